@@ -854,7 +854,9 @@ QString AssimpImporter::generateMeshFile(aiNode *, QFile &file, const AssimpUtil
     const auto mesh = AssimpUtils::generateMeshData(*m_scene, meshes, m_generateLightmapUV, m_useFloatJointIndices, errorString);
 
     if (mesh.isValid()) {
-        if (!mesh.save(&file))
+        const auto encoding = m_quantizeMeshes ? QSSGMesh::Mesh::VertexEncoding::Quantized
+                                               : QSSGMesh::Mesh::VertexEncoding::Full;
+        if (!mesh.save(&file, 0, encoding))
             return QString::asprintf("Failed to serialize mesh to %s", qPrintable(file.fileName()));
     } else {
         return QString::asprintf("Mesh building failed for %s: %s",
@@ -2122,6 +2124,7 @@ void AssimpImporter::processOptions(const QVariantMap &options)
     m_binaryKeyframes = checkBooleanOption(QStringLiteral("useBinaryKeyframes"), optionsObject);
 
     m_generateLightmapUV = checkBooleanOption(QStringLiteral("generateLightmapUV"), optionsObject);
+    m_quantizeMeshes = checkBooleanOption(QStringLiteral("quantizeMeshes"), optionsObject);
 }
 
 bool AssimpImporter::checkBooleanOption(const QString &optionName, const QJsonObject &options)
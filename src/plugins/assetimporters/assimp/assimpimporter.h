@@ -151,6 +151,7 @@ private:
     bool m_forceMipMapGeneration = false;
     bool m_useFloatJointIndices = false;
     bool m_generateLightmapUV = false;
+    bool m_quantizeMeshes = false;
     qreal m_globalScaleValue = 1.0;
 
     QVariantMap m_options;
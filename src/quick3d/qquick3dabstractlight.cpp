@@ -191,7 +191,8 @@ void QQuick3DAbstractLight::markAllDirty()
             | DirtyFlags(DirtyFlag::ColorDirty)
             | DirtyFlags(DirtyFlag::BrightnessDirty)
             | DirtyFlags(DirtyFlag::FadeDirty)
-            | DirtyFlags(DirtyFlag::AreaDirty);
+            | DirtyFlags(DirtyFlag::AreaDirty)
+            | DirtyFlags(DirtyFlag::CascadeDirty);
     QQuick3DNode::markAllDirty();
 }
 
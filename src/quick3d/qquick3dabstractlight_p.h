@@ -121,6 +121,7 @@ protected:
         BrightnessDirty = (1 << 2),
         FadeDirty = (1 << 3),
         AreaDirty = (1 << 4),
+        CascadeDirty = (1 << 5),
     };
     Q_DECLARE_FLAGS(DirtyFlags, DirtyFlag)
 
@@ -128,7 +129,8 @@ protected:
                               | DirtyFlags(DirtyFlag::ColorDirty)
                               | DirtyFlags(DirtyFlag::BrightnessDirty)
                               | DirtyFlags(DirtyFlag::FadeDirty)
-                              | DirtyFlags(DirtyFlag::AreaDirty);
+                              | DirtyFlags(DirtyFlag::AreaDirty)
+                              | DirtyFlags(DirtyFlag::CascadeDirty);
 private:
     quint32 mapToShadowResolution(QSSGShadowMapQuality resolution);
 
@@ -108,9 +108,107 @@ QT_BEGIN_NAMESPACE
     \sa PointLight, SpotLight
 */
 
+/*!
+    \qmlproperty int DirectionalLight::cascadeCount
+    \since 6.4
+
+    This property defines into how many parts, or cascades, the camera's view
+    is split for the shadows of this light. Each cascade gets its own shadow
+    map, covering only the objects at its range of distances from the camera.
+    With more cascades, shadows close to the camera get sharper in large
+    scenes. Values between 1 and 4 are supported. The default value is 1,
+    meaning one shadow map fitted to the whole scene.
+
+    With more than one cascade, shadows reach up to \l {Light::shadowMapFar}{shadowMapFar}
+    from the camera, or up to the camera's far clip plane when that is
+    closer.
+
+    \note There are at most 8 shadow maps in a View3D. Lights get fewer
+    cascades when more would be needed.
+
+    \sa cascadeSplitBlend, cascadeResolutionScale, {Light::castsShadow}{castsShadow}
+*/
+
+/*!
+    \qmlproperty real DirectionalLight::cascadeSplitBlend
+    \since 6.4
+
+    This property defines where the view is split into cascades. At 0, the
+    cascades cover equal ranges of distances from the camera. At 1, each
+    cascade covers a range that is larger than the previous one by the same
+    factor, which puts more resolution close to the camera. Values in between
+    blend between the two. The default value is 0.75.
+
+    \sa cascadeCount
+*/
+
+/*!
+    \qmlproperty real DirectionalLight::cascadeResolutionScale
+    \since 6.4
+
+    This property defines the size of each cascade's shadow map relative to
+    the previous one. The first cascade uses the size set by
+    \l {Light::shadowMapQuality}{shadowMapQuality}. Sizes are rounded down to
+    a power of two. The value is between 0.125 and 1. The default value is 1,
+    meaning all cascades have the same resolution.
+
+    \sa cascadeCount
+*/
+
 QQuick3DDirectionalLight::QQuick3DDirectionalLight(QQuick3DNode *parent)
     : QQuick3DAbstractLight(*(new QQuick3DNodePrivate(QQuick3DNodePrivate::Type::DirectionalLight)), parent) {}
 
+int QQuick3DDirectionalLight::cascadeCount() const
+{
+    return m_cascadeCount;
+}
+
+float QQuick3DDirectionalLight::cascadeSplitBlend() const
+{
+    return m_cascadeSplitBlend;
+}
+
+float QQuick3DDirectionalLight::cascadeResolutionScale() const
+{
+    return m_cascadeResolutionScale;
+}
+
+void QQuick3DDirectionalLight::setCascadeCount(int cascadeCount)
+{
+    cascadeCount = qBound(1, cascadeCount, 4);
+    if (m_cascadeCount == cascadeCount)
+        return;
+
+    m_cascadeCount = cascadeCount;
+    m_dirtyFlags.setFlag(DirtyFlag::CascadeDirty);
+    emit cascadeCountChanged();
+    update();
+}
+
+void QQuick3DDirectionalLight::setCascadeSplitBlend(float cascadeSplitBlend)
+{
+    cascadeSplitBlend = qBound(0.0f, cascadeSplitBlend, 1.0f);
+    if (qFuzzyCompare(m_cascadeSplitBlend, cascadeSplitBlend))
+        return;
+
+    m_cascadeSplitBlend = cascadeSplitBlend;
+    m_dirtyFlags.setFlag(DirtyFlag::CascadeDirty);
+    emit cascadeSplitBlendChanged();
+    update();
+}
+
+void QQuick3DDirectionalLight::setCascadeResolutionScale(float cascadeResolutionScale)
+{
+    cascadeResolutionScale = qBound(0.125f, cascadeResolutionScale, 1.0f);
+    if (qFuzzyCompare(m_cascadeResolutionScale, cascadeResolutionScale))
+        return;
+
+    m_cascadeResolutionScale = cascadeResolutionScale;
+    m_dirtyFlags.setFlag(DirtyFlag::CascadeDirty);
+    emit cascadeResolutionScaleChanged();
+    update();
+}
+
 QSSGRenderGraphObject *QQuick3DDirectionalLight::updateSpatialNode(QSSGRenderGraphObject *node)
 {
     if (!node) {
@@ -120,6 +218,15 @@ QSSGRenderGraphObject *QQuick3DDirectionalLight::updateSpatialNode(QSSGRenderGra
 
     QQuick3DAbstractLight::updateSpatialNode(node);
 
+    QSSGRenderLight *light = static_cast<QSSGRenderLight *>(node);
+
+    if (m_dirtyFlags.testFlag(DirtyFlag::CascadeDirty)) {
+        m_dirtyFlags.setFlag(DirtyFlag::CascadeDirty, false);
+        light->m_cascadeCount = quint32(m_cascadeCount);
+        light->m_cascadeSplitBlend = m_cascadeSplitBlend;
+        light->m_cascadeResolutionScale = m_cascadeResolutionScale;
+    }
+
     return node;
 }
 
@@ -50,6 +50,9 @@ QT_BEGIN_NAMESPACE
 class Q_QUICK3D_EXPORT QQuick3DDirectionalLight : public QQuick3DAbstractLight
 {
     Q_OBJECT
+    Q_PROPERTY(int cascadeCount READ cascadeCount WRITE setCascadeCount NOTIFY cascadeCountChanged REVISION(6, 4))
+    Q_PROPERTY(float cascadeSplitBlend READ cascadeSplitBlend WRITE setCascadeSplitBlend NOTIFY cascadeSplitBlendChanged REVISION(6, 4))
+    Q_PROPERTY(float cascadeResolutionScale READ cascadeResolutionScale WRITE setCascadeResolutionScale NOTIFY cascadeResolutionScaleChanged REVISION(6, 4))
 
     QML_NAMED_ELEMENT(DirectionalLight)
 
@@ -57,9 +60,27 @@ public:
     explicit QQuick3DDirectionalLight(QQuick3DNode *parent = nullptr);
     ~QQuick3DDirectionalLight() override {}
 
+    int cascadeCount() const;
+    float cascadeSplitBlend() const;
+    float cascadeResolutionScale() const;
+
+public Q_SLOTS:
+    Q_REVISION(6, 4) void setCascadeCount(int cascadeCount);
+    Q_REVISION(6, 4) void setCascadeSplitBlend(float cascadeSplitBlend);
+    Q_REVISION(6, 4) void setCascadeResolutionScale(float cascadeResolutionScale);
+
+Q_SIGNALS:
+    Q_REVISION(6, 4) void cascadeCountChanged();
+    Q_REVISION(6, 4) void cascadeSplitBlendChanged();
+    Q_REVISION(6, 4) void cascadeResolutionScaleChanged();
+
 protected:
     QSSGRenderGraphObject *updateSpatialNode(QSSGRenderGraphObject *node) override;
 
+private:
+    int m_cascadeCount = 1;
+    float m_cascadeSplitBlend = 0.75f;
+    float m_cascadeResolutionScale = 1.0f;
 };
 
 QT_END_NAMESPACE
@@ -364,8 +364,11 @@ void QQuick3DGeometry::markAllDirty()
 void QQuick3DGeometry::setVertexData(const QByteArray &data)
 {
     Q_D(QQuick3DGeometry);
+    if (!d->m_geometryChanged && data.size() == d->m_vertexBuffer.size())
+        d->m_vertexDirtyRanges.append({ 0, quint32(data.size()) });
+    else
+        d->m_geometryChanged = true;
     d->m_vertexBuffer = data;
-    d->m_geometryChanged = true;
 }
 
 /*!
@@ -377,6 +380,11 @@ void QQuick3DGeometry::setVertexData(const QByteArray &data)
     greater than the current size of the buffer, the overshooting data will
     be ignored.
 
+    When nothing but the contents of the vertex and index data changed since
+    the last update, only the changed ranges are uploaded to the existing
+    graphics buffers. For data that changes often, consider also setting
+    the buffer usage to \c Dynamic with setBufferUsage().
+
     \note The partial update functions for vertex and index data do not offer
     any guarantee on how such changes are implemented internally. Depending on
     the underlying implementation, even partial changes may lead to updating
@@ -385,13 +393,14 @@ void QQuick3DGeometry::setVertexData(const QByteArray &data)
 void QQuick3DGeometry::setVertexData(int offset, const QByteArray &data)
 {
     Q_D(QQuick3DGeometry);
-    if (offset >= d->m_vertexBuffer.size())
+    if (offset < 0 || offset >= d->m_vertexBuffer.size())
         return;
 
     const size_t len = qMin(d->m_vertexBuffer.size() - offset, data.size());
     memcpy(d->m_vertexBuffer.data() + offset, data.data(), len);
 
-    d->m_geometryChanged = true;
+    if (!d->m_geometryChanged)
+        d->m_vertexDirtyRanges.append({ quint32(offset), quint32(len) });
 }
 
 /*!
@@ -402,8 +411,11 @@ void QQuick3DGeometry::setVertexData(int offset, const QByteArray &data)
 void QQuick3DGeometry::setIndexData(const QByteArray &data)
 {
     Q_D(QQuick3DGeometry);
+    if (!d->m_geometryChanged && data.size() == d->m_indexBuffer.size())
+        d->m_indexDirtyRanges.append({ 0, quint32(data.size()) });
+    else
+        d->m_geometryChanged = true;
     d->m_indexBuffer = data;
-    d->m_geometryChanged = true;
 }
 
 /*!
@@ -423,13 +435,14 @@ void QQuick3DGeometry::setIndexData(const QByteArray &data)
 void QQuick3DGeometry::setIndexData(int offset, const QByteArray &data)
 {
     Q_D(QQuick3DGeometry);
-    if (offset >= d->m_indexBuffer.size())
+    if (offset < 0 || offset >= d->m_indexBuffer.size())
         return;
 
     const size_t len = qMin(d->m_indexBuffer.size() - offset, data.size());
     memcpy(d->m_indexBuffer.data() + offset, data.data(), len);
 
-    d->m_geometryChanged = true;
+    if (!d->m_geometryChanged)
+        d->m_indexDirtyRanges.append({ quint32(offset), quint32(len) });
 }
 
 /*!
@@ -500,6 +513,52 @@ void QQuick3DGeometry::setPrimitiveType(PrimitiveType type)
     }
 }
 
+/*!
+    \enum QQuick3DGeometry::BufferUsage
+    \since 6.4
+
+    Describes how often the vertex and index data is expected to change.
+
+    \value Static The data is expected to change rarely. This is the default.
+    \value Dynamic The data is expected to change frequently, for example in
+    every frame. Depending on the underlying graphics API, the buffers may
+    then live in memory that is faster to update but slower to draw from.
+
+    \sa setBufferUsage()
+*/
+
+/*!
+    \since 6.4
+
+    Returns the usage of the graphics buffers created for the vertex and
+    index data.
+
+    \sa setBufferUsage
+*/
+QQuick3DGeometry::BufferUsage QQuick3DGeometry::bufferUsage() const
+{
+    const Q_D(QQuick3DGeometry);
+    return d->m_bufferUsage;
+}
+
+/*!
+    \since 6.4
+
+    Sets the usage of the graphics buffers created for the vertex and index
+    data to \a usage. The initial value is \c Static.
+
+    Partial updates done with setVertexData() and setIndexData() with an
+    offset update the existing buffers in both cases.
+*/
+void QQuick3DGeometry::setBufferUsage(BufferUsage usage)
+{
+    Q_D(QQuick3DGeometry);
+    if (d->m_bufferUsage != usage) {
+        d->m_bufferUsage = usage;
+        d->m_geometryChanged = true;
+    }
+}
+
 /*!
     Adds vertex attribute description. Each attribute has a \a semantic, which specifies
     the usage of the attribute and the number of components it has, an \a offset from the
@@ -779,6 +838,7 @@ QSSGRenderGraphObject *QQuick3DGeometry::updateSpatialNode(QSSGRenderGraphObject
             qWarning("%d is an invalid stride, was QQuick3DGeometry::setStride() called?", d->m_stride);
         geometry->setIndexData(d->m_indexBuffer);
         geometry->setVertexData(d->m_vertexBuffer);
+        geometry->setDynamic(d->m_bufferUsage == BufferUsage::Dynamic);
         geometry->setPrimitiveType(mapPrimitiveType(d->m_primitiveType));
         quint32 indexBufferComponentSize = 0;
         for (int i = 0; i < d->m_attributeCount; ++i) {
@@ -815,7 +875,21 @@ QSSGRenderGraphObject *QQuick3DGeometry::updateSpatialNode(QSSGRenderGraphObject
                 geometry->addSubset(s.offset, s.count, s.boundsMin, s.boundsMax, s.name);
         }
         d->m_geometryChanged = false;
+    } else {
+        for (const auto &range : qAsConst(d->m_vertexDirtyRanges))
+            geometry->updateVertexData(d->m_vertexBuffer, range.offset, range.size);
+        // The index data is dropped when there is no index attribute
+        if (!geometry->indexBuffer().isEmpty()) {
+            for (const auto &range : qAsConst(d->m_indexDirtyRanges))
+                geometry->updateIndexData(d->m_indexBuffer, range.offset, range.size);
+        }
+        // The implicit subset covers the whole geometry, culling relies on
+        // its bounds following the geometry's.
+        if (d->m_geometryBoundsChanged && d->m_subsets.isEmpty() && geometry->meshData().m_subsets.count() == 1)
+            geometry->setSubsetBounds(0, d->m_min, d->m_max);
     }
+    d->m_vertexDirtyRanges.clear();
+    d->m_indexDirtyRanges.clear();
     if (d->m_geometryBoundsChanged) {
         geometry->setBounds(d->m_min, d->m_max);
         emit geometryNodeDirty();
@@ -56,6 +56,11 @@ public:
         Triangles
     };
 
+    enum class BufferUsage {
+        Static,
+        Dynamic
+    };
+
     struct Attribute {
         enum Semantic {
             IndexSemantic,
@@ -101,6 +106,8 @@ public:
     void setStride(int stride);
     void setBounds(const QVector3D &min, const QVector3D &max);
     void setPrimitiveType(PrimitiveType type);
+    BufferUsage bufferUsage() const;
+    void setBufferUsage(BufferUsage usage);
 
     void addAttribute(Attribute::Semantic semantic, int offset,
                       Attribute::ComponentType componentType);
@@ -62,6 +62,11 @@ public:
         quint32 count;
     };
 
+    struct DirtyRange {
+        quint32 offset;
+        quint32 size;
+    };
+
     static const int MAX_ATTRIBUTE_COUNT = 16;
     QByteArray m_vertexBuffer;
     QByteArray m_indexBuffer;
@@ -72,8 +77,12 @@ public:
     QVector3D m_min;
     QVector3D m_max;
     int m_stride = 0;
+    QQuick3DGeometry::BufferUsage m_bufferUsage = QQuick3DGeometry::BufferUsage::Static;
     bool m_geometryChanged = true;
     bool m_geometryBoundsChanged = true;
+    // Parts of the data changed since the last sync, when nothing else did
+    QVector<DirtyRange> m_vertexDirtyRanges;
+    QVector<DirtyRange> m_indexDirtyRanges;
 
     static QQuick3DGeometry::Attribute::Semantic semanticFromName(const QByteArray &name);
     static QQuick3DGeometry::Attribute::ComponentType toComponentType(QSSGMesh::Mesh::ComponentType componentType);
@@ -97,6 +97,10 @@ QT_BEGIN_NAMESPACE
     in the scene, the model will need to make it self discoverable by setting the \l {Model::pickable}{pickable} property to true.
     Visit the \l {Qt Quick 3D - Picking example} to see how picking can be enabled.
 
+    The acceleration structure used for picking against the triangles of the mesh is built in the
+    background once the model is shown. Until it is ready, picking only tests the bounds of the
+    sub-meshes. The \l pickingDataReady() signal tells when picking becomes precise.
+
 */
 
 /*!
@@ -304,6 +308,17 @@ bool QQuick3DModel::pickable() const
     return m_pickable;
 }
 
+/*!
+    \qmlsignal QtQuick3D::Model::pickingDataReady()
+    \since 6.4
+
+    This signal is emitted when the acceleration structure for picking the mesh of a
+    \l pickable model has been built, and picking is no longer limited to the bounds
+    of the sub-meshes.
+
+    The corresponding handler is \c onPickingDataReady.
+*/
+
 /*!
     \qmlproperty Geometry Model::geometry
 
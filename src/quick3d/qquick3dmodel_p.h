@@ -157,6 +157,7 @@ Q_SIGNALS:
     void depthBiasChanged();
     Q_REVISION(6, 3)  void receivesReflectionsChanged();
     Q_REVISION(6, 4)  void skinChanged();
+    Q_REVISION(6, 4)  void pickingDataReady();
 
 protected:
     QSSGRenderGraphObject *updateSpatialNode(QSSGRenderGraphObject *node) override;
@@ -120,6 +120,269 @@ float QQuick3DRenderStats::maxFrameTime() const
     return m_maxFrameTime;
 }
 
+/*!
+    \qmlproperty int QtQuick3D::RenderStats::cullingTestCount
+    \readonly
+    \since 6.4
+
+    This property holds the number of bounding box tests performed against the
+    camera and the shadow casting light frustums in the last frame. The tests
+    are done against groups of models first, so with a good part of the scene
+    outside of the frustum this is considerably less than the number of
+    models.
+
+    \note Frustum culling against the camera is only done when
+    \l{Camera::frustumCullingEnabled}{frustumCullingEnabled} is set.
+
+    \sa culledNodeCount
+*/
+int QQuick3DRenderStats::cullingTestCount() const
+{
+    return m_results.cullingStats.testCount;
+}
+
+/*!
+    \qmlproperty int QtQuick3D::RenderStats::culledNodeCount
+    \readonly
+    \since 6.4
+
+    This property holds the number of models rejected by the camera and the
+    shadow casting light frustums in the last frame. A model outside of several
+    frustums is counted for each of them.
+
+    \sa cullingTestCount
+*/
+int QQuick3DRenderStats::culledNodeCount() const
+{
+    return m_results.cullingStats.culledNodeCount;
+}
+
+/*!
+    \qmlproperty int QtQuick3D::RenderStats::shaderCacheHitCount
+    \readonly
+    \since 6.4
+
+    This property holds the number of material shaders that were loaded from
+    the persistent shader cache instead of being generated at runtime, since
+    the scene was first rendered.
+
+    The cache is stored in the application's cache location, see
+    QStandardPaths::CacheLocation. It can be disabled by setting the
+    environment variable \c QT_QUICK3D_DISABLE_SHADER_DISK_CACHE to \c 1.
+
+    \sa shaderCacheMissCount, shaderCacheTimeSaved
+*/
+int QQuick3DRenderStats::shaderCacheHitCount() const
+{
+    return m_results.shaderCacheStats.diskCacheHitCount;
+}
+
+/*!
+    \qmlproperty int QtQuick3D::RenderStats::shaderCacheMissCount
+    \readonly
+    \since 6.4
+
+    This property holds the number of material shaders that were not found in
+    the persistent shader cache and had to be generated at runtime, since the
+    scene was first rendered.
+
+    \sa shaderCacheHitCount
+*/
+int QQuick3DRenderStats::shaderCacheMissCount() const
+{
+    return m_results.shaderCacheStats.diskCacheMissCount;
+}
+
+/*!
+    \qmlproperty float QtQuick3D::RenderStats::shaderCacheTimeSaved
+    \readonly
+    \since 6.4
+
+    This property holds the time, in milliseconds, it originally took to
+    generate the shaders that were loaded from the persistent shader cache.
+
+    \sa shaderCacheHitCount
+*/
+float QQuick3DRenderStats::shaderCacheTimeSaved() const
+{
+    return m_results.shaderCacheStats.diskCacheTimeSaved;
+}
+
+/*!
+    \qmlproperty int QtQuick3D::RenderStats::pipelineCount
+    \readonly
+    \since 6.4
+
+    This property holds the number of graphics pipelines currently cached by
+    the renderer. Pipelines not used for a while are released once there are
+    more than 1024 of them, the limit can be changed with the environment
+    variable \c QT_QUICK3D_MAX_CACHED_PIPELINES. A value of \c 0 keeps all
+    pipelines.
+
+    \sa pipelineCacheHitCount, pipelineCacheMissCount, resourceCacheEvictionCount
+*/
+int QQuick3DRenderStats::pipelineCount() const
+{
+    return m_results.resourceCacheStats.pipelines.size;
+}
+
+/*!
+    \qmlproperty int QtQuick3D::RenderStats::pipelineCacheHitCount
+    \readonly
+    \since 6.4
+
+    This property holds the number of times a graphics pipeline was found in
+    the cache, since the scene was first rendered.
+
+    \sa pipelineCacheMissCount
+*/
+int QQuick3DRenderStats::pipelineCacheHitCount() const
+{
+    return int(m_results.resourceCacheStats.pipelines.hits);
+}
+
+/*!
+    \qmlproperty int QtQuick3D::RenderStats::pipelineCacheMissCount
+    \readonly
+    \since 6.4
+
+    This property holds the number of graphics pipelines that had to be
+    created, since the scene was first rendered.
+
+    \sa pipelineCacheHitCount, pipelineCreationTime
+*/
+int QQuick3DRenderStats::pipelineCacheMissCount() const
+{
+    return int(m_results.resourceCacheStats.pipelines.misses);
+}
+
+/*!
+    \qmlproperty float QtQuick3D::RenderStats::pipelineCreationTime
+    \readonly
+    \since 6.4
+
+    This property holds the total time, in milliseconds, spent creating
+    graphics pipelines since the scene was first rendered.
+
+    \sa pipelineCacheMissCount
+*/
+float QQuick3DRenderStats::pipelineCreationTime() const
+{
+    return m_results.resourceCacheStats.pipelines.creationTimeNs / 1000000.0f;
+}
+
+/*!
+    \qmlproperty int QtQuick3D::RenderStats::shaderResourceBindingCount
+    \readonly
+    \since 6.4
+
+    This property holds the number of shader resource binding sets currently
+    cached by the renderer. They are released in the same way as pipelines,
+    the limit of 4096 can be changed with the environment variable
+    \c QT_QUICK3D_MAX_CACHED_SRBS.
+
+    \sa pipelineCount
+*/
+int QQuick3DRenderStats::shaderResourceBindingCount() const
+{
+    return m_results.resourceCacheStats.srbs.size;
+}
+
+/*!
+    \qmlproperty int QtQuick3D::RenderStats::samplerCount
+    \readonly
+    \since 6.4
+
+    This property holds the number of texture samplers created by the
+    renderer.
+*/
+int QQuick3DRenderStats::samplerCount() const
+{
+    return m_results.resourceCacheStats.samplers.size;
+}
+
+/*!
+    \qmlproperty int QtQuick3D::RenderStats::resourceCacheEvictionCount
+    \readonly
+    \since 6.4
+
+    This property holds the number of cached pipelines, shader resource
+    binding sets and per-draw call data released because their caches grew
+    above the limit, since the scene was first rendered. A steadily growing
+    value means the limits are too low for the scene.
+
+    \sa pipelineCount, shaderResourceBindingCount
+*/
+int QQuick3DRenderStats::resourceCacheEvictionCount() const
+{
+    const QSSGRhiCacheStats &stats(m_results.resourceCacheStats);
+    return int(stats.pipelines.evictions + stats.srbs.evictions + stats.drawCallData.evictions);
+}
+
+/*!
+    \qmlproperty int QtQuick3D::RenderStats::textureLoadPendingCount
+    \readonly
+    \since 6.4
+
+    This property holds the number of images currently loaded in the
+    background for Textures with \l{Texture::asynchronous}{asynchronous} set
+    to true. Materials use a placeholder for these until they are ready.
+
+    \sa textureLoadFinishedCount
+*/
+int QQuick3DRenderStats::textureLoadPendingCount() const
+{
+    return m_results.textureLoadStats.pendingCount;
+}
+
+/*!
+    \qmlproperty int QtQuick3D::RenderStats::textureLoadFinishedCount
+    \readonly
+    \since 6.4
+
+    This property holds the number of images loaded in the background, since
+    the scene was first rendered.
+
+    \sa textureLoadPendingCount
+*/
+int QQuick3DRenderStats::textureLoadFinishedCount() const
+{
+    return m_results.textureLoadStats.finishedCount;
+}
+
+/*!
+    \qmlproperty int QtQuick3D::RenderStats::pipelineSwitchCount
+    \readonly
+    \since 6.4
+
+    This property holds the number of times a different graphics pipeline was
+    bound while recording the last frame. Each switch has a cost on the CPU
+    and the GPU, a high value compared to the number of models suggests that
+    the draw calls are not grouped well, for example because the materials
+    differ only slightly.
+
+    \sa shaderResourceBindingSwitchCount, pipelineCount
+*/
+int QQuick3DRenderStats::pipelineSwitchCount() const
+{
+    return int(m_results.switchStats.pipelineSwitches);
+}
+
+/*!
+    \qmlproperty int QtQuick3D::RenderStats::shaderResourceBindingSwitchCount
+    \readonly
+    \since 6.4
+
+    This property holds the number of times a different set of shader
+    resource bindings was bound while recording the last frame.
+
+    \sa pipelineSwitchCount, shaderResourceBindingCount
+*/
+int QQuick3DRenderStats::shaderResourceBindingSwitchCount() const
+{
+    return int(m_results.switchStats.srbSwitches);
+}
+
 void QQuick3DRenderStats::startSync()
 {
     m_syncStartTime = timestamp();
@@ -148,6 +411,31 @@ void QQuick3DRenderStats::endRenderPrepare()
     m_results.renderPrepareTime = timestamp() - m_renderPrepareStartTime;
 }
 
+void QQuick3DRenderStats::setCullingStats(const QSSGCullingStats &stats)
+{
+    m_results.cullingStats = stats;
+}
+
+void QQuick3DRenderStats::setShaderCacheStats(const QSSGShaderCacheStats &stats)
+{
+    m_results.shaderCacheStats = stats;
+}
+
+void QQuick3DRenderStats::setResourceCacheStats(const QSSGRhiCacheStats &stats)
+{
+    m_results.resourceCacheStats = stats;
+}
+
+void QQuick3DRenderStats::setTextureLoadStats(const QSSGTextureLoadStats &stats)
+{
+    m_results.textureLoadStats = stats;
+}
+
+void QQuick3DRenderStats::setSwitchStats(const QSSGRhiSwitchStats &stats)
+{
+    m_results.switchStats = stats;
+}
+
 void QQuick3DRenderStats::endRender(bool dump)
 {
     ++m_frameCount;
@@ -178,6 +466,43 @@ void QQuick3DRenderStats::endRender(bool dump)
             m_notifiedResults.renderPrepareTime = m_results.renderPrepareTime;
             emit renderTimeChanged();
         }
+
+        if (m_results.cullingStats.testCount != m_notifiedResults.cullingStats.testCount
+                || m_results.cullingStats.culledNodeCount != m_notifiedResults.cullingStats.culledNodeCount) {
+            m_notifiedResults.cullingStats = m_results.cullingStats;
+            emit cullingStatsChanged();
+        }
+
+        if (m_results.shaderCacheStats.diskCacheHitCount != m_notifiedResults.shaderCacheStats.diskCacheHitCount
+                || m_results.shaderCacheStats.diskCacheMissCount != m_notifiedResults.shaderCacheStats.diskCacheMissCount) {
+            m_notifiedResults.shaderCacheStats = m_results.shaderCacheStats;
+            emit shaderCacheStatsChanged();
+        }
+
+        const QSSGRhiCacheStats &cacheStats(m_results.resourceCacheStats);
+        const QSSGRhiCacheStats &notifiedCacheStats(m_notifiedResults.resourceCacheStats);
+        if (cacheStats.pipelines.misses != notifiedCacheStats.pipelines.misses
+                || cacheStats.pipelines.hits != notifiedCacheStats.pipelines.hits
+                || cacheStats.srbs.size != notifiedCacheStats.srbs.size
+                || cacheStats.samplers.size != notifiedCacheStats.samplers.size
+                || cacheStats.pipelines.evictions != notifiedCacheStats.pipelines.evictions
+                || cacheStats.srbs.evictions != notifiedCacheStats.srbs.evictions
+                || cacheStats.drawCallData.evictions != notifiedCacheStats.drawCallData.evictions) {
+            m_notifiedResults.resourceCacheStats = m_results.resourceCacheStats;
+            emit resourceCacheStatsChanged();
+        }
+
+        if (m_results.textureLoadStats.pendingCount != m_notifiedResults.textureLoadStats.pendingCount
+                || m_results.textureLoadStats.finishedCount != m_notifiedResults.textureLoadStats.finishedCount) {
+            m_notifiedResults.textureLoadStats = m_results.textureLoadStats;
+            emit textureLoadStatsChanged();
+        }
+
+        if (m_results.switchStats.pipelineSwitches != m_notifiedResults.switchStats.pipelineSwitches
+                || m_results.switchStats.srbSwitches != m_notifiedResults.switchStats.srbSwitches) {
+            m_notifiedResults.switchStats = m_results.switchStats;
+            emit switchStatsChanged();
+        }
     }
 
     const float fpsInterval = 1000.0f;
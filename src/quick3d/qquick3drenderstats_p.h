@@ -44,6 +44,10 @@
 #include <QtQuick3D/qtquick3dglobal.h>
 #include <QtCore/qobject.h>
 #include <QtQuick3DRuntimeRender/private/qssgrendercontextcore_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrenderscenebvh_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrendershadercache_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrhicontext_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrenderbuffermanager_p.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -56,6 +60,22 @@ class Q_QUICK3D_EXPORT QQuick3DRenderStats : public QObject
     Q_PROPERTY(float renderPrepareTime READ renderPrepareTime NOTIFY renderTimeChanged)
     Q_PROPERTY(float syncTime READ syncTime NOTIFY syncTimeChanged)
     Q_PROPERTY(float maxFrameTime READ maxFrameTime NOTIFY maxFrameTimeChanged)
+    Q_PROPERTY(int cullingTestCount READ cullingTestCount NOTIFY cullingStatsChanged REVISION(6, 4))
+    Q_PROPERTY(int culledNodeCount READ culledNodeCount NOTIFY cullingStatsChanged REVISION(6, 4))
+    Q_PROPERTY(int shaderCacheHitCount READ shaderCacheHitCount NOTIFY shaderCacheStatsChanged REVISION(6, 4))
+    Q_PROPERTY(int shaderCacheMissCount READ shaderCacheMissCount NOTIFY shaderCacheStatsChanged REVISION(6, 4))
+    Q_PROPERTY(float shaderCacheTimeSaved READ shaderCacheTimeSaved NOTIFY shaderCacheStatsChanged REVISION(6, 4))
+    Q_PROPERTY(int pipelineCount READ pipelineCount NOTIFY resourceCacheStatsChanged REVISION(6, 4))
+    Q_PROPERTY(int pipelineCacheHitCount READ pipelineCacheHitCount NOTIFY resourceCacheStatsChanged REVISION(6, 4))
+    Q_PROPERTY(int pipelineCacheMissCount READ pipelineCacheMissCount NOTIFY resourceCacheStatsChanged REVISION(6, 4))
+    Q_PROPERTY(float pipelineCreationTime READ pipelineCreationTime NOTIFY resourceCacheStatsChanged REVISION(6, 4))
+    Q_PROPERTY(int shaderResourceBindingCount READ shaderResourceBindingCount NOTIFY resourceCacheStatsChanged REVISION(6, 4))
+    Q_PROPERTY(int samplerCount READ samplerCount NOTIFY resourceCacheStatsChanged REVISION(6, 4))
+    Q_PROPERTY(int resourceCacheEvictionCount READ resourceCacheEvictionCount NOTIFY resourceCacheStatsChanged REVISION(6, 4))
+    Q_PROPERTY(int textureLoadPendingCount READ textureLoadPendingCount NOTIFY textureLoadStatsChanged REVISION(6, 4))
+    Q_PROPERTY(int textureLoadFinishedCount READ textureLoadFinishedCount NOTIFY textureLoadStatsChanged REVISION(6, 4))
+    Q_PROPERTY(int pipelineSwitchCount READ pipelineSwitchCount NOTIFY switchStatsChanged REVISION(6, 4))
+    Q_PROPERTY(int shaderResourceBindingSwitchCount READ shaderResourceBindingSwitchCount NOTIFY switchStatsChanged REVISION(6, 4))
 
 public:
     QQuick3DRenderStats(QObject *parent = nullptr);
@@ -66,6 +86,22 @@ public:
     float renderPrepareTime() const;
     float syncTime() const;
     float maxFrameTime() const;
+    int cullingTestCount() const;
+    int culledNodeCount() const;
+    int shaderCacheHitCount() const;
+    int shaderCacheMissCount() const;
+    float shaderCacheTimeSaved() const;
+    int pipelineCount() const;
+    int pipelineCacheHitCount() const;
+    int pipelineCacheMissCount() const;
+    float pipelineCreationTime() const;
+    int shaderResourceBindingCount() const;
+    int samplerCount() const;
+    int resourceCacheEvictionCount() const;
+    int textureLoadPendingCount() const;
+    int textureLoadFinishedCount() const;
+    int pipelineSwitchCount() const;
+    int shaderResourceBindingSwitchCount() const;
 
     void startSync();
     void endSync(bool dump = false);
@@ -75,12 +111,23 @@ public:
     void endRenderPrepare();
     void endRender(bool dump = false);
 
+    void setCullingStats(const QSSGCullingStats &stats);
+    void setShaderCacheStats(const QSSGShaderCacheStats &stats);
+    void setResourceCacheStats(const QSSGRhiCacheStats &stats);
+    void setTextureLoadStats(const QSSGTextureLoadStats &stats);
+    void setSwitchStats(const QSSGRhiSwitchStats &stats);
+
 Q_SIGNALS:
     void fpsChanged();
     void frameTimeChanged();
     void renderTimeChanged();
     void syncTimeChanged();
     void maxFrameTimeChanged();
+    Q_REVISION(6, 4) void cullingStatsChanged();
+    Q_REVISION(6, 4) void shaderCacheStatsChanged();
+    Q_REVISION(6, 4) void resourceCacheStatsChanged();
+    Q_REVISION(6, 4) void textureLoadStatsChanged();
+    Q_REVISION(6, 4) void switchStatsChanged();
 
 private:
     float timestamp() const;
@@ -103,6 +150,11 @@ private:
         float renderTime = 0;
         float renderPrepareTime = 0;
         float syncTime = 0;
+        QSSGCullingStats cullingStats;
+        QSSGShaderCacheStats shaderCacheStats;
+        QSSGRhiCacheStats resourceCacheStats;
+        QSSGTextureLoadStats textureLoadStats;
+        QSSGRhiSwitchStats switchStats;
     };
 
     Results m_results;
@@ -51,10 +51,13 @@
 #include <QtQuick3DRuntimeRender/private/qssgrendereffect_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrhieffectsystem_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrendererimpllayerrenderpreparationdata_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrendererimpllayerrenderdata_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrhiquadrenderer_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrhicontext_p.h>
 
 #include <QtCore/QObject>
+#include <QtQml/QQmlFile>
+#include <QtQml/qqmlcontext.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -306,10 +309,10 @@ QRhiTexture *QQuick3DSceneRenderer::renderToRhiTexture(QQuickWindow *qw)
             clearColor = m_backgroundColor;
         }
         cb->beginPass(m_textureRenderTarget, clearColor, { 1.0f, 0 }, nullptr, QSSGRhiContext::commonPassFlags());
-        QSSGRHICTX_STAT(rhiCtx, beginRenderPass(m_textureRenderTarget));
+        rhiCtx->stats().beginRenderPass(m_textureRenderTarget);
         rhiRender();
         cb->endPass();
-        QSSGRHICTX_STAT(rhiCtx, endRenderPass());
+        rhiCtx->stats().endRenderPass();
 
         const bool temporalAA = m_layer->temporalAAIsActive;
         const bool progressiveAA = m_layer->progressiveAAIsActive;
@@ -456,6 +459,8 @@ void QQuick3DSceneRenderer::beginFrame()
 void QQuick3DSceneRenderer::endFrame()
 {
     m_sgContext->endFrame(m_layer);
+    if (m_renderStats)
+        m_renderStats->setSwitchStats(m_sgContext->rhiContext()->stats().switchStats);
 }
 
 void QQuick3DSceneRenderer::rhiPrepare(const QRect &viewport, qreal displayPixelRatio)
@@ -473,6 +478,19 @@ void QQuick3DSceneRenderer::rhiPrepare(const QRect &viewport, qreal displayPixel
     m_sgContext->prepareLayerForRender(*m_layer);
     m_sgContext->rhiPrepare(*m_layer);
 
+    if (m_renderStats && m_layer->renderData)
+        m_renderStats->setCullingStats(m_layer->renderData->cullingStats);
+    if (m_renderStats) {
+        m_renderStats->setShaderCacheStats(m_sgContext->shaderCache()->stats());
+        m_renderStats->setResourceCacheStats(m_sgContext->rhiContext()->cacheStats());
+        m_renderStats->setTextureLoadStats(m_sgContext->bufferManager()->imageLoadStats());
+    }
+
+    // The status of the Textures is only updated when synchronizing, make
+    // sure there is another frame when no more images are pending.
+    if (m_layer->renderData && !m_layer->renderData->loadedImages.isEmpty())
+        requestedFramesCount = qMax(requestedFramesCount, 1);
+
     m_prepared = true;
 }
 
@@ -501,6 +519,49 @@ static QRhiTexture::Format toRhiTextureFormat(QQuickShaderEffectSource::Format f
     }
 }
 
+void QQuick3DSceneRenderer::notifyPickingDataReady(QQuick3DViewport *view3D, QVector<const QSSGRenderModel *> &models)
+{
+    if (models.isEmpty())
+        return;
+
+    QQuick3DSceneManager *sceneManager = QQuick3DObjectPrivate::get(view3D->scene())->sceneManager;
+    QQuick3DSceneManager *importSceneManager = nullptr;
+    if (QQuick3DNode *importScene = view3D->importScene())
+        importSceneManager = QQuick3DObjectPrivate::get(importScene)->sceneManager;
+
+    for (const QSSGRenderModel *model : qAsConst(models)) {
+        QQuick3DObject *frontendObject = sceneManager ? sceneManager->lookUpNode(model) : nullptr;
+        if (!frontendObject && importSceneManager)
+            frontendObject = importSceneManager->lookUpNode(model);
+        if (auto frontendModel = qobject_cast<QQuick3DModel *>(frontendObject))
+            emit frontendModel->pickingDataReady();
+    }
+    models.clear();
+}
+
+void QQuick3DSceneRenderer::notifyImagesLoaded(QQuick3DViewport *view3D, QVector<QPair<QSSGRenderImage *, bool>> &images)
+{
+    if (images.isEmpty())
+        return;
+
+    QQuick3DSceneManager *sceneManager = QQuick3DObjectPrivate::get(view3D->scene())->sceneManager;
+    QQuick3DSceneManager *importSceneManager = nullptr;
+    if (QQuick3DNode *importScene = view3D->importScene())
+        importSceneManager = QQuick3DObjectPrivate::get(importScene)->sceneManager;
+
+    for (const auto &image : qAsConst(images)) {
+        QQuick3DObject *frontendObject = sceneManager ? sceneManager->lookUpNode(image.first) : nullptr;
+        if (!frontendObject && importSceneManager)
+            frontendObject = importSceneManager->lookUpNode(image.first);
+        if (auto frontendTexture = qobject_cast<QQuick3DTexture *>(frontendObject)) {
+            // The source may have changed again in the meantime
+            if (frontendTexture->status() == QQuick3DTexture::Loading)
+                frontendTexture->setStatus(image.second ? QQuick3DTexture::Ready : QQuick3DTexture::Error);
+        }
+    }
+    images.clear();
+}
+
 void QQuick3DSceneRenderer::synchronize(QQuick3DViewport *view3D, const QSize &size, float dpr)
 {
     Q_ASSERT(view3D != nullptr); // This is not an option!
@@ -518,6 +579,24 @@ void QQuick3DSceneRenderer::synchronize(QQuick3DViewport *view3D, const QSize &s
 
     QList<QSSGRenderGraphObject *> resourceLoaders;
 
+    // Start baking the shaders of the manifest before anything needs them.
+    const QUrl shaderManifest = view3D->shaderManifest();
+    if (m_shaderManifest != shaderManifest) {
+        m_shaderManifest = shaderManifest;
+        if (!shaderManifest.isEmpty()) {
+            const QQmlContext *context = qmlContext(view3D);
+            const QUrl resolvedUrl = context ? context->resolvedUrl(shaderManifest) : shaderManifest;
+            m_sgContext->shaderCache()->prewarm(QQmlFile::urlToLocalFileOrQrc(resolvedUrl));
+        }
+    }
+
+    // Before the dirty nodes are updated: models removed since the last frame
+    // are only known to the scene managers until then.
+    if (m_layer && m_layer->renderData) {
+        notifyPickingDataReady(view3D, m_layer->renderData->pickingDataReadyModels);
+        notifyImagesLoaded(view3D, m_layer->renderData->loadedImages);
+    }
+
     if (auto sceneManager = QQuick3DObjectPrivate::get(view3D->scene())->sceneManager) {
         sceneManager->rci = m_sgContext.data();
         sceneManager->updateDirtyNodes();
@@ -878,6 +957,16 @@ QQuick3DSceneRenderer::PickResultList QQuick3DSceneRenderer::syncPickAll(const Q
                                                 ray);
 }
 
+QVector<QQuick3DSceneRenderer::PickResultList> QQuick3DSceneRenderer::syncPickAll(const QVector<QSSGRenderRay> &rays)
+{
+    if (!m_layer)
+        return QVector<PickResultList>(rays.size());
+
+    return m_sgContext->renderer()->syncPickAll(*m_layer,
+                                                m_sgContext->bufferManager(),
+                                                rays);
+}
+
 void QQuick3DSceneRenderer::setGlobalPickingEnabled(bool isEnabled)
 {
     m_sgContext->renderer()->setGlobalPickingEnabled(isEnabled);
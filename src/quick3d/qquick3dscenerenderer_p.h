@@ -60,6 +60,8 @@ QT_BEGIN_NAMESPACE
 class QQuick3DSceneManager;
 class QQuick3DViewport;
 struct QSSGRenderLayer;
+struct QSSGRenderModel;
+struct QSSGRenderImage;
 
 class QQuick3DSceneRenderer
 {
@@ -82,6 +84,7 @@ protected:
     QSSGRenderPickResult syncPick(const QSSGRenderRay &ray);
     QSSGRenderPickResult syncPickOne(const QSSGRenderRay &ray, QSSGRenderNode *node);
     PickResultList syncPickAll(const QSSGRenderRay &ray);
+    QVector<PickResultList> syncPickAll(const QVector<QSSGRenderRay> &rays);
 
     void setGlobalPickingEnabled(bool isEnabled);
 
@@ -92,9 +95,12 @@ private:
     void updateLayerNode(QQuick3DViewport *view3D, const QList<QSSGRenderGraphObject *> &resourceLoaders);
     void addNodeToLayer(QSSGRenderNode *node);
     void removeNodeFromLayer(QSSGRenderNode *node);
+    void notifyPickingDataReady(QQuick3DViewport *view3D, QVector<const QSSGRenderModel *> &models);
+    void notifyImagesLoaded(QQuick3DViewport *view3D, QVector<QPair<QSSGRenderImage *, bool>> &images);
     QSSGRef<QSSGRenderContextInterface> m_sgContext;
     QSSGRenderLayer *m_layer = nullptr;
     QSize m_surfaceSize;
+    QUrl m_shaderManifest;
     SGFramebufferObjectNode *fboNode = nullptr;
     bool m_aaIsDirty = true;
 
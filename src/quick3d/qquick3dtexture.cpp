@@ -658,6 +658,63 @@ bool QQuick3DTexture::autoOrientation() const
     return m_autoOrientation;
 }
 
+/*!
+    \qmlproperty bool QtQuick3D::Texture::asynchronous
+
+    This property determines if the image given by \l source is loaded on a
+    worker thread. Until it is ready, materials using the Texture sample a
+    plain white placeholder instead, and rendering continues without waiting
+    for the image file to be read and decoded. This is useful for scenes with
+    a large number of textures, which would otherwise delay showing the first
+    frame.
+
+    By default, this property is set to false. Changing it has no effect on an
+    image that is already loaded.
+
+    \note Light probes and cube map textures are always loaded synchronously.
+
+    \since 6.4
+
+    \sa status
+*/
+bool QQuick3DTexture::asynchronous() const
+{
+    return m_asynchronous;
+}
+
+/*!
+    \qmlproperty enumeration QtQuick3D::Texture::status
+    \readonly
+
+    This property holds the status of loading the image given by \l source.
+
+    \value Texture.Null No source is set.
+    \value Texture.Ready The image has been loaded.
+    \value Texture.Loading The image is being loaded, or it has not been used
+    for rendering yet.
+    \value Texture.Error The image could not be loaded.
+
+    The image is loaded when the Texture is first used by a material in a
+    rendered scene.
+
+    \since 6.4
+
+    \sa asynchronous
+*/
+QQuick3DTexture::Status QQuick3DTexture::status() const
+{
+    return m_status;
+}
+
+void QQuick3DTexture::setStatus(Status status)
+{
+    if (m_status == status)
+        return;
+
+    m_status = status;
+    emit statusChanged();
+}
+
 void QQuick3DTexture::setSource(const QUrl &source)
 {
     if (m_source == source)
@@ -668,6 +725,7 @@ void QQuick3DTexture::setSource(const QUrl &source)
     m_dirtyFlags.setFlag(DirtyFlag::SourceItemDirty);
     m_dirtyFlags.setFlag(DirtyFlag::TextureDataDirty);
     emit sourceChanged();
+    setStatus(m_source.isEmpty() ? Null : Loading);
     update();
 }
 
@@ -936,6 +994,16 @@ void QQuick3DTexture::setGenerateMipmaps(bool generateMipmaps)
     update();
 }
 
+void QQuick3DTexture::setAsynchronous(bool asynchronous)
+{
+    if (m_asynchronous == asynchronous)
+        return;
+
+    // Picked up with the next source change
+    m_asynchronous = asynchronous;
+    emit asynchronousChanged();
+}
+
 void QQuick3DTexture::setAutoOrientation(bool autoOrientation)
 {
     if (m_autoOrientation == autoOrientation)
@@ -1057,6 +1125,9 @@ QSSGRenderGraphObject *QQuick3DTexture::updateSpatialNode(QSSGRenderGraphObject
         } else {
             imageNode->m_imagePath = QSSGRenderPath();
         }
+        imageNode->m_asyncLoad = m_asynchronous;
+        // The renderer reports back once the image is loaded, see setStatus()
+        imageNode->m_loadStatusPending = !m_source.isEmpty();
         nodeChanged = true;
     }
     if (m_dirtyFlags.testFlag(DirtyFlag::IndexUVDirty)) {
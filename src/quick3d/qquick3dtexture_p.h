@@ -78,6 +78,8 @@ class Q_QUICK3D_EXPORT QQuick3DTexture : public QQuick3DObject, public QQuickIte
     Q_PROPERTY(Filter mipFilter READ mipFilter WRITE setMipFilter NOTIFY mipFilterChanged)
     Q_PROPERTY(bool generateMipmaps READ generateMipmaps WRITE setGenerateMipmaps NOTIFY generateMipmapsChanged)
     Q_PROPERTY(bool autoOrientation READ autoOrientation WRITE setAutoOrientation NOTIFY autoOrientationChanged REVISION(6, 2))
+    Q_PROPERTY(bool asynchronous READ asynchronous WRITE setAsynchronous NOTIFY asynchronousChanged REVISION(6, 4))
+    Q_PROPERTY(Status status READ status NOTIFY statusChanged REVISION(6, 4))
 
     QML_NAMED_ELEMENT(Texture)
 
@@ -105,6 +107,14 @@ public:
     };
     Q_ENUM(Filter)
 
+    enum Status {
+        Null,
+        Ready,
+        Loading,
+        Error
+    };
+    Q_ENUM(Status)
+
     explicit QQuick3DTexture(QQuick3DObject *parent = nullptr);
     ~QQuick3DTexture() override;
 
@@ -129,6 +139,11 @@ public:
     QQuick3DTextureData *textureData() const;
     bool generateMipmaps() const;
     bool autoOrientation() const;
+    bool asynchronous() const;
+    Status status() const;
+
+    // Called when the image given by source was loaded, or failed to load
+    void setStatus(Status status);
 
     QSSGRenderImage *getRenderImage();
 
@@ -154,6 +169,7 @@ public Q_SLOTS:
     void setTextureData(QQuick3DTextureData * textureData);
     void setGenerateMipmaps(bool generateMipmaps);
     void setAutoOrientation(bool autoOrientation);
+    Q_REVISION(6, 4) void setAsynchronous(bool asynchronous);
 
 Q_SIGNALS:
     void sourceChanged();
@@ -177,6 +193,8 @@ Q_SIGNALS:
     void textureDataChanged();
     void generateMipmapsChanged();
     void autoOrientationChanged();
+    Q_REVISION(6, 4) void asynchronousChanged();
+    Q_REVISION(6, 4) void statusChanged();
 
 protected:
     QSSGRenderGraphObject *updateSpatialNode(QSSGRenderGraphObject *node) override;
@@ -241,6 +259,8 @@ private:
     QQuick3DTextureData *m_textureData = nullptr;
     bool m_generateMipmaps = false;
     bool m_autoOrientation = true;
+    bool m_asynchronous = false;
+    Status m_status = Null;
     QMetaMethod m_updateSlot;
 };
 
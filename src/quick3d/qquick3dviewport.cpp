@@ -393,6 +393,31 @@ QQuickShaderEffectSource::Format QQuick3DViewport::renderFormat() const
     return m_renderFormat;
 }
 
+/*!
+    \qmlproperty url QtQuick3D::View3D::shaderManifest
+    \since 6.4
+
+    This property holds a manifest of the material shaders the application is
+    expected to use. When the view is rendered for the first time after the
+    property is set, the shaders listed in the manifest are compiled on
+    background threads, so that they are ready by the time they are needed
+    instead of stalling the frame in which a material first appears.
+
+    A manifest is recorded by running the application with the environment
+    variable \c QT_QUICK3D_RECORD_SHADER_MANIFEST set to the name of the file
+    to write. All the material shaders compiled during the run are added to
+    the file when the application exits. As the manifest contains shader
+    sources, it can be recorded on a different machine and graphics API than
+    the one it is used on, as long as the Qt version is the same.
+
+    Shaders already available in the on-disk shader cache are not compiled
+    again.
+*/
+QUrl QQuick3DViewport::shaderManifest() const
+{
+    return m_shaderManifest;
+}
+
 /*!
     \qmlproperty QtQuick3D::RenderStats QtQuick3D::View3D::renderStats
     \readonly
@@ -726,6 +751,16 @@ void QQuick3DViewport::setRenderMode(QQuick3DViewport::RenderMode renderMode)
     update();
 }
 
+void QQuick3DViewport::setShaderManifest(const QUrl &manifest)
+{
+    if (m_shaderManifest == manifest)
+        return;
+
+    m_shaderManifest = manifest;
+    emit shaderManifestChanged();
+    update();
+}
+
 void QQuick3DViewport::setRenderFormat(QQuickShaderEffectSource::Format format)
 {
     if (m_renderFormat == format)
@@ -917,6 +952,74 @@ QList<QQuick3DPickResult> QQuick3DViewport::rayPickAll(const QVector3D &origin,
     return processedResultList;
 }
 
+/*!
+    \qmlmethod list View3D::batchPickAll(list<point> positions)
+
+    This method does the same as \l pickAll() for every view coordinate in \a positions,
+    and returns one list of \l PickResult for each of them, in the same order. Positions
+    that do not map into the scene get an empty list.
+
+    This is considerably faster than calling pickAll() in a loop, as the objects in the
+    scene are only gathered once, and the rays are traced in parallel. This makes it
+    suitable for, for instance, hover effects or lasso selection that need many rays
+    per frame.
+
+    \since 6.4
+*/
+QVariantList QQuick3DViewport::batchPickAll(const QList<QPointF> &positions) const
+{
+    QQuick3DSceneRenderer *renderer = getRenderer();
+    if (!renderer)
+        return QVariantList();
+
+    const qreal dpr = window()->effectiveDevicePixelRatio();
+    QVector<QSSGRenderRay> rays;
+    QVector<int> rayIndices;
+    rays.reserve(positions.size());
+    rayIndices.reserve(positions.size());
+    for (int i = 0; i < positions.size(); ++i) {
+        QSSGOption<QSSGRenderRay> rayResult = renderer->getRayFromViewportPos(positions.at(i) * dpr);
+        if (rayResult.hasValue()) {
+            rays.append(rayResult.getValue());
+            rayIndices.append(i);
+        }
+    }
+
+    return batchPickAllImpl(rays, rayIndices, positions.size());
+}
+
+/*!
+    \qmlmethod list View3D::batchRayPickAll(list<vector3d> origins, list<vector3d> directions)
+
+    This method does the same as \l rayPickAll() for each pair of ray origin and
+    direction from \a origins and \a directions, and returns one list of \l PickResult
+    for each ray, in the same order. Both lists must have the same length.
+
+    This is considerably faster than calling rayPickAll() in a loop, as the objects in
+    the scene are only gathered once, and the rays are traced in parallel. This makes it
+    suitable for, for instance, line-of-sight queries.
+
+    \since 6.4
+*/
+QVariantList QQuick3DViewport::batchRayPickAll(const QList<QVector3D> &origins, const QList<QVector3D> &directions) const
+{
+    if (origins.size() != directions.size()) {
+        qmlWarning(this) << "batchRayPickAll: the lists of origins and directions differ in length";
+        return QVariantList();
+    }
+
+    QVector<QSSGRenderRay> rays;
+    QVector<int> rayIndices;
+    rays.reserve(origins.size());
+    rayIndices.reserve(origins.size());
+    for (int i = 0; i < origins.size(); ++i) {
+        rays.append(QSSGRenderRay(origins.at(i), directions.at(i)));
+        rayIndices.append(i);
+    }
+
+    return batchPickAllImpl(rays, rayIndices, origins.size());
+}
+
 void QQuick3DViewport::processPointerEventFromRay(const QVector3D &origin, const QVector3D &direction, QPointerEvent *event)
 {
     internalPick(event, origin, direction);
@@ -952,6 +1055,9 @@ void QQuick3DViewport::cleanupResources()
             const auto importSceneManager = QQuick3DObjectPrivate::get(m_importScene)->sceneManager;
             rci->cleanupResources(importSceneManager->resourceCleanupQueue);
         }
+        // The frame is fully submitted at this point, so nothing refers to
+        // the cached pipelines and srbs anymore.
+        rci->rhiContext()->releaseUnusedResources();
     }
 }
 
@@ -1232,6 +1338,32 @@ bool QQuick3DViewport::internalPick(QPointerEvent *event, const QVector3D &origi
     return ret;
 }
 
+QVariantList QQuick3DViewport::batchPickAllImpl(const QVector<QSSGRenderRay> &rays,
+                                              const QVector<int> &rayIndices,
+                                              qsizetype resultCount) const
+{
+    QQuick3DSceneRenderer *renderer = getRenderer();
+    if (!renderer)
+        return QVariantList();
+
+    QVariantList processedResults;
+    processedResults.reserve(resultCount);
+    for (qsizetype i = 0; i < resultCount; ++i)
+        processedResults.append(QVariant::fromValue(QList<QQuick3DPickResult>()));
+
+    const auto resultLists = renderer->syncPickAll(rays);
+    for (int i = 0; i < resultLists.size(); ++i) {
+        const auto &resultList = resultLists.at(i);
+        QList<QQuick3DPickResult> processedResultList;
+        processedResultList.reserve(resultList.size());
+        for (const auto &result : resultList)
+            processedResultList.append(processPickResult(result));
+        processedResults[rayIndices.at(i)] = QVariant::fromValue(processedResultList);
+    }
+
+    return processedResults;
+}
+
 QQuick3DPickResult QQuick3DViewport::processPickResult(const QSSGRenderPickResult &pickResult) const
 {
     if (!pickResult.m_hitObject)
@@ -65,6 +65,7 @@ class QQuick3DSceneManager;
 class SGFramebufferObjectNode;
 class QQuick3DSGRenderNode;
 class QQuick3DSGDirectRenderer;
+struct QSSGRenderRay;
 
 class Q_QUICK3D_EXPORT QQuick3DViewport : public QQuickItem
 {
@@ -76,6 +77,7 @@ class Q_QUICK3D_EXPORT QQuick3DViewport : public QQuickItem
     Q_PROPERTY(QQuick3DNode *importScene READ importScene WRITE setImportScene NOTIFY importSceneChanged FINAL)
     Q_PROPERTY(RenderMode renderMode READ renderMode WRITE setRenderMode NOTIFY renderModeChanged FINAL)
     Q_PROPERTY(QQuickShaderEffectSource::Format renderFormat READ renderFormat WRITE setRenderFormat NOTIFY renderFormatChanged FINAL REVISION(6, 4))
+    Q_PROPERTY(QUrl shaderManifest READ shaderManifest WRITE setShaderManifest NOTIFY shaderManifestChanged FINAL REVISION(6, 4))
     Q_PROPERTY(QQuick3DRenderStats *renderStats READ renderStats CONSTANT)
     Q_CLASSINFO("DefaultProperty", "data")
 
@@ -101,6 +103,7 @@ public:
     QQuick3DNode *importScene() const;
     RenderMode renderMode() const;
     Q_REVISION(6, 4) QQuickShaderEffectSource::Format renderFormat() const;
+    Q_REVISION(6, 4) QUrl shaderManifest() const;
     QQuick3DRenderStats *renderStats() const;
 
     QQuick3DSceneRenderer *createRenderer() const;
@@ -116,6 +119,8 @@ public:
     Q_REVISION(6, 2) Q_INVOKABLE QList<QQuick3DPickResult> pickAll(float x, float y) const;
     Q_REVISION(6, 2) Q_INVOKABLE QQuick3DPickResult rayPick(const QVector3D &origin, const QVector3D &direction) const;
     Q_REVISION(6, 2) Q_INVOKABLE QList<QQuick3DPickResult> rayPickAll(const QVector3D &origin, const QVector3D &direction) const;
+    Q_REVISION(6, 4) Q_INVOKABLE QVariantList batchPickAll(const QList<QPointF> &positions) const;
+    Q_REVISION(6, 4) Q_INVOKABLE QVariantList batchRayPickAll(const QList<QVector3D> &origins, const QList<QVector3D> &directions) const;
 
     void processPointerEventFromRay(const QVector3D &origin, const QVector3D &direction, QPointerEvent *event);
 
@@ -132,6 +137,7 @@ public Q_SLOTS:
     void setImportScene(QQuick3DNode *inScene);
     void setRenderMode(QQuick3DViewport::RenderMode renderMode);
     Q_REVISION(6, 4) void setRenderFormat(QQuickShaderEffectSource::Format format);
+    Q_REVISION(6, 4) void setShaderManifest(const QUrl &manifest);
     void cleanupDirectRenderer();
 
     // Setting this true enables picking for all the models, regardless of
@@ -149,6 +155,7 @@ Q_SIGNALS:
     void importSceneChanged();
     void renderModeChanged();
     Q_REVISION(6, 4) void renderFormatChanged();
+    Q_REVISION(6, 4) void shaderManifestChanged();
 
 private:
     Q_DISABLE_COPY(QQuick3DViewport)
@@ -158,6 +165,7 @@ private:
     bool checkIsVisible() const;
     bool internalPick(QPointerEvent *event, const QVector3D &origin = QVector3D(), const QVector3D &direction = QVector3D()) const;
     QQuick3DPickResult processPickResult(const QSSGRenderPickResult &pickResult) const;
+    QVariantList batchPickAllImpl(const QVector<QSSGRenderRay> &rays, const QVector<int> &rayIndices, qsizetype resultCount) const;
     QQuick3DSceneManager *findChildSceneManager(QQuick3DObject *inObject, QQuick3DSceneManager *manager = nullptr);
 
     QQuick3DCamera *m_camera = nullptr;
@@ -170,6 +178,7 @@ private:
     bool m_renderModeDirty = false;
     RenderMode m_renderMode = Offscreen;
     QQuickShaderEffectSource::Format m_renderFormat = QQuickShaderEffectSource::RGBA8;
+    QUrl m_shaderManifest;
     QQuick3DRenderStats *m_renderStats = nullptr;
     QHash<QObject*, QMetaObject::Connection> m_connections;
     bool m_enableInputProcessing = true;
@@ -121,6 +121,26 @@ void QQuick3DParticleAffector::prepareToAffect()
 {
 }
 
+void QQuick3DParticleAffector::affectParticles(QQuick3DParticleDataBatch &batch)
+{
+    for (int i = 0; i < batch.count; ++i) {
+        QQuick3DParticleDataCurrent current = batch.current(i);
+        affectParticle(*batch.data.at(i), &current, batch.times.at(i));
+        batch.setCurrent(i, current);
+    }
+}
+
+bool QQuick3DParticleAffector::canAffectConcurrently() const
+{
+    return false;
+}
+
+bool QQuick3DParticleAffector::fillSimulationData(QSSGParticleAffectorData *data) const
+{
+    Q_UNUSED(data);
+    return false;
+}
+
 // Particles
 
 /*!
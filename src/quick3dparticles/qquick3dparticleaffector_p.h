@@ -51,6 +51,8 @@
 
 QT_BEGIN_NAMESPACE
 
+struct QSSGParticleAffectorData;
+
 class Q_QUICK3DPARTICLES_EXPORT QQuick3DParticleAffector : public QQuick3DNode
 {
     Q_OBJECT
@@ -99,6 +101,16 @@ private:
     virtual void prepareToAffect();
     // Called for each living particle attached to the attractor.
     virtual void affectParticle(const QQuick3DParticleData &sd, QQuick3DParticleDataCurrent *d, float time) = 0;
+    // Called once per frame for each logical particle attached to the attractor,
+    // with all of its living particles. The default implementation calls
+    // affectParticle() for each of them.
+    virtual void affectParticles(QQuick3DParticleDataBatch &batch);
+    // Whether affectParticles() can be called for several batches at the same
+    // time from different threads.
+    virtual bool canAffectConcurrently() const;
+    // Fills the parameters for simulating the affector in the renderer, see
+    // QSSGParticleSimulation. Returns false when that is not supported.
+    virtual bool fillSimulationData(QSSGParticleAffectorData *data) const;
 
     static void appendParticle(QQmlListProperty<QQuick3DParticle> *, QQuick3DParticle *);
     static qsizetype particleCount(QQmlListProperty<QQuick3DParticle> *);
@@ -30,6 +30,10 @@
 #include "qquick3dparticleattractor_p.h"
 #include "qquick3dparticlerandomizer_p.h"
 #include "qquick3dparticleutils_p.h"
+#include "qquick3dparticlesimd_p.h"
+#include <QtQuick3DRuntimeRender/private/qssgrenderparticles_p.h>
+
+#include <limits>
 
 QT_BEGIN_NAMESPACE
 
@@ -326,4 +330,97 @@ void QQuick3DParticleAttractor::affectParticle(const QQuick3DParticleData &sd, Q
     d->position = (pStart * d->position) + (pEnd * m_particleTransform.map(pos));
 }
 
+void QQuick3DParticleAttractor::affectParticles(QQuick3DParticleDataBatch &batch)
+{
+    if (!system())
+        return;
+
+    auto rand = system()->rand();
+    float *durations = batch.scratch(0);
+    float *targetX = batch.scratch(1);
+    float *targetY = batch.scratch(2);
+    float *targetZ = batch.scratch(3);
+    float *ends = batch.scratch(4);
+
+    // Durations and targets depend on the random values and the shape,
+    // so those are collected first particle by particle.
+    const bool sharedTarget = !m_shape && m_positionVariation.isNull();
+    const QVector3D sharedPos = m_particleTransform.map(m_centerPos);
+    for (int i = 0; i < batch.count; ++i) {
+        const QQuick3DParticleData &sd = *batch.data.at(i);
+        float duration = m_duration < 0 ? sd.lifetime : (m_duration / 1000.0f);
+        float durationVariation = m_durationVariation == 0
+                ? 0.0f
+                : (m_durationVariation / 1000.0f) - 2.0f * rand->get(sd.index, QPRand::AttractorDurationV) * (m_durationVariation / 1000.0f);
+        durations[i] = std::max(duration + durationVariation, MIN_DURATION);
+
+        QVector3D pos = m_centerPos;
+        if (m_shape) {
+            if (m_useCachedPositions)
+                pos += m_shapePositionList.at(sd.index % m_shapePositionList.size());
+            else
+                pos += m_shape->getPosition(sd.index);
+        }
+        if (!m_positionVariation.isNull()) {
+            pos.setX(pos.x() + m_positionVariation.x() - 2.0f * rand->get(sd.index, QPRand::AttractorPosVX) * m_positionVariation.x());
+            pos.setY(pos.y() + m_positionVariation.y() - 2.0f * rand->get(sd.index, QPRand::AttractorPosVY) * m_positionVariation.y());
+            pos.setZ(pos.z() + m_positionVariation.z() - 2.0f * rand->get(sd.index, QPRand::AttractorPosVZ) * m_positionVariation.z());
+        }
+        const QVector3D target = sharedTarget ? sharedPos : m_particleTransform.map(pos);
+        targetX[i] = target.x();
+        targetY[i] = target.y();
+        targetZ[i] = target.z();
+    }
+    for (int i = batch.count; i < batch.paddedCount; ++i) {
+        durations[i] = 1.0f;
+        targetX[i] = targetY[i] = targetZ[i] = 0.0f;
+    }
+
+    const QPFloat4 zero = QPFloat4::splat(0.0f);
+    const QPFloat4 one = QPFloat4::splat(1.0f);
+    // Particles hidden at the end keep their position
+    const QPFloat4 hideLimit = QPFloat4::splat(m_hideAtEnd ? 1.0f : std::numeric_limits<float>::infinity());
+    const float *times = batch.times.constData();
+    float *posX = batch.positionX.data();
+    float *posY = batch.positionY.data();
+    float *posZ = batch.positionZ.data();
+    for (int i = 0; i < batch.paddedCount; i += QQuick3DParticleDataBatch::Lanes) {
+        QPFloat4 pEnd = qpMin(one, qpMax(zero, QPFloat4::load(times + i) / QPFloat4::load(durations + i)));
+        pEnd.store(ends + i);
+        pEnd = qpSelectGreaterOrEqual(pEnd, hideLimit, zero, pEnd);
+        const QPFloat4 pStart = one - pEnd;
+        (pStart * QPFloat4::load(posX + i) + pEnd * QPFloat4::load(targetX + i)).store(posX + i);
+        (pStart * QPFloat4::load(posY + i) + pEnd * QPFloat4::load(targetY + i)).store(posY + i);
+        (pStart * QPFloat4::load(posZ + i) + pEnd * QPFloat4::load(targetZ + i)).store(posZ + i);
+    }
+
+    if (m_hideAtEnd) {
+        for (int i = 0; i < batch.count; ++i) {
+            if (ends[i] >= 1.0f)
+                batch.color[i].a = 0;
+        }
+    }
+}
+
+bool QQuick3DParticleAttractor::canAffectConcurrently() const
+{
+    // Shapes may do lazy initialization in getPosition()
+    return !m_shape || m_useCachedPositions;
+}
+
+bool QQuick3DParticleAttractor::fillSimulationData(QSSGParticleAffectorData *data) const
+{
+    // Shape positions are not available in the renderer
+    if (m_shape)
+        return false;
+
+    data->type = QSSGParticleAffectorData::Type::Attractor;
+    data->flags = m_hideAtEnd ? QSSGParticleAffectorData::HideAtEnd : 0;
+    for (int i = 0; i < 4; ++i)
+        data->params[i] = m_particleTransform.column(i);
+    data->params[4] = QVector4D(m_centerPos, m_duration < 0 ? -1.0f : m_duration / 1000.0f);
+    data->params[5] = QVector4D(m_positionVariation, m_durationVariation / 1000.0f);
+    return true;
+}
+
 QT_END_NAMESPACE
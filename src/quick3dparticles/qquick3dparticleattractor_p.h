@@ -91,6 +91,9 @@ Q_SIGNALS:
 protected:
     void prepareToAffect() override;
     void affectParticle(const QQuick3DParticleData &sd, QQuick3DParticleDataCurrent *d, float time) override;
+    void affectParticles(QQuick3DParticleDataBatch &batch) override;
+    bool canAffectConcurrently() const override;
+    bool fillSimulationData(QSSGParticleAffectorData *data) const override;
 
 private:
     void updateShapePositions();
@@ -42,6 +42,7 @@
 //
 
 #include <QVector3D>
+#include <QVector>
 #include <private/qglobal_p.h>
 
 QT_BEGIN_NAMESPACE
@@ -95,6 +96,114 @@ struct QQuick3DParticleData
     // Size: 12+12+3+3+4+4+4+4+4+4 = 54 bytes
 };
 
+// Current data of the living particles of one logical particle, as a
+// structure of arrays. This is what the affectors work on when they process
+// all the particles at once, see QQuick3DParticleAffector::affectParticles().
+// The float arrays are padded to a multiple of Lanes, so that they can be
+// processed in full SIMD registers. The padding lanes hold zeros.
+struct QQuick3DParticleDataBatch
+{
+    static constexpr int Lanes = 4;
+    static constexpr int ScratchArrays = 10;
+
+    int count = 0;
+    int paddedCount = 0;
+    int capacity = 0;
+    // Emit time data of each particle, and its index in the particle data
+    QVector<const QQuick3DParticleData *> data;
+    QVector<int> indices;
+    // Seconds since the particle was emitted
+    QVector<float> times;
+    QVector<float> positionX;
+    QVector<float> positionY;
+    QVector<float> positionZ;
+    QVector<QVector3D> rotation;
+    QVector<QVector3D> scale;
+    QVector<Color4ub> color;
+    // 0.0 -> 1.0 during the particle lifetime
+    QVector<float> timeChanges;
+    // Only used with sprite sequences
+    QVector<float> animationFrames;
+
+    static int padded(int n) { return (n + Lanes - 1) & ~(Lanes - 1); }
+
+    // Makes room for maxCount particles and sets the count to zero
+    void reset(int maxCount)
+    {
+        count = 0;
+        paddedCount = 0;
+        if (capacity >= maxCount)
+            return;
+        capacity = padded(maxCount);
+        data.resize(capacity);
+        indices.resize(capacity);
+        times.resize(capacity);
+        positionX.resize(capacity);
+        positionY.resize(capacity);
+        positionZ.resize(capacity);
+        rotation.resize(capacity);
+        scale.resize(capacity);
+        color.resize(capacity);
+        timeChanges.resize(capacity);
+        animationFrames.resize(capacity);
+        m_scratch.resize(capacity * ScratchArrays);
+    }
+
+    void append(const QQuick3DParticleData *d, int index, float time, float timeChange, const QQuick3DParticleDataCurrent &current)
+    {
+        data[count] = d;
+        indices[count] = index;
+        times[count] = time;
+        timeChanges[count] = timeChange;
+        animationFrames[count] = 0.0f;
+        setCurrent(count, current);
+        ++count;
+    }
+
+    // Called after the last append(), clears the padding lanes
+    void finish()
+    {
+        paddedCount = padded(count);
+        for (int i = count; i < paddedCount; ++i) {
+            times[i] = 0.0f;
+            positionX[i] = 0.0f;
+            positionY[i] = 0.0f;
+            positionZ[i] = 0.0f;
+        }
+    }
+
+    QQuick3DParticleDataCurrent current(int i) const
+    {
+        QQuick3DParticleDataCurrent d;
+        d.position = QVector3D(positionX.at(i), positionY.at(i), positionZ.at(i));
+        d.rotation = rotation.at(i);
+        d.scale = scale.at(i);
+        d.color = color.at(i);
+        return d;
+    }
+
+    void setCurrent(int i, const QQuick3DParticleDataCurrent &d)
+    {
+        positionX[i] = d.position.x();
+        positionY[i] = d.position.y();
+        positionZ[i] = d.position.z();
+        rotation[i] = d.rotation;
+        scale[i] = d.scale;
+        color[i] = d.color;
+    }
+
+    // Per particle temporary arrays for the affectors, paddedCount long.
+    // Their content is undefined when an affector starts.
+    float *scratch(int array)
+    {
+        Q_ASSERT(array < ScratchArrays);
+        return m_scratch.data() + array * capacity;
+    }
+
+private:
+    QVector<float> m_scratch;
+};
+
 // Data structure for storing bursts
 struct QQuick3DParticleEmitBurstData {
     int amount = 0;
@@ -28,6 +28,8 @@
 ****************************************************************************/
 
 #include "qquick3dparticlegravity_p.h"
+#include "qquick3dparticlesimd_p.h"
+#include <QtQuick3DRuntimeRender/private/qssgrenderparticles_p.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -102,4 +104,35 @@ void QQuick3DParticleGravity::affectParticle(const QQuick3DParticleData &sd, QQu
     d->position += velocity * m_directionNormalized;
 }
 
+void QQuick3DParticleGravity::affectParticles(QQuick3DParticleDataBatch &batch)
+{
+    const QPFloat4 halfMagnitude = QPFloat4::splat(0.5f * m_magnitude);
+    const QPFloat4 dirX = QPFloat4::splat(m_directionNormalized.x());
+    const QPFloat4 dirY = QPFloat4::splat(m_directionNormalized.y());
+    const QPFloat4 dirZ = QPFloat4::splat(m_directionNormalized.z());
+    const float *times = batch.times.constData();
+    float *posX = batch.positionX.data();
+    float *posY = batch.positionY.data();
+    float *posZ = batch.positionZ.data();
+    for (int i = 0; i < batch.paddedCount; i += QQuick3DParticleDataBatch::Lanes) {
+        const QPFloat4 time = QPFloat4::load(times + i);
+        const QPFloat4 velocity = halfMagnitude * (time * time);
+        (QPFloat4::load(posX + i) + velocity * dirX).store(posX + i);
+        (QPFloat4::load(posY + i) + velocity * dirY).store(posY + i);
+        (QPFloat4::load(posZ + i) + velocity * dirZ).store(posZ + i);
+    }
+}
+
+bool QQuick3DParticleGravity::canAffectConcurrently() const
+{
+    return true;
+}
+
+bool QQuick3DParticleGravity::fillSimulationData(QSSGParticleAffectorData *data) const
+{
+    data->type = QSSGParticleAffectorData::Type::Gravity;
+    data->params[0] = QVector4D(m_directionNormalized, m_magnitude);
+    return true;
+}
+
 QT_END_NAMESPACE
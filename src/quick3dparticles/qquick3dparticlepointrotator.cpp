@@ -28,6 +28,8 @@
 ****************************************************************************/
 
 #include "qquick3dparticlepointrotator_p.h"
+#include "qquick3dparticlesimd_p.h"
+#include <QtQuick3DRuntimeRender/private/qssgrenderparticles_p.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -135,4 +137,64 @@ void QQuick3DParticlePointRotator::affectParticle(const QQuick3DParticleData &sd
     }
 }
 
+void QQuick3DParticlePointRotator::affectParticles(QQuick3DParticleDataBatch &batch)
+{
+    if (qFuzzyIsNull(m_magnitude))
+        return;
+
+    // Same rotation as in affectParticle(), applied as
+    // pivot + R * (position - pivot) instead of through a matrix.
+    float *cosines = batch.scratch(0);
+    float *sines = batch.scratch(1);
+    for (int i = 0; i < batch.count; ++i) {
+        const float angle = qDegreesToRadians(batch.times.at(i) * m_magnitude);
+        cosines[i] = std::cos(angle);
+        sines[i] = std::sin(angle);
+    }
+    for (int i = batch.count; i < batch.paddedCount; ++i) {
+        cosines[i] = 1.0f;
+        sines[i] = 0.0f;
+    }
+
+    const QPFloat4 one = QPFloat4::splat(1.0f);
+    const QPFloat4 x = QPFloat4::splat(m_directionNormalized.x());
+    const QPFloat4 y = QPFloat4::splat(m_directionNormalized.y());
+    const QPFloat4 z = QPFloat4::splat(m_directionNormalized.z());
+    const QPFloat4 xx = x * x, yy = y * y, zz = z * z;
+    const QPFloat4 xy = x * y, xz = x * z, yz = y * z;
+    const QPFloat4 pivotX = QPFloat4::splat(m_pivotPoint.x());
+    const QPFloat4 pivotY = QPFloat4::splat(m_pivotPoint.y());
+    const QPFloat4 pivotZ = QPFloat4::splat(m_pivotPoint.z());
+    float *posX = batch.positionX.data();
+    float *posY = batch.positionY.data();
+    float *posZ = batch.positionZ.data();
+    for (int i = 0; i < batch.paddedCount; i += QQuick3DParticleDataBatch::Lanes) {
+        const QPFloat4 c = QPFloat4::load(cosines + i);
+        const QPFloat4 s = QPFloat4::load(sines + i);
+        const QPFloat4 ic = one - c;
+        const QPFloat4 px = QPFloat4::load(posX + i) - pivotX;
+        const QPFloat4 py = QPFloat4::load(posY + i) - pivotY;
+        const QPFloat4 pz = QPFloat4::load(posZ + i) - pivotZ;
+        const QPFloat4 rx = (xx * ic + c) * px + (xy * ic - z * s) * py + (xz * ic + y * s) * pz;
+        const QPFloat4 ry = (xy * ic + z * s) * px + (yy * ic + c) * py + (yz * ic - x * s) * pz;
+        const QPFloat4 rz = (xz * ic - y * s) * px + (yz * ic + x * s) * py + (zz * ic + c) * pz;
+        (rx + pivotX).store(posX + i);
+        (ry + pivotY).store(posY + i);
+        (rz + pivotZ).store(posZ + i);
+    }
+}
+
+bool QQuick3DParticlePointRotator::canAffectConcurrently() const
+{
+    return true;
+}
+
+bool QQuick3DParticlePointRotator::fillSimulationData(QSSGParticleAffectorData *data) const
+{
+    data->type = QSSGParticleAffectorData::Type::PointRotator;
+    data->params[0] = QVector4D(m_directionNormalized, qFuzzyIsNull(m_magnitude) ? 0.0f : m_magnitude);
+    data->params[1] = QVector4D(m_pivotPoint, 0.0f);
+    return true;
+}
+
 QT_END_NAMESPACE
@@ -75,6 +75,9 @@ Q_SIGNALS:
 protected:
     void prepareToAffect() override;
     void affectParticle(const QQuick3DParticleData &sd, QQuick3DParticleDataCurrent *d, float time) override;
+    void affectParticles(QQuick3DParticleDataBatch &batch) override;
+    bool canAffectConcurrently() const override;
+    bool fillSimulationData(QSSGParticleAffectorData *data) const override;
 
 private:
     float m_magnitude = 10.0f;
@@ -134,6 +134,7 @@ public:
         m_randomList.reserve(m_size);
         for (int i = 0; i < m_size; i++)
             m_randomList << float(m_generator.generateDouble());
+        m_serial++;
     }
 
     void setDeterministic(bool deterministic) {
@@ -159,10 +160,21 @@ public:
     {
         return m_generator;
     }
+    // The values get() returns from, for simulating the particles elsewhere.
+    // The serial changes whenever the values do.
+    const QList<float> &randomList() const
+    {
+        return m_randomList;
+    }
+    int serial() const
+    {
+        return m_serial;
+    }
 private:
     QRandomGenerator m_generator;
     int m_size = 0;
     int m_index = 0;
+    int m_serial = 0;
     bool m_deterministic = false;
     QList<float> m_randomList;
 
@@ -0,0 +1,196 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Quick 3D.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QQUICK3DPARTICLESIMD_H
+#define QQUICK3DPARTICLESIMD_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/private/qsimd_p.h>
+#include <QtQuick3DParticles/private/qquick3dparticleutils_p.h>
+#include <cmath>
+
+QT_BEGIN_NAMESPACE
+
+// Four floats processed together, used by the batch versions of the affectors.
+// Falls back to plain loops when neither SSE2 nor NEON is available.
+struct QPFloat4
+{
+#if defined(__SSE2__)
+    __m128 v;
+
+    static QPFloat4 load(const float *p) { return { _mm_loadu_ps(p) }; }
+    static QPFloat4 splat(float f) { return { _mm_set1_ps(f) }; }
+    void store(float *p) const { _mm_storeu_ps(p, v); }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    float32x4_t v;
+
+    static QPFloat4 load(const float *p) { return { vld1q_f32(p) }; }
+    static QPFloat4 splat(float f) { return { vdupq_n_f32(f) }; }
+    void store(float *p) const { vst1q_f32(p, v); }
+#else
+    float v[4];
+
+    static QPFloat4 load(const float *p) { return { { p[0], p[1], p[2], p[3] } }; }
+    static QPFloat4 splat(float f) { return { { f, f, f, f } }; }
+    void store(float *p) const { p[0] = v[0]; p[1] = v[1]; p[2] = v[2]; p[3] = v[3]; }
+#endif
+};
+
+#if defined(__SSE2__)
+
+inline QPFloat4 operator+(QPFloat4 a, QPFloat4 b) { return { _mm_add_ps(a.v, b.v) }; }
+inline QPFloat4 operator-(QPFloat4 a, QPFloat4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+inline QPFloat4 operator*(QPFloat4 a, QPFloat4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+inline QPFloat4 operator/(QPFloat4 a, QPFloat4 b) { return { _mm_div_ps(a.v, b.v) }; }
+inline QPFloat4 qpMin(QPFloat4 a, QPFloat4 b) { return { _mm_min_ps(a.v, b.v) }; }
+inline QPFloat4 qpMax(QPFloat4 a, QPFloat4 b) { return { _mm_max_ps(a.v, b.v) }; }
+// Returns ifTrue in the lanes where a >= b and ifFalse elsewhere
+inline QPFloat4 qpSelectGreaterOrEqual(QPFloat4 a, QPFloat4 b, QPFloat4 ifTrue, QPFloat4 ifFalse)
+{
+    const __m128 mask = _mm_cmpge_ps(a.v, b.v);
+    return { _mm_or_ps(_mm_and_ps(mask, ifTrue.v), _mm_andnot_ps(mask, ifFalse.v)) };
+}
+
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+
+inline QPFloat4 operator+(QPFloat4 a, QPFloat4 b) { return { vaddq_f32(a.v, b.v) }; }
+inline QPFloat4 operator-(QPFloat4 a, QPFloat4 b) { return { vsubq_f32(a.v, b.v) }; }
+inline QPFloat4 operator*(QPFloat4 a, QPFloat4 b) { return { vmulq_f32(a.v, b.v) }; }
+inline QPFloat4 operator/(QPFloat4 a, QPFloat4 b)
+{
+#if defined(__aarch64__)
+    return { vdivq_f32(a.v, b.v) };
+#else
+    // ARMv7 NEON has only a reciprocal estimate, divide lane by lane to
+    // get the same results as the scalar code.
+    float fa[4], fb[4];
+    a.store(fa);
+    b.store(fb);
+    for (int i = 0; i < 4; ++i)
+        fa[i] /= fb[i];
+    return QPFloat4::load(fa);
+#endif
+}
+inline QPFloat4 qpMin(QPFloat4 a, QPFloat4 b) { return { vminq_f32(a.v, b.v) }; }
+inline QPFloat4 qpMax(QPFloat4 a, QPFloat4 b) { return { vmaxq_f32(a.v, b.v) }; }
+inline QPFloat4 qpSelectGreaterOrEqual(QPFloat4 a, QPFloat4 b, QPFloat4 ifTrue, QPFloat4 ifFalse)
+{
+    return { vbslq_f32(vcgeq_f32(a.v, b.v), ifTrue.v, ifFalse.v) };
+}
+
+#else
+
+#define QPFLOAT4_BINARY_OP(name, expr) \
+    inline QPFloat4 name(QPFloat4 a, QPFloat4 b) \
+    { \
+        QPFloat4 r; \
+        for (int i = 0; i < 4; ++i) \
+            r.v[i] = expr; \
+        return r; \
+    }
+QPFLOAT4_BINARY_OP(operator+, a.v[i] + b.v[i])
+QPFLOAT4_BINARY_OP(operator-, a.v[i] - b.v[i])
+QPFLOAT4_BINARY_OP(operator*, a.v[i] * b.v[i])
+QPFLOAT4_BINARY_OP(operator/, a.v[i] / b.v[i])
+QPFLOAT4_BINARY_OP(qpMin, qMin(a.v[i], b.v[i]))
+QPFLOAT4_BINARY_OP(qpMax, qMax(a.v[i], b.v[i]))
+#undef QPFLOAT4_BINARY_OP
+inline QPFloat4 qpSelectGreaterOrEqual(QPFloat4 a, QPFloat4 b, QPFloat4 ifTrue, QPFloat4 ifFalse)
+{
+    QPFloat4 r;
+    for (int i = 0; i < 4; ++i)
+        r.v[i] = a.v[i] >= b.v[i] ? ifTrue.v[i] : ifFalse.v[i];
+    return r;
+}
+
+#endif
+
+// Vector version of QPSIN. The table lookups are done lane by lane, the
+// rest of qLookupSin() runs in SIMD registers. The results are not always
+// bit-identical to qLookupSin(): the compiler is free to fuse the scalar
+// multiply-adds, which rounds differently in the last bit.
+inline QPFloat4 qpSin(QPFloat4 x)
+{
+#if defined(QT_QUICK3D_PARTICLES_USE_STANDARD_SIN)
+    float f[4];
+    x.store(f);
+    for (int i = 0; i < 4; ++i)
+        f[i] = sinf(f[i]);
+    return QPFloat4::load(f);
+#else
+    alignas(16) int si[4];
+    alignas(16) int ci[4];
+    QPFloat4 d;
+#if defined(__SSE2__)
+    const __m128i sii = _mm_cvttps_epi32(_mm_mul_ps(x.v, _mm_set1_ps(QT_QUICK3D_SINE_H1)));
+    d.v = _mm_sub_ps(x.v, _mm_mul_ps(_mm_cvtepi32_ps(sii), _mm_set1_ps(QT_QUICK3D_SINE_H2)));
+    const __m128i mask = _mm_set1_epi32(QT_QUICK3D_SINE_TABLE_SIZE - 1);
+    const __m128i cii = _mm_add_epi32(sii, _mm_set1_epi32(QT_QUICK3D_SINE_TABLE_SIZE / 4));
+    _mm_store_si128(reinterpret_cast<__m128i *>(si), _mm_and_si128(sii, mask));
+    _mm_store_si128(reinterpret_cast<__m128i *>(ci), _mm_and_si128(cii, mask));
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    const int32x4_t sii = vcvtq_s32_f32(vmulq_f32(x.v, vdupq_n_f32(QT_QUICK3D_SINE_H1)));
+    d.v = vsubq_f32(x.v, vmulq_f32(vcvtq_f32_s32(sii), vdupq_n_f32(QT_QUICK3D_SINE_H2)));
+    const int32x4_t mask = vdupq_n_s32(QT_QUICK3D_SINE_TABLE_SIZE - 1);
+    const int32x4_t cii = vaddq_s32(sii, vdupq_n_s32(QT_QUICK3D_SINE_TABLE_SIZE / 4));
+    vst1q_s32(si, vandq_s32(sii, mask));
+    vst1q_s32(ci, vandq_s32(cii, mask));
+#else
+    for (int i = 0; i < 4; ++i) {
+        si[i] = int(x.v[i] * QT_QUICK3D_SINE_H1);
+        d.v[i] = x.v[i] - si[i] * QT_QUICK3D_SINE_H2;
+        ci[i] = (si[i] + QT_QUICK3D_SINE_TABLE_SIZE / 4) & (QT_QUICK3D_SINE_TABLE_SIZE - 1);
+        si[i] &= QT_QUICK3D_SINE_TABLE_SIZE - 1;
+    }
+#endif
+    float sv[4];
+    float cv[4];
+    for (int i = 0; i < 4; ++i) {
+        sv[i] = qt_quick3d_sine_table[si[i]];
+        cv[i] = qt_quick3d_sine_table[ci[i]];
+    }
+    const QPFloat4 s = QPFloat4::load(sv);
+    const QPFloat4 c = QPFloat4::load(cv);
+    return s + (c - QPFloat4::splat(0.5f) * s * d) * d;
+#endif
+}
+
+QT_END_NAMESPACE
+
+#endif // QQUICK3DPARTICLESIMD_H
@@ -29,6 +29,7 @@
 
 #include "qquick3dparticlespriteparticle_p.h"
 #include "qquick3dparticleemitter_p.h"
+#include "qquick3dparticlerandomizer_p.h"
 
 #include <QtQuick3D/private/qquick3dobject_p.h>
 
@@ -404,11 +405,24 @@ QSSGRenderGraphObject *QQuick3DParticleSpriteParticle::updateParticleNode(const
 
     auto particles = static_cast<QSSGRenderParticles *>(node);
 
-    const auto &perEmitter = perEmitterData(updateNode);
-    if (m_featureLevel == QQuick3DParticleSpriteParticle::Animated || m_featureLevel == QQuick3DParticleSpriteParticle::AnimatedVLight)
-        updateAnimatedParticleBuffer(perEmitter, particles);
-    else
-        updateParticleBuffer(perEmitter, particles);
+    auto &perEmitter = perEmitterData(updateNode);
+    if (m_simulated) {
+        updateParticleSimulation(perEmitter, particles);
+    } else {
+        if (particles->m_simulation.enabled) {
+            // Keep the serial increasing, the render contexts compare against it
+            const int serial = particles->m_simulation.serial;
+            particles->m_simulation = QSSGParticleSimulation();
+            particles->m_simulation.serial = serial + 1;
+            particles->m_particleBuffer.resize(0);
+        }
+        perEmitter.emittedSlots.clear();
+        perEmitter.simulationDirty = true;
+        if (m_featureLevel == QQuick3DParticleSpriteParticle::Animated || m_featureLevel == QQuick3DParticleSpriteParticle::AnimatedVLight)
+            updateAnimatedParticleBuffer(perEmitter, particles);
+        else
+            updateParticleBuffer(perEmitter, particles);
+    }
 
     if (!updateNode->m_nodeDirty)
         return particles;
@@ -547,6 +561,15 @@ int QQuick3DParticleSpriteParticle::nextCurrentIndex(const QQuick3DParticleEmitt
         perEmitter.particleCount++;
     }
     m_spriteParticleData[index].emitterIndex = perEmitter.emitterIndex;
+    if (m_simulated) {
+        // All the nodes cover every slot, the slot may also have belonged to another emitter
+        for (PerEmitterData &value : m_perEmitterData) {
+            if (value.emittedSlots.size() < m_maxAmount)
+                value.emittedSlots.append(index);
+            else
+                value.simulationDirty = true;
+        }
+    }
     return index;
 }
 
@@ -712,6 +735,98 @@ void QQuick3DParticleSpriteParticle::updateAnimatedParticleBuffer(const PerEmitt
     node->m_particleBuffer.setBounds(bounds);
 }
 
+QSSGParticleEmitData QQuick3DParticleSpriteParticle::particleEmitData(int slot, int emitterIndex) const
+{
+    QSSGParticleEmitData e = {};
+    const QQuick3DParticleData &d = m_particleData.at(slot);
+    if (m_spriteParticleData.at(slot).emitterIndex != emitterIndex || d.startTime < 0.0f) {
+        e.lifetime = -1.0f;
+        return e;
+    }
+    // Same as in QQuick3DParticleSystem::processParticleCommon()
+    constexpr float step = 360.0f / 127.0f;
+    const Vector3b &rv = d.startRotationVelocity;
+    e.startPosition = d.startPosition;
+    e.startTime = d.startTime;
+    e.startVelocity = d.startVelocity;
+    e.lifetime = d.lifetime;
+    e.startRotation = QVector3D(d.startRotation.x, d.startRotation.y, d.startRotation.z) * step;
+    e.startSize = d.startSize;
+    e.rotationVelocity = QVector3D(abs(rv.x) * rv.x, abs(rv.y) * rv.y, abs(rv.z) * rv.z);
+    e.endSize = d.endSize;
+    e.startColor = QVector4D(float(d.startColor.r) / 255.0f,
+                             float(d.startColor.g) / 255.0f,
+                             float(d.startColor.b) / 255.0f,
+                             float(d.startColor.a) / 255.0f);
+    e.index = quint32(d.index);
+    return e;
+}
+
+// The simulation reads the random table with the same user offsets
+static_assert(QPRand::WanderXPS == QSSG_PARTICLE_RANDOM_WANDER_XPS);
+static_assert(QPRand::WanderXPV == QSSG_PARTICLE_RANDOM_WANDER_XPV);
+static_assert(QPRand::WanderXAV == QSSG_PARTICLE_RANDOM_WANDER_XAV);
+static_assert(QPRand::AttractorDurationV == QSSG_PARTICLE_RANDOM_ATTRACTOR_DURATIONV);
+static_assert(QPRand::AttractorPosVX == QSSG_PARTICLE_RANDOM_ATTRACTOR_POSVX);
+
+static QSSGParticleSimulation::FadeEffect mapFadeEffect(QQuick3DParticle::FadeType type)
+{
+    switch (type) {
+    case QQuick3DParticle::FadeOpacity:
+        return QSSGParticleSimulation::FadeEffect::Opacity;
+    case QQuick3DParticle::FadeScale:
+        return QSSGParticleSimulation::FadeEffect::Scale;
+    default:
+        return QSSGParticleSimulation::FadeEffect::None;
+    }
+}
+
+void QQuick3DParticleSpriteParticle::updateParticleSimulation(PerEmitterData &perEmitter, QSSGRenderGraphObject *spatialNode)
+{
+    QSSGRenderParticles *node = static_cast<QSSGRenderParticles *>(spatialNode);
+    if (!node)
+        return;
+    QSSGParticleSimulation &sim = node->m_simulation;
+
+    // The renderer writes the particles to the slots they were emitted to,
+    // the slots of the other emitters stay unused.
+    const int slotCount = m_particleData.size();
+    if (node->m_particleBuffer.particleCount() != slotCount || node->m_particleBuffer.bufferSize() || m_useAnimatedParticle)
+        node->m_particleBuffer.resizeLayout(slotCount, sizeof(QSSGParticleSimple));
+    m_useAnimatedParticle = false;
+
+    const int emitterIndex = perEmitter.emitterIndex;
+    if (!sim.enabled || perEmitter.simulationDirty || sim.emitData.size() != slotCount) {
+        sim.emitData.resize(slotCount);
+        for (int i = 0; i < slotCount; ++i)
+            sim.emitData[i] = particleEmitData(i, emitterIndex);
+        sim.markAllDirty();
+    } else {
+        for (int slot : qAsConst(perEmitter.emittedSlots)) {
+            sim.emitData[slot] = particleEmitData(slot, emitterIndex);
+            sim.markDirty(slot);
+        }
+    }
+    perEmitter.emittedSlots.clear();
+    perEmitter.simulationDirty = false;
+    sim.enabled = true;
+
+    const QPRand *rand = system()->rand();
+    if (sim.randomTableSerial != rand->serial()) {
+        sim.randomTable = rand->randomList();
+        sim.randomTableSerial = rand->serial();
+    }
+    sim.time = m_simulationTime;
+    sim.fadeInDuration = fadeInDuration() / 1000.0f;
+    sim.fadeOutDuration = fadeOutDuration() / 1000.0f;
+    sim.fadeInEffect = mapFadeEffect(fadeInEffect());
+    sim.fadeOutEffect = mapFadeEffect(fadeOutEffect());
+    sim.particleScale = m_particleScale;
+    sim.offset = QVector2D(offsetX(), offsetY());
+    sim.affectors = m_simulationAffectors;
+    sim.serial++;
+}
+
 void QQuick3DParticleSpriteParticle::updateSceneManager(QQuick3DSceneManager *sceneManager)
 {
     // Check all the resource value's scene manager, and update as necessary.
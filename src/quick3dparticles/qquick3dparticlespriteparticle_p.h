@@ -175,12 +175,17 @@ private:
         int particleCount = 0;
         int emitterIndex = -1;
         const QQuick3DParticleEmitter *emitter = nullptr;
+        // Slots emitted since the last node update, when simulated by the renderer
+        QVector<int> emittedSlots;
+        bool simulationDirty = true;
     };
 
     static QSSGRenderParticles::FeatureLevel mapFeatureLevel(QQuick3DParticleSpriteParticle::FeatureLevel level);
 
     void updateParticleBuffer(const PerEmitterData &perEmitter, QSSGRenderGraphObject *node);
     void updateAnimatedParticleBuffer(const PerEmitterData &perEmitter, QSSGRenderGraphObject *node);
+    void updateParticleSimulation(PerEmitterData &perEmitter, QSSGRenderGraphObject *node);
+    QSSGParticleEmitData particleEmitData(int slot, int emitterIndex) const;
     QSSGRenderGraphObject *updateParticleNode(const ParticleUpdateNode *updateNode, QSSGRenderGraphObject *node);
     void updateSceneManager(QQuick3DSceneManager *window);
     void handleMaxAmountChanged(int amount);
@@ -205,6 +210,10 @@ private:
     bool m_billboard = false;
     FeatureLevel m_featureLevel = FeatureLevel::Simple;
     bool m_useAnimatedParticle = false;
+    // Set by the system when the renderer simulates the particles
+    bool m_simulated = false;
+    float m_simulationTime = 0.0f;
+    QVarLengthArray<QSSGParticleAffectorData, QSSGParticleSimulation::MaxAffectors> m_simulationAffectors;
 
     // Lights
     Q_REVISION(6, 3) static void qmlAppendLight(QQmlListProperty<QQuick3DAbstractLight> *list, QQuick3DAbstractLight *light);
@@ -38,6 +38,8 @@
 #include "qquick3dparticlespriteparticle_p.h"
 #include "qquick3dparticlemodelblendparticle_p.h"
 #include <QtQuick3DUtils/private/qquick3dprofiler_p.h>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThreadPool>
 #include <cmath>
 
 QT_BEGIN_NAMESPACE
@@ -598,6 +600,34 @@ void QQuick3DParticleSystem::processModelParticle(QQuick3DParticleModelParticle
 
     const int c = modelParticle->maxAmount();
 
+    // Without trails the affectors can process all the particles at once
+    if (trailEmits.isEmpty() && !isBatchingDisabled()) {
+        const int batchCount = processBatches(modelParticle, c, [&](QQuick3DParticleDataBatch &batch, int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                const auto d = &modelParticle->m_particleData.at(i);
+                if (timeS < d->startTime || timeS > d->startTime + d->lifetime)
+                    continue;
+                const float particleTimeS = timeS - d->startTime;
+                QQuick3DParticleDataCurrent currentData;
+                const float timeChange = processModelParticleData(currentData, modelParticle, d, particleTimeS);
+                batch.append(d, i, particleTimeS, timeChange, currentData);
+            }
+            batch.finish();
+            affectParticles(modelParticle, batch);
+        });
+        // Instances are added in particle order, as in the unbatched path
+        for (int b = 0; b < batchCount; b++) {
+            const QQuick3DParticleDataBatch &batch = m_particleBatches.at(b);
+            for (int i = 0; i < batch.count; i++) {
+                const QQuick3DParticleDataCurrent currentData = batch.current(i);
+                const QColor color(currentData.color.r, currentData.color.g, currentData.color.b, currentData.color.a);
+                modelParticle->addInstance(currentData.position, currentData.scale, currentData.rotation, color, batch.timeChanges.at(i));
+            }
+        }
+        modelParticle->commitInstance();
+        return;
+    }
+
     for (int i = 0; i < c; i++) {
         const auto d = &modelParticle->m_particleData.at(i);
 
@@ -618,22 +648,8 @@ void QQuick3DParticleSystem::processModelParticle(QQuick3DParticleModelParticle
             for (auto trailEmit : qAsConst(trailEmits))
                 trailEmit.emitter->emitTrailParticles(d->startPosition, 0, QQuick3DParticleDynamicBurst::TriggerStart);
         }
-        // Process features shared for both model & sprite particles
-        processParticleCommon(currentData, d, particleTimeS);
-
-        // Add a base rotation if alignment requested
-        if (modelParticle->m_alignMode != QQuick3DParticle::AlignNone)
-            processParticleAlignment(currentData, modelParticle, d);
-
-        // 0.0 -> 1.0 during the particle lifetime
-        const float timeChange = std::max(0.0f, std::min(1.0f, particleTimeS / d->lifetime));
-
-        // Scale from initial to endScale
-        currentData.scale = modelParticle->m_initialScale * (d->endSize * timeChange + d->startSize * (1.0f - timeChange));
-
-        // Fade in & out
-        const float particleTimeLeftS = d->lifetime - particleTimeS;
-        processParticleFadeInOut(currentData, modelParticle, particleTimeS, particleTimeLeftS);
+        m_particlesUsed++;
+        const float timeChange = processModelParticleData(currentData, modelParticle, d, particleTimeS);
 
         // Affectors
         for (auto affector : qAsConst(m_affectors)) {
@@ -653,6 +669,29 @@ void QQuick3DParticleSystem::processModelParticle(QQuick3DParticleModelParticle
     modelParticle->commitInstance();
 }
 
+// Particle data before the affectors, returns the particle lifetime progress
+float QQuick3DParticleSystem::processModelParticleData(QQuick3DParticleDataCurrent &currentData, const QQuick3DParticleModelParticle *modelParticle, const QQuick3DParticleData *d, float particleTimeS)
+{
+    // Process features shared for both model & sprite particles
+    processParticleCommon(currentData, d, particleTimeS);
+
+    // Add a base rotation if alignment requested
+    if (modelParticle->m_alignMode != QQuick3DParticle::AlignNone)
+        processParticleAlignment(currentData, modelParticle, d);
+
+    // 0.0 -> 1.0 during the particle lifetime
+    const float timeChange = std::max(0.0f, std::min(1.0f, particleTimeS / d->lifetime));
+
+    // Scale from initial to endScale
+    currentData.scale = modelParticle->m_initialScale * (d->endSize * timeChange + d->startSize * (1.0f - timeChange));
+
+    // Fade in & out
+    const float particleTimeLeftS = d->lifetime - particleTimeS;
+    processParticleFadeInOut(currentData, modelParticle, particleTimeS, particleTimeLeftS);
+
+    return timeChange;
+}
+
 static QVector3D mix(const QVector3D &a, const QVector3D &b, float f)
 {
     return (b - a) * f + a;
@@ -708,6 +747,7 @@ void QQuick3DParticleSystem::processModelBlendParticle(QQuick3DParticleModelBlen
             for (auto trailEmit : qAsConst(trailEmits))
                 trailEmit.emitter->emitTrailParticles(d->startPosition, 0, QQuick3DParticleDynamicBurst::TriggerStart);
         }
+        m_particlesUsed++;
 
         // Process features shared for both model & sprite particles
         processParticleCommon(currentData, d, particleTimeS);
@@ -757,8 +797,51 @@ void QQuick3DParticleSystem::processModelBlendParticle(QQuick3DParticleModelBlen
 
 void QQuick3DParticleSystem::processSpriteParticle(QQuick3DParticleSpriteParticle *spriteParticle, const QVector<TrailEmits> &trailEmits, float timeS)
 {
+    // The renderer simulates the particles from their emit data
+    if (prepareSpriteSimulation(spriteParticle, timeS)) {
+        spriteParticle->commitParticles();
+        return;
+    }
+
     const int c = spriteParticle->maxAmount();
 
+    // Without trails the affectors can process all the particles at once
+    if (trailEmits.isEmpty() && !isBatchingDisabled()) {
+        // Every range writes only its own particles
+        spriteParticle->m_spriteParticleData.detach();
+        const QVector3D offset(spriteParticle->offsetX(), spriteParticle->offsetY(), 0);
+        processBatches(spriteParticle, c, [&](QQuick3DParticleDataBatch &batch, int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                const auto d = &spriteParticle->m_particleData.at(i);
+                if (timeS < d->startTime || timeS > d->startTime + d->lifetime) {
+                    // Particle not alive currently
+                    spriteParticle->resetParticleData(i);
+                    continue;
+                }
+                const float particleTimeS = timeS - d->startTime;
+                QQuick3DParticleDataCurrent currentData;
+                float animationFrame = 0.0f;
+                const float timeChange = processSpriteParticleData(currentData, &animationFrame, spriteParticle, d, particleTimeS);
+                batch.append(d, i, particleTimeS, timeChange, currentData);
+                batch.animationFrames[batch.count - 1] = animationFrame;
+            }
+            batch.finish();
+            affectParticles(spriteParticle, batch);
+            for (int i = 0; i < batch.count; i++) {
+                const QQuick3DParticleDataCurrent currentData = batch.current(i);
+                const QVector4D color(float(currentData.color.r) / 255.0f,
+                                      float(currentData.color.g) / 255.0f,
+                                      float(currentData.color.b) / 255.0f,
+                                      float(currentData.color.a) / 255.0f);
+                spriteParticle->setParticleData(batch.indices.at(i), currentData.position + (offset * currentData.scale.x()),
+                                                currentData.rotation, color, currentData.scale.x(), batch.timeChanges.at(i),
+                                                batch.animationFrames.at(i));
+            }
+        });
+        spriteParticle->commitParticles();
+        return;
+    }
+
     for (int i = 0; i < c; i++) {
         const auto d = &spriteParticle->m_particleData.at(i);
 
@@ -779,46 +862,9 @@ void QQuick3DParticleSystem::processSpriteParticle(QQuick3DParticleSpriteParticl
             for (auto trailEmit : qAsConst(trailEmits))
                 trailEmit.emitter->emitTrailParticles(d->startPosition, 0, QQuick3DParticleDynamicBurst::TriggerStart);
         }
-        // Process features shared for both model & sprite particles
-        processParticleCommon(currentData, d, particleTimeS);
-
-        // Add a base rotation if alignment requested
-        if (!spriteParticle->m_billboard && spriteParticle->m_alignMode != QQuick3DParticle::AlignNone)
-            processParticleAlignment(currentData, spriteParticle, d);
-
-        // 0.0 -> 1.0 during the particle lifetime
-        const float timeChange = std::max(0.0f, std::min(1.0f, particleTimeS / d->lifetime));
-
-        // Scale from initial to endScale
-        const float scale = d->endSize * timeChange + d->startSize * (1.0f - timeChange);
-        currentData.scale = QVector3D(scale, scale, scale);
-
-        // Fade in & out
-        const float particleTimeLeftS = d->lifetime - particleTimeS;
-        processParticleFadeInOut(currentData, spriteParticle, particleTimeS, particleTimeLeftS);
-
+        m_particlesUsed++;
         float animationFrame = 0.0f;
-        if (auto sequence = spriteParticle->m_spriteSequence) {
-            // animationFrame range is [0..1) where 0.0 is the beginning of the first frame
-            // and 0.9999 is the end of the last frame.
-            const bool isSingleFrame = (sequence->animationDirection() == QQuick3DParticleSpriteSequence::SingleFrame);
-            float startFrame = sequence->firstFrame(d->index, isSingleFrame);
-            if (sequence->animationDirection() == QQuick3DParticleSpriteSequence::Normal) {
-                animationFrame = fmodf(startFrame + particleTimeS / d->animationTime, 1.0f);
-            } else if (sequence->animationDirection() == QQuick3DParticleSpriteSequence::Reverse) {
-                animationFrame = fmodf(startFrame + 0.9999f - fmodf(particleTimeS / d->animationTime, 1.0f), 1.0f);
-            } else if (sequence->animationDirection() == QQuick3DParticleSpriteSequence::Alternate) {
-                animationFrame = startFrame + particleTimeS / d->animationTime;
-                animationFrame = fabsf(fmodf(1.0f + animationFrame, 2.0f) - 1.0f);
-            } else if (sequence->animationDirection() == QQuick3DParticleSpriteSequence::AlternateReverse) {
-                animationFrame = fmodf(startFrame + 0.9999f, 1.0f) - particleTimeS / d->animationTime;
-                animationFrame = fabsf(fmodf(fabsf(1.0f + animationFrame), 2.0f) - 1.0f);
-            } else {
-                // SingleFrame
-                animationFrame = startFrame;
-            }
-            animationFrame = std::clamp(animationFrame, 0.0f, 0.9999f);
-        }
+        const float timeChange = processSpriteParticleData(currentData, &animationFrame, spriteParticle, d, particleTimeS);
 
         // Affectors
         for (auto affector : qAsConst(m_affectors)) {
@@ -845,10 +891,55 @@ void QQuick3DParticleSystem::processSpriteParticle(QQuick3DParticleSpriteParticl
     spriteParticle->commitParticles();
 }
 
-void QQuick3DParticleSystem::processParticleCommon(QQuick3DParticleDataCurrent &currentData, const QQuick3DParticleData *d, float particleTimeS)
+// Particle data before the affectors, returns the particle lifetime progress
+float QQuick3DParticleSystem::processSpriteParticleData(QQuick3DParticleDataCurrent &currentData, float *animationFrame, const QQuick3DParticleSpriteParticle *spriteParticle, const QQuick3DParticleData *d, float particleTimeS)
 {
-    m_particlesUsed++;
+    // Process features shared for both model & sprite particles
+    processParticleCommon(currentData, d, particleTimeS);
+
+    // Add a base rotation if alignment requested
+    if (!spriteParticle->m_billboard && spriteParticle->m_alignMode != QQuick3DParticle::AlignNone)
+        processParticleAlignment(currentData, spriteParticle, d);
+
+    // 0.0 -> 1.0 during the particle lifetime
+    const float timeChange = std::max(0.0f, std::min(1.0f, particleTimeS / d->lifetime));
+
+    // Scale from initial to endScale
+    const float scale = d->endSize * timeChange + d->startSize * (1.0f - timeChange);
+    currentData.scale = QVector3D(scale, scale, scale);
+
+    // Fade in & out
+    const float particleTimeLeftS = d->lifetime - particleTimeS;
+    processParticleFadeInOut(currentData, spriteParticle, particleTimeS, particleTimeLeftS);
+
+    if (auto sequence = spriteParticle->m_spriteSequence) {
+        // animationFrame range is [0..1) where 0.0 is the beginning of the first frame
+        // and 0.9999 is the end of the last frame.
+        const bool isSingleFrame = (sequence->animationDirection() == QQuick3DParticleSpriteSequence::SingleFrame);
+        float startFrame = sequence->firstFrame(d->index, isSingleFrame);
+        float frame = 0.0f;
+        if (sequence->animationDirection() == QQuick3DParticleSpriteSequence::Normal) {
+            frame = fmodf(startFrame + particleTimeS / d->animationTime, 1.0f);
+        } else if (sequence->animationDirection() == QQuick3DParticleSpriteSequence::Reverse) {
+            frame = fmodf(startFrame + 0.9999f - fmodf(particleTimeS / d->animationTime, 1.0f), 1.0f);
+        } else if (sequence->animationDirection() == QQuick3DParticleSpriteSequence::Alternate) {
+            frame = startFrame + particleTimeS / d->animationTime;
+            frame = fabsf(fmodf(1.0f + frame, 2.0f) - 1.0f);
+        } else if (sequence->animationDirection() == QQuick3DParticleSpriteSequence::AlternateReverse) {
+            frame = fmodf(startFrame + 0.9999f, 1.0f) - particleTimeS / d->animationTime;
+            frame = fabsf(fmodf(fabsf(1.0f + frame), 2.0f) - 1.0f);
+        } else {
+            // SingleFrame
+            frame = startFrame;
+        }
+        *animationFrame = std::clamp(frame, 0.0f, 0.9999f);
+    }
+
+    return timeChange;
+}
 
+void QQuick3DParticleSystem::processParticleCommon(QQuick3DParticleDataCurrent &currentData, const QQuick3DParticleData *d, float particleTimeS)
+{
     currentData.position = d->startPosition;
 
     // Initial color from start color
@@ -898,12 +989,148 @@ void QQuick3DParticleSystem::processParticleAlignment(QQuick3DParticleDataCurren
     }
 }
 
+// Checks whether the sprite particles can be simulated by the renderer with
+// the built-in simulation, see QSSGParticleSimulation, and collects the
+// affector parameters for it. The particles are then only emitted here.
+bool QQuick3DParticleSystem::prepareSpriteSimulation(QQuick3DParticleSpriteParticle *spriteParticle, float timeS)
+{
+    spriteParticle->m_simulated = false;
+    if (!QSSGParticleSimulation::isRequested())
+        return false;
+
+    // Features which the simulation does not support
+    if (spriteParticle->m_spriteSequence)
+        return false;
+    if (!spriteParticle->m_billboard && spriteParticle->m_alignMode != QQuick3DParticle::AlignNone)
+        return false;
+    const auto smode = spriteParticle->sortMode();
+    if (smode == QQuick3DParticle::SortNewest || smode == QQuick3DParticle::SortOldest)
+        return false;
+    for (auto emitter : qAsConst(m_trailEmitters)) {
+        if (emitter->follow() == spriteParticle)
+            return false;
+    }
+
+    auto &affectors = spriteParticle->m_simulationAffectors;
+    affectors.clear();
+    for (auto affector : qAsConst(m_affectors)) {
+        if (!affector->m_enabled || !(affector->m_particles.isEmpty() || affector->m_particles.contains(spriteParticle)))
+            continue;
+        QSSGParticleAffectorData data;
+        if (affectors.size() == QSSGParticleSimulation::MaxAffectors || !affector->fillSimulationData(&data))
+            return false;
+        affectors.append(data);
+    }
+
+    for (const QQuick3DParticleData &d : qAsConst(spriteParticle->m_particleData)) {
+        if (timeS >= d.startTime && timeS <= d.startTime + d.lifetime)
+            m_particlesUsed++;
+    }
+    spriteParticle->m_simulationTime = timeS;
+    spriteParticle->m_simulated = true;
+    return true;
+}
+
+// Splits the particles into ranges and calls process for each of them with an
+// empty batch. With enough particles, and when all the affectors allow it, the
+// ranges are processed concurrently in the global thread pool. Returns the
+// amount of ranges, their batches are in m_particleBatches in particle order.
+int QQuick3DParticleSystem::processBatches(QQuick3DParticle *particle, int count, const std::function<void (QQuick3DParticleDataBatch &, int, int)> &process)
+{
+    static constexpr int minRangeSize = 2048;
+    static constexpr int maxRanges = 64;
+    QThreadPool *threadPool = QThreadPool::globalInstance();
+    const bool threaded = count >= 2 * minRangeSize && threadPool->maxThreadCount() > 1
+            && canProcessConcurrently(particle);
+    const int rangeSize = threaded ? std::max(minRangeSize, (count + maxRanges - 1) / maxRanges) : std::max(count, 1);
+    const int rangeCount = (count + rangeSize - 1) / rangeSize;
+    if (m_particleBatches.size() < rangeCount)
+        m_particleBatches.resize(rangeCount);
+    QQuick3DParticleDataBatch *batches = m_particleBatches.data();
+
+    const auto processRange = [&](int range) {
+        const int begin = range * rangeSize;
+        const int end = std::min(count, begin + rangeSize);
+        batches[range].reset(end - begin);
+        process(batches[range], begin, end);
+    };
+
+    if (!threaded) {
+        for (int range = 0; range < rangeCount; range++)
+            processRange(range);
+    } else {
+        // Ranges are handed out to the calling thread and to the pool
+        // threads that happen to be idle.
+        QAtomicInt nextRange;
+        const auto processRanges = [&]() {
+            for (int range = nextRange.fetchAndAddRelaxed(1); range < rangeCount; range = nextRange.fetchAndAddRelaxed(1))
+                processRange(range);
+        };
+        QSemaphore helpersDone;
+        int helperCount = 0;
+        const int maxHelpers = std::min(rangeCount, threadPool->maxThreadCount()) - 1;
+        while (helperCount < maxHelpers && threadPool->tryStart([&processRanges, &helpersDone]() {
+                   processRanges();
+                   helpersDone.release();
+               })) {
+            ++helperCount;
+        }
+        processRanges();
+        helpersDone.acquire(helperCount);
+    }
+
+    for (int range = 0; range < rangeCount; range++)
+        m_particlesUsed += batches[range].count;
+    return rangeCount;
+}
+
+bool QQuick3DParticleSystem::canProcessConcurrently(QQuick3DParticle *particle) const
+{
+    if (isThreadingDisabled())
+        return false;
+    // The align target is a scene position, which is not safe to query from
+    // the worker threads.
+    if (particle->m_alignMode == QQuick3DParticle::AlignTowardsTarget)
+        return false;
+    for (auto affector : qAsConst(m_affectors)) {
+        if (affector->m_enabled && (affector->m_particles.isEmpty() || affector->m_particles.contains(particle))
+                && !affector->canAffectConcurrently())
+            return false;
+    }
+    return true;
+}
+
+void QQuick3DParticleSystem::affectParticles(QQuick3DParticle *particle, QQuick3DParticleDataBatch &batch)
+{
+    if (batch.count == 0)
+        return;
+    for (auto affector : qAsConst(m_affectors)) {
+        // If affector is set to affect only particular particles, check these are included
+        if (affector->m_enabled && (affector->m_particles.isEmpty() || affector->m_particles.contains(particle)))
+            affector->affectParticles(batch);
+    }
+}
+
 bool QQuick3DParticleSystem::isGloballyDisabled()
 {
     static const bool disabled = qEnvironmentVariableIntValue("QT_QUICK3D_DISABLE_PARTICLE_SYSTEMS");
     return disabled;
 }
 
+// Runs the affectors one particle at a time, like with trails. Mostly useful
+// for comparing results and performance with the batched version.
+bool QQuick3DParticleSystem::isBatchingDisabled()
+{
+    static const bool disabled = qEnvironmentVariableIntValue("QT_QUICK3D_DISABLE_PARTICLE_BATCHING");
+    return disabled;
+}
+
+bool QQuick3DParticleSystem::isThreadingDisabled()
+{
+    static const bool disabled = qEnvironmentVariableIntValue("QT_QUICK3D_DISABLE_PARTICLE_THREADS");
+    return disabled;
+}
+
 bool QQuick3DParticleSystem::isEditorModeOn()
 {
     static const bool editorMode = qEnvironmentVariableIntValue("QT_QUICK3D_EDITOR_PARTICLE_SYSTEMS");
@@ -58,6 +58,7 @@
 #include <QtQml/qqml.h>
 #include <QElapsedTimer>
 #include <QTimer>
+#include <functional>
 
 QT_BEGIN_NAMESPACE
 
@@ -162,7 +163,15 @@ private:
     void processParticleCommon(QQuick3DParticleDataCurrent &currentData, const QQuick3DParticleData *d, float particleTimeS);
     void processParticleFadeInOut(QQuick3DParticleDataCurrent &currentData, const QQuick3DParticle *particle, float particleTimeS, float particleTimeLeftS);
     void processParticleAlignment(QQuick3DParticleDataCurrent &currentData, const QQuick3DParticle *particle, const QQuick3DParticleData *d);
+    float processModelParticleData(QQuick3DParticleDataCurrent &currentData, const QQuick3DParticleModelParticle *modelParticle, const QQuick3DParticleData *d, float particleTimeS);
+    float processSpriteParticleData(QQuick3DParticleDataCurrent &currentData, float *animationFrame, const QQuick3DParticleSpriteParticle *spriteParticle, const QQuick3DParticleData *d, float particleTimeS);
+    int processBatches(QQuick3DParticle *particle, int count, const std::function<void (QQuick3DParticleDataBatch &, int, int)> &process);
+    bool canProcessConcurrently(QQuick3DParticle *particle) const;
+    void affectParticles(QQuick3DParticle *particle, QQuick3DParticleDataBatch &batch);
+    bool prepareSpriteSimulation(QQuick3DParticleSpriteParticle *spriteParticle, float timeS);
     static bool isGloballyDisabled();
+    static bool isBatchingDisabled();
+    static bool isThreadingDisabled();
     static bool isEditorModeOn();
 
 private:
@@ -208,6 +217,9 @@ private:
     QQuick3DParticleSystemLogging *m_loggingData = nullptr;
     QPRand m_rand;
     int m_particleIdIndex = 0;
+    // Living particles of the currently processed logical particle, one batch
+    // per particle range when the affectors are run over all of them at once
+    QVector<QQuick3DParticleDataBatch> m_particleBatches;
 };
 
 class QQuick3DParticleSystemAnimation : public QAbstractAnimation
@@ -31,6 +31,8 @@
 #include "qquick3dparticlewander_p.h"
 #include "qquick3dparticlerandomizer_p.h"
 #include "qquick3dparticleutils_p.h"
+#include "qquick3dparticlesimd_p.h"
+#include <QtQuick3DRuntimeRender/private/qssgrenderparticles_p.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -337,4 +339,109 @@ void QQuick3DParticleWander::affectParticle(const QQuick3DParticleData &sd, QQui
     }
 }
 
+void QQuick3DParticleWander::affectParticles(QQuick3DParticleDataBatch &batch)
+{
+    if (!system())
+        return;
+    auto rand = system()->rand();
+    const float *times = batch.times.constData();
+    float *positions[3] = { batch.positionX.data(), batch.positionY.data(), batch.positionZ.data() };
+    float *smooth = batch.scratch(0);
+    float *lifetimes = batch.scratch(1);
+    float *paceVariations = batch.scratch(2);
+    float *amountVariations = batch.scratch(3);
+    float *startPaces = batch.scratch(4);
+    const QPFloat4 one = QPFloat4::splat(1.0f);
+    const float pi2 = float(M_PI * 2);
+    const QPFloat4 pi2v = QPFloat4::splat(pi2);
+
+    // Optionally smoothen the beginning & end of wander
+    if (m_fadeOutDuration > 0) {
+        for (int i = 0; i < batch.count; ++i)
+            lifetimes[i] = batch.data.at(i)->lifetime;
+        for (int i = batch.count; i < batch.paddedCount; ++i)
+            lifetimes[i] = 0.0f;
+    }
+    const QPFloat4 fadeIn = QPFloat4::splat(float(m_fadeInDuration) / 1000.0f);
+    const QPFloat4 fadeOut = QPFloat4::splat(float(m_fadeOutDuration) / 1000.0f);
+    for (int i = 0; i < batch.paddedCount; i += QQuick3DParticleDataBatch::Lanes) {
+        const QPFloat4 time = QPFloat4::load(times + i);
+        QPFloat4 s = one;
+        if (m_fadeInDuration > 0)
+            s = qpMin(one, time / fadeIn);
+        if (m_fadeOutDuration > 0)
+            s = qpMin((QPFloat4::load(lifetimes + i) - time) / fadeOut, s);
+        s.store(smooth + i);
+    }
+
+    // Global
+    for (int axis = 0; axis < 3; ++axis) {
+        if (qFuzzyIsNull(m_globalAmount[axis]) || qFuzzyIsNull(m_globalPace[axis]))
+            continue;
+        const QPFloat4 paceStart = QPFloat4::splat(m_globalPaceStart[axis]);
+        const QPFloat4 pace = QPFloat4::splat(m_globalPace[axis]);
+        const QPFloat4 amount = QPFloat4::splat(m_globalAmount[axis]);
+        float *pos = positions[axis];
+        for (int i = 0; i < batch.paddedCount; i += QQuick3DParticleDataBatch::Lanes) {
+            const QPFloat4 time = QPFloat4::load(times + i);
+            const QPFloat4 wander = QPFloat4::load(smooth + i) * qpSin(paceStart + time * pi2v * pace) * amount;
+            (QPFloat4::load(pos + i) + wander).store(pos + i);
+        }
+    }
+
+    // Unique
+    static const QPRand::UserType paceVariationUsers[3] = { QPRand::WanderXPV, QPRand::WanderYPV, QPRand::WanderZPV };
+    static const QPRand::UserType amountVariationUsers[3] = { QPRand::WanderXAV, QPRand::WanderYAV, QPRand::WanderZAV };
+    static const QPRand::UserType paceStartUsers[3] = { QPRand::WanderXPS, QPRand::WanderYPS, QPRand::WanderZPS };
+    for (int axis = 0; axis < 3; ++axis) {
+        if (qFuzzyIsNull(m_uniqueAmount[axis]) || qFuzzyIsNull(m_uniquePace[axis]))
+            continue;
+        for (int i = 0; i < batch.count; ++i) {
+            const int index = batch.data.at(i)->index;
+            // Values between  1.0 +/- variation
+            paceVariations[i] = 1.0f + m_uniquePaceVariation - 2.0f * rand->get(index, paceVariationUsers[axis]) * m_uniquePaceVariation;
+            amountVariations[i] = 1.0f + m_uniqueAmountVariation - 2.0f * rand->get(index, amountVariationUsers[axis]) * m_uniqueAmountVariation;
+            startPaces[i] = rand->get(index, paceStartUsers[axis]) * pi2;
+        }
+        for (int i = batch.count; i < batch.paddedCount; ++i)
+            paceVariations[i] = amountVariations[i] = startPaces[i] = 0.0f;
+
+        const QPFloat4 uniquePace = QPFloat4::splat(m_uniquePace[axis]);
+        const QPFloat4 uniqueAmount = QPFloat4::splat(m_uniqueAmount[axis]);
+        float *pos = positions[axis];
+        for (int i = 0; i < batch.paddedCount; i += QQuick3DParticleDataBatch::Lanes) {
+            const QPFloat4 time = QPFloat4::load(times + i);
+            const QPFloat4 pace = QPFloat4::load(startPaces + i) + QPFloat4::load(paceVariations + i) * time * pi2v * uniquePace;
+            const QPFloat4 amount = QPFloat4::load(amountVariations + i) * uniqueAmount;
+            (QPFloat4::load(pos + i) + QPFloat4::load(smooth + i) * qpSin(pace) * amount).store(pos + i);
+        }
+    }
+}
+
+bool QQuick3DParticleWander::canAffectConcurrently() const
+{
+    return true;
+}
+
+bool QQuick3DParticleWander::fillSimulationData(QSSGParticleAffectorData *data) const
+{
+    // Directions which affectParticle() skips have zero amount
+    QVector3D globalAmount;
+    QVector3D uniqueAmount;
+    for (int axis = 0; axis < 3; ++axis) {
+        if (!qFuzzyIsNull(m_globalAmount[axis]) && !qFuzzyIsNull(m_globalPace[axis]))
+            globalAmount[axis] = m_globalAmount[axis];
+        if (!qFuzzyIsNull(m_uniqueAmount[axis]) && !qFuzzyIsNull(m_uniquePace[axis]))
+            uniqueAmount[axis] = m_uniqueAmount[axis];
+    }
+
+    data->type = QSSGParticleAffectorData::Type::Wander;
+    data->params[0] = QVector4D(globalAmount, m_uniquePaceVariation);
+    data->params[1] = QVector4D(m_globalPace, m_uniqueAmountVariation);
+    data->params[2] = QVector4D(m_globalPaceStart, m_fadeInDuration / 1000.0f);
+    data->params[3] = QVector4D(uniqueAmount, m_fadeOutDuration / 1000.0f);
+    data->params[4] = QVector4D(m_uniquePace, 0.0f);
+    return true;
+}
+
 QT_END_NAMESPACE
@@ -0,0 +1,69 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Quick 3D.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSSG_PARTICLE_SIMULATION_H
+#define QSSG_PARTICLE_SIMULATION_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+// Constants shared by QSSGParticleSimulation and the particle compute shaders.
+// Included from GLSL too, so only preprocessor definitions go here.
+
+#define QSSG_PARTICLE_WORKGROUP_SIZE 256
+#define QSSG_PARTICLE_MAX_AFFECTORS 8
+
+// QSSGParticleAffectorData::Type and Flag
+#define QSSG_PARTICLE_AFFECTOR_GRAVITY 0u
+#define QSSG_PARTICLE_AFFECTOR_ATTRACTOR 1u
+#define QSSG_PARTICLE_AFFECTOR_WANDER 2u
+#define QSSG_PARTICLE_AFFECTOR_POINTROTATOR 3u
+#define QSSG_PARTICLE_AFFECTOR_HIDE_AT_END 1u
+
+// QSSGParticleSimulation::FadeEffect
+#define QSSG_PARTICLE_FADE_NONE 0u
+#define QSSG_PARTICLE_FADE_OPACITY 1u
+#define QSSG_PARTICLE_FADE_SCALE 2u
+
+// QPRand::UserType values of the particle system random table
+#define QSSG_PARTICLE_RANDOM_WANDER_XPS 1u
+#define QSSG_PARTICLE_RANDOM_WANDER_XPV 4u
+#define QSSG_PARTICLE_RANDOM_WANDER_XAV 7u
+#define QSSG_PARTICLE_RANDOM_ATTRACTOR_DURATIONV 10u
+#define QSSG_PARTICLE_RANDOM_ATTRACTOR_POSVX 11u
+
+#endif // QSSG_PARTICLE_SIMULATION_H
@@ -127,6 +127,15 @@ void QSSGRenderGeometry::addSubset(quint32 offset, quint32 count, const QVector3
     m_meshData.m_subsets.append({name, {boundsMin, boundsMax}, count, offset, {}});
 }
 
+void QSSGRenderGeometry::setSubsetBounds(int idx, const QVector3D &boundsMin, const QVector3D &boundsMax)
+{
+    QSSGMesh::Mesh::SubsetBounds &bounds = m_meshData.m_subsets[idx].bounds;
+    if (bounds.min == boundsMin && bounds.max == boundsMax)
+        return;
+    bounds = { boundsMin, boundsMax };
+    m_generationId++;
+}
+
 void QSSGRenderGeometry::setStride(int stride)
 {
     m_meshData.m_stride = stride;
@@ -141,8 +150,9 @@ void QSSGRenderGeometry::setPrimitiveType(QSSGMesh::Mesh::DrawMode type)
 
 void QSSGRenderGeometry::setBounds(const QVector3D &min, const QVector3D &max)
 {
+    // The bounds are not part of the buffers, changing them alone does not
+    // need new ones.
     m_bounds = QSSGBounds3(min, max);
-    markDirty();
 }
 
 void QSSGRenderGeometry::clear()
@@ -179,7 +189,75 @@ void QSSGRenderGeometry::setIndexData(const QByteArray &data)
     markDirty();
 }
 
+void QSSGRenderGeometry::updateVertexData(const QByteArray &data, quint32 offset, quint32 size)
+{
+    if (data.size() != m_meshData.m_vertexBuffer.size()) {
+        setVertexData(data);
+        return;
+    }
+    m_meshData.m_vertexBuffer = data;
+    addDirtyRange(false, offset, size);
+}
+
+void QSSGRenderGeometry::updateIndexData(const QByteArray &data, quint32 offset, quint32 size)
+{
+    if (data.size() != m_meshData.m_indexBuffer.size()) {
+        setIndexData(data);
+        return;
+    }
+    m_meshData.m_indexBuffer = data;
+    addDirtyRange(true, offset, size);
+}
+
+bool QSSGRenderGeometry::isDynamic() const
+{
+    return m_dynamic;
+}
+
+void QSSGRenderGeometry::setDynamic(bool dynamic)
+{
+    if (m_dynamic == dynamic)
+        return;
+    m_dynamic = dynamic;
+    markDirty();
+}
+
 void QSSGRenderGeometry::markDirty()
 {
     m_generationId++;
+    m_dirtyRangesBaseGenerationId = m_generationId;
+    m_dirtyRanges.clear();
+}
+
+void QSSGRenderGeometry::addDirtyRange(bool indexData, quint32 offset, quint32 size)
+{
+    // The ranges are kept until the next full change since there may be
+    // several buffer managers behind with their own buffers. To keep the list
+    // short, it is collapsed into one range per buffer when it grows too long.
+    static const int MAX_DIRTY_RANGES = 64;
+
+    m_generationId++;
+    if (m_dirtyRanges.count() >= MAX_DIRTY_RANGES) {
+        DirtyRange merged[2];
+        bool used[2] = { false, false };
+        for (const DirtyRange &range : qAsConst(m_dirtyRanges)) {
+            const int i = range.indexData ? 1 : 0;
+            if (!used[i]) {
+                merged[i] = range;
+                used[i] = true;
+            } else {
+                const quint32 start = qMin(merged[i].offset, range.offset);
+                const quint32 end = qMax(merged[i].offset + merged[i].size, range.offset + range.size);
+                merged[i].offset = start;
+                merged[i].size = end - start;
+            }
+            merged[i].generationId = m_generationId;
+        }
+        m_dirtyRanges.clear();
+        for (int i = 0; i < 2; ++i) {
+            if (used[i])
+                m_dirtyRanges.append(merged[i]);
+        }
+    }
+    m_dirtyRanges.append({ m_generationId, offset, size, indexData });
 }
@@ -60,6 +60,15 @@ public:
         QSSGMesh::Mesh::ComponentType componentType = QSSGMesh::Mesh::ComponentType::Float32;
     };
 
+    // A byte range of the vertex or index data that changed in generation
+    // generationId, without the layout or the size of the data changing.
+    struct DirtyRange {
+        uint32_t generationId = 0;
+        quint32 offset = 0;
+        quint32 size = 0;
+        bool indexData = false;
+    };
+
     explicit QSSGRenderGeometry();
     virtual ~QSSGRenderGeometry();
 
@@ -76,6 +85,11 @@ public:
 
     void setVertexData(const QByteArray &data);
     void setIndexData(const QByteArray &data);
+    // Replace the data like setVertexData() and setIndexData(), but when the
+    // size of the data is unchanged, only the given range is recorded as
+    // changed so that the existing buffers can be updated in place.
+    void updateVertexData(const QByteArray &data, quint32 offset, quint32 size);
+    void updateIndexData(const QByteArray &data, quint32 offset, quint32 size);
     void setStride(int stride);
     void setBounds(const QVector3D &min, const QVector3D &max);
     void setPrimitiveType(QSSGMesh::Mesh::DrawMode type);
@@ -85,19 +99,34 @@ public:
                       QSSGMesh::Mesh::ComponentType componentType);
     void addAttribute(const Attribute &att);
     void addSubset(quint32 offset, quint32 count, const QVector3D &boundsMin, const QVector3D &boundsMax, const QString &name = {});
+    // Like a partial update of the data, this keeps the existing buffers
+    void setSubsetBounds(int idx, const QVector3D &boundsMin, const QVector3D &boundsMax);
 
     void clear();
     void clearAttributes();
 
+    bool isDynamic() const;
+    void setDynamic(bool dynamic);
+
     uint32_t generationId() const;
     const QSSGMesh::RuntimeMeshData &meshData() const;
 
+    // All changes made after generation dirtyRangesBaseGenerationId() are
+    // listed in dirtyRanges(). Buffers created from an earlier generation
+    // must be recreated.
+    uint32_t dirtyRangesBaseGenerationId() const { return m_dirtyRangesBaseGenerationId; }
+    const QVector<DirtyRange> &dirtyRanges() const { return m_dirtyRanges; }
+
 protected:
     Q_DISABLE_COPY(QSSGRenderGeometry)
 
     void markDirty();
+    void addDirtyRange(bool indexData, quint32 offset, quint32 size);
 
     uint32_t m_generationId = 1;
+    uint32_t m_dirtyRangesBaseGenerationId = 1;
+    QVector<DirtyRange> m_dirtyRanges;
+    bool m_dynamic = false;
     QSSGMesh::RuntimeMeshData m_meshData;
     QSSGBounds3 m_bounds;
 };
@@ -102,11 +102,16 @@ struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGRenderImage : public QSSGRenderGraphObj
     QSSGRenderTextureFilterOp m_mipFilterType = QSSGRenderTextureFilterOp::Linear;
     QSSGRenderTextureFormat m_format = QSSGRenderTextureFormat::Unknown;
     bool m_generateMipmaps = false;
+    bool m_asyncLoad = false;
 
     // Changing any of the above variables is covered by the Dirty flag, while
     // the texture transform is covered by TransformDirty.
     QMatrix4x4 m_textureTransform;
 
+    // Set when the source changes, cleared when preparing a frame in which
+    // the image is no longer loading, so that the result is reported once.
+    bool m_loadStatusPending = false;
+
     QSSGRenderImage(QSSGRenderGraphObject::Type type = QSSGRenderGraphObject::Type::Image2D);
     ~QSSGRenderImage();
 
@@ -50,6 +50,9 @@ QSSGRenderLight::QSSGRenderLight(QSSGRenderGraphObject::Type type)
     , m_shadowMapRes(9)
     , m_shadowMapFar(5000.0f)
     , m_shadowFilter(35.0f)
+    , m_cascadeCount(1)
+    , m_cascadeSplitBlend(0.75f)
+    , m_cascadeResolutionScale(1.0f)
 {
     Q_ASSERT(QSSGRenderGraphObject::isLight(type));
 }
@@ -72,6 +72,11 @@ struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGRenderLight : public QSSGRenderNode
     float m_shadowMapFar; // Far clip plane for the shadow map
     float m_shadowFilter; // Shadow map filter step size
 
+    // Only valid if node is a directional light
+    quint32 m_cascadeCount; // 1-4, the view frustum is split into this many shadow maps
+    float m_cascadeSplitBlend; // 0 for uniform, 1 for logarithmic splits
+    float m_cascadeResolutionScale; // size of each cascade's map relative to the previous one
+
     // Defaults to directional light
     explicit QSSGRenderLight(Type type = Type::DirectionalLight);
 };
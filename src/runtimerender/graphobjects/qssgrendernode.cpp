@@ -71,66 +71,71 @@ bool QSSGRenderNode::calculateGlobalVariables()
     if (retval) {
         flags.setFlag(Flag::Dirty, false);
         calculateLocalTransform();
-        globalOpacity = localOpacity;
         if (parent) {
             // Layer transforms do not flow down but affect the final layer's rendered
             // representation.
             retval = parent->calculateGlobalVariables() || retval;
-            if (parent->type != QSSGRenderGraphObject::Type::Layer) {
-                globalOpacity *= parent->globalOpacity;
-                if (!flags.testFlag(Flag::IgnoreParentTransform))
-                    globalTransform = parent->globalTransform * localTransform;
-                else
-                    globalTransform = localTransform;
-            } else {
+            if (parent->type != QSSGRenderGraphObject::Type::Layer && !flags.testFlag(Flag::IgnoreParentTransform))
+                globalTransform = parent->globalTransform * localTransform;
+            else
                 globalTransform = localTransform;
-            }
-            if (this == instanceRoot) {
-                globalInstanceTransform = parent->globalTransform;
-                localInstanceTransform = localTransform;
-            } else if (instanceRoot) {
-                globalInstanceTransform = instanceRoot->globalInstanceTransform;
-                //### technically O(n^2) -- we could cache localInstanceTransform if every node in the
-                // tree is guaranteed to have the same instance root. That would require an API change.
-                localInstanceTransform = localTransform;
-                auto *p = parent;
-                while (p) {
-                    if (p == instanceRoot) {
-                        localInstanceTransform = p->localInstanceTransform * localInstanceTransform;
-                        break;
-                    }
-                    localInstanceTransform = p->localTransform * localInstanceTransform;
-                    p = p->parent;
-                }
-            } else {
-                // By default, we do magic: translation is applied to the global instance transform,
-                // while scale/rotation is local
-
-                localInstanceTransform = localTransform;
-                auto &localInstanceMatrix =  *reinterpret_cast<float (*)[4][4]>(localInstanceTransform.data());
-                QVector3D localPos{localInstanceMatrix[3][0], localInstanceMatrix[3][1], localInstanceMatrix[3][2]};
-                localInstanceMatrix[3][0] = 0;
-                localInstanceMatrix[3][1] = 0;
-                localInstanceMatrix[3][2] = 0;
-                globalInstanceTransform = parent->globalTransform;
-                globalInstanceTransform.translate(localPos);
-            }
-
-            flags.setFlag(Flag::GloballyActive, (flags.testFlag(Flag::Active) && parent->flags.testFlag(Flag::GloballyActive)));
-            flags.setFlag(Flag::GloballyPickable, (flags.testFlag(Flag::LocallyPickable) || parent->flags.testFlag(Flag::GloballyPickable)));
         } else {
             globalTransform = localTransform;
-            flags.setFlag(Flag::GloballyActive, flags.testFlag(Flag::Active));
-            flags.setFlag(Flag::GloballyPickable, flags.testFlag(Flag::LocallyPickable));
-            localInstanceTransform = localTransform;
-            globalInstanceTransform = {};
         }
+        calculateInheritedVariables();
     }
     // We always clear dirty in a reasonable manner but if we aren't active
     // there is no reason to tell the universe if we are dirty or not.
     return retval && flags.testFlag(Flag::Active);
 }
 
+void QSSGRenderNode::calculateInheritedVariables()
+{
+    globalOpacity = localOpacity;
+    if (parent) {
+        if (parent->type != QSSGRenderGraphObject::Type::Layer)
+            globalOpacity *= parent->globalOpacity;
+        if (this == instanceRoot) {
+            globalInstanceTransform = parent->globalTransform;
+            localInstanceTransform = localTransform;
+        } else if (instanceRoot) {
+            globalInstanceTransform = instanceRoot->globalInstanceTransform;
+            //### technically O(n^2) -- we could cache localInstanceTransform if every node in the
+            // tree is guaranteed to have the same instance root. That would require an API change.
+            localInstanceTransform = localTransform;
+            auto *p = parent;
+            while (p) {
+                if (p == instanceRoot) {
+                    localInstanceTransform = p->localInstanceTransform * localInstanceTransform;
+                    break;
+                }
+                localInstanceTransform = p->localTransform * localInstanceTransform;
+                p = p->parent;
+            }
+        } else {
+            // By default, we do magic: translation is applied to the global instance transform,
+            // while scale/rotation is local
+
+            localInstanceTransform = localTransform;
+            auto &localInstanceMatrix =  *reinterpret_cast<float (*)[4][4]>(localInstanceTransform.data());
+            QVector3D localPos{localInstanceMatrix[3][0], localInstanceMatrix[3][1], localInstanceMatrix[3][2]};
+            localInstanceMatrix[3][0] = 0;
+            localInstanceMatrix[3][1] = 0;
+            localInstanceMatrix[3][2] = 0;
+            globalInstanceTransform = parent->globalTransform;
+            globalInstanceTransform.translate(localPos);
+        }
+
+        flags.setFlag(Flag::GloballyActive, (flags.testFlag(Flag::Active) && parent->flags.testFlag(Flag::GloballyActive)));
+        flags.setFlag(Flag::GloballyPickable, (flags.testFlag(Flag::LocallyPickable) || parent->flags.testFlag(Flag::GloballyPickable)));
+    } else {
+        flags.setFlag(Flag::GloballyActive, flags.testFlag(Flag::Active));
+        flags.setFlag(Flag::GloballyPickable, flags.testFlag(Flag::LocallyPickable));
+        localInstanceTransform = localTransform;
+        globalInstanceTransform = {};
+    }
+}
+
 void QSSGRenderNode::calculateRotationMatrix(QMatrix4x4 &outMatrix) const
 {
     outMatrix = QMatrix4x4(rotation.toRotationMatrix());
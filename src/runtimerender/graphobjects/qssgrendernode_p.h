@@ -147,6 +147,12 @@ struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGRenderNode : public QSSGRenderGraphObje
     // valid global transforms.
     bool calculateGlobalVariables();
 
+    // The non-recursive part of calculateGlobalVariables(): derives the
+    // global opacity, the instancing transforms and the globally
+    // active/pickable flags from the parent, which must be up to date.
+    // globalTransform is expected to be calculated already.
+    void calculateInheritedVariables();
+
     // Given our rotation order and handedness, calculate the final rotation matrix
     // Only the upper 3x3 of this matrix is filled in.
     // If this object is left handed, then you need to call FlipCoordinateSystem
@@ -28,6 +28,9 @@
 ****************************************************************************/
 
 #include <QtQuick3DRuntimeRender/private/qssgrenderparticles_p.h>
+#include <QtQuick3DUtils/private/qssgutils_p.h>
+#include <QtCore/qatomic.h>
+#include <QtCore/qmath.h>
 #include <cmath>
 
 QT_BEGIN_NAMESPACE
@@ -44,13 +47,24 @@ static int ceilDivide(int a, int b)
 }
 
 void QSSGParticleBuffer::resize(int particleCount, int particleSize)
+{
+    updateLayout(particleCount, particleSize);
+    m_particleBuffer.resize(m_sliceStride * m_size.height());
+}
+
+void QSSGParticleBuffer::resizeLayout(int particleCount, int particleSize)
+{
+    updateLayout(particleCount, particleSize);
+    m_particleBuffer.clear();
+}
+
+void QSSGParticleBuffer::updateLayout(int particleCount, int particleSize)
 {
     if (particleCount == 0) {
         m_particlesPerSlice = 0;
         m_particleCount = 0;
         m_sliceStride = 0;
         m_size = QSize();
-        m_particleBuffer.resize(0);
         return;
     }
     int vec4PerParticle = ceilDivide(particleSize, 16);
@@ -63,7 +77,6 @@ void QSSGParticleBuffer::resize(int particleCount, int particleSize)
     height = divisibleBy(height, 4);
     m_sliceStride = width * 16;
     m_size = QSize(width, height);
-    m_particleBuffer.resize(m_sliceStride * height);
 }
 
 void QSSGParticleBuffer::setBounds(const QSSGBounds3& bounds)
@@ -127,6 +140,201 @@ QSSGBounds3 QSSGParticleBuffer::bounds() const
     return m_bounds;
 }
 
+void QSSGParticleSimulation::markDirty(int slot)
+{
+    const int updateSerial = serial + 1;
+    if (dirtyRangesBaseSerial == updateSerial)
+        return;
+    if (!dirtyRanges.isEmpty()) {
+        Range &last = dirtyRanges.last();
+        if (last.serial == updateSerial) {
+            if (slot >= last.begin && slot < last.end)
+                return;
+            if (slot == last.end) {
+                last.end++;
+                return;
+            }
+        }
+    }
+    // Emitters fill the slots in order, so there should only be a few ranges
+    // per update. The oldest ones are dropped to keep the history short, the
+    // render contexts which have not uploaded them yet upload everything.
+    if (dirtyRanges.size() >= 64) {
+        dirtyRangesBaseSerial = std::max(dirtyRangesBaseSerial, dirtyRanges.first().serial);
+        dirtyRanges.removeFirst();
+    }
+    dirtyRanges.append({ updateSerial, slot, slot + 1 });
+}
+
+void QSSGParticleSimulation::markAllDirty()
+{
+    dirtyRanges.clear();
+    dirtyRangesBaseSerial = serial + 1;
+}
+
+namespace {
+
+enum RandomUser : quint32
+{
+    WanderXPS = QSSG_PARTICLE_RANDOM_WANDER_XPS,
+    WanderXPV = QSSG_PARTICLE_RANDOM_WANDER_XPV,
+    WanderXAV = QSSG_PARTICLE_RANDOM_WANDER_XAV,
+    AttractorDurationV = QSSG_PARTICLE_RANDOM_ATTRACTOR_DURATIONV,
+    AttractorPosVX = QSSG_PARTICLE_RANDOM_ATTRACTOR_POSVX
+};
+
+struct SimulatedParticle
+{
+    QVector3D position;
+    QVector3D rotation;
+    QVector4D color;
+    float size;
+    float timeChange;
+};
+
+}
+
+// CPU version of particlesimulate.comp, the constants both use are in
+// qssgparticlesimulation_p.h. The lookup table sine is accurate enough for
+// positions and much cheaper than std::sin for every particle and axis.
+static bool simulateParticle(const QSSGParticleSimulation &sim, const QSSGParticleEmitData &e, SimulatedParticle *out)
+{
+    const float t = sim.time - e.startTime;
+    if (e.lifetime < 0.0f || t < 0.0f || t > e.lifetime)
+        return false;
+
+    const int randomCount = sim.randomTable.size();
+    const auto random = [&](quint32 user) {
+        return randomCount ? sim.randomTable.at(int((e.index + user) % quint32(randomCount))) : 0.0f;
+    };
+
+    QVector3D position = e.startPosition + e.startVelocity * t;
+    QVector4D color = e.startColor;
+    const float timeChange = qBound(0.0f, t / e.lifetime, 1.0f);
+    float size = e.endSize * timeChange + e.startSize * (1.0f - timeChange);
+
+    const float timeLeft = e.lifetime - t;
+    if (t < sim.fadeInDuration) {
+        const float fadeIn = t / sim.fadeInDuration;
+        if (sim.fadeInEffect == QSSGParticleSimulation::FadeEffect::Opacity)
+            color.setW(color.w() * fadeIn);
+        else if (sim.fadeInEffect == QSSGParticleSimulation::FadeEffect::Scale)
+            size *= fadeIn;
+    }
+    if (timeLeft < sim.fadeOutDuration) {
+        const float fadeOut = timeLeft / sim.fadeOutDuration;
+        if (sim.fadeOutEffect == QSSGParticleSimulation::FadeEffect::Opacity)
+            color.setW(color.w() * fadeOut);
+        else if (sim.fadeOutEffect == QSSGParticleSimulation::FadeEffect::Scale)
+            size *= fadeOut;
+    }
+
+    const float pi2 = float(M_PI * 2);
+    for (const QSSGParticleAffectorData &affector : sim.affectors) {
+        const QVector4D *p = affector.params;
+        switch (affector.type) {
+        case QSSGParticleAffectorData::Type::Gravity:
+            position += (0.5f * p[0].w() * t * t) * p[0].toVector3D();
+            break;
+        case QSSGParticleAffectorData::Type::Attractor: {
+            float duration = p[4].w() < 0.0f ? e.lifetime : p[4].w();
+            const float durationVariation = p[5].w();
+            if (durationVariation != 0.0f)
+                duration += durationVariation - 2.0f * random(AttractorDurationV) * durationVariation;
+            duration = std::max(duration, 0.001f);
+            const float pEnd = qBound(0.0f, t / duration, 1.0f);
+            if ((affector.flags & QSSGParticleAffectorData::HideAtEnd) && pEnd >= 1.0f) {
+                color.setW(0.0f);
+                break;
+            }
+            QVector3D target = p[4].toVector3D();
+            const QVector3D variation = p[5].toVector3D();
+            for (int axis = 0; axis < 3; ++axis)
+                target[axis] += variation[axis] - 2.0f * random(AttractorPosVX + axis) * variation[axis];
+            const QVector4D mapped = p[0] * target.x() + p[1] * target.y() + p[2] * target.z() + p[3];
+            position = (1.0f - pEnd) * position + pEnd * (mapped.toVector3D() / mapped.w());
+            break;
+        }
+        case QSSGParticleAffectorData::Type::Wander: {
+            float smooth = 1.0f;
+            if (p[2].w() > 0.0f)
+                smooth = std::min(1.0f, t / p[2].w());
+            if (p[3].w() > 0.0f)
+                smooth = std::min(timeLeft / p[3].w(), smooth);
+            const float uniquePaceVariation = p[0].w();
+            const float uniqueAmountVariation = p[1].w();
+            for (int axis = 0; axis < 3; ++axis) {
+                position[axis] += smooth * qLookupSin(p[2][axis] + t * pi2 * p[1][axis]) * p[0][axis];
+                if (p[3][axis] == 0.0f)
+                    continue;
+                const float paceVariation = 1.0f + uniquePaceVariation - 2.0f * random(WanderXPV + axis) * uniquePaceVariation;
+                const float amountVariation = 1.0f + uniqueAmountVariation - 2.0f * random(WanderXAV + axis) * uniqueAmountVariation;
+                const float pace = random(WanderXPS + axis) * pi2 + paceVariation * t * pi2 * p[4][axis];
+                position[axis] += smooth * qLookupSin(pace) * amountVariation * p[3][axis];
+            }
+            break;
+        }
+        case QSSGParticleAffectorData::Type::PointRotator: {
+            const float angle = qDegreesToRadians(t * p[0].w());
+            const QVector3D axis = p[0].toVector3D();
+            const QVector3D pivot = p[1].toVector3D();
+            const QVector3D v = position - pivot;
+            const float c = qLookupCos(angle);
+            const float s = qLookupSin(angle);
+            // Rodrigues' rotation formula
+            position = pivot + v * c + QVector3D::crossProduct(axis, v) * s
+                    + axis * QVector3D::dotProduct(axis, v) * (1.0f - c);
+            break;
+        }
+        }
+    }
+
+    out->position = position + QVector3D(sim.offset * size, 0.0f);
+    out->rotation = qDegreesToRadians(1.0f) * (e.startRotation + e.rotationVelocity * t);
+    out->color = color;
+    out->size = size * sim.particleScale;
+    out->timeChange = timeChange;
+    return true;
+}
+
+void QSSGParticleSimulation::simulate(QSSGParticleBuffer &buffer) const
+{
+    const int particleCount = std::min(int(emitData.size()), buffer.particleCount());
+    const int pps = buffer.particlesPerSlice();
+    const int ss = buffer.sliceStride();
+    char *dest = buffer.pointer();
+    QSSGBounds3 bounds;
+    for (int i = 0; i < particleCount; ++i) {
+        QSSGParticleSimple *dp = reinterpret_cast<QSSGParticleSimple *>(dest + (i / pps) * ss) + (i % pps);
+        SimulatedParticle particle;
+        if (simulateParticle(*this, emitData.at(i), &particle)) {
+            bounds.include(particle.position);
+            *dp = { particle.position, particle.size, particle.rotation, particle.timeChange, particle.color };
+        } else {
+            *dp = {};
+        }
+    }
+    buffer.setBounds(bounds);
+}
+
+// -1 until QT_QUICK3D_GPU_PARTICLES has been read
+static QBasicAtomicInt simulationRequested = Q_BASIC_ATOMIC_INITIALIZER(-1);
+
+bool QSSGParticleSimulation::isRequested()
+{
+    int requested = simulationRequested.loadRelaxed();
+    if (requested < 0) {
+        requested = qEnvironmentVariableIntValue("QT_QUICK3D_GPU_PARTICLES") ? 1 : 0;
+        simulationRequested.storeRelaxed(requested);
+    }
+    return requested;
+}
+
+void QSSGParticleSimulation::setRequested(bool requested)
+{
+    simulationRequested.storeRelaxed(requested ? 1 : 0);
+}
+
 QSSGRenderParticles::QSSGRenderParticles()
     : QSSGRenderNode(QSSGRenderGraphObject::Type::Particles)
 {
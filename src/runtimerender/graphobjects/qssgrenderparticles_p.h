@@ -42,6 +42,7 @@
 //
 
 #include <QtQuick3DRuntimeRender/private/qssgrendernode_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgparticlesimulation_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrendercustommaterial_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrenderlight_p.h>
 #include <QtQuick3DUtils/private/qssgrenderbasetypes_p.h>
@@ -89,6 +90,9 @@ struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGTriangleParticle
 struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGParticleBuffer
 {
     void resize(int particleCount, int particleSize = sizeof(QSSGParticleSimple));
+    // Like resize(), but without allocating the data. For particles which are
+    // simulated by the renderer, see QSSGParticleSimulation.
+    void resizeLayout(int particleCount, int particleSize = sizeof(QSSGParticleSimple));
     void setBounds(const QSSGBounds3& bounds);
 
     char *pointer();
@@ -104,6 +108,8 @@ struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGParticleBuffer
     int serial() const;
 
 private:
+    void updateLayout(int particleCount, int particleSize);
+
     int m_particlesPerSlice = 0;
     int m_sliceStride = 0;
     int m_particleCount = 0;
@@ -113,6 +119,109 @@ private:
     QSSGBounds3 m_bounds;
 };
 
+// Emit time data of one particle for the GPU simulation.
+// Matches EmitData in particlesimulate.comp.
+struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGParticleEmitData
+{
+    QVector3D startPosition;
+    float startTime;
+    QVector3D startVelocity;
+    float lifetime;         // negative for unused slots
+    QVector3D startRotation; // degrees
+    float startSize;
+    QVector3D rotationVelocity; // degrees per second
+    float endSize;
+    QVector4D startColor;
+    quint32 index;          // particle index for the random table lookups
+    quint32 unusedPadding[3];
+    // total 96 bytes
+};
+
+// One affector of the GPU simulation. The meaning of the parameters depends
+// on the type, see QQuick3DParticleAffector::fillSimulationData() and
+// particlesimulate.comp.
+struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGParticleAffectorData
+{
+    enum class Type : quint32
+    {
+        Gravity = QSSG_PARTICLE_AFFECTOR_GRAVITY,
+        Attractor = QSSG_PARTICLE_AFFECTOR_ATTRACTOR,
+        Wander = QSSG_PARTICLE_AFFECTOR_WANDER,
+        PointRotator = QSSG_PARTICLE_AFFECTOR_POINTROTATOR
+    };
+    enum Flag : quint32
+    {
+        HideAtEnd = QSSG_PARTICLE_AFFECTOR_HIDE_AT_END
+    };
+
+    Type type = Type::Gravity;
+    quint32 flags = 0;
+    quint32 unusedPadding[2] = {};
+    QVector4D params[6];
+    // total 112 bytes
+};
+
+// Everything the renderer needs for simulating sprite particles on the GPU
+// instead of getting them from the particle buffer. Used when the particle
+// system and its affectors can be expressed with the built-in simulation,
+// see QT_QUICK3D_GPU_PARTICLES.
+struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGParticleSimulation
+{
+    static constexpr int MaxAffectors = QSSG_PARTICLE_MAX_AFFECTORS;
+
+    enum class FadeEffect : quint32
+    {
+        None = QSSG_PARTICLE_FADE_NONE,
+        Opacity = QSSG_PARTICLE_FADE_OPACITY,
+        Scale = QSSG_PARTICLE_FADE_SCALE
+    };
+
+    // Slots changed in the update with the given serial
+    struct Range
+    {
+        int serial;
+        int begin;
+        int end;
+    };
+
+    bool enabled = false;
+    // Emit data of every particle slot. The same node can be rendered by
+    // several render contexts, each with its own copy of the data, so the
+    // changes are kept as a history instead of being cleared by the renderer:
+    // a copy from serial dirtyRangesBaseSerial or later is brought up to date
+    // by uploading the ranges with a later serial, older copies are replaced.
+    QVector<QSSGParticleEmitData> emitData;
+    QVector<Range> dirtyRanges;
+    int dirtyRangesBaseSerial = 1;
+
+    // The random table of the particle system, uploaded when the serial changes
+    QList<float> randomTable;
+    int randomTableSerial = 0;
+
+    // Seconds since the start of the particle system
+    float time = 0.0f;
+    float fadeInDuration = 0.0f;
+    float fadeOutDuration = 0.0f;
+    FadeEffect fadeInEffect = FadeEffect::None;
+    FadeEffect fadeOutEffect = FadeEffect::None;
+    float particleScale = 1.0f;
+    QVector2D offset;
+    QVarLengthArray<QSSGParticleAffectorData, MaxAffectors> affectors;
+    // Changes whenever the data above does, the renderer simulates once per serial
+    int serial = 0;
+
+    // Both are called before serial is incremented for the update
+    void markDirty(int slot);
+    void markAllDirty();
+    // Simulates the particles on the CPU into buffer. Used when the renderer
+    // does not support compute shaders.
+    void simulate(QSSGParticleBuffer &buffer) const;
+
+    static bool isRequested();
+    // Overrides QT_QUICK3D_GPU_PARTICLES, for the tests comparing the two paths
+    static void setRequested(bool requested);
+};
+
 struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGRenderParticles : public QSSGRenderNode
 {
     enum class BlendMode : quint8
@@ -134,6 +243,7 @@ struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGRenderParticles : public QSSGRenderNode
     Q_DISABLE_COPY(QSSGRenderParticles)
 
     QSSGParticleBuffer m_particleBuffer;
+    QSSGParticleSimulation m_simulation;
 
     QVarLengthArray<QSSGRenderLight *, 4> m_lights;
 
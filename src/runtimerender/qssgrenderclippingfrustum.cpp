@@ -86,4 +86,23 @@ QSSGClippingFrustum::QSSGClippingFrustum(const QMatrix4x4 &modelviewprojection,
         _cullingPlanes[idx].calculateBBoxEdges();
 }
 
+static QSSGClipPlane nearPlaneFromMatrix(const QMatrix4x4 &modelviewprojection)
+{
+    const float *modelviewProjection = modelviewprojection.constData();
+#define M(_x, _y) modelviewProjection[(4 * (_y)) + (_x)]
+    QSSGClipPlane nearPlane;
+    nearPlane.normal.setX(M(3, 0) + M(2, 0));
+    nearPlane.normal.setY(M(3, 1) + M(2, 1));
+    nearPlane.normal.setZ(M(3, 2) + M(2, 2));
+    nearPlane.d = M(3, 3) + M(2, 3);
+    nearPlane.d /= vec3::normalize(nearPlane.normal);
+#undef M
+    return nearPlane;
+}
+
+QSSGClippingFrustum::QSSGClippingFrustum(const QMatrix4x4 &modelviewprojection)
+    : QSSGClippingFrustum(modelviewprojection, nearPlaneFromMatrix(modelviewprojection))
+{
+}
+
 QT_END_NAMESPACE
@@ -42,6 +42,8 @@
 // We mean it.
 //
 
+#include <QtQuick3DRuntimeRender/private/qtquick3druntimerenderglobal_p.h>
+
 #include <QtQuick3DUtils/private/qssgplane_p.h>
 #include <QtQuick3DUtils/private/qssgbounds3_p.h>
 
@@ -139,13 +141,15 @@ struct QSSGClipPlane
     }
 };
 
-struct QSSGClippingFrustum
+struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGClippingFrustum
 {
     QSSGClipPlane mPlanes[6];
 
     QSSGClippingFrustum() = default;
 
     QSSGClippingFrustum(const QMatrix4x4 &modelviewprojection, const QSSGClipPlane &nearPlane);
+    // Takes the near plane from the matrix as well, assuming a [-1, 1] clip depth range.
+    explicit QSSGClippingFrustum(const QMatrix4x4 &modelviewprojection);
 
     bool intersectsWith(const QSSGBounds3 &bounds) const
     {
@@ -190,6 +190,7 @@ void QSSGRenderContextInterface::beginFrame(QSSGRenderLayer *layer, bool allowRe
     }
 
     m_perFrameAllocator.reset();
+    m_jobSystem.resetAllocators();
     m_renderer->beginFrame();
     resetResourceCounters(layer);
 }
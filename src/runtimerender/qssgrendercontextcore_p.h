@@ -46,6 +46,7 @@
 #include <QtQuick3DRuntimeRender/private/qssgrhicustommaterialsystem_p.h>
 #include <QtQuick3DRuntimeRender/private/qtquick3druntimerenderglobal_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgperframeallocator_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrenderjobsystem_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrendershadercache_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrenderdefaultmaterialshadergenerator_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrenderbuffermanager_p.h>
@@ -95,6 +96,10 @@ public:
     // This is useful for short lived objects and datastructures.
     QSSGPerFrameAllocator &perFrameAllocator() { return m_perFrameAllocator; }
 
+    // Worker threads (each with their own per-frame allocator) for the
+    // parallel parts of the render preparation.
+    QSSGRenderJobSystem &jobSystem() { return m_jobSystem; }
+
     // Get the number of times EndFrame has been called
     quint32 frameCount() { return m_frameCount; }
 
@@ -147,6 +152,7 @@ private:
     const QSSGRef<QSSGProgramGenerator> m_shaderProgramGenerator;
 
     QSSGPerFrameAllocator m_perFrameAllocator;
+    QSSGRenderJobSystem m_jobSystem;
     quint32 m_activeFrameRef = 0;
     quint32 m_frameCount = 0;
 
@@ -278,6 +278,10 @@ static QSSGMaterialShaderGenerator::ShadowVariableNames setupShadowMapVariableNa
         names.shadowCoordStem.append("_coord");
         names.shadowControlStem = names.shadowMapStem;
         names.shadowControlStem.append("_control");
+        names.shadowSplitsStem = names.shadowMapStem;
+        names.shadowSplitsStem.append("_splits");
+        names.shadowTileStem = names.shadowMapStem;
+        names.shadowTileStem.append("_tiles");
     }
 
     return names;
@@ -377,12 +381,23 @@ static void generateShadowMapOcclusion(QSSGStageGeneratorBase &fragmentShader,
             fragmentShader.addUniform(names.shadowCubeStem, "samplerCube");
         }
         fragmentShader.addUniform(names.shadowControlStem, "vec4");
-        fragmentShader.addUniform(names.shadowMatrixStem, "mat4");
 
         if (inType != QSSGRenderLight::Type::DirectionalLight) {
+            fragmentShader.addUniform(names.shadowMatrixStem, "mat4");
             fragmentShader << "    qt_shadow_map_occl = qt_sampleCubemap(" << names.shadowCubeStem << ", " << names.shadowControlStem << ", " << names.shadowMatrixStem << ", " << lightVarNames.lightPos << ".xyz, qt_varWorldPos, vec2(1.0, " << names.shadowControlStem << ".z));\n";
         } else {
-            fragmentShader << "    qt_shadow_map_occl = qt_sampleOrthographic(" << names.shadowMapStem << ", " << names.shadowControlStem << ", " << names.shadowMatrixStem << ", qt_varWorldPos, vec2(1.0, " << names.shadowControlStem << ".z));\n";
+            // one matrix per cascade, picked by the distance from the camera
+            fragmentShader.addUniformArray(names.shadowMatrixStem, "mat4", QSSG_MAX_NUM_SHADOW_CASCADES);
+            fragmentShader.addUniformArray(names.shadowTileStem, "vec4", QSSG_MAX_NUM_SHADOW_CASCADES);
+            fragmentShader.addUniform(names.shadowSplitsStem, "vec4");
+            fragmentShader.addUniform("qt_cameraPosition", "vec3");
+            fragmentShader.addUniform("qt_cameraDirection", "vec3");
+            fragmentShader << "    qt_shadow_map_occl = qt_sampleCascades(" << names.shadowMapStem << ", " << names.shadowControlStem << ", "
+                           << names.shadowMatrixStem << "[0], " << names.shadowMatrixStem << "[1], "
+                           << names.shadowMatrixStem << "[2], " << names.shadowMatrixStem << "[3], "
+                           << names.shadowTileStem << "[0], " << names.shadowTileStem << "[1], "
+                           << names.shadowTileStem << "[2], " << names.shadowTileStem << "[3], "
+                           << names.shadowSplitsStem << ", qt_varWorldPos, dot(qt_varWorldPos - qt_cameraPosition, normalize(qt_cameraDirection)));\n";
         }
     } else {
         fragmentShader << "    qt_shadow_map_occl = 1.0;\n";
@@ -1606,7 +1621,8 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGMaterialShaderGenerator::generateMaterialRhiS
                                                                                       const QSSGShaderLightList &inLights,
                                                                                       QSSGRenderableImage *inFirstImage,
                                                                                       const QSSGRef<QSSGShaderLibraryManager> &shaderLibraryManager,
-                                                                                      const QSSGRef<QSSGShaderCache> &theCache)
+                                                                                      const QSSGRef<QSSGShaderCache> &theCache,
+                                                                                      bool *deferred)
 {
     QByteArray materialInfoString; // also serves as the key for the cache in compileGeneratedRhiShader
     // inShaderKeyPrefix can be a static string for default materials, but must
@@ -1620,7 +1636,7 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGMaterialShaderGenerator::generateMaterialRhiS
     vertexPipeline.endVertexGeneration();
     vertexPipeline.endFragmentGeneration();
 
-    return vertexPipeline.programGenerator()->compileGeneratedRhiShader(materialInfoString, inFeatureSet, shaderLibraryManager, theCache, {});
+    return vertexPipeline.programGenerator()->compileGeneratedRhiShader(materialInfoString, inFeatureSet, shaderLibraryManager, theCache, {}, deferred);
 }
 
 static float ZERO_MATRIX[16] = {};
@@ -1653,15 +1669,16 @@ void QSSGMaterialShaderGenerator::setRhiMaterialProperties(const QSSGRenderConte
 {
     QSSGShaderMaterialAdapter *materialAdapter = getMaterialAdapter(inMaterial);
     QSSGRhiShaderPipeline::CommonUniformIndices &cui = shaders->commonUniformIndices;
+    using CommonUniform = QSSGRhiShaderPipeline::CommonUniform;
 
     materialAdapter->setCustomPropertyUniforms(ubufData, shaders, renderContext);
 
     const QVector3D camGlobalPos = inCamera.getGlobalPos();
     const QVector2D camProperties(inCamera.clipNear, inCamera.clipFar);
 
-    shaders->setUniform(ubufData, "qt_cameraPosition", &camGlobalPos, 3 * sizeof(float), &cui.cameraPositionIdx);
-    shaders->setUniform(ubufData, "qt_cameraDirection", &inRenderProperties.cameraDirection, 3 * sizeof(float), &cui.cameraDirectionIdx);
-    shaders->setUniform(ubufData, "qt_cameraProperties", &camProperties, 2 * sizeof(float), &cui.cameraPropertiesIdx);
+    shaders->setUniform(ubufData, CommonUniform::CameraPosition, &camGlobalPos, 3 * sizeof(float));
+    shaders->setUniform(ubufData, CommonUniform::CameraDirection, &inRenderProperties.cameraDirection, 3 * sizeof(float));
+    shaders->setUniform(ubufData, CommonUniform::CameraProperties, &camProperties, 2 * sizeof(float));
 
     // Only calculate and update Matrix uniforms if they are needed
     bool usesProjectionMatrix = false;
@@ -1697,36 +1714,36 @@ void QSSGMaterialShaderGenerator::setRhiMaterialProperties(const QSSGRenderConte
     if (usesProjectionMatrix || usesInvProjectionMatrix) {
         const QMatrix4x4 projection = clipSpaceCorrMatrix * inCamera.projection;
         if (usesProjectionMatrix)
-            shaders->setUniform(ubufData, "qt_projectionMatrix", projection.constData(), 16 * sizeof(float), &cui.projectionMatrixIdx);
+            shaders->setUniform(ubufData, CommonUniform::ProjectionMatrix, projection.constData(), 16 * sizeof(float));
         if (usesInvProjectionMatrix)
-            shaders->setUniform(ubufData, "qt_inverseProjectionMatrix", projection.inverted().constData(), 16 * sizeof (float), &cui.inverseProjectionMatrixIdx);
+            shaders->setUniform(ubufData, CommonUniform::InverseProjectionMatrix, projection.inverted().constData(), 16 * sizeof (float));
     }
     if (usesViewMatrix) {
         const QMatrix4x4 viewMatrix = inCamera.globalTransform.inverted();
-        shaders->setUniform(ubufData, "qt_viewMatrix", viewMatrix.constData(), 16 * sizeof(float), &cui.viewMatrixIdx);
+        shaders->setUniform(ubufData, CommonUniform::ViewMatrix, viewMatrix.constData(), 16 * sizeof(float));
     }
     if (usesViewProjectionMatrix) {
         QMatrix4x4 viewProj;
         inCamera.calculateViewProjectionMatrix(viewProj);
         viewProj = clipSpaceCorrMatrix * viewProj;
-        shaders->setUniform(ubufData, "qt_viewProjectionMatrix", viewProj.constData(), 16 * sizeof(float), &cui.viewProjectionMatrixIdx);
+        shaders->setUniform(ubufData, CommonUniform::ViewProjectionMatrix, viewProj.constData(), 16 * sizeof(float));
     }
 
     // qt_modelMatrix is always available, but differnt when using instancing
     if (usesInstancing)
-        shaders->setUniform(ubufData, "qt_modelMatrix", localInstanceTransform.constData(), 16 * sizeof(float), &cui.modelMatrixIdx);
+        shaders->setUniform(ubufData, CommonUniform::ModelMatrix, localInstanceTransform.constData(), 16 * sizeof(float));
     else
-        shaders->setUniform(ubufData, "qt_modelMatrix", inGlobalTransform.constData(), 16 * sizeof(float), &cui.modelMatrixIdx);
+        shaders->setUniform(ubufData, CommonUniform::ModelMatrix, inGlobalTransform.constData(), 16 * sizeof(float));
 
     if (usesModelViewProjectionMatrix) {
         const QMatrix4x4 mvp = clipSpaceCorrMatrix * inModelViewProjection;
-        shaders->setUniform(ubufData, "qt_modelViewProjection", mvp.constData(), 16 * sizeof(float), &cui.modelViewProjectionIdx);
+        shaders->setUniform(ubufData, CommonUniform::ModelViewProjection, mvp.constData(), 16 * sizeof(float));
     }
     if (usesNormalMatrix)
-        shaders->setUniform(ubufData, "qt_normalMatrix", inNormalMatrix.constData(), 12 * sizeof(float), &cui.normalMatrixIdx,
+        shaders->setUniform(ubufData, CommonUniform::NormalMatrix, inNormalMatrix.constData(), 12 * sizeof(float),
                             QSSGRhiShaderPipeline::UniformFlag::Mat3); // real size will be 12 floats, setUniform repacks as needed
     if (usesParentMatrix)
-        shaders->setUniform(ubufData, "qt_parentMatrix", globalInstanceTransform.constData(), 16 * sizeof(float));
+        shaders->setUniform(ubufData, CommonUniform::ParentMatrix, globalInstanceTransform.constData(), 16 * sizeof(float));
 
     // Skinning
     const bool hasCustomVert = materialAdapter->hasCustomShaderSnippet(QSSGShaderCache::ShaderType::Vertex);
@@ -1803,18 +1820,41 @@ void QSSGMaterialShaderGenerator::setRhiMaterialProperties(const QSSGRenderConte
             } else {
                 theShadowMapProperties.shadowMapTexture = pEntry->m_rhiDepthMap;
                 theShadowMapProperties.shadowMapTextureUniformName = names.shadowMapStem;
-                if (receivesShadows) {
+                static_assert(QSSG_MAX_NUM_SHADOW_CASCADES == 4, "The cascade splits are passed as a vec4");
+                QMatrix4x4 cascadeMatrices[QSSG_MAX_NUM_SHADOW_CASCADES];
+                QVector4D cascadeTiles[QSSG_MAX_NUM_SHADOW_CASCADES];
+                float splits[QSSG_MAX_NUM_SHADOW_CASCADES];
+                const int cascadeCount = qMax(1, pEntry->m_cascadeCount);
+                for (int cascade = 0; cascade < QSSG_MAX_NUM_SHADOW_CASCADES; ++cascade) {
+                    // the unused ones repeat the last cascade
+                    const int c = qMin(cascade, cascadeCount - 1);
+                    splits[cascade] = pEntry->m_cascadeSplits[c];
+                    if (!receivesShadows) {
+                        cascadeMatrices[cascade].fill(0.0f);
+                        continue;
+                    }
                     // add fixed scale bias matrix
                     const QMatrix4x4 bias = {
                         0.5, 0.0, 0.0, 0.5,
                         0.0, 0.5, 0.0, 0.5,
                         0.0, 0.0, 0.5, 0.5,
                         0.0, 0.0, 0.0, 1.0 };
-                    const QMatrix4x4 m = bias * pEntry->m_lightVP;
-                    shaders->setUniform(ubufData, names.shadowMatrixStem, m.constData(), 16 * sizeof(float));
-                } else {
-                    shaders->setUniform(ubufData, names.shadowMatrixStem, ZERO_MATRIX, 16 * sizeof(float));
+                    // then into the cascade's tile in the atlas, taking into
+                    // account that the shader flips Y afterwards when Y is
+                    // not up in the framebuffer
+                    const QVector4D &tile(pEntry->m_atlasUvRect[c]);
+                    cascadeTiles[cascade] = tile;
+                    const float tileY = inRenderProperties.isYUpInFramebuffer ? tile.y() : 1.0f - tile.y() - tile.w();
+                    const QMatrix4x4 atlas = {
+                        tile.z(), 0.0f, 0.0f, tile.x(),
+                        0.0f, tile.w(), 0.0f, tileY,
+                        0.0f, 0.0f, 1.0f, 0.0f,
+                        0.0f, 0.0f, 0.0f, 1.0f };
+                    cascadeMatrices[cascade] = atlas * bias * pEntry->m_cascadeLightVP[c];
                 }
+                shaders->setUniformArray(ubufData, names.shadowMatrixStem, cascadeMatrices, QSSG_MAX_NUM_SHADOW_CASCADES, QSSGRenderShaderDataType::Matrix4x4);
+                shaders->setUniformArray(ubufData, names.shadowTileStem, cascadeTiles, QSSG_MAX_NUM_SHADOW_CASCADES, QSSGRenderShaderDataType::Vec4);
+                shaders->setUniform(ubufData, names.shadowSplitsStem, splits, 4 * sizeof(float));
             }
 
             if (receivesShadows) {
@@ -1871,33 +1911,33 @@ void QSSGMaterialShaderGenerator::setRhiMaterialProperties(const QSSGRenderConte
         const int maxMipLevel = lightProbeTexture.m_mipmapCount - 1;
 
         if (!materialIblProbe && !inRenderProperties.probeOrientation.isIdentity()) {
-            shaders->setUniform(ubufData, "qt_lightProbeOrientation",
+            shaders->setUniform(ubufData, CommonUniform::LightProbeOrientation,
                                 inRenderProperties.probeOrientation.constData(),
-                                12 * sizeof(float), &cui.lightProbeOrientationIdx,
+                                12 * sizeof(float),
                                 QSSGRhiShaderPipeline::UniformFlag::Mat3);
         }
 
         const float props[4] = { 0.0f, float(maxMipLevel), inRenderProperties.probeHorizon, inRenderProperties.probeExposure };
-        shaders->setUniform(ubufData, "qt_lightProbeProperties", props, 4 * sizeof(float), &cui.lightProbePropertiesIdx);
+        shaders->setUniform(ubufData, CommonUniform::LightProbeProperties, props, 4 * sizeof(float));
 
         shaders->setLightProbeTexture(lightProbeTexture.m_texture, theHorzLightProbeTilingMode, theVertLightProbeTilingMode);
     } else {
         // no lightprobe
         const float emptyProps[4] = { 0.0f, 0.0f, -1.0f, 0.0f };
-        shaders->setUniform(ubufData, "qt_lightProbeProperties", emptyProps, 4 * sizeof(float), &cui.lightProbePropertiesIdx);
+        shaders->setUniform(ubufData, CommonUniform::LightProbeProperties, emptyProps, 4 * sizeof(float));
 
         shaders->setLightProbeTexture(nullptr);
     }
 
     if (receivesReflections && reflectionProbe.enabled) {
-        shaders->setUniform(ubufData, "qt_reflectionProbeBoxCenter", &reflectionProbe.probeBoxCenter, 3 * sizeof(float), &cui.reflectionProbeBoxCenter);
-        shaders->setUniform(ubufData, "qt_reflectionProbeBoxMin", &reflectionProbe.probeBoxMin, 3 * sizeof(float), &cui.reflectionProbeBoxMin);
-        shaders->setUniform(ubufData, "qt_reflectionProbeBoxMax", &reflectionProbe.probeBoxMax, 3 * sizeof(float), &cui.reflectionProbeBoxMax);
-        shaders->setUniform(ubufData, "qt_reflectionProbeCorrection", &reflectionProbe.parallaxCorrection, sizeof(int), &cui.reflectionProbeCorrection);
+        shaders->setUniform(ubufData, CommonUniform::ReflectionProbeBoxCenter, &reflectionProbe.probeBoxCenter, 3 * sizeof(float));
+        shaders->setUniform(ubufData, CommonUniform::ReflectionProbeBoxMin, &reflectionProbe.probeBoxMin, 3 * sizeof(float));
+        shaders->setUniform(ubufData, CommonUniform::ReflectionProbeBoxMax, &reflectionProbe.probeBoxMax, 3 * sizeof(float));
+        shaders->setUniform(ubufData, CommonUniform::ReflectionProbeCorrection, &reflectionProbe.parallaxCorrection, sizeof(int));
     }
 
     const QVector3D emissiveColor = materialAdapter->emissiveColor();
-    shaders->setUniform(ubufData, "qt_material_emissive_color", &emissiveColor, 3 * sizeof(float), &cui.material_emissiveColorIdx);
+    shaders->setUniform(ubufData, CommonUniform::MaterialEmissiveColor, &emissiveColor, 3 * sizeof(float));
 
     const auto qMix = [](float x, float y, float a) {
         return (x * (1.0f - a) + (y * a));
@@ -1911,11 +1951,11 @@ void QSSGMaterialShaderGenerator::setRhiMaterialProperties(const QSSGRenderConte
     const QVector3D materialSpecularTint = materialAdapter->specularTint();
     const QVector3D specularTint = materialAdapter->isPrincipled() ? qMix3(QVector3D(1.0f, 1.0f, 1.0f), color.toVector3D(), materialSpecularTint.x())
                                                                    : materialSpecularTint;
-    shaders->setUniform(ubufData, "qt_material_base_color", &color, 4 * sizeof(float), &cui.material_baseColorIdx);
+    shaders->setUniform(ubufData, CommonUniform::MaterialBaseColor, &color, 4 * sizeof(float));
 
     const float ior = materialAdapter->ior();
     QVector4D specularColor(specularTint, ior);
-    shaders->setUniform(ubufData, "qt_material_specular", &specularColor, 4 * sizeof(float), &cui.material_specularIdx);
+    shaders->setUniform(ubufData, CommonUniform::MaterialSpecular, &specularColor, 4 * sizeof(float));
 
      // metalnessAmount cannot be multiplied in here yet due to custom materials
     const bool hasLighting = materialAdapter->hasLighting();
@@ -1931,7 +1971,7 @@ void QSSGMaterialShaderGenerator::setRhiMaterialProperties(const QSSGRenderConte
         memcpy(ubufData + shaders->ub0LightDataOffset(), &lightsUniformData, shaders->ub0LightDataSize());
     }
 
-    shaders->setUniform(ubufData, "qt_light_ambient_total", &theLightAmbientTotal, 3 * sizeof(float), &cui.light_ambient_totalIdx);
+    shaders->setUniform(ubufData, CommonUniform::LightAmbientTotal, &theLightAmbientTotal, 3 * sizeof(float));
 
     const float materialProperties[4] = {
         materialAdapter->specularAmount(),
@@ -1939,7 +1979,7 @@ void QSSGMaterialShaderGenerator::setRhiMaterialProperties(const QSSGRenderConte
         materialAdapter->metalnessAmount(),
         inOpacity
     };
-    shaders->setUniform(ubufData, "qt_material_properties", materialProperties, 4 * sizeof(float), &cui.material_propertiesIdx);
+    shaders->setUniform(ubufData, CommonUniform::MaterialProperties, materialProperties, 4 * sizeof(float));
 
     const float materialProperties2[4] = {
         materialAdapter->fresnelPower(),
@@ -1947,7 +1987,7 @@ void QSSGMaterialShaderGenerator::setRhiMaterialProperties(const QSSGRenderConte
         materialAdapter->translucentFallOff(),
         materialAdapter->diffuseLightWrap()
     };
-    shaders->setUniform(ubufData, "qt_material_properties2", materialProperties2, 4 * sizeof(float), &cui.material_properties2Idx);
+    shaders->setUniform(ubufData, CommonUniform::MaterialProperties2, materialProperties2, 4 * sizeof(float));
 
     const float materialProperties3[4] = {
         materialAdapter->occlusionAmount(),
@@ -1955,7 +1995,7 @@ void QSSGMaterialShaderGenerator::setRhiMaterialProperties(const QSSGRenderConte
         materialAdapter->clearcoatAmount(),
         materialAdapter->clearcoatRoughnessAmount()
     };
-    shaders->setUniform(ubufData, "qt_material_properties3", materialProperties3, 4 * sizeof(float), &cui.material_properties3Idx);
+    shaders->setUniform(ubufData, CommonUniform::MaterialProperties3, materialProperties3, 4 * sizeof(float));
 
     const float materialProperties4[4] = {
         materialAdapter->heightAmount(),
@@ -1963,15 +2003,15 @@ void QSSGMaterialShaderGenerator::setRhiMaterialProperties(const QSSGRenderConte
         materialAdapter->maxHeightSamples(),
         materialAdapter->transmissionFactor()
     };
-    shaders->setUniform(ubufData, "qt_material_properties4", materialProperties4, 4 * sizeof(float), &cui.material_properties4Idx);
+    shaders->setUniform(ubufData, CommonUniform::MaterialProperties4, materialProperties4, 4 * sizeof(float));
 
     // We only ever use attenuation and thickness uniforms when using transmission
     if (materialAdapter->isTransmissionEnabled()) {
         const QVector4D attenuationProperties(materialAdapter->attenuationColor(), materialAdapter->attenuationDistance());
-        shaders->setUniform(ubufData, "qt_material_attenuation", &attenuationProperties, 4 * sizeof(float), &cui.material_attenuationIdx);
+        shaders->setUniform(ubufData, CommonUniform::MaterialAttenuation, &attenuationProperties, 4 * sizeof(float));
 
         const float thickness = materialAdapter->thicknessFactor();
-        shaders->setUniform(ubufData, "qt_material_thickness", &thickness, sizeof(float), &cui.thicknessFactorIdx);
+        shaders->setUniform(ubufData, CommonUniform::MaterialThickness, &thickness, sizeof(float));
     }
 
     const float rhiProperties[4] = {
@@ -1980,7 +2020,7 @@ void QSSGMaterialShaderGenerator::setRhiMaterialProperties(const QSSGRenderConte
         inRenderProperties.isClipDepthZeroToOne ? 0.0f : -1.0f,
         0.0f // unused
     };
-    shaders->setUniform(ubufData, "qt_rhi_properties", rhiProperties, 4 * sizeof(float), &cui.rhiPropertiesIdx);
+    shaders->setUniform(ubufData, CommonUniform::RhiProperties, rhiProperties, 4 * sizeof(float));
 
     quint32 imageIdx = 0;
     for (QSSGRenderableImage *theImage = inFirstImage; theImage; theImage = theImage->m_nextImage, ++imageIdx) {
@@ -2005,12 +2045,12 @@ void QSSGMaterialShaderGenerator::setRhiMaterialProperties(const QSSGRenderConte
     }
 
     if (shadowDepthAdjust)
-        shaders->setUniform(ubufData, "qt_shadowDepthAdjust", shadowDepthAdjust, 2 * sizeof(float), &cui.shadowDepthAdjustIdx);
+        shaders->setUniform(ubufData, CommonUniform::ShadowDepthAdjust, shadowDepthAdjust, 2 * sizeof(float));
 
     const bool usesPointsTopology = inProperties.m_usesPointsTopology.getValue(inKey);
     if (usesPointsTopology) {
         const float pointSize = materialAdapter->pointSize();
-        shaders->setUniform(ubufData, "qt_materialPointSize", &pointSize, sizeof(float), &cui.pointSizeIdx);
+        shaders->setUniform(ubufData, CommonUniform::MaterialPointSize, &pointSize, sizeof(float));
     }
 
     inPipelineState->lineWidth = materialAdapter->lineWidth();
@@ -84,6 +84,8 @@ struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGMaterialShaderGenerator
         QByteArray shadowMatrixStem;
         QByteArray shadowCoordStem;
         QByteArray shadowControlStem;
+        QByteArray shadowSplitsStem;
+        QByteArray shadowTileStem;
     };
 
     ~QSSGMaterialShaderGenerator() = default;
@@ -98,7 +100,8 @@ struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGMaterialShaderGenerator
                                                                     const QSSGRenderGraphObject &inMaterial,
                                                                     const QSSGShaderLightList &inLights,
                                                                     QSSGRenderableImage *inFirstImage, const QSSGRef<QSSGShaderLibraryManager> &shaderLibraryManager,
-                                                                    const QSSGRef<QSSGShaderCache> &theCache);
+                                                                    const QSSGRef<QSSGShaderCache> &theCache,
+                                                                    bool *deferred = nullptr);
 
     static void setRhiMaterialProperties(const QSSGRenderContextInterface &,
                                          QSSGRef<QSSGRhiShaderPipeline> &shaders,
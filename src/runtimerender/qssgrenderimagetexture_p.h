@@ -51,7 +51,8 @@ class QRhiTexture;
 enum class QSSGRenderImageTextureFlagValue
 {
     HasTransparency = 1 << 0,
-    RGBE8 = 1 << 1
+    RGBE8 = 1 << 1,
+    Loading = 1 << 2
 };
 
 struct QSSGRenderImageTextureFlags : public QFlags<QSSGRenderImageTextureFlagValue>
@@ -61,6 +62,10 @@ struct QSSGRenderImageTextureFlags : public QFlags<QSSGRenderImageTextureFlagVal
 
     bool isRgbe8() const { return this->operator&(QSSGRenderImageTextureFlagValue::RGBE8); }
     void setRgbe8(bool inValue) { setFlag(QSSGRenderImageTextureFlagValue::RGBE8, inValue); }
+
+    // The texture is a placeholder for an image that is still being loaded
+    bool isLoading() const { return this->operator&(QSSGRenderImageTextureFlagValue::Loading); }
+    void setLoading(bool inValue) { setFlag(QSSGRenderImageTextureFlagValue::Loading, inValue); }
 };
 
 struct QSSGRenderImageTexture
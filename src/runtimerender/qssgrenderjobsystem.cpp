@@ -0,0 +1,97 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Quick 3D.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qssgrenderjobsystem_p.h"
+
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+
+QT_BEGIN_NAMESPACE
+
+static bool parallelPrepareDisabled()
+{
+    return qEnvironmentVariableIntValue("QT_QUICK3D_DISABLE_PARALLEL_PREPARE") != 0;
+}
+
+QSSGRenderJobSystem::QSSGRenderJobSystem()
+    : m_enabled(!parallelPrepareDisabled())
+{
+    // The calling thread participates, so one less pool thread is needed.
+    m_slotCount = qMax(1, QThread::idealThreadCount());
+    m_pool.setMaxThreadCount(qMax(1, m_slotCount - 1));
+    m_pool.setObjectName(QLatin1String("QSSGRenderJobSystem"));
+
+    m_allocators.reserve(m_slotCount);
+    for (int i = 0; i < m_slotCount; ++i)
+        m_allocators.push_back(std::make_unique<QSSGPerFrameAllocator>());
+}
+
+QSSGRenderJobSystem::~QSSGRenderJobSystem()
+{
+    m_pool.waitForDone();
+}
+
+void QSSGRenderJobSystem::resetAllocators()
+{
+    for (const auto &allocator : m_allocators)
+        allocator->reset();
+}
+
+void QSSGRenderJobSystem::run(int jobCount, const Job &job)
+{
+    if (jobCount <= 0)
+        return;
+
+    const int workerCount = qMin(slotCount(), jobCount) - 1;
+    if (workerCount <= 0) {
+        for (int i = 0; i < jobCount; ++i)
+            job(i, 0);
+        return;
+    }
+
+    QAtomicInt nextJob(0);
+    QSemaphore done;
+    const auto drain = [&nextJob, jobCount, &job](int slot) {
+        for (int i = nextJob.fetchAndAddRelaxed(1); i < jobCount; i = nextJob.fetchAndAddRelaxed(1))
+            job(i, slot);
+    };
+
+    for (int worker = 0; worker < workerCount; ++worker) {
+        const int slot = worker + 1;
+        m_pool.start([&drain, &done, slot]() {
+            drain(slot);
+            done.release();
+        });
+    }
+
+    drain(0);
+    done.acquire(workerCount);
+}
+
+QT_END_NAMESPACE
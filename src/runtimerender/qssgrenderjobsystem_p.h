@@ -0,0 +1,98 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Quick 3D.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSSGRENDERJOBSYSTEM_P_H
+#define QSSGRENDERJOBSYSTEM_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtQuick3DRuntimeRender/private/qtquick3druntimerenderglobal_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgperframeallocator_p.h>
+
+#include <QtCore/QThreadPool>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+QT_BEGIN_NAMESPACE
+
+// Small fork-join job system used by the render preparation step. There is
+// one instance per QSSGRenderContextInterface, so per render thread. The
+// calling (render) thread always takes part in executing the jobs, which
+// means that with a single worker slot everything runs inline.
+//
+// Each worker slot has its own QSSGPerFrameAllocator arena, so jobs can
+// allocate per-frame objects without locking. The arenas are reset together
+// with the context's main per-frame allocator in beginFrame().
+class Q_QUICK3DRUNTIMERENDER_EXPORT QSSGRenderJobSystem
+{
+    Q_DISABLE_COPY(QSSGRenderJobSystem)
+public:
+    using Job = std::function<void(int jobIndex, int slot)>;
+
+    QSSGRenderJobSystem();
+    ~QSSGRenderJobSystem();
+
+    // Disabled when QT_QUICK3D_DISABLE_PARALLEL_PREPARE is set, or when
+    // there is only one core available.
+    bool isEnabled() const { return m_enabled && m_slotCount > 1; }
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+
+    // Number of worker slots, including the calling thread.
+    int slotCount() const { return isEnabled() ? m_slotCount : 1; }
+
+    QSSGPerFrameAllocator &allocator(int slot) { return *m_allocators[slot]; }
+    void resetAllocators();
+
+    // Runs job(jobIndex, slot) for every jobIndex in [0, jobCount) and
+    // returns when all of them have finished. Jobs are picked up in order,
+    // but may complete in any order: a job must only write to data owned by
+    // its jobIndex (or slot), never to shared state.
+    void run(int jobCount, const Job &job);
+
+private:
+    QThreadPool m_pool;
+    std::vector<std::unique_ptr<QSSGPerFrameAllocator>> m_allocators;
+    int m_slotCount = 1;
+    bool m_enabled = true;
+};
+
+QT_END_NAMESPACE
+
+#endif // QSSGRENDERJOBSYSTEM_P_H
@@ -47,6 +47,8 @@
 #include <QtQuick3DUtils/private/qssgbounds3_p.h>
 #include <QtQuick3DUtils/private/qssgmeshbvh_p.h>
 
+#include <memory>
+
 QT_BEGIN_NAMESPACE
 
 struct QSSGRenderSubset
@@ -54,7 +56,7 @@ struct QSSGRenderSubset
     quint32 count;
     quint32 offset;
     QSSGBounds3 bounds; // Vertex buffer bounds
-    QSSGMeshBVHNode *bvhRoot = nullptr;
+    const QSSGMeshBVHNode *bvhRoot = nullptr;
     struct {
         QSSGRef<QSSGRhiBuffer> vertexBuffer;
         QSSGRef<QSSGRhiBuffer> indexBuffer;
@@ -90,17 +92,13 @@ struct QSSGRenderMesh
     QVector<QSSGRenderSubset> subsets;
     QSSGRenderDrawMode drawMode;
     QSSGRenderWinding winding;
-    QSSGMeshBVH *bvh = nullptr;
+    // Shared, so that picking can keep using it after the mesh has changed
+    std::shared_ptr<QSSGMeshBVH> bvh;
 
     QSSGRenderMesh(QSSGRenderDrawMode inDrawMode, QSSGRenderWinding inWinding)
         : drawMode(inDrawMode), winding(inWinding)
     {
     }
-
-    ~QSSGRenderMesh()
-    {
-        delete bvh;
-    }
 };
 QT_END_NAMESPACE
 
@@ -35,6 +35,8 @@
 #include <QtQuick3DUtils/private/qssgmeshbvh_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrendermesh_p.h>
 
+#include <QtCore/private/qsimd_p.h>
+
 QT_BEGIN_NAMESPACE
 
 // http://www.siggraph.org/education/materials/HyperGraph/raytrace/rayplane_intersection.htm
@@ -198,83 +200,201 @@ bool QSSGRenderRay::triangleIntersect(const QSSGRenderRay &ray,
 
 void QSSGRenderRay::intersectWithBVH(const RayData &data,
                                      const QSSGMeshBVHNode *bvh,
-                                     const QSSGRenderMesh *mesh,
-                                     QVector<IntersectionResult> &intersections,
-                                     int depth)
+                                     const QSSGMeshBVH *meshBVH,
+                                     QVector<IntersectionResult> &intersections)
 {
-    if (!bvh || !mesh || !mesh->bvh)
+    if (!bvh || !meshBVH)
         return;
 
-    // If this is a leaf node, process it's triangles
-    if (bvh->count != 0) {
-        // If there is an intersection on a leaf node, then test against geometry
-        auto results = intersectWithBVHTriangles(data, mesh->bvh->triangles, bvh->offset, bvh->count);
-        if (!results.isEmpty())
-            intersections.append(results);
-        return;
+    // The tree is at most 40 levels deep (see QSSGMeshBVHBuilder), and only
+    // one child per level is pending at any time.
+    constexpr int maxStackSize = 64;
+    const QSSGMeshBVHNode *stack[maxStackSize];
+    int stackSize = 0;
+    stack[stackSize++] = bvh;
+
+    const QSSGMeshBVHTriangle *triangles = meshBVH->triangles.constData();
+    while (stackSize > 0) {
+        const QSSGMeshBVHNode *node = stack[--stackSize];
+
+        // If this is a leaf node, process it's triangles
+        if (node->isLeaf()) {
+            if (node->count > 0)
+                intersectWithBVHTriangles(data, triangles + node->offset, node->count, intersections);
+            continue;
+        }
+
+        const QSSGMeshBVHNode *left = node->left();
+        const QSSGMeshBVHNode *right = node->right();
+        const auto leftHit = QSSGRenderRay::intersectWithAABBv2(data, left->boundingData);
+        const auto rightHit = QSSGRenderRay::intersectWithAABBv2(data, right->boundingData);
+        const bool hitLeft = leftHit.intersects();
+        const bool hitRight = rightHit.intersects();
+        Q_ASSERT(stackSize + 2 <= maxStackSize);
+        // Visit the nearer child first, the other one goes on the stack.
+        if (hitLeft && hitRight) {
+            const bool leftFirst = leftHit.min <= rightHit.min;
+            stack[stackSize++] = leftFirst ? right : left;
+            stack[stackSize++] = leftFirst ? left : right;
+        } else if (hitLeft) {
+            stack[stackSize++] = left;
+        } else if (hitRight) {
+            stack[stackSize++] = right;
+        }
     }
+}
+
+static inline void appendTriangleIntersection(const QSSGRenderRay::RayData &data,
+                                              const QSSGMeshBVHTriangle &triangle,
+                                              float u,
+                                              float v,
+                                              const QVector3D &normal,
+                                              QVector<QSSGRenderRay::IntersectionResult> &intersections)
+{
+    const float w = 1.0f - u - v;
+    const QVector3D localIntersectionPoint = u * triangle.vertex1 +
+                                             v * triangle.vertex2 +
+                                             w * triangle.vertex3;
+
+    const QVector2D uvCoordinate = u * triangle.uvCoord1 +
+                                   v * triangle.uvCoord2 +
+                                   w * triangle.uvCoord3;
+    // Get the intersection point in scene coordinates
+    const QVector3D sceneIntersectionPos = mat44::transform(data.globalTransform,
+                                                            localIntersectionPoint);
+    const QVector3D hitVector = data.ray.origin - sceneIntersectionPos;
+    // Get the magnitude of the hit vector
+    const float rayLengthSquared = vec3::magnitudeSquared(hitVector);
+    intersections.append(QSSGRenderRay::IntersectionResult(rayLengthSquared,
+                                                           uvCoordinate,
+                                                           sceneIntersectionPos,
+                                                           localIntersectionPoint,
+                                                           normal));
+}
+
+#if defined(__SSE2__)
+namespace {
+struct Vec3x4
+{
+    __m128 x;
+    __m128 y;
+    __m128 z;
+};
+
+inline Vec3x4 operator-(const Vec3x4 &a, const Vec3x4 &b)
+{
+    return { _mm_sub_ps(a.x, b.x), _mm_sub_ps(a.y, b.y), _mm_sub_ps(a.z, b.z) };
+}
 
-    auto hit = QSSGRenderRay::intersectWithAABBv2(data, bvh->left->boundingData);
-    if (hit.intersects())
-        intersectWithBVH(data, bvh->left, mesh, intersections, depth + 1);
+inline __m128 dot(const Vec3x4 &a, const Vec3x4 &b)
+{
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)), _mm_mul_ps(a.z, b.z));
+}
 
-    hit = QSSGRenderRay::intersectWithAABBv2(data, bvh->right->boundingData);
-    if (hit.intersects())
-        intersectWithBVH(data, bvh->right, mesh, intersections, depth + 1);
+inline Vec3x4 cross(const Vec3x4 &a, const Vec3x4 &b)
+{
+    return { _mm_sub_ps(_mm_mul_ps(a.y, b.z), _mm_mul_ps(a.z, b.y)),
+             _mm_sub_ps(_mm_mul_ps(a.z, b.x), _mm_mul_ps(a.x, b.z)),
+             _mm_sub_ps(_mm_mul_ps(a.x, b.y), _mm_mul_ps(a.y, b.x)) };
 }
 
+inline Vec3x4 splat(const QVector3D &v)
+{
+    return { _mm_set1_ps(v.x()), _mm_set1_ps(v.y()), _mm_set1_ps(v.z()) };
+}
 
+inline Vec3x4 gather(const QSSGMeshBVHTriangle *t, QVector3D QSSGMeshBVHTriangle::*vertex)
+{
+    return { _mm_setr_ps((t[0].*vertex).x(), (t[1].*vertex).x(), (t[2].*vertex).x(), (t[3].*vertex).x()),
+             _mm_setr_ps((t[0].*vertex).y(), (t[1].*vertex).y(), (t[2].*vertex).y(), (t[3].*vertex).y()),
+             _mm_setr_ps((t[0].*vertex).z(), (t[1].*vertex).z(), (t[2].*vertex).z(), (t[3].*vertex).z()) };
+}
+}
 
-QVector<QSSGRenderRay::IntersectionResult> QSSGRenderRay::intersectWithBVHTriangles(const RayData &data,
-                                                                                    const QVector<QSSGMeshBVHTriangle *> &bvhTriangles,
-                                                                                    int triangleOffset,
-                                                                                    int triangleCount)
+// Four triangles at a time, with the same arithmetic as triangleIntersect().
+static void intersectWithTriangles4(const QSSGRenderRay::RayData &data,
+                                    const QSSGMeshBVHTriangle *triangles,
+                                    QVector<QSSGRenderRay::IntersectionResult> &intersections)
 {
-    Q_ASSERT(bvhTriangles.count() >= triangleOffset + triangleCount);
+    const Vec3x4 origin = splat(data.origin);
+    const Vec3x4 direction = splat(data.direction);
+    const Vec3x4 v0 = gather(triangles, &QSSGMeshBVHTriangle::vertex1);
+    const Vec3x4 v1 = gather(triangles, &QSSGMeshBVHTriangle::vertex2);
+    const Vec3x4 v2 = gather(triangles, &QSSGMeshBVHTriangle::vertex3);
+    const __m128 zero = _mm_setzero_ps();
+
+    const Vec3x4 normal = cross(v1 - v0, v2 - v0);
+    const __m128 denominator = dot(normal, normal);
+    const __m128 Vd = dot(normal, direction);
+    const __m128 absVd = _mm_andnot_ps(_mm_set1_ps(-0.0f), Vd);
+    __m128 mask = _mm_cmpge_ps(absVd, _mm_set1_ps(0.0001f));
+    if (!_mm_movemask_ps(mask))
+        return;
+
+    const __m128 d = dot(normal, v0);
+    const __m128 t = _mm_div_ps(_mm_sub_ps(d, dot(normal, origin)), Vd);
+    mask = _mm_and_ps(mask, _mm_cmpge_ps(t, zero));
+    if (!_mm_movemask_ps(mask))
+        return;
+
+    const Vec3x4 P = { _mm_add_ps(origin.x, _mm_mul_ps(t, direction.x)),
+                       _mm_add_ps(origin.y, _mm_mul_ps(t, direction.y)),
+                       _mm_add_ps(origin.z, _mm_mul_ps(t, direction.z)) };
+    mask = _mm_and_ps(mask, _mm_cmpge_ps(dot(normal, cross(v1 - v0, P - v0)), zero));
+    const __m128 u = dot(normal, cross(v2 - v1, P - v1));
+    mask = _mm_and_ps(mask, _mm_cmpge_ps(u, zero));
+    const __m128 v = dot(normal, cross(v0 - v2, P - v2));
+    mask = _mm_and_ps(mask, _mm_cmpge_ps(v, zero));
+    const int hits = _mm_movemask_ps(mask);
+    if (!hits)
+        return;
 
-    QVector<QSSGRenderRay::IntersectionResult> results;
+    alignas(16) float us[4];
+    alignas(16) float vs[4];
+    alignas(16) float nx[4];
+    alignas(16) float ny[4];
+    alignas(16) float nz[4];
+    _mm_store_ps(us, _mm_div_ps(u, denominator));
+    _mm_store_ps(vs, _mm_div_ps(v, denominator));
+    _mm_store_ps(nx, normal.x);
+    _mm_store_ps(ny, normal.y);
+    _mm_store_ps(nz, normal.z);
+    for (int lane = 0; lane < 4; ++lane) {
+        if (hits & (1 << lane))
+            appendTriangleIntersection(data, triangles[lane], us[lane], vs[lane], QVector3D(nx[lane], ny[lane], nz[lane]), intersections);
+    }
+}
+#endif
 
-    for (int i = triangleOffset; i < triangleCount + triangleOffset; ++i) {
-        const auto &triangle = bvhTriangles[i];
+void QSSGRenderRay::intersectWithBVHTriangles(const RayData &data,
+                                              const QSSGMeshBVHTriangle *triangles,
+                                              int triangleCount,
+                                              QVector<IntersectionResult> &intersections)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    for (; i + 4 <= triangleCount; i += 4)
+        intersectWithTriangles4(data, triangles + i, intersections);
+#endif
 
-        QSSGRenderRay relativeRay(data.origin, data.direction);
+    const QSSGRenderRay relativeRay(data.origin, data.direction);
+    for (; i < triangleCount; ++i) {
+        const QSSGMeshBVHTriangle &triangle = triangles[i];
 
         // Use Barycentric Coordinates to get the intersection values
         float u = 0.f;
         float v = 0.f;
         QVector3D normal;
         const bool intersects = triangleIntersect(relativeRay,
-                                                  triangle->vertex1,
-                                                  triangle->vertex2,
-                                                  triangle->vertex3,
+                                                  triangle.vertex1,
+                                                  triangle.vertex2,
+                                                  triangle.vertex3,
                                                   u,
                                                   v,
                                                   normal);
-        if (intersects) {
-            const float w = 1.0f - u - v;
-            const QVector3D localIntersectionPoint = u * triangle->vertex1 +
-                                                     v * triangle->vertex2 +
-                                                     w * triangle->vertex3;
-
-            const QVector2D uvCoordinate = u * triangle->uvCoord1 +
-                                           v * triangle->uvCoord2 +
-                                           w * triangle->uvCoord3;
-            // Get the intersection point in scene coordinates
-            const QVector3D sceneIntersectionPos = mat44::transform(data.globalTransform,
-                                                                    localIntersectionPoint);
-            const QVector3D hitVector = data.ray.origin - sceneIntersectionPos;
-            // Get the magnitude of the hit vector
-            const float rayLengthSquared = vec3::magnitudeSquared(hitVector);
-            results.append(IntersectionResult(rayLengthSquared,
-                                              uvCoordinate,
-                                              sceneIntersectionPos,
-                                              localIntersectionPoint,
-                                              normal));
-        }
+        if (intersects)
+            appendTriangleIntersection(data, triangle, u, v, normal, intersections);
     }
-
-    // Does not intersect with any of the triangles
-    return results;
 }
 
 QSSGOption<QVector2D> QSSGRenderRay::relative(const QMatrix4x4 &inGlobalTransform,
@@ -52,7 +52,7 @@
 
 QT_BEGIN_NAMESPACE
 struct QSSGMeshBVHNode;
-struct QSSGRenderMesh;
+struct QSSGMeshBVH;
 struct QSSGMeshBVHTriangle;
 enum class QSSGRenderBasisPlanes
 {
@@ -140,15 +140,15 @@ struct Q_AUTOTEST_EXPORT QSSGRenderRay
                                          const QSSGBounds3 &bounds);
 
     static void intersectWithBVH(const RayData &data,
-                                        const QSSGMeshBVHNode *bvh,
-                                        const QSSGRenderMesh *mesh,
-                                        QVector<IntersectionResult> &intersections,
-                                        int depth = 0);
-
-    static QVector<IntersectionResult> intersectWithBVHTriangles(const RayData &data,
-                                                                 const QVector<QSSGMeshBVHTriangle *> &bvhTriangles,
-                                                                 int triangleOffset,
-                                                                 int triangleCount);
+                                 const QSSGMeshBVHNode *bvh,
+                                 const QSSGMeshBVH *meshBVH,
+                                 QVector<IntersectionResult> &intersections);
+
+    // Appends a result for every triangle the ray hits.
+    static void intersectWithBVHTriangles(const RayData &data,
+                                          const QSSGMeshBVHTriangle *triangles,
+                                          int triangleCount,
+                                          QVector<IntersectionResult> &intersections);
 
     QSSGOption<QVector2D> relative(const QMatrix4x4 &inGlobalTransform,
                                         const QSSGBounds3 &inBounds,
@@ -534,7 +534,7 @@ void QSSGReflectionMapEntry::renderMips(QSSGRhiContext *context)
                 face = m_timeSliceFace;
 
             cb->beginPass(m_rhiPrefilterRenderTargetsMap[mipLevel][face], QColor(0, 0, 0, 1), { 1.0f, 0 }, nullptr, QSSGRhiContext::commonPassFlags());
-            QSSGRHICTX_STAT(context, beginRenderPass(m_rhiPrefilterRenderTargetsMap[mipLevel][face]));
+            context->stats().beginRenderPass(m_rhiPrefilterRenderTargetsMap[mipLevel][face]);
             if (mipLevel < mipmapCount - 1) {
                 // Specular pre-filtered Cube Map levels
                 cb->setGraphicsPipeline(m_prefilterPipeline);
@@ -545,6 +545,8 @@ void QSSGReflectionMapEntry::renderMips(QSSGRhiContext *context)
                     { 2, quint32(uBufSamplesElementSize * mipLevel) }
                 };
                 cb->setShaderResources(m_prefilterSrb, 2, dynamicOffsets.constData());
+                context->stats().setGraphicsPipeline(m_prefilterPipeline);
+                context->stats().setShaderResources(m_prefilterSrb);
             } else {
                 // Diffuse Irradiance
                 cb->setGraphicsPipeline(m_irradiancePipeline);
@@ -555,11 +557,13 @@ void QSSGReflectionMapEntry::renderMips(QSSGRhiContext *context)
                     { 2, quint32(uBufIrradianceElementSize) }
                 };
                 cb->setShaderResources(m_irradianceSrb, 1, dynamicOffsets.constData());
+                context->stats().setGraphicsPipeline(m_irradiancePipeline);
+                context->stats().setShaderResources(m_irradianceSrb);
             }
             cb->draw(36);
             QSSGRHICTX_STAT(context, draw(36, 1));
             cb->endPass();
-            QSSGRHICTX_STAT(context, endRenderPass());
+            context->stats().endRenderPass();
 
             if (m_timeSlicing == QSSGRenderReflectionProbe::ReflectionTimeSlicing::IndividualFaces)
                 break;
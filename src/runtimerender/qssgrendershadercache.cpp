@@ -37,7 +37,15 @@
 
 #include <QtCore/QRegularExpression>
 #include <QtCore/QString>
+#include <QtCore/qbuffer.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qelapsedtimer.h>
 #include <QtCore/qfile.h>
+#include <QtCore/qfileinfo.h>
+#include <QtCore/qsavefile.h>
+#include <QtCore/qsemaphore.h>
+#include <QtCore/qstandardpaths.h>
+#include <QtCore/qthreadpool.h>
 
 #include <QtGui/qsurfaceformat.h>
 #if QT_CONFIG(opengl)
@@ -180,13 +188,389 @@ static void initBaker(QShaderBaker *, QRhi *)
 }
 #endif // QT_QUICK3D_HAS_RUNTIME_SHADERS
 
-QSSGShaderCache::~QSSGShaderCache() {}
+// Keeps the shaders baked at runtime in a qsbc file, so that later runs of
+// the application can skip QShaderBaker for materials they have seen before.
+// Entries are looked up by the hash of the shader cache key; the description
+// holds the full key and is compared on load, which rejects both hash
+// collisions and damaged entries. The description also records how long the
+// shader took to bake, which is what the stats report as time saved.
+//
+// The collection can only be written as a whole, so new shaders are collected
+// in memory and the file is rewritten, through QSaveFile, when the cache goes
+// away. Shaders used in this run are written first and the rest only as long
+// as they fit in the size limit, which drops the entries that have not been
+// used for the longest time.
+class QSSGShaderDiskCache
+{
+public:
+    QSSGShaderDiskCache(const QString &filePath, qint64 sizeLimit)
+        : m_filePath(filePath)
+        , m_sizeLimit(sizeLimit)
+        , m_collection(filePath)
+    {
+    }
+
+    ~QSSGShaderDiskCache()
+    {
+        save();
+    }
+
+    bool contains(size_t hkey)
+    {
+        return ensureMapped() && m_entries.contains(QQsbCollection::Entry(hkey)) && !m_invalid.contains(hkey);
+    }
+    bool load(size_t hkey, const QByteArray &identity, QShader *vert, QShader *frag, qint64 *bakeTimeUs);
+    void store(size_t hkey, const QByteArray &identity, const QShader &vert, const QShader &frag, qint64 bakeTimeUs);
+    void save();
+
+private:
+    struct Record
+    {
+        size_t hkey;
+        QByteArray description;
+        QShader vert;
+        QShader frag;
+    };
+
+    static QByteArray description(const QByteArray &identity, qint64 bakeTimeUs)
+    {
+        return QByteArray::number(bakeTimeUs) + ' ' + identity;
+    }
+
+    bool ensureMapped();
+
+    QString m_filePath;
+    qint64 m_sizeLimit;
+    QQsbCollection m_collection;
+    QQsbCollection::EntryMap m_entries;
+    bool m_mapAttempted = false;
+    bool m_mapped = false;
+    bool m_dirty = false;
+    QVector<size_t> m_used; // entries of the file loaded in this run
+    QSet<size_t> m_invalid; // entries of the file that failed to load
+    QVector<Record> m_pending; // shaders baked in this run
+};
+
+bool QSSGShaderDiskCache::ensureMapped()
+{
+    if (!m_mapAttempted) {
+        m_mapAttempted = true;
+        if (QFile::exists(m_filePath)) {
+            m_mapped = m_collection.map(QQsbCollection::Read);
+            if (m_mapped) {
+                m_entries = m_collection.getEntries();
+            } else {
+                qCDebug(PERF_INFO, "Ignoring unreadable shader cache %s", qPrintable(m_filePath));
+                m_dirty = true;
+            }
+        }
+    }
+    return m_mapped;
+}
+
+bool QSSGShaderDiskCache::load(size_t hkey, const QByteArray &identity, QShader *vert, QShader *frag, qint64 *bakeTimeUs)
+{
+    if (!ensureMapped())
+        return false;
+
+    const auto it = m_entries.constFind(QQsbCollection::Entry(hkey));
+    if (it == m_entries.cend() || m_invalid.contains(hkey))
+        return false;
+
+    QByteArray desc;
+    if (m_collection.extractQsbEntry(*it, &desc, nullptr, vert, frag)) {
+        const qsizetype separator = desc.indexOf(' ');
+        bool ok = false;
+        const qint64 bakeTime = separator > 0 ? desc.left(separator).toLongLong(&ok) : 0;
+        if (ok && desc.mid(separator + 1) == identity && vert->isValid() && frag->isValid()) {
+            *bakeTimeUs = bakeTime;
+            m_used.append(hkey);
+            return true;
+        }
+    }
+
+    // Either corrupted or a different key with the same hash. The shader is
+    // going to be baked and stored again, drop the old entry.
+    *vert = QShader();
+    *frag = QShader();
+    m_invalid.insert(hkey);
+    m_dirty = true;
+    return false;
+}
+
+void QSSGShaderDiskCache::store(size_t hkey, const QByteArray &identity, const QShader &vert, const QShader &frag, qint64 bakeTimeUs)
+{
+    m_pending.append({ hkey, description(identity, bakeTimeUs), vert, frag });
+    m_dirty = true;
+}
+
+void QSSGShaderDiskCache::save()
+{
+    if (!m_dirty)
+        return;
+    m_dirty = false;
+
+    if (m_mapped) {
+        m_collection.unmap();
+        m_mapped = false;
+    }
+    m_mapAttempted = false;
+    m_entries.clear();
+
+    QVector<Record> records;
+    QSet<size_t> written;
+    qint64 totalSize = 0;
+    const auto add = [&](Record &&record) {
+        if (written.contains(record.hkey))
+            return;
+        const qint64 size = record.description.size() + record.vert.serialized().size() + record.frag.serialized().size();
+        if (totalSize + size > m_sizeLimit)
+            return;
+        totalSize += size;
+        written.insert(record.hkey);
+        records.append(std::move(record));
+    };
+
+    // Newest first, the ones baked last are most likely still relevant.
+    for (auto it = m_pending.rbegin(), end = m_pending.rend(); it != end; ++it)
+        add(std::move(*it));
+    m_pending.clear();
+
+    // Re-read the file instead of relying on what was mapped: another
+    // process or window may have saved its shaders in the meantime.
+    if (QFile::exists(m_filePath)) {
+        QQsbCollection current(m_filePath);
+        if (current.map(QQsbCollection::Read)) {
+            const auto entries = current.getEntries();
+            QVector<QQsbCollection::Entry> ordered;
+            ordered.reserve(entries.size());
+            for (size_t hkey : std::as_const(m_used)) {
+                const auto it = entries.constFind(QQsbCollection::Entry(hkey));
+                if (it != entries.cend())
+                    ordered.append(*it);
+            }
+            for (const QQsbCollection::Entry &entry : entries) {
+                if (!m_used.contains(entry.hkey))
+                    ordered.append(entry);
+            }
+            for (const QQsbCollection::Entry &entry : std::as_const(ordered)) {
+                if (m_invalid.contains(entry.hkey) || written.contains(entry.hkey))
+                    continue;
+                Record record { entry.hkey, {}, {}, {} };
+                if (current.extractQsbEntry(entry, &record.description, nullptr, &record.vert, &record.frag)
+                        && record.vert.isValid() && record.frag.isValid()) {
+                    add(std::move(record));
+                }
+            }
+            current.unmap();
+        }
+    }
+    m_used.clear();
+    m_invalid.clear();
+
+    if (records.isEmpty()) {
+        QFile::remove(m_filePath);
+        return;
+    }
+
+    // The collection closes the device when done, so it is written to memory
+    // and then to a QSaveFile. This way a crash or a concurrent reader never
+    // sees a partially written cache.
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    {
+        QQsbCollection collection(buffer);
+        for (const Record &record : std::as_const(records))
+            collection.addQsbEntry(record.description, QQsbShaderFeatureSet(), record.vert, record.frag, record.hkey);
+        collection.unmap();
+    }
+
+    QDir().mkpath(QFileInfo(m_filePath).absolutePath());
+    QSaveFile f(m_filePath);
+    if (!f.open(QIODevice::WriteOnly) || f.write(buffer.data()) != buffer.data().size() || !f.commit())
+        qCDebug(PERF_INFO, "Failed to write shader cache %s", qPrintable(m_filePath));
+}
+
+// The manifest lists the material shaders compiled by an application, as the
+// sources before preprocessing, so that they can be baked ahead of their first
+// use by later runs, possibly for a different graphics API.
+struct QSSGShaderManifestEntry
+{
+    QByteArray key;
+    QSSGShaderFeatures features;
+    QByteArray vertexSource;
+    QByteArray fragmentSource;
+};
+
+static constexpr quint32 ShaderManifestMagic = 0x51334d46; // Q3MF
+static constexpr quint32 ShaderManifestVersion = 1;
+
+static QVector<QSSGShaderManifestEntry> readShaderManifest(const QString &fileName)
+{
+    QVector<QSSGShaderManifestEntry> entries;
+    QFile f(fileName);
+    if (!f.open(QIODevice::ReadOnly))
+        return entries;
+
+    QDataStream ds(&f);
+    ds.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint32 count = 0;
+    ds >> magic >> version >> count;
+    if (magic != ShaderManifestMagic || version != ShaderManifestVersion) {
+        qWarning("%s is not a shader manifest", qPrintable(fileName));
+        return entries;
+    }
+    for (quint32 i = 0; i < count; ++i) {
+        QSSGShaderManifestEntry entry;
+        ds >> entry.key >> entry.features.flags >> entry.vertexSource >> entry.fragmentSource;
+        if (ds.status() != QDataStream::Ok) {
+            qWarning("Shader manifest %s is truncated", qPrintable(fileName));
+            break;
+        }
+        entries.append(entry);
+    }
+    return entries;
+}
+
+static void writeShaderManifest(const QString &fileName, const QVector<QSSGShaderManifestEntry> &entries)
+{
+    QSaveFile f(fileName);
+    if (!f.open(QIODevice::WriteOnly)) {
+        qWarning("Failed to write shader manifest %s", qPrintable(fileName));
+        return;
+    }
+    QDataStream ds(&f);
+    ds.setVersion(QDataStream::Qt_6_0);
+    ds << ShaderManifestMagic << ShaderManifestVersion << quint32(entries.size());
+    for (const QSSGShaderManifestEntry &entry : entries)
+        ds << entry.key << entry.features.flags << entry.vertexSource << entry.fragmentSource;
+    if (!f.commit())
+        qWarning("Failed to write shader manifest %s", qPrintable(fileName));
+}
+
+QSSGShaderCache::~QSSGShaderCache()
+{
+    if (m_manifestRecordFile.isEmpty() || m_recordedShaders.isEmpty())
+        return;
+
+    // Add to what earlier runs recorded, they may have gone through other
+    // parts of the application.
+    QVector<QSSGShaderManifestEntry> entries = readShaderManifest(m_manifestRecordFile);
+    QSet<QPair<QByteArray, QSSGShaderFeatures::FlagType>> known;
+    for (const QSSGShaderManifestEntry &entry : std::as_const(entries))
+        known.insert({ entry.key, entry.features.flags });
+    for (auto it = m_recordedShaders.cbegin(), end = m_recordedShaders.cend(); it != end; ++it) {
+        if (!known.contains({ it.key().m_key, it.key().m_features.flags }))
+            entries.append({ it.key().m_key, it.key().m_features, it.value().first, it.value().second });
+    }
+    writeShaderManifest(m_manifestRecordFile, entries);
+}
+
+// A shader bake running on a worker thread. Whoever claims it first runs it:
+// the worker, or the render thread when it needs the result right away.
+// Everything but claimed, done and finished is owned by that thread until done
+// is set.
+struct QSSGShaderCache::PendingBake
+{
+    void run();
+    void wait();
+
+    // As passed to compileForRhi(), compared on pick-up in case a manifest
+    // from a different version was prewarmed.
+    QByteArray vertexSource;
+    QByteArray fragmentSource;
+    QByteArray vertexCode;
+    QByteArray fragmentCode;
+    QShader vertexShader;
+    QShader fragmentShader;
+    QString vertErr;
+    QString fragErr;
+    qint64 bakeTimeUs = 0;
+    QSharedPointer<QShaderBaker> baker;
+    QAtomicInt claimed;
+    QAtomicInt done;
+    QSemaphore finished;
+    // render thread only
+    bool requested = false; // false for bakes only started by prewarm()
+    bool prewarmed = false;
+    bool doneReported = false;
+};
 
 QSSGShaderCache::QSSGShaderCache(const QSSGRef<QSSGRhiContext> &ctx,
                                  const InitBakerFunc initBakeFn)
     : m_rhiContext(ctx)
     , m_initBaker(initBakeFn ? initBakeFn : &initBaker)
+    , m_asyncBaking(!initBakeFn
+                    && qEnvironmentVariableIntValue("QT_QUICK3D_ASYNC_SHADER_BAKING")
+                    && !QSSGRhiContext::editorMode()
+                    && !QSSGRhiContext::shaderDebuggingEnabled())
+    , m_manifestRecordFile(initBakeFn ? QString() : qEnvironmentVariable("QT_QUICK3D_RECORD_SHADER_MANIFEST"))
+{
+}
+
+bool QSSGShaderCache::hasPendingBakes()
 {
+    bool pending = false;
+    for (const QSharedPointer<PendingBake> &bake : std::as_const(m_pendingBakes)) {
+        // Nothing is waiting for the ones started ahead of time.
+        if (!bake->requested)
+            continue;
+        if (!bake->done.loadAcquire()) {
+            pending = true;
+        } else if (!bake->doneReported) {
+            // One more frame for the renderables waiting for it to pick the
+            // shaders up. Bakes nobody asks for anymore stay around until
+            // they are needed again.
+            bake->doneReported = true;
+            pending = true;
+        }
+    }
+    return pending;
+}
+
+QSSGShaderDiskCache *QSSGShaderCache::diskCache()
+{
+    if (m_diskCacheInitialized)
+        return m_diskCache.data();
+    m_diskCacheInitialized = true;
+
+    // Only the default baker setup is known to produce what the file name
+    // below describes. Shaders meant for debugging or the editor are not kept.
+    QRhi *rhi = m_rhiContext->rhi();
+    if (!rhi || m_initBaker != &initBaker || QSSGRhiContext::editorMode() || QSSGRhiContext::shaderDebuggingEnabled()
+            || qEnvironmentVariableIntValue("QT_QUICK3D_DISABLE_SHADER_DISK_CACHE"))
+        return nullptr;
+
+    QString dir = qEnvironmentVariable("QT_QUICK3D_SHADER_DISK_CACHE_DIR");
+    if (dir.isEmpty()) {
+        dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+        if (dir.isEmpty())
+            return nullptr;
+        dir += QLatin1String("/qtquick3d/shaders");
+    }
+
+    // What the baker generates depends on the Qt version, the backend and,
+    // for OpenGL, the context. Keep a separate file for each combination.
+    const QRhiDriverInfo driverInfo = rhi->driverInfo();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArrayLiteral(QT_VERSION_STR));
+    hash.addData(rhi->backendName());
+    hash.addData(driverInfo.deviceName);
+    hash.addData(QByteArray::number(driverInfo.deviceId));
+    hash.addData(QByteArray::number(driverInfo.vendorId));
+    const QString fileName = QLatin1String("qtquick3d-") + QString::fromLatin1(hash.result().toHex().left(16))
+            + QLatin1String(".qsbc");
+
+    const int sizeLimitKb = qEnvironmentVariableIsSet("QT_QUICK3D_SHADER_DISK_CACHE_SIZE")
+            ? qEnvironmentVariableIntValue("QT_QUICK3D_SHADER_DISK_CACHE_SIZE")
+            : 32 * 1024;
+    if (sizeLimitKb <= 0)
+        return nullptr;
+
+    m_diskCache.reset(new QSSGShaderDiskCache(dir + QLatin1Char('/') + fileName, qint64(sizeLimitKb) * 1024));
+    return m_diskCache.data();
 }
 
 QSSGRef<QSSGRhiShaderPipeline> QSSGShaderCache::getRhiShaderPipeline(const QByteArray &inKey,
@@ -252,10 +636,103 @@ QByteArray QSSGShaderCache::shaderCollectionFile()
     return QByteArrayLiteral("qtappshaders.qsbc");
 }
 
+#ifdef QT_QUICK3D_HAS_RUNTIME_SHADERS
+void QSSGShaderCache::PendingBake::run()
+{
+    if (!claimed.testAndSetAcquire(0, 1))
+        return;
+    QElapsedTimer bakeTimer;
+    bakeTimer.start();
+    baker->setSourceString(vertexCode, QShader::VertexStage);
+    vertexShader = baker->bake();
+    if (!vertexShader.isValid())
+        vertErr = baker->errorMessage();
+    baker->setSourceString(fragmentCode, QShader::FragmentStage);
+    fragmentShader = baker->bake();
+    if (!fragmentShader.isValid())
+        fragErr = baker->errorMessage();
+    bakeTimeUs = bakeTimer.nsecsElapsed() / 1000;
+    baker.reset();
+    done.storeRelease(1);
+    finished.release();
+}
+
+// Runs the bake on the calling thread when no worker has picked it up yet,
+// waits for the worker otherwise.
+void QSSGShaderCache::PendingBake::wait()
+{
+    if (done.loadAcquire())
+        return;
+    run();
+    if (!done.loadAcquire()) {
+        finished.acquire();
+        finished.release();
+    }
+}
+
+// Bakes m_vertexCode and m_fragmentCode, the preprocessed sources, on a
+// worker thread.
+QSharedPointer<QSSGShaderCache::PendingBake> QSSGShaderCache::startBake(const QSSGShaderCacheKey &key,
+                                                                      const QByteArray &vertexSource,
+                                                                      const QByteArray &fragmentSource)
+{
+    QSharedPointer<PendingBake> bake(new PendingBake);
+    bake->vertexSource = vertexSource;
+    bake->fragmentSource = fragmentSource;
+    bake->vertexCode = m_vertexCode;
+    bake->fragmentCode = m_fragmentCode;
+    m_pendingBakes.insert(key, bake);
+    // The baker is set up here, the setup may query the QRhi.
+    bake->baker.reset(new QShaderBaker);
+    m_initBaker(bake->baker.data(), m_rhiContext->rhi());
+    QThreadPool::globalInstance()->start([bake]() { bake->run(); });
+    return bake;
+}
+#endif
+
+int QSSGShaderCache::prewarm(const QString &manifestFile)
+{
+#ifdef QT_QUICK3D_HAS_RUNTIME_SHADERS
+    int started = 0;
+    const QVector<QSSGShaderManifestEntry> entries = readShaderManifest(manifestFile);
+    for (const QSSGShaderManifestEntry &entry : entries) {
+        QSSGShaderCacheKey key(entry.key);
+        key.m_features = entry.features;
+        key.updateHashCode();
+        if (m_rhiShaders.contains(key) || m_pendingBakes.contains(key))
+            continue;
+        // Loading from the disk cache is cheap enough to be left for when the
+        // shaders are needed.
+        QSSGShaderDiskCache *shaderDiskCache = key.m_hashCode ? diskCache() : nullptr;
+        if (shaderDiskCache && shaderDiskCache->contains(key.m_hashCode))
+            continue;
+
+        m_vertexCode = entry.vertexSource;
+        m_fragmentCode = entry.fragmentSource;
+        if (!m_vertexCode.isEmpty())
+            addShaderPreprocessor(m_vertexCode, entry.key, ShaderType::Vertex, entry.features);
+        if (!m_fragmentCode.isEmpty())
+            addShaderPreprocessor(m_fragmentCode, entry.key, ShaderType::Fragment, entry.features);
+        startBake(key, entry.vertexSource, entry.fragmentSource)->prewarmed = true;
+        ++started;
+    }
+    if (started)
+        qCDebug(PERF_INFO, "Prewarming %d shaders from %s", started, qPrintable(manifestFile));
+    return started;
+#else
+    Q_UNUSED(manifestFile);
+    return 0;
+#endif
+}
+
 QSSGRef<QSSGRhiShaderPipeline> QSSGShaderCache::compileForRhi(const QByteArray &inKey, const QByteArray &inVert, const QByteArray &inFrag,
-                                                              const QSSGShaderFeatures &inFeatures, QSSGRhiShaderPipeline::StageFlags stageFlags)
+                                                              const QSSGShaderFeatures &inFeatures, QSSGRhiShaderPipeline::StageFlags stageFlags,
+                                                              bool *deferred)
 {
 #ifdef QT_QUICK3D_HAS_RUNTIME_SHADERS
+    if (deferred)
+        *deferred = false;
+
     const QSSGRef<QSSGRhiShaderPipeline> &rhiShaders = getRhiShaderPipeline(inKey, inFeatures);
     if (rhiShaders)
         return rhiShaders;
@@ -264,6 +741,77 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGShaderCache::compileForRhi(const QByteArray &
     tempKey.m_features = inFeatures;
     tempKey.updateHashCode();
 
+    if (!m_manifestRecordFile.isEmpty() && !m_recordedShaders.contains(tempKey))
+        m_recordedShaders.insert(tempKey, { inVert, inFrag });
+
+    auto pendingIt = m_pendingBakes.find(tempKey);
+    if (pendingIt != m_pendingBakes.end()
+            && (pendingIt.value()->vertexSource != inVert || pendingIt.value()->fragmentSource != inFrag)) {
+        m_pendingBakes.erase(pendingIt);
+        pendingIt = m_pendingBakes.end();
+    }
+    if (pendingIt != m_pendingBakes.end() && !pendingIt.value()->done.loadAcquire()) {
+        if (deferred && m_asyncBaking) {
+            pendingIt.value()->requested = true;
+            *deferred = true;
+            return {};
+        }
+        // Started by prewarm(), and the caller needs the shaders now. Still
+        // cheaper than starting over: the bake is run right here when no
+        // worker has picked it up yet.
+        pendingIt.value()->wait();
+    }
+    if (pendingIt != m_pendingBakes.end()) {
+        const QSharedPointer<PendingBake> bake = pendingIt.value();
+        m_pendingBakes.erase(pendingIt);
+        if (bake->prewarmed)
+            m_stats.prewarmHitCount += 1;
+
+        QSSGRef<QSSGRhiShaderPipeline> shaders;
+        if (bake->vertexShader.isValid() && bake->fragmentShader.isValid()) {
+            shaders = new QSSGRhiShaderPipeline(*m_rhiContext.data());
+            shaders->addStage(QRhiShaderStage(QRhiShaderStage::Vertex, bake->vertexShader), stageFlags);
+            shaders->addStage(QRhiShaderStage(QRhiShaderStage::Fragment, bake->fragmentShader), stageFlags);
+            if (QSSGShaderDiskCache *shaderDiskCache = tempKey.m_hashCode ? diskCache() : nullptr) {
+                shaderDiskCache->store(tempKey.m_hashCode, QByteArray::number(inFeatures.flags) + ' ' + inKey,
+                                       bake->vertexShader, bake->fragmentShader, bake->bakeTimeUs);
+            }
+        } else {
+            if (!bake->vertErr.isEmpty()) {
+                qWarning("Failed to compile vertex shader:\n");
+                qWarning() << inKey << '\n' << bake->vertErr;
+            }
+            if (!bake->fragErr.isEmpty()) {
+                qWarning("Failed to compile fragment shader \n");
+                qWarning() << inKey << '\n' << bake->fragErr;
+            }
+        }
+        const auto inserted = m_rhiShaders.insert(tempKey, shaders);
+        return inserted.value();
+    }
+
+    // The stage flags are not part of the shaders, and so not of the identity.
+    QSSGShaderDiskCache *shaderDiskCache = tempKey.m_hashCode ? diskCache() : nullptr;
+    const QByteArray diskCacheIdentity = shaderDiskCache ? QByteArray::number(inFeatures.flags) + ' ' + inKey : QByteArray();
+    if (shaderDiskCache) {
+        QShader vertexShader;
+        QShader fragmentShader;
+        qint64 bakeTimeUs = 0;
+        if (shaderDiskCache->load(tempKey.m_hashCode, diskCacheIdentity, &vertexShader, &fragmentShader, &bakeTimeUs)) {
+            m_stats.diskCacheHitCount += 1;
+            m_stats.diskCacheTimeSaved += bakeTimeUs / 1000.0f;
+            QSSGRef<QSSGRhiShaderPipeline> shaders(new QSSGRhiShaderPipeline(*m_rhiContext.data()));
+            shaders->addStage(QRhiShaderStage(QRhiShaderStage::Vertex, vertexShader), stageFlags);
+            shaders->addStage(QRhiShaderStage(QRhiShaderStage::Fragment, fragmentShader), stageFlags);
+            const auto inserted = m_rhiShaders.insert(tempKey, shaders);
+            return inserted.value();
+        }
+        m_stats.diskCacheMissCount += 1;
+    }
+
+    QElapsedTimer bakeTimer;
+    bakeTimer.start();
+
     m_vertexCode = inVert;
     m_fragmentCode = inFrag;
 
@@ -275,6 +823,12 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGShaderCache::compileForRhi(const QByteArray &
 
     // lo and behold the final shader strings are ready
 
+    if (deferred && m_asyncBaking) {
+        startBake(tempKey, inVert, inFrag)->requested = true;
+        *deferred = true;
+        return {};
+    }
+
     QSSGRef<QSSGRhiShaderPipeline> shaders;
     QString vertErr, fragErr;
 
@@ -352,6 +906,8 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGShaderCache::compileForRhi(const QByteArray &
         shaders->addStage(QRhiShaderStage(QRhiShaderStage::Fragment, fragmentShader), stageFlags);
         if (shaderDebug)
             qDebug("Compilation for vertex and fragment stages succeeded");
+        if (shaderDiskCache)
+            shaderDiskCache->store(tempKey.m_hashCode, diskCacheIdentity, vertexShader, fragmentShader, bakeTimer.nsecsElapsed() / 1000);
     }
 
     if (editorMode && s_statusCallback) {
@@ -372,6 +928,8 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGShaderCache::compileForRhi(const QByteArray &
     Q_UNUSED(inFrag);
     Q_UNUSED(inFeatures);
     Q_UNUSED(stageFlags);
+    if (deferred)
+        *deferred = false;
     qWarning("Cannot compile and condition shaders at runtime because this build of Qt Quick 3D is not linking to Qt Shader Tools. "
              "Only pre-processed materials are supported.");
     return {};
@@ -51,11 +51,13 @@
 #include <QtCore/QString>
 #include <QtCore/qcryptographichash.h>
 #include <QtCore/QSharedPointer>
+#include <QtCore/QScopedPointer>
 #include <QtCore/QVector>
 
 QT_BEGIN_NAMESPACE
 
 class QSSGRhiShaderPipeline;
+class QSSGShaderDiskCache;
 class QShaderBaker;
 class QRhi;
 
@@ -166,6 +168,18 @@ struct QSSGShaderCacheKey
     }
 };
 
+// Counters of the persistent shader cache, accumulated over the lifetime of
+// the QSSGShaderCache.
+struct QSSGShaderCacheStats
+{
+    int diskCacheHitCount = 0;
+    int diskCacheMissCount = 0;
+    // Time the shaders loaded from disk took to bake originally, in milliseconds.
+    float diskCacheTimeSaved = 0.0f;
+    // Shaders taken from the bakes started by prewarm().
+    int prewarmHitCount = 0;
+};
+
 class Q_QUICK3DRUNTIMERENDER_EXPORT QSSGShaderCache
 {
 public:
@@ -190,6 +204,18 @@ private:
     QString m_contextTypeString;
     QSSGShaderCacheKey m_tempKey;
     const InitBakerFunc m_initBaker;
+    QScopedPointer<QSSGShaderDiskCache> m_diskCache;
+    bool m_diskCacheInitialized = false;
+    QSSGShaderCacheStats m_stats;
+    struct PendingBake;
+    QHash<QSSGShaderCacheKey, QSharedPointer<PendingBake>> m_pendingBakes;
+    const bool m_asyncBaking;
+    // Sources of the shaders compiled in this run, when recording a manifest.
+    QString m_manifestRecordFile;
+    QHash<QSSGShaderCacheKey, QPair<QByteArray, QByteArray>> m_recordedShaders;
+
+    QSSGShaderDiskCache *diskCache();
+    QSharedPointer<PendingBake> startBake(const QSSGShaderCacheKey &key, const QByteArray &vertexSource, const QByteArray &fragmentSource);
 
     void addShaderPreprocessor(QByteArray &str,
                                const QByteArray &inKey,
@@ -204,15 +230,34 @@ public:
     QSSGRef<QSSGRhiShaderPipeline> getRhiShaderPipeline(const QByteArray &inKey,
                                                         const QSSGShaderFeatures &inFeatures);
 
+    // With a non-null deferred, and asynchronous baking enabled, the baking
+    // may be done on a worker thread. *deferred is then set to true and null
+    // is returned; calling again with the same key and sources in a later
+    // frame returns the shaders once they are ready.
     QSSGRef<QSSGRhiShaderPipeline> compileForRhi(const QByteArray &inKey,
                                                const QByteArray &inVert,
                                                const QByteArray &inFrag,
                                                const QSSGShaderFeatures &inFeatures,
-                                               QSSGRhiShaderPipeline::StageFlags stageFlags);
+                                               QSSGRhiShaderPipeline::StageFlags stageFlags,
+                                               bool *deferred = nullptr);
+
+    // True while deferred shaders are being baked, or were finished since the
+    // last call and have not been picked up yet.
+    bool hasPendingBakes();
+
+    // Starts baking the shaders recorded in a manifest on worker threads,
+    // unless they are already available. Returns the number of bakes started.
+    // compileForRhi() waits for the ones that are not finished when needed,
+    // unless it can defer.
+    // Manifests are recorded by setting QT_QUICK3D_RECORD_SHADER_MANIFEST to
+    // a file name: all material shaders compiled in the run are added to it.
+    int prewarm(const QString &manifestFile);
 
     QSSGRef<QSSGRhiShaderPipeline> loadGeneratedShader(const QByteArray &inKey, QQsbCollection::Entry entry);
     QSSGRef<QSSGRhiShaderPipeline> loadBuiltinForRhi(const QByteArray &inKey);
 
+    const QSSGShaderCacheStats &stats() const { return m_stats; }
+
     static QByteArray resourceFolder();
     static QByteArray shaderCollectionFile();
 };
@@ -457,7 +457,8 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGProgramGenerator::compileGeneratedRhiShader(c
                                                                                const QSSGShaderFeatures &inFeatureSet,
                                                                                const QSSGRef<QSSGShaderLibraryManager> &shaderLibraryManager,
                                                                                const QSSGRef<QSSGShaderCache> &theCache,
-                                                                               QSSGRhiShaderPipeline::StageFlags stageFlags)
+                                                                               QSSGRhiShaderPipeline::StageFlags stageFlags,
+                                                                               bool *deferred)
 {
     // No stages enabled
     if (((quint32)m_enabledStages) == 0) {
@@ -499,7 +500,8 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGProgramGenerator::compileGeneratedRhiShader(c
                                    m_vs.m_finalBuilder,
                                    m_fs.m_finalBuilder,
                                    inFeatureSet,
-                                   stageFlags);
+                                   stageFlags,
+                                   deferred);
 }
 
 QSSGVertexShaderGenerator::QSSGVertexShaderGenerator()
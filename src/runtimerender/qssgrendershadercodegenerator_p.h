@@ -192,7 +192,8 @@ struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGProgramGenerator
                                                              const QSSGShaderFeatures &inFeatureSet,
                                                              const QSSGRef<QSSGShaderLibraryManager> &shaderLibraryManager,
                                                              const QSSGRef<QSSGShaderCache> &theCache,
-                                                             QSSGRhiShaderPipeline::StageFlags stageFlags);
+                                                             QSSGRhiShaderPipeline::StageFlags stageFlags,
+                                                             bool *deferred = nullptr);
 };
 
 QT_END_NAMESPACE
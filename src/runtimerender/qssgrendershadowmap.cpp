@@ -33,6 +33,10 @@
 #include <QtQuick3DRuntimeRender/private/qssgrendererimpllayerrenderdata_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrendercontextcore_p.h>
 
+#include <QtCore/qmath.h>
+
+#include <algorithm>
+
 QT_BEGIN_NAMESPACE
 
 QSSGRenderShadowMap::QSSGRenderShadowMap(const QSSGRenderContextInterface &inContext)
@@ -46,6 +50,11 @@ QSSGRenderShadowMap::~QSSGRenderShadowMap()
         entry.destroyRhiResources();
 
     m_shadowMapList.clear();
+
+    m_atlas.reset();
+    for (CubeScratch &scratch : m_cubeScratch)
+        scratch.reset();
+    m_cubeScratch.clear();
 }
 
 static QRhiTexture *allocateRhiTexture(QRhi *rhi,
@@ -69,41 +78,345 @@ static QRhiRenderBuffer *allocateRhiRenderBuffer(QRhi *rhi,
     return renderBuffer;
 }
 
-static inline void setupForRhiDepthCube(QRhi *rhi,
-                                        QSSGShadowMapEntry *entry,
-                                        const QSize &size,
-                                        QRhiTexture::Format format)
+static QRhiTexture::Format shadowMapFormat(QRhi *rhi)
+{
+    QRhiTexture::Format rhiFormat = QRhiTexture::R16F;
+    if (!rhi->isTextureFormatSupported(rhiFormat))
+        rhiFormat = QRhiTexture::R16;
+    return rhiFormat;
+}
+
+// Unused texels around each tile of the atlas, so that filtering and blurring
+// do not pick up the neighbouring shadow maps.
+static const int AtlasTileBorder = 4;
+// Maps are not made smaller than this to fit the budget.
+static const int MinShadowMapSize = 64;
+
+// Tiles are power-of-two squares. Placing them from the largest to the
+// smallest along a Z-order curve packs them without gaps into any
+// power-of-two square with enough area.
+static QPoint atlasTilePosition(quint64 areaBefore, int tileSize)
+{
+    quint64 index = areaBefore / (quint64(tileSize) * quint64(tileSize));
+    int x = 0;
+    int y = 0;
+    for (int bit = 0; index; ++bit, index >>= 2) {
+        x |= int(index & 1) << bit;
+        y |= int((index >> 1) & 1) << bit;
+    }
+    return QPoint(x * tileSize, y * tileSize);
+}
+
+// Each cascade's map is smaller than the previous one by the light's scale,
+// rounded down to a power of two.
+static int cascadeSize(const QSSGShadowMapRequest &request, int cascade)
+{
+    float size = float(request.size);
+    for (int i = 0; i < cascade; ++i)
+        size *= request.cascadeResolutionScale;
+    int pow2 = request.size;
+    while (pow2 > MinShadowMapSize && float(pow2) > size)
+        pow2 /= 2;
+    return pow2;
+}
+
+static int atlasTileCount(const QVector<QSSGShadowMapRequest> &requests)
+{
+    int count = 0;
+    for (const QSSGShadowMapRequest &request : requests) {
+        if (request.mode == ShadowMapModes::VSM)
+            count += request.cascadeCount;
+    }
+    return count;
+}
+
+static int atlasSize(const QVector<QSSGShadowMapRequest> &requests)
+{
+    int size = 0;
+    quint64 area = 0;
+    for (const QSSGShadowMapRequest &request : requests) {
+        if (request.mode == ShadowMapModes::VSM) {
+            for (int cascade = 0; cascade < request.cascadeCount; ++cascade) {
+                const int tileSize = cascadeSize(request, cascade);
+                size = qMax(size, tileSize);
+                area += quint64(tileSize) * quint64(tileSize);
+            }
+        }
+    }
+    while (quint64(size) * quint64(size) < area)
+        size *= 2;
+    return size;
+}
+
+// 2 bytes per texel for the R16(F) maps and their blur copies, 4 for depth-stencil
+static quint64 estimatedMemory(const QVector<QSSGShadowMapRequest> &requests)
+{
+    const quint64 atlas = atlasSize(requests);
+    quint64 bytes = atlas * atlas * (2 + 2 + 4);
+    QVarLengthArray<int, 8> cubeSizes;
+    for (const QSSGShadowMapRequest &request : requests) {
+        if (request.mode == ShadowMapModes::CUBE) {
+            const quint64 faceTexels = quint64(request.size) * quint64(request.size);
+            bytes += 6 * faceTexels * 2;
+            if (!cubeSizes.contains(request.size)) {
+                cubeSizes.append(request.size);
+                bytes += 6 * faceTexels * 2 + faceTexels * 4;
+            }
+        }
+    }
+    return bytes;
+}
+
+static quint64 shadowMapBudget()
 {
-    entry->m_rhiDepthCube = allocateRhiTexture(rhi, format, size, QRhiTexture::RenderTarget | QRhiTexture::CubeMap);
-    entry->m_rhiCubeCopy = allocateRhiTexture(rhi, format, size, QRhiTexture::RenderTarget | QRhiTexture::CubeMap);
-    entry->m_rhiDepthStencil = allocateRhiRenderBuffer(rhi, QRhiRenderBuffer::DepthStencil, size);
+    static const quint64 budget = quint64(qMax(0, qEnvironmentVariableIntValue("QT_QUICK3D_SHADOW_MAP_BUDGET"))) * 1024 * 1024;
+    return budget;
 }
 
-static inline void setupForRhiDepth(QRhi *rhi,
-                                    QSSGShadowMapEntry *entry,
-                                    const QSize &size,
-                                    QRhiTexture::Format format)
+void QSSGRenderShadowMap::computeCascadeSplits(float clipNear, float clipFar, float shadowMapFar, float splitBlend,
+                                               int cascadeCount, float *splits)
 {
-    entry->m_rhiDepthMap = allocateRhiTexture(rhi, format, size, QRhiTexture::RenderTarget);
-    entry->m_rhiDepthCopy = allocateRhiTexture(rhi, format, size, QRhiTexture::RenderTarget);
-    entry->m_rhiDepthStencil = allocateRhiRenderBuffer(rhi, QRhiRenderBuffer::DepthStencil, size);
+    clipNear = qMax(clipNear, 0.001f);
+    const float cameraFar = clipFar;
+    clipFar = qMin(clipFar, shadowMapFar);
+    if (clipFar <= clipNear)
+        clipFar = cameraFar;
+    const float blend = qBound(0.0f, splitBlend, 1.0f);
+    for (int i = 1; i < cascadeCount; ++i) {
+        const float f = float(i) / cascadeCount;
+        const float logSplit = clipNear * qPow(clipFar / clipNear, f);
+        const float uniformSplit = clipNear + (clipFar - clipNear) * f;
+        splits[i - 1] = blend * logSplit + (1.0f - blend) * uniformSplit;
+    }
+    splits[cascadeCount - 1] = clipFar;
 }
 
-void QSSGRenderShadowMap::addShadowMapEntry(qint32 lightIdx,
-                                            qint32 width,
-                                            qint32 height,
-                                            ShadowMapModes mode)
+void QSSGRenderShadowMap::updateShadowMapEntries(QVector<QSSGShadowMapRequest> requests)
 {
     QRhi *rhi = m_context.rhiContext()->rhi();
     // Bail out if there is no QRhi, since we can't add entries without it
     if (!rhi)
         return;
 
-    const QSize pixelSize(width, height);
+    // The shadow pass has per-tile resources for a fixed number of tiles, so
+    // drop cascades, starting with the lights that have the most.
+    while (atlasTileCount(requests) > QSSG_MAX_NUM_SHADOW_MAPS) {
+        QSSGShadowMapRequest *mostCascades = nullptr;
+        for (QSSGShadowMapRequest &request : requests) {
+            if (request.mode == ShadowMapModes::VSM && (!mostCascades || request.cascadeCount > mostCascades->cascadeCount))
+                mostCascades = &request;
+        }
+        if (mostCascades->cascadeCount == 1)
+            break; // more lights than tiles, left to the caller
+        --mostCascades->cascadeCount;
+    }
 
-    QRhiTexture::Format rhiFormat = QRhiTexture::R16F;
-    if (!rhi->isTextureFormatSupported(rhiFormat))
-        rhiFormat = QRhiTexture::R16;
+    // Halve the least important map until everything fits.
+    const quint64 budget = shadowMapBudget();
+    const int maxTextureSize = rhi->resourceLimit(QRhi::TextureSizeMax);
+    for (;;) {
+        const bool overBudget = budget > 0 && estimatedMemory(requests) > budget;
+        const bool atlasTooLarge = atlasSize(requests) > maxTextureSize;
+        if (!overBudget && !atlasTooLarge)
+            break;
+        int victim = -1;
+        for (int i = 0; i < requests.count(); ++i) {
+            const QSSGShadowMapRequest &request(requests[i]);
+            if (request.size <= MinShadowMapSize)
+                continue;
+            if (!overBudget && request.mode != ShadowMapModes::VSM)
+                continue;
+            if (victim < 0 || request.importance < requests[victim].importance)
+                victim = i;
+        }
+        if (victim < 0)
+            break;
+        requests[victim].size /= 2;
+    }
+
+    // Entries of lights that do not cast shadows anymore go away.
+    for (int i = m_shadowMapList.count() - 1; i >= 0; --i) {
+        const quint32 lightIdx = m_shadowMapList[i].m_lightIndex;
+        const bool requested = std::any_of(requests.cbegin(), requests.cend(),
+                                           [lightIdx](const QSSGShadowMapRequest &request) { return quint32(request.lightIdx) == lightIdx; });
+        if (!requested) {
+            m_shadowMapList[i].destroyRhiResources();
+            m_shadowMapList.remove(i);
+        }
+    }
+
+    // The atlas, with the tiles laid out from the largest to the smallest.
+    struct Tile {
+        const QSSGShadowMapRequest *request;
+        int cascade;
+        int size;
+    };
+    QVarLengthArray<Tile, QSSG_MAX_NUM_SHADOW_MAPS> tiles;
+    for (const QSSGShadowMapRequest &request : qAsConst(requests)) {
+        if (request.mode == ShadowMapModes::VSM) {
+            for (int cascade = 0; cascade < request.cascadeCount; ++cascade)
+                tiles.append({ &request, cascade, cascadeSize(request, cascade) });
+        }
+    }
+    std::stable_sort(tiles.begin(), tiles.end(), [](const Tile &a, const Tile &b) {
+        return a.size > b.size;
+    });
+    if (tiles.isEmpty() || !ensureAtlas(atlasSize(requests)))
+        m_atlas.reset();
+
+    quint64 areaBefore = 0;
+    for (const Tile &tile : qAsConst(tiles)) {
+        const QSSGShadowMapRequest *request = tile.request;
+        const QPoint pos = atlasTilePosition(areaBefore, tile.size);
+        areaBefore += quint64(tile.size) * quint64(tile.size);
+        if (m_atlas.texture) {
+            addAtlasShadowMapEntry(request->lightIdx, request->cascadeCount, tile.cascade, QRect(pos, QSize(tile.size, tile.size))
+                                   .adjusted(AtlasTileBorder, AtlasTileBorder, -AtlasTileBorder, -AtlasTileBorder));
+        } else if (QSSGShadowMapEntry *pEntry = shadowMapEntry(request->lightIdx)) {
+            // no atlas, no shadows for this light
+            pEntry->destroyRhiResources();
+            m_shadowMapList.remove(int(pEntry - m_shadowMapList.data()));
+        }
+    }
+
+    for (const QSSGShadowMapRequest &request : qAsConst(requests)) {
+        if (request.mode == ShadowMapModes::CUBE)
+            addCubeShadowMapEntry(request.lightIdx, request.size);
+    }
+
+    // Scratch resources of sizes no cube map uses anymore
+    for (auto it = m_cubeScratch.begin(); it != m_cubeScratch.end(); ) {
+        const int size = it.key();
+        const bool used = std::any_of(m_shadowMapList.cbegin(), m_shadowMapList.cend(), [size](const QSSGShadowMapEntry &entry) {
+            return entry.m_rhiDepthCube && entry.m_rhiDepthCube->pixelSize().width() == size;
+        });
+        if (used) {
+            ++it;
+        } else {
+            it->reset();
+            it = m_cubeScratch.erase(it);
+        }
+    }
+}
+
+bool QSSGRenderShadowMap::ensureAtlas(int size)
+{
+    const QSize pixelSize(size, size);
+    if (m_atlas.texture && m_atlas.texture->pixelSize() == pixelSize)
+        return true;
+
+    QRhi *rhi = m_context.rhiContext()->rhi();
+    const QRhiTexture::Format rhiFormat = shadowMapFormat(rhi);
+
+    // The entries refer to the old atlas, they get updated by the caller.
+    // Whatever was rendered before is gone.
+    m_atlas.reset();
+    for (QSSGShadowMapEntry &entry : m_shadowMapList) {
+        if (entry.m_inAtlas)
+            std::fill(std::begin(entry.m_renderedSignature), std::end(entry.m_renderedSignature), 0);
+    }
+    m_atlas.texture = allocateRhiTexture(rhi, rhiFormat, pixelSize, QRhiTexture::RenderTarget);
+    m_atlas.copy = allocateRhiTexture(rhi, rhiFormat, pixelSize, QRhiTexture::RenderTarget);
+    m_atlas.depthStencil = allocateRhiRenderBuffer(rhi, QRhiRenderBuffer::DepthStencil, pixelSize);
+
+    QRhiTextureRenderTargetDescription rtDesc;
+    rtDesc.setColorAttachments({ m_atlas.texture });
+    rtDesc.setDepthStencilBuffer(m_atlas.depthStencil);
+    m_atlas.renderTarget = rhi->newTextureRenderTarget(rtDesc);
+    m_atlas.renderPassDesc = m_atlas.renderTarget->newCompatibleRenderPassDescriptor();
+    m_atlas.renderTarget->setRenderPassDescriptor(m_atlas.renderPassDesc);
+    if (!m_atlas.renderTarget->create()) {
+        qWarning("Failed to build shadow map render target");
+        m_atlas.reset();
+        return false;
+    }
+
+    // blur X: texture -> copy
+    m_atlas.blurRenderTarget0 = rhi->newTextureRenderTarget({ m_atlas.copy });
+    m_atlas.blurRenderPassDesc = m_atlas.blurRenderTarget0->newCompatibleRenderPassDescriptor();
+    m_atlas.blurRenderTarget0->setRenderPassDescriptor(m_atlas.blurRenderPassDesc);
+    m_atlas.blurRenderTarget0->create();
+    // blur Y: copy -> texture
+    m_atlas.blurRenderTarget1 = rhi->newTextureRenderTarget({ m_atlas.texture });
+    m_atlas.blurRenderTarget1->setRenderPassDescriptor(m_atlas.blurRenderPassDesc);
+    m_atlas.blurRenderTarget1->create();
+
+    return true;
+}
+
+void QSSGRenderShadowMap::addAtlasShadowMapEntry(qint32 lightIdx, int cascadeCount, int cascade, const QRect &tile)
+{
+    QSSGShadowMapEntry *pEntry = shadowMapEntry(lightIdx);
+    if (pEntry && !pEntry->m_inAtlas) {
+        // previously CUBE now VSM
+        pEntry->destroyRhiResources();
+    } else if (!pEntry) {
+        m_shadowMapList.push_back(QSSGShadowMapEntry());
+        pEntry = &m_shadowMapList.back();
+    }
+
+    pEntry->m_lightIndex = lightIdx;
+    pEntry->m_shadowMapMode = ShadowMapModes::VSM;
+    pEntry->m_inAtlas = true;
+    pEntry->m_cascadeCount = cascadeCount;
+    pEntry->m_rhiDepthMap = m_atlas.texture;
+    pEntry->m_rhiDepthCopy = m_atlas.copy;
+    pEntry->m_rhiDepthStencil = m_atlas.depthStencil;
+    pEntry->m_rhiRenderTargets.resize(1);
+    pEntry->m_rhiRenderTargets[0] = m_atlas.renderTarget;
+    pEntry->m_rhiRenderPassDesc = m_atlas.renderPassDesc;
+    pEntry->m_rhiBlurRenderTarget0 = m_atlas.blurRenderTarget0;
+    pEntry->m_rhiBlurRenderTarget1 = m_atlas.blurRenderTarget1;
+    pEntry->m_rhiBlurRenderPassDesc = m_atlas.blurRenderPassDesc;
+
+    // Viewports have their origin at the bottom left, texture coordinates
+    // only when Y is up in the framebuffer.
+    const float atlasSize = m_atlas.texture->pixelSize().width();
+    pEntry->m_atlasRect[cascade] = tile;
+    const float v = m_context.rhiContext()->rhi()->isYUpInFramebuffer() ? tile.y() : atlasSize - tile.y() - tile.height();
+    pEntry->m_atlasUvRect[cascade] = QVector4D(tile.x() / atlasSize, v / atlasSize,
+                                               tile.width() / atlasSize, tile.height() / atlasSize);
+}
+
+QSSGRenderShadowMap::CubeScratch &QSSGRenderShadowMap::cubeScratch(int size)
+{
+    CubeScratch &scratch(m_cubeScratch[size]);
+    if (scratch.copy)
+        return scratch;
+
+    QRhi *rhi = m_context.rhiContext()->rhi();
+    const QSize pixelSize(size, size);
+    scratch.copy = allocateRhiTexture(rhi, shadowMapFormat(rhi), pixelSize, QRhiTexture::RenderTarget | QRhiTexture::CubeMap);
+    scratch.depthStencil = allocateRhiRenderBuffer(rhi, QRhiRenderBuffer::DepthStencil, pixelSize);
+
+    // blurring cubemap happens via multiple render targets (all faces attached to COLOR0..5)
+    if (rhi->resourceLimit(QRhi::MaxColorAttachments) >= 6) {
+        // blur X: depthCube -> cubeCopy
+        QRhiColorAttachment att[6];
+        for (int face = 0; face < 6; ++face) {
+            att[face].setTexture(scratch.copy);
+            att[face].setLayer(face);
+        }
+        QRhiTextureRenderTargetDescription rtDesc;
+        rtDesc.setColorAttachments(att, att + 6);
+        scratch.blurRenderTarget0 = rhi->newTextureRenderTarget(rtDesc);
+        scratch.blurRenderPassDesc = scratch.blurRenderTarget0->newCompatibleRenderPassDescriptor();
+        scratch.blurRenderTarget0->setRenderPassDescriptor(scratch.blurRenderPassDesc);
+        scratch.blurRenderTarget0->create();
+    } else {
+        static bool warned = false;
+        if (!warned) {
+            warned = true;
+            qWarning("Cubemap-based shadow maps will not be blurred because MaxColorAttachments is less than 6");
+        }
+    }
+    return scratch;
+}
+
+void QSSGRenderShadowMap::addCubeShadowMapEntry(qint32 lightIdx, qint32 size)
+{
+    QRhi *rhi = m_context.rhiContext()->rhi();
+    const QSize pixelSize(size, size);
 
     // This function is called once per shadow casting light on every layer
     // prepare (i.e. once per frame). We must avoid creating resources as much
@@ -112,150 +425,55 @@ void QSSGRenderShadowMap::addShadowMapEntry(qint32 lightIdx,
 
     QSSGShadowMapEntry *pEntry = shadowMapEntry(lightIdx);
     if (pEntry) {
-        if (pEntry->m_rhiDepthMap && mode == ShadowMapModes::CUBE) {
-            // previously VSM now CUBE
-            pEntry->destroyRhiResources();
-            setupForRhiDepthCube(rhi, pEntry, pixelSize, rhiFormat);
-        } else if (pEntry->m_rhiDepthCube && mode != ShadowMapModes::CUBE) {
-            // previously CUBE now VSM
+        // previously VSM, or CUBE with a different size
+        if (!pEntry->m_rhiDepthCube || pEntry->m_rhiDepthCube->pixelSize() != pixelSize)
             pEntry->destroyRhiResources();
-            setupForRhiDepth(rhi, pEntry, pixelSize, rhiFormat);
-        } else if (pEntry->m_rhiDepthMap) {
-            // VSM before and now, see if size has changed
-            if (pEntry->m_rhiDepthMap->pixelSize() != pixelSize) {
-                pEntry->destroyRhiResources();
-                setupForRhiDepth(rhi, pEntry, pixelSize, rhiFormat);
-            }
-        } else if (pEntry->m_rhiDepthCube) {
-            // CUBE before and now, see if size has changed
-            if (pEntry->m_rhiDepthCube->pixelSize() != pixelSize) {
-                pEntry->destroyRhiResources();
-                setupForRhiDepthCube(rhi, pEntry, pixelSize, rhiFormat);
-            }
-        }
-        pEntry->m_shadowMapMode = mode;
-    } else if (mode == ShadowMapModes::CUBE) {
-        QRhiTexture *depthMap = allocateRhiTexture(rhi, rhiFormat, pixelSize, QRhiTexture::RenderTarget | QRhiTexture::CubeMap);
-        QRhiTexture *depthCopy = allocateRhiTexture(rhi, rhiFormat, pixelSize, QRhiTexture::RenderTarget | QRhiTexture::CubeMap);
-        QRhiRenderBuffer *depthStencil = allocateRhiRenderBuffer(rhi, QRhiRenderBuffer::DepthStencil, pixelSize);
-        m_shadowMapList.push_back(QSSGShadowMapEntry::withRhiDepthCubeMap(lightIdx, mode, depthMap, depthCopy, depthStencil));
-
-        pEntry = &m_shadowMapList.back();
-    } else { // VSM
-        Q_ASSERT(mode == ShadowMapModes::VSM);
-        QRhiTexture *depthMap = allocateRhiTexture(rhi, rhiFormat, QSize(width, height), QRhiTexture::RenderTarget);
-        QRhiTexture *depthCopy = allocateRhiTexture(rhi, rhiFormat, QSize(width, height), QRhiTexture::RenderTarget);
-        QRhiRenderBuffer *depthStencil = allocateRhiRenderBuffer(rhi, QRhiRenderBuffer::DepthStencil, pixelSize);
-        m_shadowMapList.push_back(QSSGShadowMapEntry::withRhiDepthMap(lightIdx, mode, depthMap, depthCopy, depthStencil));
-
+    } else {
+        m_shadowMapList.push_back(QSSGShadowMapEntry());
         pEntry = &m_shadowMapList.back();
     }
 
-    if (pEntry) {
-        // Additional graphics resources: samplers, render targets.
-        if (mode == ShadowMapModes::VSM) {
-            if (pEntry->m_rhiRenderTargets.isEmpty()) {
-                pEntry->m_rhiRenderTargets.resize(1);
-                pEntry->m_rhiRenderTargets[0] = nullptr;
-            }
-            Q_ASSERT(pEntry->m_rhiRenderTargets.count() == 1);
-
-            QRhiTextureRenderTarget *&rt(pEntry->m_rhiRenderTargets[0]);
-            if (!rt) {
-                QRhiTextureRenderTargetDescription rtDesc;
-                rtDesc.setColorAttachments({ pEntry->m_rhiDepthMap });
-                rtDesc.setDepthStencilBuffer(pEntry->m_rhiDepthStencil);
-                rt = rhi->newTextureRenderTarget(rtDesc);
-                rt->setDescription(rtDesc);
-                // The same renderpass descriptor can be reused since the
-                // format, load/store ops are the same regardless of the shadow mode.
-                if (!pEntry->m_rhiRenderPassDesc)
-                    pEntry->m_rhiRenderPassDesc = rt->newCompatibleRenderPassDescriptor();
-                rt->setRenderPassDescriptor(pEntry->m_rhiRenderPassDesc);
-                if (!rt->create())
-                    qWarning("Failed to build shadow map render target");
-            }
+    pEntry->m_lightIndex = lightIdx;
+    pEntry->m_shadowMapMode = ShadowMapModes::CUBE;
+    if (pEntry->m_rhiDepthCube)
+        return;
 
-            if (!pEntry->m_rhiBlurRenderTarget0) {
-                // blur X: depthMap -> depthCopy
-                pEntry->m_rhiBlurRenderTarget0 = rhi->newTextureRenderTarget({ pEntry->m_rhiDepthCopy });
-                if (!pEntry->m_rhiBlurRenderPassDesc)
-                    pEntry->m_rhiBlurRenderPassDesc = pEntry->m_rhiBlurRenderTarget0->newCompatibleRenderPassDescriptor();
-                pEntry->m_rhiBlurRenderTarget0->setRenderPassDescriptor(pEntry->m_rhiBlurRenderPassDesc);
-                pEntry->m_rhiBlurRenderTarget0->create();
-            }
-            if (!pEntry->m_rhiBlurRenderTarget1) {
-                // blur Y: depthCopy -> depthMap
-                pEntry->m_rhiBlurRenderTarget1 = rhi->newTextureRenderTarget({ pEntry->m_rhiDepthMap });
-                pEntry->m_rhiBlurRenderTarget1->setRenderPassDescriptor(pEntry->m_rhiBlurRenderPassDesc);
-                pEntry->m_rhiBlurRenderTarget1->create();
-            }
-        } else {
-            if (pEntry->m_rhiRenderTargets.isEmpty()) {
-                pEntry->m_rhiRenderTargets.resize(6);
-                for (int i = 0; i < 6; ++i)
-                    pEntry->m_rhiRenderTargets[i] = nullptr;
-            }
-            Q_ASSERT(pEntry->m_rhiRenderTargets.count() == 6);
-
-            for (int face = 0; face < 6; ++face) {
-                QRhiTextureRenderTarget *&rt(pEntry->m_rhiRenderTargets[face]);
-                if (!rt) {
-                    QRhiColorAttachment att(pEntry->m_rhiDepthCube);
-                    att.setLayer(face); // 6 render targets, each referencing one face of the cubemap
-                    QRhiTextureRenderTargetDescription rtDesc;
-                    rtDesc.setColorAttachments({ att });
-                    rtDesc.setDepthStencilBuffer(pEntry->m_rhiDepthStencil);
-                    rt = rhi->newTextureRenderTarget(rtDesc);
-                    rt->setDescription(rtDesc);
-                    if (!pEntry->m_rhiRenderPassDesc)
-                        pEntry->m_rhiRenderPassDesc = rt->newCompatibleRenderPassDescriptor();
-                    rt->setRenderPassDescriptor(pEntry->m_rhiRenderPassDesc);
-                    if (!rt->create())
-                        qWarning("Failed to build shadow map render target");
-                }
-            }
+    const CubeScratch &scratch(cubeScratch(size));
+    pEntry->m_rhiDepthCube = allocateRhiTexture(rhi, shadowMapFormat(rhi), pixelSize, QRhiTexture::RenderTarget | QRhiTexture::CubeMap);
+    pEntry->m_rhiCubeCopy = scratch.copy;
+    pEntry->m_rhiDepthStencil = scratch.depthStencil;
+    pEntry->m_rhiBlurRenderTarget0 = scratch.blurRenderTarget0;
+    pEntry->m_rhiBlurRenderPassDesc = scratch.blurRenderPassDesc;
 
-            // blurring cubemap happens via multiple render targets (all faces attached to COLOR0..5)
-            if (rhi->resourceLimit(QRhi::MaxColorAttachments) >= 6) {
-                if (!pEntry->m_rhiBlurRenderTarget0) {
-                    // blur X: depthCube -> cubeCopy
-                    QRhiColorAttachment att[6];
-                    for (int face = 0; face < 6; ++face) {
-                        att[face].setTexture(pEntry->m_rhiCubeCopy);
-                        att[face].setLayer(face);
-                    }
-                    QRhiTextureRenderTargetDescription rtDesc;
-                    rtDesc.setColorAttachments(att, att + 6);
-                    pEntry->m_rhiBlurRenderTarget0 = rhi->newTextureRenderTarget(rtDesc);
-                    if (!pEntry->m_rhiBlurRenderPassDesc)
-                        pEntry->m_rhiBlurRenderPassDesc = pEntry->m_rhiBlurRenderTarget0->newCompatibleRenderPassDescriptor();
-                    pEntry->m_rhiBlurRenderTarget0->setRenderPassDescriptor(pEntry->m_rhiBlurRenderPassDesc);
-                    pEntry->m_rhiBlurRenderTarget0->create();
-                }
-                if (!pEntry->m_rhiBlurRenderTarget1) {
-                    // blur Y: cubeCopy -> depthCube
-                    QRhiColorAttachment att[6];
-                    for (int face = 0; face < 6; ++face) {
-                        att[face].setTexture(pEntry->m_rhiDepthCube);
-                        att[face].setLayer(face);
-                    }
-                    QRhiTextureRenderTargetDescription rtDesc;
-                    rtDesc.setColorAttachments(att, att + 6);
-                    pEntry->m_rhiBlurRenderTarget1 = rhi->newTextureRenderTarget(rtDesc);
-                    pEntry->m_rhiBlurRenderTarget1->setRenderPassDescriptor(pEntry->m_rhiBlurRenderPassDesc);
-                    pEntry->m_rhiBlurRenderTarget1->create();
-                }
-            } else {
-                static bool warned = false;
-                if (!warned) {
-                    warned = true;
-                    qWarning("Cubemap-based shadow maps will not be blurred because MaxColorAttachments is less than 6");
-                }
-            }
-        }
+    pEntry->m_rhiRenderTargets.resize(6);
+    for (int face = 0; face < 6; ++face) {
+        QRhiColorAttachment att(pEntry->m_rhiDepthCube);
+        att.setLayer(face); // 6 render targets, each referencing one face of the cubemap
+        QRhiTextureRenderTargetDescription rtDesc;
+        rtDesc.setColorAttachments({ att });
+        rtDesc.setDepthStencilBuffer(pEntry->m_rhiDepthStencil);
+        QRhiTextureRenderTarget *rt = rhi->newTextureRenderTarget(rtDesc);
+        rt->setDescription(rtDesc);
+        if (!pEntry->m_rhiRenderPassDesc)
+            pEntry->m_rhiRenderPassDesc = rt->newCompatibleRenderPassDescriptor();
+        rt->setRenderPassDescriptor(pEntry->m_rhiRenderPassDesc);
+        if (!rt->create())
+            qWarning("Failed to build shadow map render target");
+        pEntry->m_rhiRenderTargets[face] = rt;
+    }
 
-        pEntry->m_lightIndex = lightIdx;
+    if (pEntry->m_rhiBlurRenderPassDesc) {
+        // blur Y: cubeCopy -> depthCube
+        QRhiColorAttachment att[6];
+        for (int face = 0; face < 6; ++face) {
+            att[face].setTexture(pEntry->m_rhiDepthCube);
+            att[face].setLayer(face);
+        }
+        QRhiTextureRenderTargetDescription rtDesc;
+        rtDesc.setColorAttachments(att, att + 6);
+        pEntry->m_rhiBlurRenderTarget1 = rhi->newTextureRenderTarget(rtDesc);
+        pEntry->m_rhiBlurRenderTarget1->setRenderPassDescriptor(pEntry->m_rhiBlurRenderPassDesc);
+        pEntry->m_rhiBlurRenderTarget1->create();
     }
 }
 
@@ -278,59 +496,53 @@ QSSGShadowMapEntry::QSSGShadowMapEntry()
 {
 }
 
-QSSGShadowMapEntry QSSGShadowMapEntry::withRhiDepthMap(quint32 lightIdx,
-                                                       ShadowMapModes mode,
-                                                       QRhiTexture *depthMap,
-                                                       QRhiTexture *depthCopy,
-                                                       QRhiRenderBuffer *depthStencil)
-{
-    QSSGShadowMapEntry e;
-    e.m_lightIndex = lightIdx;
-    e.m_shadowMapMode = mode;
-    e.m_rhiDepthMap = depthMap;
-    e.m_rhiDepthCopy = depthCopy;
-    e.m_rhiDepthStencil = depthStencil;
-    return e;
-}
-
-QSSGShadowMapEntry QSSGShadowMapEntry::withRhiDepthCubeMap(quint32 lightIdx,
-                                                           ShadowMapModes mode,
-                                                           QRhiTexture *depthCube,
-                                                           QRhiTexture *cubeCopy,
-                                                           QRhiRenderBuffer *depthStencil)
-{
-    QSSGShadowMapEntry e;
-    e.m_lightIndex = lightIdx;
-    e.m_shadowMapMode = mode;
-    e.m_rhiDepthCube = depthCube;
-    e.m_rhiCubeCopy = cubeCopy;
-    e.m_rhiDepthStencil = depthStencil;
-    return e;
-}
-
 void QSSGShadowMapEntry::destroyRhiResources()
 {
-    delete m_rhiDepthMap;
+    // Only the cube map, its render targets and the blur Y target are owned
+    // by the entry, the rest is shared, see QSSGRenderShadowMap.
+    if (!m_inAtlas) {
+        delete m_rhiDepthCube;
+        qDeleteAll(m_rhiRenderTargets);
+        delete m_rhiRenderPassDesc;
+        delete m_rhiBlurRenderTarget1;
+    }
     m_rhiDepthMap = nullptr;
-    delete m_rhiDepthCopy;
     m_rhiDepthCopy = nullptr;
-    delete m_rhiDepthCube;
     m_rhiDepthCube = nullptr;
-    delete m_rhiCubeCopy;
     m_rhiCubeCopy = nullptr;
-    delete m_rhiDepthStencil;
     m_rhiDepthStencil = nullptr;
-
-    qDeleteAll(m_rhiRenderTargets);
     m_rhiRenderTargets.clear();
-    delete m_rhiRenderPassDesc;
     m_rhiRenderPassDesc = nullptr;
-    delete m_rhiBlurRenderTarget0;
     m_rhiBlurRenderTarget0 = nullptr;
-    delete m_rhiBlurRenderTarget1;
     m_rhiBlurRenderTarget1 = nullptr;
-    delete m_rhiBlurRenderPassDesc;
     m_rhiBlurRenderPassDesc = nullptr;
+    m_inAtlas = false;
+    m_cascadeCount = 0;
+    std::fill(std::begin(m_atlasRect), std::end(m_atlasRect), QRect());
+    std::fill(std::begin(m_atlasUvRect), std::end(m_atlasUvRect), QVector4D());
+    std::fill(std::begin(m_renderedSignature), std::end(m_renderedSignature), 0);
+}
+
+void QSSGRenderShadowMap::Atlas::reset()
+{
+    delete renderTarget;
+    delete renderPassDesc;
+    delete blurRenderTarget0;
+    delete blurRenderTarget1;
+    delete blurRenderPassDesc;
+    delete texture;
+    delete copy;
+    delete depthStencil;
+    *this = Atlas();
+}
+
+void QSSGRenderShadowMap::CubeScratch::reset()
+{
+    delete blurRenderTarget0;
+    delete blurRenderPassDesc;
+    delete copy;
+    delete depthStencil;
+    *this = CubeScratch();
 }
 
 QT_END_NAMESPACE
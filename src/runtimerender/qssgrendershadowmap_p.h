@@ -44,6 +44,10 @@
 
 #include <QtGui/QMatrix4x4>
 #include <QtGui/QVector3D>
+#include <QtGui/QVector4D>
+#include <QtCore/QRect>
+#include <QtCore/QHash>
+#include <QtQuick3DRuntimeRender/private/qtquick3druntimerenderglobal_p.h>
 #include <QtQuick3DUtils/private/qssgrenderbasetypes_p.h>
 
 QT_BEGIN_NAMESPACE
@@ -56,6 +60,8 @@ class QRhiTextureRenderTarget;
 class QRhiRenderPassDescriptor;
 class QRhiTexture;
 
+#define QSSG_MAX_NUM_SHADOW_CASCADES 4
+
 enum class ShadowMapModes
 {
     VSM, ///< variance shadow mapping
@@ -66,23 +72,21 @@ struct QSSGShadowMapEntry
 {
     QSSGShadowMapEntry();
 
-    static QSSGShadowMapEntry withRhiDepthMap(quint32 lightIdx,
-                                              ShadowMapModes mode,
-                                              QRhiTexture *depthMap,
-                                              QRhiTexture *depthCopy,
-                                              QRhiRenderBuffer *depthStencil);
-
-    static QSSGShadowMapEntry withRhiDepthCubeMap(quint32 lightIdx,
-                                                  ShadowMapModes mode,
-                                                  QRhiTexture *depthCube,
-                                                  QRhiTexture *cubeCopy,
-                                                  QRhiRenderBuffer *depthStencil);
-
     void destroyRhiResources();
 
     quint32 m_lightIndex; ///< the light index it belongs to
     ShadowMapModes m_shadowMapMode; ///< shadow map method
 
+    // 2D shadow maps are tiles in the atlas shared by all lights of the
+    // layer, and cube maps of the same size share the blur and depth-stencil
+    // buffers. Such resources are owned by the QSSGRenderShadowMap, the
+    // pointers below only refer to them.
+    // Cascaded directional lights have one tile per cascade.
+    bool m_inAtlas = false;
+    int m_cascadeCount = 0;
+    QRect m_atlasRect[QSSG_MAX_NUM_SHADOW_CASCADES]; ///< area of the atlas rendered to, in QRhi viewport coordinates
+    QVector4D m_atlasUvRect[QSSG_MAX_NUM_SHADOW_CASCADES]; ///< the same area as (u, v, width, height) in texture coordinates
+
     // RHI resources
     QRhiTexture *m_rhiDepthMap = nullptr; // shadow map (VSM)
     QRhiTexture *m_rhiDepthCopy = nullptr; // for blur pass (VSM)
@@ -98,9 +102,26 @@ struct QSSGShadowMapEntry
     QMatrix4x4 m_lightVP; ///< light view projection matrix
     QMatrix4x4 m_lightCubeView[6]; ///< light cubemap view matrices
     QMatrix4x4 m_lightView; ///< light view transform
+    QMatrix4x4 m_cascadeLightVP[QSSG_MAX_NUM_SHADOW_CASCADES]; ///< light view projection of each cascade
+    float m_cascadeSplits[QSSG_MAX_NUM_SHADOW_CASCADES] = {}; ///< distance from the camera where each cascade ends
+
+    // Hash of the light and casters the map (or each cascade's tile) was
+    // last rendered with, 0 when the contents are not valid. See
+    // rhiRenderShadowMap().
+    size_t m_renderedSignature[QSSG_MAX_NUM_SHADOW_CASCADES] = {};
+};
+
+struct QSSGShadowMapRequest
+{
+    qint32 lightIdx;
+    qint32 size; ///< width and height, a power of two
+    ShadowMapModes mode;
+    float importance; ///< relative, e.g. the size of the light's range on screen
+    qint32 cascadeCount = 1; ///< VSM only
+    float cascadeResolutionScale = 1.0f; ///< size of each cascade relative to the previous one
 };
 
-class QSSGRenderShadowMap
+class Q_QUICK3DRUNTIMERENDER_EXPORT QSSGRenderShadowMap
 {
     typedef QVector<QSSGShadowMapEntry> TShadowMapEntryList;
 
@@ -108,20 +129,63 @@ public:
     QAtomicInt ref;
     const QSSGRenderContextInterface &m_context;
 
+    // The one texture the 2D shadow maps of all lights are rendered into
+    struct Atlas
+    {
+        QRhiTexture *texture = nullptr;
+        QRhiTexture *copy = nullptr; // for blur pass
+        QRhiRenderBuffer *depthStencil = nullptr;
+        QRhiTextureRenderTarget *renderTarget = nullptr;
+        QRhiRenderPassDescriptor *renderPassDesc = nullptr;
+        QRhiTextureRenderTarget *blurRenderTarget0 = nullptr; // blur X, targets copy
+        QRhiTextureRenderTarget *blurRenderTarget1 = nullptr; // blur Y, targets texture
+        QRhiRenderPassDescriptor *blurRenderPassDesc = nullptr;
+        void reset();
+    };
+
     QSSGRenderShadowMap(const QSSGRenderContextInterface &inContext);
     ~QSSGRenderShadowMap();
 
-    void addShadowMapEntry(qint32 lightIdx,
-                           qint32 width,
-                           qint32 height,
-                           ShadowMapModes mode);
+    // Called with all shadow casting lights on every layer prepare. Creates,
+    // resizes and releases the shadow maps as needed. When the maps would
+    // need more memory than QT_QUICK3D_SHADOW_MAP_BUDGET (in megabytes), or a
+    // larger atlas than the maximum texture size, the maps of the least
+    // important lights get smaller. The atlas holds at most
+    // QSSG_MAX_NUM_SHADOW_MAPS tiles, lights get fewer cascades when more
+    // would be needed.
+    void updateShadowMapEntries(QVector<QSSGShadowMapRequest> requests);
 
     QSSGShadowMapEntry *shadowMapEntry(int lightIdx);
 
     qint32 shadowMapEntryCount() { return m_shadowMapList.size(); }
 
+    const Atlas &atlas() const { return m_atlas; }
+
+    // Distances from the camera where each of the cascadeCount cascades ends,
+    // blending between an even (splitBlend 0) and a logarithmic (1)
+    // distribution, the "practical split scheme". Shadows reach up to
+    // shadowMapFar, or the camera's far plane when that is nearer.
+    static void computeCascadeSplits(float clipNear, float clipFar, float shadowMapFar, float splitBlend,
+                                     int cascadeCount, float *splits);
+
 private:
+    struct CubeScratch
+    {
+        QRhiTexture *copy = nullptr; // for blur pass
+        QRhiRenderBuffer *depthStencil = nullptr;
+        QRhiTextureRenderTarget *blurRenderTarget0 = nullptr; // blur X, targets copy
+        QRhiRenderPassDescriptor *blurRenderPassDesc = nullptr;
+        void reset();
+    };
+
+    void addCubeShadowMapEntry(qint32 lightIdx, qint32 size);
+    void addAtlasShadowMapEntry(qint32 lightIdx, int cascadeCount, int cascade, const QRect &tile);
+    bool ensureAtlas(int size);
+    CubeScratch &cubeScratch(int size);
+
     TShadowMapEntryList m_shadowMapList;
+    Atlas m_atlas;
+    QHash<int, CubeScratch> m_cubeScratch; // by size
 };
 
 QT_END_NAMESPACE
@@ -30,8 +30,20 @@
 #include "qssgrhicontext_p.h"
 #include <QtQuick3DUtils/private/qssgmesh_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrenderableimage_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrenderparticles_p.h>
 #include <QtQuick3DUtils/private/qssgutils_p.h>
 #include <QtCore/QVariant>
+#include <QtCore/qcryptographichash.h>
+#include <QtCore/qdatastream.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qfileinfo.h>
+#include <QtCore/qsavefile.h>
+#include <QtCore/qstandardpaths.h>
+
+#include <algorithm>
+#include <iterator>
 
 QT_BEGIN_NAMESPACE
 
@@ -195,6 +207,42 @@ QRhiGraphicsPipeline::CullMode QSSGRhiGraphicsPipelineState::toCullMode(QSSGCull
     return QRhiGraphicsPipeline::None;
 }
 
+// Must match the order of QSSGRhiShaderPipeline::CommonUniform.
+static const char *commonUniformNames[] = {
+    "qt_cameraPosition",
+    "qt_cameraDirection",
+    "qt_cameraProperties",
+    "qt_projectionMatrix",
+    "qt_inverseProjectionMatrix",
+    "qt_viewMatrix",
+    "qt_viewProjectionMatrix",
+    "qt_modelMatrix",
+    "qt_modelViewProjection",
+    "qt_normalMatrix",
+    "qt_parentMatrix",
+    "qt_lightProbeOrientation",
+    "qt_lightProbeProperties",
+    "qt_reflectionProbeBoxCenter",
+    "qt_reflectionProbeBoxMin",
+    "qt_reflectionProbeBoxMax",
+    "qt_reflectionProbeCorrection",
+    "qt_material_emissive_color",
+    "qt_material_base_color",
+    "qt_material_specular",
+    "qt_material_properties",
+    "qt_material_properties2",
+    "qt_material_properties3",
+    "qt_material_properties4",
+    "qt_material_attenuation",
+    "qt_material_thickness",
+    "qt_light_ambient_total",
+    "qt_rhi_properties",
+    "qt_shadowDepthAdjust",
+    "qt_materialPointSize"
+};
+static_assert(std::size(commonUniformNames) == size_t(QSSGRhiShaderPipeline::CommonUniform::Count),
+              "commonUniformNames does not match CommonUniform");
+
 void QSSGRhiShaderPipeline::addStage(const QRhiShaderStage &stage, StageFlags flags)
 {
     m_stages.append(stage);
@@ -213,6 +261,11 @@ void QSSGRhiShaderPipeline::addStage(const QRhiShaderStage &stage, StageFlags fl
                 m_ub0NextUBufOffset = m_context.rhi()->ubufAligned(m_ub0Size);
                 for (const QShaderDescription::BlockVariable &var : blk.members)
                     m_ub0[var.name] = var;
+                for (size_t i = 0; i < size_t(CommonUniform::Count); ++i) {
+                    auto it = m_ub0.constFind(QByteArray::fromRawData(commonUniformNames[i], qstrlen(commonUniformNames[i])));
+                    if (it != m_ub0.cend())
+                        m_commonUniforms[i] = { it->offset, it->size };
+                }
                 break;
             }
         }
@@ -913,47 +966,258 @@ int QSSGRhiShaderPipeline::bindingForTexture(const char *name, int hint)
     return binding;
 }
 
+// Enough for several hundred lit draw calls. Larger allocations get a chunk of
+// their own size.
+static const quint32 UniformRingChunkSize = 1024 * 1024;
+
+void QSSGRhiUniformRing::reset()
+{
+    for (Chunk &chunk : m_chunks) {
+        chunk.used = 0;
+        chunk.flushed = 0;
+    }
+    m_current = 0;
+    m_lastOffset = 0;
+}
+
+QSSGRhiUniformRing::Allocation QSSGRhiUniformRing::allocate(QRhi *rhi, int size)
+{
+    const quint32 alignedSize = rhi->ubufAligned(size);
+    for (; m_current < m_chunks.count(); ++m_current) {
+        Chunk &chunk(m_chunks[m_current]);
+        if (chunk.used + alignedSize <= quint32(chunk.data.size())) {
+            m_lastOffset = chunk.used;
+            chunk.used += alignedSize;
+            return { chunk.buffer, m_lastOffset, chunk.data.data() + m_lastOffset };
+        }
+    }
+
+    const quint32 chunkSize = qMax(UniformRingChunkSize, alignedSize);
+    Chunk chunk;
+    chunk.buffer = rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, chunkSize);
+    if (!chunk.buffer->create()) {
+        qWarning("Failed to build uniform buffer of size %u", chunkSize);
+        delete chunk.buffer;
+        return {};
+    }
+    chunk.data.resize(chunkSize);
+    chunk.used = alignedSize;
+    m_chunks.append(std::move(chunk));
+    m_current = m_chunks.count() - 1;
+    m_lastOffset = 0;
+    return { m_chunks[m_current].buffer, 0, m_chunks[m_current].data.data() };
+}
+
+void QSSGRhiUniformRing::shrinkLast(QRhi *rhi, int size)
+{
+    if (m_current < m_chunks.count()) {
+        Chunk &chunk(m_chunks[m_current]);
+        chunk.used = qMin(chunk.used, m_lastOffset + rhi->ubufAligned(size));
+    }
+}
+
+void QSSGRhiUniformRing::flush(QRhiResourceUpdateBatch *rub)
+{
+    // One update per chunk, covering everything written since the last flush.
+    for (Chunk &chunk : m_chunks) {
+        if (chunk.used > chunk.flushed) {
+            rub->updateDynamicBuffer(chunk.buffer, chunk.flushed, chunk.used - chunk.flushed,
+                                     chunk.data.constData() + chunk.flushed);
+            chunk.flushed = chunk.used;
+        }
+    }
+}
+
+void QSSGRhiUniformRing::releaseResources()
+{
+    for (Chunk &chunk : m_chunks)
+        delete chunk.buffer;
+    m_chunks.clear();
+    m_current = 0;
+    m_lastOffset = 0;
+}
+
+// -1 until QT_QUICK3D_DISABLE_UNIFORM_RING has been read
+static QBasicAtomicInt uniformRingEnabled = Q_BASIC_ATOMIC_INITIALIZER(-1);
+
+bool QSSGRhiUniformRing::isEnabled()
+{
+    int enabled = uniformRingEnabled.loadRelaxed();
+    if (enabled < 0) {
+        enabled = qEnvironmentVariableIntValue("QT_QUICK3D_DISABLE_UNIFORM_RING") == 0 ? 1 : 0;
+        uniformRingEnabled.storeRelaxed(enabled);
+    }
+    return enabled;
+}
+
+void QSSGRhiUniformRing::setEnabled(bool enabled)
+{
+    uniformRingEnabled.storeRelaxed(enabled ? 1 : 0);
+}
+
+static int cacheBudget(const char *name, int defaultValue)
+{
+    bool ok = false;
+    const int v = qEnvironmentVariableIntValue(name, &ok);
+    return ok ? qMax(0, v) : defaultValue;
+}
+
 QSSGRhiContext::QSSGRhiContext()
 {
     Q_STATIC_ASSERT(int(QSSGRhiSamplerBindingHints::LightProbe) > int(QSSGRenderableImage::Type::Occlusion));
+
+    m_cacheLimits.pipelines = cacheBudget("QT_QUICK3D_MAX_CACHED_PIPELINES", m_cacheLimits.pipelines);
+    m_cacheLimits.srbs = cacheBudget("QT_QUICK3D_MAX_CACHED_SRBS", m_cacheLimits.srbs);
+    m_cacheLimits.drawCallData = cacheBudget("QT_QUICK3D_MAX_CACHED_DRAW_CALL_DATA", m_cacheLimits.drawCallData);
+}
+
+// The driver side pipeline cache (Vulkan pipeline cache, OpenGL program
+// binaries) is kept in a file per backend and device, so that the pipelines
+// QSSGRhiContext::pipeline() builds do not need to be compiled by the driver
+// on every start. The data itself is validated by QRhi, the header here only
+// rejects files written by other Qt versions or that are not cache files.
+static constexpr quint32 PipelineCacheMagic = 0x51335043; // Q3PC
+static constexpr quint32 PipelineCacheVersion = 1;
+
+QString QSSGRhiContext::pipelineCacheFileName(QRhi *rhi)
+{
+    if (!rhi->isFeatureSupported(QRhi::PipelineCache) || QSSGRhiContext::editorMode()
+            || qEnvironmentVariableIntValue("QT_QUICK3D_DISABLE_PIPELINE_CACHE"))
+        return QString();
+
+    QString dir = qEnvironmentVariable("QT_QUICK3D_PIPELINE_CACHE_DIR");
+    if (dir.isEmpty()) {
+        dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+        if (dir.isEmpty())
+            return QString();
+        dir += QLatin1String("/qtquick3d/pipelines");
+    }
+
+    const QRhiDriverInfo driverInfo = rhi->driverInfo();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(rhi->backendName());
+    hash.addData(driverInfo.deviceName);
+    hash.addData(QByteArray::number(driverInfo.deviceId));
+    hash.addData(QByteArray::number(driverInfo.vendorId));
+    return dir + QLatin1String("/qtquick3d-") + QString::fromLatin1(hash.result().toHex().left(16))
+            + QLatin1String(".rhipcache");
+}
+
+QByteArray QSSGRhiContext::readPipelineCache(const QString &fileName)
+{
+    QFile f(fileName);
+    if (!f.open(QIODevice::ReadOnly))
+        return QByteArray();
+
+    QDataStream ds(&f);
+    ds.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QByteArray qtVersion;
+    QByteArray data;
+    ds >> magic >> version >> qtVersion >> data;
+    // Trailing bytes mean the file was not written by writePipelineCache().
+    if (ds.status() != QDataStream::Ok || !ds.atEnd()
+            || magic != PipelineCacheMagic || version != PipelineCacheVersion
+            || qtVersion != QByteArrayLiteral(QT_VERSION_STR)) {
+        return QByteArray();
+    }
+    return data;
+}
+
+bool QSSGRhiContext::writePipelineCache(const QString &fileName, const QByteArray &data)
+{
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    QSaveFile f(fileName);
+    if (!f.open(QIODevice::WriteOnly))
+        return false;
+    QDataStream ds(&f);
+    ds.setVersion(QDataStream::Qt_6_0);
+    ds << PipelineCacheMagic << PipelineCacheVersion << QByteArrayLiteral(QT_VERSION_STR) << data;
+    if (!f.commit()) {
+        qWarning("Failed to write pipeline cache %s", qPrintable(fileName));
+        return false;
+    }
+    return true;
 }
 
 QSSGRhiContext::~QSSGRhiContext()
 {
+    // Only worth writing when new pipelines were built, the data contains
+    // all the ones created through the QRhi so far.
+    if (m_rhi && m_pipelineCacheDirty && !m_pipelineCacheFile.isEmpty()) {
+        const QByteArray data = m_rhi->pipelineCacheData();
+        if (!data.isEmpty())
+            writePipelineCache(m_pipelineCacheFile, data);
+    }
+
     for (QSSGRhiDrawCallData &dcd : m_drawCallData)
         dcd.reset();
 
-    qDeleteAll(m_pipelines);
+    for (const auto &cached : qAsConst(m_pipelines))
+        delete cached.resource;
     qDeleteAll(m_computePipelines);
-    qDeleteAll(m_srbCache);
+    for (const auto &cached : qAsConst(m_srbCache))
+        delete cached.resource;
     qDeleteAll(m_textures);
-    for (const auto &samplerInfo : qAsConst(m_samplers))
-        delete samplerInfo.second;
+    qDeleteAll(m_samplers);
     for (const auto &instanceData : qAsConst(m_instanceBuffers)) {
         if (instanceData.owned)
             delete instanceData.buffer;
     }
-    for (const auto &particleData : qAsConst(m_particleData))
+    for (auto &particleData : m_particleData) {
         delete particleData.texture;
+        particleData.simulation.reset();
+    }
     qDeleteAll(m_dummyTextures);
 }
 
+QRhiCommandBuffer::BeginPassFlags QSSGRhiContext::commonPassFlags()
+{
+    // GPU compute is only used by the particle simulation. Without it we can
+    // get a small performance gain with OpenGL by declaring this.
+    if (QSSGParticleSimulation::isRequested())
+        return {};
+    return QRhiCommandBuffer::DoNotTrackResourcesForCompute;
+}
+
 void QSSGRhiContext::initialize(QRhi *rhi)
 {
     Q_ASSERT(rhi && !m_rhi);
     m_rhi = rhi;
+
+    // When the QRhi comes with pipeline cache data already (for example
+    // Qt Quick's QQuickGraphicsConfiguration::setPipelineCacheLoadFile()),
+    // the application manages the cache. Loading ours would replace that
+    // data, and writing it back would duplicate it in a second file.
+    if (!m_rhi->pipelineCacheData().isEmpty())
+        return;
+
+    m_pipelineCacheFile = pipelineCacheFileName(rhi);
+    if (!m_pipelineCacheFile.isEmpty()) {
+        const QByteArray data = readPipelineCache(m_pipelineCacheFile);
+        if (!data.isEmpty())
+            m_rhi->setPipelineCacheData(data);
+    }
 }
 
 QRhiShaderResourceBindings *QSSGRhiContext::srb(const QSSGRhiShaderResourceBindingList &bindings)
 {
-    auto it = m_srbCache.constFind(bindings);
-    if (it != m_srbCache.constEnd())
-        return *it;
+    auto it = m_srbCache.find(bindings);
+    if (it != m_srbCache.end()) {
+        it->lastUsedFrame = m_frameIndex;
+        ++m_cacheStats.srbs.hits;
+        return it->resource;
+    }
 
+    ++m_cacheStats.srbs.misses;
+    QElapsedTimer timer;
+    timer.start();
     QRhiShaderResourceBindings *srb = m_rhi->newShaderResourceBindings();
     srb->setBindings(bindings.v, bindings.v + bindings.p);
     if (srb->create()) {
-        m_srbCache.insert(bindings, srb);
+        m_srbCache.insert(bindings, { srb, m_frameIndex });
+        m_cacheStats.srbs.creationTimeNs += timer.nsecsElapsed();
     } else {
         qWarning("Failed to build srb");
         delete srb;
@@ -966,11 +1230,17 @@ QRhiGraphicsPipeline *QSSGRhiContext::pipeline(const QSSGGraphicsPipelineStateKe
                                                QRhiRenderPassDescriptor *rpDesc,
                                                QRhiShaderResourceBindings *srb)
 {
-    auto it = m_pipelines.constFind(key);
-    if (it != m_pipelines.constEnd())
-        return it.value();
+    auto it = m_pipelines.find(key);
+    if (it != m_pipelines.end()) {
+        it->lastUsedFrame = m_frameIndex;
+        ++m_cacheStats.pipelines.hits;
+        return it->resource;
+    }
 
     // Build a new one. This is potentially expensive.
+    ++m_cacheStats.pipelines.misses;
+    QElapsedTimer timer;
+    timer.start();
     QRhiGraphicsPipeline *ps = m_rhi->newGraphicsPipeline();
 
     ps->setShaderStages(key.state.shaderPipeline->cbeginStages(), key.state.shaderPipeline->cendStages());
@@ -1011,7 +1281,9 @@ QRhiGraphicsPipeline *QSSGRhiContext::pipeline(const QSSGGraphicsPipelineStateKe
         return nullptr;
     }
 
-    m_pipelines.insert(key, ps);
+    m_pipelines.insert(key, { ps, m_frameIndex });
+    m_cacheStats.pipelines.creationTimeNs += timer.nsecsElapsed();
+    m_pipelineCacheDirty = true;
     return ps;
 }
 
@@ -1034,15 +1306,17 @@ QRhiComputePipeline *QSSGRhiContext::computePipeline(const QSSGComputePipelineSt
     return computePipeline;
 }
 
-using SamplerInfo = QPair<QSSGRhiSamplerDescription, QRhiSampler*>;
-
 QRhiSampler *QSSGRhiContext::sampler(const QSSGRhiSamplerDescription &samplerDescription)
 {
-    auto compareSampler = [samplerDescription](const SamplerInfo &info){ return info.first == samplerDescription; };
-    const auto found = std::find_if(m_samplers.cbegin(), m_samplers.cend(), compareSampler);
-    if (found != m_samplers.cend())
-        return found->second;
+    auto it = m_samplers.constFind(samplerDescription);
+    if (it != m_samplers.constEnd()) {
+        ++m_cacheStats.samplers.hits;
+        return *it;
+    }
 
+    ++m_cacheStats.samplers.misses;
+    QElapsedTimer timer;
+    timer.start();
     QRhiSampler *newSampler = m_rhi->newSampler(samplerDescription.minFilter, samplerDescription.magFilter,
                                                 samplerDescription.mipmap,
                                                 samplerDescription.hTiling, samplerDescription.vTiling, samplerDescription.zTiling);
@@ -1051,10 +1325,146 @@ QRhiSampler *QSSGRhiContext::sampler(const QSSGRhiSamplerDescription &samplerDes
         delete newSampler;
         return nullptr;
     }
-    m_samplers << SamplerInfo{samplerDescription, newSampler};
+    m_samplers.insert(samplerDescription, newSampler);
+    m_cacheStats.samplers.creationTimeNs += timer.nsecsElapsed();
     return newSampler;
 }
 
+// Returns the last-used frame stamp at or below which entries are to be
+// evicted in order to get rid of the \a excess least recently used ones.
+static quint32 evictionCutoff(QVector<quint32> &stamps, qsizetype excess)
+{
+    std::nth_element(stamps.begin(), stamps.begin() + (excess - 1), stamps.end());
+    return stamps[excess - 1];
+}
+
+void QSSGRhiContext::releaseUnusedResources()
+{
+    const int maxPipelines = m_cacheLimits.pipelines;
+    const int maxSrbs = m_cacheLimits.srbs;
+    const int maxDrawCallData = m_cacheLimits.drawCallData;
+    // Keeping recently used objects avoids thrashing with scenes that simply
+    // need more than the budget allows.
+    const quint32 minUnusedFrames = m_cacheLimits.minUnusedFrames;
+
+    const qsizetype excessDrawCallData = maxDrawCallData ? m_drawCallData.count() - maxDrawCallData : 0;
+    const qsizetype excessPipelines = maxPipelines ? m_pipelines.count() - maxPipelines : 0;
+    const qsizetype excessSrbs = maxSrbs ? m_srbCache.count() - maxSrbs : 0;
+    if ((excessDrawCallData <= 0 && excessPipelines <= 0 && excessSrbs <= 0) || m_frameIndex < minUnusedFrames)
+        return;
+
+    const quint32 maxStamp = m_frameIndex - minUnusedFrames;
+    QVector<quint32> stamps;
+
+    // The draw call data goes first since it owns a uniform buffer, and
+    // refers to a pipeline and an srb which it uses without going through
+    // the caches below.
+    if (excessDrawCallData > 0) {
+        stamps.reserve(m_drawCallData.count());
+        for (const QSSGRhiDrawCallData &dcd : qAsConst(m_drawCallData))
+            stamps.append(dcd.lastUsedFrame);
+        const quint32 cutoff = qMin(evictionCutoff(stamps, excessDrawCallData), maxStamp);
+        qsizetype evicted = 0;
+        for (auto it = m_drawCallData.begin(); it != m_drawCallData.end() && evicted < excessDrawCallData; ) {
+            if (it->lastUsedFrame <= cutoff) {
+                it->reset();
+                it = m_drawCallData.erase(it);
+                ++evicted;
+            } else {
+                ++it;
+            }
+        }
+        m_cacheStats.drawCallData.evictions += evicted;
+    }
+
+    // What the remaining draw call data refers to counts as used in the
+    // frame the draw call data was last used in.
+    QHash<const void *, quint32> dcdStamps;
+    if (excessPipelines > 0 || excessSrbs > 0) {
+        for (const QSSGRhiDrawCallData &dcd : qAsConst(m_drawCallData)) {
+            if (dcd.pipeline) {
+                quint32 &stamp(dcdStamps[dcd.pipeline]);
+                stamp = qMax(stamp, dcd.lastUsedFrame);
+            }
+            if (dcd.srb) {
+                quint32 &stamp(dcdStamps[dcd.srb]);
+                stamp = qMax(stamp, dcd.lastUsedFrame);
+            }
+        }
+    }
+    auto effectiveStamp = [&dcdStamps](const void *resource, quint32 lastUsedFrame) {
+        return qMax(lastUsedFrame, dcdStamps.value(resource));
+    };
+
+    QSet<const void *> evictedResources;
+
+    if (excessPipelines > 0) {
+        stamps.clear();
+        for (const auto &cached : qAsConst(m_pipelines))
+            stamps.append(effectiveStamp(cached.resource, cached.lastUsedFrame));
+        const quint32 cutoff = qMin(evictionCutoff(stamps, excessPipelines), maxStamp);
+        qsizetype evicted = 0;
+        for (auto it = m_pipelines.begin(); it != m_pipelines.end() && evicted < excessPipelines; ) {
+            if (effectiveStamp(it->resource, it->lastUsedFrame) <= cutoff) {
+                evictedResources.insert(it->resource);
+                delete it->resource;
+                it = m_pipelines.erase(it);
+                ++evicted;
+            } else {
+                ++it;
+            }
+        }
+        m_cacheStats.pipelines.evictions += evicted;
+    }
+
+    if (excessSrbs > 0) {
+        // The srb a pipeline was created with must stay valid as long as
+        // the pipeline does.
+        QSet<const void *> pipelineSrbs;
+        for (const auto &cached : qAsConst(m_pipelines))
+            pipelineSrbs.insert(cached.resource->shaderResourceBindings());
+        for (QRhiComputePipeline *computePipeline : qAsConst(m_computePipelines))
+            pipelineSrbs.insert(computePipeline->shaderResourceBindings());
+
+        stamps.clear();
+        for (const auto &cached : qAsConst(m_srbCache))
+            stamps.append(pipelineSrbs.contains(cached.resource) ? m_frameIndex : effectiveStamp(cached.resource, cached.lastUsedFrame));
+        const quint32 cutoff = qMin(evictionCutoff(stamps, excessSrbs), maxStamp);
+        qsizetype evicted = 0;
+        for (auto it = m_srbCache.begin(); it != m_srbCache.end() && evicted < excessSrbs; ) {
+            if (!pipelineSrbs.contains(it->resource) && effectiveStamp(it->resource, it->lastUsedFrame) <= cutoff) {
+                evictedResources.insert(it->resource);
+                delete it->resource;
+                it = m_srbCache.erase(it);
+                ++evicted;
+            } else {
+                ++it;
+            }
+        }
+        m_cacheStats.srbs.evictions += evicted;
+    }
+
+    // Make the draw call data go through the caches again the next time
+    // instead of using a dangling pointer.
+    if (!evictedResources.isEmpty()) {
+        for (QSSGRhiDrawCallData &dcd : m_drawCallData) {
+            if (evictedResources.contains(dcd.pipeline))
+                dcd.pipeline = nullptr;
+            if (evictedResources.contains(dcd.srb))
+                dcd.srb = nullptr;
+        }
+    }
+}
+
+const QSSGRhiCacheStats &QSSGRhiContext::cacheStats()
+{
+    m_cacheStats.pipelines.size = m_pipelines.count();
+    m_cacheStats.srbs.size = m_srbCache.count();
+    m_cacheStats.samplers.size = m_samplers.count();
+    m_cacheStats.drawCallData.size = m_drawCallData.count();
+    return m_cacheStats;
+}
+
 void QSSGRhiContext::releaseTexture(QRhiTexture *texture)
 {
     m_textures.remove(texture);
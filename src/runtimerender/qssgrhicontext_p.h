@@ -178,6 +178,13 @@ inline bool operator!=(const QSSGRhiSamplerDescription &a, const QSSGRhiSamplerD
     return !(a == b);
 }
 
+inline size_t qHash(const QSSGRhiSamplerDescription &s, size_t seed = 0) Q_DECL_NOTHROW
+{
+    // 3 bits per enum are plenty, all fit into one integer
+    return qHash(uint(s.minFilter) | (uint(s.magFilter) << 3) | (uint(s.mipmap) << 6)
+                 | (uint(s.hTiling) << 9) | (uint(s.vTiling) << 12) | (uint(s.zTiling) << 15), seed);
+}
+
 struct QSSGRhiTexture
 {
     QByteArray name;
@@ -278,45 +285,56 @@ public:
 
     const QHash<QSSGRhiInputAssemblerState::InputSemantic, QShaderDescription::InOutVariable> &vertexInputs() const { return m_vertexInputs; }
 
+    // The members of the main uniform block every material shader may have.
+    // Their offsets are looked up once, when the vertex stage is added, so
+    // that setUniform() can write them without any lookup by name.
+    enum class CommonUniform {
+        CameraPosition,
+        CameraDirection,
+        CameraProperties,
+        ProjectionMatrix,
+        InverseProjectionMatrix,
+        ViewMatrix,
+        ViewProjectionMatrix,
+        ModelMatrix,
+        ModelViewProjection,
+        NormalMatrix,
+        ParentMatrix,
+        LightProbeOrientation,
+        LightProbeProperties,
+        ReflectionProbeBoxCenter,
+        ReflectionProbeBoxMin,
+        ReflectionProbeBoxMax,
+        ReflectionProbeCorrection,
+        MaterialEmissiveColor,
+        MaterialBaseColor,
+        MaterialSpecular,
+        MaterialProperties,
+        MaterialProperties2,
+        MaterialProperties3,
+        MaterialProperties4,
+        MaterialAttenuation,
+        MaterialThickness,
+        LightAmbientTotal,
+        RhiProperties,
+        ShadowDepthAdjust,
+        MaterialPointSize,
+
+        Count
+    };
+
+    // Offset into the main uniform block, -1 when the shader does not have
+    // the uniform.
+    int offsetOfUniform(CommonUniform u) const { return m_commonUniforms[int(u)].offset; }
+
     // This struct is used purely for performance. It is used to quickly store
-    // and index common uniform names using the storeIndex argument in the
-    // setUniform method.
+    // and index uniform names, that are not in CommonUniform, using the
+    // storeIndex argument in the setUniform method.
     struct CommonUniformIndices
     {
-        int cameraPositionIdx = -1;
-        int cameraDirectionIdx = -1;
-        int viewProjectionMatrixIdx = -1;
-        int projectionMatrixIdx = -1;
-        int inverseProjectionMatrixIdx = -1;
-        int viewMatrixIdx = -1;
-        int modelViewProjectionIdx = -1;
-        int normalMatrixIdx = -1;
-        int modelMatrixIdx = -1;
-        int lightProbeOrientationIdx = -1;
-        int lightProbePropertiesIdx = -1;
-        int material_emissiveColorIdx = -1;
-        int material_baseColorIdx = -1;
-        int material_specularIdx = -1;
-        int cameraPropertiesIdx = -1;
-        int light_ambient_totalIdx = -1;
-        int material_propertiesIdx = -1;
-        int material_properties2Idx = -1;
-        int material_properties3Idx = -1;
-        int material_properties4Idx = -1;
-        int material_properties5Idx = -1;
-        int material_attenuationIdx = -1;
-        int thicknessFactorIdx = -1;
-        int rhiPropertiesIdx = -1;
-        int displaceAmountIdx = -1;
         int boneTransformsIdx = -1;
         int boneNormalTransformsIdx = -1;
-        int shadowDepthAdjustIdx = -1;
-        int pointSizeIdx = -1;
         int morphWeightsIdx = -1;
-        int reflectionProbeBoxCenter = -1;
-        int reflectionProbeBoxMax = -1;
-        int reflectionProbeBoxMin = -1;
-        int reflectionProbeCorrection = -1;
 
         struct ImageIndices
         {
@@ -341,6 +359,7 @@ public:
 
     void setUniformValue(char *ubufData, const char *name, const QVariant &value, QSSGRenderShaderDataType type);
     void setUniform(char *ubufData, const char *name, const void *data, size_t size, int *storeIndex = nullptr, UniformFlags flags = {});
+    inline void setUniform(char *ubufData, CommonUniform u, const void *data, size_t size, UniformFlags flags = {});
     void setUniformArray(char *ubufData, const char *name, const void *data, size_t itemCount, QSSGRenderShaderDataType type, int *storeIndex = nullptr);
     int bindingForTexture(const char *name, int hint = -1);
 
@@ -393,6 +412,10 @@ private:
     int m_ub0Size = 0;
     int m_ub0NextUBufOffset = 0;
     QHash<QByteArray, QShaderDescription::BlockVariable> m_ub0;
+    struct CommonUniformLayout {
+        int offset = -1;
+        int size = 0;
+    } m_commonUniforms[size_t(CommonUniform::Count)];
     QHash<QSSGRhiInputAssemblerState::InputSemantic, QShaderDescription::InOutVariable> m_vertexInputs;
     QHash<QByteArray, QShaderDescription::InOutVariable> m_combinedImageSamplers;
     int m_materialImageSamplerBindings[size_t(QSSGRhiSamplerBindingHints::BindingMapSize)];
@@ -417,6 +440,31 @@ private:
 Q_DECLARE_OPERATORS_FOR_FLAGS(QSSGRhiShaderPipeline::StageFlags)
 Q_DECLARE_OPERATORS_FOR_FLAGS(QSSGRhiShaderPipeline::UniformFlags)
 
+inline void QSSGRhiShaderPipeline::setUniform(char *ubufData, CommonUniform u, const void *data, size_t size, UniformFlags flags)
+{
+    const CommonUniformLayout &layout(m_commonUniforms[int(u)]);
+    if (layout.offset < 0) // not used by the shader
+        return;
+#ifdef QT_DEBUG
+    if (int(size) != layout.size) {
+        qWarning("Uniform block member %d got %d bytes whereas the true size is %d",
+                 int(u), int(size), layout.size);
+        return;
+    }
+#endif
+    char *dst = ubufData + layout.offset;
+    if (flags.testFlag(UniformFlag::Mat3)) {
+        // mat3 is still 4 floats per column in the uniform buffer (but there
+        // is no 4th column), so 48 bytes altogether, not 36 or 64.
+        const float *src = static_cast<const float *>(data);
+        memcpy(dst, src, 3 * sizeof(float));
+        memcpy(dst + 4 * sizeof(float), src + 3, 3 * sizeof(float));
+        memcpy(dst + 8 * sizeof(float), src + 6, 3 * sizeof(float));
+    } else {
+        memcpy(dst, data, size);
+    }
+}
+
 struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGRhiGraphicsPipelineState
 {
     const QSSGRhiShaderPipeline *shaderPipeline;
@@ -504,7 +552,17 @@ struct QSSGGraphicsPipelineStateKey
                                                const QRhiShaderResourceBindings *srb)
     {
         const QVector<quint32> rtDesc = rpDesc->serializedFormat();
-        const QVector<quint32> srbDesc = srb->serializedLayoutDescription();
+        QVector<quint32> srbDesc = srb->serializedLayoutDescription();
+        // The layout description does not tell apart uniform buffers with and
+        // without a dynamic offset, but a pipeline built for one cannot be
+        // used with the other.
+        for (auto it = srb->cbeginBindings(), end = srb->cendBindings(); it != end; ++it) {
+            const QRhiShaderResourceBinding::Data *d = it->data();
+            if (d->type == QRhiShaderResourceBinding::UniformBuffer && d->u.ubuf.hasDynamicOffset) {
+                srbDesc.append(0xffffffff);
+                break;
+            }
+        }
         return { state, rtDesc, srbDesc, { qHash(rtDesc), qHash(srbDesc) } };
     }
 };
@@ -590,6 +648,7 @@ struct QSSGRhiShaderResourceBindingList
     }
 
     void addUniformBuffer(int binding, QRhiShaderResourceBinding::StageFlags stage, QRhiBuffer *buf, int offset, int size);
+    void addUniformBufferWithDynamicOffset(int binding, QRhiShaderResourceBinding::StageFlags stage, QRhiBuffer *buf, int size);
     void addTexture(int binding, QRhiShaderResourceBinding::StageFlags stage, QRhiTexture *tex, QRhiSampler *sampler);
 };
 
@@ -636,6 +695,26 @@ inline void QSSGRhiShaderResourceBindingList::addUniformBuffer(int binding, QRhi
     d->u.ubuf.hasDynamicOffset = false;
 }
 
+inline void QSSGRhiShaderResourceBindingList::addUniformBufferWithDynamicOffset(int binding, QRhiShaderResourceBinding::StageFlags stage,
+                                                                                QRhiBuffer *buf, int size)
+{
+#ifdef QT_DEBUG
+    if (p == MAX_SIZE) {
+        qWarning("Out of shader resource bindings slots (max is %d)", MAX_SIZE);
+        return;
+    }
+#endif
+    QRhiShaderResourceBinding::Data *d = v[p++].data();
+    h ^= qintptr(buf) ^ size;
+    d->binding = binding;
+    d->stage = stage;
+    d->type = QRhiShaderResourceBinding::UniformBuffer;
+    d->u.ubuf.buf = buf;
+    d->u.ubuf.offset = 0;
+    d->u.ubuf.maybeSize = size;
+    d->u.ubuf.hasDynamicOffset = true;
+}
+
 inline void QSSGRhiShaderResourceBindingList::addTexture(int binding, QRhiShaderResourceBinding::StageFlags stage,
                                                          QRhiTexture *tex, QRhiSampler *sampler)
 {
@@ -713,6 +792,7 @@ struct QSSGRhiDrawCallData
     size_t renderTargetDescriptionHash = 0;
     QVector<quint32> renderTargetDescription;
     QSSGRhiGraphicsPipelineState ps;
+    quint32 lastUsedFrame = 0;
 
     void reset() {
         delete ubuf;
@@ -722,6 +802,53 @@ struct QSSGRhiDrawCallData
     }
 };
 
+// Per-frame suballocator for uniform data. Instead of a dedicated buffer for
+// each draw call, the data is written into a few large dynamic buffers at
+// offsets aligned to QRhi::UniformBufferOffsetAlignment, and bound with a
+// dynamic offset, so draw calls using the same textures can share one srb.
+// The allocations are only valid until the next reset(), which is expected
+// once per frame, and must be flush()ed before recording a pass that reads
+// them.
+class Q_QUICK3DRUNTIMERENDER_EXPORT QSSGRhiUniformRing
+{
+    Q_DISABLE_COPY(QSSGRhiUniformRing)
+public:
+    struct Allocation
+    {
+        QRhiBuffer *buffer = nullptr;
+        quint32 offset = 0;
+        char *data = nullptr;
+    };
+
+    QSSGRhiUniformRing() = default;
+    ~QSSGRhiUniformRing() { releaseResources(); }
+
+    void reset();
+    Allocation allocate(QRhi *rhi, int size);
+    // Gives back the unused tail of the most recent allocation.
+    void shrinkLast(QRhi *rhi, int size);
+    // Queues the data written since the last flush for upload.
+    void flush(QRhiResourceUpdateBatch *rub);
+    void releaseResources();
+
+    // False when QT_QUICK3D_DISABLE_UNIFORM_RING is set, the draw calls then
+    // use a buffer each. setEnabled() overrides it, for comparing the two.
+    static bool isEnabled();
+    static void setEnabled(bool enabled);
+
+private:
+    struct Chunk
+    {
+        QRhiBuffer *buffer = nullptr;
+        QByteArray data;
+        quint32 used = 0;
+        quint32 flushed = 0;
+    };
+    QVector<Chunk> m_chunks;
+    int m_current = 0;
+    quint32 m_lastOffset = 0;
+};
+
 struct QSSGRhiSortData
 {
     float d = 0.0f;
@@ -747,6 +874,44 @@ struct QSSGRhiParticleData
     int particleCount = 0;
     int serial = -1;
     bool sorting = false;
+
+    // Resources of the compute shader simulation, see QSSGParticleSimulation
+    struct Simulation {
+        QRhiBuffer *emitBuffer = nullptr;
+        QRhiBuffer *randomBuffer = nullptr;
+        QRhiBuffer *stateBuffer = nullptr;
+        QRhiBuffer *sortBuffer = nullptr;
+        QRhiBuffer *simulateUbuf = nullptr;
+        QRhiBuffer *sortUbuf = nullptr;
+        QRhiBuffer *scatterUbuf = nullptr;
+        QRhiShaderResourceBindings *simulateSrb = nullptr;
+        QRhiShaderResourceBindings *sortSrb = nullptr;
+        QRhiShaderResourceBindings *scatterSrb = nullptr;
+        int emitCount = 0;
+        int emitSerial = -1;
+        int sortCount = 0;
+        int sortSteps = 0;
+        int randomCount = 0;
+        int randomTableSerial = -1;
+        int serial = -1;
+        QVector3D sortDirection;
+        bool texturesLoadStore = false;
+
+        void reset()
+        {
+            delete emitBuffer;
+            delete randomBuffer;
+            delete stateBuffer;
+            delete sortBuffer;
+            delete simulateUbuf;
+            delete sortUbuf;
+            delete scatterUbuf;
+            delete simulateSrb;
+            delete sortSrb;
+            delete scatterSrb;
+            *this = Simulation();
+        }
+    } simulation;
 };
 
 struct QSSGRhiDummyTextureKey
@@ -773,6 +938,48 @@ inline bool operator!=(const QSSGRhiDummyTextureKey &a, const QSSGRhiDummyTextur
     return !(a == b);
 }
 
+// Counters for the caches in QSSGRhiContext. Everything but the sizes is
+// accumulated over the lifetime of the context.
+struct QSSGRhiCacheStats
+{
+    struct Counters {
+        int size = 0;
+        quint64 hits = 0;
+        quint64 misses = 0;
+        quint64 evictions = 0;
+        qint64 creationTimeNs = 0;
+    };
+    Counters pipelines;
+    Counters srbs;
+    Counters samplers;
+    Counters drawCallData;
+};
+
+// Budgets for the number of cached objects, 0 disables eviction. Objects
+// used within the last minUnusedFrames frames are never evicted, even when
+// that means staying above the budget.
+struct QSSGRhiCacheLimits
+{
+    int pipelines = 1024;
+    int srbs = 4096;
+    int drawCallData = 8192;
+    quint32 minUnusedFrames = 60;
+};
+
+struct QSSGRhiSwitchStats
+{
+    quint32 pipelineSwitches = 0;
+    quint32 srbSwitches = 0;
+};
+
+// Shadow maps (atlas tiles and cube maps) rendered in a frame, and the ones
+// whose contents were still valid from an earlier frame
+struct QSSGRhiShadowMapStats
+{
+    quint32 rendered = 0;
+    quint32 skipped = 0;
+};
+
 #define QSSGRHICTX_STAT(ctx, f) for (bool qssgrhictxlog_enabled = QSSGRhiContextStats::isEnabled(); qssgrhictxlog_enabled; qssgrhictxlog_enabled = false) ctx->stats().f
 
 class QSSGRhiContextStats
@@ -784,18 +991,30 @@ public:
         return enabled;
     }
 
+    // start(), stop(), the render pass and the pipeline and srb switch
+    // tracking are called regardless of isEnabled() since the switch counts
+    // are also exposed in RenderStats. The shadow map counts are always
+    // collected too. The rest is only collected when enabled.
     void start(const void *key)
     {
         renderPasses.clear();
         externalRenderPass = {};
+        switchStats = {};
+        shadowMapStats = {};
         currentRenderPassIndex = -1;
+        currentPipeline = nullptr;
+        currentSrb = nullptr;
         rendererPtr = key;
     }
 
     void stop()
     {
+        if (!isEnabled())
+            return;
         const int rpCount = renderPasses.count();
-        qDebug("%d render passes in 3D renderer %p", rpCount, rendererPtr);
+        qDebug("%d render passes in 3D renderer %p, %u pipeline and %u shader resource switches in total",
+               rpCount, rendererPtr, switchStats.pipelineSwitches, switchStats.srbSwitches);
+        qDebug("%u shadow maps rendered, %u reused", shadowMapStats.rendered, shadowMapStats.skipped);
         for (int i = 0; i < rpCount; ++i) {
             const RenderPassInfo &rp(renderPasses[i]);
             qDebug("Render pass %d: target size %dx%d pixels",
@@ -812,13 +1031,45 @@ public:
 
     void beginRenderPass(QRhiTextureRenderTarget *rt)
     {
-        renderPasses.append({ rt->pixelSize(), {}, {} });
-        currentRenderPassIndex = renderPasses.count() - 1;
+        if (isEnabled()) {
+            renderPasses.append({ rt->pixelSize(), {}, {} });
+            currentRenderPassIndex = renderPasses.count() - 1;
+        }
+        currentPipeline = nullptr;
+        currentSrb = nullptr;
     }
 
     void endRenderPass()
     {
         currentRenderPassIndex = -1;
+        currentPipeline = nullptr;
+        currentSrb = nullptr;
+    }
+
+    // Only actual changes are counted, matching what QRhi does since setting
+    // the same pipeline or srb again is a no-op there.
+    void setGraphicsPipeline(const QRhiGraphicsPipeline *ps)
+    {
+        if (ps == currentPipeline)
+            return;
+        switchStats.pipelineSwitches += 1;
+        if (isEnabled()) {
+            RenderPassInfo &rp(currentRenderPassIndex >= 0 ? renderPasses[currentRenderPassIndex] : externalRenderPass);
+            rp.pipelineSwitches += 1;
+        }
+        currentPipeline = ps;
+    }
+
+    void setShaderResources(const QRhiShaderResourceBindings *srb)
+    {
+        if (srb == currentSrb)
+            return;
+        switchStats.srbSwitches += 1;
+        if (isEnabled()) {
+            RenderPassInfo &rp(currentRenderPassIndex >= 0 ? renderPasses[currentRenderPassIndex] : externalRenderPass);
+            rp.srbSwitches += 1;
+        }
+        currentSrb = srb;
     }
 
     void drawIndexed(quint32 indexCount, quint32 instanceCount)
@@ -865,18 +1116,41 @@ public:
         QSize pixelSize;
         IndexedDrawInfo indexedDraws;
         DrawInfo draws;
+        quint32 pipelineSwitches = 0;
+        quint32 srbSwitches = 0;
     };
     QVector<RenderPassInfo> renderPasses;
     RenderPassInfo externalRenderPass;
+    QSSGRhiSwitchStats switchStats;
+    QSSGRhiShadowMapStats shadowMapStats;
     int currentRenderPassIndex = -1;
+    const QRhiGraphicsPipeline *currentPipeline = nullptr;
+    const QRhiShaderResourceBindings *currentSrb = nullptr;
     const void *rendererPtr = nullptr;
 
+    static void printCache(const char *name, const QSSGRhiCacheStats::Counters &c)
+    {
+        qDebug("%s cache: %d entries, %llu hits, %llu misses, %llu evictions, %.3f ms spent creating",
+               name, c.size, c.hits, c.misses, c.evictions, c.creationTimeNs / 1000000.0);
+    }
+
+    void printCacheStats(const QSSGRhiCacheStats &stats)
+    {
+        printCache("Graphics pipeline", stats.pipelines);
+        printCache("Shader resource bindings", stats.srbs);
+        printCache("Sampler", stats.samplers);
+        qDebug("Draw call data: %d entries, %llu evictions",
+               stats.drawCallData.size, stats.drawCallData.evictions);
+    }
+
     void printRenderPass(const RenderPassInfo &rp)
     {
         qDebug("%u indexed draw calls with %u indices in total, "
                "%u non-indexed draw calls with %u vertices in total",
                rp.indexedDraws.callCount, rp.indexedDraws.indexCount,
                rp.draws.callCount, rp.draws.vertexCount);
+        qDebug("%u pipeline switches, %u shader resource switches",
+               rp.pipelineSwitches, rp.srbSwitches);
         if (rp.indexedDraws.instancedCallCount || rp.draws.instancedCallCount) {
             qDebug("%u instanced indexed draw calls with %u indices and %u instances in total, "
                    "%u instanced non-indexed draw calls with %u indices and %u instances in total",
@@ -932,7 +1206,9 @@ public:
 
     QSSGRhiDrawCallData &drawCallData(const QSSGRhiDrawCallDataKey &key)
     {
-        return m_drawCallData[key];
+        QSSGRhiDrawCallData &dcd(m_drawCallData[key]);
+        dcd.lastUsedFrame = m_frameIndex;
+        return dcd;
     }
 
     QRhiSampler *sampler(const QSSGRhiSamplerDescription &samplerDescription);
@@ -944,19 +1220,31 @@ public:
 
     void cleanupDrawCallData(const QSSGRenderModel *model);
 
+    // Advances the frame counter the caches use to find out what has not
+    // been used for a while.
+    void beginFrame() { ++m_frameIndex; }
+    // Trims the pipeline, srb and draw call data caches to their budgets.
+    // Must only be called when no command buffer refers to the cached
+    // objects anymore, i.e. outside of recording a frame.
+    void releaseUnusedResources();
+    const QSSGRhiCacheStats &cacheStats();
+    // Defaults to the QT_QUICK3D_MAX_CACHED_* environment variables.
+    const QSSGRhiCacheLimits &cacheLimits() const { return m_cacheLimits; }
+    void setCacheLimits(const QSSGRhiCacheLimits &limits) { m_cacheLimits = limits; }
+
     QRhiTexture *dummyTexture(QRhiTexture::Flags flags, QRhiResourceUpdateBatch *rub,
                               const QSize &size = QSize(64, 64), const QColor &fillColor = Qt::black);
 
-    static inline QRhiCommandBuffer::BeginPassFlags commonPassFlags()
-    {
-        // We do not use GPU compute at all at the moment, this means we can
-        // get a small performance gain with OpenGL by declaring this.
-        return QRhiCommandBuffer::DoNotTrackResourcesForCompute;
-    }
+    static QRhiCommandBuffer::BeginPassFlags commonPassFlags();
 
     static bool shaderDebuggingEnabled();
     static bool editorMode();
 
+    // The on-disk driver pipeline cache, empty name when it is not used.
+    static QString pipelineCacheFileName(QRhi *rhi);
+    static QByteArray readPipelineCache(const QString &fileName);
+    static bool writePipelineCache(const QString &fileName, const QByteArray &data);
+
     QSSGRhiInstanceBufferData &instanceBufferData(QSSGRenderInstanceTable *instanceTable)
     {
         return m_instanceBuffers[instanceTable];
@@ -977,16 +1265,28 @@ private:
     QRhiRenderTarget *m_rt = nullptr;
     int m_mainSamples = 1;
     QHash<const void *, QSSGRhiGraphicsPipelineState> m_gfxPs;
-    QHash<QSSGRhiShaderResourceBindingList, QRhiShaderResourceBindings *> m_srbCache;
-    QHash<QSSGGraphicsPipelineStateKey, QRhiGraphicsPipeline *> m_pipelines;
+    template<typename T>
+    struct CachedResource
+    {
+        T *resource = nullptr;
+        quint32 lastUsedFrame = 0;
+    };
+    QHash<QSSGRhiShaderResourceBindingList, CachedResource<QRhiShaderResourceBindings>> m_srbCache;
+    QHash<QSSGGraphicsPipelineStateKey, CachedResource<QRhiGraphicsPipeline>> m_pipelines;
     QHash<QSSGComputePipelineStateKey, QRhiComputePipeline *> m_computePipelines;
     QHash<QSSGRhiDrawCallDataKey, QSSGRhiDrawCallData> m_drawCallData;
-    QVector<QPair<QSSGRhiSamplerDescription, QRhiSampler*>> m_samplers;
+    QHash<QSSGRhiSamplerDescription, QRhiSampler *> m_samplers;
     QSet<QRhiTexture *> m_textures;
     QHash<QSSGRhiDummyTextureKey, QRhiTexture *> m_dummyTextures;
     QHash<QSSGRenderInstanceTable *, QSSGRhiInstanceBufferData> m_instanceBuffers;
     QHash<const QSSGRenderGraphObject *, QSSGRhiParticleData> m_particleData;
     QSSGRhiContextStats m_stats;
+    // Where the driver's pipeline cache is kept between runs, empty if not.
+    QString m_pipelineCacheFile;
+    bool m_pipelineCacheDirty = false;
+    quint32 m_frameIndex = 0;
+    QSSGRhiCacheStats m_cacheStats;
+    QSSGRhiCacheLimits m_cacheLimits;
 };
 
 inline QRhiSampler::Filter toRhi(QSSGRenderTextureFilterOp op)
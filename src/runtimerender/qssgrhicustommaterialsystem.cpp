@@ -82,6 +82,7 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGCustomMaterialSystem::shadersForCustomMateria
     auto it = shaderMap.find(skey);
     if (it == shaderMap.end()) {
         Q_QUICK3D_PROFILE_START(QQuick3DProfiler::Quick3DGenerateShader);
+        bool deferred = false;
         QSSGMaterialVertexPipeline pipeline(context->shaderProgramGenerator(),
                                             context->renderer()->defaultMaterialShaderKeyProperties(),
                                             material.adapter,
@@ -98,9 +99,14 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGCustomMaterialSystem::shadersForCustomMateria
                                                                                 renderable.lights,
                                                                                 renderable.firstImage,
                                                                                 context->shaderLibraryManager(),
-                                                                                context->shaderCache());
+                                                                                context->shaderCache(),
+                                                                                &deferred);
         Q_QUICK3D_PROFILE_END(QQuick3DProfiler::Quick3DGenerateShader);
 
+        // Skipped until the shaders baked in the background are ready.
+        if (deferred)
+            return nullptr;
+
         // make skey useable as a key for the QHash (makes copies of materialKey and featureSet, instead of just referencing)
         skey.detach();
         // insert it no matter what, no point in trying over and over again
@@ -572,6 +578,8 @@ void QSSGCustomMaterialSystem::rhiRenderRenderable(QSSGRhiContext *rhiCtx,
     QRhiCommandBuffer *cb = rhiCtx->commandBuffer();
     cb->setGraphicsPipeline(ps);
     cb->setShaderResources(srb);
+    rhiCtx->stats().setGraphicsPipeline(ps);
+    rhiCtx->stats().setShaderResources(srb);
 
     if (*needsSetViewport) {
         if (!state)
@@ -35,6 +35,9 @@
 #include <QtQuick3DRuntimeRender/private/qssgrenderer_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrendercamera_p.h>
 
+#include <QtCore/QFile>
+#include <QtCore/qmath.h>
+
 QT_BEGIN_NAMESPACE
 
 static const QRhiShaderResourceBinding::StageFlags VISIBILITY_ALL =
@@ -65,16 +68,16 @@ void QSSGParticleRenderer::updateUniformsForParticles(QSSGRef<QSSGRhiShaderPipel
 {
     const QMatrix4x4 clipSpaceCorrMatrix = rhiCtx->rhi()->clipSpaceCorrMatrix();
 
-    QSSGRhiShaderPipeline::CommonUniformIndices &cui = shaders->commonUniformIndices;
+    using CommonUniform = QSSGRhiShaderPipeline::CommonUniform;
 
     const QMatrix4x4 projection = clipSpaceCorrMatrix * inCamera.projection;
-    shaders->setUniform(ubufData, "qt_projectionMatrix", projection.constData(), 16 * sizeof(float), &cui.projectionMatrixIdx);
+    shaders->setUniform(ubufData, CommonUniform::ProjectionMatrix, projection.constData(), 16 * sizeof(float));
 
     const QMatrix4x4 viewMatrix = inCamera.globalTransform.inverted();
-    shaders->setUniform(ubufData, "qt_viewMatrix", viewMatrix.constData(), 16 * sizeof(float), &cui.viewMatrixIdx);
+    shaders->setUniform(ubufData, CommonUniform::ViewMatrix, viewMatrix.constData(), 16 * sizeof(float));
 
     const QMatrix4x4 &modelMatrix = renderable.globalTransform;
-    shaders->setUniform(ubufData, "qt_modelMatrix", modelMatrix.constData(), 16 * sizeof(float), &cui.modelMatrixIdx);
+    shaders->setUniform(ubufData, CommonUniform::ModelMatrix, modelMatrix.constData(), 16 * sizeof(float));
 
     QVector2D oneOverSize = QVector2D(1.0f, 1.0f);
     auto &particleBuffer = renderable.particles.m_particleBuffer;
@@ -145,7 +148,7 @@ void QSSGParticleRenderer::updateUniformsForParticles(QSSGRef<QSSGRhiShaderPipel
         if (lightOffset >= 0)
             memcpy(ubufData + lightOffset, &lightData, sizeof(ParticleLightData));
     }
-    shaders->setUniform(ubufData, "qt_light_ambient_total", &theLightAmbientTotal, 3 * sizeof(float), &cui.light_ambient_totalIdx);
+    shaders->setUniform(ubufData, CommonUniform::LightAmbientTotal, &theLightAmbientTotal, 3 * sizeof(float));
     int enablePointLights = pointLight > 0 ? 1 : 0;
     int enableSpotLights = spotLight > 0 ? 1 : 0;
     shaders->setUniform(ubufData, "qt_pointLights", &enablePointLights, sizeof(int));
@@ -282,6 +285,283 @@ static void sortParticles(QByteArray &result, QList<QSSGRhiSortData> &sortData,
     copyParticles(result, sortData, buffer);
 }
 
+namespace {
+
+// Matches buf in particlesimulate.comp
+struct SimulationUniforms
+{
+    QSSGParticleAffectorData affectors[QSSGParticleSimulation::MaxAffectors];
+    float fade[4];
+    float sortDirection[4];
+    float offset[2];
+    float time;
+    float particleScale;
+    quint32 particleCount;
+    quint32 countPerSlice;
+    quint32 affectorCount;
+    quint32 randomCount;
+    quint32 sortCount;
+    quint32 unusedPadding[3];
+};
+
+static_assert(sizeof(QSSGParticleEmitData) == 96, "QSSGParticleEmitData must match EmitData in particlesimulate.comp");
+static_assert(sizeof(QSSGParticleAffectorData) == 112, "QSSGParticleAffectorData must match Affector in particlesimulate.comp");
+static_assert(sizeof(SimulationUniforms) == 976, "SimulationUniforms must match buf in particlesimulate.comp");
+
+// Matches buf in particlesort.comp
+struct SortUniforms
+{
+    quint32 j;
+    quint32 k;
+    quint32 sortCount;
+};
+
+// Matches buf in particlescatter.comp
+struct ScatterUniforms
+{
+    quint32 particleCount;
+    quint32 countPerSlice;
+};
+
+struct SimulationShaders
+{
+    QShader simulate;
+    QShader sort;
+    QShader scatter;
+
+    bool isValid() const { return simulate.isValid() && sort.isValid() && scatter.isValid(); }
+};
+
+}
+
+static const int SIMULATION_WORKGROUP_SIZE = QSSG_PARTICLE_WORKGROUP_SIZE;
+static const int SORT_ENTRY_SIZE = 8;
+
+static QShader loadComputeShader(const char *name)
+{
+    QFile f(QLatin1String(":/res/rhishaders/") + QLatin1String(name) + QLatin1String(".comp.qsb"));
+    if (!f.open(QIODevice::ReadOnly)) {
+        qWarning("Failed to open %s", qPrintable(f.fileName()));
+        return QShader();
+    }
+    return QShader::fromSerialized(f.readAll());
+}
+
+static const SimulationShaders &simulationShaders()
+{
+    static const SimulationShaders shaders = { loadComputeShader("particlesimulate"),
+                                               loadComputeShader("particlesort"),
+                                               loadComputeShader("particlescatter") };
+    return shaders;
+}
+
+// Returns true if the buffer was created or resized
+static bool ensureBuffer(QRhi *rhi, QRhiBuffer *&buffer, QRhiBuffer::Type type,
+                         QRhiBuffer::UsageFlags usage, quint32 size)
+{
+    // Zero sized buffers are not allowed, unused bindings still need one
+    size = std::max(size, 16u);
+    if (buffer && buffer->size() >= size)
+        return false;
+    if (!buffer) {
+        buffer = rhi->newBuffer(type, usage, size);
+    } else {
+        buffer->setSize(size);
+    }
+    if (!buffer->create())
+        qWarning("Failed to build particle simulation buffer of size %u", size);
+    return true;
+}
+
+bool QSSGParticleRenderer::prepareSimulation(QSSGRhiContext *rhiCtx,
+                                             const QSSGRenderParticles &particles,
+                                             const QVector3D &cameraDirection)
+{
+    QRhi *rhi = rhiCtx->rhi();
+    const SimulationShaders &shaders = simulationShaders();
+    if (!rhi->isFeatureSupported(QRhi::Compute) || !shaders.isValid())
+        return false;
+
+    const QSSGParticleSimulation &sim = particles.m_simulation;
+    QSSGRhiParticleData &particleData = rhiCtx->particleData(&particles);
+    QSSGRhiParticleData::Simulation &gpu = particleData.simulation;
+    Q_ASSERT(gpu.texturesLoadStore);
+
+    const bool sorting = particles.m_depthSorting;
+    QVector3D sortDirection;
+    if (sorting)
+        sortDirection = particles.globalTransform.inverted().map(cameraDirection).normalized();
+
+    // The particles are rendered to several passes per frame, simulate only once
+    if (gpu.serial == sim.serial && (!sorting || gpu.sortDirection == sortDirection))
+        return true;
+    gpu.serial = sim.serial;
+    gpu.sortDirection = sortDirection;
+
+    const QSSGParticleBuffer &particleBuffer = particles.m_particleBuffer;
+    const int particleCount = std::min(int(sim.emitData.size()), particleBuffer.particleCount());
+    if (particleCount == 0)
+        return true;
+    const quint32 sortCount = sorting ? qNextPowerOfTwo(quint32(particleCount - 1)) : 0;
+
+    QRhiResourceUpdateBatch *rub = rhi->nextResourceUpdateBatch();
+    bool buffersChanged = false;
+
+    // Emit data, only the slots the emitters have changed since the previous
+    // upload of this context are uploaded
+    const quint32 emitSize = particleCount * sizeof(QSSGParticleEmitData);
+    buffersChanged |= ensureBuffer(rhi, gpu.emitBuffer, QRhiBuffer::Static, QRhiBuffer::StorageBuffer, emitSize);
+    if (buffersChanged || gpu.emitSerial < sim.dirtyRangesBaseSerial || gpu.emitCount != particleCount) {
+        rub->uploadStaticBuffer(gpu.emitBuffer, 0, emitSize, sim.emitData.constData());
+    } else {
+        for (const QSSGParticleSimulation::Range &range : qAsConst(sim.dirtyRanges)) {
+            if (range.serial <= gpu.emitSerial)
+                continue;
+            const int begin = std::min(range.begin, particleCount);
+            const int end = std::min(range.end, particleCount);
+            if (end > begin) {
+                rub->uploadStaticBuffer(gpu.emitBuffer, begin * sizeof(QSSGParticleEmitData),
+                                        (end - begin) * sizeof(QSSGParticleEmitData),
+                                        sim.emitData.constData() + begin);
+            }
+        }
+    }
+    gpu.emitCount = particleCount;
+    gpu.emitSerial = sim.serial;
+
+    const int randomCount = sim.randomTable.size();
+    if (ensureBuffer(rhi, gpu.randomBuffer, QRhiBuffer::Static, QRhiBuffer::StorageBuffer, randomCount * sizeof(float))
+            || gpu.randomTableSerial != sim.randomTableSerial || gpu.randomCount != randomCount) {
+        buffersChanged = true;
+        if (randomCount)
+            rub->uploadStaticBuffer(gpu.randomBuffer, 0, randomCount * sizeof(float), sim.randomTable.constData());
+        gpu.randomTableSerial = sim.randomTableSerial;
+        gpu.randomCount = randomCount;
+    }
+
+    buffersChanged |= ensureBuffer(rhi, gpu.stateBuffer, QRhiBuffer::Static, QRhiBuffer::StorageBuffer,
+                                   sorting ? particleCount * sizeof(QSSGParticleSimple) : 0);
+    buffersChanged |= ensureBuffer(rhi, gpu.sortBuffer, QRhiBuffer::Static, QRhiBuffer::StorageBuffer,
+                                   sortCount * SORT_ENTRY_SIZE);
+    buffersChanged |= ensureBuffer(rhi, gpu.simulateUbuf, QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer,
+                                   sizeof(SimulationUniforms));
+    buffersChanged |= ensureBuffer(rhi, gpu.scatterUbuf, QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer,
+                                   sizeof(ScatterUniforms));
+
+    // Every step of the bitonic sort has its own uniforms at a dynamic offset
+    const quint32 sortUniformStride = rhi->ubufAligned(sizeof(SortUniforms));
+    int sortSteps = 0;
+    for (quint32 k = 2; k <= sortCount; k <<= 1) {
+        for (quint32 j = k >> 1; j > 0; j >>= 1)
+            sortSteps++;
+    }
+    buffersChanged |= ensureBuffer(rhi, gpu.sortUbuf, QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer,
+                                   std::max(sortSteps, 1) * sortUniformStride);
+
+    SimulationUniforms uniforms;
+    memset(&uniforms, 0, sizeof(uniforms));
+    const int affectorCount = std::min(int(sim.affectors.size()), int(QSSGParticleSimulation::MaxAffectors));
+    for (int i = 0; i < affectorCount; ++i)
+        uniforms.affectors[i] = sim.affectors.at(i);
+    uniforms.fade[0] = sim.fadeInDuration;
+    uniforms.fade[1] = sim.fadeOutDuration;
+    uniforms.fade[2] = float(sim.fadeInEffect);
+    uniforms.fade[3] = float(sim.fadeOutEffect);
+    uniforms.sortDirection[0] = sortDirection.x();
+    uniforms.sortDirection[1] = sortDirection.y();
+    uniforms.sortDirection[2] = sortDirection.z();
+    uniforms.sortDirection[3] = sorting ? 1.0f : 0.0f;
+    uniforms.offset[0] = sim.offset.x();
+    uniforms.offset[1] = sim.offset.y();
+    uniforms.time = sim.time;
+    uniforms.particleScale = sim.particleScale;
+    uniforms.particleCount = quint32(particleCount);
+    uniforms.countPerSlice = quint32(particleBuffer.particlesPerSlice());
+    uniforms.affectorCount = quint32(affectorCount);
+    uniforms.randomCount = quint32(randomCount);
+    uniforms.sortCount = sortCount;
+    rub->updateDynamicBuffer(gpu.simulateUbuf, 0, sizeof(uniforms), &uniforms);
+
+    if (sorting) {
+        QByteArray sortUniforms(sortSteps * sortUniformStride, Qt::Uninitialized);
+        int step = 0;
+        for (quint32 k = 2; k <= sortCount; k <<= 1) {
+            for (quint32 j = k >> 1; j > 0; j >>= 1) {
+                const SortUniforms u = { j, k, sortCount };
+                memcpy(sortUniforms.data() + step * sortUniformStride, &u, sizeof(u));
+                step++;
+            }
+        }
+        if (sortSteps)
+            rub->updateDynamicBuffer(gpu.sortUbuf, 0, sortUniforms.size(), sortUniforms.constData());
+        const ScatterUniforms scatter = { quint32(particleCount), uniforms.countPerSlice };
+        rub->updateDynamicBuffer(gpu.scatterUbuf, 0, sizeof(scatter), &scatter);
+    }
+    gpu.sortCount = int(sortCount);
+    gpu.sortSteps = sortSteps;
+
+    if (buffersChanged || !gpu.simulateSrb) {
+        const auto stage = QRhiShaderResourceBinding::ComputeStage;
+        delete gpu.simulateSrb;
+        gpu.simulateSrb = rhi->newShaderResourceBindings();
+        gpu.simulateSrb->setBindings({
+            QRhiShaderResourceBinding::uniformBuffer(0, stage, gpu.simulateUbuf),
+            QRhiShaderResourceBinding::bufferLoad(1, stage, gpu.emitBuffer),
+            QRhiShaderResourceBinding::bufferLoad(2, stage, gpu.randomBuffer),
+            QRhiShaderResourceBinding::bufferStore(3, stage, gpu.stateBuffer),
+            QRhiShaderResourceBinding::bufferStore(4, stage, gpu.sortBuffer),
+            QRhiShaderResourceBinding::imageStore(5, stage, particleData.texture, 0)
+        });
+        gpu.simulateSrb->create();
+
+        delete gpu.sortSrb;
+        gpu.sortSrb = rhi->newShaderResourceBindings();
+        gpu.sortSrb->setBindings({
+            QRhiShaderResourceBinding::uniformBufferWithDynamicOffset(0, stage, gpu.sortUbuf, sizeof(SortUniforms)),
+            QRhiShaderResourceBinding::bufferLoadStore(1, stage, gpu.sortBuffer)
+        });
+        gpu.sortSrb->create();
+
+        delete gpu.scatterSrb;
+        gpu.scatterSrb = rhi->newShaderResourceBindings();
+        gpu.scatterSrb->setBindings({
+            QRhiShaderResourceBinding::uniformBuffer(0, stage, gpu.scatterUbuf),
+            QRhiShaderResourceBinding::bufferLoad(1, stage, gpu.stateBuffer),
+            QRhiShaderResourceBinding::bufferLoad(2, stage, gpu.sortBuffer),
+            QRhiShaderResourceBinding::imageStore(3, stage, particleData.texture, 0)
+        });
+        gpu.scatterSrb->create();
+    }
+
+    QRhiCommandBuffer *cb = rhiCtx->commandBuffer();
+    cb->beginComputePass(rub);
+
+    const int simulateCount = std::max(particleCount, int(sortCount));
+    cb->setComputePipeline(rhiCtx->computePipeline(QSSGComputePipelineStateKey::create(shaders.simulate, gpu.simulateSrb),
+                                                   gpu.simulateSrb));
+    cb->setShaderResources(gpu.simulateSrb);
+    cb->dispatch((simulateCount + SIMULATION_WORKGROUP_SIZE - 1) / SIMULATION_WORKGROUP_SIZE, 1, 1);
+
+    if (sorting) {
+        const int sortGroups = (int(sortCount) + SIMULATION_WORKGROUP_SIZE - 1) / SIMULATION_WORKGROUP_SIZE;
+        cb->setComputePipeline(rhiCtx->computePipeline(QSSGComputePipelineStateKey::create(shaders.sort, gpu.sortSrb),
+                                                       gpu.sortSrb));
+        for (int step = 0; step < sortSteps; ++step) {
+            const QRhiCommandBuffer::DynamicOffset offset(0, quint32(step) * sortUniformStride);
+            cb->setShaderResources(gpu.sortSrb, 1, &offset);
+            cb->dispatch(sortGroups, 1, 1);
+        }
+
+        cb->setComputePipeline(rhiCtx->computePipeline(QSSGComputePipelineStateKey::create(shaders.scatter, gpu.scatterSrb),
+                                                       gpu.scatterSrb));
+        cb->setShaderResources(gpu.scatterSrb);
+        cb->dispatch((particleCount + SIMULATION_WORKGROUP_SIZE - 1) / SIMULATION_WORKGROUP_SIZE, 1, 1);
+    }
+
+    cb->endComputePass();
+    return true;
+}
+
 void QSSGParticleRenderer::rhiPrepareRenderable(QSSGRef<QSSGRhiShaderPipeline> &shaderPipeline,
                                                 QSSGRhiContext *rhiCtx,
                                                 QSSGRhiGraphicsPipelineState *ps,
@@ -310,18 +590,41 @@ void QSSGParticleRenderer::rhiPrepareRenderable(QSSGRef<QSSGRhiShaderPipeline> &
     dcd.ubuf->endFullDynamicBufferUpdateForCurrentFrame();
 
     QSSGRhiParticleData &particleData = rhiCtx->particleData(&renderable.particles);
-    const QSSGParticleBuffer &particleBuffer = renderable.particles.m_particleBuffer;
-    int particleCount = particleBuffer.particleCount();
-    if (particleData.texture == nullptr || particleData.particleCount != particleCount) {
-        QSize size(particleBuffer.size());
+    const QSSGParticleBuffer *particleBuffer = &renderable.particles.m_particleBuffer;
+    int particleCount = particleBuffer->particleCount();
+    const bool simulated = renderable.particles.m_simulation.enabled;
+    const bool textureLoadStore = simulated && rhiCtx->rhi()->isFeatureSupported(QRhi::Compute);
+    if (particleData.texture == nullptr || particleData.particleCount != particleCount
+            || particleData.simulation.texturesLoadStore != textureLoadStore) {
+        QSize size(particleBuffer->size());
+        const QRhiTexture::Flags flags = textureLoadStore ? QRhiTexture::UsedWithLoadStore : QRhiTexture::Flags();
         if (!particleData.texture) {
-            particleData.texture = rhiCtx->rhi()->newTexture(QRhiTexture::RGBA32F, size);
+            particleData.texture = rhiCtx->rhi()->newTexture(QRhiTexture::RGBA32F, size, 1, flags);
             particleData.texture->create();
         } else {
             particleData.texture->setPixelSize(size);
+            particleData.texture->setFlags(flags);
             particleData.texture->create();
         }
         particleData.particleCount = particleCount;
+        particleData.simulation.texturesLoadStore = textureLoadStore;
+        particleData.simulation.serial = -1;
+    }
+
+    const QVector3D cameraDirection = camera ? camera->getScalingCorrectDirection() : *inData.cameraDirection;
+
+    // The compute shaders write straight to the particle texture. Without
+    // compute support the same simulation runs on the CPU and the result is
+    // uploaded like the particle buffer normally is.
+    QSSGParticleBuffer simulatedBuffer;
+    if (simulated) {
+        if (prepareSimulation(rhiCtx, renderable.particles, cameraDirection)) {
+            particleBuffer = nullptr;
+        } else {
+            simulatedBuffer.resize(particleCount);
+            renderable.particles.m_simulation.simulate(simulatedBuffer);
+            particleBuffer = &simulatedBuffer;
+        }
     }
 
     bool sortingChanged = particleData.sorting != renderable.particles.m_depthSorting;
@@ -331,25 +634,24 @@ void QSSGParticleRenderer::rhiPrepareRenderable(QSSGRef<QSSGRhiShaderPipeline> &
     }
     particleData.sorting = renderable.particles.m_depthSorting;
 
-    QByteArray uploadData;
+    if (particleBuffer) {
+        QByteArray uploadData;
 
-    if (renderable.particles.m_depthSorting) {
-        bool animatedParticles = renderable.particles.m_featureLevel == QSSGRenderParticles::FeatureLevel::Animated;
-        if (!camera)
-            sortParticles(particleData.sortedData, particleData.sortData, particleBuffer, renderable.particles, *inData.cameraDirection, animatedParticles);
-        else
-            sortParticles(particleData.sortedData, particleData.sortData, particleBuffer, renderable.particles, camera->getScalingCorrectDirection(), animatedParticles);
-        uploadData = particleData.sortedData;
-    } else {
-        uploadData = particleBuffer.data();
-    }
+        if (renderable.particles.m_depthSorting) {
+            bool animatedParticles = renderable.particles.m_featureLevel == QSSGRenderParticles::FeatureLevel::Animated;
+            sortParticles(particleData.sortedData, particleData.sortData, *particleBuffer, renderable.particles, cameraDirection, animatedParticles);
+            uploadData = particleData.sortedData;
+        } else {
+            uploadData = particleBuffer->data();
+        }
 
-    QRhiResourceUpdateBatch *rub = rhiCtx->rhi()->nextResourceUpdateBatch();
-    QRhiTextureSubresourceUploadDescription upload;
-    upload.setData(uploadData);
-    QRhiTextureUploadDescription uploadDesc(QRhiTextureUploadEntry(0, 0, upload));
-    rub->uploadTexture(particleData.texture, uploadDesc);
-    rhiCtx->commandBuffer()->resourceUpdate(rub);
+        QRhiResourceUpdateBatch *rub = rhiCtx->rhi()->nextResourceUpdateBatch();
+        QRhiTextureSubresourceUploadDescription upload;
+        upload.setData(uploadData);
+        QRhiTextureUploadDescription uploadDesc(QRhiTextureUploadEntry(0, 0, upload));
+        rub->uploadTexture(particleData.texture, uploadDesc);
+        rhiCtx->commandBuffer()->resourceUpdate(rub);
+    }
 
     ps->ia.topology = QRhiGraphicsPipeline::TriangleStrip;
     ps->ia.inputLayout = QRhiVertexInputLayout();
@@ -558,6 +860,8 @@ void QSSGParticleRenderer::rhiRenderRenderable(QSSGRhiContext *rhiCtx,
     cb->setGraphicsPipeline(ps);
     cb->setVertexInput(0, 0, nullptr);
     cb->setShaderResources(srb);
+    rhiCtx->stats().setGraphicsPipeline(ps);
+    rhiCtx->stats().setShaderResources(srb);
 
     if (needsSetViewport && *needsSetViewport) {
         if (!state)
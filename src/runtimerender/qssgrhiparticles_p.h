@@ -57,7 +57,7 @@ struct QSSGRenderCamera;
 struct QSSGReflectionMapEntry;
 class QRhiTexture;
 
-class QSSGParticleRenderer
+class Q_QUICK3DRUNTIMERENDER_EXPORT QSSGParticleRenderer
 {
 public:
     static void updateUniformsForParticles(QSSGRef<QSSGRhiShaderPipeline> &shaderPipeline,
@@ -85,6 +85,9 @@ public:
                                     bool *needsSetViewport,
                                     int cubeFace,
                                     QSSGRhiGraphicsPipelineState *state);
+    static bool prepareSimulation(QSSGRhiContext *rhiCtx,
+                                  const QSSGRenderParticles &particles,
+                                  const QVector3D &cameraDirection);
     static void prepareParticlesForModel(QSSGRef<QSSGRhiShaderPipeline> &shaderPipeline,
                                          QSSGRhiContext *rhiCtx,
                                          QSSGRhiShaderResourceBindingList &bindings,
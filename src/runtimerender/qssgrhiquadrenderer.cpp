@@ -116,8 +116,11 @@ void QSSGRhiQuadRenderer::recordRenderQuad(QSSGRhiContext *rhiCtx,
     }
 
     QRhiCommandBuffer *cb = rhiCtx->commandBuffer();
-    cb->setGraphicsPipeline(rhiCtx->pipeline(QSSGGraphicsPipelineStateKey::create(*ps, rpDesc, srb), rpDesc, srb));
+    QRhiGraphicsPipeline *pipeline = rhiCtx->pipeline(QSSGGraphicsPipelineStateKey::create(*ps, rpDesc, srb), rpDesc, srb);
+    cb->setGraphicsPipeline(pipeline);
     cb->setShaderResources(srb);
+    rhiCtx->stats().setGraphicsPipeline(pipeline);
+    rhiCtx->stats().setShaderResources(srb);
     cb->setViewport(ps->viewport);
     QRhiCommandBuffer::VertexInput vb(m_vbuf->buffer(), 0);
     cb->setVertexInput(0, 1, &vb, m_ibuf->buffer(), m_ibuf->indexFormat());
@@ -131,10 +134,10 @@ void QSSGRhiQuadRenderer::recordRenderQuadPass(QSSGRhiContext *rhiCtx,
 {
     QRhiCommandBuffer *cb = rhiCtx->commandBuffer();
     cb->beginPass(rt, Qt::black, { 1.0f, 0 }, nullptr, QSSGRhiContext::commonPassFlags());
-    QSSGRHICTX_STAT(rhiCtx, beginRenderPass(rt));
+    rhiCtx->stats().beginRenderPass(rt);
     recordRenderQuad(rhiCtx, ps, srb, rt->renderPassDescriptor(), flags);
     cb->endPass();
-    QSSGRHICTX_STAT(rhiCtx, endRenderPass());
+    rhiCtx->stats().endRenderPass();
 }
 
 QT_END_NAMESPACE
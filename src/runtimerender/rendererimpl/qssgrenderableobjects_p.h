@@ -232,7 +232,10 @@ struct QSSGRenderableObjectHandle
 {
     QSSGRenderableObject *obj;
     float cameraDistanceSq;
-    static inline QSSGRenderableObjectHandle create(QSSGRenderableObject *o, float camDistSq = 0.0f) { return {o, camDistSq};}
+    // Packed key the render lists are radix sorted by, see
+    // QSSGLayerRenderPreparationData::getOpaqueRenderableObjects().
+    quint64 sortKey;
+    static inline QSSGRenderableObjectHandle create(QSSGRenderableObject *o, float camDistSq = 0.0f) { return {o, camDistSq, 0};}
 };
 Q_DECLARE_TYPEINFO(QSSGRenderableObjectHandle, Q_PRIMITIVE_TYPE);
 
@@ -325,6 +328,9 @@ struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGSubsetRenderable : public QSSGRenderabl
         struct {
             QRhiGraphicsPipeline *pipeline = nullptr;
             QRhiShaderResourceBindings *srb = nullptr;
+            // offsets into the layer's uniform ring, when srb uses it
+            QRhiCommandBuffer::DynamicOffset dynamicOffsets[2];
+            int dynamicOffsetCount = 0;
         } mainPass;
         struct {
             QRhiGraphicsPipeline *pipeline = nullptr;
@@ -332,7 +338,8 @@ struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGSubsetRenderable : public QSSGRenderabl
         } depthPrePass;
         struct {
             QRhiGraphicsPipeline *pipeline = nullptr;
-            QRhiShaderResourceBindings *srb[6] = {};
+            // per cube face, or per light in the shadow map atlas
+            QRhiShaderResourceBindings *srb[QSSG_MAX_NUM_SHADOW_MAPS] = {};
         } shadowPass;
         struct {
             QRhiGraphicsPipeline *pipeline = nullptr;
@@ -47,6 +47,8 @@
 #include <QtQuick3DUtils/private/qssgutils_p.h>
 
 #include <QtCore/QMutexLocker>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThreadPool>
 
 #include <cstdlib>
 #include <algorithm>
@@ -150,7 +152,8 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGRenderer::generateRhiShaderPipelineImpl(QSSGS
                                                                            const QSSGRef<QSSGProgramGenerator> &shaderProgramGenerator,
                                                                            QSSGShaderDefaultMaterialKeyProperties &shaderKeyProperties,
                                                                            const QSSGShaderFeatures &featureSet,
-                                                                           QByteArray &shaderString)
+                                                                           QByteArray &shaderString,
+                                                                           bool *deferred)
 {
     shaderString = logPrefix();
     QSSGShaderDefaultMaterialKey theKey(renderable.shaderDescription);
@@ -188,21 +191,24 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGRenderer::generateRhiShaderPipelineImpl(QSSGS
                                                                   renderable.lights,
                                                                   renderable.firstImage,
                                                                   shaderLibraryManager,
-                                                                  shaderCache);
+                                                                  shaderCache,
+                                                                  deferred);
 }
 
 QSSGRef<QSSGRhiShaderPipeline> QSSGRenderer::generateRhiShaderPipeline(QSSGSubsetRenderable &inRenderable,
-                                                                       const QSSGShaderFeatures &inFeatureSet)
+                                                                       const QSSGShaderFeatures &inFeatureSet,
+                                                                       bool *deferred)
 {
     const QSSGRef<QSSGShaderCache> &theCache = m_contextInterface->shaderCache();
     const auto &shaderProgramGenerator = contextInterface()->shaderProgramGenerator();
     const auto &shaderLibraryManager = contextInterface()->shaderLibraryManager();
-    return generateRhiShaderPipelineImpl(inRenderable, shaderLibraryManager, theCache, shaderProgramGenerator, m_defaultMaterialShaderKeyProperties, inFeatureSet, m_generatedShaderString);
+    return generateRhiShaderPipelineImpl(inRenderable, shaderLibraryManager, theCache, shaderProgramGenerator, m_defaultMaterialShaderKeyProperties, inFeatureSet, m_generatedShaderString, deferred);
 }
 
 void QSSGRenderer::beginFrame()
 {
-    QSSGRHICTX_STAT(m_contextInterface->rhiContext().data(), start(this));
+    m_contextInterface->rhiContext()->beginFrame();
+    m_contextInterface->rhiContext()->stats().start(this);
 }
 
 void QSSGRenderer::endFrame()
@@ -218,7 +224,8 @@ void QSSGRenderer::endFrame()
     }
     m_materialClearDirty.clear();
 
-    QSSGRHICTX_STAT(m_contextInterface->rhiContext().data(), stop());
+    m_contextInterface->rhiContext()->stats().stop();
+    QSSGRHICTX_STAT(m_contextInterface->rhiContext().data(), printCacheStats(m_contextInterface->rhiContext()->cacheStats()));
 }
 
 QSSGRenderer::PickResultList QSSGRenderer::syncPickAll(const QSSGRenderLayer &layer,
@@ -305,7 +312,12 @@ void QSSGRenderer::endLayerRender()
 
 bool QSSGRenderer::rendererRequestsFrames() const
 {
-    return m_progressiveAARenderRequest;
+    // Keep rendering while BVHs are built and images are decoded in the
+    // background, they are only picked up when preparing a frame.
+    return m_progressiveAARenderRequest
+            || (m_contextInterface && m_contextInterface->bufferManager()->hasPendingMeshBVHBuilds())
+            || (m_contextInterface && m_contextInterface->bufferManager()->hasPendingImageLoads())
+            || (m_contextInterface && m_contextInterface->shaderCache()->hasPendingBakes());
 }
 
 using RenderableList = QVarLengthArray<const QSSGRenderNode *>;
@@ -335,6 +347,111 @@ void QSSGRenderer::getLayerHitObjectList(const QSSGRenderLayer &layer,
     }
 }
 
+QVector<QSSGRenderer::PickResultList> QSSGRenderer::syncPickAll(const QSSGRenderLayer &layer,
+                                                                const QSSGRef<QSSGBufferManager> &bufferManager,
+                                                                const QVector<QSSGRenderRay> &rays)
+{
+    if (!layer.flags.testFlag(QSSGRenderLayer::Flag::Active))
+        return QVector<PickResultList>(rays.size());
+
+    RenderableList renderables;
+    for (const auto &childNode : layer.children)
+        dfs(childNode, renderables);
+
+    // Same order as getLayerHitObjectList(), so that equally distant hits
+    // come out the same as with single ray picking.
+    PickCandidateList candidates;
+    candidates.reserve(renderables.size());
+
+    // The meshes are only locked while their picking data is copied, see
+    // intersectRayWithSubsetRenderable() for why. The rays are traced
+    // without the lock, so that the render thread is not blocked.
+    {
+        QMutexLocker mutexLocker(bufferManager->meshUpdateMutex());
+        for (int idx = renderables.size() - 1; idx >= 0; --idx) {
+            const QSSGRenderNode *node = renderables.at(idx);
+            if (!m_globalPickingEnabled && !node->flags.testFlag(QSSGRenderNode::Flag::LocallyPickable))
+                continue;
+            if (node->type == QSSGRenderGraphObject::Type::Item2D) {
+                PickCandidate candidate;
+                candidate.node = node;
+                candidates.append(candidate);
+            } else if (node->type == QSSGRenderGraphObject::Type::Model) {
+                const QSSGRenderModel &model = static_cast<const QSSGRenderModel &>(*node);
+                const QSSGRenderMesh *mesh = bufferManager->getMeshForPicking(model);
+                if (mesh)
+                    candidates.append(pickCandidate(model, *mesh));
+            }
+        }
+    }
+
+    return intersectRaysWithCandidates(rays, candidates, QThreadPool::globalInstance());
+}
+
+QSSGRenderer::PickCandidate QSSGRenderer::pickCandidate(const QSSGRenderModel &model, const QSSGRenderMesh &mesh)
+{
+    PickCandidate candidate;
+    candidate.node = &model;
+    candidate.subsets.reserve(mesh.subsets.size());
+    for (const QSSGRenderSubset &subset : mesh.subsets)
+        candidate.subsets.append({ subset.bounds, subset.bvhRoot });
+    candidate.bvh = mesh.bvh;
+    return candidate;
+}
+
+QVector<QSSGRenderer::PickResultList> QSSGRenderer::intersectRaysWithCandidates(const QVector<QSSGRenderRay> &rays,
+                                                                                const PickCandidateList &candidates,
+                                                                                QThreadPool *threadPool)
+{
+    QVector<PickResultList> pickResults(rays.size());
+    if (rays.isEmpty() || candidates.isEmpty())
+        return pickResults;
+
+    // Rays are handed out in small chunks, to the calling thread and to the
+    // pool threads that happen to be idle. Every ray only writes to its own
+    // result list.
+    static constexpr int raysPerChunk = 16;
+    const int chunkCount = (int(rays.size()) + raysPerChunk - 1) / raysPerChunk;
+    QAtomicInt nextChunk;
+    const auto traceChunks = [&]() {
+        for (int chunk = nextChunk.fetchAndAddRelaxed(1); chunk < chunkCount; chunk = nextChunk.fetchAndAddRelaxed(1)) {
+            const int end = qMin(int(rays.size()), (chunk + 1) * raysPerChunk);
+            for (int rayIdx = chunk * raysPerChunk; rayIdx < end; ++rayIdx) {
+                const QSSGRenderRay &ray = rays.at(rayIdx);
+                PickResultList &rayResults = pickResults[rayIdx];
+                for (const PickCandidate &candidate : candidates) {
+                    if (candidate.node->type == QSSGRenderGraphObject::Type::Model) {
+                        const QSSGRenderModel &model = static_cast<const QSSGRenderModel &>(*candidate.node);
+                        intersectRayWithSubsets(ray, model, candidate.subsets, candidate.bvh.get(), rayResults);
+                    } else {
+                        const QSSGRenderItem2D &item2D = static_cast<const QSSGRenderItem2D &>(*candidate.node);
+                        intersectRayWithItem2D(ray, item2D, rayResults);
+                    }
+                }
+                std::stable_sort(rayResults.begin(), rayResults.end(), [](const QSSGRenderPickResult &lhs, const QSSGRenderPickResult &rhs) {
+                    return lhs.m_distanceSq < rhs.m_distanceSq;
+                });
+            }
+        }
+    };
+
+    QSemaphore helpersDone;
+    int helperCount = 0;
+    if (threadPool) {
+        const int maxHelpers = qMin(chunkCount, threadPool->maxThreadCount()) - 1;
+        while (helperCount < maxHelpers && threadPool->tryStart([&traceChunks, &helpersDone]() {
+                   traceChunks();
+                   helpersDone.release();
+               })) {
+            ++helperCount;
+        }
+    }
+    traceChunks();
+    helpersDone.acquire(helperCount);
+
+    return pickResults;
+}
+
 void QSSGRenderer::intersectRayWithSubsetRenderable(const QSSGRef<QSSGBufferManager> &bufferManager,
                                                     const QSSGRenderRay &inRay,
                                                     const QSSGRenderNode &node,
@@ -362,9 +479,28 @@ void QSSGRenderer::intersectRayWithSubsetRenderable(const QSSGRef<QSSGBufferMana
     if (!mesh)
         return;
 
+    intersectRayWithMesh(inRay, model, *mesh, outIntersectionResultList);
+}
+
+void QSSGRenderer::intersectRayWithMesh(const QSSGRenderRay &inRay,
+                                        const QSSGRenderModel &model,
+                                        const QSSGRenderMesh &mesh,
+                                        QSSGRenderer::PickResultList &outIntersectionResultList)
+{
+    intersectRayWithSubsets(inRay, model, mesh.subsets, mesh.bvh.get(), outIntersectionResultList);
+}
+
+// Subsets is a list of QSSGRenderSubset or PickCandidate::Subset, which both
+// have the bounds and the BVH root of a subset.
+template<typename Subsets>
+void QSSGRenderer::intersectRayWithSubsets(const QSSGRenderRay &inRay,
+                                           const QSSGRenderModel &model,
+                                           const Subsets &subMeshes,
+                                           const QSSGMeshBVH *bvh,
+                                           QSSGRenderer::PickResultList &outIntersectionResultList)
+{
     const auto &globalTransform = model.globalTransform;
     auto rayData = QSSGRenderRay::createRayData(globalTransform, inRay);
-    const auto &subMeshes = mesh->subsets;
     QSSGBounds3 modelBounds;
     for (const auto &subMesh : subMeshes)
         modelBounds.include(subMesh.bounds);
@@ -391,7 +527,7 @@ void QSSGRenderer::intersectRayWithSubsetRenderable(const QSSGRef<QSSGBufferMana
             hit = QSSGRenderRay::intersectWithAABBv2(rayData, subMesh.bvhRoot->boundingData);
             if (hit.intersects()) {
                 results.clear();
-                inRay.intersectWithBVH(rayData, subMesh.bvhRoot, mesh, results);
+                inRay.intersectWithBVH(rayData, subMesh.bvhRoot, bvh, results);
                 float subMeshMinRayLength = std::numeric_limits<float>::max();
                 for (const auto &subMeshResult : qAsConst(results)) {
                     if (subMeshResult.rayLengthSquared < subMeshMinRayLength) {
@@ -478,8 +614,13 @@ QSSGRef<QSSGRhiShaderPipeline> QSSGRenderer::getRhiShaders(QSSGSubsetRenderable
     auto it = m_shaderMap.find(skey);
     if (it == m_shaderMap.end()) {
         Q_QUICK3D_PROFILE_START(QQuick3DProfiler::Quick3DGenerateShader);
-        shaderPipeline = generateRhiShaderPipeline(inRenderable, inFeatureSet);
+        bool deferred = false;
+        shaderPipeline = generateRhiShaderPipeline(inRenderable, inFeatureSet, &deferred);
         Q_QUICK3D_PROFILE_END(QQuick3DProfiler::Quick3DGenerateShader);
+        // Being baked in the background, the renderable is skipped until the
+        // shaders are ready and are picked up in a later frame.
+        if (deferred)
+            return nullptr;
         // make skey useable as a key for the QHash (makes copies of materialKey and featureSet, instead of just referencing)
         skey.detach();
         // insert it no matter what, no point in trying over and over again
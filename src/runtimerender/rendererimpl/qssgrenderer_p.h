@@ -67,6 +67,7 @@
 QT_BEGIN_NAMESPACE
 
 class QSSGRhiQuadRenderer;
+class QThreadPool;
 
 class Q_QUICK3DRUNTIMERENDER_EXPORT QSSGRenderer
 {
@@ -107,6 +108,38 @@ public:
                                   const QSSGRenderRay &ray,
                                   QSSGRenderNode *target = nullptr);
 
+    // Same as syncPickAll() for each of the rays, but the pickable objects
+    // are only gathered once, and the rays are spread over the threads of
+    // the global thread pool. Returns one sorted result list per ray.
+    QVector<PickResultList> syncPickAll(const QSSGRenderLayer &layer,
+                                        const QSSGRef<QSSGBufferManager> &bufferManager,
+                                        const QVector<QSSGRenderRay> &rays);
+
+    // A pickable object, with what picking needs of its mesh copied, so that
+    // the rays can be traced while the meshes are updated. The BVH is shared
+    // with the mesh.
+    struct PickCandidate
+    {
+        struct Subset
+        {
+            QSSGBounds3 bounds;
+            const QSSGMeshBVHNode *bvhRoot = nullptr;
+        };
+        const QSSGRenderNode *node = nullptr;
+        // Models only
+        QVector<Subset> subsets;
+        std::shared_ptr<const QSSGMeshBVH> bvh;
+    };
+    using PickCandidateList = QVector<PickCandidate>;
+
+    static PickCandidate pickCandidate(const QSSGRenderModel &model, const QSSGRenderMesh &mesh);
+
+    // Intersects all the rays with all the candidates, on threadPool when
+    // given.
+    static QVector<PickResultList> intersectRaysWithCandidates(const QVector<QSSGRenderRay> &rays,
+                                                               const PickCandidateList &candidates,
+                                                               QThreadPool *threadPool = nullptr);
+
     // Setting this true enables picking for all the models, regardless of
     // the models pickable property.
     void setGlobalPickingEnabled(bool isEnabled);
@@ -125,7 +158,8 @@ public:
                                                                         const QSSGRef<QSSGProgramGenerator> &shaderProgramGenerator,
                                                                         QSSGShaderDefaultMaterialKeyProperties &shaderKeyProperties,
                                                                         const QSSGShaderFeatures &featureSet,
-                                                                        QByteArray &shaderString);
+                                                                        QByteArray &shaderString,
+                                                                        bool *deferred = nullptr);
 
     QSSGRef<QSSGRhiShaderPipeline> getRhiShaders(QSSGSubsetRenderable &inRenderable,
                                                const QSSGShaderFeatures &inFeatureSet);
@@ -162,13 +196,23 @@ protected:
                                                  const QSSGRenderNode &node,
                                                  PickResultList &outIntersectionResultList);
     static void intersectRayWithItem2D(const QSSGRenderRay &inRay, const QSSGRenderItem2D &item2D, PickResultList &outIntersectionResultList);
+    static void intersectRayWithMesh(const QSSGRenderRay &inRay,
+                                     const QSSGRenderModel &model,
+                                     const QSSGRenderMesh &mesh,
+                                     PickResultList &outIntersectionResultList);
+    template<typename Subsets>
+    static void intersectRayWithSubsets(const QSSGRenderRay &inRay,
+                                        const QSSGRenderModel &model,
+                                        const Subsets &subMeshes,
+                                        const QSSGMeshBVH *bvh,
+                                        PickResultList &outIntersectionResultList);
 
 private:
     friend class QSSGRenderContextInterface;
     void releaseResources();
     QSSGRef<QSSGRhiShaderPipeline> getBuiltinRhiShader(const QByteArray &name,
                                                        QSSGRef<QSSGRhiShaderPipeline> &storage);
-    QSSGRef<QSSGRhiShaderPipeline> generateRhiShaderPipeline(QSSGSubsetRenderable &inRenderable, const QSSGShaderFeatures &inFeatureSet);
+    QSSGRef<QSSGRhiShaderPipeline> generateRhiShaderPipeline(QSSGSubsetRenderable &inRenderable, const QSSGShaderFeatures &inFeatureSet, bool *deferred);
 
     QSSGRenderContextInterface *m_contextInterface = nullptr; //  We're own by the context interface
 
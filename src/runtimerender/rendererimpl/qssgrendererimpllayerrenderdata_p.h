@@ -78,6 +78,8 @@ struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGLayerRenderData : public QSSGLayerRende
     QSSGRhiRenderableTexture m_rhiDepthTexture;
     QSSGRhiRenderableTexture m_rhiAoTexture;
     QSSGRhiRenderableTexture m_rhiScreenTexture;
+    // Per-frame storage for the uniforms of the main pass
+    QSSGRhiUniformRing m_uniformRing;
 
     // ProgressiveAA algorithm details.
     quint32 m_progressiveAAPassIndex;
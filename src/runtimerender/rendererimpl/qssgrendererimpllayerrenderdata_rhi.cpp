@@ -35,6 +35,8 @@
 #include <QtQuick3DRuntimeRender/private/qssgrhicustommaterialsystem_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrhiquadrenderer_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrhiparticles_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrendergeometry_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrendertexturedata_p.h>
 #include <QtQuick/private/qsgtexture_p.h>
 #include <QtQuick/private/qsgrenderer_p.h>
 
@@ -357,12 +359,29 @@ static void rhiPrepareRenderable(QSSGRhiContext *rhiCtx,
                                                    : rhiCtx->drawCallData({ layerNode, modelNode,
                                                                             &subsetRenderable.material, 0, QSSGRhiDrawCallDataKey::Main }));
 
-            shaderPipeline->ensureCombinedMainLightsUniformBuffer(&dcd.ubuf);
-            char *ubufData = dcd.ubuf->beginFullDynamicBufferUpdateForCurrentFrame();
+            // The main pass takes its uniforms from the per-frame ring, the
+            // passes recorded already while preparing keep using a buffer
+            // per draw call.
+            QSSGRhiUniformRing::Allocation ringAlloc;
+            if (cubeFace < 0 && QSSGRhiUniformRing::isEnabled()) {
+                ringAlloc = inData.m_uniformRing.allocate(rhiCtx->rhi(),
+                                                          shaderPipeline->ub0LightDataOffset() + int(sizeof(QSSGShaderLightsUniformData)));
+            }
+            char *ubufData = ringAlloc.data;
+            if (!ringAlloc.buffer) {
+                shaderPipeline->ensureCombinedMainLightsUniformBuffer(&dcd.ubuf);
+                ubufData = dcd.ubuf->beginFullDynamicBufferUpdateForCurrentFrame();
+            }
             updateUniformsForDefaultMaterial(shaderPipeline, rhiCtx, ubufData, ps, subsetRenderable, *camera, nullptr, alteredModelViewProjection);
             if (blendParticles)
                 QSSGParticleRenderer::updateUniformsForParticleModel(shaderPipeline, ubufData, &subsetRenderable.modelContext.model, subsetRenderable.subset.offset);
-            dcd.ubuf->endFullDynamicBufferUpdateForCurrentFrame();
+            if (ringAlloc.buffer) {
+                inData.m_uniformRing.shrinkLast(rhiCtx->rhi(), shaderPipeline->isLightingEnabled()
+                                                ? shaderPipeline->ub0LightDataOffset() + shaderPipeline->ub0LightDataSize()
+                                                : shaderPipeline->ub0Size());
+            } else {
+                dcd.ubuf->endFullDynamicBufferUpdateForCurrentFrame();
+            }
 
             if (blendParticles)
                 QSSGParticleRenderer::prepareParticlesForModel(shaderPipeline, rhiCtx, bindings, &subsetRenderable.modelContext.model);
@@ -379,12 +398,30 @@ static void rhiPrepareRenderable(QSSGRhiContext *rhiCtx,
             int instanceBufferBinding = setupInstancing(&subsetRenderable, ps, rhiCtx, cameraDirection);
             ps->ia.bakeVertexInputLocations(*shaderPipeline, instanceBufferBinding);
 
-            bindings.addUniformBuffer(0, VISIBILITY_ALL, dcd.ubuf, 0, shaderPipeline->ub0Size());
-
-            if (shaderPipeline->isLightingEnabled()) {
-                bindings.addUniformBuffer(1, VISIBILITY_ALL, dcd.ubuf,
-                                          shaderPipeline->ub0LightDataOffset(),
-                                          shaderPipeline->ub0LightDataSize());
+            if (ringAlloc.buffer) {
+                // With dynamic offsets the srb does not depend on where the
+                // data is, so it can be shared by all draw calls with the
+                // same textures.
+                auto &mainPass(subsetRenderable.rhiRenderData.mainPass);
+                bindings.addUniformBufferWithDynamicOffset(0, VISIBILITY_ALL, ringAlloc.buffer, shaderPipeline->ub0Size());
+                mainPass.dynamicOffsets[0] = { 0, ringAlloc.offset };
+                mainPass.dynamicOffsetCount = 1;
+                if (shaderPipeline->isLightingEnabled()) {
+                    bindings.addUniformBufferWithDynamicOffset(1, VISIBILITY_ALL, ringAlloc.buffer,
+                                                               shaderPipeline->ub0LightDataSize());
+                    mainPass.dynamicOffsets[1] = { 1, ringAlloc.offset + quint32(shaderPipeline->ub0LightDataOffset()) };
+                    mainPass.dynamicOffsetCount = 2;
+                }
+            } else {
+                if (cubeFace < 0)
+                    subsetRenderable.rhiRenderData.mainPass.dynamicOffsetCount = 0;
+                bindings.addUniformBuffer(0, VISIBILITY_ALL, dcd.ubuf, 0, shaderPipeline->ub0Size());
+
+                if (shaderPipeline->isLightingEnabled()) {
+                    bindings.addUniformBuffer(1, VISIBILITY_ALL, dcd.ubuf,
+                                              shaderPipeline->ub0LightDataOffset(),
+                                              shaderPipeline->ub0LightDataSize());
+                }
             }
 
             // Texture maps
@@ -840,6 +877,8 @@ static void rhiRenderDepthPassForObject(QSSGRhiContext *rhiCtx,
 
         cb->setGraphicsPipeline(ps);
         cb->setShaderResources(srb);
+        rhiCtx->stats().setGraphicsPipeline(ps);
+        rhiCtx->stats().setShaderResources(srb);
 
         if (*needsSetViewport) {
             cb->setViewport(rhiCtx->graphicsPipelineState(&inData)->viewport);
@@ -1001,11 +1040,28 @@ static void setupCubeReflectionCameras(const QSSGRenderReflectionProbe *inProbe,
     }
 }
 
+// The part of the camera frustum between two distances from the camera, for
+// one cascade of a directional light's shadow map.
+static BoxPoints computeFrustumSlice(const BoxPoints &frustumPoints, float clipNear, float clipFar, float sliceNear, float sliceFar)
+{
+    const float t0 = (sliceNear - clipNear) / (clipFar - clipNear);
+    const float t1 = (sliceFar - clipNear) / (clipFar - clipNear);
+    BoxPoints slice;
+    for (int i = 0; i < 4; ++i) {
+        // the edges of the frustum run from the near (0-3) to the far (4-7) corners
+        const QVector3D edge = frustumPoints[i + 4] - frustumPoints[i];
+        slice[i] = frustumPoints[i] + edge * t0;
+        slice[i + 4] = frustumPoints[i] + edge * t1;
+    }
+    return slice;
+}
+
 static void setupCameraForShadowMap(const QSSGRenderCamera &inCamera,
                                     const QSSGRenderLight *inLight,
                                     QSSGRenderCamera &theCamera,
                                     const BoxPoints &castingBox,
-                                    const BoxPoints &receivingBox)
+                                    const BoxPoints &receivingBox,
+                                    const BoxPoints *frustumSlice = nullptr)
 {
     // setup light matrix
     quint32 mapRes = 1 << inLight->m_shadowMapRes;
@@ -1036,8 +1092,18 @@ static void setupCameraForShadowMap(const QSSGRenderCamera &inCamera,
 
         QVector3D finalDims;
         QVector3D center;
-        // Select smallest bounds from either scene or camera frustum
-        if (sceneCastingBounds.isFinite() // handle empty scene
+        if (frustumSlice) {
+            // A cascade covers its slice of the camera frustum, extended
+            // towards the light so that casters outside the slice still
+            // shadow it.
+            QSSGBounds3 bounds = calculateShadowCameraBoundingBox(*frustumSlice, forward, up, right);
+            if (sceneCastingBounds.isFinite())
+                bounds.minimum.setZ(qMin(bounds.minimum.z(), sceneCastingBounds.minimum.z()));
+            const QVector3D c = bounds.center();
+            center = right * c.x() + up * c.y() + forward * c.z();
+            finalDims = bounds.dimensions();
+        } else if (sceneCastingBounds.isFinite() // handle empty scene
+            // Select smallest bounds from either scene or camera frustum
             && sceneCastingBounds.extents().lengthSquared() < frustumBounds.extents().lengthSquared()) {
             center = calcCenter(castingBox);
             const QSSGBounds3 boundsReceiving = calculateShadowCameraBoundingBox(receivingBox, forward, up, right);
@@ -1104,6 +1170,25 @@ static void setupCameraForShadowMap(const QSSGRenderCamera &inCamera,
     theCamera.calculateGlobalVariables(theViewport);
 }
 
+static void setupCameraForCascade(const QSSGRenderCamera &inCamera,
+                                  const BoxPoints &frustumPoints,
+                                  const QSSGRenderLight *inLight,
+                                  const QSSGShadowMapEntry *pEntry,
+                                  int cascade,
+                                  QSSGRenderCamera &theCamera,
+                                  const BoxPoints &castingBox,
+                                  const BoxPoints &receivingBox)
+{
+    if (pEntry->m_cascadeCount <= 1) {
+        setupCameraForShadowMap(inCamera, inLight, theCamera, castingBox, receivingBox);
+        return;
+    }
+    const float sliceNear = cascade > 0 ? pEntry->m_cascadeSplits[cascade - 1] : inCamera.clipNear;
+    const BoxPoints slice = computeFrustumSlice(frustumPoints, inCamera.clipNear, inCamera.clipFar,
+                                                sliceNear, pEntry->m_cascadeSplits[cascade]);
+    setupCameraForShadowMap(inCamera, inLight, theCamera, castingBox, receivingBox, &slice);
+}
+
 static void setupCubeShadowCameras(const QSSGRenderLight *inLight, QSSGRenderCamera inCameras[6])
 {
     Q_ASSERT(inLight != nullptr);
@@ -1266,7 +1351,9 @@ static void rhiPrepareResourcesForReflectionMap(QSSGRhiContext *rhiCtx,
     }
 }
 
-static void rhiPrepareResourcesForShadowMap(QSSGRhiContext *rhiCtx,
+// Returns false when some casters could not be prepared, for example because
+// their shaders are not ready yet.
+static bool rhiPrepareResourcesForShadowMap(QSSGRhiContext *rhiCtx,
                                             QSSGLayerRenderData &inData,
                                             QSSGShadowMapEntry *pEntry,
                                             QSSGRhiGraphicsPipelineState *ps,
@@ -1282,6 +1369,7 @@ static void rhiPrepareResourcesForShadowMap(QSSGRhiContext *rhiCtx,
     else
         featureSet.set(QSSGShaderFeatures::Feature::CubeShadowPass, true);
 
+    bool complete = true;
     for (const auto &handle : sortedOpaqueObjects) {
         QSSGRenderableObject *theObject = handle.obj;
         if (!theObject->renderableFlags.castsShadows())
@@ -1309,8 +1397,10 @@ static void rhiPrepareResourcesForShadowMap(QSSGRhiContext *rhiCtx,
             const bool blendParticles = subsetRenderable.generator->contextInterface()->renderer()->defaultMaterialShaderKeyProperties().m_blendParticles.getValue(subsetRenderable.shaderDescription);
 
             shaderPipeline = shadersForDefaultMaterial(ps, subsetRenderable, objectFeatureSet);
-            if (!shaderPipeline)
+            if (!shaderPipeline) {
+                complete = false;
                 continue;
+            }
             shaderPipeline->ensureCombinedMainLightsUniformBuffer(&dcd->ubuf);
             char *ubufData = dcd->ubuf->beginFullDynamicBufferUpdateForCurrentFrame();
             updateUniformsForDefaultMaterial(shaderPipeline, rhiCtx, ubufData, ps, subsetRenderable, inCamera, depthAdjust, &modelViewProjection);
@@ -1324,8 +1414,10 @@ static void rhiPrepareResourcesForShadowMap(QSSGRhiContext *rhiCtx,
 
             QSSGCustomMaterialSystem &customMaterialSystem(*subsetRenderable.generator->contextInterface()->customMaterialSystem().data());
             shaderPipeline = customMaterialSystem.shadersForCustomMaterial(ps, subsetRenderable.customMaterial(), subsetRenderable, objectFeatureSet);
-            if (!shaderPipeline)
+            if (!shaderPipeline) {
+                complete = false;
                 continue;
+            }
             shaderPipeline->ensureCombinedMainLightsUniformBuffer(&dcd->ubuf);
             char *ubufData = dcd->ubuf->beginFullDynamicBufferUpdateForCurrentFrame();
             // inCamera is the shadow camera, not the same as inData.camera
@@ -1378,6 +1470,7 @@ static void rhiPrepareResourcesForShadowMap(QSSGRhiContext *rhiCtx,
             subsetRenderable.rhiRenderData.shadowPass.srb[cubeFace] = srb;
         }
     }
+    return complete;
 }
 
 static void rhiRenderRenderable(QSSGRhiContext *rhiCtx,
@@ -1415,7 +1508,11 @@ static void rhiRenderOneShadowMap(QSSGRhiContext *rhiCtx,
             cb->setGraphicsPipeline(renderable->rhiRenderData.shadowPass.pipeline);
 
             QRhiShaderResourceBindings *srb = renderable->rhiRenderData.shadowPass.srb[cubeFace];
+            if (!srb)
+                continue;
             cb->setShaderResources(srb);
+            rhiCtx->stats().setGraphicsPipeline(renderable->rhiRenderData.shadowPass.pipeline);
+            rhiCtx->stats().setShaderResources(srb);
 
             if (needsSetViewport) {
                 cb->setViewport(ps->viewport);
@@ -1448,29 +1545,26 @@ static void rhiBlurShadowMap(QSSGRhiContext *rhiCtx,
                              QSSGShadowMapEntry *pEntry,
                              const QSSGRef<QSSGRenderer> &renderer,
                              float shadowFilter,
-                             float shadowMapFar,
-                             bool orthographic)
+                             float shadowMapFar)
 {
     // may not be able to do the blur pass if the number of max color
     // attachments is the gl/vk spec mandated minimum of 4, and we need 6.
-    // (applicable only to !orthographic, whereas orthographic always works)
     if (!pEntry->m_rhiBlurRenderTarget0 || !pEntry->m_rhiBlurRenderTarget1)
         return;
 
     QRhi *rhi = rhiCtx->rhi();
     QSSGRhiGraphicsPipelineState ps;
-    QRhiTexture *map = orthographic ? pEntry->m_rhiDepthMap : pEntry->m_rhiDepthCube;
-    QRhiTexture *workMap = orthographic ? pEntry->m_rhiDepthCopy : pEntry->m_rhiCubeCopy;
+    QRhiTexture *map = pEntry->m_rhiDepthCube;
+    QRhiTexture *workMap = pEntry->m_rhiCubeCopy;
     const QSize size = map->pixelSize();
     ps.viewport = QRhiViewport(0, 0, float(size.width()), float(size.height()));
 
-    QSSGRef<QSSGRhiShaderPipeline> shaderPipeline = orthographic ? renderer->getRhiOrthographicShadowBlurXShader()
-                                                               : renderer->getRhiCubemapShadowBlurXShader();
+    QSSGRef<QSSGRhiShaderPipeline> shaderPipeline = renderer->getRhiCubemapShadowBlurXShader();
     if (!shaderPipeline)
         return;
     ps.shaderPipeline = shaderPipeline.data();
 
-    ps.colorAttachmentCount = orthographic ? 1 : 6;
+    ps.colorAttachmentCount = 6;
 
     // construct a key that is unique for this frame (we use a dynamic buffer
     // so even if the same key gets used in the next frame, just updating the
@@ -1505,16 +1599,12 @@ static void rhiBlurShadowMap(QSSGRhiContext *rhiCtx,
     bindings.addTexture(1, QRhiShaderResourceBinding::FragmentStage, map, sampler);
     QRhiShaderResourceBindings *srb = rhiCtx->srb(bindings);
 
-    QSSGRhiQuadRenderer::Flags quadFlags;
-    if (orthographic) // orthoshadowshadowblurx and y have attr_uv as well
-        quadFlags |= QSSGRhiQuadRenderer::UvCoords;
     renderer->rhiQuadRenderer()->prepareQuad(rhiCtx, nullptr);
-    renderer->rhiQuadRenderer()->recordRenderQuadPass(rhiCtx, &ps, srb, pEntry->m_rhiBlurRenderTarget0, quadFlags);
+    renderer->rhiQuadRenderer()->recordRenderQuadPass(rhiCtx, &ps, srb, pEntry->m_rhiBlurRenderTarget0, {});
 
-    // repeat for blur Y, now depthCopy -> depthMap or cubeCopy -> depthCube
+    // repeat for blur Y, now cubeCopy -> depthCube
 
-    shaderPipeline = orthographic ? renderer->getRhiOrthographicShadowBlurYShader()
-                                  : renderer->getRhiCubemapShadowBlurYShader();
+    shaderPipeline = renderer->getRhiCubemapShadowBlurYShader();
     if (!shaderPipeline)
         return;
     ps.shaderPipeline = shaderPipeline.data();
@@ -1525,7 +1615,181 @@ static void rhiBlurShadowMap(QSSGRhiContext *rhiCtx,
     srb = rhiCtx->srb(bindings);
 
     renderer->rhiQuadRenderer()->prepareQuad(rhiCtx, nullptr);
-    renderer->rhiQuadRenderer()->recordRenderQuadPass(rhiCtx, &ps, srb, pEntry->m_rhiBlurRenderTarget1, quadFlags);
+    renderer->rhiQuadRenderer()->recordRenderQuadPass(rhiCtx, &ps, srb, pEntry->m_rhiBlurRenderTarget1, {});
+}
+
+// One tile of the atlas: the map of a light, or of one cascade of it
+struct QSSGAtlasShadowMap
+{
+    QSSGShadowMapEntry *entry;
+    const QSSGRenderLight *light;
+    int cascade;
+    QVector<QSSGRenderableObjectHandle> culledCasters;
+    const QVector<QSSGRenderableObjectHandle> *casters;
+    size_t signature;
+};
+
+// Blurs the tiles of all lights in the shadow map atlas, with one pass for
+// each direction.
+static void rhiBlurShadowMapAtlas(QSSGRhiContext *rhiCtx,
+                                  const QSSGRenderShadowMap::Atlas &atlas,
+                                  const QVarLengthArray<QSSGAtlasShadowMap, QSSG_MAX_NUM_SHADOW_MAPS> &shadowMaps,
+                                  const QSSGRef<QSSGRenderer> &renderer)
+{
+    QRhi *rhi = rhiCtx->rhi();
+    QRhiCommandBuffer *cb = rhiCtx->commandBuffer();
+
+    QSSGRef<QSSGRhiShaderPipeline> blurX = renderer->getRhiOrthographicShadowBlurXShader();
+    QSSGRef<QSSGRhiShaderPipeline> blurY = renderer->getRhiOrthographicShadowBlurYShader();
+    if (!blurX || !blurY)
+        return;
+
+    // see rhiBlurShadowMap()
+    QMatrix4x4 flipY;
+    if (rhi->isYUpInFramebuffer() != rhi->isYUpInNDC())
+        flipY.data()[5] = -1.0f;
+
+    QVarLengthArray<QRhiBuffer *, QSSG_MAX_NUM_SHADOW_MAPS> ubufs;
+    for (const QSSGAtlasShadowMap &shadowMap : shadowMaps) {
+        QSSGRhiDrawCallData &dcd = rhiCtx->drawCallData({ atlas.texture, nullptr, shadowMap.entry, shadowMap.cascade, QSSGRhiDrawCallDataKey::ShadowBlur });
+        if (!dcd.ubuf) {
+            dcd.ubuf = rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 64 + 16 + 16);
+            dcd.ubuf->create();
+        }
+        // The blur radius is relative to the size of the light's own map.
+        const QVector4D &uvRect(shadowMap.entry->m_atlasUvRect[shadowMap.cascade]);
+        const float cameraProperties[2] = { shadowMap.light->m_shadowFilter * uvRect.z(), shadowMap.light->m_shadowMapFar };
+        char *ubufData = dcd.ubuf->beginFullDynamicBufferUpdateForCurrentFrame();
+        memcpy(ubufData, flipY.constData(), 64);
+        memcpy(ubufData + 64, cameraProperties, 8);
+        memcpy(ubufData + 80, &uvRect, 16);
+        dcd.ubuf->endFullDynamicBufferUpdateForCurrentFrame();
+        ubufs.append(dcd.ubuf);
+    }
+
+    QRhiSampler *sampler = rhiCtx->sampler({ QRhiSampler::Linear, QRhiSampler::Linear, QRhiSampler::None,
+                                             QRhiSampler::ClampToEdge, QRhiSampler::ClampToEdge, QRhiSampler::Repeat });
+    renderer->rhiQuadRenderer()->prepareQuad(rhiCtx, nullptr);
+
+    const struct {
+        QSSGRhiShaderPipeline *shaderPipeline;
+        QRhiTexture *source;
+        QRhiTextureRenderTarget *rt;
+    } passes[2] = {
+        { blurX.data(), atlas.texture, atlas.blurRenderTarget0 }, // texture -> copy
+        { blurY.data(), atlas.copy, atlas.blurRenderTarget1 } // copy -> texture
+    };
+    for (const auto &pass : passes) {
+        // Clear to "no shadow", so that the borders of the tiles stay lit.
+        cb->beginPass(pass.rt, Qt::white, { 1.0f, 0 }, nullptr, QSSGRhiContext::commonPassFlags());
+        rhiCtx->stats().beginRenderPass(pass.rt);
+        for (int i = 0; i < shadowMaps.count(); ++i) {
+            const QRect &tile(shadowMaps[i].entry->m_atlasRect[shadowMaps[i].cascade]);
+            QSSGRhiGraphicsPipelineState ps;
+            ps.shaderPipeline = pass.shaderPipeline;
+            ps.viewport = QRhiViewport(tile.x(), tile.y(), tile.width(), tile.height());
+            QSSGRhiShaderResourceBindingList bindings;
+            bindings.addUniformBuffer(0, VISIBILITY_ALL, ubufs[i]);
+            bindings.addTexture(1, QRhiShaderResourceBinding::FragmentStage, pass.source, sampler);
+            QRhiShaderResourceBindings *srb = rhiCtx->srb(bindings);
+            renderer->rhiQuadRenderer()->recordRenderQuad(rhiCtx, &ps, srb, atlas.blurRenderPassDesc,
+                                                          QSSGRhiQuadRenderer::UvCoords);
+        }
+        cb->endPass();
+        rhiCtx->stats().endRenderPass();
+    }
+}
+
+// Drops the models that are completely outside of a 2D shadow map's light
+// frustum. These would be clipped anyway, but not before going through the
+// whole pipeline.
+static const QVector<QSSGRenderableObjectHandle> &cullShadowCasters(QSSGLayerRenderData &inData,
+                                                                    const QMatrix4x4 &lightViewProjection,
+                                                                    const QVector<QSSGRenderableObjectHandle> &objects,
+                                                                    QVector<QSSGRenderableObjectHandle> &culledObjects)
+{
+    if (inData.sceneBVH.isEmpty())
+        return objects;
+
+    inData.sceneBVH.cull(QSSGClippingFrustum(lightViewProjection), inData.shadowCasterVisibility,
+                         inData.transformStore.size(), inData.cullingStats);
+    culledObjects.clear();
+    for (const QSSGRenderableObjectHandle &handle : objects) {
+        const QSSGRenderableObject *theObject = handle.obj;
+        if (theObject->renderableFlags.isDefaultMaterialMeshSubset() || theObject->renderableFlags.isCustomMaterialMeshSubset()) {
+            const QSSGSubsetRenderable *renderable = static_cast<const QSSGSubsetRenderable *>(theObject);
+            const qint32 slot = qint32(renderable->modelContext.model.dfsIndex) - 1;
+            if (inData.shadowCasterVisibility.at(slot) == QSSGRenderSceneBVH::Visibility::Outside)
+                continue;
+        }
+        culledObjects.append(handle);
+    }
+    return culledObjects;
+}
+
+static bool shadowMapCacheEnabled()
+{
+    static const bool enabled = qEnvironmentVariableIntValue("QT_QUICK3D_DISABLE_SHADOW_MAP_CACHE") == 0;
+    return enabled;
+}
+
+// Hashes what the contents of a shadow map depend on on the casters' side:
+// which meshes are drawn, where, and with which alpha textures. Custom
+// geometry and texture data can change without their buffers or textures
+// being recreated, so their generations are part of it. Returns 0 when a
+// caster's geometry changes in ways not visible from here (skinning, morphing,
+// particles, custom vertex shaders) or it is alpha tested with a texture from
+// Qt Quick, the map must then be rendered every frame.
+static size_t shadowCasterSignature(const QVector<QSSGRenderableObjectHandle> &casters, size_t seed)
+{
+    for (const QSSGRenderableObjectHandle &handle : casters) {
+        const QSSGRenderableObject *theObject = handle.obj;
+        if (!theObject->renderableFlags.castsShadows())
+            continue;
+        if (!theObject->renderableFlags.isDefaultMaterialMeshSubset() && !theObject->renderableFlags.isCustomMaterialMeshSubset())
+            continue;
+
+        const QSSGSubsetRenderable *renderable = static_cast<const QSSGSubsetRenderable *>(theObject);
+        const QSSGRenderModel &model(renderable->modelContext.model);
+        if (model.skin || model.skeleton || !model.morphWeights.isEmpty() || model.particleBuffer)
+            return 0;
+        if (theObject->renderableFlags.isCustomMaterialMeshSubset()
+                && renderable->customMaterial().m_customShaderPresence.testFlag(QSSGRenderCustomMaterial::CustomShaderPresenceFlag::Vertex))
+            return 0;
+
+        seed = qHash(&model, seed);
+        seed = qHash(renderable->subset.rhi.vertexBuffer.data(), seed);
+        // Partial updates of custom geometry keep the buffers
+        if (model.geometry)
+            seed = qHash(model.geometry->generationId(), seed);
+        seed = qHash(renderable->subset.offset, seed);
+        seed = qHash(renderable->subset.count, seed);
+        seed = qHashBits(renderable->globalTransform.constData(), 16 * sizeof(float), seed);
+        seed = qHash(model.m_depthBias, seed);
+        if (model.instanceTable) {
+            seed = qHash(model.instanceTable->serial(), seed);
+            seed = qHash(model.instanceCount(), seed);
+        }
+        if (theObject->depthWriteMode == QSSGDepthDrawMode::OpaquePrePass) {
+            for (const QSSGRenderableImage *image = renderable->firstImage; image; image = image->m_nextImage) {
+                // The contents of an item's texture may change in any frame
+                if (image->m_imageNode.m_qsgTexture)
+                    return 0;
+                seed = qHash(image->m_texture.m_texture, seed);
+                if (image->m_imageNode.m_rawTextureData)
+                    seed = qHash(image->m_imageNode.m_rawTextureData->generationId(), seed);
+            }
+        }
+    }
+    return seed ? seed : 1;
+}
+
+static size_t shadowLightSignature(const QSSGRenderLight *light, const QMatrix4x4 *viewProjections, int count, size_t seed = 0)
+{
+    for (int i = 0; i < count; ++i)
+        seed = qHashBits(viewProjections[i].constData(), 16 * sizeof(float), seed);
+    seed = qHash(light->m_shadowFilter, seed);
+    return qHash(light->m_shadowMapFar, seed);
 }
 
 static void rhiRenderShadowMap(QSSGRhiContext *rhiCtx,
@@ -1562,101 +1826,186 @@ static void rhiRenderShadowMap(QSSGRhiContext *rhiCtx,
     ps.depthBias = 2;
     ps.slopeScaledDepthBias = 1.5f;
 
+    // Maps are only rendered again when their signature changes, i.e. when
+    // the light or a caster moved.
+    const bool useCache = shadowMapCacheEnabled();
+
+    // The 2D shadow maps of all lights are rendered into their tiles of the
+    // atlas in one pass. The pipelines do not depend on the tile, the
+    // viewport is only set when recording. The tiles share the render pass,
+    // so the atlas is rendered as a whole when any tile changed.
+    QVarLengthArray<QSSGAtlasShadowMap, QSSG_MAX_NUM_SHADOW_MAPS> atlasShadowMaps;
+    bool atlasDirty = false;
+    const QSSGRenderShadowMap::Atlas &atlas(shadowMapManager->atlas());
+    const BoxPoints frustumPoints = computeFrustumBounds(camera);
+    for (int i = 0, ie = globalLights.count(); i != ie; ++i) {
+        if (!globalLights[i].shadows)
+            continue;
+
+        QSSGShadowMapEntry *pEntry = shadowMapManager->shadowMapEntry(i);
+        if (!pEntry || !pEntry->m_inAtlas || !atlas.renderTarget)
+            continue;
+
+        const auto &light = globalLights[i].light;
+        const int cascadeCount = pEntry->m_cascadeCount;
+        if (cascadeCount > 1) {
+            QSSGRenderShadowMap::computeCascadeSplits(camera.clipNear, camera.clipFar, light->m_shadowMapFar,
+                                                      light->m_cascadeSplitBlend, cascadeCount, pEntry->m_cascadeSplits);
+        } else {
+            // one map for everything
+            pEntry->m_cascadeSplits[0] = std::numeric_limits<float>::max();
+        }
+
+        for (int cascade = 0; cascade < cascadeCount; ++cascade) {
+            // the shadow pass srbs and draw call data are per slot, and the
+            // casters of the earlier slots must not move
+            if (atlasShadowMaps.count() == QSSG_MAX_NUM_SHADOW_MAPS)
+                break;
+            atlasShadowMaps.append({ pEntry, light, cascade, {}, nullptr, 0 });
+            QSSGAtlasShadowMap &shadowMap(atlasShadowMaps.last());
+
+            QSSGRenderCamera theCamera(QSSGRenderCamera::Type::OrthographicCamera);
+            setupCameraForCascade(camera, frustumPoints, light, pEntry, cascade, theCamera, castingObjectsBox, receivingObjectsBox);
+            QMatrix4x4 &lightVP(pEntry->m_cascadeLightVP[cascade]);
+            theCamera.calculateViewProjectionMatrix(lightVP);
+            if (cascade == 0) {
+                pEntry->m_lightVP = lightVP;
+                pEntry->m_lightView = theCamera.globalTransform.inverted(); // pre-calculate this for the material
+            }
+
+            // Each cascade only gets the casters within its own frustum.
+            shadowMap.casters = &cullShadowCasters(inData, lightVP, sortedOpaqueObjects, shadowMap.culledCasters);
+            if (useCache) {
+                const QRect &tile(pEntry->m_atlasRect[cascade]);
+                size_t seed = shadowLightSignature(light, &lightVP, 1);
+                seed = qHash(tile.x(), seed);
+                seed = qHash(tile.y(), seed);
+                seed = qHash(tile.width(), seed);
+                shadowMap.signature = shadowCasterSignature(*shadowMap.casters, seed);
+            }
+            if (!shadowMap.signature || shadowMap.signature != pEntry->m_renderedSignature[cascade])
+                atlasDirty = true;
+        }
+    }
+
+    if (atlasDirty) {
+        const QSize size = atlas.texture->pixelSize();
+        ps.viewport = QRhiViewport(0, 0, float(size.width()), float(size.height()));
+        for (int slot = 0; slot < atlasShadowMaps.count(); ++slot) {
+            QSSGAtlasShadowMap &shadowMap(atlasShadowMaps[slot]);
+            QSSGShadowMapEntry *pEntry = shadowMap.entry;
+            const int cascade = shadowMap.cascade;
+            // same camera as above, set up again as cameras cannot be copied
+            QSSGRenderCamera theCamera(QSSGRenderCamera::Type::OrthographicCamera);
+            setupCameraForCascade(camera, frustumPoints, shadowMap.light, pEntry, cascade, theCamera, castingObjectsBox, receivingObjectsBox);
+            pEntry->m_lightVP = pEntry->m_cascadeLightVP[cascade];
+            const bool complete = rhiPrepareResourcesForShadowMap(rhiCtx, inData, pEntry, &ps, &depthAdjust,
+                                                                  *shadowMap.casters, theCamera, true, slot);
+            pEntry->m_renderedSignature[cascade] = complete ? shadowMap.signature : 0;
+        }
+
+        // Render into the 2D texture atlas.texture, using atlas.depthStencil
+        // as the (throwaway) depth/stencil buffer.
+        cb->beginPass(atlas.renderTarget, Qt::white, { 1.0f, 0 }, nullptr, QSSGRhiContext::commonPassFlags());
+        rhiCtx->stats().beginRenderPass(atlas.renderTarget);
+        for (int slot = 0; slot < atlasShadowMaps.count(); ++slot) {
+            const QRect &tile(atlasShadowMaps[slot].entry->m_atlasRect[atlasShadowMaps[slot].cascade]);
+            ps.viewport = QRhiViewport(tile.x(), tile.y(), tile.width(), tile.height());
+            rhiRenderOneShadowMap(rhiCtx, &ps, *atlasShadowMaps[slot].casters, slot);
+        }
+        cb->endPass();
+        rhiCtx->stats().endRenderPass();
+
+        rhiBlurShadowMapAtlas(rhiCtx, atlas, atlasShadowMaps, renderer);
+        rhiCtx->stats().shadowMapStats.rendered += atlasShadowMaps.count();
+    } else {
+        rhiCtx->stats().shadowMapStats.skipped += atlasShadowMaps.count();
+    }
 
     for (int i = 0, ie = globalLights.count(); i != ie; ++i) {
         if (!globalLights[i].shadows)
             continue;
 
         QSSGShadowMapEntry *pEntry = shadowMapManager->shadowMapEntry(i);
-        if (!pEntry)
+        if (!pEntry || pEntry->m_inAtlas)
             continue;
 
         Q_ASSERT(pEntry->m_rhiDepthStencil);
-        const bool orthographic = pEntry->m_rhiDepthMap && pEntry->m_rhiDepthCopy;
-        if (orthographic) {
-            const QSize size = pEntry->m_rhiDepthMap->pixelSize();
-            ps.viewport = QRhiViewport(0, 0, float(size.width()), float(size.height()));
-
-            const auto &light = globalLights[i].light;
-            const auto cameraType = (light->type == QSSGRenderLight::Type::DirectionalLight) ? QSSGRenderCamera::Type::OrthographicCamera : QSSGRenderCamera::Type::CustomCamera;
-            QSSGRenderCamera theCamera(cameraType);
-            setupCameraForShadowMap(camera, light, theCamera, castingObjectsBox, receivingObjectsBox);
-            theCamera.calculateViewProjectionMatrix(pEntry->m_lightVP);
-            pEntry->m_lightView = theCamera.globalTransform.inverted(); // pre-calculate this for the material
-
-            rhiPrepareResourcesForShadowMap(rhiCtx, inData, pEntry, &ps, &depthAdjust,
-                                            sortedOpaqueObjects, theCamera, true, 0);
-
-            // Render into the 2D texture pEntry->m_rhiDepthMap, using
-            // pEntry->m_rhiDepthStencil as the (throwaway) depth/stencil buffer.
-            QRhiTextureRenderTarget *rt = pEntry->m_rhiRenderTargets[0];
-            cb->beginPass(rt, Qt::white, { 1.0f, 0 }, nullptr, QSSGRhiContext::commonPassFlags());
-            QSSGRHICTX_STAT(rhiCtx, beginRenderPass(rt));
-            rhiRenderOneShadowMap(rhiCtx, &ps, sortedOpaqueObjects, 0);
-            cb->endPass();
-            QSSGRHICTX_STAT(rhiCtx, endRenderPass());
+        Q_ASSERT(pEntry->m_rhiDepthCube && pEntry->m_rhiCubeCopy);
+        const QSize size = pEntry->m_rhiDepthCube->pixelSize();
+        ps.viewport = QRhiViewport(0, 0, float(size.width()), float(size.height()));
 
-            rhiBlurShadowMap(rhiCtx, pEntry, renderer, globalLights[i].light->m_shadowFilter, globalLights[i].light->m_shadowMapFar, true);
-        } else {
-            Q_ASSERT(pEntry->m_rhiDepthCube && pEntry->m_rhiCubeCopy);
-            const QSize size = pEntry->m_rhiDepthCube->pixelSize();
-            ps.viewport = QRhiViewport(0, 0, float(size.width()), float(size.height()));
-
-            QSSGRenderCamera theCameras[6] { QSSGRenderCamera{QSSGRenderCamera::Type::PerspectiveCamera},
-                                             QSSGRenderCamera{QSSGRenderCamera::Type::PerspectiveCamera},
-                                             QSSGRenderCamera{QSSGRenderCamera::Type::PerspectiveCamera},
-                                             QSSGRenderCamera{QSSGRenderCamera::Type::PerspectiveCamera},
-                                             QSSGRenderCamera{QSSGRenderCamera::Type::PerspectiveCamera},
-                                             QSSGRenderCamera{QSSGRenderCamera::Type::PerspectiveCamera} };
-            setupCubeShadowCameras(globalLights[i].light, theCameras);
-            pEntry->m_lightView = QMatrix4x4();
-
-            const bool swapYFaces = !rhi->isYUpInFramebuffer();
-            for (int face = 0; face < 6; ++face) {
-                theCameras[face].calculateViewProjectionMatrix(pEntry->m_lightVP);
-                pEntry->m_lightCubeView[face] = theCameras[face].globalTransform.inverted(); // pre-calculate this for the material
-
-                rhiPrepareResourcesForShadowMap(rhiCtx, inData, pEntry, &ps, &depthAdjust,
-                                                sortedOpaqueObjects, theCameras[face], false, face);
-            }
+        QSSGRenderCamera theCameras[6] { QSSGRenderCamera{QSSGRenderCamera::Type::PerspectiveCamera},
+                                         QSSGRenderCamera{QSSGRenderCamera::Type::PerspectiveCamera},
+                                         QSSGRenderCamera{QSSGRenderCamera::Type::PerspectiveCamera},
+                                         QSSGRenderCamera{QSSGRenderCamera::Type::PerspectiveCamera},
+                                         QSSGRenderCamera{QSSGRenderCamera::Type::PerspectiveCamera},
+                                         QSSGRenderCamera{QSSGRenderCamera::Type::PerspectiveCamera} };
+        setupCubeShadowCameras(globalLights[i].light, theCameras);
+        pEntry->m_lightView = QMatrix4x4();
 
-            for (int face = 0; face < 6; ++face) {
-                // Render into one face of the cubemap texture pEntry->m_rhiDephCube, using
-                // pEntry->m_rhiDepthStencil as the (throwaway) depth/stencil buffer.
-
-                int outFace = face;
-                // FACE  S  T               GL
-                // +x   -z, -y   right
-                // -x   +z, -y   left
-                // +y   +x, +z   top
-                // -y   +x, -z   bottom
-                // +z   +x, -y   front
-                // -z   -x, -y   back
-                // FACE  S  T               D3D
-                // +x   -z, +y   right
-                // -x   +z, +y   left
-                // +y   +x, -z   bottom
-                // -y   +x, +z   top
-                // +z   +x, +y   front
-                // -z   -x, +y   back
-                if (swapYFaces) {
-                    // +Y and -Y faces get swapped (D3D, Vulkan, Metal).
-                    // See shadowMapping.glsllib. This is complemented there by reversing T as well.
-                    if (outFace == 2)
-                        outFace = 3;
-                    else if (outFace == 3)
-                        outFace = 2;
-                }
-                QRhiTextureRenderTarget *rt = pEntry->m_rhiRenderTargets[outFace];
-                cb->beginPass(rt, Qt::white, { 1.0f, 0 }, nullptr, QSSGRhiContext::commonPassFlags());
-                QSSGRHICTX_STAT(rhiCtx, beginRenderPass(rt));
-                rhiRenderOneShadowMap(rhiCtx, &ps, sortedOpaqueObjects, face);
-                cb->endPass();
-                QSSGRHICTX_STAT(rhiCtx, endRenderPass());
+        QMatrix4x4 faceViewProjections[6];
+        for (int face = 0; face < 6; ++face) {
+            theCameras[face].calculateViewProjectionMatrix(faceViewProjections[face]);
+            pEntry->m_lightCubeView[face] = theCameras[face].globalTransform.inverted(); // pre-calculate this for the material
+        }
+
+        size_t signature = 0;
+        if (useCache) {
+            signature = shadowCasterSignature(sortedOpaqueObjects,
+                                              shadowLightSignature(globalLights[i].light, faceViewProjections, 6));
+            if (signature && signature == pEntry->m_renderedSignature[0]) {
+                rhiCtx->stats().shadowMapStats.skipped += 1;
+                continue;
             }
+        }
 
-            rhiBlurShadowMap(rhiCtx, pEntry, renderer, globalLights[i].light->m_shadowFilter, globalLights[i].light->m_shadowMapFar, false);
+        const bool swapYFaces = !rhi->isYUpInFramebuffer();
+        bool complete = true;
+        for (int face = 0; face < 6; ++face) {
+            pEntry->m_lightVP = faceViewProjections[face];
+            complete &= rhiPrepareResourcesForShadowMap(rhiCtx, inData, pEntry, &ps, &depthAdjust,
+                                                        sortedOpaqueObjects, theCameras[face], false, face);
         }
+        pEntry->m_renderedSignature[0] = complete ? signature : 0;
+        rhiCtx->stats().shadowMapStats.rendered += 1;
+
+        for (int face = 0; face < 6; ++face) {
+            // Render into one face of the cubemap texture pEntry->m_rhiDephCube, using
+            // pEntry->m_rhiDepthStencil as the (throwaway) depth/stencil buffer.
+
+            int outFace = face;
+            // FACE  S  T               GL
+            // +x   -z, -y   right
+            // -x   +z, -y   left
+            // +y   +x, +z   top
+            // -y   +x, -z   bottom
+            // +z   +x, -y   front
+            // -z   -x, -y   back
+            // FACE  S  T               D3D
+            // +x   -z, +y   right
+            // -x   +z, +y   left
+            // +y   +x, -z   bottom
+            // -y   +x, +z   top
+            // +z   +x, +y   front
+            // -z   -x, +y   back
+            if (swapYFaces) {
+                // +Y and -Y faces get swapped (D3D, Vulkan, Metal).
+                // See shadowMapping.glsllib. This is complemented there by reversing T as well.
+                if (outFace == 2)
+                    outFace = 3;
+                else if (outFace == 3)
+                    outFace = 2;
+            }
+            QRhiTextureRenderTarget *rt = pEntry->m_rhiRenderTargets[outFace];
+            cb->beginPass(rt, Qt::white, { 1.0f, 0 }, nullptr, QSSGRhiContext::commonPassFlags());
+            rhiCtx->stats().beginRenderPass(rt);
+            rhiRenderOneShadowMap(rhiCtx, &ps, sortedOpaqueObjects, face);
+            cb->endPass();
+            rhiCtx->stats().endRenderPass();
+        }
+
+        rhiBlurShadowMap(rhiCtx, pEntry, renderer, globalLights[i].light->m_shadowFilter, globalLights[i].light->m_shadowMapFar);
     }
 }
 
@@ -1722,7 +2071,7 @@ static void rhiRenderReflectionMap(QSSGRhiContext *rhiCtx,
             }
             QRhiTextureRenderTarget *rt = pEntry->m_rhiRenderTargets[outFace];
             cb->beginPass(rt, reflectionProbes[i]->clearColor, { 1.0f, 0 }, nullptr, QSSGRhiContext::commonPassFlags());
-            QSSGRHICTX_STAT(rhiCtx, beginRenderPass(rt));
+            rhiCtx->stats().beginRenderPass(rt);
 
             if (inData.layer.background == QSSGRenderLayer::Background::SkyBox
                     && rhiCtx->rhi()->isFeatureSupported(QRhi::TexelFetch)
@@ -1743,7 +2092,7 @@ static void rhiRenderReflectionMap(QSSGRhiContext *rhiCtx,
                 rhiRenderRenderable(rhiCtx, inData, *handle.obj, &needsSetViewport, face, &ps);
 
             cb->endPass();
-            QSSGRHICTX_STAT(rhiCtx, endRenderPass());
+            rhiCtx->stats().endRenderPass();
 
             if (pEntry->m_timeSlicing == QSSGRenderReflectionProbe::ReflectionTimeSlicing::IndividualFaces)
                 break;
@@ -1810,9 +2159,9 @@ static void rhiRenderAoTexture(QSSGRhiContext *rhiCtx,
         QRhiCommandBuffer *cb = rhiCtx->commandBuffer();
         // just clear and stop there
         cb->beginPass(inData.m_rhiAoTexture.rt, Qt::white, { 1.0f, 0 });
-        QSSGRHICTX_STAT(rhiCtx, beginRenderPass(inData.m_rhiAoTexture.rt));
+        rhiCtx->stats().beginRenderPass(inData.m_rhiAoTexture.rt);
         cb->endPass();
-        QSSGRHICTX_STAT(rhiCtx, endRenderPass());
+        rhiCtx->stats().endRenderPass();
         return;
     }
 
@@ -1950,6 +2299,7 @@ void QSSGLayerRenderData::rhiPrepare()
     Q_ASSERT(rhiCtx->isValid());
 
     QSSGRhiGraphicsPipelineState *ps = rhiCtx->resetGraphicsPipelineState(this);
+    m_uniformRing.reset();
 
     const QRectF vp = layerPrepResult->viewport;
     ps->viewport = { float(vp.x()), float(vp.y()), float(vp.width()), float(vp.height()), 0.0f, 1.0f };
@@ -2049,7 +2399,7 @@ void QSSGLayerRenderData::rhiPrepare()
                 {
                     bool needsSetVieport = true;
                     cb->beginPass(m_rhiDepthTexture.rt, Qt::transparent, { 1.0f, 0 }, nullptr, QSSGRhiContext::commonPassFlags());
-                    QSSGRHICTX_STAT(rhiCtx, beginRenderPass(m_rhiDepthTexture.rt));
+                    rhiCtx->stats().beginRenderPass(m_rhiDepthTexture.rt);
                     // NB! We do not pass sortedTransparentObjects in the 4th
                     // argument to stay compatible with the 5.15 code base,
                     // which also does not include semi-transparent objects in
@@ -2059,7 +2409,7 @@ void QSSGLayerRenderData::rhiPrepare()
                     // both for depth and color.
                     rhiRenderDepthPass(rhiCtx, *this, sortedOpaqueObjects, {}, &needsSetVieport);
                     cb->endPass();
-                    QSSGRHICTX_STAT(rhiCtx, endRenderPass());
+                    rhiCtx->stats().endRenderPass();
                 } else {
                     m_rhiDepthTexture.reset();
                 }
@@ -2194,11 +2544,14 @@ void QSSGLayerRenderData::rhiPrepare()
                 this->features.disableTonemapping();
                 for (const auto &handle : sortedOpaqueObjects)
                     rhiPrepareRenderable(rhiCtx, *this, *handle.obj, m_rhiScreenTexture.rpDesc, 1);
+                QRhiResourceUpdateBatch *uniformRub = rhiCtx->rhi()->nextResourceUpdateBatch();
+                m_uniformRing.flush(uniformRub);
+                cb->resourceUpdate(uniformRub);
                 QColor clearColor(Qt::transparent);
                 if (layer.background == QSSGRenderLayer::Background::Color)
                     clearColor = QColor::fromRgbF(layer.clearColor.x(), layer.clearColor.y(), layer.clearColor.z());
                 cb->beginPass(m_rhiScreenTexture.rt, clearColor, { 1.0f, 0 }, nullptr, QSSGRhiContext::commonPassFlags());
-                QSSGRHICTX_STAT(rhiCtx, beginRenderPass(m_rhiScreenTexture.rt));
+                rhiCtx->stats().beginRenderPass(m_rhiScreenTexture.rt);
                 if (layer.background == QSSGRenderLayer::Background::SkyBox
                         && rhiCtx->rhi()->isFeatureSupported(QRhi::TexelFetch) && layer.skyBoxSrb) {
                     // This is offscreen, so rendered untonemapped
@@ -2220,7 +2573,7 @@ void QSSGLayerRenderData::rhiPrepare()
                     rub->generateMips(m_rhiScreenTexture.texture);
                 }
                 cb->endPass(rub);
-                QSSGRHICTX_STAT(rhiCtx, endRenderPass());
+                rhiCtx->stats().endRenderPass();
                 // Re-enable all tonemapping
                 this->features = featuresBackup;
             }
@@ -2322,6 +2675,10 @@ void QSSGLayerRenderData::rhiPrepare()
                 rhiPrepareRenderable(rhiCtx, *this, *theObject, mainRpDesc, samples);
         }
 
+        QRhiResourceUpdateBatch *uniformRub = rhiCtx->rhi()->nextResourceUpdateBatch();
+        m_uniformRing.flush(uniformRub);
+        cb->resourceUpdate(uniformRub);
+
         cb->debugMarkEnd();
 
         renderer->endLayerRender();
@@ -2340,10 +2697,13 @@ static void rhiRenderRenderable(QSSGRhiContext *rhiCtx,
 
         QRhiGraphicsPipeline *ps = subsetRenderable.rhiRenderData.mainPass.pipeline;
         QRhiShaderResourceBindings *srb = subsetRenderable.rhiRenderData.mainPass.srb;
+        const QRhiCommandBuffer::DynamicOffset *dynamicOffsets = subsetRenderable.rhiRenderData.mainPass.dynamicOffsets;
+        int dynamicOffsetCount = subsetRenderable.rhiRenderData.mainPass.dynamicOffsetCount;
 
         if (cubeFace >= 0) {
             ps = subsetRenderable.rhiRenderData.reflectionPass.pipeline;
             srb = subsetRenderable.rhiRenderData.reflectionPass.srb[cubeFace];
+            dynamicOffsetCount = 0;
         }
 
         if (!ps || !srb)
@@ -2355,7 +2715,9 @@ static void rhiRenderRenderable(QSSGRhiContext *rhiCtx,
         QRhiCommandBuffer *cb = rhiCtx->commandBuffer();
         // QRhi optimizes out unnecessary binding of the same pipline
         cb->setGraphicsPipeline(ps);
-        cb->setShaderResources(srb);
+        cb->setShaderResources(srb, dynamicOffsetCount, dynamicOffsetCount ? dynamicOffsets : nullptr);
+        rhiCtx->stats().setGraphicsPipeline(ps);
+        rhiCtx->stats().setShaderResources(srb);
 
         if (*needsSetViewport) {
             if (!state)
@@ -45,6 +45,9 @@
 #include <QtQuick3DUtils/private/qssgutils_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgruntimerenderlogging_p.h>
 
+#include <cstring>
+#include <limits>
+
 #ifdef Q_CC_MSVC
 #pragma warning(disable : 4355)
 #endif
@@ -121,10 +124,14 @@ static void maybeQueueNodeForRender(QSSGRenderNode &inNode,
                                     QVector<QSSGRenderReflectionProbe *> &outReflectionProbes,
                                     int &ioReflectionProbeCount,
                                     quint32 &ioDFSIndex,
+                                    QSSGRenderTransformStore &transformStore,
+                                    qint32 parentSlot,
                                     QVector<QSSGRenderSkeleton*> &dirtySkeletons)
 {
     ++ioDFSIndex;
     inNode.dfsIndex = ioDFSIndex;
+    const qint32 slot = transformStore.add(&inNode, parentSlot);
+    Q_ASSERT(quint32(slot) + 1 == ioDFSIndex);
     if (QSSGRenderGraphObject::isRenderable(inNode.type)) {
         collectNode(QSSGRenderableNodeEntry(inNode), outRenderables, ioRenderableCount);
         if (inNode.type == QSSGRenderGraphObject::Type::Model) {
@@ -188,6 +195,8 @@ static void maybeQueueNodeForRender(QSSGRenderNode &inNode,
                                 outReflectionProbes,
                                 ioReflectionProbeCount,
                                 ioDFSIndex,
+                                transformStore,
+                                slot,
                                 dirtySkeletons);
 }
 
@@ -229,6 +238,119 @@ static inline float signedSquare(float val)
     return sign * val * val;
 }
 
+// Maps a float to an unsigned integer with the same ordering, so that
+// distances can take part in an integer radix sort without losing precision.
+static inline quint32 orderedFloatBits(float value)
+{
+    quint32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+// Identifies the pipeline an opaque renderable is going to use. The actual
+// QRhiGraphicsPipeline is only known after rhiPrepare, but it is derived from
+// the shader key (plus the shader sources for custom materials), so equal
+// hashes end up with equal pipelines in practice.
+static inline quint32 pipelineSortHash(const QSSGRenderableObject &obj)
+{
+    if (obj.renderableFlags.isDefaultMaterialMeshSubset()) {
+        const QSSGSubsetRenderable &subset(static_cast<const QSSGSubsetRenderable &>(obj));
+        return quint32(subset.shaderDescription.hash());
+    }
+    if (obj.renderableFlags.isCustomMaterialMeshSubset()) {
+        const QSSGSubsetRenderable &subset(static_cast<const QSSGSubsetRenderable &>(obj));
+        return quint32(subset.shaderDescription.hash() ^ qHash(subset.customMaterial().m_shaderPathKey));
+    }
+    return 0;
+}
+
+// Identifies the resources (textures, uniform values) bound for the
+// renderable, which are shared between subsets using the same material.
+static inline quint32 resourceSortHash(const QSSGRenderableObject &obj)
+{
+    if (obj.renderableFlags.isDefaultMaterialMeshSubset() || obj.renderableFlags.isCustomMaterialMeshSubset())
+        return quint32(qHash(&static_cast<const QSSGSubsetRenderable &>(obj).material));
+    if (obj.renderableFlags.isParticlesRenderable())
+        return quint32(qHash(&static_cast<const QSSGParticlesRenderable &>(obj).particles));
+    return 0;
+}
+
+// Stable LSD radix sort of the handles by sortKey, one byte per pass. A
+// single counting pass builds the histograms of all digits; digits that are
+// the same for every key (e.g. the upper half of a 32-bit key) are skipped.
+void QSSGLayerRenderPreparationData::radixSortRenderables(TRenderableObjectList &objects,
+                                                          TRenderableObjectList &scratch)
+{
+    const qsizetype count = objects.size();
+    if (count < 2)
+        return;
+
+    constexpr int DigitCount = sizeof(quint64);
+    quint32 histograms[DigitCount][256] = {};
+    for (const QSSGRenderableObjectHandle &handle : std::as_const(objects)) {
+        quint64 key = handle.sortKey;
+        for (int digit = 0; digit < DigitCount; ++digit, key >>= 8)
+            ++histograms[digit][key & 0xff];
+    }
+
+    scratch.resize(count);
+    QSSGRenderableObjectHandle *src = objects.data();
+    QSSGRenderableObjectHandle *dst = scratch.data();
+    for (int digit = 0; digit < DigitCount; ++digit) {
+        const int shift = digit * 8;
+        quint32 *histogram = histograms[digit];
+        if (histogram[(src[0].sortKey >> shift) & 0xff] == quint32(count))
+            continue;
+        quint32 offset = 0;
+        for (int bucket = 0; bucket < 256; ++bucket) {
+            const quint32 bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+        for (qsizetype idx = 0; idx < count; ++idx)
+            dst[histogram[(src[idx].sortKey >> shift) & 0xff]++] = src[idx];
+        std::swap(src, dst);
+    }
+    if (src != objects.data())
+        std::copy(src, src + count, objects.data());
+}
+
+// Sorts furthest to nearest, exactly by distance.
+void QSSGLayerRenderPreparationData::sortBackToFront(TRenderableObjectList &objects,
+                                                     TRenderableObjectList &scratch,
+                                                     const QVector3D &cameraPosition,
+                                                     const QVector3D &cameraDirection)
+{
+    for (QSSGRenderableObjectHandle &theInfo : objects) {
+        const QVector3D difference = theInfo.obj->worldCenterPoint - cameraPosition;
+        theInfo.cameraDistanceSq = QVector3D::dotProduct(difference, cameraDirection) + signedSquare(theInfo.obj->depthBias);
+        theInfo.sortKey = ~orderedFloatBits(theInfo.cameraDistanceSq);
+    }
+    radixSortRenderables(objects, scratch);
+}
+
+// Opaque objects do not need an exact order, only enough of it to get some
+// early depth rejection. The key is, from the top:
+//   4 bits  coarse depth slice,
+//   24 bits pipeline (shader key) hash,
+//   16 bits material hash,
+//   20 bits fine depth within the slice,
+// so within each of the 16 slices the draws are grouped by pipeline and then
+// by material, and those groups are drawn front to back.
+quint64 QSSGLayerRenderPreparationData::opaqueSortKey(float distance, float minDistance, float maxDistance,
+                                                      quint32 pipelineHash, quint32 resourceHash)
+{
+    constexpr quint32 DepthBits = 24;
+    constexpr quint32 FineDepthBits = 20;
+    const float range = maxDistance - minDistance;
+    const float depthScale = range > 0.0f ? float((1u << DepthBits) - 1) / range : 0.0f;
+    const quint32 depth = qMin(quint32((distance - minDistance) * depthScale), (1u << DepthBits) - 1);
+    return (quint64(depth >> FineDepthBits) << 60)
+            | (quint64((pipelineHash ^ (pipelineHash >> 24)) & 0xffffff) << 36)
+            | (quint64((resourceHash ^ (resourceHash >> 16)) & 0xffff) << 20)
+            | quint64(depth & ((1u << FineDepthBits) - 1));
+}
+
 // Per-frame cache of renderable objects post-sort.
 const QVector<QSSGRenderableObjectHandle> &QSSGLayerRenderPreparationData::getOpaqueRenderableObjects(bool performSort)
 {
@@ -237,20 +359,25 @@ const QVector<QSSGRenderableObjectHandle> &QSSGLayerRenderPreparationData::getOp
     if (layer.flags.testFlag(QSSGRenderLayer::Flag::LayerEnableDepthTest) && !opaqueObjects.empty()) {
         QVector3D theCameraDirection(getCameraDirection());
         QVector3D theCameraPosition = camera->getGlobalPos();
-        renderedOpaqueObjects = opaqueObjects;
+        // Appending keeps the allocation of the previous frame around.
+        renderedOpaqueObjects.append(opaqueObjects);
         // Setup the object's sorting information
-        for (int idx = 0, end = renderedOpaqueObjects.size(); idx < end; ++idx) {
-            QSSGRenderableObjectHandle &theInfo = renderedOpaqueObjects[idx];
+        float minDistance = std::numeric_limits<float>::max();
+        float maxDistance = std::numeric_limits<float>::lowest();
+        for (QSSGRenderableObjectHandle &theInfo : renderedOpaqueObjects) {
             const QVector3D difference = theInfo.obj->worldCenterPoint - theCameraPosition;
             theInfo.cameraDistanceSq = QVector3D::dotProduct(difference, theCameraDirection) + signedSquare(theInfo.obj->depthBias);
+            minDistance = qMin(minDistance, theInfo.cameraDistanceSq);
+            maxDistance = qMax(maxDistance, theInfo.cameraDistanceSq);
         }
 
-        static const auto isRenderObjectPtrLessThan = [](const QSSGRenderableObjectHandle &lhs, const QSSGRenderableObjectHandle &rhs) {
-            return lhs.cameraDistanceSq < rhs.cameraDistanceSq;
-        };
-        // Render nearest to furthest objects
-        if (performSort)
-            std::sort(renderedOpaqueObjects.begin(), renderedOpaqueObjects.end(), isRenderObjectPtrLessThan);
+        if (performSort) {
+            for (QSSGRenderableObjectHandle &theInfo : renderedOpaqueObjects) {
+                theInfo.sortKey = opaqueSortKey(theInfo.cameraDistanceSq, minDistance, maxDistance,
+                                                pipelineSortHash(*theInfo.obj), resourceSortHash(*theInfo.obj));
+            }
+            radixSortRenderables(renderedOpaqueObjects, renderableSortScratch);
+        }
     }
     return renderedOpaqueObjects;
 }
@@ -261,28 +388,13 @@ const QVector<QSSGRenderableObjectHandle> &QSSGLayerRenderPreparationData::getTr
     if (!renderedTransparentObjects.empty() || camera == nullptr)
         return renderedTransparentObjects;
 
-    renderedTransparentObjects = transparentObjects;
+    renderedTransparentObjects.append(transparentObjects);
 
     if (!layer.flags.testFlag(QSSGRenderLayer::Flag::LayerEnableDepthTest))
         renderedTransparentObjects.append(opaqueObjects);
 
-    if (!renderedTransparentObjects.empty()) {
-        QVector3D theCameraDirection(getCameraDirection());
-        QVector3D theCameraPosition = camera->getGlobalPos();
-
-        // Setup the object's sorting information
-        for (quint32 idx = 0, end = renderedTransparentObjects.size(); idx < end; ++idx) {
-            QSSGRenderableObjectHandle &theInfo = renderedTransparentObjects[idx];
-            const QVector3D difference = theInfo.obj->worldCenterPoint - theCameraPosition;
-            theInfo.cameraDistanceSq = QVector3D::dotProduct(difference, theCameraDirection) + signedSquare(theInfo.obj->depthBias);
-        }
-
-        static const auto iSRenderObjectPtrGreatThan = [](const QSSGRenderableObjectHandle &lhs, const QSSGRenderableObjectHandle &rhs) {
-            return lhs.cameraDistanceSq > rhs.cameraDistanceSq;
-        };
-        // render furthest to nearest.
-        std::sort(renderedTransparentObjects.begin(), renderedTransparentObjects.end(), iSRenderObjectPtrGreatThan);
-    }
+    if (!renderedTransparentObjects.empty())
+        sortBackToFront(renderedTransparentObjects, renderableSortScratch, camera->getGlobalPos(), getCameraDirection());
 
     return renderedTransparentObjects;
 }
@@ -291,23 +403,9 @@ const QVector<QSSGRenderableObjectHandle> &QSSGLayerRenderPreparationData::getSc
 {
     if (!renderedScreenTextureObjects.empty() || camera == nullptr)
         return renderedScreenTextureObjects;
-    renderedScreenTextureObjects = screenTextureObjects;
-    if (!renderedScreenTextureObjects.empty()) {
-        QVector3D theCameraDirection(getCameraDirection());
-        QVector3D theCameraPosition = camera->getGlobalPos();
-        // Setup the object's sorting information
-        for (quint32 idx = 0, end = renderedScreenTextureObjects.size(); idx < end; ++idx) {
-            QSSGRenderableObjectHandle &theInfo = renderedScreenTextureObjects[idx];
-            const QVector3D difference = theInfo.obj->worldCenterPoint - theCameraPosition;
-            theInfo.cameraDistanceSq = QVector3D::dotProduct(difference, theCameraDirection) + signedSquare(theInfo.obj->depthBias);
-        }
-        static const auto iSRenderObjectPtrGreatThan = [](const QSSGRenderableObjectHandle &lhs,
-                                                          const QSSGRenderableObjectHandle &rhs) {
-            return lhs.cameraDistanceSq > rhs.cameraDistanceSq;
-        };
-        // render furthest to nearest.
-        std::sort(renderedScreenTextureObjects.begin(), renderedScreenTextureObjects.end(), iSRenderObjectPtrGreatThan);
-    }
+    renderedScreenTextureObjects.append(screenTextureObjects);
+    if (!renderedScreenTextureObjects.empty())
+        sortBackToFront(renderedScreenTextureObjects, renderableSortScratch, camera->getGlobalPos(), getCameraDirection());
     return renderedScreenTextureObjects;
 }
 
@@ -364,6 +462,13 @@ Q_REQUIRED_RESULT inline T *RENDER_FRAME_NEW(QSSGRenderContextInterface &ctx, Ar
     return new (ctx.perFrameAllocator().allocate(sizeof(T)))T(std::forward<Args>(args)...);
 }
 
+// Same as above, but for allocating from a specific (per-worker) arena.
+template <typename T, typename... Args>
+Q_REQUIRED_RESULT inline T *RENDER_FRAME_NEW(QSSGPerFrameAllocator &allocator, Args&&... args)
+{
+    return new (allocator.allocate(sizeof(T)))T(std::forward<Args>(args)...);
+}
+
 QSSGShaderDefaultMaterialKey QSSGLayerRenderPreparationData::generateLightingKey(
         QSSGRenderDefaultMaterial::MaterialLighting inLightingType, const QSSGShaderLightList &lights, bool receivesShadows)
 {
@@ -401,24 +506,19 @@ void QSSGLayerRenderPreparationData::prepareImageForRender(QSSGRenderImage &inIm
                                                            QSSGRenderableObjectFlags &ioFlags,
                                                            QSSGShaderDefaultMaterialKey &inShaderKey,
                                                            quint32 inImageIndex,
+                                                           QSSGRenderablePrepJob &job,
                                                            QSSGRenderDefaultMaterial *inMaterial)
 {
-    QSSGRenderContextInterface &contextInterface = *renderer->contextInterface();
-    const QSSGRef<QSSGBufferManager> &bufferManager = contextInterface.bufferManager();
+    // The texture has been loaded by prepareImageResource() already, this
+    // function only looks it up so that it is safe to call from a job.
+    const auto prepared = preparedImages.constFind(&inImage);
+    if (prepared == preparedImages.cend())
+        return;
 
-    if (inImage.clearDirty())
+    if (prepared->dirty)
         ioFlags |= QSSGRenderableObjectFlag::Dirty;
 
-    // This is where the QRhiTexture gets created, if not already done. Note
-    // that the bufferManager is per-QQuickWindow, and so per-render-thread.
-    // Hence using the same Texture (backed by inImage as the backend node) in
-    // multiple windows will work by each scene in each window getting its own
-    // QRhiTexture. And that's why the QSSGRenderImageTexture cannot be a
-    // member of the QSSGRenderImage. Conceptually this matches what we do for
-    // models (QSSGRenderModel -> QSSGRenderMesh retrieved from the
-    // bufferManager in each prepareModelForRender, etc.).
-
-    const QSSGRenderImageTexture texture = bufferManager->loadRenderImage(&inImage, inImage.m_generateMipmaps ? QSSGBufferManager::MipModeGenerated : QSSGBufferManager::MipModeNone);
+    const QSSGRenderImageTexture &texture = prepared->texture;
 
     if (texture.m_texture) {
         if (texture.m_flags.hasTransparency()
@@ -429,7 +529,7 @@ void QSSGLayerRenderPreparationData::prepareImageForRender(QSSGRenderImage &inIm
             ioFlags |= QSSGRenderableObjectFlag::HasTransparency;
         }
 
-        QSSGRenderableImage *theImage = RENDER_FRAME_NEW<QSSGRenderableImage>(contextInterface, inMapType, inImage, texture);
+        QSSGRenderableImage *theImage = RENDER_FRAME_NEW<QSSGRenderableImage>(*job.allocator, inMapType, inImage, texture);
         QSSGShaderKeyImageMap &theKeyProp = renderer->defaultMaterialShaderKeyProperties().m_imageMaps[inImageIndex];
 
         theKeyProp.setEnabled(inShaderKey, true);
@@ -568,8 +668,9 @@ QSSGDefaultMaterialPreparationResult QSSGLayerRenderPreparationData::prepareDefa
         QSSGRenderDefaultMaterial &inMaterial,
         QSSGRenderableObjectFlags &inExistingFlags,
         float inOpacity,
+        bool vertexColorsEnabled,
         const QSSGShaderLightList &lights,
-        QSSGLayerRenderPreparationResultFlags &ioFlags)
+        QSSGRenderablePrepJob &job)
 {
     QSSGRenderDefaultMaterial *theMaterial = &inMaterial;
     QSSGDefaultMaterialPreparationResult retval(generateLightingKey(theMaterial->lighting, lights, inExistingFlags.receivesShadows()));
@@ -611,8 +712,8 @@ QSSGDefaultMaterialPreparationResult QSSGLayerRenderPreparationData::prepareDefa
 //        renderer->prepareImageForIbl(*theMaterial->iblProbe);
 //    }
 
+    // The LightProbe feature itself has been enabled in prepareModelResources().
     if (!renderer->defaultMaterialShaderKeyProperties().m_hasIbl.getValue(theGeneratedKey) && theMaterial->iblProbe) {
-        features.set(QSSGShaderFeatures::Feature::LightProbe, true);
         renderer->defaultMaterialShaderKeyProperties().m_hasIbl.setValue(theGeneratedKey, true);
         // features.set(ShaderFeatureDefines::enableIblFov(),
         // m_Renderer.GetLayerRenderData()->m_Layer.m_ProbeFov < 180.0f );
@@ -650,7 +751,7 @@ QSSGDefaultMaterialPreparationResult QSSGLayerRenderPreparationData::prepareDefa
         renderer->defaultMaterialShaderKeyProperties().m_fresnelEnabled.setValue(theGeneratedKey, theMaterial->isFresnelEnabled());
 
         renderer->defaultMaterialShaderKeyProperties().m_vertexColorsEnabled.setValue(theGeneratedKey,
-                                                                                      theMaterial->isVertexColorsEnabled());
+                                                                                      vertexColorsEnabled);
         renderer->defaultMaterialShaderKeyProperties().m_clearcoatEnabled.setValue(theGeneratedKey,
                                                                                    theMaterial->isClearcoatEnabled());
         renderer->defaultMaterialShaderKeyProperties().m_transmissionEnabled.setValue(theGeneratedKey,
@@ -663,7 +764,7 @@ QSSGDefaultMaterialPreparationResult QSSGLayerRenderPreparationData::prepareDefa
 #define CHECK_IMAGE_AND_PREPARE(img, imgtype, shadercomponent)                          \
     if ((img))                                                                          \
         prepareImageForRender(*(img), imgtype, firstImage, nextImage, renderableFlags,  \
-                              theGeneratedKey, shadercomponent, &inMaterial)
+                              theGeneratedKey, shadercomponent, job, &inMaterial)
 
         if (theMaterial->type == QSSGRenderGraphObject::Type::PrincipledMaterial) {
             CHECK_IMAGE_AND_PREPARE(theMaterial->colorMap,
@@ -732,8 +833,8 @@ QSSGDefaultMaterialPreparationResult QSSGLayerRenderPreparationData::prepareDefa
         renderableFlags |= QSSGRenderableObjectFlag::HasTransparency;
 
     if (inMaterial.isTransmissionEnabled()) {
-        ioFlags.setRequiresScreenTexture(true);
-        ioFlags.setRequiresMipmapsForScreenTexture(true);
+        job.flags.setRequiresScreenTexture(true);
+        job.flags.setRequiresMipmapsForScreenTexture(true);
         renderableFlags |= QSSGRenderableObjectFlag::RequiresScreenTexture;
     }
 
@@ -741,14 +842,14 @@ QSSGDefaultMaterialPreparationResult QSSGLayerRenderPreparationData::prepareDefa
     if (retval.renderableFlags.isDirty())
         retval.dirty = true;
     if (retval.dirty)
-        renderer->addMaterialDirtyClear(&inMaterial);
+        job.dirtyMaterials.append(&inMaterial);
     return retval;
 }
 
 QSSGDefaultMaterialPreparationResult QSSGLayerRenderPreparationData::prepareCustomMaterialForRender(
         QSSGRenderCustomMaterial &inMaterial, QSSGRenderableObjectFlags &inExistingFlags,
         float inOpacity, bool alreadyDirty, const QSSGShaderLightList &lights,
-        QSSGLayerRenderPreparationResultFlags &ioFlags)
+        QSSGRenderablePrepJob &job)
 {
     QSSGDefaultMaterialPreparationResult retval(
                 generateLightingKey(QSSGRenderDefaultMaterial::MaterialLighting::FragmentLighting,
@@ -803,40 +904,65 @@ QSSGDefaultMaterialPreparationResult QSSGLayerRenderPreparationData::prepareCust
         renderableFlags |= QSSGRenderableObjectFlag::HasTransparency;
 
     if (inMaterial.m_renderFlags.testFlag(QSSGRenderCustomMaterial::RenderFlag::ScreenTexture)) {
-        ioFlags.setRequiresScreenTexture(true);
+        job.flags.setRequiresScreenTexture(true);
         renderableFlags |= QSSGRenderableObjectFlag::RequiresScreenTexture;
     }
 
     if (inMaterial.m_renderFlags.testFlag(QSSGRenderCustomMaterial::RenderFlag::ScreenMipTexture)) {
-        ioFlags.setRequiresScreenTexture(true);
-        ioFlags.setRequiresMipmapsForScreenTexture(true);
+        job.flags.setRequiresScreenTexture(true);
+        job.flags.setRequiresMipmapsForScreenTexture(true);
         renderableFlags |= QSSGRenderableObjectFlag::RequiresScreenTexture;
     }
 
     if (inMaterial.m_renderFlags.testFlag(QSSGRenderCustomMaterial::RenderFlag::DepthTexture))
-        ioFlags.setRequiresDepthTexture(true);
+        job.flags.setRequiresDepthTexture(true);
 
     if (inMaterial.m_renderFlags.testFlag(QSSGRenderCustomMaterial::RenderFlag::AoTexture)) {
-        ioFlags.setRequiresDepthTexture(true);
-        ioFlags.setRequiresSsaoPass(true);
+        job.flags.setRequiresDepthTexture(true);
+        job.flags.setRequiresSsaoPass(true);
     }
 
     retval.firstImage = nullptr;
 
     if (retval.dirty || alreadyDirty)
-        renderer->addMaterialDirtyClear(&inMaterial);
+        job.dirtyMaterials.append(&inMaterial);
     return retval;
 }
 
+void QSSGLayerRenderPreparationData::prepareImageResource(QSSGRenderImage *inImage)
+{
+    if (!inImage)
+        return;
+
+    auto it = preparedImages.find(inImage);
+    if (it != preparedImages.end())
+        return;
+
+    // This is where the QRhiTexture gets created, if not already done. Note
+    // that the bufferManager is per-QQuickWindow, and so per-render-thread.
+    // Hence using the same Texture (backed by inImage as the backend node) in
+    // multiple windows will work by each scene in each window getting its own
+    // QRhiTexture. And that's why the QSSGRenderImageTexture cannot be a
+    // member of the QSSGRenderImage. Conceptually this matches what we do for
+    // models (QSSGRenderModel -> QSSGRenderMesh retrieved from the
+    // bufferManager in each prepareModelForRender, etc.).
+    const QSSGRef<QSSGBufferManager> &bufferManager = renderer->contextInterface()->bufferManager();
+    QSSGPreparedRenderImage prepared;
+    prepared.dirty = inImage->clearDirty();
+    prepared.texture = bufferManager->loadRenderImage(inImage, inImage->m_generateMipmaps ? QSSGBufferManager::MipModeGenerated : QSSGBufferManager::MipModeNone);
+    preparedImages.insert(inImage, prepared);
+
+    if (inImage->m_loadStatusPending && !prepared.texture.m_flags.isLoading()) {
+        inImage->m_loadStatusPending = false;
+        loadedImages.append({ inImage, prepared.texture.m_texture != nullptr });
+    }
+}
+
 // inModel is const to emphasize the fact that its members cannot be written
 // here: in case there is a scene shared between multiple View3Ds in different
 // QQuickWindows, each window may run this in their own render thread, while
 // inModel is the same.
-bool QSSGLayerRenderPreparationData::prepareModelForRender(const QSSGRenderModel &inModel,
-                                                           const QMatrix4x4 &inViewProjection,
-                                                           const QSSGOption<QSSGClippingFrustum> &inClipFrustum,
-                                                           QSSGShaderLightList &lights,
-                                                           QSSGLayerRenderPreparationResultFlags &ioFlags)
+QSSGRenderMesh *QSSGLayerRenderPreparationData::prepareModelResources(const QSSGRenderModel &inModel)
 {
     QSSGRenderContextInterface &contextInterface = *renderer->contextInterface();
     const QSSGRef<QSSGBufferManager> &bufferManager = contextInterface.bufferManager();
@@ -851,10 +977,124 @@ bool QSSGLayerRenderPreparationData::prepareModelForRender(const QSSGRenderModel
     QSSGRenderMesh *theMesh = bufferManager->loadMesh(&inModel);
 
     if (theMesh == nullptr)
+        return nullptr;
+
+    const bool canModelBePickable = (inModel.globalOpacity > QSSG_RENDER_MINIMUM_RENDER_OPACITY)
+                                    && (inModel.flags.testFlag(QSSGRenderModel::Flag::GloballyPickable));
+    if (canModelBePickable) {
+        // Check if there is BVH data, if not generate it. This may happen in
+        // the background, in which case picking falls back to the bounds of
+        // the subsets until the BVH has been attached in a later frame.
+        if (bufferManager->prepareMeshBVH(inModel, theMesh)) {
+            if (pickingDataPendingModels.remove(&inModel))
+                pickingDataReadyModels.append(&inModel);
+        } else {
+            pickingDataPendingModels.insert(&inModel);
+        }
+    } else {
+        pickingDataPendingModels.remove(&inModel);
+    }
+
+    bool hasAttributeColor = false;
+    if (theMesh->subsets.size() > 0) {
+        for (const QSSGRhiInputAssemblerState::InputSemantic &sem : qAsConst(theMesh->subsets[0].rhi.ia.inputs)) {
+            if (sem == QSSGRhiInputAssemblerState::ColorSemantic)
+                hasAttributeColor = true;
+        }
+    }
+    const auto &rhiCtx = contextInterface.rhiContext();
+    const bool usesBlendParticles = inModel.particleBuffer != nullptr;
+    const bool usesInstancing = inModel.instancing() && rhiCtx->rhi()->isFeatureSupported(QRhi::Instancing);
+
+    for (int idx = 0; idx < theMesh->subsets.size(); ++idx) {
+        if (inModel.materials.isEmpty())
+            break;
+        QSSGRenderGraphObject *theMaterialObject = (idx + 1 > inModel.materials.count()) ? inModel.materials.last()
+                                                                                          : inModel.materials.at(idx);
+        if (theMaterialObject == nullptr)
+            continue;
+
+        if (theMaterialObject->type == QSSGRenderGraphObject::Type::DefaultMaterial || theMaterialObject->type == QSSGRenderGraphObject::Type::PrincipledMaterial) {
+            QSSGRenderDefaultMaterial &theMaterial(static_cast<QSSGRenderDefaultMaterial &>(*theMaterialObject));
+            // vertexColor should be supported in both DefaultMaterial and PrincipleMaterial
+            // if the mesh has it.
+            theMaterial.vertexColorsEnabled = hasAttributeColor || usesInstancing || usesBlendParticles;
+
+            if (theMaterial.iblProbe)
+                features.set(QSSGShaderFeatures::Feature::LightProbe, true);
+
+            // Textures of completely transparent materials are not needed
+            // (prepareDefaultMaterialForRender skips them), but the ones of
+            // models outside the frustum are kept referenced.
+            if (inModel.globalOpacity * theMaterial.opacity < QSSG_RENDER_MINIMUM_RENDER_OPACITY)
+                continue;
+
+            prepareImageResource(theMaterial.colorMap);
+            prepareImageResource(theMaterial.emissiveMap);
+            prepareImageResource(theMaterial.specularReflection);
+            prepareImageResource(theMaterial.roughnessMap);
+            prepareImageResource(theMaterial.opacityMap);
+            prepareImageResource(theMaterial.bumpMap);
+            prepareImageResource(theMaterial.specularMap);
+            prepareImageResource(theMaterial.normalMap);
+            prepareImageResource(theMaterial.translucencyMap);
+            if (theMaterial.type == QSSGRenderGraphObject::Type::PrincipledMaterial) {
+                prepareImageResource(theMaterial.metalnessMap);
+                prepareImageResource(theMaterial.occlusionMap);
+                prepareImageResource(theMaterial.heightMap);
+                prepareImageResource(theMaterial.clearcoatMap);
+                prepareImageResource(theMaterial.clearcoatRoughnessMap);
+                prepareImageResource(theMaterial.clearcoatNormalMap);
+                prepareImageResource(theMaterial.transmissionMap);
+                prepareImageResource(theMaterial.thicknessMap);
+            }
+        } else if (theMaterialObject->type == QSSGRenderGraphObject::Type::CustomMaterial) {
+            QSSGRenderCustomMaterial &theMaterial(static_cast<QSSGRenderCustomMaterial &>(*theMaterialObject));
+            if (theMaterial.m_iblProbe)
+                theMaterial.m_iblProbe->clearDirty();
+        }
+    }
+
+    return theMesh;
+}
+
+// A model outside of the view frustum still ends up in the depth prepass
+// and the shadow maps with some depth draw modes, and transmission or custom
+// materials affect the layer's screen texture and depth texture needs.
+// Otherwise it does not contribute anything, and there is no need to create
+// renderables for it.
+static bool canSkipCulledModel(const QSSGRenderModel &inModel)
+{
+    for (const QSSGRenderGraphObject *theMaterialObject : inModel.materials) {
+        if (!theMaterialObject)
+            continue;
+        if (theMaterialObject->type != QSSGRenderGraphObject::Type::DefaultMaterial
+                && theMaterialObject->type != QSSGRenderGraphObject::Type::PrincipledMaterial)
+            return false;
+        const QSSGRenderDefaultMaterial &theMaterial(static_cast<const QSSGRenderDefaultMaterial &>(*theMaterialObject));
+        if (theMaterial.depthDrawMode == QSSGDepthDrawMode::Always
+                || theMaterial.depthDrawMode == QSSGDepthDrawMode::OpaquePrePass
+                || theMaterial.isTransmissionEnabled())
+            return false;
+    }
+    return true;
+}
+
+bool QSSGLayerRenderPreparationData::prepareModelForRender(const QSSGRenderModel &inModel,
+                                                           QSSGRenderMesh *theMesh,
+                                                           const QMatrix4x4 &inViewProjection,
+                                                           const QSSGOption<QSSGClippingFrustum> &inClipFrustum,
+                                                           QSSGRenderSceneBVH::Visibility visibility,
+                                                           QSSGShaderLightList &lights,
+                                                           QSSGRenderablePrepJob &job)
+{
+    if (visibility == QSSGRenderSceneBVH::Visibility::Outside && canSkipCulledModel(inModel))
         return false;
 
-    QSSGModelContext &theModelContext = *RENDER_FRAME_NEW<QSSGModelContext>(contextInterface, inModel, inViewProjection);
-    modelContexts.push_back(&theModelContext);
+    QSSGRenderContextInterface &contextInterface = *renderer->contextInterface();
+
+    QSSGModelContext &theModelContext = *RENDER_FRAME_NEW<QSSGModelContext>(*job.allocator, inModel, inViewProjection);
+    job.modelContexts.push_back(&theModelContext);
 
     bool subsetDirty = false;
 
@@ -863,20 +1103,6 @@ bool QSSGLayerRenderPreparationData::prepareModelForRender(const QSSGRenderModel
     // in a somewhat fine-grained style.
     const bool canModelBePickable = (inModel.globalOpacity > QSSG_RENDER_MINIMUM_RENDER_OPACITY)
                                     && (theModelContext.model.flags.testFlag(QSSGRenderModel::Flag::GloballyPickable));
-    if (canModelBePickable) {
-        // Check if there is BVH data, if not generate it
-        if (!theMesh->bvh) {
-            if (!inModel.meshPath.isNull())
-                theMesh->bvh = bufferManager->loadMeshBVH(inModel.meshPath);
-            else if (inModel.geometry)
-                theMesh->bvh = bufferManager->loadMeshBVH(inModel.geometry);
-
-            if (theMesh->bvh) {
-                for (int i = 0; i < theMesh->bvh->roots.count(); ++i)
-                    theMesh->subsets[i].bvhRoot = theMesh->bvh->roots.at(i);
-            }
-        }
-    }
 
     // many renderableFlags are the same for all the subsets
     QSSGRenderableObjectFlags renderableFlagsForModel;
@@ -963,11 +1189,15 @@ bool QSSGLayerRenderPreparationData::prepareModelForRender(const QSSGRenderModel
         theModelCenter = mat44::transform(inModel.globalTransform, theModelCenter);
 
         if (subsetOpacity >= QSSG_RENDER_MINIMUM_RENDER_OPACITY && inClipFrustum.hasValue()) {
-            // Check bounding box against the clipping planes
-            QSSGBounds3 theGlobalBounds = theSubset.bounds;
-            theGlobalBounds.transform(theModelContext.model.globalTransform);
-            if (!inClipFrustum->intersectsWith(theGlobalBounds))
+            if (visibility == QSSGRenderSceneBVH::Visibility::Outside) {
                 subsetOpacity = 0.0f;
+            } else if (visibility == QSSGRenderSceneBVH::Visibility::Intersecting) {
+                // Check bounding box against the clipping planes
+                QSSGBounds3 theGlobalBounds = theSubset.bounds;
+                theGlobalBounds.transform(theModelContext.model.globalTransform);
+                if (!inClipFrustum->intersectsWith(theGlobalBounds))
+                    subsetOpacity = 0.0f;
+            }
         }
 
         renderableFlags.setPointsTopology(theSubset.rhi.ia.topology == QRhiGraphicsPipeline::Points);
@@ -986,11 +1216,12 @@ bool QSSGLayerRenderPreparationData::prepareModelForRender(const QSSGRenderModel
 
         if (theMaterialObject->type == QSSGRenderGraphObject::Type::DefaultMaterial || theMaterialObject->type == QSSGRenderGraphObject::Type::PrincipledMaterial) {
             QSSGRenderDefaultMaterial &theMaterial(static_cast<QSSGRenderDefaultMaterial &>(*theMaterialObject));
-            // vertexColor should be supported in both DefaultMaterial and PrincipleMaterial
-            // if the mesh has it.
-            theMaterial.vertexColorsEnabled = renderableFlags.hasAttributeColor() || usesInstancing || usesBlendParticles;
+            // Same value as what prepareModelResources() stored in the
+            // material, but that may have been overwritten by another model
+            // sharing the material.
+            const bool vertexColorsEnabled = renderableFlags.hasAttributeColor() || usesInstancing || usesBlendParticles;
             QSSGDefaultMaterialPreparationResult theMaterialPrepResult(
-                    prepareDefaultMaterialForRender(theMaterial, renderableFlags, subsetOpacity, lights, ioFlags));
+                    prepareDefaultMaterialForRender(theMaterial, renderableFlags, subsetOpacity, vertexColorsEnabled, lights, job));
             QSSGShaderDefaultMaterialKey &theGeneratedKey(theMaterialPrepResult.materialKey);
             subsetOpacity = theMaterialPrepResult.opacity;
             QSSGRenderableImage *firstImage(theMaterialPrepResult.firstImage);
@@ -1013,7 +1244,7 @@ bool QSSGLayerRenderPreparationData::prepareModelForRender(const QSSGRenderModel
             for (int i = 0; i < inModel.morphAttributes.size(); ++i)
                 renderer->defaultMaterialShaderKeyProperties().m_morphTargetAttributes[i].setValue(theGeneratedKey, inModel.morphAttributes[i] & morphTargetAttribs[i]);
 
-            theRenderableObject = RENDER_FRAME_NEW<QSSGSubsetRenderable>(contextInterface,
+            theRenderableObject = RENDER_FRAME_NEW<QSSGSubsetRenderable>(*job.allocator,
                                                                          renderableFlags,
                                                                          theModelCenter,
                                                                          renderer,
@@ -1036,7 +1267,7 @@ bool QSSGLayerRenderPreparationData::prepareModelForRender(const QSSGRenderModel
 
             QSSGDefaultMaterialPreparationResult theMaterialPrepResult(
                     prepareCustomMaterialForRender(theMaterial, renderableFlags, subsetOpacity, subsetDirty,
-                                                   lights, ioFlags));
+                                                   lights, job));
             QSSGShaderDefaultMaterialKey &theGeneratedKey(theMaterialPrepResult.materialKey);
             subsetOpacity = theMaterialPrepResult.opacity;
             QSSGRenderableImage *firstImage(theMaterialPrepResult.firstImage);
@@ -1062,10 +1293,7 @@ bool QSSGLayerRenderPreparationData::prepareModelForRender(const QSSGRenderModel
             for (int i = 0; i < MAX_MORPH_TARGET; ++i)
                 renderer->defaultMaterialShaderKeyProperties().m_morphTargetAttributes[i].setValue(theGeneratedKey, morphTargetAttribs[i]);
 
-            if (theMaterial.m_iblProbe)
-                theMaterial.m_iblProbe->clearDirty();
-
-            theRenderableObject = RENDER_FRAME_NEW<QSSGSubsetRenderable>(contextInterface,
+            theRenderableObject = RENDER_FRAME_NEW<QSSGSubsetRenderable>(*job.allocator,
                                                                          renderableFlags,
                                                                          theModelCenter,
                                                                          renderer,
@@ -1080,28 +1308,17 @@ bool QSSGLayerRenderPreparationData::prepareModelForRender(const QSSGRenderModel
                                                                          lights,
                                                                          morphWeights);
         }
-        if (theRenderableObject) {
-            if (theRenderableObject->renderableFlags.requiresScreenTexture())
-                screenTextureObjects.push_back(QSSGRenderableObjectHandle::create(theRenderableObject));
-            else if (theRenderableObject->renderableFlags.hasTransparency())
-                transparentObjects.push_back(QSSGRenderableObjectHandle::create(theRenderableObject));
-            else
-                opaqueObjects.push_back(QSSGRenderableObjectHandle::create(theRenderableObject));
-        }
+        if (theRenderableObject)
+            job.addRenderable(theRenderableObject);
     }
 
-    // Now is the time to kick off the vertex/index buffer updates for all the
-    // new meshes (and their submeshes). This here is the last possible place
-    // to kick this off because the rest of the rendering pipeline will only
-    // see the individual sub-objects as "renderable objects".
-    bufferManager->commitBufferResourceUpdates();
-
     return subsetDirty;
 }
 
 bool QSSGLayerRenderPreparationData::prepareParticlesForRender(const QSSGRenderParticles &inParticles,
                                                                const QSSGOption<QSSGClippingFrustum> &inClipFrustum,
-                                                               QSSGShaderLightList &lights)
+                                                               QSSGShaderLightList &lights,
+                                                               QSSGRenderablePrepJob &job)
 {
     QSSGRenderContextInterface &contextInterface = *renderer->contextInterface();
 
@@ -1127,7 +1344,8 @@ bool QSSGLayerRenderPreparationData::prepareParticlesForRender(const QSSGRenderP
     QVector3D center(inParticles.m_particleBuffer.bounds().center());
     center = mat44::transform(inParticles.globalTransform, center);
 
-    if (opacity >= QSSG_RENDER_MINIMUM_RENDER_OPACITY && inClipFrustum.hasValue()) {
+    // The bounds of GPU simulated particles are not known on the CPU
+    if (opacity >= QSSG_RENDER_MINIMUM_RENDER_OPACITY && inClipFrustum.hasValue() && !inParticles.m_simulation.enabled) {
         // Check bounding box against the clipping planes
         QSSGBounds3 theGlobalBounds = inParticles.m_particleBuffer.bounds();
         theGlobalBounds.transform(inParticles.globalTransform);
@@ -1174,14 +1392,8 @@ bool QSSGLayerRenderPreparationData::prepareParticlesForRender(const QSSGRenderP
                                                                               colorTable,
                                                                               lights,
                                                                               opacity);
-        if (theRenderableObject) {
-            if (theRenderableObject->renderableFlags.requiresScreenTexture())
-                screenTextureObjects.push_back(QSSGRenderableObjectHandle::create(theRenderableObject));
-            else if (theRenderableObject->renderableFlags.hasTransparency())
-                transparentObjects.push_back(QSSGRenderableObjectHandle::create(theRenderableObject));
-            else
-                opaqueObjects.push_back(QSSGRenderableObjectHandle::create(theRenderableObject));
-        }
+        if (theRenderableObject)
+            job.addRenderable(theRenderableObject);
     }
 
     return dirty;
@@ -1191,32 +1403,73 @@ bool QSSGLayerRenderPreparationData::prepareRenderablesForRender(const QMatrix4x
                                                                    const QSSGOption<QSSGClippingFrustum> &inClipFrustum,
                                                                    QSSGLayerRenderPreparationResultFlags &ioFlags)
 {
-    bool wasDataDirty = false;
-    QSSGRhiContext *rhiCtx = renderer->contextInterface()->rhiContext().data();
-    for (qint32 idx = 0, end = renderableNodes.size(); idx < end; ++idx) {
+    // Scenes below this size are not worth the cost of waking up the workers.
+    static const qsizetype minNodesPerJob = 64;
+
+    QSSGRenderContextInterface &contextInterface = *renderer->contextInterface();
+    QSSGRenderJobSystem &jobSystem = contextInterface.jobSystem();
+    QSSGRhiContext *rhiCtx = contextInterface.rhiContext().data();
+
+    const qsizetype nodeCount = renderableNodes.size();
+    qsizetype nodesPerJob = qMax(nodeCount, qsizetype(1));
+    if (jobSystem.isEnabled()) {
+        // A few jobs per slot to even out models with very different subset counts.
+        const qsizetype jobsWanted = qsizetype(jobSystem.slotCount()) * 4;
+        nodesPerJob = qMax(minNodesPerJob, (nodeCount + jobsWanted - 1) / jobsWanted);
+    }
+    const int jobCount = int(qMax(qsizetype(1), (nodeCount + nodesPerJob - 1) / nodesPerJob));
+
+    renderablePrepJobs.resize(jobCount);
+    for (QSSGRenderablePrepJob &job : renderablePrepJobs)
+        job.reset();
+    renderableMeshes.fill(nullptr, nodeCount);
+    preparedImages.clear();
+    cullingStats = QSSGCullingStats();
+
+    // The scene BVH is only worth maintaining when something culls with it.
+    const bool useSceneBVH = inClipFrustum.hasValue() || ioFlags.requiresShadowMapPass();
+    if (useSceneBVH)
+        sceneBVH.beginUpdate();
+    else
+        sceneBVH.clear();
+
+    // First pass, on the render thread: buffer manager access and everything
+    // else that is not safe to do from a job. Particles and 2D items are few,
+    // so they are fully prepared here.
+    for (qsizetype idx = 0; idx < nodeCount; ++idx) {
         QSSGRenderableNodeEntry &theNodeEntry(renderableNodes[idx]);
         QSSGRenderNode *theNode = theNodeEntry.node;
-        wasDataDirty = wasDataDirty || theNode->flags.testFlag(QSSGRenderNode::Flag::Dirty);
+        QSSGRenderablePrepJob &job = renderablePrepJobs[idx / nodesPerJob];
+        // The global variables were calculated by transformStore.update()
+        // already, and the dirty state was folded into wasDataDirty there.
         switch (theNode->type) {
         case QSSGRenderGraphObject::Type::Model: {
             QSSGRenderModel *theModel = static_cast<QSSGRenderModel *>(theNode);
-            theModel->calculateGlobalVariables();
             if (theModel->flags.testFlag(QSSGRenderModel::Flag::GloballyActive)) {
-                bool wasModelDirty = prepareModelForRender(*theModel, inViewProjection, inClipFrustum, theNodeEntry.lights, ioFlags);
-                wasDataDirty = wasDataDirty || wasModelDirty;
+                QSSGRenderMesh *theMesh = prepareModelResources(*theModel);
+                renderableMeshes[idx] = theMesh;
+                // Instanced and particle models draw outside of their mesh
+                // bounds, these keep being tested per subset.
+                if (useSceneBVH && theMesh && !theModel->instancing() && !theModel->particleBuffer) {
+                    QSSGBounds3 meshBounds;
+                    for (const QSSGRenderSubset &theSubset : qAsConst(theMesh->subsets))
+                        meshBounds.include(theSubset.bounds);
+                    if (!meshBounds.isEmpty()) {
+                        const qint32 slot = qint32(theModel->dfsIndex) - 1;
+                        sceneBVH.addLeaf(theModel, slot, meshBounds, transformStore.wasDirty(slot));
+                    }
+                }
             }
         } break;
         case QSSGRenderGraphObject::Type::Particles: {
             QSSGRenderParticles *theParticles = static_cast<QSSGRenderParticles *>(theNode);
-            theParticles->calculateGlobalVariables();
             if (theParticles->flags.testFlag(QSSGRenderModel::Flag::GloballyActive)) {
-                bool wasModelDirty = prepareParticlesForRender(*theParticles, inClipFrustum, theNodeEntry.lights);
-                wasDataDirty = wasDataDirty || wasModelDirty;
+                bool wasModelDirty = prepareParticlesForRender(*theParticles, inClipFrustum, theNodeEntry.lights, job);
+                job.wasDataDirty = job.wasDataDirty || wasModelDirty;
             }
         } break;
         case QSSGRenderGraphObject::Type::Item2D: {
             QSSGRenderItem2D *theItem2D = static_cast<QSSGRenderItem2D *>(theNode);
-            theItem2D->calculateGlobalVariables();
             if (theItem2D->flags.testFlag(QSSGRenderModel::Flag::GloballyActive)) {
                 theItem2D->MVP = inViewProjection * theItem2D->globalTransform;
                 static const QMatrix4x4 flipMatrix(1.0f, 0.0f, 0.0f, 0.0f,
@@ -1234,6 +1487,54 @@ bool QSSGLayerRenderPreparationData::prepareRenderablesForRender(const QMatrix4x
             break;
         }
     }
+
+    // Now is the time to kick off the vertex/index buffer updates for all the
+    // new meshes (and their submeshes). This here is the last possible place
+    // to kick this off because the rest of the rendering pipeline will only
+    // see the individual sub-objects as "renderable objects".
+    contextInterface.bufferManager()->commitBufferResourceUpdates();
+
+    if (useSceneBVH)
+        sceneBVH.endUpdate();
+    if (inClipFrustum.hasValue())
+        sceneBVH.cull(*inClipFrustum, cameraVisibility, transformStore.size(), cullingStats);
+    else
+        cameraVisibility.fill(QSSGRenderSceneBVH::Visibility::Intersecting, transformStore.size());
+
+    // Second pass: culling, material keys and renderable creation. With the
+    // job system disabled this runs inline, one job after the other.
+    jobSystem.run(jobCount, [&](int jobIndex, int slot) {
+        QSSGRenderablePrepJob &job = renderablePrepJobs[jobIndex];
+        job.allocator = &jobSystem.allocator(slot);
+        const qsizetype begin = jobIndex * nodesPerJob;
+        const qsizetype end = qMin(begin + nodesPerJob, nodeCount);
+        for (qsizetype idx = begin; idx < end; ++idx) {
+            QSSGRenderMesh *theMesh = renderableMeshes.at(idx);
+            if (!theMesh)
+                continue;
+            QSSGRenderableNodeEntry &theNodeEntry(renderableNodes[idx]);
+            const QSSGRenderModel &theModel = static_cast<const QSSGRenderModel &>(*theNodeEntry.node);
+            const QSSGRenderSceneBVH::Visibility visibility = cameraVisibility.at(theModel.dfsIndex - 1);
+            bool wasModelDirty = prepareModelForRender(theModel, theMesh, inViewProjection, inClipFrustum,
+                                                       visibility, theNodeEntry.lights, job);
+            job.wasDataDirty = job.wasDataDirty || wasModelDirty;
+        }
+    });
+
+    // Merge in job order, so that the result does not depend on the number of
+    // threads or on which job finished first.
+    bool wasDataDirty = false;
+    for (const QSSGRenderablePrepJob &job : qAsConst(renderablePrepJobs)) {
+        modelContexts.append(job.modelContexts);
+        opaqueObjects.append(job.opaqueObjects);
+        transparentObjects.append(job.transparentObjects);
+        screenTextureObjects.append(job.screenTextureObjects);
+        for (QSSGRenderGraphObject *material : job.dirtyMaterials)
+            renderer->addMaterialDirtyClear(material);
+        ioFlags |= job.flags;
+        wasDataDirty = wasDataDirty || job.wasDataDirty;
+    }
+
     return wasDataDirty;
 }
 
@@ -1424,6 +1725,7 @@ void QSSGLayerRenderPreparationData::prepareForRender()
             // First model using skeleton clears the dirty flag so we need another mechanism
             // to tell to the other models the skeleton is dirty.
             QVector<QSSGRenderSkeleton*> dirtySkeletons;
+            transformStore.clear();
             for (auto &theChild : layer.children)
                 maybeQueueNodeForRender(theChild,
                                         renderableNodes,
@@ -1435,9 +1737,16 @@ void QSSGLayerRenderPreparationData::prepareForRender()
                                         reflectionProbes,
                                         reflectionProbeCount,
                                         dfsIndex,
+                                        transformStore,
+                                        -1,
                                         dirtySkeletons);
             dirtySkeletons.clear();
 
+            // Global transforms, opacity and active state of every node in
+            // one linear pass. Cameras, lights and renderables find their
+            // Dirty flag cleared afterwards.
+            wasDataDirty = transformStore.update() || wasDataDirty;
+
             if (renderableNodes.size() != renderableNodeCount)
                 renderableNodes.resize(renderableNodeCount);
             if (cameras.size() != cameraNodeCount)
@@ -1535,22 +1844,30 @@ void QSSGLayerRenderPreparationData::prepareForRender()
 
             }
 
+            QVector<QSSGShadowMapRequest> shadowMapRequests;
             const auto lightCount = renderableLights.size();
             for (int lightIdx = 0; lightIdx < lightCount; lightIdx++) {
                 auto &shaderLight = renderableLights[lightIdx];
                 shaderLight.direction = shaderLight.light->getScalingCorrectDirection();
                 if (shaderLight.shadows) {
-                    if (!shadowMapManager)
-                        shadowMapManager = new QSSGRenderShadowMap(*renderer->contextInterface());
-
-                    quint32 mapSize = 1 << shaderLight.light->m_shadowMapRes;
+                    const qint32 mapSize = 1 << shaderLight.light->m_shadowMapRes;
                     ShadowMapModes mapMode = (shaderLight.light->type != QSSGRenderLight::Type::DirectionalLight)
                             ? ShadowMapModes::CUBE
                             : ShadowMapModes::VSM;
-                    shadowMapManager->addShadowMapEntry(lightIdx,
-                                                        mapSize,
-                                                        mapSize,
-                                                        mapMode);
+                    // Directional lights affect everything, for the others
+                    // the size of their range on screen is a good enough
+                    // measure of how visible their shadows can be.
+                    float importance = std::numeric_limits<float>::max();
+                    if (mapMode == ShadowMapModes::CUBE && camera) {
+                        const float distance = (shaderLight.light->getGlobalPos() - camera->getGlobalPos()).length();
+                        importance = shaderLight.light->m_shadowMapFar / qMax(distance, 0.001f);
+                    }
+                    QSSGShadowMapRequest request { lightIdx, mapSize, mapMode, importance };
+                    if (mapMode == ShadowMapModes::VSM) {
+                        request.cascadeCount = qBound(1, int(shaderLight.light->m_cascadeCount), QSSG_MAX_NUM_SHADOW_CASCADES);
+                        request.cascadeResolutionScale = shaderLight.light->m_cascadeResolutionScale;
+                    }
+                    shadowMapRequests.append(request);
                     thePrepResult.flags.setRequiresShadowMapPass(true);
                     // Any light with castShadow=true triggers shadow mapping
                     // in the generated shaders. The fact that some (or even
@@ -1560,6 +1877,12 @@ void QSSGLayerRenderPreparationData::prepareForRender()
                 }
             }
 
+            if (!shadowMapRequests.isEmpty() || shadowMapManager) {
+                if (!shadowMapManager)
+                    shadowMapManager = new QSSGRenderShadowMap(*renderer->contextInterface());
+                shadowMapManager->updateShadowMapEntries(shadowMapRequests);
+            }
+
             for (const QSSGShaderLight &shaderLight : qAsConst(renderableLights)) {
                 if (!shaderLight.light->m_scope)
                     globalLights.append(shaderLight);
@@ -1649,6 +1972,8 @@ void QSSGLayerRenderPreparationData::resetForFrame()
     renderedItem2Ds.clear();
     renderedOpaqueDepthPrepassObjects.clear();
     renderedDepthWriteObjects.clear();
+    pickingDataReadyModels.clear();
+    loadedImages.clear();
 }
 
 QSSGLayerRenderPreparationResult::QSSGLayerRenderPreparationResult(const QRectF &inViewport, const QRectF &inScissor, QSSGRenderLayer &inLayer)
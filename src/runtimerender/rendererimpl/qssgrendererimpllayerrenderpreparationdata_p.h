@@ -51,15 +51,22 @@
 #include <QtQuick3DRuntimeRender/private/qssgrenderresourceloader_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrenderreflectionmap_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrendercamera_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrenderimagetexture_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgperframeallocator_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrendertransformstore_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrenderscenebvh_p.h>
 
 #include <QtQuick3DUtils/private/qssgrenderbasetypes_p.h>
 
+#include <QtCore/QSet>
+
 #define QSSG_RENDER_MINIMUM_RENDER_OPACITY .01f
 
 QT_BEGIN_NAMESPACE
 
 class QSSGRendererImpl;
 struct QSSGRenderableObject;
+struct QSSGRenderMesh;
 
 enum class QSSGLayerRenderPreparationResultFlag
 {
@@ -179,6 +186,53 @@ struct QSSGDefaultMaterialPreparationResult
     explicit QSSGDefaultMaterialPreparationResult(QSSGShaderDefaultMaterialKey inMaterialKey);
 };
 
+// Texture lookup result for a QSSGRenderImage, resolved once per frame on
+// the render thread before the renderable preparation jobs run.
+struct QSSGPreparedRenderImage
+{
+    QSSGRenderImageTexture texture;
+    bool dirty = false;
+};
+
+// Output of one renderable preparation job. A job covers a contiguous range
+// of renderableNodes and only ever writes to its own QSSGRenderablePrepJob,
+// allocating from the per-frame arena of the worker slot it runs on. The
+// results of all jobs are merged in job order, so the outcome does not
+// depend on how many threads were used.
+struct QSSGRenderablePrepJob
+{
+    QSSGPerFrameAllocator *allocator = nullptr;
+    QVector<QSSGModelContext *> modelContexts;
+    QVector<QSSGRenderableObjectHandle> opaqueObjects;
+    QVector<QSSGRenderableObjectHandle> transparentObjects;
+    QVector<QSSGRenderableObjectHandle> screenTextureObjects;
+    QVector<QSSGRenderGraphObject *> dirtyMaterials;
+    QSSGLayerRenderPreparationResultFlags flags;
+    bool wasDataDirty = false;
+
+    void reset()
+    {
+        allocator = nullptr;
+        modelContexts.clear();
+        opaqueObjects.clear();
+        transparentObjects.clear();
+        screenTextureObjects.clear();
+        dirtyMaterials.clear();
+        flags = QSSGLayerRenderPreparationResultFlags();
+        wasDataDirty = false;
+    }
+
+    void addRenderable(QSSGRenderableObject *obj)
+    {
+        if (obj->renderableFlags.requiresScreenTexture())
+            screenTextureObjects.push_back(QSSGRenderableObjectHandle::create(obj));
+        else if (obj->renderableFlags.hasTransparency())
+            transparentObjects.push_back(QSSGRenderableObjectHandle::create(obj));
+        else
+            opaqueObjects.push_back(QSSGRenderableObjectHandle::create(obj));
+    }
+};
+
 // Data used strictly in the render preparation step.
 struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGLayerRenderPreparationData
 {
@@ -203,6 +257,8 @@ struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGLayerRenderPreparationData
     QVector<QSSGRenderReflectionProbe *> reflectionProbes;
     QVector<QSSGRenderableNodeEntry> renderableItem2Ds;
     QVector<QSSGRenderableNodeEntry> renderedItem2Ds;
+    // All the nodes of the layer in depth-first order, slot is dfsIndex - 1.
+    QSSGRenderTransformStore transformStore;
 
     // Results of prepare for render.
     QSSGRenderCamera *camera;
@@ -217,12 +273,35 @@ struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGLayerRenderPreparationData
     TRenderableObjectList renderedScreenTextureObjects;
     TRenderableObjectList renderedOpaqueDepthPrepassObjects;
     TRenderableObjectList renderedDepthWriteObjects;
+    // Second buffer for the radix sort of the lists above.
+    TRenderableObjectList renderableSortScratch;
     QSSGOption<QSSGClippingFrustum> clippingFrustum;
     QSSGOption<QSSGLayerRenderPreparationResult> layerPrepResult;
     QSSGOption<QVector3D> cameraDirection;
 
     TModelContextPtrList modelContexts;
 
+    // Scratch data for prepareRenderablesForRender, kept around to reuse the allocations.
+    QVector<QSSGRenderMesh *> renderableMeshes; // indexed like renderableNodes
+    QHash<const QSSGRenderImage *, QSSGPreparedRenderImage> preparedImages;
+    QVector<QSSGRenderablePrepJob> renderablePrepJobs;
+
+    // Models of the layer, for culling against the camera and the shadow
+    // casting lights. The visibility lists are indexed by transformStore slot.
+    QSSGRenderSceneBVH sceneBVH;
+    QVector<QSSGRenderSceneBVH::Visibility> cameraVisibility;
+    QVector<QSSGRenderSceneBVH::Visibility> shadowCasterVisibility;
+    QSSGCullingStats cullingStats;
+
+    // Models for which the BVH used for picking became available this frame,
+    // and the ones still waiting for it. Kept per layer since the model may be
+    // shared with other layers, which have their own BVH builds.
+    QVector<const QSSGRenderModel *> pickingDataReadyModels;
+    QSet<const QSSGRenderModel *> pickingDataPendingModels;
+    // Images loaded from a file that became available, or failed to load,
+    // this frame. The flag is false for the latter.
+    QVector<QPair<QSSGRenderImage *, bool>> loadedImages;
+
     QSSGShaderFeatures features;
     bool tooManyLightsWarningShown = false;
     bool tooManyShadowLightsWarningShown = false;
@@ -237,39 +316,53 @@ struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGLayerRenderPreparationData
     QSSGShaderDefaultMaterialKey generateLightingKey(QSSGRenderDefaultMaterial::MaterialLighting inLightingType,
                                                      const QSSGShaderLightList &lights, bool receivesShadows = true);
 
+    // Render thread only: everything that goes through the buffer manager or
+    // writes to scene objects shared between models (meshes, BVHs, textures,
+    // dirty flags) is resolved here, so that prepareModelForRender can run on
+    // a worker thread afterwards. Returns null if the model has no mesh.
+    QSSGRenderMesh *prepareModelResources(const QSSGRenderModel &inModel);
+    void prepareImageResource(QSSGRenderImage *inImage);
+
     void prepareImageForRender(QSSGRenderImage &inImage,
                                QSSGRenderableImage::Type inMapType,
                                QSSGRenderableImage *&ioFirstImage,
                                QSSGRenderableImage *&ioNextImage,
                                QSSGRenderableObjectFlags &ioFlags,
                                QSSGShaderDefaultMaterialKey &ioGeneratedShaderKey,
-                               quint32 inImageIndex, QSSGRenderDefaultMaterial *inMaterial = nullptr);
+                               quint32 inImageIndex,
+                               QSSGRenderablePrepJob &job,
+                               QSSGRenderDefaultMaterial *inMaterial = nullptr);
 
     void setVertexInputPresence(const QSSGRenderableObjectFlags &renderableFlags,
                                 QSSGShaderDefaultMaterialKey &key,
                                 QSSGRenderer *renderer);
 
     QSSGDefaultMaterialPreparationResult prepareDefaultMaterialForRender(QSSGRenderDefaultMaterial &inMaterial,
-                                                                           QSSGRenderableObjectFlags &inExistingFlags,
-                                                                           float inOpacity,
+                                                                         QSSGRenderableObjectFlags &inExistingFlags,
+                                                                         float inOpacity,
+                                                                         bool vertexColorsEnabled,
                                                                          const QSSGShaderLightList &lights,
-                                                                         QSSGLayerRenderPreparationResultFlags &ioFlags);
+                                                                         QSSGRenderablePrepJob &job);
 
     QSSGDefaultMaterialPreparationResult prepareCustomMaterialForRender(QSSGRenderCustomMaterial &inMaterial,
                                                                         QSSGRenderableObjectFlags &inExistingFlags,
                                                                         float inOpacity, bool alreadyDirty,
                                                                         const QSSGShaderLightList &lights,
-                                                                        QSSGLayerRenderPreparationResultFlags &ioFlags);
+                                                                        QSSGRenderablePrepJob &job);
 
     // Updates lights with model receivesShadows. Do not pass globalLights.
+    // May run on a worker thread, see prepareModelResources().
     bool prepareModelForRender(const QSSGRenderModel &inModel,
+                               QSSGRenderMesh *theMesh,
                                const QMatrix4x4 &inViewProjection,
                                const QSSGOption<QSSGClippingFrustum> &inClipFrustum,
+                               QSSGRenderSceneBVH::Visibility visibility,
                                QSSGShaderLightList &lights,
-                               QSSGLayerRenderPreparationResultFlags &ioFlags);
+                               QSSGRenderablePrepJob &job);
     bool prepareParticlesForRender(const QSSGRenderParticles &inParticles,
                                    const QSSGOption<QSSGClippingFrustum> &inClipFrustum,
-                                   QSSGShaderLightList &lights);
+                                   QSSGShaderLightList &lights,
+                                   QSSGRenderablePrepJob &job);
 
     // Helper function used during PrepareForRender and PrepareAndRender
     bool prepareRenderablesForRender(const QMatrix4x4 &inViewProjection,
@@ -290,6 +383,16 @@ struct Q_QUICK3DRUNTIMERENDER_EXPORT QSSGLayerRenderPreparationData
     const QVector<QSSGRenderableObjectHandle> &getScreenTextureRenderableObjects();
     const QVector<QSSGRenderableNodeEntry> &getRenderableItem2Ds();
 
+    // The sorting of the render lists, see getOpaqueRenderableObjects() for
+    // the layout of the opaque keys
+    static void radixSortRenderables(TRenderableObjectList &objects, TRenderableObjectList &scratch);
+    static void sortBackToFront(TRenderableObjectList &objects,
+                                TRenderableObjectList &scratch,
+                                const QVector3D &cameraPosition,
+                                const QVector3D &cameraDirection);
+    static quint64 opaqueSortKey(float distance, float minDistance, float maxDistance,
+                                 quint32 pipelineHash, quint32 resourceHash);
+
     virtual void resetForFrame();
 };
 QT_END_NAMESPACE
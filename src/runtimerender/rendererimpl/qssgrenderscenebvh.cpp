@@ -0,0 +1,230 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Quick 3D.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qssgrenderscenebvh_p.h"
+
+#include <QtQuick3DRuntimeRender/private/qssgrendernode_p.h>
+
+#include <algorithm>
+
+QT_BEGIN_NAMESPACE
+
+static constexpr qint32 maxLeavesPerNode = 4;
+static constexpr quint32 allPlanesMask = (1u << 6) - 1;
+
+void QSSGRenderSceneBVH::clear()
+{
+    m_leaves.clear();
+    m_order.clear();
+    m_nodes.clear();
+    m_leafCount = 0;
+    m_movedSinceBuild = 0;
+    m_needsRebuild = true;
+    m_needsRefit = false;
+}
+
+void QSSGRenderSceneBVH::beginUpdate()
+{
+    m_leafCount = 0;
+    m_needsRefit = false;
+}
+
+void QSSGRenderSceneBVH::addLeaf(const QSSGRenderNode *node, qint32 key, const QSSGBounds3 &localBounds, bool transformChanged)
+{
+    const qsizetype index = m_leafCount++;
+    if (index < m_leaves.size()) {
+        Leaf &leaf = m_leaves[index];
+        if (leaf.node != node || leaf.key != key)
+            m_needsRebuild = true;
+        const bool boundsChanged = leaf.localBounds.minimum != localBounds.minimum
+                || leaf.localBounds.maximum != localBounds.maximum;
+        if (m_needsRebuild || transformChanged || boundsChanged) {
+            leaf.node = node;
+            leaf.key = key;
+            leaf.localBounds = localBounds;
+            leaf.worldBounds = localBounds;
+            leaf.worldBounds.transform(node->globalTransform);
+            ++m_movedSinceBuild;
+            m_needsRefit = true;
+        }
+    } else {
+        QSSGBounds3 worldBounds = localBounds;
+        worldBounds.transform(node->globalTransform);
+        m_leaves.append({ node, key, localBounds, worldBounds });
+        m_needsRebuild = true;
+    }
+}
+
+void QSSGRenderSceneBVH::endUpdate()
+{
+    if (m_leafCount != m_leaves.size()) {
+        m_leaves.resize(m_leafCount);
+        m_needsRebuild = true;
+    }
+
+    // Refitting keeps the topology, which degrades as the leaves move away
+    // from where they were when the tree was built.
+    if (m_movedSinceBuild > qMax(m_leafCount / 4, qsizetype(maxLeavesPerNode)))
+        m_needsRebuild = true;
+
+    if (m_needsRebuild) {
+        m_order.resize(m_leafCount);
+        for (qint32 i = 0; i < qint32(m_leafCount); ++i)
+            m_order[i] = i;
+        m_nodes.resize(0);
+        if (m_leafCount > 0)
+            build(0, qint32(m_leafCount));
+        m_movedSinceBuild = 0;
+        m_needsRebuild = false;
+    } else if (m_needsRefit) {
+        refit();
+    }
+    m_needsRefit = false;
+}
+
+qint32 QSSGRenderSceneBVH::build(qint32 first, qint32 count)
+{
+    const qint32 nodeIndex = qint32(m_nodes.size());
+    m_nodes.append(Node{ QSSGBounds3(), first, count, -1 });
+
+    QSSGBounds3 bounds;
+    QSSGBounds3 centers;
+    for (qint32 i = first; i < first + count; ++i) {
+        const QSSGBounds3 &leafBounds = m_leaves.at(m_order.at(i)).worldBounds;
+        bounds.include(leafBounds);
+        centers.include(leafBounds.center());
+    }
+    m_nodes[nodeIndex].bounds = bounds;
+
+    if (count <= maxLeavesPerNode)
+        return nodeIndex;
+
+    // Median split along the axis with the largest spread of centers.
+    const QVector3D extents = centers.dimensions();
+    int axis = 0;
+    if (extents.y() > extents.x())
+        axis = 1;
+    if (extents.z() > extents[axis])
+        axis = 2;
+    const qint32 half = count / 2;
+    auto begin = m_order.begin() + first;
+    std::nth_element(begin, begin + half, begin + count, [this, axis](qint32 a, qint32 b) {
+        return m_leaves.at(a).worldBounds.center(axis) < m_leaves.at(b).worldBounds.center(axis);
+    });
+
+    build(first, half);
+    const qint32 right = build(first + half, count - half);
+    m_nodes[nodeIndex].right = right;
+    return nodeIndex;
+}
+
+void QSSGRenderSceneBVH::refit()
+{
+    // Children always come after their parent.
+    for (qsizetype i = m_nodes.size() - 1; i >= 0; --i) {
+        Node &node = m_nodes[i];
+        QSSGBounds3 bounds;
+        if (node.right < 0) {
+            for (qint32 j = node.first; j < node.first + node.count; ++j)
+                bounds.include(m_leaves.at(m_order.at(j)).worldBounds);
+        } else {
+            bounds = m_nodes.at(i + 1).bounds;
+            bounds.include(m_nodes.at(node.right).bounds);
+        }
+        node.bounds = bounds;
+    }
+}
+
+// Same plane tests as QSSGClippingFrustum::intersectsWith(), but planes the
+// box is completely in front of are dropped from the mask, as they do not
+// need to be tested again for anything contained in the box.
+static QSSGRenderSceneBVH::Visibility classify(const QSSGClippingFrustum &frustum, const QSSGBounds3 &bounds, quint32 &planeMask)
+{
+    for (quint32 idx = 0; idx < 6; ++idx) {
+        if (!(planeMask & (1u << idx)))
+            continue;
+        const int result = frustum.mPlanes[idx].intersect(bounds);
+        if (result < 0)
+            return QSSGRenderSceneBVH::Visibility::Outside;
+        if (result > 0)
+            planeMask &= ~(1u << idx);
+    }
+    return planeMask ? QSSGRenderSceneBVH::Visibility::Intersecting : QSSGRenderSceneBVH::Visibility::Inside;
+}
+
+void QSSGRenderSceneBVH::cull(const QSSGClippingFrustum &frustum,
+                              QVector<Visibility> &visibility,
+                              qsizetype keyCount,
+                              QSSGCullingStats &stats) const
+{
+    visibility.fill(Visibility::Intersecting, keyCount);
+    if (!m_nodes.isEmpty())
+        cullNode(0, allPlanesMask, frustum, visibility, stats);
+}
+
+void QSSGRenderSceneBVH::cullNode(qint32 nodeIndex,
+                                  quint32 planeMask,
+                                  const QSSGClippingFrustum &frustum,
+                                  QVector<Visibility> &visibility,
+                                  QSSGCullingStats &stats) const
+{
+    const Node &node = m_nodes.at(nodeIndex);
+    ++stats.testCount;
+    const Visibility nodeVisibility = classify(frustum, node.bounds, planeMask);
+    if (nodeVisibility != Visibility::Intersecting) {
+        markRange(node, nodeVisibility, visibility);
+        if (nodeVisibility == Visibility::Outside)
+            stats.culledNodeCount += node.count;
+        return;
+    }
+
+    if (node.right >= 0) {
+        cullNode(nodeIndex + 1, planeMask, frustum, visibility, stats);
+        cullNode(node.right, planeMask, frustum, visibility, stats);
+        return;
+    }
+
+    for (qint32 i = node.first; i < node.first + node.count; ++i) {
+        const Leaf &leaf = m_leaves.at(m_order.at(i));
+        quint32 leafMask = planeMask;
+        ++stats.testCount;
+        const Visibility leafVisibility = classify(frustum, leaf.worldBounds, leafMask);
+        visibility[leaf.key] = leafVisibility;
+        if (leafVisibility == Visibility::Outside)
+            ++stats.culledNodeCount;
+    }
+}
+
+void QSSGRenderSceneBVH::markRange(const Node &node, Visibility value, QVector<Visibility> &visibility) const
+{
+    for (qint32 i = node.first; i < node.first + node.count; ++i)
+        visibility[m_leaves.at(m_order.at(i)).key] = value;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,136 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Quick 3D.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSSG_RENDER_SCENE_BVH_H
+#define QSSG_RENDER_SCENE_BVH_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtQuick3DRuntimeRender/private/qtquick3druntimerenderglobal_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrenderclippingfrustum_p.h>
+
+#include <QtQuick3DUtils/private/qssgbounds3_p.h>
+
+#include <QtCore/QVector>
+
+QT_BEGIN_NAMESPACE
+
+struct QSSGRenderNode;
+
+struct QSSGCullingStats
+{
+    int testCount = 0; // bounding box vs. frustum tests
+    int culledNodeCount = 0; // renderable nodes rejected by a frustum
+};
+
+// Bounding volume hierarchy over the world space bounds of the models in a
+// layer, used to reject whole groups of models against the camera and the
+// shadow casting light frustums.
+//
+// The leaves are passed in every frame, in scene order. As long as the set
+// of leaves stays the same, the tree is only refitted to the changed bounds.
+// It is rebuilt when models are added or removed, or once enough of them have
+// moved for the old topology to become a poor fit.
+class Q_QUICK3DRUNTIMERENDER_EXPORT QSSGRenderSceneBVH
+{
+public:
+    enum class Visibility : quint8
+    {
+        Outside,
+        Intersecting,
+        Inside
+    };
+
+    void clear();
+    bool isEmpty() const { return m_nodes.isEmpty(); }
+
+    void beginUpdate();
+    // key identifies the leaf in the visibility results. localBounds are
+    // transformed by the node's globalTransform, which is only redone when
+    // transformChanged is set or the local bounds differ from the last frame.
+    void addLeaf(const QSSGRenderNode *node, qint32 key, const QSSGBounds3 &localBounds, bool transformChanged);
+    void endUpdate();
+
+    // Resizes visibility to keyCount and fills it in for every leaf. Keys not
+    // present in the tree are reported as Intersecting, so that the caller
+    // falls back to its own tests for them.
+    void cull(const QSSGClippingFrustum &frustum,
+              QVector<Visibility> &visibility,
+              qsizetype keyCount,
+              QSSGCullingStats &stats) const;
+
+private:
+    struct Leaf
+    {
+        const QSSGRenderNode *node;
+        qint32 key;
+        QSSGBounds3 localBounds;
+        QSSGBounds3 worldBounds;
+    };
+
+    // Depth-first layout: the left child of an inner node directly follows
+    // it. [first, first + count) is the range in m_order covered by the node.
+    struct Node
+    {
+        QSSGBounds3 bounds;
+        qint32 first;
+        qint32 count;
+        qint32 right; // -1 for leaf nodes
+    };
+
+    qint32 build(qint32 first, qint32 count);
+    void refit();
+    void cullNode(qint32 nodeIndex,
+                  quint32 planeMask,
+                  const QSSGClippingFrustum &frustum,
+                  QVector<Visibility> &visibility,
+                  QSSGCullingStats &stats) const;
+    void markRange(const Node &node, Visibility value, QVector<Visibility> &visibility) const;
+
+    QVector<Leaf> m_leaves;
+    QVector<qint32> m_order; // leaf indices, ordered as the nodes reference them
+    QVector<Node> m_nodes;
+    qsizetype m_leafCount = 0;
+    qsizetype m_movedSinceBuild = 0;
+    bool m_needsRebuild = true;
+    bool m_needsRefit = false;
+};
+
+QT_END_NAMESPACE
+
+#endif // QSSG_RENDER_SCENE_BVH_H
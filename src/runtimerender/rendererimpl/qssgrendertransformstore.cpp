@@ -0,0 +1,139 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Quick 3D.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qssgrendertransformstore_p.h"
+
+#include <QtQuick3DRuntimeRender/private/qssgrendernode_p.h>
+
+#include <QtCore/private/qsimd_p.h>
+
+#include <cstring>
+
+QT_BEGIN_NAMESPACE
+
+void QSSGRenderTransformStore::clear()
+{
+    // Keep the capacity, the node count of a scene rarely changes much.
+    m_nodes.resize(0);
+    m_parents.resize(0);
+    m_world.resize(0);
+    m_dirty.resize(0);
+}
+
+qint32 QSSGRenderTransformStore::add(QSSGRenderNode *node, qint32 parentSlot)
+{
+    Q_ASSERT(parentSlot < qint32(m_nodes.size()));
+    const qint32 slot = qint32(m_nodes.size());
+    m_nodes.append(node);
+    m_parents.append(parentSlot);
+    m_world.append(Matrix());
+    m_dirty.append(0);
+    return slot;
+}
+
+// out = a * b, all three column-major 4x4 matrices. out must not alias a or b.
+void QSSGRenderTransformStore::multiply(const float *a, const float *b, float *out)
+{
+#if defined(__SSE2__)
+    const __m128 a0 = _mm_loadu_ps(a);
+    const __m128 a1 = _mm_loadu_ps(a + 4);
+    const __m128 a2 = _mm_loadu_ps(a + 8);
+    const __m128 a3 = _mm_loadu_ps(a + 12);
+    for (int col = 0; col < 4; ++col) {
+        const float *bc = b + col * 4;
+        __m128 r = _mm_mul_ps(a0, _mm_set1_ps(bc[0]));
+        r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(bc[1])));
+        r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(bc[2])));
+        r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_set1_ps(bc[3])));
+        _mm_storeu_ps(out + col * 4, r);
+    }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    const float32x4_t a0 = vld1q_f32(a);
+    const float32x4_t a1 = vld1q_f32(a + 4);
+    const float32x4_t a2 = vld1q_f32(a + 8);
+    const float32x4_t a3 = vld1q_f32(a + 12);
+    for (int col = 0; col < 4; ++col) {
+        const float *bc = b + col * 4;
+        float32x4_t r = vmulq_n_f32(a0, bc[0]);
+        r = vmlaq_n_f32(r, a1, bc[1]);
+        r = vmlaq_n_f32(r, a2, bc[2]);
+        r = vmlaq_n_f32(r, a3, bc[3]);
+        vst1q_f32(out + col * 4, r);
+    }
+#else
+    for (int col = 0; col < 4; ++col) {
+        for (int row = 0; row < 4; ++row) {
+            out[col * 4 + row] = a[row] * b[col * 4]
+                               + a[4 + row] * b[col * 4 + 1]
+                               + a[8 + row] * b[col * 4 + 2]
+                               + a[12 + row] * b[col * 4 + 3];
+        }
+    }
+#endif
+}
+
+bool QSSGRenderTransformStore::update()
+{
+    bool anyDirty = false;
+    const qsizetype count = m_nodes.size();
+    for (qsizetype slot = 0; slot < count; ++slot) {
+        QSSGRenderNode *node = m_nodes.at(slot);
+        Matrix &world = m_world[slot];
+        const bool dirty = node->flags.testFlag(QSSGRenderNode::Flag::Dirty);
+        m_dirty[slot] = dirty;
+        if (!dirty) {
+            std::memcpy(world.m, node->globalTransform.constData(), sizeof(world.m));
+            continue;
+        }
+        anyDirty = true;
+
+        const qint32 parentSlot = m_parents.at(slot);
+        if (parentSlot < 0 && node->parent && node->parent->type != QSSGRenderGraphObject::Type::Layer) {
+            // Not parented to the layer itself (for example an imported scene
+            // root), the parent chain is outside of the store.
+            node->calculateGlobalVariables();
+            std::memcpy(world.m, node->globalTransform.constData(), sizeof(world.m));
+            continue;
+        }
+
+        node->flags.setFlag(QSSGRenderNode::Flag::Dirty, false);
+        node->calculateLocalTransform();
+        const float *local = node->localTransform.constData();
+        if (parentSlot >= 0 && !node->flags.testFlag(QSSGRenderNode::Flag::IgnoreParentTransform))
+            multiply(m_world.at(parentSlot).m, local, world.m);
+        else
+            std::memcpy(world.m, local, sizeof(world.m));
+        // data() and not constData(), this marks the matrix as a general one.
+        std::memcpy(node->globalTransform.data(), world.m, sizeof(world.m));
+        node->calculateInheritedVariables();
+    }
+    return anyDirty;
+}
+
+QT_END_NAMESPACE
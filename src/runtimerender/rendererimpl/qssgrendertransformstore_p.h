@@ -0,0 +1,94 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Quick 3D.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSSG_RENDER_TRANSFORM_STORE_H
+#define QSSG_RENDER_TRANSFORM_STORE_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtQuick3DRuntimeRender/private/qtquick3druntimerenderglobal_p.h>
+
+#include <QtCore/QVector>
+
+QT_BEGIN_NAMESPACE
+
+struct QSSGRenderNode;
+
+// Flat, structure-of-arrays view of the node hierarchy of a layer. Slots are
+// assigned in depth-first order while the scene is walked, so a parent always
+// comes before its children and the world matrices can be updated in a
+// single linear pass instead of recursing up the parent chain for every node.
+//
+// The nodes' own globalTransform stays the authoritative value (renderables
+// keep references to it); the store writes it back for every node it
+// updates and mirrors it for the clean ones.
+class Q_QUICK3DRUNTIMERENDER_EXPORT QSSGRenderTransformStore
+{
+public:
+    struct Matrix
+    {
+        float m[16]; // column-major, same layout as QMatrix4x4::data()
+    };
+
+    void clear();
+    // Appends a node, parentSlot is -1 for direct children of the layer.
+    qint32 add(QSSGRenderNode *node, qint32 parentSlot);
+
+    // Recalculates the world matrices of all the dirty nodes and clears their
+    // Dirty flag. Returns true if any node was dirty.
+    bool update();
+
+    qsizetype size() const { return m_nodes.size(); }
+    QSSGRenderNode *node(qint32 slot) const { return m_nodes.at(slot); }
+    qint32 parentSlot(qint32 slot) const { return m_parents.at(slot); }
+    const Matrix &worldTransform(qint32 slot) const { return m_world.at(slot); }
+    // Whether the node was dirty in the last update().
+    bool wasDirty(qint32 slot) const { return m_dirty.at(slot) != 0; }
+
+    static void multiply(const float *a, const float *b, float *out);
+
+private:
+    QVector<QSSGRenderNode *> m_nodes;
+    QVector<qint32> m_parents;
+    QVector<Matrix> m_world;
+    QVector<quint8> m_dirty;
+};
+
+QT_END_NAMESPACE
+
+#endif // QSSG_RENDER_TRANSFORM_STORE_H
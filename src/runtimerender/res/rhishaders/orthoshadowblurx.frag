@@ -7,6 +7,7 @@ layout(location = 0) out vec4 fragOutput;
 layout(std140, binding = 0) uniform buf {
     mat4 matrix;
     vec2 cameraProperties;
+    vec4 uvRect; // the part of the texture to blur, as (u, v, width, height)
 } ubuf;
 
 layout(binding = 1) uniform sampler2D depthSrc;
@@ -14,11 +15,16 @@ layout(binding = 1) uniform sampler2D depthSrc;
 void main()
 {
     vec2 ofsScale = vec2(ubuf.cameraProperties.x / 7680.0, 0.0);
-    float depth0 = texture(depthSrc, uv_coords).x;
-    float depth1 = texture(depthSrc, uv_coords + ofsScale).x;
-    depth1 += texture(depthSrc, uv_coords - ofsScale).x;
-    float depth2 = texture(depthSrc, uv_coords + 2.0 * ofsScale).x;
-    depth2 += texture(depthSrc, uv_coords - 2.0 * ofsScale).x;
+    // keep the taps inside the tile so that the neighbouring tiles of the
+    // atlas do not bleed in
+    vec2 halfTexel = 0.5 / vec2(textureSize(depthSrc, 0));
+    vec2 uvMin = ubuf.uvRect.xy + halfTexel;
+    vec2 uvMax = ubuf.uvRect.xy + ubuf.uvRect.zw - halfTexel;
+    float depth0 = texture(depthSrc, clamp(uv_coords, uvMin, uvMax)).x;
+    float depth1 = texture(depthSrc, clamp(uv_coords + ofsScale, uvMin, uvMax)).x;
+    depth1 += texture(depthSrc, clamp(uv_coords - ofsScale, uvMin, uvMax)).x;
+    float depth2 = texture(depthSrc, clamp(uv_coords + 2.0 * ofsScale, uvMin, uvMax)).x;
+    depth2 += texture(depthSrc, clamp(uv_coords - 2.0 * ofsScale, uvMin, uvMax)).x;
     float outDepth = 0.38774 * depth0 + 0.24477 * depth1 + 0.06136 * depth2;
     fragOutput = vec4(outDepth);
 }
@@ -8,6 +8,7 @@ layout(location = 0) out vec2 uv_coords;
 layout(std140, binding = 0) uniform buf {
     mat4 matrix;
     vec2 cameraProperties;
+    vec4 uvRect; // the part of the texture to blur, as (u, v, width, height)
 } ubuf;
 
 out gl_PerVertex { vec4 gl_Position; };
@@ -15,5 +16,5 @@ out gl_PerVertex { vec4 gl_Position; };
 void main()
 {
     gl_Position = ubuf.matrix * vec4(attr_pos, 1.0);
-    uv_coords.xy = attr_uv.xy;
+    uv_coords.xy = ubuf.uvRect.xy + attr_uv.xy * ubuf.uvRect.zw;
 }
@@ -39,6 +39,7 @@
 #include <QtQuick/QSGTexture>
 
 #include <QtCore/QDir>
+#include <QtCore/QThreadPool>
 #include <QtGui/private/qimage_p.h>
 #include <QtQuick/private/qsgtexture_p.h>
 #include <QtQuick/private/qsgcompressedtexture_p.h>
@@ -50,6 +51,8 @@
 #include <QtQuick3DRuntimeRender/private/qssgrendertexturedata_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrendercontextcore_p.h>
 
+#include <algorithm>
+
 QT_BEGIN_NAMESPACE
 
 //#define QSSG_RENDERBUFFER_DEBUGGING
@@ -111,6 +114,138 @@ static constexpr QSize sizeForMipLevel(int mipLevel, const QSize &baseLevelSize)
     return QSize(qMax(1, baseLevelSize.width() >> mipLevel), qMax(1, baseLevelSize.height() >> mipLevel));
 }
 
+// Shared between the render thread and the worker decoding the image, in the
+// same manner as MeshBVHBuild.
+struct QSSGBufferManager::ImageLoad
+{
+    QMutex mutex;
+    QSSGLoadedTexture *texture = nullptr;
+    bool hasTransparency = false;
+    bool canceled = false;
+    QAtomicInt finished;
+    // Set when loading an image again that had mip levels dropped
+    quint64 streamInSize = 0;
+};
+
+static bool asyncImageLoadForced()
+{
+    static const bool forced = qEnvironmentVariableIntValue("QT_QUICK3D_ASYNC_TEXTURE_LOADING") != 0;
+    return forced;
+}
+
+static uint64_t textureMemorySize(QRhiTexture *texture)
+{
+    uint64_t s = 0;
+    if (!texture)
+        return s;
+
+    auto format = texture->format();
+    if (format == QRhiTexture::UnknownFormat)
+        return 0;
+
+    s = texture->pixelSize().width() * texture->pixelSize().height();
+    /*
+        UnknownFormat,
+        RGBA8,
+        BGRA8,
+        R8,
+        RG8,
+        R16,
+        RG16,
+        RED_OR_ALPHA8,
+        RGBA16F,
+        RGBA32F,
+        R16F,
+        R32F,
+        RGB10A2,
+        D16,
+        D24,
+        D24S8,
+        D32F,*/
+    static const uint64_t pixelSizes[] = {0, 4, 4, 1, 2, 2, 4, 1, 2, 4, 2, 4, 4, 2, 4, 4, 4};
+    /*
+        BC1,
+        BC2,
+        BC3,
+        BC4,
+        BC5,
+        BC6H,
+        BC7,
+        ETC2_RGB8,
+        ETC2_RGB8A1,
+        ETC2_RGBA8,*/
+    static const uint64_t blockSizes[] = {8, 16, 16, 8, 16, 16, 16, 8, 8, 16};
+    Q_STATIC_ASSERT_X(QRhiTexture::BC1 == 17 && QRhiTexture::ETC2_RGBA8 == 26,
+                      "QRhiTexture format constant value missmatch.");
+    if (format < QRhiTexture::BC1)
+        s *= pixelSizes[format];
+    else if (format >= QRhiTexture::BC1 && format <= QRhiTexture::ETC2_RGBA8)
+        s /= blockSizes[format - QRhiTexture::BC1];
+    else
+        s /= 16;
+
+    if (texture->flags() & QRhiTexture::MipMapped)
+        s += s / 4;
+    if (texture->flags() & QRhiTexture::CubeMap)
+        s *= 6;
+    return s;
+}
+
+static quint64 textureMemoryBudget()
+{
+    static const quint64 budget = quint64(qMax(0, qEnvironmentVariableIntValue("QT_QUICK3D_TEXTURE_MEMORY_BUDGET"))) * 1024 * 1024;
+    return budget;
+}
+
+// Memory used by the texture of an image once the scheduled mip levels are
+// dropped. Placeholders are not owned by the image, they do not count.
+static quint64 residentTextureSize(const QSSGBufferManager::ImageData &imageData)
+{
+    if (imageData.renderImageTexture.m_flags.isLoading())
+        return 0;
+    return textureMemorySize(imageData.renderImageTexture.m_texture) >> (2 * imageData.mipLevelsToDrop);
+}
+
+static quint64 requestedTextureSize(const QSSGBufferManager::ImageData &imageData)
+{
+    if (imageData.renderImageTexture.m_flags.isLoading())
+        return 0;
+    return textureMemorySize(imageData.renderImageTexture.m_texture) << (2 * imageData.droppedMipLevels);
+}
+
+static constexpr int MinReducedTextureSize = 64;
+
+static bool canDropMipLevel(const QSSGBufferManager::ImageCacheKey &key, const QSSGBufferManager::ImageData &imageData)
+{
+    // Light probes need all their prefiltered levels. Cube maps and
+    // compressed textures are not reduced either.
+    QRhiTexture *texture = imageData.renderImageTexture.m_texture;
+    if (!texture || imageData.pendingLoad
+            || key.mipMode == QSSGBufferManager::MipModeBsdf
+            || key.type == int(QSSGRenderGraphObject::Type::ImageCube)
+            || texture->format() >= QRhiTexture::BC1)
+        return false;
+    const int levels = imageData.mipLevelsToDrop + 1;
+    if (imageData.renderImageTexture.m_mipmapCount <= levels)
+        return false;
+    const QSize size = texture->pixelSize();
+    return (qMin(size.width(), size.height()) >> levels) >= MinReducedTextureSize;
+}
+
+static bool hasTransparentPixels(const QSSGLoadedTexture *inTexture)
+{
+    if (inTexture->textureFileData.isValid()) {
+        const QTextureFileData &tex = inTexture->textureFileData;
+        const auto glFormat = tex.glInternalFormat() ? tex.glInternalFormat() : tex.glFormat();
+        return !QSGCompressedTexture::formatIsOpaque(glFormat);
+    }
+    if (!inTexture->image.isNull())
+        return QImageData::get(inTexture->image)->checkForAlphaPixels();
+    if (inTexture->data)
+        return inTexture->scanForTransparency();
+    return false;
+}
+
 QSSGBufferManager::QSSGBufferManager()
 {
 }
@@ -185,6 +320,27 @@ QSSGRenderImageTexture QSSGBufferManager::loadRenderImage(const QSSGRenderImage
         const ImageCacheKey imageKey = { image->m_imagePath, inMipMode, int(image->type) };
         auto foundIt = imageMap.find(imageKey);
         if (foundIt != imageMap.cend()) {
+            ImageData &imageData = foundIt.value();
+            if (imageData.pendingLoad)
+                finishImageLoad(imageKey, imageData);
+            else if (imageData.mipLevelsToDrop > 0)
+                dropMipLevels(imageData);
+            else if (imageData.droppedMipLevels > 0 && canStreamIn(imageData, textureMemoryBudget()))
+                startImageLoad(imageData, image, flags.testFlag(LoadWithFlippedY));
+            result = imageData.renderImageTexture;
+        } else if ((image->m_asyncLoad || asyncImageLoadForced())
+                   && inMipMode != MipModeBsdf
+                   && image->type != QSSGRenderGraphObject::Type::ImageCube) {
+            // Sampling a placeholder keeps the material's shader the same
+            // once the real texture is there.
+            foundIt = imageMap.insert(imageKey, ImageData());
+            QSSGRenderImageTexture &placeholder = foundIt.value().renderImageTexture;
+            QRhiResourceUpdateBatch *rub = context->rhi()->nextResourceUpdateBatch();
+            placeholder.m_texture = context->dummyTexture({}, rub, QSize(1, 1), Qt::white);
+            context->commandBuffer()->resourceUpdate(rub);
+            placeholder.m_mipmapCount = 1;
+            placeholder.m_flags.setLoading(true);
+            startImageLoad(foundIt.value(), image, flags.testFlag(LoadWithFlippedY));
             result = foundIt.value().renderImageTexture;
         } else {
             QScopedPointer<QSSGLoadedTexture> theLoadedTexture;
@@ -214,11 +370,214 @@ QSSGRenderImageTexture QSSGBufferManager::loadRenderImage(const QSSGRenderImage
             }
         }
         foundIt.value().usageCounts[currentLayer]++;
+        foundIt.value().lastUsedFrame = frameResetIndex;
     }
     Q_QUICK3D_PROFILE_END_WITH_PAYLOAD(QQuick3DProfiler::Quick3DTextureLoad, stats.imageDataSize);
     return result;
 }
 
+void QSSGBufferManager::startImageLoad(ImageData &imageData, const QSSGRenderImage *image, bool flipY)
+{
+    const auto load = std::make_shared<ImageLoad>();
+    imageData.pendingLoad = load;
+    ++textureLoadStats.pendingCount;
+    if (imageData.droppedMipLevels > 0) {
+        load->streamInSize = requestedTextureSize(imageData) - residentTextureSize(imageData);
+        textureStreamInSize += load->streamInSize;
+    }
+
+    // The image must not be accessed from the worker thread.
+    const QString path = image->m_imagePath.path();
+    const QSSGRenderTextureFormat format = image->m_format;
+    QThreadPool::globalInstance()->start([load, path, format, flipY]() {
+        QSSGLoadedTexture *texture = QSSGLoadedTexture::load(path, format, flipY);
+        const bool hasTransparency = texture && hasTransparentPixels(texture);
+        QMutexLocker loadLocker(&load->mutex);
+        if (load->canceled) {
+            delete texture;
+        } else {
+            load->texture = texture;
+            load->hasTransparency = hasTransparency;
+        }
+        load->finished.storeRelease(1);
+    });
+}
+
+void QSSGBufferManager::finishImageLoad(const ImageCacheKey &key, ImageData &imageData)
+{
+    const std::shared_ptr<ImageLoad> load = imageData.pendingLoad;
+    if (!load->finished.loadAcquire())
+        return;
+
+    imageData.pendingLoad.reset();
+    --textureLoadStats.pendingCount;
+    textureStreamInSize -= load->streamInSize;
+
+    // An image loaded again in full keeps using its reduced texture until
+    // the new one is there. The placeholder is owned by the QSSGRhiContext,
+    // no need to release it.
+    QRhiTexture *previousTexture = nullptr;
+    if (imageData.renderImageTexture.m_flags.isLoading())
+        imageData.renderImageTexture = QSSGRenderImageTexture();
+    else
+        previousTexture = imageData.renderImageTexture.m_texture;
+    const quint64 previousSize = residentTextureSize(imageData);
+    // Do not try again when loading the full image fails
+    imageData.droppedMipLevels = 0;
+
+    QScopedPointer<QSSGLoadedTexture> theLoadedTexture;
+    bool hasTransparency = false;
+    {
+        QMutexLocker loadLocker(&load->mutex);
+        theLoadedTexture.reset(std::exchange(load->texture, nullptr));
+        hasTransparency = load->hasTransparency;
+    }
+    if (!theLoadedTexture) {
+        qCWarning(WARNING, "Failed to load image: %s", qPrintable(key.path.path()));
+        return;
+    }
+
+    // The transparency scan was done on the worker already
+    QSSGRenderImageTexture texture;
+    if (createRhiTexture(texture, theLoadedTexture.data(), MipMode(key.mipMode))) {
+        texture.m_flags.setHasTransparency(hasTransparency);
+        if (previousTexture) {
+            Q_QUICK3D_PROFILE_IF_ENABLED(QQuick3DProfiler::Quick3DTextureLoad, decreaseMemoryStat(previousTexture));
+            m_contextInterface->rhiContext()->releaseTexture(previousTexture);
+        }
+        imageData.renderImageTexture = texture;
+        imageData.mipLevelsToDrop = 0;
+        textureResidentSize = textureResidentSize - previousSize + residentTextureSize(imageData);
+        ++textureLoadStats.finishedCount;
+#ifdef QSSG_RENDERBUFFER_DEBUGGING
+        qDebug() << "+ uploadTexture: " << key.path.path() << currentLayer;
+#endif
+        Q_QUICK3D_PROFILE_IF_ENABLED(QQuick3DProfiler::Quick3DTextureLoad,
+                                     increaseMemoryStat(imageData.renderImageTexture.m_texture));
+    }
+}
+
+void QSSGBufferManager::cancelImageLoad(const std::shared_ptr<ImageLoad> &load)
+{
+    {
+        // The worker may still be running, it deletes its result itself then
+        QMutexLocker loadLocker(&load->mutex);
+        load->canceled = true;
+        delete std::exchange(load->texture, nullptr);
+    }
+    --textureLoadStats.pendingCount;
+    textureStreamInSize -= load->streamInSize;
+}
+
+bool QSSGBufferManager::canStreamIn(const ImageData &imageData, quint64 budget) const
+{
+    // Only when the full texture fits next to the other textures in use,
+    // otherwise it would be reduced again right away.
+    const quint64 streamInSize = requestedTextureSize(imageData) - residentTextureSize(imageData);
+    return textureResidentSize + textureStreamInSize + streamInSize <= budget;
+}
+
+void QSSGBufferManager::dropMipLevels(ImageData &imageData)
+{
+    QSSGRenderImageTexture &texture = imageData.renderImageTexture;
+    const int levels = qMin(std::exchange(imageData.mipLevelsToDrop, 0), texture.m_mipmapCount - 1);
+    if (levels <= 0)
+        return;
+
+    // The remaining levels are copied on the GPU, the image does not need
+    // to be loaded again.
+    auto context = m_contextInterface->rhiContext();
+    QRhi *rhi = context->rhi();
+    QRhiTexture *oldTexture = texture.m_texture;
+    const QSize size = sizeForMipLevel(levels, oldTexture->pixelSize());
+    const int mipmapCount = texture.m_mipmapCount - levels;
+    QRhiTexture::Flags textureFlags = oldTexture->flags();
+    textureFlags.setFlag(QRhiTexture::MipMapped, mipmapCount > 1);
+    QRhiTexture *newTexture = rhi->newTexture(oldTexture->format(), size, 1, textureFlags);
+    if (!newTexture->create()) {
+        delete newTexture;
+        return;
+    }
+
+    QRhiResourceUpdateBatch *rub = rhi->nextResourceUpdateBatch();
+    for (int level = 0; level < mipmapCount; ++level) {
+        QRhiTextureCopyDescription copyDescription;
+        copyDescription.setSourceLevel(level + levels);
+        copyDescription.setDestinationLevel(level);
+        copyDescription.setPixelSize(sizeForMipLevel(level, size));
+        rub->copyTexture(newTexture, oldTexture, copyDescription);
+    }
+    context->commandBuffer()->resourceUpdate(rub);
+
+    // QRhi defers releasing the native resource until the frame is done
+    Q_QUICK3D_PROFILE_IF_ENABLED(QQuick3DProfiler::Quick3DTextureLoad, decreaseMemoryStat(oldTexture));
+    context->releaseTexture(oldTexture);
+    context->registerTexture(newTexture);
+    Q_QUICK3D_PROFILE_IF_ENABLED(QQuick3DProfiler::Quick3DTextureLoad, increaseMemoryStat(newTexture));
+
+    texture.m_texture = newTexture;
+    texture.m_mipmapCount = mipmapCount;
+    imageData.droppedMipLevels += levels;
+}
+
+void QSSGBufferManager::enforceTextureBudget(quint64 budget)
+{
+    quint64 usedSize = 0;
+    quint64 unusedSize = 0;
+    QVector<QPair<quint32, ImageCacheKey>> unusedImages;
+    for (auto it = imageMap.cbegin(), end = imageMap.cend(); it != end; ++it) {
+        const quint64 size = residentTextureSize(it.value());
+        if (it.value().lastUsedFrame == frameResetIndex) {
+            usedSize += size;
+        } else if (size > 0) {
+            unusedSize += size;
+            unusedImages.append({ it.value().lastUsedFrame, it.key() });
+        }
+    }
+
+    // Textures not used in this frame go first, least recently used first
+    if (usedSize + unusedSize > budget) {
+        std::sort(unusedImages.begin(), unusedImages.end(), [](const auto &a, const auto &b) {
+            return a.first < b.first;
+        });
+        for (const auto &unusedImage : qAsConst(unusedImages)) {
+            if (usedSize + unusedSize <= budget)
+                break;
+            unusedSize -= residentTextureSize(imageMap.value(unusedImage.second));
+            releaseImage(unusedImage.second);
+        }
+    }
+
+    // Then the highest mip level of the largest texture in use, until it fits
+    while (usedSize > budget) {
+        ImageData *largest = nullptr;
+        quint64 largestSize = 0;
+        for (auto it = imageMap.begin(), end = imageMap.end(); it != end; ++it) {
+            if (it.value().lastUsedFrame != frameResetIndex || !canDropMipLevel(it.key(), it.value()))
+                continue;
+            const quint64 size = residentTextureSize(it.value());
+            if (size > largestSize) {
+                largest = &it.value();
+                largestSize = size;
+            }
+        }
+        if (!largest) {
+            // Only textures with mip levels can be reduced, the budget stays
+            // exceeded when the rest does not fit.
+            if (!std::exchange(textureBudgetExceededWarned, true)) {
+                qCWarning(WARNING, "Textures in use exceed the texture memory budget by %llu bytes, "
+                                   "only mipmapped textures can be reduced",
+                          usedSize - budget);
+            }
+            break;
+        }
+        ++largest->mipLevelsToDrop;
+        usedSize -= largestSize - residentTextureSize(*largest);
+    }
+
+    textureResidentSize = usedSize;
+}
+
 QSSGRenderImageTexture QSSGBufferManager::loadTextureData(QSSGRenderTextureData *data, MipMode inMipMode)
 {
     auto theImageData = customTextureMap.find(data);
@@ -629,7 +988,7 @@ bool QSSGBufferManager::createEnvironmentMap(const QSSGLoadedTexture *inImage, Q
 
     for (int face = 0; face < 6; ++face) {
         cb->beginPass(renderTargets[face], QColor(0, 0, 0, 1), { 1.0f, 0 }, nullptr, QSSGRhiContext::commonPassFlags());
-        QSSGRHICTX_STAT(context, beginRenderPass(renderTargets[face]));
+        context->stats().beginRenderPass(renderTargets[face]);
 
         // Execute render pass
         cb->setGraphicsPipeline(envMapPipeline);
@@ -640,11 +999,13 @@ bool QSSGBufferManager::createEnvironmentMap(const QSSGLoadedTexture *inImage, Q
             { 2, quint32(ubufEnvMapElementSize * face )}
         };
         cb->setShaderResources(envMapSrb, 2, dynamicOffset.constData());
+        context->stats().setGraphicsPipeline(envMapPipeline);
+        context->stats().setShaderResources(envMapSrb);
 
         cb->draw(36);
         QSSGRHICTX_STAT(context, draw(36, 1));
         cb->endPass();
-        QSSGRHICTX_STAT(context, endRenderPass());
+        context->stats().endRenderPass();
     }
     cb->debugMarkEnd();
 
@@ -784,7 +1145,7 @@ bool QSSGBufferManager::createEnvironmentMap(const QSSGLoadedTexture *inImage, Q
     for (int mipLevel = 0; mipLevel < mipmapCount; ++mipLevel) {
         for (int face = 0; face < 6; ++face) {
             cb->beginPass(renderTargetsMap[mipLevel][face], QColor(0, 0, 0, 1), { 1.0f, 0 }, nullptr, QSSGRhiContext::commonPassFlags());
-            QSSGRHICTX_STAT(context, beginRenderPass(renderTargetsMap[mipLevel][face]));
+            context->stats().beginRenderPass(renderTargetsMap[mipLevel][face]);
             cb->setGraphicsPipeline(prefilterPipeline);
             cb->setVertexInput(0, 1, &vbufBinding);
             cb->setViewport(QRhiViewport(0, 0, mipLevelSizes[mipLevel].width(), mipLevelSizes[mipLevel].height()));
@@ -793,10 +1154,12 @@ bool QSSGBufferManager::createEnvironmentMap(const QSSGLoadedTexture *inImage, Q
                 { 2, quint32(ubufPrefilterElementSize * mipLevel) }
             };
             cb->setShaderResources(preFilterSrb, 2, dynamicOffsets.constData());
+            context->stats().setGraphicsPipeline(prefilterPipeline);
+            context->stats().setShaderResources(preFilterSrb);
             cb->draw(36);
             QSSGRHICTX_STAT(context, draw(36, 1));
             cb->endPass();
-            QSSGRHICTX_STAT(context, endRenderPass());
+            context->stats().endRenderPass();
         }
     }
     cb->debugMarkEnd();
@@ -815,8 +1178,6 @@ bool QSSGBufferManager::createRhiTexture(QSSGRenderImageTexture &texture,
     int textureSampleCount = 1;
     QRhiTexture::Flags textureFlags;
     int mipmapCount = 1;
-    const bool checkTransp = inFlags.testFlag(ScanForTransparency);
-    bool hasTransp = false;
 
     auto context = m_contextInterface->rhiContext();
     auto *rhi = context->rhi();
@@ -885,26 +1246,17 @@ bool QSSGBufferManager::createRhiTexture(QSSGRenderImageTexture &texture,
         }
 
         rhiFormat = toRhiFormat(inTexture->format.format);
-        if (checkTransp) {
-            auto glFormat = tex.glInternalFormat() ? tex.glInternalFormat() : tex.glFormat();
-            hasTransp = !QSGCompressedTexture::formatIsOpaque(glFormat);
-        }
     } else {
         QRhiTextureSubresourceUploadDescription subDesc;
         if (!inTexture->image.isNull()) {
             rhiFormat = toRhiFormat(inTexture->format.format);
             size = inTexture->image.size();
             subDesc.setImage(inTexture->image);
-            if (checkTransp)
-                hasTransp = QImageData::get(inTexture->image)->checkForAlphaPixels();
         } else if (inTexture->data) {
             rhiFormat = toRhiFormat(inTexture->format.format);
             size = QSize(inTexture->width, inTexture->height);
             QByteArray buf(static_cast<const char *>(inTexture->data), qMax(0, int(inTexture->dataSizeInBytes)));
             subDesc.setData(buf);
-            if (checkTransp)
-                hasTransp = inTexture->scanForTransparency();
-
         }
         subDesc.setSourceSize(size);
         if (!subDesc.data().isEmpty() || !subDesc.image().isNull())
@@ -935,8 +1287,8 @@ bool QSSGBufferManager::createRhiTexture(QSSGRenderImageTexture &texture,
     auto *tex = rhi->newTexture(rhiFormat, size, textureSampleCount, textureFlags);
     tex->create();
 
-    if (checkTransp)
-        texture.m_flags.setHasTransparency(hasTransp);
+    if (inFlags.testFlag(ScanForTransparency))
+        texture.m_flags.setHasTransparency(hasTransparentPixels(inTexture));
     texture.m_texture = tex;
 
     QRhiTextureUploadDescription uploadDescription;
@@ -977,7 +1329,7 @@ QSSGMesh::Mesh QSSGBufferManager::loadPrimitive(const QString &inRelativePath)
     const quint32 id = 1;
     QSharedPointer<QIODevice> device(QSSGInputUtil::getStreamForFile(path));
     if (device) {
-        QSSGMesh::Mesh mesh = QSSGMesh::Mesh::loadMesh(device.data(), id);
+        QSSGMesh::Mesh mesh = QSSGMesh::Mesh::loadMeshMapped(device, id);
         if (mesh.isValid())
             return mesh;
     }
@@ -1029,7 +1381,7 @@ QSSGBounds3 QSSGBufferManager::getModelBounds(const QSSGRenderModel *model) cons
     return retval;
 }
 
-QSSGRenderMesh *QSSGBufferManager::createRenderMesh(const QSSGMesh::Mesh &mesh)
+QSSGRenderMesh *QSSGBufferManager::createRenderMesh(const QSSGMesh::Mesh &mesh, QRhiBuffer::Type bufferType)
 {
     QSSGRenderMesh *newMesh = new QSSGRenderMesh(QSSGRenderDrawMode(mesh.drawMode()),
                                                  QSSGRenderWinding(mesh.winding()));
@@ -1063,20 +1415,26 @@ QSSGRenderMesh *QSSGBufferManager::createRenderMesh(const QSSGMesh::Mesh &mesh)
     QRhiResourceUpdateBatch *rub = meshBufferUpdateBatch();
     auto context = m_contextInterface->rhiContext();
     rhi.vertexBuffer = new QSSGRhiBuffer(*context.data(),
-                                         QRhiBuffer::Static,
+                                         bufferType,
                                          QRhiBuffer::VertexBuffer,
                                          vertexBuffer.stride,
                                          vertexBuffer.data.size());
-    rub->uploadStaticBuffer(rhi.vertexBuffer->buffer(), vertexBuffer.data);
+    if (bufferType == QRhiBuffer::Dynamic)
+        rub->updateDynamicBuffer(rhi.vertexBuffer->buffer(), 0, vertexBuffer.data.size(), vertexBuffer.data.constData());
+    else
+        rub->uploadStaticBuffer(rhi.vertexBuffer->buffer(), vertexBuffer.data);
 
     if (!indexBuffer.data.isEmpty()) {
         rhi.indexBuffer = new QSSGRhiBuffer(*context.data(),
-                                            QRhiBuffer::Static,
+                                            bufferType,
                                             QRhiBuffer::IndexBuffer,
                                             0,
                                             indexBuffer.data.size(),
                                             rhiIndexFormat);
-        rub->uploadStaticBuffer(rhi.indexBuffer->buffer(), indexBuffer.data);
+        if (bufferType == QRhiBuffer::Dynamic)
+            rub->updateDynamicBuffer(rhi.indexBuffer->buffer(), 0, indexBuffer.data.size(), indexBuffer.data.constData());
+        else
+            rub->uploadStaticBuffer(rhi.indexBuffer->buffer(), indexBuffer.data);
     }
     QVector<QSSGRenderVertexBufferEntry> entryBuffer;
     entryBuffer.resize(vertexBuffer.entries.size());
@@ -1218,6 +1576,7 @@ void QSSGBufferManager::releaseGeometry(QSSGRenderGeometry *geometry)
 #endif
         Q_QUICK3D_PROFILE_START(QQuick3DProfiler::Quick3DCustomMeshLoad);
         Q_QUICK3D_PROFILE_IF_ENABLED(QQuick3DProfiler::Quick3DCustomMeshLoad, decreaseMemoryStat(meshItr.value().mesh));
+        cancelMeshBVHBuild(meshItr.value().mesh);
         delete meshItr.value().mesh;
         customMeshMap.erase(meshItr);
         Q_QUICK3D_PROFILE_END_WITH_PAYLOAD(QQuick3DProfiler::Quick3DCustomMeshLoad,
@@ -1255,6 +1614,7 @@ void QSSGBufferManager::releaseMesh(const QSSGRenderPath &inSourcePath)
 #endif
         Q_QUICK3D_PROFILE_START(QQuick3DProfiler::Quick3DMeshLoad);
         Q_QUICK3D_PROFILE_IF_ENABLED(QQuick3DProfiler::Quick3DMeshLoad, decreaseMemoryStat(meshItr.value().mesh));
+        cancelMeshBVHBuild(meshItr.value().mesh);
         delete meshItr.value().mesh;
         meshMap.erase(meshItr);
         Q_QUICK3D_PROFILE_END_WITH_PAYLOAD(QQuick3DProfiler::Quick3DMeshLoad,
@@ -1266,8 +1626,13 @@ void QSSGBufferManager::releaseImage(const ImageCacheKey &key)
 {
     const auto imageItr = imageMap.constFind(key);
     if (imageItr != imageMap.cend()) {
-        auto rhiTexture = imageItr.value().renderImageTexture.m_texture;
-        if (rhiTexture) {
+        const QSSGRenderImageTexture &texture = imageItr.value().renderImageTexture;
+        auto rhiTexture = texture.m_texture;
+        if (imageItr.value().pendingLoad)
+            cancelImageLoad(imageItr.value().pendingLoad);
+        // The placeholder is not ours to release, while a reduced texture that
+        // is being loaded again in full is.
+        if (rhiTexture && !texture.m_flags.isLoading()) {
 #ifdef QSSG_RENDERBUFFER_DEBUGGING
             qDebug() << "- releaseTexture: " << key.path.path() << currentLayer;
 #endif
@@ -1307,6 +1672,7 @@ void QSSGBufferManager::cleanupUnreferencedBuffers(quint32 frameId, QSSGRenderLa
 #ifdef QSSG_RENDERBUFFER_DEBUGGING
                 qDebug() << "- releaseGeometry: " << meshIterator.key().path() << currentLayer;
 #endif
+                cancelMeshBVHBuild(meshIterator.value().mesh);
                 delete meshIterator.value().mesh;
                 meshIterator = meshMap.erase(meshIterator);
             } else {
@@ -1321,6 +1687,7 @@ void QSSGBufferManager::cleanupUnreferencedBuffers(quint32 frameId, QSSGRenderLa
 #ifdef QSSG_RENDERBUFFER_DEBUGGING
                 qDebug() << "- releaseGeometry: " << customMeshIterator.key() << currentLayer;
 #endif
+                cancelMeshBVHBuild(customMeshIterator.value().mesh);
                 delete customMeshIterator.value().mesh;
                 customMeshIterator = customMeshMap.erase(customMeshIterator);
             } else {
@@ -1342,12 +1709,17 @@ void QSSGBufferManager::cleanupUnreferencedBuffers(quint32 frameId, QSSGRenderLa
         }
     }
 
-    // Images
+    // Images, kept around while within the budget if there is one
+    const quint64 textureBudget = textureMemoryBudget();
     auto imageKeyIterator = imageMap.cbegin();
     while (imageKeyIterator != imageMap.cend()) {
-        if (isUnused(imageKeyIterator.value().usageCounts)) {
-            auto rhiTexture = imageKeyIterator.value().renderImageTexture.m_texture;
-            if (rhiTexture) {
+        if (isUnused(imageKeyIterator.value().usageCounts)
+                && (!textureBudget || imageKeyIterator.value().pendingLoad)) {
+            const QSSGRenderImageTexture &texture = imageKeyIterator.value().renderImageTexture;
+            auto rhiTexture = texture.m_texture;
+            if (imageKeyIterator.value().pendingLoad)
+                cancelImageLoad(imageKeyIterator.value().pendingLoad);
+            if (rhiTexture && !texture.m_flags.isLoading()) {
 #ifdef QSSG_RENDERBUFFER_DEBUGGING
                 qDebug() << "- releaseTexture: " << imageKeyIterator.key().path.path() << currentLayer;
 #endif
@@ -1358,6 +1730,8 @@ void QSSGBufferManager::cleanupUnreferencedBuffers(quint32 frameId, QSSGRenderLa
             ++imageKeyIterator;
         }
     }
+    if (textureBudget)
+        enforceTextureBudget(textureBudget);
 
     // Custom Texture Data
     auto textureDataIterator = customTextureMap.cbegin();
@@ -1471,6 +1845,13 @@ QSSGRenderMesh *QSSGBufferManager::loadCustomMesh(QSSGRenderGeometry *geometry)
     if (meshIterator == customMeshMap.end()) {
         meshIterator = customMeshMap.insert(geometry, MeshData());
     } else if (geometry->generationId() != meshIterator->generationId) {
+        if (meshIterator->mesh && meshIterator->generationId >= geometry->dirtyRangesBaseGenerationId()) {
+            // Only parts of the data changed, the buffers can be kept
+            updateCustomMesh(meshIterator->mesh, geometry, meshIterator->generationId);
+            meshIterator->generationId = geometry->generationId();
+            meshIterator.value().usageCounts[currentLayer]++;
+            return meshIterator.value().mesh;
+        }
         // Release old data
         releaseGeometry(geometry);
         meshIterator = customMeshMap.insert(geometry, MeshData());
@@ -1490,7 +1871,8 @@ QSSGRenderMesh *QSSGBufferManager::loadCustomMesh(QSSGRenderGeometry *geometry)
     #ifdef QSSG_RENDERBUFFER_DEBUGGING
             qDebug() << "+ uploadGeometry: " << geometry << currentLayer;
     #endif
-            meshIterator->mesh = createRenderMesh(mesh);
+            meshIterator->mesh = createRenderMesh(mesh, geometry->isDynamic() ? QRhiBuffer::Dynamic
+                                                                              : QRhiBuffer::Static);
             meshIterator->usageCounts[currentLayer] = 1;
             meshIterator->generationId = geometry->generationId();
             Q_QUICK3D_PROFILE_IF_ENABLED(QQuick3DProfiler::Quick3DCustomMeshLoad, increaseMemoryStat(meshIterator->mesh));
@@ -1505,6 +1887,52 @@ QSSGRenderMesh *QSSGBufferManager::loadCustomMesh(QSSGRenderGeometry *geometry)
     return meshIterator->mesh;
 }
 
+void QSSGBufferManager::updateCustomMesh(QSSGRenderMesh *mesh, const QSSGRenderGeometry *geometry, uint32_t fromGenerationId)
+{
+    if (mesh->subsets.isEmpty())
+        return;
+
+    // All subsets share the same buffers
+    const QSSGRenderSubset &firstSubset(mesh->subsets.first());
+    QRhiBuffer *vertexBuffer = firstSubset.rhi.vertexBuffer ? firstSubset.rhi.vertexBuffer->buffer() : nullptr;
+    QRhiBuffer *indexBuffer = firstSubset.rhi.indexBuffer ? firstSubset.rhi.indexBuffer->buffer() : nullptr;
+    const QSSGMesh::RuntimeMeshData &meshData = geometry->meshData();
+    bool dataChanged = false;
+    QRhiResourceUpdateBatch *rub = nullptr;
+    for (const QSSGRenderGeometry::DirtyRange &range : geometry->dirtyRanges()) {
+        if (range.generationId <= fromGenerationId || range.size == 0)
+            continue;
+        QRhiBuffer *buffer = range.indexData ? indexBuffer : vertexBuffer;
+        const QByteArray &data = range.indexData ? meshData.m_indexBuffer : meshData.m_vertexBuffer;
+        if (!buffer || range.offset + range.size > quint32(buffer->size()) || range.offset + range.size > quint32(data.size()))
+            continue;
+        if (!rub)
+            rub = meshBufferUpdateBatch();
+        dataChanged = true;
+        if (buffer->type() == QRhiBuffer::Dynamic)
+            rub->updateDynamicBuffer(buffer, range.offset, range.size, data.constData() + range.offset);
+        else
+            rub->uploadStaticBuffer(buffer, range.offset, range.size, data.constData() + range.offset);
+    }
+
+    // Picking may be looking at the subsets from another thread
+    QMutexLocker meshMutexLocker(&meshBufferMutex);
+
+    // The subsets themselves are unchanged, apart from maybe their bounds
+    for (int i = 0, count = qMin(mesh->subsets.count(), meshData.m_subsets.count()); i < count; ++i) {
+        const QSSGMesh::Mesh::SubsetBounds &bounds = meshData.m_subsets.at(i).bounds;
+        mesh->subsets[i].bounds = QSSGBounds3(bounds.min, bounds.max);
+    }
+    if (!dataChanged)
+        return;
+
+    // The picking data is out of date, it is rebuilt when needed
+    cancelMeshBVHBuild(mesh);
+    mesh->bvh.reset();
+    for (QSSGRenderSubset &subset : mesh->subsets)
+        subset.bvhRoot = nullptr;
+}
+
 QSSGMeshBVH *QSSGBufferManager::loadMeshBVH(const QSSGRenderPath &inSourcePath)
 {
     const QSSGMesh::Mesh mesh = loadMeshData(inSourcePath);
@@ -1513,10 +1941,11 @@ QSSGMeshBVH *QSSGBufferManager::loadMeshBVH(const QSSGRenderPath &inSourcePath)
         return nullptr;
     }
     QSSGMeshBVHBuilder meshBVHBuilder(mesh);
+    meshBVHBuilder.setThreadPool(QThreadPool::globalInstance());
     return meshBVHBuilder.buildTree();
 }
 
-QSSGMeshBVH *QSSGBufferManager::loadMeshBVH(QSSGRenderGeometry *geometry)
+static QSSGMeshBVHBuilder *createMeshBVHBuilder(const QSSGRenderGeometry *geometry)
 {
     if (!geometry)
         return nullptr;
@@ -1551,15 +1980,135 @@ QSSGMeshBVH *QSSGBufferManager::loadMeshBVH(QSSGRenderGeometry *geometry)
         }
     }
 
-    QSSGMeshBVHBuilder meshBVHBuilder(geometry->vertexBuffer(),
-                                      geometry->stride(),
-                                      posOffset,
-                                      hasUV,
-                                      uvOffset,
-                                      hasIndexBuffer,
-                                      geometry->indexBuffer(),
-                                      indexBufferFormat);
-    return meshBVHBuilder.buildTree();
+    // The builder keeps its own references to the (implicitly shared) data,
+    // so it stays valid when the geometry changes later on.
+    return new QSSGMeshBVHBuilder(geometry->vertexBuffer(),
+                                  geometry->stride(),
+                                  posOffset,
+                                  hasUV,
+                                  uvOffset,
+                                  hasIndexBuffer,
+                                  geometry->indexBuffer(),
+                                  indexBufferFormat);
+}
+
+QSSGMeshBVH *QSSGBufferManager::loadMeshBVH(QSSGRenderGeometry *geometry)
+{
+    const std::unique_ptr<QSSGMeshBVHBuilder> meshBVHBuilder(createMeshBVHBuilder(geometry));
+    if (!meshBVHBuilder)
+        return nullptr;
+    meshBVHBuilder->setThreadPool(QThreadPool::globalInstance());
+    return meshBVHBuilder->buildTree();
+}
+
+static bool asyncMeshBVHBuildEnabled()
+{
+    static const bool enabled = qEnvironmentVariableIntValue("QT_QUICK3D_SYNCHRONOUS_BVH_BUILD") == 0;
+    return enabled;
+}
+
+static void attachMeshBVH(QSSGRenderMesh *mesh, QSSGMeshBVH *bvh)
+{
+    mesh->bvh.reset(bvh);
+    for (int i = 0; i < bvh->roots.count(); ++i)
+        mesh->subsets[i].bvhRoot = bvh->root(i);
+}
+
+bool QSSGBufferManager::prepareMeshBVH(const QSSGRenderModel &model, QSSGRenderMesh *mesh)
+{
+    if (mesh->bvh)
+        return true;
+
+    if (!asyncMeshBVHBuildEnabled()) {
+        QSSGMeshBVH *bvh = nullptr;
+        if (!model.meshPath.isNull())
+            bvh = loadMeshBVH(model.meshPath);
+        else if (model.geometry)
+            bvh = loadMeshBVH(model.geometry);
+        if (!bvh)
+            return false;
+        // Picking may be looking at the mesh from another thread
+        QMutexLocker meshMutexLocker(&meshBufferMutex);
+        attachMeshBVH(mesh, bvh);
+        return true;
+    }
+
+    const auto buildIt = meshBVHBuilds.constFind(mesh);
+    if (buildIt != meshBVHBuilds.cend()) {
+        const std::shared_ptr<MeshBVHBuild> build = buildIt.value();
+        if (!build->finished.loadAcquire())
+            return false;
+        QSSGMeshBVH *bvh = nullptr;
+        {
+            QMutexLocker buildLocker(&build->mutex);
+            bvh = std::exchange(build->bvh, nullptr);
+        }
+        // A build without a result stays in the list, there is no point in
+        // retrying it.
+        if (!bvh)
+            return false;
+        meshBVHBuilds.erase(buildIt);
+        QMutexLocker meshMutexLocker(&meshBufferMutex);
+        attachMeshBVH(mesh, bvh);
+        return true;
+    }
+
+    // Everything the build needs is gathered here, the model, its geometry
+    // and the registered asset meshes must not be accessed from the worker
+    // thread. Loading the mesh data is cheap for mesh files since these are
+    // mapped, the builder only keeps references to the data.
+    std::shared_ptr<QSSGMeshBVHBuilder> meshBVHBuilder;
+    if (!model.meshPath.isNull()) {
+        const QSSGMesh::Mesh meshData = loadMeshData(model.meshPath);
+        if (meshData.isValid())
+            meshBVHBuilder = std::make_shared<QSSGMeshBVHBuilder>(meshData);
+        else
+            qCWarning(WARNING, "Failed to load mesh: %s", qPrintable(model.meshPath.path()));
+    } else if (model.geometry) {
+        meshBVHBuilder.reset(createMeshBVHBuilder(model.geometry));
+    }
+
+    const auto build = std::make_shared<MeshBVHBuild>();
+    meshBVHBuilds.insert(mesh, build);
+    if (!meshBVHBuilder) {
+        build->finished.storeRelease(1);
+        return false;
+    }
+
+    QThreadPool::globalInstance()->start([build, meshBVHBuilder]() {
+        meshBVHBuilder->setThreadPool(QThreadPool::globalInstance());
+        QSSGMeshBVH *bvh = meshBVHBuilder->buildTree();
+        QMutexLocker buildLocker(&build->mutex);
+        if (build->canceled)
+            delete bvh;
+        else
+            build->bvh = bvh;
+        build->finished.storeRelease(1);
+    });
+    return false;
+}
+
+bool QSSGBufferManager::hasPendingMeshBVHBuilds() const
+{
+    for (const auto &build : meshBVHBuilds) {
+        if (!build->finished.loadAcquire())
+            return true;
+    }
+    return false;
+}
+
+void QSSGBufferManager::cancelMeshBVHBuild(QSSGRenderMesh *mesh)
+{
+    const auto buildIt = meshBVHBuilds.constFind(mesh);
+    if (buildIt == meshBVHBuilds.cend())
+        return;
+    {
+        // The worker may still be running, it deletes its result itself then
+        QMutexLocker buildLocker(&buildIt.value()->mutex);
+        buildIt.value()->canceled = true;
+        delete std::exchange(buildIt.value()->bvh, nullptr);
+    }
+    meshBVHBuilds.erase(buildIt);
 }
 
 QSSGMesh::Mesh QSSGBufferManager::loadMeshData(const QSSGRenderPath &inMeshPath)
@@ -1597,7 +2146,11 @@ QSSGMesh::Mesh QSSGBufferManager::loadMeshData(const QSSGRenderPath &inMeshPath)
         if (!pathBuilder.isEmpty()) {
             QSharedPointer<QIODevice> device(QSSGInputUtil::getStreamForFile(pathBuilder));
             if (device) {
-                QSSGMesh::Mesh mesh = QSSGMesh::Mesh::loadMesh(device.data(), id);
+                // The vertex and index data reference the mapped file when
+                // possible, so the upload in createRenderMesh() reads them
+                // straight from the file pages, and nothing stays resident
+                // once the returned mesh is gone.
+                QSSGMesh::Mesh mesh = QSSGMesh::Mesh::loadMeshMapped(device, id);
                 if (mesh.isValid())
                     result = mesh;
             }
@@ -1616,6 +2169,13 @@ void QSSGBufferManager::clear()
 
     {
         QMutexLocker meshMutexLocker(&meshBufferMutex);
+        for (auto iter = meshBVHBuilds.cbegin(), end = meshBVHBuilds.cend(); iter != end; ++iter) {
+            QMutexLocker buildLocker(&iter.value()->mutex);
+            iter.value()->canceled = true;
+            delete std::exchange(iter.value()->bvh, nullptr);
+        }
+        meshBVHBuilds.clear();
+
         // Meshes (by path)
         for (auto iter = meshMap.begin(), end = meshMap.end(); iter != end; ++iter) {
             QSSGRenderMesh *theMesh = iter.value().mesh;
@@ -1693,65 +2253,12 @@ void QSSGBufferManager::processResourceLoader(const QSSGRenderResourceLoader *lo
 #if QT_CONFIG(qml_debug)
 QSSGBufferManager::MemoryStats QSSGBufferManager::memoryStats() const
 {
-    return stats;
-}
-
-static uint64_t textureMemorySize(QRhiTexture *texture)
-{
-    uint64_t s = 0;
-    if (!texture)
-        return s;
-
-    auto format = texture->format();
-    if (format == QRhiTexture::UnknownFormat)
-        return 0;
-
-    s = texture->pixelSize().width() * texture->pixelSize().height();
-    /*
-        UnknownFormat,
-        RGBA8,
-        BGRA8,
-        R8,
-        RG8,
-        R16,
-        RG16,
-        RED_OR_ALPHA8,
-        RGBA16F,
-        RGBA32F,
-        R16F,
-        R32F,
-        RGB10A2,
-        D16,
-        D24,
-        D24S8,
-        D32F,*/
-    static const uint64_t pixelSizes[] = {0, 4, 4, 1, 2, 2, 4, 1, 2, 4, 2, 4, 4, 2, 4, 4, 4};
-    /*
-        BC1,
-        BC2,
-        BC3,
-        BC4,
-        BC5,
-        BC6H,
-        BC7,
-        ETC2_RGB8,
-        ETC2_RGB8A1,
-        ETC2_RGBA8,*/
-    static const uint64_t blockSizes[] = {8, 16, 16, 8, 16, 16, 16, 8, 8, 16};
-    Q_STATIC_ASSERT_X(QRhiTexture::BC1 == 17 && QRhiTexture::ETC2_RGBA8 == 26,
-                      "QRhiTexture format constant value missmatch.");
-    if (format < QRhiTexture::BC1)
-        s *= pixelSizes[format];
-    else if (format >= QRhiTexture::BC1 && format <= QRhiTexture::ETC2_RGBA8)
-        s /= blockSizes[format - QRhiTexture::BC1];
-    else
-        s /= 16;
-
-    if (texture->flags() & QRhiTexture::MipMapped)
-        s += s / 4;
-    if (texture->flags() & QRhiTexture::CubeMap)
-        s *= 6;
-    return s;
+    MemoryStats result = stats;
+    for (const ImageData &imageData : imageMap) {
+        result.imageResidentDataSize += residentTextureSize(imageData);
+        result.imageRequestedDataSize += requestedTextureSize(imageData);
+    }
+    return result;
 }
 
 static uint64_t bufferMemorySize(QRhiBuffer *buffer)
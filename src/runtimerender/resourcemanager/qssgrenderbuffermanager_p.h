@@ -53,6 +53,8 @@
 
 #include <QtCore/QMutex>
 
+#include <memory>
+
 QT_BEGIN_NAMESPACE
 
 struct QSSGRenderMesh;
@@ -74,12 +76,23 @@ struct QSSGRenderLayer;
 // between different threads (and so windows). This is ensured by design, by
 // having a dedicated BufferManager for each render thread (window).
 
+// Counters of the images loaded on worker threads, accumulated over the
+// lifetime of the QSSGBufferManager.
+struct QSSGTextureLoadStats
+{
+    // Images being decoded, the materials use a placeholder meanwhile
+    int pendingCount = 0;
+    int finishedCount = 0;
+};
+
 class QSSGRenderContextInterface;
 class Q_QUICK3DRUNTIMERENDER_EXPORT QSSGBufferManager
 {
 public:
     QAtomicInt ref;
 
+    struct ImageLoad;
+
     struct ImageCacheKey {
         QSSGRenderPath path;
         int mipMode;
@@ -90,6 +103,13 @@ public:
         QSSGRenderImageTexture renderImageTexture;
         QHash<QSSGRenderLayer*, uint32_t> usageCounts;
         uint32_t generationId = 0;
+        // Set while the image is decoded on a worker thread,
+        // renderImageTexture is a placeholder then.
+        std::shared_ptr<ImageLoad> pendingLoad;
+        // Used with a texture memory budget, see enforceTextureBudget()
+        uint32_t lastUsedFrame = 0;
+        int droppedMipLevels = 0;
+        int mipLevelsToDrop = 0;
     };
 
     struct MeshData {
@@ -101,6 +121,10 @@ public:
     struct MemoryStats {
         uint64_t meshDataSize = 0;
         uint64_t imageDataSize = 0;
+        // Textures loaded from files: the memory they use, and the memory
+        // they would use without the mip levels dropped to meet the budget.
+        uint64_t imageResidentDataSize = 0;
+        uint64_t imageRequestedDataSize = 0;
     };
 
     enum MipMode {
@@ -119,16 +143,30 @@ public:
 
     void setRenderContextInterface(QSSGRenderContextInterface *ctx);
 
+    // Images with m_asyncLoad set, or all of them when
+    // QT_QUICK3D_ASYNC_TEXTURE_LOADING is set, are decoded on a worker thread
+    // when loaded from a file. Until the texture is uploaded, a later call
+    // with the same image picks it up, a plain white placeholder is returned
+    // with the Loading flag set. Light probes and cube maps are always loaded
+    // right away.
     QSSGRenderImageTexture loadRenderImage(const QSSGRenderImage *image,
                                            MipMode inMipMode = MipModeNone,
                                            LoadRenderImageFlags flags = LoadWithFlippedY);
+    bool hasPendingImageLoads() const { return textureLoadStats.pendingCount > 0; }
+    const QSSGTextureLoadStats &imageLoadStats() const { return textureLoadStats; }
 
     QSSGRenderMesh *getMeshForPicking(const QSSGRenderModel &model) const;
     QSSGBounds3 getModelBounds(const QSSGRenderModel *model) const;
 
     QSSGRenderMesh *loadMesh(const QSSGRenderModel *model);
 
-    // Called at the end of the frame to release unreferenced geometry and textures
+    // Called at the end of the frame to release unreferenced geometry and
+    // textures. With a texture memory budget, set in megabytes with
+    // QT_QUICK3D_TEXTURE_MEMORY_BUDGET, textures loaded from files are kept
+    // around until the budget is exceeded instead, and the least recently
+    // used ones are released first. When the textures in use exceed the
+    // budget, the highest mip levels of the largest ones are dropped. They
+    // are loaded again in the background once there is room.
     void cleanupUnreferencedBuffers(quint32 frameId, QSSGRenderLayer *layer);
     void resetUsageCounters(quint32 frameId, QSSGRenderLayer *layer);
 
@@ -142,6 +180,15 @@ public:
     static QSSGMeshBVH *loadMeshBVH(const QSSGRenderPath &inSourcePath);
     static QSSGMeshBVH *loadMeshBVH(QSSGRenderGeometry *geometry);
 
+    // Makes sure the mesh of the model gets the BVH used for picking. By
+    // default the BVH is built on a worker thread: the first call starts the
+    // build and returns false, and a later call attaches the result to the
+    // mesh once it is ready. Until then picking only tests the bounds of the
+    // subsets. Setting QT_QUICK3D_SYNCHRONOUS_BVH_BUILD builds it right away.
+    // Returns true when mesh->bvh is set.
+    bool prepareMeshBVH(const QSSGRenderModel &model, QSSGRenderMesh *mesh);
+    bool hasPendingMeshBVHBuilds() const;
+
     static QRhiTexture::Format toRhiFormat(const QSSGRenderTextureFormat format);
 
     static void registerMeshData(const QString &assetId, const QVector<QSSGMesh::Mesh> &meshData);
@@ -181,13 +228,33 @@ private:
     QSSGRenderMesh *loadMesh(const QSSGRenderPath &inSourcePath);
     QSSGRenderMesh *loadCustomMesh(QSSGRenderGeometry *geometry);
     static QSSGMesh::Mesh loadMeshData(const QSSGRenderPath &inSourcePath);
-    QSSGRenderMesh *createRenderMesh(const QSSGMesh::Mesh &mesh);
+    QSSGRenderMesh *createRenderMesh(const QSSGMesh::Mesh &mesh, QRhiBuffer::Type bufferType = QRhiBuffer::Static);
+    void updateCustomMesh(QSSGRenderMesh *mesh, const QSSGRenderGeometry *geometry, uint32_t fromGenerationId);
     QSSGRenderImageTexture loadTextureData(QSSGRenderTextureData *data, MipMode inMipMode);
     bool createEnvironmentMap(const QSSGLoadedTexture *inImage, QSSGRenderImageTexture *outTexture);
 
     void releaseMesh(const QSSGRenderPath &inSourcePath);
     void releaseImage(const ImageCacheKey &key);
 
+    // Shared between the render thread and the worker building the BVH. The
+    // worker never touches the mesh itself, the result is picked up by
+    // prepareMeshBVH() on the render thread.
+    struct MeshBVHBuild {
+        QMutex mutex;
+        QSSGMeshBVH *bvh = nullptr;
+        bool canceled = false;
+        QAtomicInt finished;
+    };
+    void cancelMeshBVHBuild(QSSGRenderMesh *mesh);
+
+    void startImageLoad(ImageData &imageData, const QSSGRenderImage *image, bool flipY);
+    void finishImageLoad(const ImageCacheKey &key, ImageData &imageData);
+    void cancelImageLoad(const std::shared_ptr<ImageLoad> &load);
+
+    void enforceTextureBudget(quint64 budget);
+    void dropMipLevels(ImageData &imageData);
+    bool canStreamIn(const ImageData &imageData, quint64 budget) const;
+
     QSSGRenderContextInterface *m_contextInterface = nullptr; // ContextInterfaces owns BufferManager
 
     // These store the actual buffer handles
@@ -200,6 +267,17 @@ private:
     QRhiResourceUpdateBatch *meshBufferUpdates = nullptr;
     QMutex meshBufferMutex;
 
+    // Pending BVH builds, and finished ones that did not produce a BVH so
+    // that these are not started over and over again.
+    QHash<QSSGRenderMesh *, std::shared_ptr<MeshBVHBuild>> meshBVHBuilds;
+
+    QSSGTextureLoadStats textureLoadStats;
+    // Memory used by the textures loaded from files as of the end of the
+    // last frame, and reserved for the ones being loaded again in full.
+    quint64 textureResidentSize = 0;
+    quint64 textureStreamInSize = 0;
+    bool textureBudgetExceededWarned = false;
+
     quint32 frameCleanupIndex = 0;
     quint32 frameResetIndex = 0;
     QSSGRenderLayer *currentLayer = nullptr;
@@ -29,7 +29,11 @@
 
 #include "qssgmesh_p.h"
 
+#include <cmath>
+
 #include <QtCore/QVector>
+#include <QtCore/QFile>
+#include <QtCore/QDataStream>
 #include <QtQuick3DUtils/private/qssgdataref_p.h>
 
 QT_BEGIN_NAMESPACE
@@ -56,6 +60,9 @@ static const size_t SUBSET_STRUCT_SIZE_V3_V4 = 40;
 // subset list: count, offset, minXYZ, maxXYZ, nameOffset, nameLength, lightmapSizeWidth, lightmapSizeHeight
 static const size_t SUBSET_STRUCT_SIZE_V5 = 48;
 
+// vertex buffer entry encoding list: encoding, offsetXYZ, scaleXYZ
+static const size_t VERTEX_BUFFER_ENTRY_ENCODING_STRUCT_SIZE = 28;
+
 MeshInternal::MultiMeshInfo MeshInternal::readFileHeader(QIODevice *device)
 {
     const qint64 multiHeaderStartOffset = device->size() - qint64(MULTI_HEADER_STRUCT_SIZE);
@@ -108,7 +115,20 @@ void MeshInternal::writeFileHeader(QIODevice *device, const MeshInternal::MultiM
     outputStream << meshFileInfo.fileId << meshFileInfo.fileVersion << multiEntriesOffset << meshCount;
 }
 
-quint64 MeshInternal::readMeshData(QIODevice *device, quint64 offset, Mesh *mesh, MeshDataHeader *header)
+static QByteArray readBufferData(QIODevice *device, const uchar *mappedData, quint32 size)
+{
+    if (!mappedData)
+        return device->read(size);
+
+    const qint64 pos = device->pos();
+    if (pos + qint64(size) > device->size())
+        return QByteArray();
+    device->seek(pos + size);
+    return QByteArray::fromRawData(reinterpret_cast<const char *>(mappedData) + pos, size);
+}
+
+quint64 MeshInternal::readMeshData(QIODevice *device, quint64 offset, Mesh *mesh, MeshDataHeader *header,
+                                   const uchar *mappedData)
 {
     static char alignPadding[4] = {};
 
@@ -173,6 +193,12 @@ quint64 MeshInternal::readMeshData(QIODevice *device, quint64 offset, Mesh *mesh
         mesh->m_vertexBuffer.entries.append(vertexBufferEntry);
         entriesByteSize += VERTEX_BUFFER_ENTRY_STRUCT_SIZE;
     }
+    QByteArray encodingTable;
+    if (header->hasQuantizedVertexData()) {
+        const quint32 encodingTableSize = vertexBufferEntriesCount * VERTEX_BUFFER_ENTRY_ENCODING_STRUCT_SIZE;
+        encodingTable = device->read(encodingTableSize);
+        entriesByteSize += encodingTableSize;
+    }
     quint32 alignAmount = offsetTracker.alignedAdvance(entriesByteSize);
     if (alignAmount)
         device->read(alignPadding, alignAmount);
@@ -189,12 +215,30 @@ quint64 MeshInternal::readMeshData(QIODevice *device, quint64 offset, Mesh *mesh
             device->read(alignPadding, alignAmount);
     }
 
-    mesh->m_vertexBuffer.data = device->read(vertexBufferDataSize);
+    if (header->hasPageAlignedBuffers()) {
+        alignAmount = offsetTracker.pageAlignedAdvance();
+        if (alignAmount)
+            device->seek(device->pos() + alignAmount);
+    }
+    mesh->m_vertexBuffer.data = readBufferData(device, mappedData, vertexBufferDataSize);
+    if (quint32(mesh->m_vertexBuffer.data.size()) != vertexBufferDataSize) {
+        qWarning() << "Mesh vertex data truncated";
+        return 0;
+    }
     alignAmount = offsetTracker.alignedAdvance(vertexBufferDataSize);
     if (alignAmount)
         device->read(alignPadding, alignAmount);
 
-    mesh->m_indexBuffer.data = device->read(indexBufferDataSize);
+    if (header->hasPageAlignedBuffers()) {
+        alignAmount = offsetTracker.pageAlignedAdvance();
+        if (alignAmount)
+            device->seek(device->pos() + alignAmount);
+    }
+    mesh->m_indexBuffer.data = readBufferData(device, mappedData, indexBufferDataSize);
+    if (quint32(mesh->m_indexBuffer.data.size()) != indexBufferDataSize) {
+        qWarning() << "Mesh index data truncated";
+        return 0;
+    }
     alignAmount = offsetTracker.alignedAdvance(indexBufferDataSize);
     if (alignAmount)
         device->read(alignPadding, alignAmount);
@@ -249,6 +293,11 @@ quint64 MeshInternal::readMeshData(QIODevice *device, quint64 offset, Mesh *mesh
     for (const MeshInternal::Subset &internalSubset : internalSubsets)
         mesh->m_subsets.append(internalSubset.toMeshSubset());
 
+    if (header->hasQuantizedVertexData() && !dequantizeVertexData(mesh, encodingTable)) {
+        qWarning() << "Mesh vertex data encoding invalid";
+        return 0;
+    }
+
     return header->sizeInBytes;
 }
 
@@ -270,10 +319,13 @@ void MeshInternal::writeMeshHeader(QIODevice *device, const MeshDataHeader &head
 // that's also legacy nonsense, but having that allows the reader not have to
 // branch based on the version.
 
-quint64 MeshInternal::writeMeshData(QIODevice *device, const Mesh &mesh)
+quint64 MeshInternal::writeMeshData(QIODevice *device, const Mesh &inMesh, bool quantize)
 {
     static const char alignPadding[4] = {};
 
+    QByteArray encodingTable;
+    const Mesh mesh = quantize ? quantizeVertexData(inMesh, &encodingTable) : inMesh;
+
     QDataStream outputStream(device);
     outputStream.setByteOrder(QDataStream::LittleEndian);
     outputStream.setFloatingPointPrecision(QDataStream::SinglePrecision);
@@ -323,6 +375,10 @@ quint64 MeshInternal::writeMeshData(QIODevice *device, const Mesh &mesh)
                      << offset;
         entriesByteSize += VERTEX_BUFFER_ENTRY_STRUCT_SIZE;
     }
+    if (quantize) {
+        device->write(encodingTable);
+        entriesByteSize += encodingTable.size();
+    }
     quint32 alignAmount = offsetTracker.alignedAdvance(entriesByteSize);
     if (alignAmount)
         device->write(alignPadding, alignAmount);
@@ -337,11 +393,17 @@ quint64 MeshInternal::writeMeshData(QIODevice *device, const Mesh &mesh)
             device->write(alignPadding, alignAmount);
     }
 
+    alignAmount = offsetTracker.pageAlignedAdvance();
+    if (alignAmount)
+        device->write(QByteArray(alignAmount, '\0'));
     device->write(mesh.m_vertexBuffer.data.constData(), vertexBufferDataSize);
     alignAmount = offsetTracker.alignedAdvance(vertexBufferDataSize);
     if (alignAmount)
         device->write(alignPadding, alignAmount);
 
+    alignAmount = offsetTracker.pageAlignedAdvance();
+    if (alignAmount)
+        device->write(QByteArray(alignAmount, '\0'));
     device->write(mesh.m_indexBuffer.data.constData(), indexBufferDataSize);
     alignAmount = offsetTracker.alignedAdvance(indexBufferDataSize);
     if (alignAmount)
@@ -395,25 +457,42 @@ quint64 MeshInternal::writeMeshData(QIODevice *device, const Mesh &mesh)
     return sizeInBytes;
 }
 
-Mesh Mesh::loadMesh(QIODevice *device, quint32 id)
+static Mesh loadMeshEntry(QIODevice *device, quint32 id, const uchar *mappedData)
 {
     MeshInternal::MeshDataHeader header;
     const MeshInternal::MultiMeshInfo meshFileInfo = MeshInternal::readFileHeader(device);
     auto it = meshFileInfo.meshEntries.constFind(id);
     if (it != meshFileInfo.meshEntries.constEnd()) {
         Mesh mesh;
-        quint64 size = MeshInternal::readMeshData(device, *it, &mesh, &header);
+        quint64 size = MeshInternal::readMeshData(device, *it, &mesh, &header, mappedData);
         if (size)
             return mesh;
     } else if (id == 0 && !meshFileInfo.meshEntries.isEmpty()) {
         Mesh mesh;
-        quint64 size = MeshInternal::readMeshData(device, *meshFileInfo.meshEntries.cbegin(), &mesh, &header);
+        quint64 size = MeshInternal::readMeshData(device, *meshFileInfo.meshEntries.cbegin(), &mesh, &header, mappedData);
         if (size)
             return mesh;
     }
     return Mesh();
 }
 
+Mesh Mesh::loadMesh(QIODevice *device, quint32 id)
+{
+    return loadMeshEntry(device, id, nullptr);
+}
+
+Mesh Mesh::loadMeshMapped(const QSharedPointer<QIODevice> &device, quint32 id)
+{
+    QFile *file = qobject_cast<QFile *>(device.data());
+    const uchar *mappedData = file ? file->map(0, file->size()) : nullptr;
+    if (!mappedData)
+        return loadMeshEntry(device.data(), id, nullptr);
+
+    Mesh mesh = loadMeshEntry(device.data(), id, mappedData);
+    mesh.m_mappedDevice = device;
+    return mesh;
+}
+
 QMap<quint32, Mesh> Mesh::loadAll(QIODevice *device)
 {
     MeshInternal::MeshDataHeader header;
@@ -633,7 +712,7 @@ Mesh Mesh::fromRuntimeData(const RuntimeMeshData &data, QString *error)
     return mesh;
 }
 
-quint32 Mesh::save(QIODevice *device, quint32 id) const
+quint32 Mesh::save(QIODevice *device, quint32 id, VertexEncoding encoding) const
 {
     qint64 newMeshStartPosFromEnd = 0;
     quint32 newId = 1;
@@ -664,9 +743,12 @@ quint32 Mesh::save(QIODevice *device, quint32 id) const
     header.meshEntries.insert(newId, meshOffset);
 
     MeshInternal::MeshDataHeader meshHeader = MeshInternal::MeshDataHeader::withDefaults();
+    const bool quantize = encoding == VertexEncoding::Quantized;
+    if (quantize)
+        meshHeader.flags |= MeshInternal::MeshDataHeader::QuantizedVertexData;
     // skip the space for the mesh header for now
     device->seek(device->pos() + MESH_HEADER_STRUCT_SIZE);
-    meshHeader.sizeInBytes = MeshInternal::writeMeshData(device, *this);
+    meshHeader.sizeInBytes = MeshInternal::writeMeshData(device, *this, quantize);
     // now the mesh header is ready to be written out
     device->seek(meshOffset);
     MeshInternal::writeMeshHeader(device, meshHeader);
@@ -732,6 +814,329 @@ QSSGBounds3 MeshInternal::calculateSubsetBounds(const Mesh::VertexBufferEntry &e
     return result;
 }
 
+// Encodings of the vertex buffer entries in mesh data with the
+// QuantizedVertexData flag. Range16 stores each component as an unsigned
+// 16-bit value within [offset, offset + scale] of that component.
+// Octahedral16 stores a unit vector as two signed normalized 16-bit values.
+enum class VertexEntryEncoding : quint32 {
+    None = 0,
+    Range16,
+    Octahedral16
+};
+
+struct VertexEntryQuantization {
+    VertexEntryEncoding encoding = VertexEntryEncoding::None;
+    float offset[3] = {};
+    float scale[3] = {};
+};
+
+static VertexEntryEncoding encodingForEntry(const Mesh::VertexBufferEntry &entry)
+{
+    if (entry.componentType != Mesh::ComponentType::Float32)
+        return VertexEntryEncoding::None;
+    if (entry.name == MeshInternal::getPositionAttrName() && entry.componentCount == 3)
+        return VertexEntryEncoding::Range16;
+    if ((entry.name == MeshInternal::getUV0AttrName() || entry.name == MeshInternal::getUV1AttrName())
+            && entry.componentCount == 2)
+        return VertexEntryEncoding::Range16;
+    if ((entry.name == MeshInternal::getNormalAttrName()
+         || entry.name == MeshInternal::getTexTanAttrName()
+         || entry.name == MeshInternal::getTexBinormalAttrName())
+            && entry.componentCount == 3)
+        return VertexEntryEncoding::Octahedral16;
+    return VertexEntryEncoding::None;
+}
+
+static inline float signNotZero(float v)
+{
+    return v >= 0.0f ? 1.0f : -1.0f;
+}
+
+static void encodeOctahedral(const float *v, qint16 *out)
+{
+    const float l1 = qAbs(v[0]) + qAbs(v[1]) + qAbs(v[2]);
+    float x = l1 > 0.0f ? v[0] / l1 : 0.0f;
+    float y = l1 > 0.0f ? v[1] / l1 : 0.0f;
+    if (l1 > 0.0f && v[2] < 0.0f) {
+        const float foldedX = (1.0f - qAbs(y)) * signNotZero(x);
+        y = (1.0f - qAbs(x)) * signNotZero(y);
+        x = foldedX;
+    }
+    out[0] = qint16(qRound(qBound(-1.0f, x, 1.0f) * 32767.0f));
+    out[1] = qint16(qRound(qBound(-1.0f, y, 1.0f) * 32767.0f));
+}
+
+static void decodeOctahedral(const qint16 *in, float *v)
+{
+    float x = qMax(in[0] / 32767.0f, -1.0f);
+    float y = qMax(in[1] / 32767.0f, -1.0f);
+    const float z = 1.0f - qAbs(x) - qAbs(y);
+    const float t = qMax(-z, 0.0f);
+    x += x >= 0.0f ? -t : t;
+    y += y >= 0.0f ? -t : t;
+    const float length = std::sqrt(x * x + y * y + z * z);
+    v[0] = length > 0.0f ? x / length : 0.0f;
+    v[1] = length > 0.0f ? y / length : 0.0f;
+    v[2] = length > 0.0f ? z / length : 1.0f;
+}
+
+// Places the entries one after the other, each aligned to its component
+// size, and returns the resulting stride.
+static quint32 layoutVertexEntries(QVector<Mesh::VertexBufferEntry> *entries)
+{
+    quint32 offset = 0;
+    quint32 alignment = 4;
+    for (Mesh::VertexBufferEntry &entry : *entries) {
+        const quint32 componentSize = MeshInternal::byteSizeForComponentType(entry.componentType);
+        offset = getAlignedOffset(offset, componentSize);
+        entry.offset = offset;
+        offset += componentSize * entry.componentCount;
+        alignment = qMax(alignment, componentSize);
+    }
+    return getAlignedOffset(offset, alignment);
+}
+
+static inline quint32 indexValue(const char *indices, quint32 indexSize, quint32 i)
+{
+    if (indexSize == 2) {
+        quint16 v;
+        memcpy(&v, indices + i * 2, 2);
+        return v;
+    }
+    quint32 v;
+    memcpy(&v, indices + i * 4, 4);
+    return v;
+}
+
+static inline void setIndexValue(char *indices, quint32 indexSize, quint32 i, quint32 value)
+{
+    if (indexSize == 2) {
+        const quint16 v = quint16(value);
+        memcpy(indices + i * 2, &v, 2);
+    } else {
+        memcpy(indices + i * 4, &value, 4);
+    }
+}
+
+Mesh MeshInternal::quantizeVertexData(const Mesh &mesh, QByteArray *encodingTable)
+{
+    const Mesh::VertexBuffer &vertexBuffer(mesh.m_vertexBuffer);
+    const quint32 stride = vertexBuffer.stride;
+    const quint32 vertexCount = stride ? vertexBuffer.data.size() / stride : 0;
+    const char *src = vertexBuffer.data.constData();
+
+    Mesh result = mesh;
+    Mesh::VertexBuffer &encoded(result.m_vertexBuffer);
+    QVector<VertexEntryQuantization> quantizations(vertexBuffer.entries.size());
+    for (int i = 0; i < encoded.entries.size(); ++i) {
+        Mesh::VertexBufferEntry &entry(encoded.entries[i]);
+        VertexEntryQuantization &quantization(quantizations[i]);
+        quantization.encoding = encodingForEntry(entry);
+        if (entry.offset + sizeof(float) * entry.componentCount > stride)
+            quantization.encoding = VertexEntryEncoding::None;
+
+        switch (quantization.encoding) {
+        case VertexEntryEncoding::Range16:
+            for (quint32 c = 0; c < entry.componentCount; ++c) {
+                float minimum = std::numeric_limits<float>::max();
+                float maximum = std::numeric_limits<float>::lowest();
+                for (quint32 v = 0; v < vertexCount; ++v) {
+                    float value;
+                    memcpy(&value, src + v * stride + entry.offset + c * sizeof(float), sizeof(float));
+                    minimum = qMin(minimum, value);
+                    maximum = qMax(maximum, value);
+                }
+                if (vertexCount) {
+                    quantization.offset[c] = minimum;
+                    quantization.scale[c] = maximum - minimum;
+                }
+            }
+            entry.componentType = Mesh::ComponentType::UnsignedInt16;
+            break;
+        case VertexEntryEncoding::Octahedral16:
+            entry.componentType = Mesh::ComponentType::Int16;
+            entry.componentCount = 2;
+            break;
+        case VertexEntryEncoding::None:
+            break;
+        }
+    }
+    encoded.stride = layoutVertexEntries(&encoded.entries);
+
+    // Vertices are stored in the order of their first use by the index
+    // buffer, so that drawing reads the vertex data mostly sequentially.
+    const Mesh::IndexBuffer &indexBuffer(mesh.m_indexBuffer);
+    const quint32 indexSize = MeshInternal::byteSizeForComponentType(indexBuffer.componentType);
+    const bool indexed = !indexBuffer.data.isEmpty() && (indexSize == 2 || indexSize == 4);
+    const quint32 indexCount = indexed ? indexBuffer.data.size() / indexSize : 0;
+    const quint32 unassigned = std::numeric_limits<quint32>::max();
+    QVector<quint32> newIndex(vertexCount, unassigned);
+    quint32 nextIndex = 0;
+    bool indicesInRange = true;
+    for (quint32 i = 0; i < indexCount; ++i) {
+        const quint32 v = indexValue(indexBuffer.data.constData(), indexSize, i);
+        if (v >= vertexCount)
+            indicesInRange = false;
+        else if (newIndex[v] == unassigned)
+            newIndex[v] = nextIndex++;
+    }
+    for (quint32 v = 0; v < vertexCount; ++v) {
+        if (newIndex[v] == unassigned)
+            newIndex[v] = nextIndex++;
+    }
+
+    encoded.data = QByteArray(vertexCount * encoded.stride, '\0');
+    char *dst = encoded.data.data();
+    for (quint32 v = 0; v < vertexCount; ++v) {
+        const char *srcVertex = src + v * stride;
+        char *dstVertex = dst + newIndex[v] * encoded.stride;
+        for (int i = 0; i < encoded.entries.size(); ++i) {
+            const Mesh::VertexBufferEntry &srcEntry(vertexBuffer.entries[i]);
+            const Mesh::VertexBufferEntry &dstEntry(encoded.entries[i]);
+            const VertexEntryQuantization &quantization(quantizations[i]);
+            switch (quantization.encoding) {
+            case VertexEntryEncoding::Range16:
+                for (quint32 c = 0; c < srcEntry.componentCount; ++c) {
+                    float value;
+                    memcpy(&value, srcVertex + srcEntry.offset + c * sizeof(float), sizeof(float));
+                    const float scale = quantization.scale[c];
+                    const float normalized = scale > 0.0f ? (value - quantization.offset[c]) / scale : 0.0f;
+                    const quint16 q = quint16(qBound(0, qRound(normalized * 65535.0f), 65535));
+                    memcpy(dstVertex + dstEntry.offset + c * sizeof(quint16), &q, sizeof(quint16));
+                }
+                break;
+            case VertexEntryEncoding::Octahedral16: {
+                float value[3];
+                memcpy(value, srcVertex + srcEntry.offset, sizeof(value));
+                qint16 q[2];
+                encodeOctahedral(value, q);
+                memcpy(dstVertex + dstEntry.offset, q, sizeof(q));
+            }
+                break;
+            case VertexEntryEncoding::None: {
+                const quint32 byteSize = MeshInternal::byteSizeForComponentType(srcEntry.componentType)
+                        * srcEntry.componentCount;
+                if (srcEntry.offset + byteSize <= stride)
+                    memcpy(dstVertex + dstEntry.offset, srcVertex + srcEntry.offset, byteSize);
+            }
+                break;
+            }
+        }
+    }
+
+    if (indexed) {
+        // 16-bit indices are enough when all the vertices can be addressed
+        const bool narrow = indexSize == 4 && indicesInRange && vertexCount <= 65536;
+        const quint32 newIndexSize = narrow ? 2 : indexSize;
+        QByteArray indices(indexCount * newIndexSize, Qt::Uninitialized);
+        for (quint32 i = 0; i < indexCount; ++i) {
+            const quint32 v = indexValue(indexBuffer.data.constData(), indexSize, i);
+            setIndexValue(indices.data(), newIndexSize, i, v < vertexCount ? newIndex[v] : v);
+        }
+        result.m_indexBuffer.data = indices;
+        if (narrow)
+            result.m_indexBuffer.componentType = Mesh::ComponentType::UnsignedInt16;
+    }
+
+    encodingTable->clear();
+    QDataStream tableStream(encodingTable, QIODevice::WriteOnly);
+    tableStream.setByteOrder(QDataStream::LittleEndian);
+    tableStream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    for (const VertexEntryQuantization &quantization : qAsConst(quantizations)) {
+        tableStream << quint32(quantization.encoding)
+                    << quantization.offset[0] << quantization.offset[1] << quantization.offset[2]
+                    << quantization.scale[0] << quantization.scale[1] << quantization.scale[2];
+    }
+
+    return result;
+}
+
+bool MeshInternal::dequantizeVertexData(Mesh *mesh, const QByteArray &encodingTable)
+{
+    Mesh::VertexBuffer &vertexBuffer(mesh->m_vertexBuffer);
+    if (size_t(encodingTable.size()) != vertexBuffer.entries.size() * VERTEX_BUFFER_ENTRY_ENCODING_STRUCT_SIZE)
+        return false;
+
+    QDataStream tableStream(encodingTable);
+    tableStream.setByteOrder(QDataStream::LittleEndian);
+    tableStream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    const quint32 stride = vertexBuffer.stride;
+    QVector<VertexEntryQuantization> quantizations(vertexBuffer.entries.size());
+    QVector<Mesh::VertexBufferEntry> decodedEntries = vertexBuffer.entries;
+    for (int i = 0; i < vertexBuffer.entries.size(); ++i) {
+        const Mesh::VertexBufferEntry &entry(vertexBuffer.entries[i]);
+        VertexEntryQuantization &quantization(quantizations[i]);
+        quint32 encoding;
+        tableStream >> encoding
+                    >> quantization.offset[0] >> quantization.offset[1] >> quantization.offset[2]
+                    >> quantization.scale[0] >> quantization.scale[1] >> quantization.scale[2];
+        quantization.encoding = VertexEntryEncoding(encoding);
+
+        if (entry.offset + MeshInternal::byteSizeForComponentType(entry.componentType) * entry.componentCount > stride)
+            return false;
+        switch (quantization.encoding) {
+        case VertexEntryEncoding::Range16:
+            if (entry.componentType != Mesh::ComponentType::UnsignedInt16 || entry.componentCount > 3)
+                return false;
+            decodedEntries[i].componentType = Mesh::ComponentType::Float32;
+            break;
+        case VertexEntryEncoding::Octahedral16:
+            if (entry.componentType != Mesh::ComponentType::Int16 || entry.componentCount != 2)
+                return false;
+            decodedEntries[i].componentType = Mesh::ComponentType::Float32;
+            decodedEntries[i].componentCount = 3;
+            break;
+        case VertexEntryEncoding::None:
+            break;
+        default:
+            return false;
+        }
+    }
+
+    const quint32 decodedStride = layoutVertexEntries(&decodedEntries);
+    const quint32 vertexCount = stride ? vertexBuffer.data.size() / stride : 0;
+    QByteArray decoded(vertexCount * decodedStride, '\0');
+    const char *src = vertexBuffer.data.constData();
+    char *dst = decoded.data();
+    for (quint32 v = 0; v < vertexCount; ++v) {
+        const char *srcVertex = src + v * stride;
+        char *dstVertex = dst + v * decodedStride;
+        for (int i = 0; i < decodedEntries.size(); ++i) {
+            const Mesh::VertexBufferEntry &srcEntry(vertexBuffer.entries[i]);
+            const Mesh::VertexBufferEntry &dstEntry(decodedEntries[i]);
+            const VertexEntryQuantization &quantization(quantizations[i]);
+            switch (quantization.encoding) {
+            case VertexEntryEncoding::Range16:
+                for (quint32 c = 0; c < srcEntry.componentCount; ++c) {
+                    quint16 q;
+                    memcpy(&q, srcVertex + srcEntry.offset + c * sizeof(quint16), sizeof(quint16));
+                    const float value = quantization.offset[c] + (q / 65535.0f) * quantization.scale[c];
+                    memcpy(dstVertex + dstEntry.offset + c * sizeof(float), &value, sizeof(float));
+                }
+                break;
+            case VertexEntryEncoding::Octahedral16: {
+                qint16 q[2];
+                memcpy(q, srcVertex + srcEntry.offset, sizeof(q));
+                float value[3];
+                decodeOctahedral(q, value);
+                memcpy(dstVertex + dstEntry.offset, value, sizeof(value));
+            }
+                break;
+            case VertexEntryEncoding::None:
+                memcpy(dstVertex + dstEntry.offset, srcVertex + srcEntry.offset,
+                       MeshInternal::byteSizeForComponentType(srcEntry.componentType) * srcEntry.componentCount);
+                break;
+            }
+        }
+    }
+
+    vertexBuffer.entries = decodedEntries;
+    vertexBuffer.stride = decodedStride;
+    vertexBuffer.data = decoded;
+    return true;
+}
+
 } // namespace QSSGMesh
 
 QT_END_NAMESPACE
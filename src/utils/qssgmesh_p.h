@@ -51,6 +51,7 @@
 #include <QtCore/qbytearray.h>
 #include <QtCore/qiodevice.h>
 #include <QtCore/qmap.h>
+#include <QtCore/qsharedpointer.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -138,6 +139,13 @@ public:
     // id 0 == first, otherwise has to match
     static Mesh loadMesh(QIODevice *device, quint32 id = 0);
 
+    // Like loadMesh(), but when the device is a QFile that can be mapped (a
+    // local file or an uncompressed resource), the vertex and index data
+    // reference the mapped file instead of being read into memory. The
+    // mapping lives as long as the returned Mesh or any copy of it, so the
+    // buffer data must not be used after those are gone.
+    static Mesh loadMeshMapped(const QSharedPointer<QIODevice> &device, quint32 id = 0);
+
     static QMap<quint32, Mesh> loadAll(QIODevice *device);
 
     static Mesh fromAssetData(const QVector<AssetVertexEntry> &vbufEntries,
@@ -153,8 +161,17 @@ public:
     DrawMode drawMode() const { return m_drawMode; }
     Winding winding() const { return m_winding; }
 
+    enum class VertexEncoding {
+        Full,
+        // Positions and UVs as 16-bit values within their range, normals,
+        // tangents and binormals octahedral-encoded in 2x16 bits, vertices
+        // in the order of first use, and 16-bit indices when possible. The
+        // data is decoded back to 32-bit floats when loading.
+        Quantized
+    };
+
     // id 0 == generate new id; otherwise uses it as-is, and must be an unused one
-    quint32 save(QIODevice *device, quint32 id = 0) const;
+    quint32 save(QIODevice *device, quint32 id = 0, VertexEncoding encoding = VertexEncoding::Full) const;
 
 private:
     DrawMode m_drawMode = DrawMode::Triangles;
@@ -162,6 +179,7 @@ private:
     VertexBuffer m_vertexBuffer;
     IndexBuffer m_indexBuffer;
     QVector<Subset> m_subsets;
+    QSharedPointer<QIODevice> m_mappedDevice;
     friend struct MeshInternal;
 };
 
@@ -283,7 +301,16 @@ struct Q_QUICK3DUTILS_EXPORT MeshInternal
         static const quint32 LEGACY_MESH_FILE_VERSION = 3;
         // Version 5 differs from 4 with the added lightmapSizeHint per subset.
         // This needs branching in the deserializer.
-        static const quint32 FILE_VERSION = 5;
+        // Version 6 pads the vertex and index data so that both start on a
+        // page boundary of the file, which lets them be used from a mapped
+        // file without touching the pages of the surrounding headers.
+        // Version 7 adds the QuantizedVertexData flag, with which the vertex
+        // buffer entry list is followed by the encoding of each entry.
+        static const quint32 FILE_VERSION = 7;
+
+        enum Flag : quint16 {
+            QuantizedVertexData = 0x01
+        };
 
         static MeshDataHeader withDefaults() {
             return { FILE_ID, FILE_VERSION, 0, 0 };
@@ -298,6 +325,14 @@ struct Q_QUICK3DUTILS_EXPORT MeshInternal
         bool hasLightmapSizeHint() const {
             return fileVersion >= 5;
         }
+
+        bool hasPageAlignedBuffers() const {
+            return fileVersion >= 6;
+        }
+
+        bool hasQuantizedVertexData() const {
+            return fileVersion >= 7 && (flags & QuantizedVertexData);
+        }
     };
 
     struct MeshOffsetTracker {
@@ -321,6 +356,16 @@ struct Q_QUICK3DUTILS_EXPORT MeshInternal
         void advance(int advanceAmount) {
             byteCounter += advanceAmount;
         }
+
+        // Part of the file format, independent of the actual page size.
+        static const quint32 PAGE_SIZE = 4096;
+
+        quint32 pageAlignedAdvance() {
+            const quint32 leftover = quint32(offset()) % PAGE_SIZE;
+            const quint32 alignmentAmount = leftover ? PAGE_SIZE - leftover : 0;
+            byteCounter += alignmentAmount;
+            return alignmentAmount;
+        }
     };
 
     struct Subset {
@@ -346,9 +391,17 @@ struct Q_QUICK3DUTILS_EXPORT MeshInternal
 
     static MultiMeshInfo readFileHeader(QIODevice *device);
     static void writeFileHeader(QIODevice *device, const MultiMeshInfo &meshFileInfo);
-    static quint64 readMeshData(QIODevice *device, quint64 offset, Mesh *mesh, MeshDataHeader *header);
+    // With mappedData (the device's contents mapped into memory) the vertex
+    // and index data are not copied but reference mappedData.
+    static quint64 readMeshData(QIODevice *device, quint64 offset, Mesh *mesh, MeshDataHeader *header,
+                                const uchar *mappedData = nullptr);
     static void writeMeshHeader(QIODevice *device, const MeshDataHeader &header);
-    static quint64 writeMeshData(QIODevice *device, const Mesh &mesh);
+    static quint64 writeMeshData(QIODevice *device, const Mesh &mesh, bool quantize = false);
+    // Re-encodes the vertex and index data of mesh for saving with the
+    // QuantizedVertexData flag. The encoding of each vertex buffer entry is
+    // written to encodingTable.
+    static Mesh quantizeVertexData(const Mesh &mesh, QByteArray *encodingTable);
+    static bool dequantizeVertexData(Mesh *mesh, const QByteArray &encodingTable);
 
     static int byteSizeForComponentType(Mesh::ComponentType componentType) {
         switch (componentType) {
@@ -49,25 +49,24 @@
 
 QT_BEGIN_NAMESPACE
 
+// Nodes are stored in one array, in depth-first order, so that the left
+// child of an internal node is always the node right after it.
 struct Q_QUICK3DUTILS_EXPORT QSSGMeshBVHNode {
-    ~QSSGMeshBVHNode() {
-        delete left;
-        delete right;
-    }
-
-    // Internal
-    QSSGMeshBVHNode *left = nullptr;
-    QSSGMeshBVHNode *right = nullptr;
     QSSGBounds3 boundingData;
-    //splitAxis
 
-    // Leaf
-    int offset = 0;
+    // Leaf: offset is the first triangle, count the number of triangles.
+    // Internal: count is 0 and offset is the distance to the right child.
+    // An empty leaf has count 0 and offset -1.
+    int offset = -1;
     int count = 0;
+
+    bool isLeaf() const { return count != 0 || offset < 0; }
+    const QSSGMeshBVHNode *left() const { return this + 1; }
+    const QSSGMeshBVHNode *right() const { return this + offset; }
 };
+static_assert(sizeof(QSSGMeshBVHNode) == 32, "QSSGMeshBVHNode is expected to be 32 bytes");
 
 struct Q_QUICK3DUTILS_EXPORT QSSGMeshBVHTriangle {
-    QSSGBounds3 bounds;
     QVector3D vertex1;
     QVector3D vertex2;
     QVector3D vertex3;
@@ -78,15 +77,20 @@ struct Q_QUICK3DUTILS_EXPORT QSSGMeshBVHTriangle {
 
 struct Q_QUICK3DUTILS_EXPORT QSSGMeshBVH
 {
-    QSSGMeshBVH(const QVector<QSSGMeshBVHNode *> &bvhRoots,
-                const QVector<QSSGMeshBVHTriangle *> &bvhTriangles)
-        : roots(bvhRoots)
-        , triangles(bvhTriangles)
+    QSSGMeshBVH() = default;
+    QSSGMeshBVH(QVector<QSSGMeshBVHNode> &&bvhNodes,
+                QVector<int> &&bvhRoots,
+                QVector<QSSGMeshBVHTriangle> &&bvhTriangles)
+        : nodes(std::move(bvhNodes))
+        , roots(std::move(bvhRoots))
+        , triangles(std::move(bvhTriangles))
     {}
-    ~QSSGMeshBVH();
 
-    QVector<QSSGMeshBVHNode *> roots;
-    QVector<QSSGMeshBVHTriangle *> triangles;
+    const QSSGMeshBVHNode *root(int subset) const { return nodes.constData() + roots.at(subset); }
+
+    QVector<QSSGMeshBVHNode> nodes;
+    QVector<int> roots; // index into nodes for each subset
+    QVector<QSSGMeshBVHTriangle> triangles; // ordered as referenced by the leaves
 };
 
 QT_END_NAMESPACE
@@ -29,6 +29,11 @@
 
 #include "qssgmeshbvhbuilder_p.h"
 
+#include <QtCore/QSemaphore>
+#include <QtCore/QThreadPool>
+
+#include <algorithm>
+
 QT_BEGIN_NAMESPACE
 
 QSSGMeshBVHBuilder::QSSGMeshBVHBuilder(const QSSGMesh::Mesh &mesh)
@@ -89,7 +94,7 @@ QSSGMeshBVHBuilder::QSSGMeshBVHBuilder(const QByteArray &vertexBuffer,
 
 QSSGMeshBVH* QSSGMeshBVHBuilder::buildTree()
 {
-    m_roots.clear();
+    m_nodes.clear();
 
     // This only works with triangles
     if (m_mesh.isValid() && m_mesh.drawMode() != QSSGMesh::Mesh::DrawMode::Triangles)
@@ -101,37 +106,55 @@ QSSGMeshBVH* QSSGMeshBVHBuilder::buildTree()
         indexCount = m_indexBufferData.size() / getSizeOfType(m_indexBufferComponentType);
     else
         indexCount = m_vertexBufferData.size() / m_vertexStride;
-    m_triangleBounds = calculateTriangleBounds(0, indexCount);
+    calculateTriangleBounds(0, indexCount);
+
+    const quint32 triangleCount = quint32(m_triangles.size());
+    m_triangleOrder.resize(triangleCount);
+    for (quint32 i = 0; i < triangleCount; ++i)
+        m_triangleOrder[i] = i;
+    // Roughly the node count of a tree with two triangles per leaf.
+    m_nodes.reserve(qMax(triangleCount, 1u));
 
     // For each submesh, generate a root bvh node
+    QVector<int> roots;
     if (m_mesh.isValid()) {
         const QVector<QSSGMesh::Mesh::Subset> subsets = m_mesh.subsets();
         for (quint32 subsetIdx = 0, subsetEnd = subsets.size(); subsetIdx < subsetEnd; ++subsetIdx) {
             const QSSGMesh::Mesh::Subset &source(subsets[subsetIdx]);
-            QSSGMeshBVHNode *root = new QSSGMeshBVHNode();
             // Offsets provided by subset are for the index buffer
             // Convert them to work with the triangle bounds list
             const quint32 triangleOffset = source.offset / 3;
             const quint32 triangleCount = source.count / 3;
-            root->boundingData = getBounds(triangleOffset, triangleCount);
             // Recursively split the mesh into a tree of smaller bounding volumns
-            root = splitNode(root, triangleOffset, triangleCount);
-            m_roots.append(root);
+            roots.append(splitNode(m_nodes, triangleOffset, triangleCount));
         }
     } else {
         // Custom Geometry only has one subset
-        QSSGMeshBVHNode *root = new QSSGMeshBVHNode();
-        root->boundingData = getBounds(0, m_triangleBounds.count());
-        root = splitNode(root, 0, m_triangleBounds.count());
-        m_roots.append(root);
+        roots.append(splitNode(m_nodes, 0, triangleCount));
     }
-    return new QSSGMeshBVH(m_roots, m_triangleBounds);
+
+    // Store the triangles in the order the leaves reference them, so that
+    // each leaf's triangles are next to each other in memory.
+    QVector<QSSGMeshBVHTriangle> triangles;
+    triangles.reserve(triangleCount);
+    for (quint32 triangleIndex : qAsConst(m_triangleOrder))
+        triangles.append(m_triangles.at(triangleIndex));
+
+    m_triangles.clear();
+    m_triangleBounds.clear();
+    m_triangleCentroids.clear();
+    m_triangleOrder.clear();
+    m_nodes.squeeze();
+
+    return new QSSGMeshBVH(std::move(m_nodes), std::move(roots), std::move(triangles));
 }
 
-QVector<QSSGMeshBVHTriangle *> QSSGMeshBVHBuilder::calculateTriangleBounds(quint32 indexOffset, quint32 indexCount) const
+void QSSGMeshBVHBuilder::calculateTriangleBounds(quint32 indexOffset, quint32 indexCount)
 {
-    QVector<QSSGMeshBVHTriangle *> triangleBounds;
     const quint32 triangleCount = indexCount / 3;
+    m_triangles.resize(triangleCount);
+    m_triangleBounds.resize(triangleCount);
+    m_triangleCentroids.resize(triangleCount);
 
     for (quint32 i = 0; i < triangleCount; ++i) {
         // Get the indices for the triangle
@@ -147,21 +170,22 @@ QVector<QSSGMeshBVHTriangle *> QSSGMeshBVHBuilder::calculateTriangleBounds(quint
             index3 = getIndexBufferValue(triangleIndex + 2);
         }
 
-        QSSGMeshBVHTriangle *triangle = new QSSGMeshBVHTriangle();
-
-        triangle->vertex1 = getVertexBufferValuePosition(index1);
-        triangle->vertex2 = getVertexBufferValuePosition(index2);
-        triangle->vertex3 = getVertexBufferValuePosition(index3);
-        triangle->uvCoord1 = getVertexBufferValueUV(index1);
-        triangle->uvCoord2 = getVertexBufferValueUV(index2);
-        triangle->uvCoord3 = getVertexBufferValueUV(index3);
-
-        triangle->bounds.include(triangle->vertex1);
-        triangle->bounds.include(triangle->vertex2);
-        triangle->bounds.include(triangle->vertex3);
-        triangleBounds.append(triangle);
+        QSSGMeshBVHTriangle &triangle = m_triangles[i];
+
+        triangle.vertex1 = getVertexBufferValuePosition(index1);
+        triangle.vertex2 = getVertexBufferValuePosition(index2);
+        triangle.vertex3 = getVertexBufferValuePosition(index3);
+        triangle.uvCoord1 = getVertexBufferValueUV(index1);
+        triangle.uvCoord2 = getVertexBufferValueUV(index2);
+        triangle.uvCoord3 = getVertexBufferValueUV(index3);
+
+        QSSGBounds3 &bounds = m_triangleBounds[i];
+        bounds.setEmpty();
+        bounds.include(triangle.vertex1);
+        bounds.include(triangle.vertex2);
+        bounds.include(triangle.vertex3);
+        m_triangleCentroids[i] = bounds.center();
     }
-    return triangleBounds;
 }
 
 quint32 QSSGMeshBVHBuilder::getIndexBufferValue(quint32 index) const
@@ -205,144 +229,170 @@ QVector2D QSSGMeshBVHBuilder::getVertexBufferValueUV(quint32 index) const
     return *uv;
 }
 
-QSSGMeshBVHNode *QSSGMeshBVHBuilder::splitNode(QSSGMeshBVHNode *node, quint32 offset, quint32 count, quint32 depth)
+int QSSGMeshBVHBuilder::splitNode(QVector<QSSGMeshBVHNode> &nodes, quint32 offset, quint32 count, quint32 depth)
 {
+    // Do not keep references into nodes around, it grows while recursing.
+    const int nodeIndex = int(nodes.size());
+    nodes.append(QSSGMeshBVHNode());
+
+    QSSGBounds3 centroidBounds;
+    for (quint32 i = offset; i < offset + count; ++i)
+        centroidBounds.include(m_triangleCentroids.at(m_triangleOrder.at(i)));
+    const QSSGBounds3 bounds = getBounds(offset, count);
+    nodes[nodeIndex].boundingData = bounds;
+
+    const auto makeLeaf = [&nodes, nodeIndex, offset, count]() {
+        nodes[nodeIndex].offset = count ? int(offset) : -1;
+        nodes[nodeIndex].count = int(count);
+        return nodeIndex;
+    };
+
     // Force a leaf node if the there are too few triangles or the tree depth
     // has exceeded the maximum depth
-    if (count < m_maxLeafTriangles || depth >= m_maxTreeDepth) {
-        node->offset = offset;
-        node->count = count;
-        return node;
-    }
+    if (count <= 2 || depth >= m_maxTreeDepth)
+        return makeLeaf();
 
     // Determine where to split the current bounds
-    const QSSGMeshBVHBuilder::Split split = getOptimalSplit(node->boundingData, offset, count);
-    // Really this shouldn't happen unless there is invalid bounding data, but if that
-    // that does happen make this a leaf node.
-    if (split.axis == QSSGMeshBVHBuilder::Axis::None) {
-        node->offset = offset;
-        node->count = count;
-        return node;
-    }
-
-    // Create the split by sorting the values in m_triangleBounds between
-    // offset - count based on the split axis and position. The returned offset
+    const QSSGMeshBVHBuilder::Split split = getOptimalSplit(bounds, centroidBounds, offset, count);
+    // No split when all the centroids are in the same spot, or when testing
+    // all the triangles is expected to be cheaper than descending further.
+    if (split.axis < 0 || (count <= m_maxLeafTriangles && split.cost >= float(count)))
+        return makeLeaf();
+
+    // Create the split by sorting the values in m_triangleOrder between
+    // offset - count based on the split axis and bin. The returned offset
     // will determine which values go into the left and right nodes.
-    const quint32 splitOffset = partition(offset, count, split);
-
-    // Create the leaf nodes
-    if (splitOffset == offset || splitOffset == (offset + count)) {
-        // If the split is at the start or end, this is a leaf node now
-        // because there is no further branches necessary.
-        node->offset = offset;
-        node->count = count;
+    const quint32 splitOffset = partition(offset, count, split, centroidBounds);
+    if (splitOffset == offset || splitOffset == (offset + count))
+        return makeLeaf();
+
+    const quint32 leftCount = splitOffset - offset;
+    const quint32 rightCount = offset + count - splitOffset;
+
+    // Both halves work on disjoint ranges of m_triangleOrder, so the right
+    // one can be built on another thread into a node list of its own. Child
+    // offsets are relative, which means that list can be appended as is.
+    QVector<QSSGMeshBVHNode> rightNodes;
+    QSemaphore rightDone;
+    const bool rightInParallel = m_threadPool && rightCount >= ParallelBuildTriangleCount
+            && m_threadPool->tryStart([this, &rightNodes, &rightDone, splitOffset, rightCount, depth] {
+                   splitNode(rightNodes, splitOffset, rightCount, depth + 1);
+                   rightDone.release();
+               });
+
+    // The left node directly follows this one
+    splitNode(nodes, offset, leftCount, depth + 1);
+    int rightIndex;
+    if (rightInParallel) {
+        rightDone.acquire();
+        rightIndex = int(nodes.size());
+        nodes.append(rightNodes);
     } else {
-        // Create the Left Node
-        node->left = new QSSGMeshBVHNode();
-        const quint32 leftOffset = offset;
-        const quint32 leftCount = splitOffset - offset;
-        node->left->boundingData = getBounds(leftOffset, leftCount);
-        node->left = splitNode(node->left, leftOffset, leftCount, depth + 1);
-
-        // Create the Right Node
-        node->right = new QSSGMeshBVHNode();
-        const quint32 rightOffset = splitOffset;
-        const quint32 rightCount = count - leftCount;
-        node->right->boundingData = getBounds(rightOffset, rightCount);
-        node->right = splitNode(node->right, rightOffset, rightCount, depth + 1);
+        rightIndex = splitNode(nodes, splitOffset, rightCount, depth + 1);
     }
-
-    return node;
+    nodes[nodeIndex].offset = rightIndex - nodeIndex;
+    nodes[nodeIndex].count = 0;
+    return nodeIndex;
 }
 
 QSSGBounds3 QSSGMeshBVHBuilder::getBounds(quint32 offset, quint32 count) const
 {
     QSSGBounds3 totalBounds;
 
-    for (quint32 i = 0; i < count; ++i) {
-        QSSGBounds3 bounds = m_triangleBounds[i + offset]->bounds;
-        totalBounds.include(bounds);
-    }
+    for (quint32 i = 0; i < count; ++i)
+        totalBounds.include(m_triangleBounds.at(m_triangleOrder.at(i + offset)));
     return totalBounds;
 }
 
-QSSGMeshBVHBuilder::Split QSSGMeshBVHBuilder::getOptimalSplit(const QSSGBounds3 &nodeBounds, quint32 offset, quint32 count) const
+static inline float surfaceArea(const QSSGBounds3 &bounds)
 {
-    QSSGMeshBVHBuilder::Split split;
-    split.axis = getLongestDimension(nodeBounds);
-    split.pos = 0.f;
-
-    if (split.axis != Axis::None)
-        split.pos = getAverageValue(offset, count, split.axis);
+    const QVector3D d = bounds.maximum - bounds.minimum;
+    return 2.0f * (d.x() * d.y() + d.y() * d.z() + d.z() * d.x());
+}
 
-    return split;
+int QSSGMeshBVHBuilder::binIndex(float centroid, float centroidMin, float binScale)
+{
+    return qBound(0, int((centroid - centroidMin) * binScale), SahBinCount - 1);
 }
 
-QSSGMeshBVHBuilder::Axis QSSGMeshBVHBuilder::getLongestDimension(const QSSGBounds3 &nodeBounds)
+// Binned surface area heuristic: the cost of a split is the cost of one more
+// traversal step plus the triangle counts on each side, weighted by the
+// probability of a ray hitting that side, that is its relative surface area.
+QSSGMeshBVHBuilder::Split QSSGMeshBVHBuilder::getOptimalSplit(const QSSGBounds3 &nodeBounds,
+                                                              const QSSGBounds3 &centroidBounds,
+                                                              quint32 offset,
+                                                              quint32 count) const
 {
-    QSSGMeshBVHBuilder::Axis axis = Axis::None;
-    float largestDistance = std::numeric_limits<float>::min();
+    static constexpr float traversalCost = 1.0f;
+
+    QSSGMeshBVHBuilder::Split best;
+    best.cost = std::numeric_limits<float>::max();
 
     if (!nodeBounds.isFinite() || nodeBounds.isEmpty())
-        return axis;
+        return best;
+
+    const float nodeArea = surfaceArea(nodeBounds);
+    const float invNodeArea = nodeArea > 0.0f ? 1.0f / nodeArea : 0.0f;
+
+    for (int axis = 0; axis < 3; ++axis) {
+        const float centroidMin = centroidBounds.minimum[axis];
+        const float extent = centroidBounds.maximum[axis] - centroidMin;
+        if (!(extent > 0.0f))
+            continue;
+        const float binScale = SahBinCount / extent;
+
+        QSSGBounds3 binBounds[SahBinCount];
+        quint32 binCounts[SahBinCount] = {};
+        for (quint32 i = offset; i < offset + count; ++i) {
+            const quint32 triangleIndex = m_triangleOrder.at(i);
+            const int bin = binIndex(m_triangleCentroids.at(triangleIndex)[axis], centroidMin, binScale);
+            ++binCounts[bin];
+            binBounds[bin].include(m_triangleBounds.at(triangleIndex));
+        }
 
-    const QVector3D delta = nodeBounds.maximum - nodeBounds.minimum;
+        // Sweep from the right to get the area and count on the right side
+        // of every bin boundary, then evaluate the boundaries from the left.
+        float rightAreas[SahBinCount];
+        quint32 rightCounts[SahBinCount];
+        QSSGBounds3 rightBounds;
+        quint32 rightCount = 0;
+        for (int bin = SahBinCount - 1; bin > 0; --bin) {
+            rightBounds.include(binBounds[bin]);
+            rightCount += binCounts[bin];
+            rightAreas[bin] = rightCount ? surfaceArea(rightBounds) : 0.0f;
+            rightCounts[bin] = rightCount;
+        }
 
-    if (delta.x() > largestDistance) {
-        axis = Axis::X;
-        largestDistance = delta.x();
-    }
-    if (delta.y() > largestDistance) {
-        axis = Axis::Y;
-        largestDistance = delta.y();
+        QSSGBounds3 leftBounds;
+        quint32 leftCount = 0;
+        for (int bin = 1; bin < SahBinCount; ++bin) {
+            leftBounds.include(binBounds[bin - 1]);
+            leftCount += binCounts[bin - 1];
+            if (leftCount == 0 || rightCounts[bin] == 0)
+                continue;
+            const float cost = traversalCost
+                    + (surfaceArea(leftBounds) * leftCount + rightAreas[bin] * rightCounts[bin]) * invNodeArea;
+            if (cost < best.cost) {
+                best.axis = axis;
+                best.bin = bin;
+                best.cost = cost;
+            }
+        }
     }
-    if (delta.z() > largestDistance)
-        axis = Axis::Z;
-
-    return axis;
-}
-
-// Get the average values of triangles for a given axis
-float QSSGMeshBVHBuilder::getAverageValue(quint32 offset, quint32 count, QSSGMeshBVHBuilder::Axis axis) const
-{
-    float average = 0;
-
-    Q_ASSERT(axis != Axis::None);
-    Q_ASSERT(count != 0);
 
-    for (quint32 i = 0; i < count; ++i)
-        average += m_triangleBounds[i + offset]->bounds.center(int(axis));
-
-    return average / count;
+    return best;
 }
 
-quint32 QSSGMeshBVHBuilder::partition(quint32 offset, quint32 count, const QSSGMeshBVHBuilder::Split &split)
+quint32 QSSGMeshBVHBuilder::partition(quint32 offset, quint32 count, const Split &split, const QSSGBounds3 &centroidBounds)
 {
-    int left = offset;
-    int right = offset + count - 1;
-    const float pos = split.pos;
-    const int axis = int(split.axis);
-
-    while (true) {
-        while (left <= right && m_triangleBounds[left]->bounds.center()[axis] < pos)
-            left++;
-
-        while (left <= right && m_triangleBounds[right]->bounds.center()[axis] >= pos)
-            right--;
-
-        if (left < right) {
-            // Swap triangleBounds at left and right
-            auto temp = m_triangleBounds[left];
-            m_triangleBounds[left] = m_triangleBounds[right];
-            m_triangleBounds[right] = temp;
-
-            left++;
-            right--;
-        } else {
-            return left;
-        }
-    }
-    Q_UNREACHABLE();
+    const int axis = split.axis;
+    const float centroidMin = centroidBounds.minimum[axis];
+    const float binScale = SahBinCount / (centroidBounds.maximum[axis] - centroidMin);
+    const auto begin = m_triangleOrder.begin() + offset;
+    const auto middle = std::partition(begin, begin + count, [&](quint32 triangleIndex) {
+        return binIndex(m_triangleCentroids.at(triangleIndex)[axis], centroidMin, binScale) < split.bin;
+    });
+    return offset + quint32(middle - begin);
 }
 
 QT_END_NAMESPACE
@@ -46,6 +46,8 @@
 
 QT_BEGIN_NAMESPACE
 
+class QThreadPool;
+
 class Q_QUICK3DUTILS_EXPORT QSSGMeshBVHBuilder
 {
 public:
@@ -59,32 +61,36 @@ public:
                        const QByteArray &indexBuffer = QByteArray(),
                        QSSGRenderComponentType indexBufferType = QSSGRenderComponentType::Integer32);
 
+    // When set, large subtrees are built in parallel on the pool. Subtrees
+    // are only handed to the pool when it has an idle thread, so this is
+    // safe to use from a job that runs on the same pool.
+    void setThreadPool(QThreadPool *pool) { m_threadPool = pool; }
+
     QSSGMeshBVH* buildTree();
 
 private:
-    enum class Axis
-    {
-        None = -1,
-        X = 0,
-        Y = 1,
-        Z = 2
-    };
+    // Surface area heuristic, evaluated at the boundaries of this many
+    // equally sized bins along each axis.
+    static constexpr int SahBinCount = 16;
+    // Subtrees with fewer triangles than this are not worth a task.
+    static constexpr quint32 ParallelBuildTriangleCount = 4096;
+
     struct Split {
-        Axis axis;
-        float pos;
+        int axis = -1;
+        int bin = 0; // triangles in bins [0, bin) go left
+        float cost = 0.0f;
     };
 
-    QVector<QSSGMeshBVHTriangle*> calculateTriangleBounds(quint32 indexOffset, quint32 indexCount) const;
+    void calculateTriangleBounds(quint32 indexOffset, quint32 indexCount);
     quint32 getIndexBufferValue(quint32 index) const;
     QVector3D getVertexBufferValuePosition(quint32 index) const;
     QVector2D getVertexBufferValueUV(quint32 index) const;
 
-    QSSGMeshBVHNode *splitNode(QSSGMeshBVHNode *node, quint32 offset, quint32 count, quint32 depth = 0);
+    int splitNode(QVector<QSSGMeshBVHNode> &nodes, quint32 offset, quint32 count, quint32 depth = 0);
     QSSGBounds3 getBounds(quint32 offset, quint32 count) const;
-    Split getOptimalSplit(const QSSGBounds3 &nodeBounds, quint32 offset, quint32 count) const;
-    static Axis getLongestDimension(const QSSGBounds3 &nodeBounds);
-    float getAverageValue(quint32 offset, quint32 count, Axis axis) const;
-    quint32 partition(quint32 offset, quint32 count, const Split &split);
+    Split getOptimalSplit(const QSSGBounds3 &nodeBounds, const QSSGBounds3 &centroidBounds, quint32 offset, quint32 count) const;
+    static int binIndex(float centroid, float centroidMin, float binScale);
+    quint32 partition(quint32 offset, quint32 count, const Split &split, const QSSGBounds3 &centroidBounds);
 
     QSSGMesh::Mesh m_mesh;
     QSSGRenderComponentType m_indexBufferComponentType;
@@ -97,11 +103,16 @@ private:
     quint32 m_vertexUVOffset;
     bool m_hasIndexBuffer = true;
 
-
-    QVector<QSSGMeshBVHTriangle *> m_triangleBounds;
-    QVector<QSSGMeshBVHNode *> m_roots;
+    // Per triangle build data, in index buffer order. m_triangleOrder is
+    // what gets partitioned while building.
+    QVector<QSSGMeshBVHTriangle> m_triangles;
+    QVector<QSSGBounds3> m_triangleBounds;
+    QVector<QVector3D> m_triangleCentroids;
+    QVector<quint32> m_triangleOrder;
+    QVector<QSSGMeshBVHNode> m_nodes;
     quint32 m_maxTreeDepth = 40;
     quint32 m_maxLeafTriangles = 10;
+    QThreadPool *m_threadPool = nullptr;
 };
 
 QT_END_NAMESPACE
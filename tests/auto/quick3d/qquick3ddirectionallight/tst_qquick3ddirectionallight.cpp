@@ -110,6 +110,32 @@ void tst_QQuick3DDirectionalLight::testProperties()
         QCOMPARE(light.shadowMapQuality(), shadowMapQuality);
     }
 
+    QCOMPARE(node->m_cascadeCount, 1u);
+    light.setCascadeCount(3);
+    node = static_cast<QSSGRenderLight *>(light.updateSpatialNode(node));
+    QCOMPARE(node->m_cascadeCount, 3u);
+    QCOMPARE(light.cascadeCount(), 3);
+    light.setCascadeCount(10);
+    QCOMPARE(light.cascadeCount(), 4);
+    light.setCascadeCount(0);
+    QCOMPARE(light.cascadeCount(), 1);
+
+    const float cascadeSplitBlend = 0.25f;
+    light.setCascadeSplitBlend(cascadeSplitBlend);
+    node = static_cast<QSSGRenderLight *>(light.updateSpatialNode(node));
+    QCOMPARE(cascadeSplitBlend, node->m_cascadeSplitBlend);
+    QCOMPARE(light.cascadeSplitBlend(), node->m_cascadeSplitBlend);
+    light.setCascadeSplitBlend(2.0f);
+    QCOMPARE(light.cascadeSplitBlend(), 1.0f);
+
+    const float cascadeResolutionScale = 0.5f;
+    light.setCascadeResolutionScale(cascadeResolutionScale);
+    node = static_cast<QSSGRenderLight *>(light.updateSpatialNode(node));
+    QCOMPARE(cascadeResolutionScale, node->m_cascadeResolutionScale);
+    QCOMPARE(light.cascadeResolutionScale(), node->m_cascadeResolutionScale);
+    light.setCascadeResolutionScale(0.0f);
+    QCOMPARE(light.cascadeResolutionScale(), 0.125f);
+
     light.setCastsShadow(true);
     node = static_cast<QSSGRenderLight *>(light.updateSpatialNode(node));
     QVERIFY(node->m_castShadow);
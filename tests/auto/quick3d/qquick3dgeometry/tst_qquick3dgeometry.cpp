@@ -50,6 +50,7 @@ private slots:
     void testGeometry();
     void testGeometry2();
     void testPartialUpdate();
+    void testPartialUpdateNode();
     void testGeometrySubset();
 };
 
@@ -278,6 +279,67 @@ void tst_QQuick3DGeometry::testPartialUpdate()
     QCOMPARE(geom.indexData().mid(95), smallData.left(5));
 }
 
+void tst_QQuick3DGeometry::testPartialUpdateNode()
+{
+    Geometry geom;
+    geom.setStride(12);
+    geom.addAttribute(QQuick3DGeometry::Attribute::PositionSemantic, 0, QQuick3DGeometry::Attribute::F32Type);
+    geom.setVertexData(QByteArray(120, 'a'));
+    QCOMPARE(geom.bufferUsage(), QQuick3DGeometry::BufferUsage::Static);
+
+    auto node = static_cast<QSSGRenderGeometry *>(geom.updateSpatialNode(nullptr));
+    QVERIFY(node);
+    QVERIFY(!node->isDynamic());
+    const uint32_t baseGenerationId = node->dirtyRangesBaseGenerationId();
+    QCOMPARE(node->generationId(), baseGenerationId);
+    QVERIFY(node->dirtyRanges().isEmpty());
+
+    // Only the contents change: the ranges are listed, the base stays
+    QByteArray smallData(12, 'b');
+    geom.setVertexData(24, smallData);
+    geom.updateSpatialNode(node);
+    QCOMPARE(node->dirtyRangesBaseGenerationId(), baseGenerationId);
+    QVERIFY(node->generationId() != baseGenerationId);
+    QCOMPARE(node->dirtyRanges().count(), 1);
+    QCOMPARE(node->dirtyRanges().first().offset, 24u);
+    QCOMPARE(node->dirtyRanges().first().size, 12u);
+    QVERIFY(!node->dirtyRanges().first().indexData);
+    QCOMPARE(node->vertexBuffer().mid(24, 12), smallData);
+
+    // Replacing the data with the same size is a range as well
+    geom.setVertexData(QByteArray(120, 'c'));
+    geom.updateSpatialNode(node);
+    QCOMPARE(node->dirtyRangesBaseGenerationId(), baseGenerationId);
+    QCOMPARE(node->dirtyRanges().count(), 2);
+    QCOMPARE(node->dirtyRanges().last().offset, 0u);
+    QCOMPARE(node->dirtyRanges().last().size, 120u);
+
+    // Bounds do not affect the buffers, but the implicit subset follows them
+    const uint32_t generationId = node->generationId();
+    geom.setVertexData(0, smallData);
+    geom.setBounds(QVector3D(-1, -1, -1), QVector3D(1, 1, 1));
+    geom.updateSpatialNode(node);
+    QCOMPARE(node->dirtyRangesBaseGenerationId(), baseGenerationId);
+    QVERIFY(node->generationId() != generationId);
+    QCOMPARE(node->meshData().m_subsets.count(), 1);
+    QCOMPARE(node->meshData().m_subsets.first().bounds.min, QVector3D(-1, -1, -1));
+    QCOMPARE(node->meshData().m_subsets.first().bounds.max, QVector3D(1, 1, 1));
+
+    // A different size needs new buffers
+    geom.setVertexData(QByteArray(240, 'd'));
+    geom.updateSpatialNode(node);
+    QVERIFY(node->dirtyRangesBaseGenerationId() != baseGenerationId);
+    QCOMPARE(node->generationId(), node->dirtyRangesBaseGenerationId());
+    QVERIFY(node->dirtyRanges().isEmpty());
+
+    geom.setBufferUsage(QQuick3DGeometry::BufferUsage::Dynamic);
+    QCOMPARE(geom.bufferUsage(), QQuick3DGeometry::BufferUsage::Dynamic);
+    geom.updateSpatialNode(node);
+    QVERIFY(node->isDynamic());
+
+    delete node;
+}
+
 void tst_QQuick3DGeometry::testGeometrySubset()
 {
     Geometry geom;
@@ -48,6 +48,7 @@ class tst_QQuick3DTexture : public QObject
 
 private slots:
     void testSetSource();
+    void testAsynchronous();
     void testSetSourceItem();
     void testMappingAndTilingModes();
     void testSamplerFilteringModes();
@@ -80,6 +81,37 @@ void tst_QQuick3DTexture::testSetSource()
     QCOMPARE(spy.count(), 1);
 }
 
+void tst_QQuick3DTexture::testAsynchronous()
+{
+    Texture texture;
+    std::unique_ptr<QSSGRenderImage> node;
+
+    QSignalSpy statusSpy(&texture, SIGNAL(statusChanged()));
+    QCOMPARE(texture.status(), QQuick3DTexture::Null);
+    QVERIFY(!texture.asynchronous());
+
+    texture.setAsynchronous(true);
+    QVERIFY(texture.asynchronous());
+    texture.setSource(QUrl(QString::fromLatin1("file:path/to/resource")));
+    QCOMPARE(texture.status(), QQuick3DTexture::Loading);
+    QCOMPARE(statusSpy.count(), 1);
+
+    node.reset(static_cast<QSSGRenderImage *>(texture.updateSpatialNode(nullptr)));
+    QVERIFY(node->m_asyncLoad);
+    QVERIFY(node->m_loadStatusPending);
+
+    // Reported by the renderer once the image is loaded
+    texture.setStatus(QQuick3DTexture::Ready);
+    QCOMPARE(texture.status(), QQuick3DTexture::Ready);
+    QCOMPARE(statusSpy.count(), 2);
+
+    texture.setSource(QUrl());
+    QCOMPARE(texture.status(), QQuick3DTexture::Null);
+    QCOMPARE(statusSpy.count(), 3);
+    node.reset(static_cast<QSSGRenderImage *>(texture.updateSpatialNode(nullptr)));
+    QVERIFY(!node->m_loadStatusPending);
+}
+
 void tst_QQuick3DTexture::testSetSourceItem()
 {
     Texture texture;
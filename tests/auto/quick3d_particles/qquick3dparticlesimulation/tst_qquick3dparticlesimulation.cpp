@@ -0,0 +1,322 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QTest>
+#include <QScopedPointer>
+
+#include <QtQuick3DParticles/private/qquick3dparticlespriteparticle_p.h>
+#include <QtQuick3DParticles/private/qquick3dparticlesystem_p.h>
+#include <QtQuick3DParticles/private/qquick3dparticleemitter_p.h>
+#include <QtQuick3DParticles/private/qquick3dparticlevectordirection_p.h>
+#include <QtQuick3DParticles/private/qquick3dparticlegravity_p.h>
+#include <QtQuick3DParticles/private/qquick3dparticleattractor_p.h>
+#include <QtQuick3DParticles/private/qquick3dparticlewander_p.h>
+#include <QtQuick3DParticles/private/qquick3dparticlepointrotator_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrenderparticles_p.h>
+
+// Compares the particles simulated by QSSGParticleSimulation::simulate(), the
+// fallback of the renderer without compute shaders, with the particles the
+// affectors produce on the CPU.
+class tst_QQuick3DParticleSimulation : public QObject
+{
+    Q_OBJECT
+
+    class TestSystem : public QQuick3DParticleSystem
+    {
+    public:
+        TestSystem(QQuick3DNode *parent = nullptr)
+            : QQuick3DParticleSystem(parent)
+        {
+
+        }
+        void init()
+        {
+            QQuick3DParticleSystem::componentComplete();
+        }
+    };
+
+    class SpriteParticle : public QQuick3DParticleSpriteParticle
+    {
+    public:
+        SpriteParticle(QQuick3DNode *parent = nullptr)
+            : QQuick3DParticleSpriteParticle(parent)
+        {
+
+        }
+        void init()
+        {
+            QQuick3DParticleSpriteParticle::componentComplete();
+        }
+    };
+
+    // The sprite particle updates its render node from a private child node
+    // of the system, which the scene manager would normally sync
+    struct NodeAccess : public QQuick3DNode
+    {
+        static QSSGRenderGraphObject *update(QQuick3DNode *node, QSSGRenderGraphObject *spatialNode)
+        {
+            return (node->*&NodeAccess::updateSpatialNode)(spatialNode);
+        }
+    };
+
+    enum AffectorSetup {
+        None = 0,
+        Gravity = 0x1,
+        Attractor = 0x2,
+        Wander = 0x4,
+        PointRotator = 0x8,
+        All = Gravity | Attractor | Wander | PointRotator
+    };
+
+    struct Update
+    {
+        float time = 0.0f;
+        QVector<QSSGParticleSimple> particles;
+        QVector<QSSGParticleEmitData> emitData;
+    };
+
+    static QVector<Update> runSystem(int setup, bool simulated, int *rangeUploads = nullptr);
+    static QVector<QSSGParticleSimple> particles(const QSSGParticleBuffer &buffer);
+
+private slots:
+    void cleanup();
+    void testSimulate_data();
+    void testSimulate();
+};
+
+void tst_QQuick3DParticleSimulation::cleanup()
+{
+    QSSGParticleSimulation::setRequested(qEnvironmentVariableIntValue("QT_QUICK3D_GPU_PARTICLES"));
+}
+
+QVector<QSSGParticleSimple> tst_QQuick3DParticleSimulation::particles(const QSSGParticleBuffer &buffer)
+{
+    QVector<QSSGParticleSimple> result;
+    const int pps = buffer.particlesPerSlice();
+    const char *src = buffer.pointer();
+    for (int i = 0; i < buffer.particleCount(); ++i)
+        result.append(*(reinterpret_cast<const QSSGParticleSimple *>(src + (i / pps) * buffer.sliceStride()) + (i % pps)));
+    return result;
+}
+
+// Updates a seeded system either with the affectors or with the simulation
+// and returns the particles of every update. With the simulation, also checks
+// that uploading the dirty ranges of each update keeps a copy of the emit
+// data in sync, like the renderer does.
+QVector<tst_QQuick3DParticleSimulation::Update> tst_QQuick3DParticleSimulation::runSystem(int setup, bool simulated, int *rangeUploads)
+{
+    QSSGParticleSimulation::setRequested(simulated);
+
+    QScopedPointer<TestSystem> system(new TestSystem());
+    system->setRunning(false);
+    system->setUseRandomSeed(false);
+    system->setSeed(4321);
+
+    SpriteParticle *particle = new SpriteParticle(system.data());
+    // Fewer slots than emitted particles, so that the slots get reused
+    particle->setMaxAmount(150);
+    particle->setColor(QColor(200, 120, 60, 230));
+    particle->setColorVariation(QVector4D(0.2f, 0.1f, 0.3f, 0.1f));
+    particle->setFadeInDuration(200);
+    particle->setFadeOutDuration(300);
+    particle->setFadeOutEffect(QQuick3DParticle::FadeScale);
+    particle->setOffsetX(0.5f);
+
+    QQuick3DParticleVectorDirection *velocity = new QQuick3DParticleVectorDirection(system.data());
+    velocity->setDirection(QVector3D(0.0f, 100.0f, 0.0f));
+    velocity->setDirectionVariation(QVector3D(50.0f, 20.0f, 50.0f));
+
+    QQuick3DParticleEmitter *emitter = new QQuick3DParticleEmitter(system.data());
+    emitter->setSystem(system.data());
+    emitter->setParticle(particle);
+    emitter->setVelocity(velocity);
+    emitter->setEmitRate(100.0f);
+    emitter->setLifeSpan(1000);
+    emitter->setLifeSpanVariation(300);
+    emitter->setParticleScale(1.0f);
+    emitter->setParticleEndScale(2.0f);
+    emitter->setParticleRotationVelocity(QVector3D(0.0f, 0.0f, 90.0f));
+
+    if (setup & Gravity) {
+        auto *gravity = new QQuick3DParticleGravity(system.data());
+        gravity->setSystem(system.data());
+        gravity->setMagnitude(150.0f);
+        gravity->setDirection(QVector3D(1.0f, -2.0f, 0.5f));
+    }
+    if (setup & Attractor) {
+        auto *attractor = new QQuick3DParticleAttractor(system.data());
+        attractor->setSystem(system.data());
+        attractor->setPosition(QVector3D(10.0f, 80.0f, -5.0f));
+        attractor->setDuration(1500);
+        attractor->setDurationVariation(400);
+        attractor->setPositionVariation(QVector3D(5.0f, 0.0f, 2.0f));
+    }
+    if (setup & Wander) {
+        auto *wander = new QQuick3DParticleWander(system.data());
+        wander->setSystem(system.data());
+        wander->setGlobalAmount(QVector3D(10.0f, 10.0f, 10.0f));
+        wander->setGlobalPace(QVector3D(0.5f, 0.5f, 0.5f));
+        wander->setUniqueAmount(QVector3D(20.0f, 20.0f, 20.0f));
+        wander->setUniquePace(QVector3D(1.0f, 1.0f, 1.0f));
+        wander->setUniqueAmountVariation(0.5f);
+        wander->setUniquePaceVariation(0.5f);
+    }
+    if (setup & PointRotator) {
+        auto *rotator = new QQuick3DParticlePointRotator(system.data());
+        rotator->setSystem(system.data());
+        rotator->setMagnitude(75.0f);
+        rotator->setDirection(QVector3D(0.3f, 1.0f, -0.6f));
+        rotator->setPivotPoint(QVector3D(2.0f, -1.0f, 0.5f));
+    }
+
+    particle->init();
+    system->init();
+
+    QVector<Update> updates;
+    QSSGRenderGraphObject *node = nullptr;
+    QVector<QSSGParticleEmitData> uploaded;
+    int uploadedSerial = 0;
+    for (int time = 50; time <= 3000; time += 50) {
+        system->updateCurrentTime(time);
+
+        // The node the sprite particle creates for its only emitter
+        QQuick3DNode *updateNode = nullptr;
+        for (QQuick3DNode *child : system->findChildren<QQuick3DNode *>(QString(), Qt::FindDirectChildrenOnly)) {
+            if (child->metaObject() == &QQuick3DNode::staticMetaObject)
+                updateNode = child;
+        }
+        if (!updateNode)
+            continue;
+        node = NodeAccess::update(updateNode, node);
+        auto *particles = static_cast<QSSGRenderParticles *>(node);
+        const QSSGParticleSimulation &sim = particles->m_simulation;
+        if (sim.enabled != simulated) {
+            qWarning("The particles were %s simulated", simulated ? "not" : "unexpectedly");
+            break;
+        }
+
+        Update update;
+        update.time = time / 1000.0f;
+        if (simulated) {
+            QSSGParticleBuffer buffer;
+            buffer.resize(particles->m_particleBuffer.particleCount());
+            sim.simulate(buffer);
+            update.particles = tst_QQuick3DParticleSimulation::particles(buffer);
+            update.emitData = sim.emitData;
+
+            if (uploadedSerial < sim.dirtyRangesBaseSerial) {
+                uploaded = sim.emitData;
+            } else {
+                for (const QSSGParticleSimulation::Range &range : sim.dirtyRanges) {
+                    if (range.serial <= uploadedSerial)
+                        continue;
+                    for (int i = range.begin; i < range.end; ++i)
+                        uploaded[i] = sim.emitData.at(i);
+                    if (rangeUploads)
+                        ++*rangeUploads;
+                }
+            }
+            uploadedSerial = sim.serial;
+            if (uploaded.size() != sim.emitData.size()
+                    || memcmp(uploaded.constData(), sim.emitData.constData(), uploaded.size() * sizeof(QSSGParticleEmitData))) {
+                qWarning("The emit data uploaded by ranges differs at %d ms", time);
+                break;
+            }
+        } else {
+            update.particles = tst_QQuick3DParticleSimulation::particles(particles->m_particleBuffer);
+        }
+        updates.append(update);
+    }
+
+    delete node;
+    return updates;
+}
+
+void tst_QQuick3DParticleSimulation::testSimulate_data()
+{
+    QTest::addColumn<int>("setup");
+    QTest::newRow("none") << int(None);
+    QTest::newRow("gravity") << int(Gravity);
+    QTest::newRow("attractor") << int(Attractor);
+    QTest::newRow("wander") << int(Wander);
+    QTest::newRow("pointrotator") << int(PointRotator);
+    QTest::newRow("all") << int(All);
+}
+
+void tst_QQuick3DParticleSimulation::testSimulate()
+{
+    QFETCH(int, setup);
+
+    int rangeUploads = 0;
+    const QVector<Update> cpu = runSystem(setup, false);
+    const QVector<Update> simulated = runSystem(setup, true, &rangeUploads);
+    QCOMPARE(simulated.size(), cpu.size());
+    QVERIFY(!cpu.isEmpty());
+    // Most of the updates only upload the newly emitted slots
+    QVERIFY(rangeUploads > cpu.size() / 2);
+
+    // The affectors use the same lookup table sine as the simulation, but
+    // integrate in a different order. The CPU path stores the colors as bytes.
+    const auto fuzzyEqual = [](float a, float b, float tolerance) {
+        return qAbs(a - b) <= tolerance * std::max(1.0f, qAbs(a));
+    };
+    const float positionTolerance = 1e-3f;
+    const float colorTolerance = 2.0f / 255.0f;
+
+    int compared = 0;
+    for (int u = 0; u < cpu.size(); ++u) {
+        const Update &c = cpu.at(u);
+        const Update &s = simulated.at(u);
+        // The CPU path packs the particles of the emitter, which with only one
+        // emitter are the slots it has used so far
+        QVERIFY(c.particles.size() <= s.particles.size());
+        for (int i = 0; i < c.particles.size(); ++i) {
+            const QSSGParticleEmitData &e = s.emitData.at(i);
+            // Skip the particles which are born or die right at this time,
+            // the paths may round the comparison differently
+            if (qAbs(c.time - e.startTime) < 1e-4f || qAbs(c.time - e.startTime - e.lifetime) < 1e-4f)
+                continue;
+            const QSSGParticleSimple &cp = c.particles.at(i);
+            const QSSGParticleSimple &sp = s.particles.at(i);
+            const QByteArray where = QByteArray::number(c.time) + " s, slot " + QByteArray::number(i);
+            QVERIFY2((cp.size > 0.0f) == (sp.size > 0.0f), where.constData());
+            if (cp.size == 0.0f)
+                continue;
+            for (int k = 0; k < 3; ++k)
+                QVERIFY2(fuzzyEqual(cp.position[k], sp.position[k], positionTolerance), where.constData());
+            QVERIFY2(fuzzyEqual(cp.size, sp.size, positionTolerance), where.constData());
+            for (int k = 0; k < 4; ++k)
+                QVERIFY2(qAbs(cp.color[k] - sp.color[k]) <= colorTolerance, where.constData());
+            ++compared;
+        }
+    }
+    QVERIFY(compared > 0);
+}
+
+QTEST_APPLESS_MAIN(tst_QQuick3DParticleSimulation)
+#include "tst_qquick3dparticlesimulation.moc"
@@ -30,19 +30,89 @@
 #include <QTest>
 #include <QSignalSpy>
 #include <QScopedPointer>
+#include <QThread>
+#include <QThreadPool>
 
 #include <QtQuick3DParticles/private/qquick3dparticlespriteparticle_p.h>
 #include <QtQuick3DParticles/private/qquick3dparticlemodelparticle_p.h>
 #include <QtQuick3DParticles/private/qquick3dparticlesystem_p.h>
+#include <QtQuick3DParticles/private/qquick3dparticleemitter_p.h>
+#include <QtQuick3DParticles/private/qquick3dparticlevectordirection_p.h>
+#include <QtQuick3DParticles/private/qquick3dparticlegravity_p.h>
+#include <QtQuick3DParticles/private/qquick3dparticlewander_p.h>
+#include <QtQuick3DParticles/private/qquick3dparticlepointrotator_p.h>
+#include <QtQuick3DParticles/private/qquick3dparticleattractor_p.h>
+#include <QtQuick3DParticles/private/qquick3dparticleshape_p.h>
+#include <QtQuick3DParticles/private/qquick3dparticledata_p.h>
+#include <QtQuick3DParticles/private/qquick3dparticlesimd_p.h>
+#include <QtQuick3DUtils/private/qssgutils_p.h>
+#include <QtQuick3D/qquick3dinstancing.h>
 
 
 class tst_QQuick3DParticleSystem : public QObject
 {
     Q_OBJECT
 
+    class TestSystem : public QQuick3DParticleSystem
+    {
+    public:
+        TestSystem(QQuick3DNode *parent = nullptr)
+            : QQuick3DParticleSystem(parent)
+        {
+
+        }
+        void init()
+        {
+            QQuick3DParticleSystem::componentComplete();
+        }
+    };
+
+    class ModelParticle : public QQuick3DParticleModelParticle
+    {
+    public:
+        ModelParticle(QQuick3DNode *parent = nullptr)
+            : QQuick3DParticleModelParticle(parent)
+        {
+
+        }
+        void init()
+        {
+            QQuick3DParticleModelParticle::componentComplete();
+        }
+    };
+
+    // Gives access to what the particle system calls
+    template<typename Affector>
+    class TestAffector : public Affector
+    {
+    public:
+        using Affector::Affector;
+        using Affector::prepareToAffect;
+        using Affector::affectParticle;
+        using Affector::affectParticles;
+    };
+
+    enum AffectorSetup {
+        Gravity,
+        Attractor,
+        AttractorVariation,
+        AttractorShape,
+        AttractorCachedShape,
+        Wander,
+        PointRotator
+    };
+
+    static QList<QByteArray> runSystem(int maxThreadCount);
+    template<typename Affector>
+    static void compareBatched(TestAffector<Affector> *affector);
+
 private slots:
     void testInitialization();
     void testSystem();
+    void testThreadedUpdate();
+    void testAffectParticlesBatched_data();
+    void testAffectParticlesBatched();
+    void testSinBatched();
 };
 
 void tst_QQuick3DParticleSystem::testInitialization()
@@ -92,6 +162,214 @@ void tst_QQuick3DParticleSystem::testSystem()
     delete system;
 }
 
+// Updates a seeded system with enough particles to be split into ranges and
+// returns the instance table of every update
+QList<QByteArray> tst_QQuick3DParticleSystem::runSystem(int maxThreadCount)
+{
+    QThreadPool *threadPool = QThreadPool::globalInstance();
+    const int oldMaxThreadCount = threadPool->maxThreadCount();
+    threadPool->setMaxThreadCount(maxThreadCount);
+
+    QScopedPointer<TestSystem> system(new TestSystem());
+    system->setRunning(false);
+    system->setUseRandomSeed(false);
+    system->setSeed(1234);
+
+    ModelParticle *particle = new ModelParticle(system.data());
+    particle->setMaxAmount(12000);
+
+    QQuick3DParticleVectorDirection *velocity = new QQuick3DParticleVectorDirection(system.data());
+    velocity->setDirection(QVector3D(0.0f, 100.0f, 0.0f));
+    velocity->setDirectionVariation(QVector3D(50.0f, 20.0f, 50.0f));
+
+    QQuick3DParticleEmitter *emitter = new QQuick3DParticleEmitter(system.data());
+    emitter->setSystem(system.data());
+    emitter->setParticle(particle);
+    emitter->setVelocity(velocity);
+    emitter->setEmitRate(10000.0f);
+    emitter->setLifeSpan(2000);
+    emitter->setLifeSpanVariation(500);
+
+    QQuick3DParticleGravity *gravity = new QQuick3DParticleGravity(system.data());
+    gravity->setSystem(system.data());
+    QQuick3DParticleWander *wander = new QQuick3DParticleWander(system.data());
+    wander->setGlobalAmount(QVector3D(10.0f, 10.0f, 10.0f));
+    wander->setGlobalPace(QVector3D(0.5f, 0.5f, 0.5f));
+    wander->setUniqueAmount(QVector3D(20.0f, 20.0f, 20.0f));
+    wander->setUniquePace(QVector3D(1.0f, 1.0f, 1.0f));
+    wander->setUniqueAmountVariation(0.5f);
+    wander->setUniquePaceVariation(0.5f);
+    wander->setSystem(system.data());
+    QQuick3DParticlePointRotator *rotator = new QQuick3DParticlePointRotator(system.data());
+    rotator->setMagnitude(45.0f);
+    rotator->setSystem(system.data());
+
+    particle->init();
+    system->init();
+
+    QList<QByteArray> instances;
+    for (int time = 100; time <= 3000; time += 100) {
+        system->updateCurrentTime(time);
+        instances.append(particle->instanceTable()->instanceBuffer(nullptr));
+    }
+
+    threadPool->setMaxThreadCount(oldMaxThreadCount);
+    return instances;
+}
+
+void tst_QQuick3DParticleSystem::testThreadedUpdate()
+{
+    // With one thread in the pool the particles are updated on the calling
+    // thread only, otherwise the ranges are processed concurrently
+    const QList<QByteArray> serial = runSystem(1);
+    const QList<QByteArray> threaded = runSystem(std::max(4, QThread::idealThreadCount()));
+
+    QCOMPARE(threaded.size(), serial.size());
+    for (int i = 0; i < serial.size(); ++i) {
+        QVERIFY(!serial.at(i).isEmpty());
+        QVERIFY2(threaded.at(i) == serial.at(i), qPrintable(QStringLiteral("update %1 differs").arg(i)));
+    }
+}
+
+// Runs the same particles through affectParticle() and affectParticles() and
+// compares the results. The count is not a multiple of the batch lanes, so
+// that the padding is covered.
+template<typename Affector>
+void tst_QQuick3DParticleSystem::compareBatched(TestAffector<Affector> *affector)
+{
+    affector->prepareToAffect();
+
+    const int count = 11;
+    QVector<QQuick3DParticleData> particleData(count);
+    QVector<QQuick3DParticleDataCurrent> scalar(count);
+    QQuick3DParticleDataBatch batch;
+    batch.reset(count);
+    for (int i = 0; i < count; ++i) {
+        particleData[i].index = i;
+        particleData[i].lifetime = 2.0f + 0.25f * i;
+        scalar[i].position = QVector3D(i, -2.0f * i, 1.0f + 0.5f * i);
+        const float time = 0.1f + 0.25f * i;
+        batch.append(&particleData[i], i, time, time / particleData[i].lifetime, scalar[i]);
+        affector->affectParticle(particleData[i], &scalar[i], time);
+    }
+    batch.finish();
+    affector->affectParticles(batch);
+
+    // Both paths do the same operations in the same order, but the compiler
+    // may fuse multiply-adds in the scalar code
+    const float tolerance = 1e-4f;
+    for (int i = 0; i < count; ++i) {
+        const QQuick3DParticleDataCurrent batched = batch.current(i);
+        QVERIFY2((batched.position - scalar[i].position).length() < tolerance,
+                 qPrintable(QStringLiteral("particle %1: batched (%2, %3, %4), scalar (%5, %6, %7)")
+                            .arg(i).arg(batched.position.x()).arg(batched.position.y()).arg(batched.position.z())
+                            .arg(scalar[i].position.x()).arg(scalar[i].position.y()).arg(scalar[i].position.z())));
+        QCOMPARE(batched.color.a, scalar[i].color.a);
+    }
+}
+
+void tst_QQuick3DParticleSystem::testAffectParticlesBatched_data()
+{
+    QTest::addColumn<int>("setup");
+    QTest::newRow("gravity") << int(Gravity);
+    QTest::newRow("attractor") << int(Attractor);
+    QTest::newRow("attractor with variation") << int(AttractorVariation);
+    QTest::newRow("attractor with shape") << int(AttractorShape);
+    QTest::newRow("attractor with cached shape") << int(AttractorCachedShape);
+    QTest::newRow("wander") << int(Wander);
+    QTest::newRow("point rotator") << int(PointRotator);
+}
+
+void tst_QQuick3DParticleSystem::testAffectParticlesBatched()
+{
+    QFETCH(int, setup);
+
+    QScopedPointer<TestSystem> system(new TestSystem());
+    system->setUseRandomSeed(false);
+    system->setSeed(1234);
+    system->init();
+
+    switch (setup) {
+    case Gravity: {
+        auto *gravity = new TestAffector<QQuick3DParticleGravity>(system.data());
+        gravity->setSystem(system.data());
+        gravity->setMagnitude(150.0f);
+        gravity->setDirection(QVector3D(1.0f, -2.0f, 0.5f));
+        compareBatched(gravity);
+        break;
+    }
+    case Attractor:
+    case AttractorVariation:
+    case AttractorShape:
+    case AttractorCachedShape: {
+        auto *attractor = new TestAffector<QQuick3DParticleAttractor>(system.data());
+        attractor->setSystem(system.data());
+        attractor->setPosition(QVector3D(10.0f, 20.0f, -5.0f));
+        if (setup == AttractorVariation) {
+            // Some of the particles reach the target and get hidden
+            attractor->setDuration(1000);
+            attractor->setDurationVariation(400);
+            attractor->setPositionVariation(QVector3D(5.0f, 0.0f, 2.0f));
+            attractor->setHideAtEnd(true);
+        } else if (setup == AttractorShape || setup == AttractorCachedShape) {
+            auto *shape = new QQuick3DParticleShape(attractor);
+            shape->setType(QQuick3DParticleShape::Sphere);
+            attractor->setShape(shape);
+            attractor->setDurationVariation(300);
+            if (setup == AttractorCachedShape) {
+                // Fewer positions than particles, so that they get reused
+                attractor->setUseCachedPositions(true);
+                attractor->setPositionsAmount(5);
+            } else {
+                attractor->setPositionVariation(QVector3D(1.0f, 2.0f, 3.0f));
+            }
+        }
+        compareBatched(attractor);
+        break;
+    }
+    case Wander: {
+        auto *wander = new TestAffector<QQuick3DParticleWander>(system.data());
+        wander->setSystem(system.data());
+        wander->setGlobalAmount(QVector3D(1.0f, 2.0f, 0.0f));
+        wander->setGlobalPace(QVector3D(0.5f, 1.5f, 1.0f));
+        wander->setGlobalPaceStart(QVector3D(0.2f, 1.0f, 0.0f));
+        wander->setUniqueAmount(QVector3D(3.0f, 0.0f, 1.0f));
+        wander->setUniquePace(QVector3D(1.0f, 1.0f, 2.0f));
+        wander->setUniqueAmountVariation(0.5f);
+        wander->setUniquePaceVariation(0.3f);
+        wander->setFadeInDuration(500);
+        wander->setFadeOutDuration(800);
+        compareBatched(wander);
+        break;
+    }
+    case PointRotator: {
+        auto *rotator = new TestAffector<QQuick3DParticlePointRotator>(system.data());
+        rotator->setSystem(system.data());
+        rotator->setMagnitude(75.0f);
+        rotator->setDirection(QVector3D(0.3f, 1.0f, -0.6f));
+        rotator->setPivotPoint(QVector3D(2.0f, -1.0f, 0.5f));
+        compareBatched(rotator);
+        break;
+    }
+    default:
+        QFAIL("Unknown affector setup");
+    }
+}
+
+void tst_QQuick3DParticleSystem::testSinBatched()
+{
+    // Same table and interpolation as qLookupSin(), up to rounding
+    const int count = 1024;
+    for (int i = 0; i < count; i += 4) {
+        float x[4];
+        float s[4];
+        for (int j = 0; j < 4; ++j)
+            x[j] = (i + j) * float(8.0 * M_PI / count);
+        qpSin(QPFloat4::load(x)).store(s);
+        for (int j = 0; j < 4; ++j)
+            QVERIFY2(qAbs(s[j] - qLookupSin(x[j])) < 1e-6f, qPrintable(QStringLiteral("sin(%1)").arg(x[j])));
+    }
+}
 
 QTEST_APPLESS_MAIN(tst_QQuick3DParticleSystem)
 #include "tst_qquick3dparticlesystem.moc"
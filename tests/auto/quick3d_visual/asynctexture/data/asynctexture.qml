@@ -0,0 +1,26 @@
+import QtQuick
+import QtQuick3D
+
+View3D {
+    width: 64
+    height: 64
+    anchors.fill: parent
+
+    property alias texture: texture
+
+    PerspectiveCamera {
+        z: 600
+    }
+
+    Model {
+        source: "#Rectangle"
+        scale: Qt.vector3d(10, 10, 1)
+        materials: DefaultMaterial {
+            lighting: DefaultMaterial.NoLighting
+            diffuseMap: Texture {
+                id: texture
+                asynchronous: true
+            }
+        }
+    }
+}
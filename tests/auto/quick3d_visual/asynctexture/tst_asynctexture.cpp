@@ -0,0 +1,158 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+
+#include <QTest>
+#include <QTemporaryDir>
+#include <QQuickView>
+
+#include <QtQuick3D/private/qquick3dtexture_p.h>
+
+#if QT_CONFIG(vulkan)
+#include <QVulkanInstance>
+#endif
+
+#include "../shared/util.h"
+
+static inline void renderNextFrame(QQuick3DTestOffscreenRenderer *renderer, bool *readCompleted, QRhiReadbackResult *readResult, QImage *result)
+{
+    renderer->qmlEngine->collectGarbage();
+    QGuiApplication::processEvents();
+    renderer->renderControl->polishItems();
+    renderer->renderControl->beginFrame();
+    renderer->renderControl->sync();
+    renderer->renderControl->render();
+    renderer->enqueueReadback(readCompleted, readResult, result);
+    renderer->renderControl->endFrame();
+}
+
+static int centerPixelGreen(const QImage &image)
+{
+    return qGreen(image.pixel(image.width() / 2, image.height() / 2));
+}
+
+class tst_AsyncTexture : public QQuick3DDataTest
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase() override;
+    void loadReady();
+    void loadError();
+
+private:
+    bool initRenderer(QQuick3DTestOffscreenRenderer *renderer, const QString &filename);
+    // Renders until the status of the texture is no longer Loading
+    QQuick3DTexture::Status waitForLoad(QQuick3DTestOffscreenRenderer *renderer, QQuick3DTexture *texture, QImage *result);
+
+    QTemporaryDir m_imageDir;
+#if QT_CONFIG(vulkan)
+    QVulkanInstance vulkanInstance;
+#endif
+};
+
+void tst_AsyncTexture::initTestCase()
+{
+    QQuick3DDataTest::initTestCase();
+    if (!initialized())
+        return;
+
+#if QT_CONFIG(vulkan)
+    vulkanInstance.setLayers({ "VK_LAYER_LUNARG_standard_validation" });
+    vulkanInstance.create(); // may fail, which is fine is Vulkan is not used in the first place
+#endif
+
+    QVERIFY(m_imageDir.isValid());
+    QImage image(256, 256, QImage::Format_RGBA8888);
+    image.fill(Qt::red);
+    QVERIFY(image.save(m_imageDir.filePath("red.png")));
+}
+
+bool tst_AsyncTexture::initRenderer(QQuick3DTestOffscreenRenderer *renderer, const QString &filename)
+{
+    const bool initSuccess = renderer->init(testFileUrl(filename),
+#if QT_CONFIG(vulkan)
+                                            &vulkanInstance
+#else
+                                            nullptr
+#endif
+    );
+    return initSuccess;
+}
+
+QQuick3DTexture::Status tst_AsyncTexture::waitForLoad(QQuick3DTestOffscreenRenderer *renderer, QQuick3DTexture *texture, QImage *result)
+{
+    bool readCompleted = false;
+    QRhiReadbackResult readResult;
+    for (int i = 0; i < 100 && texture->status() == QQuick3DTexture::Loading; ++i) {
+        renderNextFrame(renderer, &readCompleted, &readResult, result);
+        QTest::qWait(10);
+    }
+    // Render once more so that the result shows the loaded image
+    renderNextFrame(renderer, &readCompleted, &readResult, result);
+    return texture->status();
+}
+
+void tst_AsyncTexture::loadReady()
+{
+    QQuick3DTestOffscreenRenderer renderer;
+    QVERIFY(initRenderer(&renderer, QStringLiteral("asynctexture.qml")));
+
+    auto texture = renderer.rootItem->property("texture").value<QQuick3DTexture *>();
+    QVERIFY(texture);
+    QVERIFY(texture->asynchronous());
+    QCOMPARE(texture->status(), QQuick3DTexture::Null);
+
+    texture->setSource(QUrl::fromLocalFile(m_imageDir.filePath("red.png")));
+    QCOMPARE(texture->status(), QQuick3DTexture::Loading);
+
+    QImage result;
+    QCOMPARE(waitForLoad(&renderer, texture, &result), QQuick3DTexture::Ready);
+    QVERIFY(!result.isNull());
+    // Red instead of the white placeholder
+    QVERIFY(centerPixelGreen(result) < 64);
+}
+
+void tst_AsyncTexture::loadError()
+{
+    QQuick3DTestOffscreenRenderer renderer;
+    QVERIFY(initRenderer(&renderer, QStringLiteral("asynctexture.qml")));
+
+    auto texture = renderer.rootItem->property("texture").value<QQuick3DTexture *>();
+    QVERIFY(texture);
+
+    texture->setSource(QUrl::fromLocalFile(m_imageDir.filePath("missing.png")));
+    QCOMPARE(texture->status(), QQuick3DTexture::Loading);
+
+    QImage result;
+    QCOMPARE(waitForLoad(&renderer, texture, &result), QQuick3DTexture::Error);
+}
+
+QTEST_MAIN(tst_AsyncTexture)
+#include "tst_asynctexture.moc"
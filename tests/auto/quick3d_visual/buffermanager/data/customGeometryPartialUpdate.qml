@@ -0,0 +1,31 @@
+import QtQuick
+import QtQuick3D
+
+View3D {
+    width: 640
+    height: 480
+    id: view1
+    anchors.fill: parent
+
+    // The test gives the model a triangle geometry and moves its vertices
+    property Model testModel: model1
+
+    environment: SceneEnvironment {
+        backgroundMode: SceneEnvironment.Color
+        clearColor: "black"
+    }
+
+    PerspectiveCamera {
+        id: camera1
+        z: 600
+    }
+
+    Model {
+        id: model1
+        materials: PrincipledMaterial {
+            baseColor: "red"
+            lighting: PrincipledMaterial.NoLighting
+            cullMode: Material.NoCulling
+        }
+    }
+}
@@ -33,6 +33,8 @@
 #include <private/qssgrendercontextcore_p.h>
 #include <private/qssgrenderbuffermanager_p.h>
 #include <private/qquick3dresourceloader_p.h>
+#include <private/qssgrendermesh_p.h>
+#include <QtQuick3D/qquick3dgeometry.h>
 
 #if QT_CONFIG(vulkan)
 #include <QVulkanInstance>
@@ -63,6 +65,7 @@ private slots:
     void staticScene_data();
     void staticScene();
     void dynamicScene();
+    void partialGeometryUpdate();
 
 private:
     bool initRenderer(QQuick3DTestOffscreenRenderer *renderer, const QString &filename);
@@ -352,6 +355,98 @@ void tst_BufferManager::dynamicScene()
     QCOMPARE(bufferManager->getCustomMeshMap().count(), 0);
 }
 
+static QByteArray trianglePositions(const QVector3D &top)
+{
+    const QVector3D positions[] = {
+        QVector3D(-100.0f, -100.0f, 0.0f),
+        QVector3D(100.0f, -100.0f, 0.0f),
+        top
+    };
+    return QByteArray(reinterpret_cast<const char *>(positions), sizeof(positions));
+}
+
+void tst_BufferManager::partialGeometryUpdate()
+{
+    QQuick3DTestOffscreenRenderer renderer;
+    QVERIFY(initRenderer(&renderer, QString("customGeometryPartialUpdate.qml")));
+
+    if (renderer.quickWindow->rendererInterface()->graphicsApi() == QSGRendererInterface::OpenGL) {
+#ifdef Q_OS_MACOS
+        QSKIP("Skipping test due to sofware OpenGL renderer problems on macOS");
+#endif
+    }
+
+    QQuick3DViewport *view = qobject_cast<QQuick3DViewport *>(renderer.rootItem);
+    QVERIFY(view);
+    QQuick3DObject *model = renderer.rootItem->property("testModel").value<QQuick3DObject *>();
+    QVERIFY(model);
+
+    auto geometry = new QQuick3DGeometry(model);
+    geometry->setStride(3 * sizeof(float));
+    geometry->addAttribute(QQuick3DGeometry::Attribute::PositionSemantic, 0,
+                           QQuick3DGeometry::Attribute::F32Type);
+    geometry->setVertexData(trianglePositions(QVector3D(0.0f, 100.0f, 0.0f)));
+    geometry->setBounds(QVector3D(-100.0f, -100.0f, 0.0f), QVector3D(100.0f, 100.0f, 0.0f));
+    QVERIFY(model->setProperty("geometry", QVariant::fromValue(geometry)));
+
+    bool readCompleted = false;
+    QRhiReadbackResult readResult;
+    QImage result;
+
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    QVERIFY(readCompleted);
+
+    // One point is inside the triangle only while its top vertex is up, the
+    // other one is inside it in both cases
+    const auto redAt = [&](const QVector3D &position) {
+        const QVector3D viewPos = view->mapFrom3DScene(position);
+        return qRed(result.pixel(int(viewPos.x()), int(viewPos.y())));
+    };
+    const QVector3D upperPoint(0.0f, 50.0f, 0.0f);
+    const QVector3D lowerPoint(0.0f, -80.0f, 0.0f);
+    QVERIFY(redAt(upperPoint) > 200);
+    QVERIFY(redAt(lowerPoint) > 200);
+
+    QSSGRenderContextInterface *context = QSSGRenderContextInterface::renderContextForWindow(*renderer.quickWindow);
+    QVERIFY(context);
+
+    auto bufferManager = context->bufferManager();
+
+    QCOMPARE(bufferManager->getCustomMeshMap().count(), 1);
+    QSSGRenderMesh *mesh = bufferManager->getCustomMeshMap().cbegin()->mesh;
+    QVERIFY(mesh);
+    QCOMPARE(mesh->subsets.count(), 1);
+    QRhiBuffer *vertexBuffer = mesh->subsets.first().rhi.vertexBuffer->buffer();
+
+    // Move the top vertex down, only the last vertex is written, and grow
+    // the bounds, like a point cloud getting more points would
+    const QVector3D boundsMax = geometry->boundsMax() + QVector3D(1000, 1000, 1000);
+    const QByteArray movedTop = trianglePositions(QVector3D(0.0f, -50.0f, 0.0f)).mid(2 * geometry->stride());
+    geometry->setVertexData(2 * geometry->stride(), movedTop);
+    geometry->setBounds(geometry->boundsMin(), boundsMax);
+    geometry->update();
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    QVERIFY(readCompleted);
+
+    // The buffers are updated in place, the bounds used for culling follow
+    QCOMPARE(bufferManager->getCustomMeshMap().count(), 1);
+    QCOMPARE(bufferManager->getCustomMeshMap().cbegin()->mesh, mesh);
+    QCOMPARE(mesh->subsets.first().rhi.vertexBuffer->buffer(), vertexBuffer);
+    QCOMPARE(mesh->subsets.first().bounds.maximum, boundsMax);
+
+    // and what is drawn is the moved triangle
+    QVERIFY(redAt(upperPoint) < 50);
+    QVERIFY(redAt(lowerPoint) > 200);
+
+    // Bounds alone as well
+    const QVector3D boundsMin = geometry->boundsMin() - QVector3D(1000, 1000, 1000);
+    geometry->setBounds(boundsMin, boundsMax);
+    geometry->update();
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    QCOMPARE(bufferManager->getCustomMeshMap().cbegin()->mesh, mesh);
+    QCOMPARE(mesh->subsets.first().bounds.minimum, boundsMin);
+}
+
 bool tst_BufferManager::initRenderer(QQuick3DTestOffscreenRenderer *renderer, const QString &filename)
 {
     const bool initSuccess = renderer->init(testFileUrl(filename),
@@ -0,0 +1,99 @@
+import QtQuick
+import QtQuick3D
+
+View3D {
+    width: 400
+    height: 400
+    anchors.fill: parent
+
+    // Any model, for finding the layer
+    property Model testModel: ground
+
+    environment: SceneEnvironment {
+        backgroundMode: SceneEnvironment.Color
+        clearColor: "black"
+    }
+
+    PerspectiveCamera {
+        y: 300
+        z: 900
+        eulerRotation.x: -15
+    }
+
+    DirectionalLight {
+        eulerRotation.x: -30
+        eulerRotation.y: -20
+    }
+
+    PointLight {
+        x: 200
+        y: 200
+        z: 200
+        color: "lightblue"
+    }
+
+    Model {
+        id: ground
+        source: "#Rectangle"
+        eulerRotation.x: -90
+        y: -100
+        scale: Qt.vector3d(30, 30, 1)
+        materials: PrincipledMaterial {
+            baseColor: "gray"
+        }
+    }
+
+    // Enough models for several prepare jobs. Part of the grid is outside of
+    // the view, some of the materials are transparent, and the materials
+    // differ in what their shaders need.
+    Repeater3D {
+        model: 600
+        Model {
+            source: index % 3 == 0 ? "#Sphere" : (index % 3 == 1 ? "#Cube" : "#Cone")
+            x: (index % 30 - 14.5) * 60
+            z: -(Math.floor(index / 30) - 5) * 60
+            eulerRotation: Qt.vector3d(index * 10, index * 20, 0)
+            scale: Qt.vector3d(0.3, 0.3, 0.3)
+            materials: [ [material0, material1, material2, material3, material4, material5][Math.floor(index / 3) % 6] ]
+        }
+    }
+
+    PrincipledMaterial {
+        id: material0
+        baseColor: "orange"
+        metalness: 0.5
+        roughness: 0.3
+    }
+
+    DefaultMaterial {
+        id: material1
+        diffuseColor: "green"
+        specularAmount: 0.5
+    }
+
+    DefaultMaterial {
+        id: material2
+        diffuseColor: "purple"
+        lighting: DefaultMaterial.NoLighting
+    }
+
+    PrincipledMaterial {
+        id: material3
+        baseColor: "steelblue"
+        opacity: 0.5
+    }
+
+    PrincipledMaterial {
+        id: material4
+        baseColor: "red"
+        emissiveFactor: Qt.vector3d(0.2, 0.0, 0.0)
+        alphaMode: PrincipledMaterial.Blend
+        opacity: 0.7
+    }
+
+    DefaultMaterial {
+        id: material5
+        diffuseColor: "yellow"
+        cullMode: Material.NoCulling
+    }
+}
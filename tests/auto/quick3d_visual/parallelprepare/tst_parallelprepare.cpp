@@ -0,0 +1,196 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QTest>
+
+#include <private/qquick3dobject_p.h>
+#include <private/qssgrendercontextcore_p.h>
+#include <private/qssgrenderjobsystem_p.h>
+#include <private/qssgrenderlayer_p.h>
+#include <private/qssgrenderableobjects_p.h>
+#include <private/qssgrendererimpllayerrenderdata_p.h>
+
+#if QT_CONFIG(vulkan)
+#include <QVulkanInstance>
+#endif
+
+#include "../shared/util.h"
+
+static inline void renderNextFrame(QQuick3DTestOffscreenRenderer *renderer, bool *readCompleted, QRhiReadbackResult *readResult, QImage *result)
+{
+    renderer->qmlEngine->collectGarbage();
+    QGuiApplication::processEvents();
+    renderer->renderControl->polishItems();
+    renderer->renderControl->beginFrame();
+    renderer->renderControl->sync();
+    renderer->renderControl->render();
+    renderer->enqueueReadback(readCompleted, readResult, result);
+    renderer->renderControl->endFrame();
+}
+
+// What prepareRenderablesForRender produced for one subset. The renderables
+// themselves are allocated anew every frame, so they are compared by content.
+struct Renderable
+{
+    const QSSGRenderGraphObject *model = nullptr;
+    const QSSGRenderSubset *subset = nullptr;
+    const QSSGRenderGraphObject *material = nullptr;
+    size_t shaderKey = 0;
+    float opacity = 0.0f;
+    QVector3D worldCenterPoint;
+
+    bool operator==(const Renderable &other) const
+    {
+        return model == other.model && subset == other.subset && material == other.material
+                && shaderKey == other.shaderKey && opacity == other.opacity
+                && worldCenterPoint == other.worldCenterPoint;
+    }
+};
+
+static QList<Renderable> renderables(const QSSGLayerRenderPreparationData::TRenderableObjectList &objects)
+{
+    QList<Renderable> result;
+    for (const QSSGRenderableObjectHandle &handle : objects) {
+        Renderable r;
+        r.worldCenterPoint = handle.obj->worldCenterPoint;
+        if (handle.obj->renderableFlags.isDefaultMaterialMeshSubset()
+                || handle.obj->renderableFlags.isCustomMaterialMeshSubset()) {
+            const auto *subsetRenderable = static_cast<const QSSGSubsetRenderable *>(handle.obj);
+            r.model = &subsetRenderable->modelContext.model;
+            r.subset = &subsetRenderable->subset;
+            r.material = &subsetRenderable->material;
+            r.shaderKey = subsetRenderable->shaderDescription.hash();
+            r.opacity = subsetRenderable->opacity;
+        }
+        result.append(r);
+    }
+    return result;
+}
+
+class tst_ParallelPrepare : public QQuick3DDataTest
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase() override;
+    void sameOutput();
+
+private:
+#if QT_CONFIG(vulkan)
+    QVulkanInstance vulkanInstance;
+#endif
+};
+
+void tst_ParallelPrepare::initTestCase()
+{
+    QQuick3DDataTest::initTestCase();
+    if (!initialized())
+        return;
+
+#if QT_CONFIG(vulkan)
+    vulkanInstance.setLayers({ "VK_LAYER_LUNARG_standard_validation" });
+    vulkanInstance.create(); // may fail, which is fine is Vulkan is not used in the first place
+#endif
+}
+
+// The renderables of the layer are prepared in jobs on worker threads, or
+// all on the render thread with QT_QUICK3D_DISABLE_PARALLEL_PREPARE set. The
+// lists and so the rendered frame must be the same either way.
+void tst_ParallelPrepare::sameOutput()
+{
+    QQuick3DTestOffscreenRenderer renderer;
+    QVERIFY(renderer.init(testFileUrl("scene.qml"),
+#if QT_CONFIG(vulkan)
+                          &vulkanInstance
+#else
+                          nullptr
+#endif
+    ));
+
+    bool readCompleted = false;
+    QRhiReadbackResult readResult;
+    QImage result;
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    QVERIFY(readCompleted);
+
+    QSSGRenderContextInterface *context = QSSGRenderContextInterface::renderContextForWindow(*renderer.quickWindow);
+    QVERIFY(context);
+    QSSGRenderJobSystem &jobSystem = context->jobSystem();
+    jobSystem.setEnabled(true);
+    if (!jobSystem.isEnabled())
+        QSKIP("Only one core available, everything is prepared on the render thread");
+
+    QQuick3DObject *model = renderer.rootItem->property("testModel").value<QQuick3DObject *>();
+    QVERIFY(model);
+    auto node = static_cast<QSSGRenderNode *>(QQuick3DObjectPrivate::get(model)->spatialNode);
+    while (node && node->type != QSSGRenderGraphObject::Type::Layer)
+        node = node->parent;
+    QVERIFY(node);
+    const QSSGRenderLayer *layer = static_cast<const QSSGRenderLayer *>(node);
+    QVERIFY(layer->renderData);
+
+    struct Frame {
+        QImage image;
+        QList<Renderable> opaque;
+        QList<Renderable> transparent;
+    };
+    const auto render = [&](bool parallel) {
+        jobSystem.setEnabled(parallel);
+        // Anything set up lazily is in place by the second frame
+        renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+        renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+        return Frame { result,
+                       renderables(layer->renderData->opaqueObjects),
+                       renderables(layer->renderData->transparentObjects) };
+    };
+
+    const Frame serial = render(false);
+    QVERIFY(readCompleted);
+    QVERIFY(!serial.image.isNull());
+    // Enough renderables for the parallel path to split them into jobs, and
+    // both kinds of lists are used
+    QVERIFY(serial.opaque.count() + serial.transparent.count() > 128);
+    QVERIFY(!serial.transparent.isEmpty());
+
+    const Frame parallel = render(true);
+    QVERIFY(readCompleted);
+    QCOMPARE(parallel.opaque.count(), serial.opaque.count());
+    QCOMPARE(parallel.transparent.count(), serial.transparent.count());
+    QVERIFY(parallel.opaque == serial.opaque);
+    QVERIFY(parallel.transparent == serial.transparent);
+    QCOMPARE(parallel.image, serial.image);
+
+    // And again, once the per-slot allocators have been reused
+    const Frame again = render(true);
+    QVERIFY(again.opaque == serial.opaque);
+    QVERIFY(again.transparent == serial.transparent);
+    QCOMPARE(again.image, serial.image);
+}
+
+QTEST_MAIN(tst_ParallelPrepare)
+#include "tst_parallelprepare.moc"
@@ -42,9 +42,11 @@ class tst_Picking : public QQuick3DDataTest
 private Q_SLOTS:
     void initTestCase() override;
     void test_object_picking();
+    void test_batch_picking();
 
 private:
     QQuickItem *find2DChildIn3DNode(QQuickView *view, const QString &objectName, const QString &itemName);
+    static bool compareResults(const QList<QQuick3DPickResult> &actual, const QList<QQuick3DPickResult> &expected);
 
 };
 
@@ -194,5 +196,71 @@ void tst_Picking::test_object_picking()
     QVERIFY(resultList.isEmpty());
 }
 
+bool tst_Picking::compareResults(const QList<QQuick3DPickResult> &actual, const QList<QQuick3DPickResult> &expected)
+{
+    if (actual.size() != expected.size())
+        return false;
+    for (int i = 0; i < actual.size(); ++i) {
+        if (actual.at(i).objectHit() != expected.at(i).objectHit()
+                || !qFuzzyCompare(actual.at(i).distance(), expected.at(i).distance())
+                || !qFuzzyCompare(actual.at(i).scenePosition(), expected.at(i).scenePosition()))
+            return false;
+    }
+    return true;
+}
+
+void tst_Picking::test_batch_picking()
+{
+    QScopedPointer<QQuickView> view(createView(QLatin1String("picking.qml"), QSize(400, 400)));
+    QVERIFY(view);
+    QVERIFY(QTest::qWaitForWindowExposed(view.data()));
+
+    QQuick3DViewport *view3d = view->findChild<QQuick3DViewport *>(QStringLiteral("view"));
+    QVERIFY(view3d);
+
+    // Enough rays to be traced in parallel, over and around both models
+    QList<QPointF> positions;
+    for (int y = 0; y < 400; y += 7) {
+        for (int x = 0; x < 400; x += 7)
+            positions.append(QPointF(x, y));
+    }
+
+    int hitCount = 0;
+    QVariantList batchResults = view3d->batchPickAll(positions);
+    QCOMPARE(batchResults.size(), positions.size());
+    for (int i = 0; i < positions.size(); ++i) {
+        const QPointF &position = positions.at(i);
+        const auto expected = view3d->pickAll(position.x(), position.y());
+        const auto actual = batchResults.at(i).value<QList<QQuick3DPickResult>>();
+        QVERIFY2(compareResults(actual, expected),
+                 qPrintable(QStringLiteral("Results differ at (%1, %2)").arg(position.x()).arg(position.y())));
+        hitCount += expected.size();
+    }
+    QVERIFY(hitCount > 0);
+
+    // Rays through the scene from both sides
+    QList<QVector3D> origins;
+    QList<QVector3D> directions;
+    for (int y = -150; y <= 150; y += 10) {
+        for (int x = -150; x <= 150; x += 10) {
+            origins.append(QVector3D(x, y, 100.0f));
+            directions.append(QVector3D(0.001f * x, 0.001f * y, -1.0f).normalized());
+            origins.append(QVector3D(x, y, -100.0f));
+            directions.append(QVector3D(0.0f, 0.0f, 1.0f));
+        }
+    }
+
+    hitCount = 0;
+    batchResults = view3d->batchRayPickAll(origins, directions);
+    QCOMPARE(batchResults.size(), origins.size());
+    for (int i = 0; i < origins.size(); ++i) {
+        const auto expected = view3d->rayPickAll(origins.at(i), directions.at(i));
+        const auto actual = batchResults.at(i).value<QList<QQuick3DPickResult>>();
+        QVERIFY2(compareResults(actual, expected), qPrintable(QStringLiteral("Results differ for ray %1").arg(i)));
+        hitCount += expected.size();
+    }
+    QVERIFY(hitCount > 0);
+}
+
 QTEST_MAIN(tst_Picking)
 #include "tst_picking.moc"
@@ -0,0 +1,378 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QTest>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QCryptographicHash>
+
+#include <private/qssgrhicontext_p.h>
+#include <private/qssgrendershadercache_p.h>
+#include <private/qqsbcollection_p.h>
+
+static const char *vertexSource =
+        "layout(location = 0) in vec3 attr_pos;\n"
+        "void main()\n"
+        "{\n"
+        "    gl_Position = vec4(attr_pos, 1.0);\n"
+        "}\n";
+
+static const char *fragmentSource =
+        "void main()\n"
+        "{\n"
+        "    fragOutput = vec4(1.0);\n"
+        "}\n";
+
+class tst_ShaderCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void prewarm_data();
+    void prewarm();
+    void diskCacheHit();
+    void diskCacheIdentityMismatch();
+    void diskCacheInvalidEntry();
+    void diskCacheTruncated();
+    void diskCacheSizeLimit();
+
+private:
+    QSSGShaderCacheStats compile(const QByteArrayList &keys, QShader *vert = nullptr, QShader *frag = nullptr);
+    QString diskCacheFileName(const QByteArray &qtVersion) const;
+
+    QRhi *rhi = nullptr;
+    QSSGRef<QSSGRhiContext> rhiContext;
+};
+
+// Enables the shader disk cache in a temporary directory for the lifetime
+// of the object.
+class DiskCacheDir
+{
+public:
+    DiskCacheDir()
+    {
+        qunsetenv("QT_QUICK3D_DISABLE_SHADER_DISK_CACHE");
+        qputenv("QT_QUICK3D_SHADER_DISK_CACHE_DIR", dir.path().toLocal8Bit());
+    }
+    ~DiskCacheDir()
+    {
+        qunsetenv("QT_QUICK3D_SHADER_DISK_CACHE_DIR");
+        qunsetenv("QT_QUICK3D_SHADER_DISK_CACHE_SIZE");
+        qputenv("QT_QUICK3D_DISABLE_SHADER_DISK_CACHE", "1");
+    }
+
+    bool isValid() const { return dir.isValid(); }
+    QString filePath(const QString &fileName) const { return dir.filePath(fileName); }
+    QStringList files() const { return QDir(dir.path()).entryList({ QLatin1String("*.qsbc") }, QDir::Files); }
+
+private:
+    QTemporaryDir dir;
+};
+
+void tst_ShaderCache::initTestCase()
+{
+#ifndef QT_QUICK3D_HAS_RUNTIME_SHADERS
+    QSKIP("Shaders cannot be baked at runtime in this build");
+#endif
+    // The shaders must come from the bakes, not from an earlier run.
+    qputenv("QT_QUICK3D_DISABLE_SHADER_DISK_CACHE", "1");
+
+    rhi = QRhi::create(QRhi::Null, nullptr);
+    QVERIFY(rhi);
+    rhiContext = QSSGRef<QSSGRhiContext>(new QSSGRhiContext);
+    rhiContext->initialize(rhi);
+}
+
+// Compiles the shaders under each of the keys with a new cache, which saves
+// its disk cache when going away.
+QSSGShaderCacheStats tst_ShaderCache::compile(const QByteArrayList &keys, QShader *vert, QShader *frag)
+{
+    QScopedPointer<QSSGShaderCache> cache(new QSSGShaderCache(rhiContext));
+    for (const QByteArray &key : keys) {
+        const QSSGRef<QSSGRhiShaderPipeline> shaders = cache->compileForRhi(key, vertexSource, fragmentSource, {}, {});
+        if (!shaders)
+            return {};
+        if (vert)
+            *vert = shaders->vertexStage()->shader();
+        if (frag)
+            *frag = shaders->fragmentStage()->shader();
+    }
+    return cache->stats();
+}
+
+// Matches what QSSGShaderCache uses: one file per Qt version and QRhi backend
+// and device, so that no shaders generated for something else get loaded.
+QString tst_ShaderCache::diskCacheFileName(const QByteArray &qtVersion) const
+{
+    const QRhiDriverInfo driverInfo = rhi->driverInfo();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(qtVersion);
+    hash.addData(rhi->backendName());
+    hash.addData(driverInfo.deviceName);
+    hash.addData(QByteArray::number(driverInfo.deviceId));
+    hash.addData(QByteArray::number(driverInfo.vendorId));
+    return QLatin1String("qtquick3d-") + QString::fromLatin1(hash.result().toHex().left(16))
+            + QLatin1String(".qsbc");
+}
+
+// Writes a cache file with a single entry for \a key
+static bool writeDiskCacheEntry(const QString &fileName, const QByteArray &key, const QByteArray &description,
+                                const QShader &vert, const QShader &frag)
+{
+    QQsbCollection collection(fileName);
+    if (!collection.map(QQsbCollection::Write))
+        return false;
+    collection.addQsbEntry(description, QQsbShaderFeatureSet(), vert, frag,
+                           QSSGShaderCacheKey::generateHashCode(key, QSSGShaderFeatures()));
+    collection.unmap();
+    return true;
+}
+
+void tst_ShaderCache::cleanupTestCase()
+{
+    rhiContext.clear();
+    delete rhi;
+}
+
+void tst_ShaderCache::prewarm_data()
+{
+    QTest::addColumn<bool>("asyncBaking");
+    QTest::newRow("synchronous baking") << false;
+    QTest::newRow("asynchronous baking") << true;
+}
+
+void tst_ShaderCache::prewarm()
+{
+    QFETCH(bool, asyncBaking);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString manifest = dir.filePath(QLatin1String("shaders.q3mf"));
+    const QByteArray key("tst_shadercache");
+    QSSGShaderFeatures features;
+
+    // Record the manifest
+    qputenv("QT_QUICK3D_RECORD_SHADER_MANIFEST", manifest.toLocal8Bit());
+    {
+        QScopedPointer<QSSGShaderCache> cache(new QSSGShaderCache(rhiContext));
+        QVERIFY(cache->compileForRhi(key, vertexSource, fragmentSource, features, {}));
+    }
+    qunsetenv("QT_QUICK3D_RECORD_SHADER_MANIFEST");
+    QVERIFY(QFile::exists(manifest));
+
+    if (asyncBaking)
+        qputenv("QT_QUICK3D_ASYNC_SHADER_BAKING", "1");
+    QScopedPointer<QSSGShaderCache> cache(new QSSGShaderCache(rhiContext));
+    qunsetenv("QT_QUICK3D_ASYNC_SHADER_BAKING");
+
+    QCOMPARE(cache->prewarm(manifest), 1);
+    // Nothing is waiting for it yet
+    QVERIFY(!cache->hasPendingBakes());
+
+    // Needed right away: the prewarmed bake is waited for, whether it is
+    // finished or not, instead of being baked a second time.
+    const QSSGRef<QSSGRhiShaderPipeline> shaders = cache->compileForRhi(key, vertexSource, fragmentSource, features, {});
+    QVERIFY(shaders);
+    QVERIFY(shaders->vertexStage());
+    QVERIFY(shaders->fragmentStage());
+    QCOMPARE(cache->stats().prewarmHitCount, 1);
+
+    // Known by now, neither prewarmed nor baked again
+    QCOMPARE(cache->prewarm(manifest), 0);
+    QCOMPARE(cache->compileForRhi(key, vertexSource, fragmentSource, features, {}).data(), shaders.data());
+    QCOMPARE(cache->stats().prewarmHitCount, 1);
+
+    // Different features make a different shader, baked on its own
+    QSSGShaderFeatures otherFeatures;
+    otherFeatures.set(QSSGShaderFeatures::Feature::LinearTonemapping, true);
+    QVERIFY(cache->compileForRhi(key, vertexSource, fragmentSource, otherFeatures, {}));
+    QCOMPARE(cache->stats().prewarmHitCount, 1);
+}
+
+void tst_ShaderCache::diskCacheHit()
+{
+    DiskCacheDir dir;
+    QVERIFY(dir.isValid());
+    const QByteArray key("tst_shadercache_disk");
+
+    QShader vert;
+    QShader frag;
+    QSSGShaderCacheStats stats = compile({ key }, &vert, &frag);
+    QCOMPARE(stats.diskCacheHitCount, 0);
+    QCOMPARE(stats.diskCacheMissCount, 1);
+    QCOMPARE(dir.files(), QStringList { diskCacheFileName(QT_VERSION_STR) });
+
+    // A new cache, as in the next run of the application, takes the shaders
+    // from the file instead of baking them
+    QShader loadedVert;
+    QShader loadedFrag;
+    stats = compile({ key }, &loadedVert, &loadedFrag);
+    QCOMPARE(stats.diskCacheHitCount, 1);
+    QCOMPARE(stats.diskCacheMissCount, 0);
+    QVERIFY(stats.diskCacheTimeSaved >= 0.0f);
+    QVERIFY(loadedVert == vert);
+    QVERIFY(loadedFrag == frag);
+
+    // And again, loading alone does not lose anything
+    stats = compile({ key });
+    QCOMPARE(stats.diskCacheHitCount, 1);
+}
+
+void tst_ShaderCache::diskCacheIdentityMismatch()
+{
+    DiskCacheDir dir;
+    QVERIFY(dir.isValid());
+    const QByteArray key("tst_shadercache_disk");
+
+    QShader vert;
+    QShader frag;
+    QCOMPARE(compile({ key }, &vert, &frag).diskCacheMissCount, 1);
+
+    // What another Qt version wrote is not looked at
+    const QString fileName = dir.filePath(diskCacheFileName(QT_VERSION_STR));
+    const QString otherFileName = dir.filePath(diskCacheFileName("6.0.0"));
+    QVERIFY(QFile::rename(fileName, otherFileName));
+    QSSGShaderCacheStats stats = compile({ key });
+    QCOMPARE(stats.diskCacheHitCount, 0);
+    QCOMPARE(stats.diskCacheMissCount, 1);
+    QVERIFY(QFile::exists(fileName));
+    QVERIFY(QFile::exists(otherFileName));
+
+    // An entry with the right hash but made for other features, i.e. a hash
+    // collision, is rejected and replaced
+    QSSGShaderFeatures otherFeatures;
+    otherFeatures.set(QSSGShaderFeatures::Feature::LinearTonemapping, true);
+    QVERIFY(writeDiskCacheEntry(fileName, key, "1000 " + QByteArray::number(otherFeatures.flags) + ' ' + key, vert, frag));
+    stats = compile({ key });
+    QCOMPARE(stats.diskCacheHitCount, 0);
+    QCOMPARE(stats.diskCacheMissCount, 1);
+    stats = compile({ key });
+    QCOMPARE(stats.diskCacheHitCount, 1);
+    QCOMPARE(stats.diskCacheMissCount, 0);
+}
+
+void tst_ShaderCache::diskCacheInvalidEntry()
+{
+    DiskCacheDir dir;
+    QVERIFY(dir.isValid());
+    const QByteArray key("tst_shadercache_disk");
+    const QString fileName = dir.filePath(diskCacheFileName(QT_VERSION_STR));
+
+    // The description matches, the shaders are unusable
+    QVERIFY(writeDiskCacheEntry(fileName, key, "1000 0 " + key, QShader(), QShader()));
+    QShader vert;
+    QShader frag;
+    QSSGShaderCacheStats stats = compile({ key }, &vert, &frag);
+    QCOMPARE(stats.diskCacheHitCount, 0);
+    QCOMPARE(stats.diskCacheMissCount, 1);
+    QVERIFY(vert.isValid());
+    QVERIFY(frag.isValid());
+
+    // Baked again, and stored in place of the invalid entry
+    QShader loadedVert;
+    stats = compile({ key }, &loadedVert);
+    QCOMPARE(stats.diskCacheHitCount, 1);
+    QVERIFY(loadedVert == vert);
+
+    // Not a number where the bake time is expected
+    QVERIFY(writeDiskCacheEntry(fileName, key, "x 0 " + key, vert, frag));
+    stats = compile({ key });
+    QCOMPARE(stats.diskCacheHitCount, 0);
+    QCOMPARE(stats.diskCacheMissCount, 1);
+}
+
+void tst_ShaderCache::diskCacheTruncated()
+{
+    DiskCacheDir dir;
+    QVERIFY(dir.isValid());
+    const QByteArray key("tst_shadercache_disk");
+    const QString fileName = dir.filePath(diskCacheFileName(QT_VERSION_STR));
+
+    QShader vert;
+    QCOMPARE(compile({ key }, &vert).diskCacheMissCount, 1);
+
+    QFile f(fileName);
+    QVERIFY(f.exists());
+    QVERIFY(f.resize(f.size() / 2));
+
+    // Baked as if there was no file, and the file is written anew
+    QShader bakedVert;
+    QSSGShaderCacheStats stats = compile({ key }, &bakedVert);
+    QCOMPARE(stats.diskCacheHitCount, 0);
+    QCOMPARE(stats.diskCacheMissCount, 1);
+    QVERIFY(bakedVert == vert);
+
+    stats = compile({ key });
+    QCOMPARE(stats.diskCacheHitCount, 1);
+    QCOMPARE(stats.diskCacheMissCount, 0);
+}
+
+void tst_ShaderCache::diskCacheSizeLimit()
+{
+    DiskCacheDir dir;
+    QVERIFY(dir.isValid());
+
+    QByteArrayList keys;
+    for (int i = 0; i < 24; ++i)
+        keys.append(QByteArray("tst_shadercache_disk_") + QByteArray::number(i));
+
+    QShader vert;
+    QShader frag;
+    QSSGShaderCacheStats stats = compile(keys, &vert, &frag);
+    QCOMPARE(stats.diskCacheMissCount, keys.count());
+
+    // Room for a few entries, but far from all of them. The description
+    // holds the bake time and the features next to the key.
+    const qint64 entrySize = vert.serialized().size() + frag.serialized().size() + keys.last().size() + 32;
+    const int sizeLimitKb = int((4 * entrySize + 1023) / 1024);
+    QVERIFY2(qint64(sizeLimitKb) * 1024 < keys.count() * entrySize, "The test shaders are too large");
+
+    // Use two of the old ones and add a new one, with the limit in place
+    const QByteArray newKey("tst_shadercache_disk_new");
+    qputenv("QT_QUICK3D_SHADER_DISK_CACHE_SIZE", QByteArray::number(sizeLimitKb));
+    stats = compile({ keys[0], keys[1], newKey });
+    qunsetenv("QT_QUICK3D_SHADER_DISK_CACHE_SIZE");
+    QCOMPARE(stats.diskCacheHitCount, 2);
+    QCOMPARE(stats.diskCacheMissCount, 1);
+
+    // The ones used last are kept, others went
+    QScopedPointer<QSSGShaderCache> cache(new QSSGShaderCache(rhiContext));
+    for (const QByteArray &key : { newKey, keys[0], keys[1] })
+        QVERIFY(cache->compileForRhi(key, vertexSource, fragmentSource, {}, {}));
+    QCOMPARE(cache->stats().diskCacheHitCount, 3);
+    for (int i = 2; i < keys.count(); ++i)
+        QVERIFY(cache->compileForRhi(keys[i], vertexSource, fragmentSource, {}, {}));
+    QVERIFY(cache->stats().diskCacheMissCount > 0);
+    QVERIFY(cache->stats().diskCacheHitCount <= sizeLimitKb * 1024 / int(entrySize - 32));
+}
+
+QTEST_GUILESS_MAIN(tst_ShaderCache)
+#include "tst_shadercache.moc"
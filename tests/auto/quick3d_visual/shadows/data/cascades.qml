@@ -0,0 +1,69 @@
+import QtQuick
+import QtQuick3D
+
+View3D {
+    width: 400
+    height: 400
+    anchors.fill: parent
+
+    // The shadows end at 2000 from the camera, the casters are in the first
+    // cascade, in the last one, and beyond it
+    property vector3d nearCasterPosition: Qt.vector3d(0, 100, -600)
+    property vector3d farCasterPosition: Qt.vector3d(0, 100, -1500)
+    property vector3d beyondCasterPosition: Qt.vector3d(0, 100, -3000)
+
+    environment: SceneEnvironment {
+        backgroundMode: SceneEnvironment.Color
+        clearColor: "black"
+    }
+
+    PerspectiveCamera {
+        y: 400
+        eulerRotation.x: -20
+        clipFar: 5000
+    }
+
+    // Straight down, the shadows are right below the casters
+    DirectionalLight {
+        eulerRotation.x: -90
+        castsShadow: true
+        shadowFactor: 100
+        shadowMapFar: 2000
+        shadowMapQuality: Light.ShadowMapQualityHigh
+        cascadeCount: 3
+    }
+
+    Model {
+        source: "#Rectangle"
+        eulerRotation.x: -90
+        scale: Qt.vector3d(100, 100, 1)
+        castsShadows: false
+        materials: DefaultMaterial {
+            diffuseColor: "white"
+        }
+    }
+
+    Model {
+        source: "#Cube"
+        position: nearCasterPosition
+        materials: DefaultMaterial {
+            diffuseColor: "white"
+        }
+    }
+
+    Model {
+        source: "#Cube"
+        position: farCasterPosition
+        materials: DefaultMaterial {
+            diffuseColor: "white"
+        }
+    }
+
+    Model {
+        source: "#Cube"
+        position: beyondCasterPosition
+        materials: DefaultMaterial {
+            diffuseColor: "white"
+        }
+    }
+}
@@ -0,0 +1,48 @@
+import QtQuick
+import QtQuick3D
+
+View3D {
+    width: 400
+    height: 400
+    anchors.fill: parent
+
+    property Model caster: casterModel
+
+    environment: SceneEnvironment {
+        backgroundMode: SceneEnvironment.Color
+        clearColor: "black"
+    }
+
+    // Between the caster and the ground, so that only the shadow is seen
+    PerspectiveCamera {
+        y: 50
+        eulerRotation.x: -90
+    }
+
+    DirectionalLight {
+        eulerRotation.x: -90
+        castsShadow: true
+        shadowFactor: 100
+        shadowMapQuality: Light.ShadowMapQualityHigh
+    }
+
+    Model {
+        source: "#Rectangle"
+        eulerRotation.x: -90
+        scale: Qt.vector3d(10, 10, 1)
+        castsShadows: false
+        materials: DefaultMaterial {
+            diffuseColor: "white"
+        }
+    }
+
+    // The geometry is set from the test
+    Model {
+        id: casterModel
+        y: 100
+        materials: DefaultMaterial {
+            diffuseColor: "white"
+            cullMode: Material.NoCulling
+        }
+    }
+}
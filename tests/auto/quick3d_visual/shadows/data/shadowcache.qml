@@ -0,0 +1,56 @@
+import QtQuick
+import QtQuick3D
+
+View3D {
+    width: 400
+    height: 400
+    anchors.fill: parent
+
+    property DirectionalLight directionalLight: directionalLight
+    property PointLight pointLight: pointLight
+
+    environment: SceneEnvironment {
+        backgroundMode: SceneEnvironment.Color
+        clearColor: "black"
+    }
+
+    PerspectiveCamera {
+        y: 300
+        z: 300
+        eulerRotation.x: -45
+    }
+
+    // One map in the atlas
+    DirectionalLight {
+        id: directionalLight
+        eulerRotation.x: -60
+        castsShadow: true
+        shadowFactor: 100
+    }
+
+    // One cube map
+    PointLight {
+        id: pointLight
+        y: 200
+        castsShadow: true
+        shadowFactor: 100
+    }
+
+    Model {
+        source: "#Rectangle"
+        eulerRotation.x: -90
+        scale: Qt.vector3d(10, 10, 1)
+        castsShadows: false
+        materials: DefaultMaterial {
+            diffuseColor: "white"
+        }
+    }
+
+    Model {
+        source: "#Cube"
+        y: 75
+        materials: DefaultMaterial {
+            diffuseColor: "white"
+        }
+    }
+}
@@ -0,0 +1,249 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QTest>
+#include <QQuickView>
+#include <QQuickItem>
+
+#include <QtQuick3D/private/qquick3dmodel_p.h>
+#include <QtQuick3D/private/qquick3dviewport_p.h>
+#include <QtQuick3D/qquick3dgeometry.h>
+
+#include <private/qssgrendercontextcore_p.h>
+#include <private/qssgrhicontext_p.h>
+
+#if QT_CONFIG(vulkan)
+#include <QVulkanInstance>
+#endif
+
+#include "../shared/util.h"
+
+static inline void renderNextFrame(QQuick3DTestOffscreenRenderer *renderer, bool *readCompleted, QRhiReadbackResult *readResult, QImage *result)
+{
+    renderer->qmlEngine->collectGarbage();
+    QGuiApplication::processEvents();
+    renderer->renderControl->polishItems();
+    renderer->renderControl->beginFrame();
+    renderer->renderControl->sync();
+    renderer->renderControl->render();
+    renderer->enqueueReadback(readCompleted, readResult, result);
+    renderer->renderControl->endFrame();
+}
+
+class tst_Shadows : public QQuick3DDataTest
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase() override;
+    void casterGeometryChange();
+    void cachedShadowMaps();
+    void cascades();
+
+private:
+#if QT_CONFIG(vulkan)
+    QVulkanInstance vulkanInstance;
+#endif
+};
+
+void tst_Shadows::initTestCase()
+{
+    QQuick3DDataTest::initTestCase();
+    if (!initialized())
+        return;
+
+#if QT_CONFIG(vulkan)
+    vulkanInstance.setLayers({ "VK_LAYER_LUNARG_standard_validation" });
+    vulkanInstance.create(); // may fail, which is fine is Vulkan is not used in the first place
+#endif
+}
+
+// Two triangles in the XZ plane, each vertex a position and a normal
+static QByteArray quadVertexData(float halfSize)
+{
+    const float corners[6][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, -1 }, { 1, 1 }, { -1, 1 } };
+    QByteArray data(6 * 6 * sizeof(float), Qt::Uninitialized);
+    float *p = reinterpret_cast<float *>(data.data());
+    for (const auto &corner : corners) {
+        *p++ = corner[0] * halfSize;
+        *p++ = 0.0f;
+        *p++ = corner[1] * halfSize;
+        *p++ = 0.0f;
+        *p++ = 1.0f;
+        *p++ = 0.0f;
+    }
+    return data;
+}
+
+static int centerPixelRed(const QImage &image)
+{
+    return qRed(image.pixel(image.width() / 2, image.height() / 2));
+}
+
+void tst_Shadows::casterGeometryChange()
+{
+    QScopedPointer<QQuickView> view(createView(QLatin1String("castergeometry.qml"), QSize(400, 400)));
+    QVERIFY(view);
+    QVERIFY(QTest::qWaitForWindowExposed(view.data()));
+
+    const auto caster = view->rootObject()->property("caster").value<QQuick3DModel *>();
+    QVERIFY(caster);
+
+    QQuick3DGeometry *geometry = new QQuick3DGeometry(caster);
+    geometry->setStride(6 * sizeof(float));
+    geometry->setPrimitiveType(QQuick3DGeometry::PrimitiveType::Triangles);
+    geometry->addAttribute(QQuick3DGeometry::Attribute::PositionSemantic, 0,
+                           QQuick3DGeometry::Attribute::F32Type);
+    geometry->addAttribute(QQuick3DGeometry::Attribute::NormalSemantic, 3 * sizeof(float),
+                           QQuick3DGeometry::Attribute::F32Type);
+    geometry->setBounds(QVector3D(-200, 0, -200), QVector3D(200, 0, 200));
+    geometry->setVertexData(quadVertexData(200));
+    geometry->update();
+    caster->setGeometry(geometry);
+
+    QImage result = grab(view.data());
+    if (result.isNull())
+        return; // was QFAIL'ed already
+
+    // The camera only sees the ground below the caster, which is in its shadow
+    QVERIFY(centerPixelRed(result) < 64);
+
+    // Render the same again, the shadow map may be reused
+    result = grab(view.data());
+    if (result.isNull())
+        return;
+    QVERIFY(centerPixelRed(result) < 64);
+
+    // Collapse the caster in place, with the bounds unchanged. The light's
+    // view of the scene stays the same, only the contents of the geometry
+    // tell that the shadow map must be rendered again.
+    geometry->setVertexData(0, quadVertexData(0));
+    geometry->update();
+
+    result = grab(view.data());
+    if (result.isNull())
+        return;
+    QVERIFY(centerPixelRed(result) > 128);
+}
+
+void tst_Shadows::cachedShadowMaps()
+{
+    if (qEnvironmentVariableIntValue("QT_QUICK3D_DISABLE_SHADOW_MAP_CACHE"))
+        QSKIP("The shadow map cache is disabled");
+
+    QQuick3DTestOffscreenRenderer renderer;
+    QVERIFY(renderer.init(testFileUrl("shadowcache.qml"),
+#if QT_CONFIG(vulkan)
+                          &vulkanInstance
+#else
+                          nullptr
+#endif
+    ));
+
+    QObject *directionalLight = renderer.rootItem->property("directionalLight").value<QObject *>();
+    QObject *pointLight = renderer.rootItem->property("pointLight").value<QObject *>();
+    QVERIFY(directionalLight);
+    QVERIFY(pointLight);
+
+    bool readCompleted = false;
+    QRhiReadbackResult readResult;
+    QImage result;
+
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    QSSGRenderContextInterface *context = QSSGRenderContextInterface::renderContextForWindow(*renderer.quickWindow);
+    QVERIFY(context);
+    const QSSGRhiShadowMapStats &stats = context->rhiContext()->stats().shadowMapStats;
+    // The atlas tile of the directional light and the cube map of the point light
+    QCOMPARE(stats.rendered + stats.skipped, 2u);
+
+    // A map is rendered again until all its casters could be drawn, after
+    // that identical frames reuse both
+    for (int i = 0; i < 10 && stats.rendered; ++i)
+        renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    QCOMPARE(stats.rendered, 0u);
+    QCOMPARE(stats.skipped, 2u);
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    QCOMPARE(stats.rendered, 0u);
+    QCOMPARE(stats.skipped, 2u);
+    const QImage cached = result;
+
+    // Only the map of the light which moved is rendered
+    directionalLight->setProperty("eulerRotation", QVector3D(-50.0f, 10.0f, 0.0f));
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    QCOMPARE(stats.rendered, 1u);
+    QCOMPARE(stats.skipped, 1u);
+    QVERIFY(result != cached);
+
+    pointLight->setProperty("position", QVector3D(50.0f, 200.0f, 0.0f));
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    QCOMPARE(stats.rendered, 1u);
+    QCOMPARE(stats.skipped, 1u);
+
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    QCOMPARE(stats.rendered, 0u);
+    QCOMPARE(stats.skipped, 2u);
+}
+
+void tst_Shadows::cascades()
+{
+    QQuick3DTestOffscreenRenderer renderer;
+    QVERIFY(renderer.init(testFileUrl("cascades.qml"),
+#if QT_CONFIG(vulkan)
+                          &vulkanInstance
+#else
+                          nullptr
+#endif
+    ));
+
+    QQuick3DViewport *view = qobject_cast<QQuick3DViewport *>(renderer.rootItem);
+    QVERIFY(view);
+
+    bool readCompleted = false;
+    QRhiReadbackResult readResult;
+    QImage result;
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    QVERIFY(readCompleted);
+
+    // The red of the ground right below a caster, which the camera sees past it
+    const auto groundBelow = [&](const char *casterPosition) {
+        QVector3D position = view->property(casterPosition).value<QVector3D>();
+        position.setY(0.0f);
+        const QVector3D viewPos = view->mapFrom3DScene(position);
+        return qRed(result.pixel(int(viewPos.x()), int(viewPos.y())));
+    };
+
+    QVERIFY(groundBelow("nearCasterPosition") < 64);
+    // In the last cascade
+    QVERIFY(groundBelow("farCasterPosition") < 64);
+    // Beyond the last split nothing is shadowed
+    QVERIFY(groundBelow("beyondCasterPosition") > 128);
+}
+
+QTEST_MAIN(tst_Shadows)
+#include "tst_shadows.moc"
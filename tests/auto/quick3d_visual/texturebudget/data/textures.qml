@@ -0,0 +1,44 @@
+import QtQuick
+import QtQuick3D
+
+View3D {
+    width: 64
+    height: 64
+    anchors.fill: parent
+
+    // Image urls, set from the test
+    property var sources: []
+    property var mipmappedSources: []
+
+    PerspectiveCamera {
+        z: 600
+    }
+
+    Repeater3D {
+        model: sources
+        Model {
+            source: "#Rectangle"
+            materials: DefaultMaterial {
+                lighting: DefaultMaterial.NoLighting
+                diffuseMap: Texture {
+                    source: modelData
+                }
+            }
+        }
+    }
+
+    Repeater3D {
+        model: mipmappedSources
+        Model {
+            source: "#Rectangle"
+            materials: DefaultMaterial {
+                lighting: DefaultMaterial.NoLighting
+                diffuseMap: Texture {
+                    source: modelData
+                    generateMipmaps: true
+                    mipFilter: Texture.Linear
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,253 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QTest>
+#include <QTemporaryDir>
+#include <QRegularExpression>
+#include <QQuickView>
+
+#include <private/qssgrendercontextcore_p.h>
+#include <private/qssgrenderbuffermanager_p.h>
+
+#if QT_CONFIG(vulkan)
+#include <QVulkanInstance>
+#endif
+
+#include "../shared/util.h"
+
+// The budget is read once, set it before anything is rendered
+static const quint64 Budget = 2 * 1024 * 1024;
+// A 512x512 RGBA image, and with its mip levels
+static const quint64 PlainSize = 512 * 512 * 4;
+static const quint64 MipmappedSize = PlainSize + PlainSize / 4;
+
+static inline void renderNextFrame(QQuick3DTestOffscreenRenderer *renderer, bool *readCompleted, QRhiReadbackResult *readResult, QImage *result)
+{
+    renderer->qmlEngine->collectGarbage();
+    QGuiApplication::processEvents();
+    renderer->renderControl->polishItems();
+    renderer->renderControl->beginFrame();
+    renderer->renderControl->sync();
+    renderer->renderControl->render();
+    renderer->enqueueReadback(readCompleted, readResult, result);
+    renderer->renderControl->endFrame();
+}
+
+static const QSSGBufferManager::ImageData *findImage(const QSSGRef<QSSGBufferManager> &bufferManager, const QString &fileName)
+{
+    const auto &imageMap = bufferManager->getImageMap();
+    for (auto it = imageMap.cbegin(), end = imageMap.cend(); it != end; ++it) {
+        if (it.key().path.path().endsWith(QLatin1Char('/') + fileName))
+            return &it.value();
+    }
+    return nullptr;
+}
+
+class tst_TextureBudget : public QQuick3DDataTest
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase() override;
+    void evictionOrder();
+    void mipLevels();
+    void nonMipmappedOverBudget();
+
+private:
+    bool initRenderer(QQuick3DTestOffscreenRenderer *renderer, const QString &filename);
+    QString imageUrl(const QString &fileName) const;
+
+    QTemporaryDir m_imageDir;
+#if QT_CONFIG(vulkan)
+    QVulkanInstance vulkanInstance;
+#endif
+};
+
+void tst_TextureBudget::initTestCase()
+{
+    qputenv("QT_QUICK3D_TEXTURE_MEMORY_BUDGET", QByteArray::number(Budget / (1024 * 1024)));
+
+    QQuick3DDataTest::initTestCase();
+    if (!initialized())
+        return;
+
+#if QT_CONFIG(vulkan)
+    vulkanInstance.setLayers({ "VK_LAYER_LUNARG_standard_validation" });
+    vulkanInstance.create(); // may fail, which is fine is Vulkan is not used in the first place
+#endif
+
+    QVERIFY(m_imageDir.isValid());
+    const QStringList names = { "plain1.png", "plain2.png", "plain3.png", "mipmapped.png" };
+    for (const QString &name : names) {
+        QImage image(512, 512, QImage::Format_RGBA8888);
+        image.fill(Qt::red);
+        QVERIFY(image.save(m_imageDir.filePath(name)));
+    }
+}
+
+bool tst_TextureBudget::initRenderer(QQuick3DTestOffscreenRenderer *renderer, const QString &filename)
+{
+    const bool initSuccess = renderer->init(testFileUrl(filename),
+#if QT_CONFIG(vulkan)
+                                            &vulkanInstance
+#else
+                                            nullptr
+#endif
+    );
+    return initSuccess;
+}
+
+QString tst_TextureBudget::imageUrl(const QString &fileName) const
+{
+    return QUrl::fromLocalFile(m_imageDir.filePath(fileName)).toString();
+}
+
+void tst_TextureBudget::evictionOrder()
+{
+    QQuick3DTestOffscreenRenderer renderer;
+    QVERIFY(initRenderer(&renderer, QStringLiteral("textures.qml")));
+
+    bool readCompleted = false;
+    QRhiReadbackResult readResult;
+    QImage result;
+
+    renderer.rootItem->setProperty("sources", QStringList { imageUrl("plain1.png") });
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+
+    QSSGRenderContextInterface *context = QSSGRenderContextInterface::renderContextForWindow(*renderer.quickWindow);
+    QVERIFY(context);
+    const auto &bufferManager = context->bufferManager();
+    QVERIFY(findImage(bufferManager, "plain1.png"));
+
+    // Unused textures are kept while they fit in the budget
+    renderer.rootItem->setProperty("sources", QStringList { imageUrl("plain2.png") });
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    QCOMPARE(bufferManager->getImageMap().count(), 2);
+
+    // Using the first one again makes the second one the least recently used
+    renderer.rootItem->setProperty("sources", QStringList { imageUrl("plain1.png") });
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    QCOMPARE(bufferManager->getImageMap().count(), 2);
+
+    renderer.rootItem->setProperty("sources", QStringList { imageUrl("plain3.png") });
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    QCOMPARE(bufferManager->getImageMap().count(), 2);
+    QVERIFY(findImage(bufferManager, "plain1.png"));
+    QVERIFY(!findImage(bufferManager, "plain2.png"));
+    QVERIFY(findImage(bufferManager, "plain3.png"));
+}
+
+void tst_TextureBudget::mipLevels()
+{
+    QQuick3DTestOffscreenRenderer renderer;
+    QVERIFY(initRenderer(&renderer, QStringLiteral("textures.qml")));
+
+    bool readCompleted = false;
+    QRhiReadbackResult readResult;
+    QImage result;
+
+    // Over the budget, only the mipmapped one can be reduced. That is
+    // decided at the end of the frame, and done in the next one.
+    renderer.rootItem->setProperty("sources", QStringList { imageUrl("plain1.png") });
+    renderer.rootItem->setProperty("mipmappedSources", QStringList { imageUrl("mipmapped.png") });
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+
+    QSSGRenderContextInterface *context = QSSGRenderContextInterface::renderContextForWindow(*renderer.quickWindow);
+    QVERIFY(context);
+    const auto &bufferManager = context->bufferManager();
+
+    const QSSGBufferManager::ImageData *plain = findImage(bufferManager, "plain1.png");
+    QVERIFY(plain);
+    QCOMPARE(plain->droppedMipLevels, 0);
+    QCOMPARE(plain->renderImageTexture.m_texture->pixelSize(), QSize(512, 512));
+    const QSSGBufferManager::ImageData *mipmapped = findImage(bufferManager, "mipmapped.png");
+    QVERIFY(mipmapped);
+    QCOMPARE(mipmapped->droppedMipLevels, 1);
+    QCOMPARE(mipmapped->renderImageTexture.m_texture->pixelSize(), QSize(256, 256));
+
+#if QT_CONFIG(qml_debug)
+    QSSGBufferManager::MemoryStats stats = bufferManager->memoryStats();
+    QCOMPARE(stats.imageResidentDataSize, PlainSize + MipmappedSize / 4);
+    QCOMPARE(stats.imageRequestedDataSize, PlainSize + MipmappedSize);
+    QVERIFY(stats.imageResidentDataSize <= Budget);
+#endif
+
+    // Once the plain texture is not used anymore, there is room for the
+    // full one. It is loaded again in the background, and the unused
+    // texture is released to make room for it.
+    renderer.rootItem->setProperty("sources", QStringList());
+    for (int i = 0; i < 100; ++i) {
+        renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+        mipmapped = findImage(bufferManager, "mipmapped.png");
+        QVERIFY(mipmapped);
+        if (mipmapped->droppedMipLevels == 0)
+            break;
+        QTest::qWait(10);
+    }
+    QCOMPARE(mipmapped->droppedMipLevels, 0);
+    QCOMPARE(mipmapped->renderImageTexture.m_texture->pixelSize(), QSize(512, 512));
+    QVERIFY(!findImage(bufferManager, "plain1.png"));
+
+#if QT_CONFIG(qml_debug)
+    stats = bufferManager->memoryStats();
+    QCOMPARE(stats.imageResidentDataSize, MipmappedSize);
+    QCOMPARE(stats.imageRequestedDataSize, MipmappedSize);
+#endif
+}
+
+void tst_TextureBudget::nonMipmappedOverBudget()
+{
+    QQuick3DTestOffscreenRenderer renderer;
+    QVERIFY(initRenderer(&renderer, QStringLiteral("textures.qml")));
+
+    bool readCompleted = false;
+    QRhiReadbackResult readResult;
+    QImage result;
+
+    // Nothing can be reduced, the textures in use stay as they are
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("exceed the texture memory budget"));
+    renderer.rootItem->setProperty("sources", QStringList { imageUrl("plain1.png"),
+                                                            imageUrl("plain2.png"),
+                                                            imageUrl("plain3.png") });
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+    renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+
+    QSSGRenderContextInterface *context = QSSGRenderContextInterface::renderContextForWindow(*renderer.quickWindow);
+    QVERIFY(context);
+    const auto &bufferManager = context->bufferManager();
+    QCOMPARE(bufferManager->getImageMap().count(), 3);
+    for (const QSSGBufferManager::ImageData &imageData : bufferManager->getImageMap()) {
+        QCOMPARE(imageData.droppedMipLevels, 0);
+        QCOMPARE(imageData.renderImageTexture.m_texture->pixelSize(), QSize(512, 512));
+    }
+}
+
+QTEST_MAIN(tst_TextureBudget)
+#include "tst_texturebudget.moc"
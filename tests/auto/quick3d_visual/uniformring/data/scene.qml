@@ -0,0 +1,65 @@
+import QtQuick
+import QtQuick3D
+
+View3D {
+    width: 400
+    height: 400
+    anchors.fill: parent
+
+    environment: SceneEnvironment {
+        backgroundMode: SceneEnvironment.Color
+        clearColor: "black"
+    }
+
+    PerspectiveCamera {
+        z: 600
+    }
+
+    DirectionalLight {
+        eulerRotation.x: -30
+        eulerRotation.y: -20
+    }
+
+    PointLight {
+        x: 200
+        y: 200
+        z: 200
+        color: "lightblue"
+        castsShadow: true
+    }
+
+    // Lit and unlit models with different materials, so that the draw calls
+    // use uniform data of different sizes
+    Repeater3D {
+        model: 16
+        Model {
+            source: index % 2 ? "#Sphere" : "#Cube"
+            x: (index % 4 - 1.5) * 120
+            y: (Math.floor(index / 4) - 1.5) * 120
+            eulerRotation: Qt.vector3d(index * 10, index * 20, 0)
+            scale: Qt.vector3d(0.6, 0.6, 0.6)
+            materials: [
+                index % 3 == 0 ? principled : (index % 3 == 1 ? defaultMaterial : unlit)
+            ]
+        }
+    }
+
+    PrincipledMaterial {
+        id: principled
+        baseColor: "orange"
+        metalness: 0.5
+        roughness: 0.3
+    }
+
+    DefaultMaterial {
+        id: defaultMaterial
+        diffuseColor: "green"
+        specularAmount: 0.5
+    }
+
+    DefaultMaterial {
+        id: unlit
+        diffuseColor: "purple"
+        lighting: DefaultMaterial.NoLighting
+    }
+}
@@ -0,0 +1,131 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QTest>
+
+#include <private/qssgrhicontext_p.h>
+
+#if QT_CONFIG(vulkan)
+#include <QVulkanInstance>
+#endif
+
+#include "../shared/util.h"
+
+static inline void renderNextFrame(QQuick3DTestOffscreenRenderer *renderer, bool *readCompleted, QRhiReadbackResult *readResult, QImage *result)
+{
+    renderer->qmlEngine->collectGarbage();
+    QGuiApplication::processEvents();
+    renderer->renderControl->polishItems();
+    renderer->renderControl->beginFrame();
+    renderer->renderControl->sync();
+    renderer->renderControl->render();
+    renderer->enqueueReadback(readCompleted, readResult, result);
+    renderer->renderControl->endFrame();
+}
+
+class tst_UniformRing : public QQuick3DDataTest
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase() override;
+    void cleanup();
+    void sameOutput();
+
+private:
+#if QT_CONFIG(vulkan)
+    QVulkanInstance vulkanInstance;
+#endif
+};
+
+void tst_UniformRing::initTestCase()
+{
+    QQuick3DDataTest::initTestCase();
+    if (!initialized())
+        return;
+
+#if QT_CONFIG(vulkan)
+    vulkanInstance.setLayers({ "VK_LAYER_LUNARG_standard_validation" });
+    vulkanInstance.create(); // may fail, which is fine is Vulkan is not used in the first place
+#endif
+}
+
+void tst_UniformRing::cleanup()
+{
+    QSSGRhiUniformRing::setEnabled(qEnvironmentVariableIntValue("QT_QUICK3D_DISABLE_UNIFORM_RING") == 0);
+}
+
+// The uniform data of the main pass comes either from the per-frame ring with
+// dynamic offsets, or from a buffer per draw call, like with
+// QT_QUICK3D_DISABLE_UNIFORM_RING set. Both must render the same.
+void tst_UniformRing::sameOutput()
+{
+    QQuick3DTestOffscreenRenderer renderer;
+    QVERIFY(renderer.init(testFileUrl("scene.qml"),
+#if QT_CONFIG(vulkan)
+                          &vulkanInstance
+#else
+                          nullptr
+#endif
+    ));
+
+    bool readCompleted = false;
+    QRhiReadbackResult readResult;
+    QImage result;
+
+    const auto render = [&](bool ringEnabled) {
+        QSSGRhiUniformRing::setEnabled(ringEnabled);
+        // Anything set up lazily is in place by the second frame
+        renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+        renderNextFrame(&renderer, &readCompleted, &readResult, &result);
+        return result;
+    };
+
+    const QImage withRing = render(true);
+    QVERIFY(readCompleted);
+    QVERIFY(!withRing.isNull());
+    // Something was drawn
+    int drawnPixels = 0;
+    for (int y = 0; y < withRing.height(); y += 4) {
+        for (int x = 0; x < withRing.width(); x += 4) {
+            if (qRed(withRing.pixel(x, y)) || qGreen(withRing.pixel(x, y)) || qBlue(withRing.pixel(x, y)))
+                ++drawnPixels;
+        }
+    }
+    QVERIFY(drawnPixels > 0);
+
+    const QImage withoutRing = render(false);
+    QVERIFY(readCompleted);
+    QCOMPARE(withoutRing, withRing);
+
+    // And back, the cached srbs and pipelines of both paths are kept apart
+    QCOMPARE(render(true), withRing);
+}
+
+QTEST_MAIN(tst_UniformRing)
+#include "tst_uniformring.moc"
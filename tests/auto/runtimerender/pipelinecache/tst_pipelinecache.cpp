@@ -0,0 +1,155 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest>
+
+#include <QtGui/private/qrhi_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrhicontext_p.h>
+
+class tst_PipelineCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void writeAndRead();
+    void overwrite();
+    void missingFile();
+    void rejected_data();
+    void rejected();
+    void unsupportedBackend();
+
+private:
+    QString cacheFile(const QString &name) const { return dir.filePath(name); }
+
+    QTemporaryDir dir;
+};
+
+// Matches the header written by QSSGRhiContext::writePipelineCache()
+static const quint32 magic = 0x51335043;
+static const quint32 version = 1;
+
+static QByteArray blob()
+{
+    QByteArray data;
+    for (int i = 0; i < 1000; ++i)
+        data.append(char(i * 7));
+    return data;
+}
+
+static QByteArray serialize(quint32 m, quint32 v, const QByteArray &qtVersion, const QByteArray &data)
+{
+    QByteArray result;
+    QDataStream ds(&result, QIODevice::WriteOnly);
+    ds.setVersion(QDataStream::Qt_6_0);
+    ds << m << v << qtVersion << data;
+    return result;
+}
+
+void tst_PipelineCache::initTestCase()
+{
+    QVERIFY(dir.isValid());
+    qputenv("QT_QUICK3D_PIPELINE_CACHE_DIR", dir.path().toLocal8Bit());
+}
+
+void tst_PipelineCache::writeAndRead()
+{
+    const QString fileName = cacheFile(QLatin1String("sub/dir/cache.rhipcache"));
+    QVERIFY(QSSGRhiContext::writePipelineCache(fileName, blob()));
+    QVERIFY(QFile::exists(fileName));
+    QCOMPARE(QSSGRhiContext::readPipelineCache(fileName), blob());
+
+    // The file is exactly what the header check expects
+    QFile f(fileName);
+    QVERIFY(f.open(QIODevice::ReadOnly));
+    QCOMPARE(f.readAll(), serialize(magic, version, QByteArrayLiteral(QT_VERSION_STR), blob()));
+}
+
+void tst_PipelineCache::overwrite()
+{
+    const QString fileName = cacheFile(QLatin1String("overwrite.rhipcache"));
+    QVERIFY(QSSGRhiContext::writePipelineCache(fileName, blob()));
+    const QByteArray smaller = blob().left(10);
+    QVERIFY(QSSGRhiContext::writePipelineCache(fileName, smaller));
+    QCOMPARE(QSSGRhiContext::readPipelineCache(fileName), smaller);
+}
+
+void tst_PipelineCache::missingFile()
+{
+    QVERIFY(QSSGRhiContext::readPipelineCache(cacheFile(QLatin1String("nonexistent.rhipcache"))).isEmpty());
+}
+
+void tst_PipelineCache::rejected_data()
+{
+    QTest::addColumn<QByteArray>("contents");
+
+    const QByteArray qtVersion = QByteArrayLiteral(QT_VERSION_STR);
+    const QByteArray valid = serialize(magic, version, qtVersion, blob());
+
+    QTest::newRow("empty") << QByteArray();
+    QTest::newRow("magic") << serialize(magic + 1, version, qtVersion, blob());
+    QTest::newRow("version") << serialize(magic, version + 1, qtVersion, blob());
+    QTest::newRow("qtversion") << serialize(magic, version, QByteArrayLiteral("5.15.2"), blob());
+    QTest::newRow("truncated header") << valid.left(6);
+    QTest::newRow("truncated data") << valid.left(valid.size() - 1);
+    QTest::newRow("trailing") << valid + QByteArrayLiteral("garbage");
+    QTest::newRow("raw blob") << blob();
+}
+
+void tst_PipelineCache::rejected()
+{
+    QFETCH(QByteArray, contents);
+
+    const QString fileName = cacheFile(QLatin1String("rejected.rhipcache"));
+    {
+        QFile f(fileName);
+        QVERIFY(f.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        QCOMPARE(f.write(contents), contents.size());
+    }
+    QVERIFY(QSSGRhiContext::readPipelineCache(fileName).isEmpty());
+}
+
+void tst_PipelineCache::unsupportedBackend()
+{
+    QRhiNullInitParams params;
+    QScopedPointer<QRhi> rhi(QRhi::create(QRhi::Null, &params));
+    QVERIFY(rhi);
+    QVERIFY(!rhi->isFeatureSupported(QRhi::PipelineCache));
+
+    // No file name, and so nothing is read or written for this QRhi
+    QVERIFY(QSSGRhiContext::pipelineCacheFileName(rhi.get()).isEmpty());
+    {
+        QSSGRef<QSSGRhiContext> rhiCtx(new QSSGRhiContext);
+        rhiCtx->initialize(rhi.get());
+    }
+    QCOMPARE(QDir(dir.path()).entryList(QStringList() << QLatin1String("qtquick3d-*")).count(), 0);
+}
+
+QTEST_APPLESS_MAIN(tst_PipelineCache)
+#include "tst_pipelinecache.moc"
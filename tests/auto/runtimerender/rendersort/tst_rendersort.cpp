@@ -0,0 +1,222 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest>
+
+#include <QtQuick3DRuntimeRender/private/qssgrendererimpllayerrenderpreparationdata_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrenderableobjects_p.h>
+
+#include <iterator>
+#include <memory>
+
+class tst_RenderSort : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void radixSort();
+    void backToFront();
+    void backToFrontStable();
+    void opaqueGroupedByPipeline();
+    void opaqueSingleDistance();
+};
+
+using RenderableList = QSSGLayerRenderPreparationData::TRenderableObjectList;
+
+// Owns the renderables the handles point to
+struct Renderables
+{
+    QMatrix4x4 transform;
+    QSSGBounds3 bounds;
+    std::vector<std::unique_ptr<QSSGRenderableObject>> objects;
+
+    QSSGRenderableObjectHandle add(const QVector3D &center, float depthBias = 0.0f)
+    {
+        objects.emplace_back(new QSSGRenderableObject(QSSGRenderableObjectFlags(), center, transform,
+                                                      bounds, bounds, depthBias));
+        return QSSGRenderableObjectHandle::create(objects.back().get());
+    }
+};
+
+void tst_RenderSort::radixSort()
+{
+    // Keys using every byte, compared against a stable std::sort
+    QRandomGenerator rng(1234);
+    RenderableList objects;
+    for (int i = 0; i < 1000; ++i) {
+        QSSGRenderableObjectHandle handle = QSSGRenderableObjectHandle::create(nullptr, float(i));
+        handle.sortKey = rng.generate64();
+        // Some duplicates for the stability
+        if (i % 10 == 0)
+            handle.sortKey = quint64(i % 3) << 40;
+        objects.append(handle);
+    }
+    RenderableList expected = objects;
+    std::stable_sort(expected.begin(), expected.end(),
+                     [](const QSSGRenderableObjectHandle &a, const QSSGRenderableObjectHandle &b) {
+                         return a.sortKey < b.sortKey;
+                     });
+
+    RenderableList scratch;
+    QSSGLayerRenderPreparationData::radixSortRenderables(objects, scratch);
+    QCOMPARE(objects.size(), expected.size());
+    for (int i = 0; i < objects.size(); ++i) {
+        QCOMPARE(objects.at(i).sortKey, expected.at(i).sortKey);
+        QCOMPARE(objects.at(i).cameraDistanceSq, expected.at(i).cameraDistanceSq);
+    }
+}
+
+void tst_RenderSort::backToFront()
+{
+    // Camera at the origin looking down -z. Negative distances are behind
+    // the camera, the depth bias moves objects further away.
+    Renderables renderables;
+    RenderableList objects;
+    objects.append(renderables.add(QVector3D(0, 0, -10)));
+    objects.append(renderables.add(QVector3D(0, 0, 5)));
+    objects.append(renderables.add(QVector3D(0, 0, -0.5f)));
+    objects.append(renderables.add(QVector3D(0, 0, -1000)));
+    objects.append(renderables.add(QVector3D(0, 0, 0)));
+    objects.append(renderables.add(QVector3D(0, 0, -1), 3.0f)); // 1 + 3 * 3
+    objects.append(renderables.add(QVector3D(0, 0, -20), -5.0f)); // 20 - 5 * 5
+    objects.append(renderables.add(QVector3D(0, 0, 100)));
+
+    RenderableList scratch;
+    QSSGLayerRenderPreparationData::sortBackToFront(objects, scratch, QVector3D(), QVector3D(0, 0, -1));
+
+    // Equal distances keep their original order
+    const int expected[] = { 3, 0, 5, 2, 4, 1, 6, 7 };
+    QCOMPARE(objects.size(), int(std::size(expected)));
+    for (int i = 0; i < objects.size(); ++i)
+        QCOMPARE(objects.at(i).obj, renderables.objects.at(expected[i]).get());
+    QCOMPARE(objects.at(1).cameraDistanceSq, 10.0f);
+    QCOMPARE(objects.at(2).cameraDistanceSq, 10.0f);
+    QCOMPARE(objects.at(5).cameraDistanceSq, -5.0f);
+    QCOMPARE(objects.at(6).cameraDistanceSq, -5.0f);
+}
+
+void tst_RenderSort::backToFrontStable()
+{
+    // Everything at the same distance stays in the original order
+    Renderables renderables;
+    RenderableList objects;
+    for (int i = 0; i < 100; ++i)
+        objects.append(renderables.add(QVector3D(float(i % 7), float(i % 5), -50.0f)));
+    const RenderableList original = objects;
+
+    RenderableList scratch;
+    QSSGLayerRenderPreparationData::sortBackToFront(objects, scratch, QVector3D(), QVector3D(0, 0, -1));
+    for (int i = 0; i < objects.size(); ++i)
+        QCOMPARE(objects.at(i).obj, original.at(i).obj);
+}
+
+void tst_RenderSort::opaqueGroupedByPipeline()
+{
+    // Distances between 0 and 1000, four pipelines and eight materials
+    QRandomGenerator rng(42);
+    constexpr float MinDistance = 0.0f;
+    constexpr float MaxDistance = 1000.0f;
+    struct Info { float distance; quint32 pipeline; quint32 resource; };
+    QVector<Info> infos;
+    RenderableList objects;
+    for (int i = 0; i < 500; ++i) {
+        const Info info = { float(rng.bounded(MaxDistance)), quint32(1 + rng.bounded(4)), quint32(1 + rng.bounded(8)) };
+        QSSGRenderableObjectHandle handle = QSSGRenderableObjectHandle::create(nullptr, info.distance);
+        handle.sortKey = QSSGLayerRenderPreparationData::opaqueSortKey(info.distance, MinDistance, MaxDistance,
+                                                                       info.pipeline, info.resource);
+        // The object is only used to find the info again
+        handle.obj = reinterpret_cast<QSSGRenderableObject *>(quintptr(infos.size() + 1));
+        infos.append(info);
+        objects.append(handle);
+    }
+    objects.append(QSSGRenderableObjectHandle::create(reinterpret_cast<QSSGRenderableObject *>(quintptr(infos.size() + 1)), MaxDistance));
+    infos.append({ MaxDistance, 1, 1 });
+    objects.last().sortKey = QSSGLayerRenderPreparationData::opaqueSortKey(MaxDistance, MinDistance, MaxDistance, 1, 1);
+
+    RenderableList scratch;
+    QSSGLayerRenderPreparationData::radixSortRenderables(objects, scratch);
+
+    const auto infoOf = [&infos](const QSSGRenderableObjectHandle &handle) {
+        return infos.at(int(quintptr(handle.obj)) - 1);
+    };
+    const auto sliceOf = [](const QSSGRenderableObjectHandle &handle) {
+        return int(handle.sortKey >> 60);
+    };
+
+    int previousSlice = -1;
+    QSet<quint32> slicePipelines;
+    quint32 currentPipeline = 0;
+    quint32 currentResource = 0;
+    float previousDistance = 0.0f;
+    for (const QSSGRenderableObjectHandle &handle : std::as_const(objects)) {
+        const Info info = infoOf(handle);
+        const int slice = sliceOf(handle);
+        // The 16 slices go front to back and cover the whole range
+        QVERIFY(slice >= previousSlice);
+        QVERIFY(slice < 16);
+        // Up to the rounding at the slice boundaries
+        QVERIFY(qAbs(slice - qMin(int(info.distance / (MaxDistance / 16.0f)), 15)) <= 1);
+        if (slice != previousSlice) {
+            previousSlice = slice;
+            slicePipelines.clear();
+            currentPipeline = 0;
+        }
+        if (info.pipeline != currentPipeline) {
+            // Each pipeline appears as one run within a slice
+            QVERIFY2(!slicePipelines.contains(info.pipeline),
+                     qPrintable(QStringLiteral("pipeline %1 split in slice %2").arg(info.pipeline).arg(slice)));
+            slicePipelines.insert(info.pipeline);
+            currentPipeline = info.pipeline;
+            currentResource = 0;
+        }
+        if (info.resource != currentResource) {
+            currentResource = info.resource;
+            previousDistance = info.distance;
+        }
+        // Front to back within a material group
+        QVERIFY(info.distance >= previousDistance);
+        previousDistance = info.distance;
+    }
+    QCOMPARE(previousSlice, 15);
+}
+
+void tst_RenderSort::opaqueSingleDistance()
+{
+    // No depth range at all: only the pipeline and material decide
+    const quint64 a = QSSGLayerRenderPreparationData::opaqueSortKey(5.0f, 5.0f, 5.0f, 2, 1);
+    const quint64 b = QSSGLayerRenderPreparationData::opaqueSortKey(5.0f, 5.0f, 5.0f, 1, 2);
+    const quint64 c = QSSGLayerRenderPreparationData::opaqueSortKey(5.0f, 5.0f, 5.0f, 1, 1);
+    QVERIFY(c < b);
+    QVERIFY(b < a);
+    QCOMPARE(c >> 60, quint64(0));
+    QCOMPARE(c & 0xfffff, quint64(0));
+}
+
+QTEST_APPLESS_MAIN(tst_RenderSort)
+#include "tst_rendersort.moc"
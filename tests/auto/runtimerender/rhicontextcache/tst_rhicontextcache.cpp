@@ -0,0 +1,316 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest>
+
+#include <QtGui/private/qrhi_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrhicontext_p.h>
+
+#include <memory>
+
+class tst_RhiContextCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void cleanup();
+
+    void leastRecentlyUsedEvicted();
+    void minUnusedFrames();
+    void drawCallDataFirst();
+    void noBudget();
+
+private:
+    QRhiShaderResourceBindings *srb(int i);
+    QRhiGraphicsPipeline *pipeline(int i, QRhiShaderResourceBindings *srb);
+    QSSGRhiDrawCallData &drawCallData(int i);
+    void advance(int frames);
+
+    std::unique_ptr<QRhi> rhi;
+    std::unique_ptr<QRhiBuffer> ubuf;
+    std::unique_ptr<QRhiTexture> texture;
+    std::unique_ptr<QRhiTextureRenderTarget> rt;
+    std::unique_ptr<QRhiRenderPassDescriptor> rpDesc;
+    QSSGRef<QSSGRhiContext> rhiCtx;
+    std::unique_ptr<QSSGRhiShaderPipeline> shaderPipeline;
+};
+
+static QShader dummyShader(QShader::Stage stage)
+{
+    QShader shader;
+    shader.setStage(stage);
+    shader.setShader(QShaderKey(QShader::SpirvShader, QShaderVersion(100)), QShaderCode(QByteArrayLiteral("dummy")));
+    return shader;
+}
+
+void tst_RhiContextCache::initTestCase()
+{
+    QRhiNullInitParams params;
+    rhi.reset(QRhi::create(QRhi::Null, &params));
+    QVERIFY(rhi);
+
+    ubuf.reset(rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 64 * 256));
+    QVERIFY(ubuf->create());
+    texture.reset(rhi->newTexture(QRhiTexture::RGBA8, QSize(64, 64), 1, QRhiTexture::RenderTarget));
+    QVERIFY(texture->create());
+    rt.reset(rhi->newTextureRenderTarget({ texture.get() }));
+    rpDesc.reset(rt->newCompatibleRenderPassDescriptor());
+    rt->setRenderPassDescriptor(rpDesc.get());
+    QVERIFY(rt->create());
+}
+
+void tst_RhiContextCache::cleanupTestCase()
+{
+    rt.reset();
+    rpDesc.reset();
+    texture.reset();
+    ubuf.reset();
+    rhi.reset();
+}
+
+void tst_RhiContextCache::init()
+{
+    rhiCtx = QSSGRef<QSSGRhiContext>(new QSSGRhiContext);
+    rhiCtx->initialize(rhi.get());
+    shaderPipeline.reset(new QSSGRhiShaderPipeline(*rhiCtx));
+    shaderPipeline->addStage(QRhiShaderStage(QRhiShaderStage::Vertex, dummyShader(QShader::VertexStage)),
+                             QSSGRhiShaderPipeline::UsedWithoutIa);
+    shaderPipeline->addStage(QRhiShaderStage(QRhiShaderStage::Fragment, dummyShader(QShader::FragmentStage)));
+}
+
+void tst_RhiContextCache::cleanup()
+{
+    shaderPipeline.reset();
+    rhiCtx.clear();
+}
+
+// Each i gives different bindings, and so a different srb
+QRhiShaderResourceBindings *tst_RhiContextCache::srb(int i)
+{
+    QSSGRhiShaderResourceBindingList bindings;
+    bindings.addUniformBuffer(0, QRhiShaderResourceBinding::VertexStage, ubuf.get(), i * 256, 64);
+    return rhiCtx->srb(bindings);
+}
+
+// Each i gives a different pipeline state, and so a different pipeline
+QRhiGraphicsPipeline *tst_RhiContextCache::pipeline(int i, QRhiShaderResourceBindings *srb)
+{
+    QSSGRhiGraphicsPipelineState ps;
+    ps.shaderPipeline = shaderPipeline.get();
+    ps.depthBias = i;
+    return rhiCtx->pipeline(QSSGGraphicsPipelineStateKey::create(ps, rpDesc.get(), srb), rpDesc.get(), srb);
+}
+
+QSSGRhiDrawCallData &tst_RhiContextCache::drawCallData(int i)
+{
+    return rhiCtx->drawCallData({ nullptr, nullptr, nullptr, i, QSSGRhiDrawCallDataKey::Main });
+}
+
+void tst_RhiContextCache::advance(int frames)
+{
+    for (int i = 0; i < frames; ++i)
+        rhiCtx->beginFrame();
+}
+
+void tst_RhiContextCache::leastRecentlyUsedEvicted()
+{
+    QSSGRhiCacheLimits limits;
+    limits.pipelines = 4;
+    limits.srbs = 6;
+    limits.drawCallData = 0;
+    limits.minUnusedFrames = 2;
+    rhiCtx->setCacheLimits(limits);
+
+    // Frame 0: the srb all the pipelines are created with
+    QRhiShaderResourceBindings *pipelineSrb = srb(0);
+    QVERIFY(pipelineSrb);
+
+    // Frames 1-8: pipeline i - 1 and srb i
+    for (int i = 1; i <= 8; ++i) {
+        advance(1);
+        QVERIFY(pipeline(i - 1, pipelineSrb));
+        QVERIFY(srb(i));
+    }
+
+    // Frame 9: the oldest ones get used again
+    advance(1);
+    QVERIFY(pipeline(0, pipelineSrb));
+    QVERIFY(srb(1));
+
+    advance(2);
+    rhiCtx->releaseUnusedResources();
+
+    // Pipelines 1-4 and srbs 2-4 were the least recently used ones. The srb
+    // of frame 0 is the oldest but must stay with the pipelines using it.
+    QSSGRhiCacheStats stats = rhiCtx->cacheStats();
+    QCOMPARE(stats.pipelines.size, 4);
+    QCOMPARE(stats.pipelines.hits, quint64(1));
+    QCOMPARE(stats.pipelines.misses, quint64(8));
+    QCOMPARE(stats.pipelines.evictions, quint64(4));
+    QCOMPARE(stats.srbs.size, 6);
+    QCOMPARE(stats.srbs.hits, quint64(1));
+    QCOMPARE(stats.srbs.misses, quint64(9));
+    QCOMPARE(stats.srbs.evictions, quint64(3));
+
+    for (int i : { 0, 5, 6, 7 })
+        QVERIFY(pipeline(i, pipelineSrb));
+    QCOMPARE(rhiCtx->cacheStats().pipelines.hits, quint64(5));
+    for (int i : { 0, 1, 5, 6, 7, 8 })
+        QVERIFY(srb(i));
+    QCOMPARE(rhiCtx->cacheStats().srbs.hits, quint64(7));
+    QCOMPARE(rhiCtx->cacheStats().srbs.misses, quint64(9));
+
+    for (int i : { 1, 2, 3, 4 })
+        QVERIFY(pipeline(i, pipelineSrb));
+    QCOMPARE(rhiCtx->cacheStats().pipelines.misses, quint64(12));
+    for (int i : { 2, 3, 4 })
+        QVERIFY(srb(i));
+    QCOMPARE(rhiCtx->cacheStats().srbs.misses, quint64(12));
+}
+
+void tst_RhiContextCache::minUnusedFrames()
+{
+    QSSGRhiCacheLimits limits;
+    limits.pipelines = 2;
+    limits.srbs = 0;
+    limits.drawCallData = 0;
+    limits.minUnusedFrames = 60;
+    rhiCtx->setCacheLimits(limits);
+
+    QRhiShaderResourceBindings *pipelineSrb = srb(0);
+    // Frames 1-5
+    for (int i = 0; i < 5; ++i) {
+        advance(1);
+        QVERIFY(pipeline(i, pipelineSrb));
+    }
+
+    // Frame 30: everything is too recent
+    advance(25);
+    rhiCtx->releaseUnusedResources();
+    QCOMPARE(rhiCtx->cacheStats().pipelines.size, 5);
+    QCOMPARE(rhiCtx->cacheStats().pipelines.evictions, quint64(0));
+
+    // Frame 62: only the ones of frames 1 and 2 may go, even though that
+    // leaves the cache above the budget
+    advance(32);
+    rhiCtx->releaseUnusedResources();
+    QCOMPARE(rhiCtx->cacheStats().pipelines.size, 3);
+    QCOMPARE(rhiCtx->cacheStats().pipelines.evictions, quint64(2));
+
+    // Frame 63: the one of frame 3 follows
+    advance(1);
+    rhiCtx->releaseUnusedResources();
+    QCOMPARE(rhiCtx->cacheStats().pipelines.size, 2);
+    QCOMPARE(rhiCtx->cacheStats().pipelines.evictions, quint64(3));
+
+    // The srb budget is disabled
+    QCOMPARE(rhiCtx->cacheStats().srbs.size, 1);
+    QCOMPARE(rhiCtx->cacheStats().srbs.evictions, quint64(0));
+}
+
+void tst_RhiContextCache::drawCallDataFirst()
+{
+    QSSGRhiCacheLimits limits;
+    limits.pipelines = 2;
+    limits.srbs = 0;
+    limits.drawCallData = 2;
+    limits.minUnusedFrames = 1;
+    rhiCtx->setCacheLimits(limits);
+
+    QRhiShaderResourceBindings *pipelineSrb = srb(0);
+    // Frames 1-3: pipeline i used through draw call data i, frame 4: pipeline 3
+    // without any draw call data
+    for (int i = 0; i < 3; ++i) {
+        advance(1);
+        QSSGRhiDrawCallData &dcd(drawCallData(i));
+        dcd.ubuf = rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 256);
+        QVERIFY(dcd.ubuf->create());
+        dcd.srb = pipelineSrb;
+        dcd.pipeline = pipeline(i, pipelineSrb);
+        QVERIFY(dcd.pipeline);
+    }
+    advance(1);
+    QVERIFY(pipeline(3, pipelineSrb));
+
+    // Frame 6: draw call data 2 is used again, with its cached pipeline
+    // and without going through pipeline()
+    advance(2);
+    QRhiGraphicsPipeline *pipeline2 = drawCallData(2).pipeline;
+
+    advance(1);
+    rhiCtx->releaseUnusedResources();
+
+    // Draw call data 0 goes, and with it what kept pipeline 0 alive. Pipeline
+    // 2 counts as used in frame 6 and so stays, pipelines 0 and 1 are the
+    // least recently used ones.
+    QSSGRhiCacheStats stats = rhiCtx->cacheStats();
+    QCOMPARE(stats.drawCallData.size, 2);
+    QCOMPARE(stats.drawCallData.evictions, quint64(1));
+    QCOMPARE(stats.pipelines.size, 2);
+    QCOMPARE(stats.pipelines.evictions, quint64(2));
+
+    // Draw call data 1 must not keep using the evicted pipeline
+    QCOMPARE(drawCallData(1).pipeline, nullptr);
+    QCOMPARE(drawCallData(1).srb, pipelineSrb);
+    QCOMPARE(drawCallData(2).pipeline, pipeline2);
+
+    const quint64 hits = rhiCtx->cacheStats().pipelines.hits;
+    QCOMPARE(pipeline(2, pipelineSrb), pipeline2);
+    QVERIFY(pipeline(3, pipelineSrb));
+    QCOMPARE(rhiCtx->cacheStats().pipelines.hits, hits + 2);
+}
+
+void tst_RhiContextCache::noBudget()
+{
+    QSSGRhiCacheLimits limits;
+    limits.pipelines = 0;
+    limits.srbs = 0;
+    limits.drawCallData = 0;
+    limits.minUnusedFrames = 0;
+    rhiCtx->setCacheLimits(limits);
+
+    for (int i = 0; i < 16; ++i) {
+        advance(1);
+        QVERIFY(pipeline(i, srb(i)));
+        drawCallData(i);
+    }
+    advance(100);
+    rhiCtx->releaseUnusedResources();
+
+    QSSGRhiCacheStats stats = rhiCtx->cacheStats();
+    QCOMPARE(stats.pipelines.size, 16);
+    QCOMPARE(stats.srbs.size, 16);
+    QCOMPARE(stats.drawCallData.size, 16);
+    QCOMPARE(stats.pipelines.evictions + stats.srbs.evictions + stats.drawCallData.evictions, quint64(0));
+}
+
+QTEST_APPLESS_MAIN(tst_RhiContextCache)
+#include "tst_rhicontextcache.moc"
@@ -0,0 +1,331 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest>
+
+#include <QtCore/qrandom.h>
+#include <QtGui/qmatrix4x4.h>
+
+#include <QtQuick3DRuntimeRender/private/qssgrenderclippingfrustum_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrendernode_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrenderscenebvh_p.h>
+
+#include <memory>
+#include <vector>
+
+using Visibility = QSSGRenderSceneBVH::Visibility;
+
+class tst_SceneBVH : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void matchesBruteForce_data();
+    void matchesBruteForce();
+    void moved();
+    void addedAndRemoved();
+    void notInTree();
+
+private:
+    struct Entry
+    {
+        QSSGRenderNode *node;
+        qint32 key;
+        QSSGBounds3 localBounds;
+        bool inTree = true; // false for instanced models, which the layer does not add
+    };
+
+    QSSGRenderNode *newNode();
+    void randomize(QSSGRenderNode *node);
+    void update(const QVector<Entry> &entries, const QSet<const QSSGRenderNode *> &changed = {});
+    void compare(const QVector<Entry> &entries, qsizetype keyCount);
+
+    QRandomGenerator random;
+    std::vector<std::unique_ptr<QSSGRenderNode>> nodes;
+    QSSGRenderSceneBVH bvh;
+    QVector<QSSGClippingFrustum> frustums;
+};
+
+static QSSGBounds3 worldBounds(const QSSGRenderNode *node, const QSSGBounds3 &localBounds)
+{
+    QSSGBounds3 bounds = localBounds;
+    bounds.transform(node->globalTransform);
+    return bounds;
+}
+
+static bool isInFrontOfAllPlanes(const QSSGClippingFrustum &frustum, const QSSGBounds3 &bounds)
+{
+    for (int corner = 0; corner < 8; ++corner) {
+        const QVector3D point((corner & 1) ? bounds.maximum.x() : bounds.minimum.x(),
+                              (corner & 2) ? bounds.maximum.y() : bounds.minimum.y(),
+                              (corner & 4) ? bounds.maximum.z() : bounds.minimum.z());
+        for (const QSSGClipPlane &plane : frustum.mPlanes) {
+            if (plane.distance(point) < 0.0f)
+                return false;
+        }
+    }
+    return true;
+}
+
+void tst_SceneBVH::init()
+{
+    random.seed(1234);
+    bvh.clear();
+
+    // A camera in the middle of the scene looking along each axis, and one
+    // outside of it seeing all of it
+    QMatrix4x4 projection;
+    projection.perspective(60.0f, 1.5f, 1.0f, 600.0f);
+    const QVector3D directions[] = {
+        QVector3D(1, 0, 0), QVector3D(-1, 0, 0),
+        QVector3D(0, 1, 0), QVector3D(0, -1, 0),
+        QVector3D(0, 0, 1), QVector3D(0, 0, -1)
+    };
+    frustums.clear();
+    for (const QVector3D &direction : directions) {
+        QMatrix4x4 view;
+        const QVector3D up = qFuzzyIsNull(direction.y()) ? QVector3D(0, 1, 0) : QVector3D(0, 0, 1);
+        view.lookAt(QVector3D(), direction, up);
+        frustums.append(QSSGClippingFrustum(projection * view));
+    }
+    QMatrix4x4 overview;
+    overview.perspective(60.0f, 1.0f, 1.0f, 5000.0f);
+    overview.lookAt(QVector3D(0, 0, 2000), QVector3D(), QVector3D(0, 1, 0));
+    frustums.append(QSSGClippingFrustum(overview));
+}
+
+void tst_SceneBVH::cleanup()
+{
+    nodes.clear();
+}
+
+QSSGRenderNode *tst_SceneBVH::newNode()
+{
+    nodes.push_back(std::make_unique<QSSGRenderNode>());
+    randomize(nodes.back().get());
+    return nodes.back().get();
+}
+
+void tst_SceneBVH::randomize(QSSGRenderNode *node)
+{
+    const auto coordinate = [this](double range) { return float(random.bounded(2.0 * range) - range); };
+    node->globalTransform.setToIdentity();
+    node->globalTransform.translate(coordinate(800.0), coordinate(800.0), coordinate(800.0));
+    node->globalTransform.rotate(float(random.bounded(360.0)), QVector3D(1, 2, 3).normalized());
+    node->globalTransform.scale(float(1.0 + random.bounded(40.0)));
+}
+
+void tst_SceneBVH::update(const QVector<Entry> &entries, const QSet<const QSSGRenderNode *> &changed)
+{
+    bvh.beginUpdate();
+    for (const Entry &entry : entries) {
+        if (entry.inTree)
+            bvh.addLeaf(entry.node, entry.key, entry.localBounds, changed.contains(entry.node));
+    }
+    bvh.endUpdate();
+}
+
+// Every frustum must give the same visible set as testing each node on its
+// own, which is what the layer did before the tree. Keys the tree does not
+// know about are tested by the caller, like instanced models are.
+void tst_SceneBVH::compare(const QVector<Entry> &entries, qsizetype keyCount)
+{
+    for (int f = 0; f < frustums.count(); ++f) {
+        const QSSGClippingFrustum &frustum = frustums.at(f);
+        QVector<Visibility> visibility;
+        QSSGCullingStats stats;
+        bvh.cull(frustum, visibility, keyCount, stats);
+        QCOMPARE(visibility.size(), keyCount);
+
+        int outsideCount = 0;
+        for (const Entry &entry : entries) {
+            const QSSGBounds3 bounds = worldBounds(entry.node, entry.localBounds);
+            const bool expected = frustum.intersectsWith(bounds);
+            const Visibility result = visibility.at(entry.key);
+            if (!entry.inTree) {
+                QCOMPARE(result, Visibility::Intersecting);
+                continue;
+            }
+            if (result == Visibility::Outside)
+                ++outsideCount;
+            if (result == Visibility::Inside)
+                QVERIFY2(isInFrontOfAllPlanes(frustum, bounds), qPrintable(QString::number(entry.key)));
+            const bool visible = result == Visibility::Inside
+                    || (result == Visibility::Intersecting && frustum.intersectsWith(bounds));
+            if (visible != expected)
+                QFAIL(qPrintable(QString::fromLatin1("key %1, frustum %2: %3 instead of %4")
+                                 .arg(entry.key).arg(f).arg(visible).arg(expected)));
+        }
+        QCOMPARE(stats.culledNodeCount, outsideCount);
+    }
+}
+
+void tst_SceneBVH::matchesBruteForce_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("single") << 1;
+    QTest::newRow("single tree node") << 4;
+    QTest::newRow("small") << 13;
+    QTest::newRow("large") << 1000;
+}
+
+void tst_SceneBVH::matchesBruteForce()
+{
+    QFETCH(int, count);
+
+    const QSSGBounds3 unitCube(QVector3D(-1, -1, -1), QVector3D(1, 1, 1));
+    QVector<Entry> entries;
+    for (int i = 0; i < count; ++i)
+        entries.append(Entry{ newNode(), qint32(i), unitCube });
+
+    update(entries);
+    QVERIFY(!bvh.isEmpty());
+    compare(entries, count);
+
+    // Nothing changed, nothing to refit
+    update(entries);
+    compare(entries, count);
+}
+
+void tst_SceneBVH::moved()
+{
+    const int count = 400;
+    const QSSGBounds3 unitCube(QVector3D(-1, -1, -1), QVector3D(1, 1, 1));
+    QVector<Entry> entries;
+    for (int i = 0; i < count; ++i)
+        entries.append(Entry{ newNode(), qint32(i), unitCube });
+    update(entries);
+    compare(entries, count);
+
+    // A few nodes per frame only refit the tree, until enough have moved for
+    // a rebuild. Both must keep matching.
+    for (int frame = 0; frame < 20; ++frame) {
+        QSet<const QSSGRenderNode *> changed;
+        for (int i = 0; i < count / 40; ++i) {
+            QSSGRenderNode *node = entries.at(int(random.bounded(count))).node;
+            randomize(node);
+            changed.insert(node);
+        }
+        update(entries, changed);
+        compare(entries, count);
+    }
+
+    // Everything at once
+    QSet<const QSSGRenderNode *> changed;
+    for (const Entry &entry : qAsConst(entries)) {
+        randomize(entry.node);
+        changed.insert(entry.node);
+    }
+    update(entries, changed);
+    compare(entries, count);
+
+    // Changed mesh bounds are picked up without the transform changing
+    for (int i = 0; i < count; i += 3)
+        entries[i].localBounds = QSSGBounds3(QVector3D(-1, -1, -1), QVector3D(200, 1, 1));
+    update(entries);
+    compare(entries, count);
+}
+
+void tst_SceneBVH::addedAndRemoved()
+{
+    const int count = 300;
+    const QSSGBounds3 unitCube(QVector3D(-1, -1, -1), QVector3D(1, 1, 1));
+    QVector<Entry> entries;
+    for (int i = 0; i < count; ++i)
+        entries.append(Entry{ newNode(), qint32(i), unitCube });
+    update(entries);
+    compare(entries, count);
+
+    // Removed from the middle, the following models are at a different
+    // index, and keep their key
+    entries.remove(100, 50);
+    update(entries);
+    compare(entries, count);
+
+    // Added at the end, with new keys
+    for (int i = 0; i < 30; ++i)
+        entries.append(Entry{ newNode(), qint32(count + i), unitCube });
+    update(entries);
+    compare(entries, count + 30);
+
+    // Added in the middle, reusing removed keys
+    for (int i = 0; i < 20; ++i)
+        entries.insert(120, Entry{ newNode(), qint32(100 + i), unitCube });
+    update(entries);
+    compare(entries, count + 30);
+
+    // A different model with the same key at the same index
+    entries[10].node = newNode();
+    update(entries);
+    compare(entries, count + 30);
+
+    // Down to nothing and back
+    update({});
+    QVERIFY(bvh.isEmpty());
+    QVector<Visibility> visibility;
+    QSSGCullingStats stats;
+    bvh.cull(frustums.first(), visibility, 5, stats);
+    QCOMPARE(visibility, QVector<Visibility>(5, Visibility::Intersecting));
+    QCOMPARE(stats.culledNodeCount, 0);
+
+    update(entries);
+    compare(entries, count + 30);
+}
+
+void tst_SceneBVH::notInTree()
+{
+    // Instanced and particle models are not added to the tree and are tested
+    // by the layer per subset, the rest of the scene is unaffected by them
+    const int count = 200;
+    const QSSGBounds3 unitCube(QVector3D(-1, -1, -1), QVector3D(1, 1, 1));
+    QVector<Entry> entries;
+    for (int i = 0; i < count; ++i) {
+        Entry entry { newNode(), qint32(i), unitCube };
+        entry.inTree = (i % 7) != 0;
+        entries.append(entry);
+    }
+    update(entries);
+    compare(entries, count);
+
+    // An instanced model moved or turned into a regular one
+    QSet<const QSSGRenderNode *> changed;
+    for (int i = 0; i < count; i += 7) {
+        randomize(entries.at(i).node);
+        changed.insert(entries.at(i).node);
+    }
+    entries[7].inTree = true;
+    update(entries, changed);
+    compare(entries, count);
+}
+
+QTEST_APPLESS_MAIN(tst_SceneBVH)
+#include "tst_scenebvh.moc"
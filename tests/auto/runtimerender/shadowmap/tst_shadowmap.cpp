@@ -0,0 +1,336 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QTest>
+#include <QtCore/qmath.h>
+
+#include <QtGui/private/qrhi_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrendershadowmap_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrendercontextcore_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrhicontext_p.h>
+
+#include <memory>
+
+// The budget is read once, set it before any shadow map is set up
+static const quint64 Budget = 64 * 1024 * 1024;
+
+class tst_ShadowMap : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void cascadeSplits_data();
+    void cascadeSplits();
+    void cascadeSplitsShadowMapFar();
+
+    void atlasTiles();
+    void budget();
+    void cubeScratch();
+
+private:
+    quint64 memoryUse(QSSGRenderShadowMap &shadowMaps, int lightCount);
+
+    std::unique_ptr<QRhi> rhi;
+    QSSGRef<QSSGRenderContextInterface> context;
+};
+
+static QSSGShadowMapRequest vsmRequest(int lightIdx, int size, float importance = 1.0f, int cascadeCount = 1)
+{
+    QSSGShadowMapRequest request { lightIdx, size, ShadowMapModes::VSM, importance };
+    request.cascadeCount = cascadeCount;
+    request.cascadeResolutionScale = 0.5f;
+    return request;
+}
+
+static QSSGShadowMapRequest cubeRequest(int lightIdx, int size, float importance = 1.0f)
+{
+    return { lightIdx, size, ShadowMapModes::CUBE, importance };
+}
+
+void tst_ShadowMap::initTestCase()
+{
+    qputenv("QT_QUICK3D_SHADOW_MAP_BUDGET", QByteArray::number(Budget / (1024 * 1024)));
+
+    QRhiNullInitParams params;
+    rhi.reset(QRhi::create(QRhi::Null, &params));
+    QVERIFY(rhi);
+    QSSGRef<QSSGRhiContext> rhiCtx(new QSSGRhiContext);
+    rhiCtx->initialize(rhi.get());
+    context = QSSGRef<QSSGRenderContextInterface>(new QSSGRenderContextInterface(nullptr, rhiCtx));
+}
+
+void tst_ShadowMap::cleanupTestCase()
+{
+    context.clear();
+    rhi.reset();
+}
+
+// What the textures of the maps take, 2 bytes per texel for the maps and
+// their blur copies and 4 for depth-stencil, the same as the budget counts
+quint64 tst_ShadowMap::memoryUse(QSSGRenderShadowMap &shadowMaps, int lightCount)
+{
+    quint64 bytes = 0;
+    if (shadowMaps.atlas().texture) {
+        const QSize size = shadowMaps.atlas().texture->pixelSize();
+        bytes += quint64(size.width()) * quint64(size.height()) * (2 + 2 + 4);
+    }
+    QSet<QRhiTexture *> cubeCopies;
+    for (int i = 0; i < lightCount; ++i) {
+        const QSSGShadowMapEntry *entry = shadowMaps.shadowMapEntry(i);
+        if (!entry || !entry->m_rhiDepthCube)
+            continue;
+        const QSize size = entry->m_rhiDepthCube->pixelSize();
+        const quint64 faceTexels = quint64(size.width()) * quint64(size.height());
+        bytes += 6 * faceTexels * 2;
+        if (!cubeCopies.contains(entry->m_rhiCubeCopy)) {
+            cubeCopies.insert(entry->m_rhiCubeCopy);
+            bytes += 6 * faceTexels * 2 + faceTexels * 4;
+        }
+    }
+    return bytes;
+}
+
+void tst_ShadowMap::cascadeSplits_data()
+{
+    QTest::addColumn<float>("blend");
+    QTest::addColumn<int>("cascadeCount");
+
+    QTest::newRow("uniform, 2") << 0.0f << 2;
+    QTest::newRow("uniform, 4") << 0.0f << 4;
+    QTest::newRow("logarithmic, 3") << 1.0f << 3;
+    QTest::newRow("logarithmic, 4") << 1.0f << 4;
+    QTest::newRow("half, 4") << 0.5f << 4;
+    // Out of range blends are clamped
+    QTest::newRow("below 0") << -1.0f << 3;
+    QTest::newRow("above 1") << 2.0f << 3;
+}
+
+void tst_ShadowMap::cascadeSplits()
+{
+    QFETCH(float, blend);
+    QFETCH(int, cascadeCount);
+
+    const float clipNear = 10.0f;
+    const float clipFar = 10000.0f;
+    float splits[QSSG_MAX_NUM_SHADOW_CASCADES] = {};
+    QSSGRenderShadowMap::computeCascadeSplits(clipNear, clipFar, 5000.0f, blend, cascadeCount, splits);
+
+    const float far = 5000.0f;
+    const float b = qBound(0.0f, blend, 1.0f);
+    for (int i = 0; i < cascadeCount - 1; ++i) {
+        const float f = float(i + 1) / cascadeCount;
+        const float uniform = clipNear + (far - clipNear) * f;
+        const float logarithmic = clipNear * qPow(far / clipNear, f);
+        QVERIFY(qAbs(splits[i] - (b * logarithmic + (1.0f - b) * uniform)) < 1e-2f);
+        if (i > 0)
+            QVERIFY(splits[i] > splits[i - 1]);
+    }
+    QCOMPARE(splits[cascadeCount - 1], far);
+
+    if (b == 0.0f) {
+        // Even steps
+        for (int i = 0; i < cascadeCount - 1; ++i)
+            QVERIFY(qAbs(splits[i] - (clipNear + (far - clipNear) * (i + 1) / cascadeCount)) < 1e-2f);
+    } else if (b == 1.0f) {
+        // Every cascade covers the same ratio of distances
+        const float ratio = qPow(far / clipNear, 1.0f / cascadeCount);
+        float previous = clipNear;
+        for (int i = 0; i < cascadeCount; ++i) {
+            QVERIFY(qAbs(splits[i] / previous - ratio) < 1e-3f * ratio);
+            previous = splits[i];
+        }
+    }
+}
+
+void tst_ShadowMap::cascadeSplitsShadowMapFar()
+{
+    float splits[QSSG_MAX_NUM_SHADOW_CASCADES] = {};
+
+    // The shadows end at shadowMapFar when it is nearer than the camera's far plane...
+    QSSGRenderShadowMap::computeCascadeSplits(1.0f, 1000.0f, 400.0f, 0.0f, 3, splits);
+    QCOMPARE(splits[2], 400.0f);
+    QVERIFY(splits[1] < 400.0f);
+
+    // ...and at the far plane otherwise
+    QSSGRenderShadowMap::computeCascadeSplits(1.0f, 1000.0f, 4000.0f, 0.0f, 3, splits);
+    QCOMPARE(splits[2], 1000.0f);
+    QVERIFY(qAbs(splits[0] - 334.0f) < 1e-2f);
+    QVERIFY(qAbs(splits[1] - 667.0f) < 1e-2f);
+
+    // With shadowMapFar in front of the near plane, the whole view is covered
+    QSSGRenderShadowMap::computeCascadeSplits(10.0f, 1000.0f, 5.0f, 1.0f, 2, splits);
+    QCOMPARE(splits[1], 1000.0f);
+    QVERIFY(qAbs(splits[0] - 100.0f) < 1e-2f);
+
+    // A single cascade covers everything up to the limit
+    QSSGRenderShadowMap::computeCascadeSplits(1.0f, 1000.0f, 400.0f, 0.5f, 1, splits);
+    QCOMPARE(splits[0], 400.0f);
+}
+
+void tst_ShadowMap::atlasTiles()
+{
+    QSSGRenderShadowMap shadowMaps(*context);
+    // Mixed sizes, in no particular order, with cascades getting smaller
+    const QVector<QSSGShadowMapRequest> requests = {
+        vsmRequest(0, 256),
+        vsmRequest(1, 1024),
+        vsmRequest(2, 512, 1.0f, 3),
+        cubeRequest(3, 256),
+        vsmRequest(4, 64),
+        vsmRequest(5, 512)
+    };
+    shadowMaps.updateShadowMapEntries(requests);
+    QCOMPARE(shadowMaps.shadowMapEntryCount(), requests.count());
+
+    const QSSGRenderShadowMap::Atlas &atlas(shadowMaps.atlas());
+    QVERIFY(atlas.texture);
+    // The smallest power of two square with enough area
+    const QSize atlasSize = atlas.texture->pixelSize();
+    QCOMPARE(atlasSize, QSize(2048, 2048));
+    const QRect atlasRect(QPoint(0, 0), atlasSize);
+
+    QVector<QRect> tiles;
+    for (const QSSGShadowMapRequest &request : requests) {
+        const QSSGShadowMapEntry *entry = shadowMaps.shadowMapEntry(request.lightIdx);
+        QVERIFY(entry);
+        if (request.mode == ShadowMapModes::CUBE) {
+            QVERIFY(!entry->m_inAtlas);
+            QVERIFY(entry->m_rhiDepthCube);
+            continue;
+        }
+        QVERIFY(entry->m_inAtlas);
+        QCOMPARE(entry->m_rhiDepthMap, atlas.texture);
+        QCOMPARE(entry->m_cascadeCount, request.cascadeCount);
+        for (int cascade = 0; cascade < request.cascadeCount; ++cascade) {
+            const QRect &tile(entry->m_atlasRect[cascade]);
+            // The size of the map, less a border on each side
+            const int expectedSize = request.size >> cascade;
+            QCOMPARE(tile.width(), tile.height());
+            QVERIFY(tile.width() < expectedSize);
+            QVERIFY(tile.width() > expectedSize / 2);
+            QVERIFY(atlasRect.contains(tile));
+            for (const QRect &other : qAsConst(tiles))
+                QVERIFY(!tile.intersects(other));
+            tiles.append(tile);
+
+            // The texture coordinates cover the same area
+            const QVector4D &uv(entry->m_atlasUvRect[cascade]);
+            QCOMPARE(uv.z(), float(tile.width()) / atlasSize.width());
+            QCOMPARE(uv.w(), float(tile.height()) / atlasSize.height());
+        }
+    }
+    QCOMPARE(tiles.count(), 7);
+
+    // Lights which do not cast shadows anymore lose their maps, the rest keep theirs
+    shadowMaps.updateShadowMapEntries({ requests.at(1), requests.at(3) });
+    QCOMPARE(shadowMaps.shadowMapEntryCount(), 2);
+    QVERIFY(!shadowMaps.shadowMapEntry(0));
+    QVERIFY(shadowMaps.shadowMapEntry(1));
+    QVERIFY(shadowMaps.shadowMapEntry(3));
+    QCOMPARE(shadowMaps.atlas().texture->pixelSize(), QSize(1024, 1024));
+}
+
+void tst_ShadowMap::budget()
+{
+    QSSGRenderShadowMap shadowMaps(*context);
+    // Unlimited these would need an 8192x8192 atlas, 512 MB
+    const QVector<QSSGShadowMapRequest> requests = {
+        vsmRequest(0, 4096, 10.0f),
+        vsmRequest(1, 4096, 1.0f),
+        cubeRequest(2, 1024, 20.0f)
+    };
+    shadowMaps.updateShadowMapEntries(requests);
+    QCOMPARE(shadowMaps.shadowMapEntryCount(), 3);
+
+    const quint64 bytes = memoryUse(shadowMaps, requests.count());
+    QVERIFY(bytes > 0);
+    QVERIFY2(bytes <= Budget, qPrintable(QString::number(bytes)));
+
+    // The least important map gets smaller first
+    const QSSGShadowMapEntry *important = shadowMaps.shadowMapEntry(0);
+    const QSSGShadowMapEntry *unimportant = shadowMaps.shadowMapEntry(1);
+    QVERIFY(important && unimportant);
+    QVERIFY(important->m_atlasRect[0].width() > unimportant->m_atlasRect[0].width());
+    // Maps are not made smaller than 64x64
+    QVERIFY(unimportant->m_atlasRect[0].width() > 32);
+    // The most important one, the cube map, still fits as it is
+    QCOMPARE(shadowMaps.shadowMapEntry(2)->m_rhiDepthCube->pixelSize(), QSize(1024, 1024));
+}
+
+void tst_ShadowMap::cubeScratch()
+{
+    QSSGRenderShadowMap shadowMaps(*context);
+    shadowMaps.updateShadowMapEntries({ cubeRequest(0, 256), cubeRequest(1, 256), cubeRequest(2, 512) });
+    QCOMPARE(shadowMaps.shadowMapEntryCount(), 3);
+
+    const QSSGShadowMapEntry *a = shadowMaps.shadowMapEntry(0);
+    const QSSGShadowMapEntry *b = shadowMaps.shadowMapEntry(1);
+    const QSSGShadowMapEntry *c = shadowMaps.shadowMapEntry(2);
+    QVERIFY(a && b && c);
+
+    // Cube maps of the same size share the blur copy and the depth-stencil
+    // buffer, each has its own cube map
+    QVERIFY(a->m_rhiDepthCube && b->m_rhiDepthCube);
+    QVERIFY(a->m_rhiDepthCube != b->m_rhiDepthCube);
+    QVERIFY(a->m_rhiCubeCopy);
+    QCOMPARE(a->m_rhiCubeCopy, b->m_rhiCubeCopy);
+    QCOMPARE(a->m_rhiDepthStencil, b->m_rhiDepthStencil);
+    QCOMPARE(a->m_rhiBlurRenderTarget0, b->m_rhiBlurRenderTarget0);
+    QVERIFY(a->m_rhiBlurRenderTarget1 != b->m_rhiBlurRenderTarget1 || !a->m_rhiBlurRenderTarget1);
+
+    // Other sizes get their own
+    QCOMPARE(c->m_rhiCubeCopy->pixelSize(), QSize(512, 512));
+    QVERIFY(c->m_rhiCubeCopy != a->m_rhiCubeCopy);
+    QVERIFY(c->m_rhiDepthStencil != a->m_rhiDepthStencil);
+
+    // The scratch stays while one map of its size is left, and the map keeps
+    // its resources
+    QRhiTexture *bCube = b->m_rhiDepthCube;
+    QRhiTexture *bCopy = b->m_rhiCubeCopy;
+    shadowMaps.updateShadowMapEntries({ cubeRequest(1, 256), cubeRequest(2, 512) });
+    QCOMPARE(shadowMaps.shadowMapEntryCount(), 2);
+    b = shadowMaps.shadowMapEntry(1);
+    QVERIFY(b);
+    QCOMPARE(b->m_rhiDepthCube, bCube);
+    QCOMPARE(b->m_rhiCubeCopy, bCopy);
+
+    // A light changing size moves to the scratch of its new size
+    shadowMaps.updateShadowMapEntries({ cubeRequest(1, 512), cubeRequest(2, 512) });
+    b = shadowMaps.shadowMapEntry(1);
+    c = shadowMaps.shadowMapEntry(2);
+    QVERIFY(b && c);
+    QCOMPARE(b->m_rhiDepthCube->pixelSize(), QSize(512, 512));
+    QCOMPARE(b->m_rhiCubeCopy, c->m_rhiCubeCopy);
+    QCOMPARE(memoryUse(shadowMaps, 3), quint64(2 * 6 * 512 * 512 * 2 + 6 * 512 * 512 * 2 + 512 * 512 * 4));
+}
+
+QTEST_APPLESS_MAIN(tst_ShadowMap)
+#include "tst_shadowmap.moc"
@@ -0,0 +1,256 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest>
+
+#include <QtGui/private/qrhi_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrhicontext_p.h>
+
+#include <memory>
+
+class tst_UniformRing : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void alignment();
+    void shrinkLast();
+    void growth();
+    void largeAllocation();
+    void reset();
+    void flush();
+    void dynamicOffsetPipelineKey();
+
+private:
+    std::unique_ptr<QRhi> rhi;
+};
+
+// Same as the chunk size in qssgrhicontext.cpp
+static const int ChunkSize = 1024 * 1024;
+
+static QShader dummyShader(QShader::Stage stage)
+{
+    QShader shader;
+    shader.setStage(stage);
+    shader.setShader(QShaderKey(QShader::SpirvShader, QShaderVersion(100)), QShaderCode(QByteArrayLiteral("dummy")));
+    return shader;
+}
+
+void tst_UniformRing::initTestCase()
+{
+    QRhiNullInitParams params;
+    rhi.reset(QRhi::create(QRhi::Null, &params));
+    QVERIFY(rhi);
+    QVERIFY(rhi->ubufAlignment() > 0);
+}
+
+void tst_UniformRing::cleanupTestCase()
+{
+    rhi.reset();
+}
+
+void tst_UniformRing::alignment()
+{
+    QSSGRhiUniformRing ring;
+    const int sizes[] = { 1, 64, 100, int(rhi->ubufAlignment()), int(rhi->ubufAlignment()) + 1, 1000 };
+    QSSGRhiUniformRing::Allocation previous;
+    int previousSize = 0;
+    for (int size : sizes) {
+        const QSSGRhiUniformRing::Allocation alloc = ring.allocate(rhi.get(), size);
+        QVERIFY(alloc.buffer);
+        QVERIFY(alloc.data);
+        QCOMPARE(alloc.offset % rhi->ubufAlignment(), 0u);
+        if (previous.buffer) {
+            QCOMPARE(alloc.buffer, previous.buffer);
+            QCOMPARE(alloc.offset, previous.offset + rhi->ubufAligned(previousSize));
+            QCOMPARE(alloc.data, previous.data + rhi->ubufAligned(previousSize));
+        } else {
+            QCOMPARE(alloc.offset, 0u);
+        }
+        previous = alloc;
+        previousSize = size;
+    }
+}
+
+void tst_UniformRing::shrinkLast()
+{
+    QSSGRhiUniformRing ring;
+    const int align = rhi->ubufAlignment();
+    const QSSGRhiUniformRing::Allocation first = ring.allocate(rhi.get(), 4 * align);
+    ring.shrinkLast(rhi.get(), 10);
+    const QSSGRhiUniformRing::Allocation second = ring.allocate(rhi.get(), 10);
+    QCOMPARE(second.buffer, first.buffer);
+    QCOMPARE(second.offset, first.offset + rhi->ubufAligned(10));
+
+    // Shrinking never grows the allocation
+    ring.shrinkLast(rhi.get(), 8 * align);
+    const QSSGRhiUniformRing::Allocation third = ring.allocate(rhi.get(), 10);
+    QCOMPARE(third.offset, second.offset + rhi->ubufAligned(10));
+}
+
+void tst_UniformRing::growth()
+{
+    QSSGRhiUniformRing ring;
+    const int align = rhi->ubufAlignment();
+    const int perChunk = ChunkSize / align;
+
+    const QSSGRhiUniformRing::Allocation first = ring.allocate(rhi.get(), align);
+    QVERIFY(first.buffer);
+    QCOMPARE(first.buffer->size(), quint32(ChunkSize));
+    for (int i = 1; i < perChunk; ++i) {
+        const QSSGRhiUniformRing::Allocation alloc = ring.allocate(rhi.get(), align);
+        QCOMPARE(alloc.buffer, first.buffer);
+        QCOMPARE(alloc.offset, quint32(i * align));
+    }
+
+    // The first chunk is full, a new one is added
+    const QSSGRhiUniformRing::Allocation next = ring.allocate(rhi.get(), align);
+    QVERIFY(next.buffer);
+    QVERIFY(next.buffer != first.buffer);
+    QCOMPARE(next.offset, 0u);
+    QVERIFY(next.data != first.data);
+}
+
+void tst_UniformRing::largeAllocation()
+{
+    QSSGRhiUniformRing ring;
+    const QSSGRhiUniformRing::Allocation small = ring.allocate(rhi.get(), 16);
+    // Larger than a chunk, gets a chunk of its own size
+    const int size = ChunkSize * 2 + 1;
+    const QSSGRhiUniformRing::Allocation large = ring.allocate(rhi.get(), size);
+    QVERIFY(large.buffer);
+    QVERIFY(large.buffer != small.buffer);
+    QCOMPARE(large.offset, 0u);
+    QVERIFY(large.buffer->size() >= quint32(rhi->ubufAligned(size)));
+}
+
+void tst_UniformRing::reset()
+{
+    QSSGRhiUniformRing ring;
+    const int align = rhi->ubufAlignment();
+    const int perChunk = ChunkSize / align;
+
+    // Two frames worth of allocations, spanning two chunks
+    QSet<QRhiBuffer *> buffers;
+    QVector<QSSGRhiUniformRing::Allocation> frame;
+    for (int i = 0; i < perChunk + 10; ++i) {
+        frame.append(ring.allocate(rhi.get(), align));
+        buffers.insert(frame.last().buffer);
+    }
+    QCOMPARE(buffers.count(), 2);
+
+    // The next frame reuses the same buffers from the start
+    ring.reset();
+    for (int i = 0; i < perChunk + 10; ++i) {
+        const QSSGRhiUniformRing::Allocation alloc = ring.allocate(rhi.get(), align);
+        QCOMPARE(alloc.buffer, frame.at(i).buffer);
+        QCOMPARE(alloc.offset, frame.at(i).offset);
+        QCOMPARE(alloc.data, frame.at(i).data);
+    }
+
+    // Until the resources are released
+    ring.releaseResources();
+    const QSSGRhiUniformRing::Allocation alloc = ring.allocate(rhi.get(), align);
+    QVERIFY(alloc.buffer);
+    QCOMPARE(alloc.offset, 0u);
+}
+
+void tst_UniformRing::flush()
+{
+    QSSGRhiUniformRing ring;
+    QRhiCommandBuffer *cb = nullptr;
+    QCOMPARE(rhi->beginOffscreenFrame(&cb), QRhi::FrameOpSuccess);
+
+    const QSSGRhiUniformRing::Allocation alloc = ring.allocate(rhi.get(), 64);
+    memset(alloc.data, 0x5a, 64);
+    QRhiResourceUpdateBatch *rub = rhi->nextResourceUpdateBatch();
+    ring.flush(rub);
+    // Nothing more to upload until something is written again
+    ring.flush(rub);
+    cb->resourceUpdate(rub);
+
+    QCOMPARE(rhi->endOffscreenFrame(), QRhi::FrameOpSuccess);
+}
+
+void tst_UniformRing::dynamicOffsetPipelineKey()
+{
+    QSSGRef<QSSGRhiContext> rhiCtx(new QSSGRhiContext);
+    rhiCtx->initialize(rhi.get());
+
+    std::unique_ptr<QRhiTexture> texture(rhi->newTexture(QRhiTexture::RGBA8, QSize(64, 64), 1, QRhiTexture::RenderTarget));
+    QVERIFY(texture->create());
+    std::unique_ptr<QRhiTextureRenderTarget> rt(rhi->newTextureRenderTarget({ texture.get() }));
+    std::unique_ptr<QRhiRenderPassDescriptor> rpDesc(rt->newCompatibleRenderPassDescriptor());
+    rt->setRenderPassDescriptor(rpDesc.get());
+    QVERIFY(rt->create());
+
+    QSSGRhiUniformRing ring;
+    const QSSGRhiUniformRing::Allocation alloc = ring.allocate(rhi.get(), 64);
+    QVERIFY(alloc.buffer);
+
+    QSSGRhiShaderResourceBindingList plainBindings;
+    plainBindings.addUniformBuffer(0, QRhiShaderResourceBinding::VertexStage, alloc.buffer, 0, 64);
+    QRhiShaderResourceBindings *plainSrb = rhiCtx->srb(plainBindings);
+    QSSGRhiShaderResourceBindingList dynamicBindings;
+    dynamicBindings.addUniformBufferWithDynamicOffset(0, QRhiShaderResourceBinding::VertexStage, alloc.buffer, 64);
+    QRhiShaderResourceBindings *dynamicSrb = rhiCtx->srb(dynamicBindings);
+    QVERIFY(plainSrb);
+    QVERIFY(dynamicSrb);
+    QVERIFY(plainSrb != dynamicSrb);
+
+    // The layouts look the same to QRhi
+    QCOMPARE(dynamicSrb->serializedLayoutDescription(), plainSrb->serializedLayoutDescription());
+
+    QSSGRhiShaderPipeline shaderPipeline(*rhiCtx);
+    shaderPipeline.addStage(QRhiShaderStage(QRhiShaderStage::Vertex, dummyShader(QShader::VertexStage)),
+                            QSSGRhiShaderPipeline::UsedWithoutIa);
+    shaderPipeline.addStage(QRhiShaderStage(QRhiShaderStage::Fragment, dummyShader(QShader::FragmentStage)));
+    QSSGRhiGraphicsPipelineState ps;
+    ps.shaderPipeline = &shaderPipeline;
+
+    const QSSGGraphicsPipelineStateKey plainKey = QSSGGraphicsPipelineStateKey::create(ps, rpDesc.get(), plainSrb);
+    const QSSGGraphicsPipelineStateKey dynamicKey = QSSGGraphicsPipelineStateKey::create(ps, rpDesc.get(), dynamicSrb);
+    QCOMPARE(plainKey.srbLayoutDescription, plainSrb->serializedLayoutDescription());
+    QCOMPARE(dynamicKey.srbLayoutDescription.count(), plainKey.srbLayoutDescription.count() + 1);
+    QCOMPARE(dynamicKey.srbLayoutDescription.last(), 0xffffffffu);
+    QVERIFY(plainKey != dynamicKey);
+
+    // And so they get pipelines of their own
+    QRhiGraphicsPipeline *plainPipeline = rhiCtx->pipeline(plainKey, rpDesc.get(), plainSrb);
+    QRhiGraphicsPipeline *dynamicPipeline = rhiCtx->pipeline(dynamicKey, rpDesc.get(), dynamicSrb);
+    QVERIFY(plainPipeline);
+    QVERIFY(dynamicPipeline);
+    QVERIFY(plainPipeline != dynamicPipeline);
+    QCOMPARE(rhiCtx->pipeline(plainKey, rpDesc.get(), plainSrb), plainPipeline);
+}
+
+QTEST_APPLESS_MAIN(tst_UniformRing)
+#include "tst_uniformring.moc"
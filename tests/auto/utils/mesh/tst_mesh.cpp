@@ -0,0 +1,377 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Quick 3D.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest>
+
+#include <QtCore/qbuffer.h>
+#include <QtCore/qtemporarydir.h>
+#include <QtCore/qendian.h>
+
+#include <iterator>
+
+#include <QtQuick3DUtils/private/qssgmesh_p.h>
+
+using namespace QSSGMesh;
+
+class mesh : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void test_saveLoad();
+    void test_saveLoadQuantized();
+    void test_mappedLoad();
+    void test_loadVersion5();
+    void test_appendedMeshAligned();
+    void test_truncatedData();
+};
+
+static const qsizetype PageSize = MeshInternal::MeshOffsetTracker::PAGE_SIZE;
+
+static const float positions[] = { -10.0f, -10.0f, 0.0f,
+                                   10.0f, -10.0f, 0.5f,
+                                   -10.0f, 10.0f, -0.5f,
+                                   10.0f, 10.0f, 0.0f };
+static const float normals[] = { 0.0f, 0.0f, 1.0f,
+                                 0.0f, 0.0f, -1.0f,
+                                 0.6f, 0.0f, 0.8f,
+                                 0.0f, -0.8f, -0.6f };
+static const float uvs[] = { 0.0f, 0.0f,
+                             2.0f, 0.0f,
+                             0.0f, 2.0f,
+                             2.0f, 2.0f };
+static const quint32 indices[] = { 2, 1, 0, 2, 3, 1 };
+
+static Mesh createMesh(float scale = 1.0f)
+{
+    float scaledPositions[std::size(positions)];
+    for (size_t i = 0; i < std::size(positions); ++i)
+        scaledPositions[i] = positions[i] * scale;
+    QVector<AssetVertexEntry> entries;
+    entries.append({ MeshInternal::getPositionAttrName(),
+                     QByteArray(reinterpret_cast<const char *>(scaledPositions), sizeof(scaledPositions)),
+                     Mesh::ComponentType::Float32, 3 });
+    entries.append({ MeshInternal::getNormalAttrName(),
+                     QByteArray(reinterpret_cast<const char *>(normals), sizeof(normals)),
+                     Mesh::ComponentType::Float32, 3 });
+    entries.append({ MeshInternal::getUV0AttrName(),
+                     QByteArray(reinterpret_cast<const char *>(uvs), sizeof(uvs)),
+                     Mesh::ComponentType::Float32, 2 });
+    AssetMeshSubset subset;
+    subset.name = QStringLiteral("subset");
+    subset.count = 6;
+    subset.offset = 0;
+    subset.boundsPositionEntryIndex = 0;
+    return Mesh::fromAssetData(entries,
+                               QByteArray(reinterpret_cast<const char *>(indices), sizeof(indices)),
+                               Mesh::ComponentType::UnsignedInt32,
+                               { subset });
+}
+
+static QVector<float> attributeValue(const Mesh &mesh, const char *name, quint32 vertex)
+{
+    const Mesh::VertexBuffer vb = mesh.vertexBuffer();
+    for (const Mesh::VertexBufferEntry &entry : vb.entries) {
+        if (entry.name != name || entry.componentType != Mesh::ComponentType::Float32)
+            continue;
+        QVector<float> result(entry.componentCount);
+        memcpy(result.data(), vb.data.constData() + vertex * vb.stride + entry.offset,
+               entry.componentCount * sizeof(float));
+        return result;
+    }
+    return {};
+}
+
+static quint32 indexValue(const Mesh &mesh, int i)
+{
+    const Mesh::IndexBuffer ib = mesh.indexBuffer();
+    if (ib.componentType == Mesh::ComponentType::UnsignedInt16)
+        return reinterpret_cast<const quint16 *>(ib.data.constData())[i];
+    return reinterpret_cast<const quint32 *>(ib.data.constData())[i];
+}
+
+static bool fuzzyEqual(const QVector<float> &a, const float *b, float epsilon)
+{
+    for (int i = 0; i < a.count(); ++i) {
+        if (qAbs(a[i] - b[i]) > epsilon)
+            return false;
+    }
+    return !a.isEmpty();
+}
+
+void mesh::test_saveLoad()
+{
+    const Mesh original = createMesh();
+    QVERIFY(original.isValid());
+
+    QBuffer buffer;
+    buffer.open(QIODevice::ReadWrite);
+    QVERIFY(original.save(&buffer) != 0);
+
+    const Mesh loaded = Mesh::loadMesh(&buffer);
+    QVERIFY(loaded.isValid());
+    QCOMPARE(loaded.vertexBuffer().stride, original.vertexBuffer().stride);
+    QCOMPARE(loaded.vertexBuffer().data, original.vertexBuffer().data);
+    QCOMPARE(loaded.indexBuffer().data, original.indexBuffer().data);
+    QCOMPARE(loaded.subsets().count(), 1);
+    QCOMPARE(loaded.subsets().first().name, QStringLiteral("subset"));
+}
+
+void mesh::test_saveLoadQuantized()
+{
+    const Mesh original = createMesh();
+    QVERIFY(original.isValid());
+
+    QBuffer buffer;
+    buffer.open(QIODevice::ReadWrite);
+    QVERIFY(original.save(&buffer, 0, Mesh::VertexEncoding::Quantized) != 0);
+
+    QBuffer fullBuffer;
+    fullBuffer.open(QIODevice::ReadWrite);
+    original.save(&fullBuffer);
+    QVERIFY(buffer.size() < fullBuffer.size());
+
+    const Mesh loaded = Mesh::loadMesh(&buffer);
+    QVERIFY(loaded.isValid());
+
+    // Decoded back to floats, with 16-bit indices since they are enough
+    const Mesh::VertexBuffer vb = loaded.vertexBuffer();
+    QCOMPARE(vb.entries.count(), 3);
+    for (const Mesh::VertexBufferEntry &entry : vb.entries)
+        QCOMPARE(entry.componentType, Mesh::ComponentType::Float32);
+    QCOMPARE(vb.data.size(), 4 * int(vb.stride));
+    QCOMPARE(loaded.indexBuffer().componentType, Mesh::ComponentType::UnsignedInt16);
+    QCOMPARE(loaded.indexBuffer().data.size(), 6 * 2);
+
+    // Vertices are in the order of first use
+    QCOMPARE(indexValue(loaded, 0), 0u);
+    QCOMPARE(indexValue(loaded, 1), 1u);
+    QCOMPARE(indexValue(loaded, 2), 2u);
+
+    for (int i = 0; i < 6; ++i) {
+        const quint32 v = indexValue(loaded, i);
+        const quint32 ov = indices[i];
+        QVERIFY(fuzzyEqual(attributeValue(loaded, MeshInternal::getPositionAttrName(), v), positions + ov * 3, 0.001f));
+        QVERIFY(fuzzyEqual(attributeValue(loaded, MeshInternal::getNormalAttrName(), v), normals + ov * 3, 0.001f));
+        QVERIFY(fuzzyEqual(attributeValue(loaded, MeshInternal::getUV0AttrName(), v), uvs + ov * 2, 0.0001f));
+    }
+
+    QCOMPARE(loaded.subsets().count(), 1);
+    QCOMPARE(loaded.subsets().first().count, 6u);
+}
+
+static QByteArray fileContents(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+    return file.readAll();
+}
+
+static bool writeFile(const QString &fileName, const QByteArray &contents)
+{
+    QFile file(fileName);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(contents) == contents.size();
+}
+
+static Mesh loadMapped(const QString &fileName, quint32 id = 0)
+{
+    QSharedPointer<QIODevice> file(new QFile(fileName));
+    if (!file->open(QIODevice::ReadOnly))
+        return Mesh();
+    return Mesh::loadMeshMapped(file, id);
+}
+
+static void compareMeshes(const Mesh &actual, const Mesh &expected)
+{
+    QVERIFY(actual.isValid());
+    QCOMPARE(actual.vertexBuffer().stride, expected.vertexBuffer().stride);
+    QCOMPARE(actual.vertexBuffer().entries.count(), expected.vertexBuffer().entries.count());
+    QCOMPARE(actual.vertexBuffer().data, expected.vertexBuffer().data);
+    QCOMPARE(actual.indexBuffer().componentType, expected.indexBuffer().componentType);
+    QCOMPARE(actual.indexBuffer().data, expected.indexBuffer().data);
+    QCOMPARE(actual.subsets().count(), expected.subsets().count());
+    QCOMPARE(actual.subsets().first().name, expected.subsets().first().name);
+    QCOMPARE(actual.subsets().first().count, expected.subsets().first().count);
+}
+
+void mesh::test_mappedLoad()
+{
+    const Mesh original = createMesh();
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath(QStringLiteral("mesh.mesh"));
+    {
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(original.save(&file) != 0);
+    }
+
+    // The vertex and index data both start on a page of the file
+    const QByteArray contents = fileContents(fileName);
+    const QByteArray vertexData = original.vertexBuffer().data;
+    const qsizetype vertexOffset = contents.indexOf(vertexData);
+    QVERIFY(vertexOffset > 0);
+    QCOMPARE(vertexOffset % PageSize, qsizetype(0));
+    const qsizetype indexOffset = contents.indexOf(original.indexBuffer().data, vertexOffset + vertexData.size());
+    QVERIFY(indexOffset > 0);
+    QCOMPARE(indexOffset % PageSize, qsizetype(0));
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const Mesh loaded = Mesh::loadMesh(&file);
+    compareMeshes(loaded, original);
+
+    // The same bytes, referenced from the mapped file
+    const Mesh mapped = loadMapped(fileName);
+    compareMeshes(mapped, loaded);
+}
+
+// Rewrites the file of one saved mesh in the version 5 layout, which is the
+// same without the padding that puts the vertex and index data on a page.
+static QByteArray toVersion5(const Mesh &mesh, const QByteArray &contents)
+{
+    // Mirrors the offsets of the writer, after the 12 byte mesh header and
+    // the 56 byte mesh struct
+    MeshInternal::MeshOffsetTracker tracker(12);
+    tracker.advance(56);
+    tracker.alignedAdvance(mesh.vertexBuffer().entries.count() * 16);
+    for (const Mesh::VertexBufferEntry &entry : mesh.vertexBuffer().entries)
+        tracker.alignedAdvance(sizeof(quint32) + entry.name.size() + 1);
+    const int vertexPadStart = tracker.offset();
+    const int vertexPad = tracker.pageAlignedAdvance();
+    tracker.alignedAdvance(mesh.vertexBuffer().data.size());
+    const int indexPadStart = tracker.offset();
+    const int indexPad = tracker.pageAlignedAdvance();
+
+    if (contents.mid(vertexPadStart, vertexPad) != QByteArray(vertexPad, '\0')
+            || contents.mid(indexPadStart, indexPad) != QByteArray(indexPad, '\0')) {
+        return QByteArray();
+    }
+
+    QByteArray result = contents.left(vertexPadStart)
+            + contents.mid(vertexPadStart + vertexPad, indexPadStart - vertexPadStart - vertexPad)
+            + contents.mid(indexPadStart + indexPad);
+    // fileId, fileVersion, flags, sizeInBytes
+    qToLittleEndian<quint16>(5, result.data() + 4);
+    const quint32 size = qFromLittleEndian<quint32>(result.constData() + 8);
+    qToLittleEndian<quint32>(size - vertexPad - indexPad, result.data() + 8);
+    return result;
+}
+
+void mesh::test_loadVersion5()
+{
+    const Mesh original = createMesh();
+    QBuffer buffer;
+    buffer.open(QIODevice::ReadWrite);
+    QVERIFY(original.save(&buffer) != 0);
+
+    const QByteArray version5 = toVersion5(original, buffer.data());
+    QVERIFY(!version5.isEmpty());
+    QVERIFY(version5.size() < buffer.data().size() - PageSize);
+
+    QBuffer version5Buffer;
+    version5Buffer.setData(version5);
+    version5Buffer.open(QIODevice::ReadOnly);
+    compareMeshes(Mesh::loadMesh(&version5Buffer), original);
+
+    // Unaligned data can be used from the mapped file as well
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath(QStringLiteral("version5.mesh"));
+    QVERIFY(writeFile(fileName, version5));
+    compareMeshes(loadMapped(fileName), original);
+}
+
+void mesh::test_appendedMeshAligned()
+{
+    const Mesh first = createMesh();
+    const Mesh second = createMesh(2.0f);
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath(QStringLiteral("meshes.mesh"));
+    {
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QCOMPARE(first.save(&file), 1u);
+    }
+    {
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QCOMPARE(second.save(&file), 2u);
+    }
+
+    const QByteArray contents = fileContents(fileName);
+    const QByteArray vertexData = second.vertexBuffer().data;
+    const qsizetype vertexOffset = contents.indexOf(vertexData);
+    QVERIFY(vertexOffset > PageSize);
+    QCOMPARE(vertexOffset % PageSize, qsizetype(0));
+    const qsizetype indexOffset = contents.indexOf(second.indexBuffer().data, vertexOffset + vertexData.size());
+    QVERIFY(indexOffset > 0);
+    QCOMPARE(indexOffset % PageSize, qsizetype(0));
+
+    compareMeshes(loadMapped(fileName, 1), first);
+    compareMeshes(loadMapped(fileName, 2), second);
+}
+
+void mesh::test_truncatedData()
+{
+    const Mesh original = createMesh();
+    QBuffer buffer;
+    buffer.open(QIODevice::ReadWrite);
+    QVERIFY(original.save(&buffer) != 0);
+
+    // The vertex data size claims more than there is in the file. The size
+    // follows the mesh header and four other fields of the mesh struct.
+    QByteArray contents = buffer.data();
+    qToLittleEndian<quint32>(quint32(contents.size()), contents.data() + 12 + 16);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath(QStringLiteral("truncated.mesh"));
+    QVERIFY(writeFile(fileName, contents));
+
+    QTest::ignoreMessage(QtWarningMsg, "Mesh vertex data truncated");
+    QVERIFY(!loadMapped(fileName).isValid());
+
+    QBuffer truncatedBuffer;
+    truncatedBuffer.setData(contents);
+    truncatedBuffer.open(QIODevice::ReadOnly);
+    QTest::ignoreMessage(QtWarningMsg, "Mesh vertex data truncated");
+    QVERIFY(!Mesh::loadMesh(&truncatedBuffer).isValid());
+
+    // A file cut off in the middle has no valid file header at the end
+    QVERIFY(writeFile(fileName, buffer.data().left(PageSize + 16)));
+    QTest::ignoreMessage(QtWarningMsg, "Mesh file invalid");
+    QVERIFY(!loadMapped(fileName).isValid());
+}
+
+QTEST_APPLESS_MAIN(mesh)
+
+#include "tst_mesh.moc"
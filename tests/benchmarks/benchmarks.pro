@@ -2,4 +2,5 @@ TEMPLATE = subdirs
 
 SUBDIRS += \
     renderer \
-    picking
+    picking \
+    particles
@@ -0,0 +1,8 @@
+QT += testlib gui-private quick3druntimerender-private
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SOURCES +=  tst_particles.cpp
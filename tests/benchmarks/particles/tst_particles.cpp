@@ -0,0 +1,200 @@
+/****************************************************************************
+**
+** Copyright (C) 2022 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Quick 3D.
+**
+** $QT_BEGIN_LICENSE:GPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 or (at your option) any later version
+** approved by the KDE Free Qt Foundation. The licenses are as published by
+** the Free Software Foundation and appearing in the file LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest>
+
+#include <QtGui/QOffscreenSurface>
+#include <QtGui/private/qrhigles2_p.h>
+
+#include <QtQuick3DRuntimeRender/private/qssgrenderparticles_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrhicontext_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrhiparticles_p.h>
+
+// Compares simulating sprite particles on the CPU, which is what the renderer
+// falls back to without compute shader support, to the compute shader path.
+// Both include getting the particles to the particle texture.
+class tst_particles : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_particles() = default;
+    ~tst_particles() = default;
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void bench_simulate_data();
+    void bench_simulate();
+
+private:
+    void setupParticles(QSSGRenderParticles &particles, int count);
+
+    QOffscreenSurface *fallbackSurface = nullptr;
+    QRhi *rhi = nullptr;
+    QSSGRef<QSSGRhiContext> rhiContext;
+};
+
+void tst_particles::initTestCase()
+{
+    fallbackSurface = QRhiGles2InitParams::newFallbackSurface();
+    QRhiGles2InitParams params;
+    params.fallbackSurface = fallbackSurface;
+    rhi = QRhi::create(QRhi::OpenGLES2, &params);
+    if (!rhi)
+        QSKIP("Failed to create QRhi");
+
+    rhiContext = QSSGRef<QSSGRhiContext>(new QSSGRhiContext);
+    rhiContext->initialize(rhi);
+}
+
+void tst_particles::cleanupTestCase()
+{
+    rhiContext.clear();
+    delete rhi;
+    delete fallbackSurface;
+}
+
+void tst_particles::bench_simulate_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::addColumn<bool>("compute");
+    QTest::addColumn<bool>("sorting");
+
+    for (int count : { 10000, 100000, 1000000 }) {
+        QTest::addRow("cpu %d", count) << count << false << false;
+        QTest::addRow("compute %d", count) << count << true << false;
+        QTest::addRow("compute sorted %d", count) << count << true << true;
+    }
+}
+
+void tst_particles::setupParticles(QSSGRenderParticles &particles, int count)
+{
+    QRandomGenerator generator(1);
+    const auto random = [&generator](float min, float max) {
+        return min + float(generator.generateDouble()) * (max - min);
+    };
+
+    QSSGParticleSimulation &sim = particles.m_simulation;
+    sim.enabled = true;
+    sim.emitData.resize(count);
+    // Emitted evenly during the first five seconds, all alive after that
+    for (int i = 0; i < count; ++i) {
+        QSSGParticleEmitData &e = sim.emitData[i];
+        e = {};
+        e.startPosition = QVector3D(random(-100, 100), random(-100, 100), random(-100, 100));
+        e.startTime = 5.0f * float(i) / float(count);
+        e.startVelocity = QVector3D(random(-50, 50), random(0, 100), random(-50, 50));
+        e.lifetime = 10.0f;
+        e.startRotation = QVector3D(0, 0, random(0, 360));
+        e.startSize = 1.0f;
+        e.rotationVelocity = QVector3D(0, 0, random(-90, 90));
+        e.endSize = 0.5f;
+        e.startColor = QVector4D(1, 1, 1, 1);
+        e.index = quint32(i);
+    }
+    sim.randomTable.resize(65536);
+    for (float &value : sim.randomTable)
+        value = random(0, 1);
+    sim.randomTableSerial = 1;
+    sim.fadeInDuration = 0.25f;
+    sim.fadeOutDuration = 0.25f;
+    sim.fadeInEffect = QSSGParticleSimulation::FadeEffect::Opacity;
+    sim.fadeOutEffect = QSSGParticleSimulation::FadeEffect::Scale;
+    sim.time = 5.0f;
+
+    QSSGParticleAffectorData gravity;
+    gravity.type = QSSGParticleAffectorData::Type::Gravity;
+    gravity.params[0] = QVector4D(0, -1, 0, 100);
+    sim.affectors.append(gravity);
+
+    QSSGParticleAffectorData wander;
+    wander.type = QSSGParticleAffectorData::Type::Wander;
+    wander.params[0] = QVector4D(10, 0, 10, 0.5f);
+    wander.params[1] = QVector4D(0.5f, 0, 0.5f, 0.5f);
+    wander.params[3] = QVector4D(5, 5, 5, 0);
+    wander.params[4] = QVector4D(1, 1, 1, 0);
+    sim.affectors.append(wander);
+
+    particles.m_particleBuffer.resizeLayout(count);
+}
+
+void tst_particles::bench_simulate()
+{
+    QFETCH(int, count);
+    QFETCH(bool, compute);
+    QFETCH(bool, sorting);
+
+    if (compute && !rhi->isFeatureSupported(QRhi::Compute))
+        QSKIP("Compute shaders are not supported");
+
+    QSSGRenderParticles particles;
+    setupParticles(particles, count);
+    particles.m_depthSorting = sorting;
+    QSSGParticleSimulation &sim = particles.m_simulation;
+    const QVector3D cameraDirection(0, 0, -1);
+
+    QSSGRhiParticleData &particleData = rhiContext->particleData(&particles);
+    particleData.texture = rhi->newTexture(QRhiTexture::RGBA32F, particles.m_particleBuffer.size(), 1,
+                                           compute ? QRhiTexture::UsedWithLoadStore : QRhiTexture::Flags());
+    QVERIFY(particleData.texture->create());
+    particleData.particleCount = count;
+    particleData.simulation.texturesLoadStore = compute;
+
+    QSSGParticleBuffer buffer;
+    buffer.resize(count);
+
+    // The frame waits for the GPU to finish, so both include the whole update
+    QBENCHMARK {
+        sim.time += 1.0f / 60.0f;
+        sim.serial++;
+        QRhiCommandBuffer *cb = nullptr;
+        QCOMPARE(rhi->beginOffscreenFrame(&cb), QRhi::FrameOpSuccess);
+        rhiContext->setCommandBuffer(cb);
+        if (compute) {
+            QVERIFY(QSSGParticleRenderer::prepareSimulation(rhiContext.data(), particles, cameraDirection));
+        } else {
+            sim.simulate(buffer);
+            QRhiResourceUpdateBatch *rub = rhi->nextResourceUpdateBatch();
+            QRhiTextureSubresourceUploadDescription upload;
+            upload.setData(buffer.data());
+            rub->uploadTexture(particleData.texture, QRhiTextureUploadDescription(QRhiTextureUploadEntry(0, 0, upload)));
+            cb->resourceUpdate(rub);
+        }
+        QCOMPARE(rhi->endOffscreenFrame(), QRhi::FrameOpSuccess);
+    }
+
+    delete particleData.texture;
+    particleData.texture = nullptr;
+    particleData.simulation.reset();
+}
+
+QTEST_MAIN(tst_particles)
+
+#include "tst_particles.moc"
@@ -1,4 +1,4 @@
-QT += testlib quick3druntimerender-private
+QT += testlib quick3druntimerender-private quick3dutils-private
 QT -= gui
 
 CONFIG += qt console warn_on depend_includepath testcase
@@ -29,9 +29,17 @@
 
 #include <QtTest>
 
+#include <QtCore/QThreadPool>
+
+#include <cmath>
+
 #include <QtQuick3DRuntimeRender/private/qssgrenderray_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrendererimpllayerrenderhelper_p.h>
 #include <QtQuick3DUtils/private/qssgutils_p.h>
+#include <QtQuick3DUtils/private/qssgmeshbvhbuilder_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrendermesh_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrendermodel_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrenderer_p.h>
 
 class intersection : public QObject
 {
@@ -44,8 +52,48 @@ public:
 private slots:
     void bench_aabbIntersection();
     void bench_aabbIntersectionv2();
+    void bench_meshBVHBuild_data();
+    void bench_meshBVHBuild();
+    void bench_meshBVHIntersection_data();
+    void bench_meshBVHIntersection();
+    void bench_batchPicking_data();
+    void bench_batchPicking();
 };
 
+// A wavy grid of gridSize x gridSize quads in the XY plane, centered at the origin.
+static QSSGMeshBVH *buildGridBVH(int gridSize, QThreadPool *threadPool = nullptr)
+{
+    QByteArray vertexBuffer;
+    vertexBuffer.resize((gridSize + 1) * (gridSize + 1) * int(sizeof(QVector3D)));
+    QVector3D *vertices = reinterpret_cast<QVector3D *>(vertexBuffer.data());
+    for (int y = 0; y <= gridSize; ++y) {
+        for (int x = 0; x <= gridSize; ++x) {
+            const float fx = float(x) / gridSize - 0.5f;
+            const float fy = float(y) / gridSize - 0.5f;
+            *vertices++ = QVector3D(fx, fy, 0.05f * std::sin(fx * 40.0f) * std::cos(fy * 40.0f));
+        }
+    }
+
+    QByteArray indexBuffer;
+    indexBuffer.resize(gridSize * gridSize * 6 * int(sizeof(quint32)));
+    quint32 *indices = reinterpret_cast<quint32 *>(indexBuffer.data());
+    for (int y = 0; y < gridSize; ++y) {
+        for (int x = 0; x < gridSize; ++x) {
+            const quint32 i0 = y * (gridSize + 1) + x;
+            const quint32 i1 = i0 + 1;
+            const quint32 i2 = i0 + gridSize + 1;
+            const quint32 i3 = i2 + 1;
+            *indices++ = i0; *indices++ = i1; *indices++ = i2;
+            *indices++ = i1; *indices++ = i3; *indices++ = i2;
+        }
+    }
+
+    QSSGMeshBVHBuilder builder(vertexBuffer, int(sizeof(QVector3D)), 0, false, -1,
+                               true, indexBuffer, QSSGRenderComponentType::UnsignedInteger32);
+    builder.setThreadPool(threadPool);
+    return builder.buildTree();
+}
+
 void intersection::bench_aabbIntersection()
 {
     QSSGRenderRay::IntersectionResult res;
@@ -82,6 +130,109 @@ void intersection::bench_aabbIntersectionv2()
     }
 }
 
+void intersection::bench_meshBVHBuild_data()
+{
+    QTest::addColumn<int>("gridSize");
+    QTest::addColumn<bool>("threaded");
+    QTest::newRow("2k triangles") << 32 << false;
+    QTest::newRow("130k triangles") << 256 << false;
+    QTest::newRow("130k triangles, threaded") << 256 << true;
+    QTest::newRow("1M triangles") << 724 << false;
+    QTest::newRow("1M triangles, threaded") << 724 << true;
+}
+
+void intersection::bench_meshBVHBuild()
+{
+    QFETCH(int, gridSize);
+    QFETCH(bool, threaded);
+    QThreadPool *threadPool = threaded ? QThreadPool::globalInstance() : nullptr;
+    QBENCHMARK {
+        delete buildGridBVH(gridSize, threadPool);
+    }
+}
+
+void intersection::bench_meshBVHIntersection_data()
+{
+    bench_meshBVHBuild_data();
+}
+
+void intersection::bench_meshBVHIntersection()
+{
+    QFETCH(int, gridSize);
+    QSSGRenderMesh mesh(QSSGRenderDrawMode::Triangles, QSSGRenderWinding::CounterClockwise);
+    mesh.bvh.reset(buildGridBVH(gridSize));
+    QVERIFY(mesh.bvh);
+
+    QMatrix4x4 globalTransform; // Identity
+    // A slightly tilted ray, so that it does not go exactly through the shared edges.
+    const auto pickRay = QSSGRenderRay(/*Origin=*/{0.013f, 0.021f, 10.0f}, /*Direction=*/QVector3D{0.01f, 0.02f, -1.0f}.normalized());
+    QSSGRenderRay::RayData data = QSSGRenderRay::createRayData(globalTransform, pickRay);
+
+    QVector<QSSGRenderRay::IntersectionResult> results;
+    QSSGRenderRay::intersectWithBVH(data, mesh.bvh->root(0), mesh.bvh.get(), results);
+    QVERIFY(!results.isEmpty());
+
+    QBENCHMARK {
+        results.clear();
+        QSSGRenderRay::intersectWithBVH(data, mesh.bvh->root(0), mesh.bvh.get(), results);
+    }
+}
+
+void intersection::bench_batchPicking_data()
+{
+    QTest::addColumn<int>("rayCount");
+    QTest::addColumn<bool>("threaded");
+    QTest::newRow("16 rays") << 16 << false;
+    QTest::newRow("16 rays, threaded") << 16 << true;
+    QTest::newRow("256 rays") << 256 << false;
+    QTest::newRow("256 rays, threaded") << 256 << true;
+    QTest::newRow("4k rays") << 4096 << false;
+    QTest::newRow("4k rays, threaded") << 4096 << true;
+}
+
+void intersection::bench_batchPicking()
+{
+    QFETCH(int, rayCount);
+    QFETCH(bool, threaded);
+
+    // 8 x 8 models sharing one 130k triangle mesh, side by side in the XY plane.
+    static constexpr int modelsPerRow = 8;
+    QSSGRenderMesh mesh(QSSGRenderDrawMode::Triangles, QSSGRenderWinding::CounterClockwise);
+    mesh.bvh.reset(buildGridBVH(256));
+    QVERIFY(mesh.bvh);
+    QSSGRenderSubset subset;
+    subset.offset = 0;
+    subset.count = quint32(mesh.bvh->triangles.size() * 3);
+    subset.bounds = mesh.bvh->root(0)->boundingData;
+    subset.bvhRoot = mesh.bvh->root(0);
+    mesh.subsets.append(subset);
+
+    QSSGRenderModel models[modelsPerRow * modelsPerRow];
+    QSSGRenderer::PickCandidateList candidates;
+    for (int i = 0; i < modelsPerRow * modelsPerRow; ++i) {
+        models[i].globalTransform.translate(float(i % modelsPerRow), float(i / modelsPerRow), 0.0f);
+        candidates.append(QSSGRenderer::pickCandidate(models[i], mesh));
+    }
+
+    // Rays spread over all the models, all of them hit something.
+    QVector<QSSGRenderRay> rays;
+    rays.reserve(rayCount);
+    for (int i = 0; i < rayCount; ++i) {
+        const float x = float(i % 64) / 64.0f * modelsPerRow - 0.5f + 0.013f;
+        const float y = float(i / 64 % 64) / 64.0f * modelsPerRow - 0.5f + 0.021f;
+        rays.append(QSSGRenderRay({ x, y, 10.0f }, QVector3D{ 0.001f, 0.002f, -1.0f }.normalized()));
+    }
+
+    QThreadPool *threadPool = threaded ? QThreadPool::globalInstance() : nullptr;
+    auto results = QSSGRenderer::intersectRaysWithCandidates(rays, candidates, threadPool);
+    QCOMPARE(results.size(), rays.size());
+    QVERIFY(!results.first().isEmpty());
+
+    QBENCHMARK {
+        results = QSSGRenderer::intersectRaysWithCandidates(rays, candidates, threadPool);
+    }
+}
+
 QTEST_APPLESS_MAIN(intersection)
 
 #include "tst_intersection.moc"
@@ -32,6 +32,7 @@
 #include <QtCore/qvector.h>
 
 #include <QtQuick3DRuntimeRender/private/qssgrenderer_p.h>
+#include <QtQuick3DRuntimeRender/private/qssgrhicontext_p.h>
 #include <QtQuick3DRuntimeRender/private/qssgrendernode_p.h>
 #include <QtQuick3D/private/qquick3dscenemanager_p.h>
 
@@ -46,6 +47,8 @@ public:
 private Q_SLOTS:
     void initTestCase();
     void bench_prep();
+    void bench_uniformUpdate_data();
+    void bench_uniformUpdate();
 
 private:
     QRhi *rhi = nullptr;
@@ -141,6 +144,187 @@ void tst_renderer::bench_prep()
     }
 }
 
+// Every member of the main uniform block that has a CommonUniform value
+static const char uniformBenchVertexShader[] =
+        "layout(std140, binding = 0) uniform cbMain {\n"
+        "    vec3 qt_cameraPosition;\n"
+        "    vec3 qt_cameraDirection;\n"
+        "    vec2 qt_cameraProperties;\n"
+        "    mat4 qt_projectionMatrix;\n"
+        "    mat4 qt_inverseProjectionMatrix;\n"
+        "    mat4 qt_viewMatrix;\n"
+        "    mat4 qt_viewProjectionMatrix;\n"
+        "    mat4 qt_modelMatrix;\n"
+        "    mat4 qt_modelViewProjection;\n"
+        "    mat3 qt_normalMatrix;\n"
+        "    mat4 qt_parentMatrix;\n"
+        "    mat3 qt_lightProbeOrientation;\n"
+        "    vec4 qt_lightProbeProperties;\n"
+        "    vec3 qt_reflectionProbeBoxCenter;\n"
+        "    vec3 qt_reflectionProbeBoxMin;\n"
+        "    vec3 qt_reflectionProbeBoxMax;\n"
+        "    int qt_reflectionProbeCorrection;\n"
+        "    vec3 qt_material_emissive_color;\n"
+        "    vec4 qt_material_base_color;\n"
+        "    vec4 qt_material_specular;\n"
+        "    vec4 qt_material_properties;\n"
+        "    vec4 qt_material_properties2;\n"
+        "    vec4 qt_material_properties3;\n"
+        "    vec4 qt_material_properties4;\n"
+        "    vec4 qt_material_attenuation;\n"
+        "    float qt_material_thickness;\n"
+        "    vec3 qt_light_ambient_total;\n"
+        "    vec4 qt_rhi_properties;\n"
+        "    vec2 qt_shadowDepthAdjust;\n"
+        "    float qt_materialPointSize;\n"
+        "};\n"
+        "layout(location = 0) in vec3 attr_pos;\n"
+        "layout(location = 0) out vec4 color;\n"
+        "void main()\n"
+        "{\n"
+        "    color = qt_material_base_color + qt_material_specular + qt_material_properties + qt_material_properties2\n"
+        "            + qt_material_properties3 + qt_material_properties4 + qt_lightProbeProperties + qt_rhi_properties\n"
+        "            + vec4(qt_cameraPosition + qt_cameraDirection + qt_material_emissive_color + qt_light_ambient_total\n"
+        "                   + qt_normalMatrix * attr_pos, qt_cameraProperties.x)\n"
+        "            + qt_viewProjectionMatrix * qt_modelMatrix * vec4(attr_pos, 1.0);\n"
+        "    gl_Position = qt_modelViewProjection * vec4(attr_pos, 1.0);\n"
+        "}\n";
+
+static const char uniformBenchFragmentShader[] =
+        "layout(location = 0) in vec4 color;\n"
+        "void main()\n"
+        "{\n"
+        "    fragOutput = color;\n"
+        "}\n";
+
+enum class UniformUpdateMode {
+    ByName,
+    StoredIndex,
+    OffsetTable
+};
+
+void tst_renderer::bench_uniformUpdate_data()
+{
+    QTest::addColumn<int>("mode");
+
+    QTest::newRow("by name") << int(UniformUpdateMode::ByName);
+    QTest::newRow("stored index") << int(UniformUpdateMode::StoredIndex);
+    QTest::newRow("offset table") << int(UniformUpdateMode::OffsetTable);
+}
+
+void tst_renderer::bench_uniformUpdate()
+{
+    QFETCH(int, mode);
+
+    QSSGRef<QSSGRhiShaderPipeline> shaders = renderContext->shaderCache()->compileForRhi(QByteArrayLiteral("tst_renderer_uniforms"),
+                                                                                         uniformBenchVertexShader,
+                                                                                         uniformBenchFragmentShader,
+                                                                                         {}, {});
+    if (!shaders)
+        QSKIP("Shaders cannot be compiled at runtime in this configuration");
+
+    using CommonUniform = QSSGRhiShaderPipeline::CommonUniform;
+    struct Uniform {
+        const char *name;
+        CommonUniform id;
+        size_t size;
+        QSSGRhiShaderPipeline::UniformFlags flags;
+    };
+    // In the order of CommonUniform
+    const Uniform uniforms[] = {
+        { "qt_cameraPosition", CommonUniform::CameraPosition, 3 * sizeof(float), {} },
+        { "qt_cameraDirection", CommonUniform::CameraDirection, 3 * sizeof(float), {} },
+        { "qt_cameraProperties", CommonUniform::CameraProperties, 2 * sizeof(float), {} },
+        { "qt_projectionMatrix", CommonUniform::ProjectionMatrix, 16 * sizeof(float), {} },
+        { "qt_inverseProjectionMatrix", CommonUniform::InverseProjectionMatrix, 16 * sizeof(float), {} },
+        { "qt_viewMatrix", CommonUniform::ViewMatrix, 16 * sizeof(float), {} },
+        { "qt_viewProjectionMatrix", CommonUniform::ViewProjectionMatrix, 16 * sizeof(float), {} },
+        { "qt_modelMatrix", CommonUniform::ModelMatrix, 16 * sizeof(float), {} },
+        { "qt_modelViewProjection", CommonUniform::ModelViewProjection, 16 * sizeof(float), {} },
+        { "qt_normalMatrix", CommonUniform::NormalMatrix, 12 * sizeof(float), QSSGRhiShaderPipeline::UniformFlag::Mat3 },
+        { "qt_parentMatrix", CommonUniform::ParentMatrix, 16 * sizeof(float), {} },
+        { "qt_lightProbeOrientation", CommonUniform::LightProbeOrientation, 12 * sizeof(float), QSSGRhiShaderPipeline::UniformFlag::Mat3 },
+        { "qt_lightProbeProperties", CommonUniform::LightProbeProperties, 4 * sizeof(float), {} },
+        { "qt_reflectionProbeBoxCenter", CommonUniform::ReflectionProbeBoxCenter, 3 * sizeof(float), {} },
+        { "qt_reflectionProbeBoxMin", CommonUniform::ReflectionProbeBoxMin, 3 * sizeof(float), {} },
+        { "qt_reflectionProbeBoxMax", CommonUniform::ReflectionProbeBoxMax, 3 * sizeof(float), {} },
+        { "qt_reflectionProbeCorrection", CommonUniform::ReflectionProbeCorrection, sizeof(int), {} },
+        { "qt_material_emissive_color", CommonUniform::MaterialEmissiveColor, 3 * sizeof(float), {} },
+        { "qt_material_base_color", CommonUniform::MaterialBaseColor, 4 * sizeof(float), {} },
+        { "qt_material_specular", CommonUniform::MaterialSpecular, 4 * sizeof(float), {} },
+        { "qt_material_properties", CommonUniform::MaterialProperties, 4 * sizeof(float), {} },
+        { "qt_material_properties2", CommonUniform::MaterialProperties2, 4 * sizeof(float), {} },
+        { "qt_material_properties3", CommonUniform::MaterialProperties3, 4 * sizeof(float), {} },
+        { "qt_material_properties4", CommonUniform::MaterialProperties4, 4 * sizeof(float), {} },
+        { "qt_material_attenuation", CommonUniform::MaterialAttenuation, 4 * sizeof(float), {} },
+        { "qt_material_thickness", CommonUniform::MaterialThickness, sizeof(float), {} },
+        { "qt_light_ambient_total", CommonUniform::LightAmbientTotal, 3 * sizeof(float), {} },
+        { "qt_rhi_properties", CommonUniform::RhiProperties, 4 * sizeof(float), {} },
+        { "qt_shadowDepthAdjust", CommonUniform::ShadowDepthAdjust, 2 * sizeof(float), {} },
+        { "qt_materialPointSize", CommonUniform::MaterialPointSize, sizeof(float), {} }
+    };
+    constexpr int uniformCount = int(sizeof(uniforms) / sizeof(uniforms[0]));
+    static_assert(uniformCount == int(CommonUniform::Count), "a CommonUniform is not covered");
+
+    for (int i = 0; i < uniformCount; ++i) {
+        QCOMPARE(int(uniforms[i].id), i);
+        QVERIFY2(shaders->offsetOfUniform(uniforms[i].id) >= 0, uniforms[i].name);
+    }
+
+    // Large enough for every uniform, and no two floats the same so that a
+    // wrong offset or a mixed up mat3 column shows in the comparison below.
+    float values[16];
+    for (int i = 0; i < 16; ++i)
+        values[i] = float(i + 1);
+    const QMatrix4x4 data(values);
+
+    // Both paths must write the same bytes, and so must both have written
+    // something, in every build (the size checks are only in debug builds).
+    const QByteArray untouched(shaders->ub0Size(), char(0xcd));
+    for (const Uniform &u : uniforms) {
+        QByteArray byName = untouched;
+        QByteArray byOffset = untouched;
+        shaders->setUniform(byName.data(), u.name, data.constData(), u.size, nullptr, u.flags);
+        shaders->setUniform(byOffset.data(), u.id, data.constData(), u.size, u.flags);
+        QVERIFY2(byName != untouched, u.name);
+        QVERIFY2(byOffset == byName, u.name);
+    }
+
+    QByteArray ubuf(shaders->ub0Size(), '\0');
+    char *ubufData = ubuf.data();
+    int storedIndices[uniformCount];
+    std::fill(std::begin(storedIndices), std::end(storedIndices), -1);
+
+    // Each iteration is what setRhiMaterialProperties does for 1000 draw calls
+    const int drawCount = 1000;
+    switch (UniformUpdateMode(mode)) {
+    case UniformUpdateMode::ByName:
+        QBENCHMARK {
+            for (int draw = 0; draw < drawCount; ++draw) {
+                for (const Uniform &u : uniforms)
+                    shaders->setUniform(ubufData, u.name, data.constData(), u.size, nullptr, u.flags);
+            }
+        }
+        break;
+    case UniformUpdateMode::StoredIndex:
+        QBENCHMARK {
+            for (int draw = 0; draw < drawCount; ++draw) {
+                for (int i = 0; i < uniformCount; ++i)
+                    shaders->setUniform(ubufData, uniforms[i].name, data.constData(), uniforms[i].size, &storedIndices[i], uniforms[i].flags);
+            }
+        }
+        break;
+    case UniformUpdateMode::OffsetTable:
+        QBENCHMARK {
+            for (int draw = 0; draw < drawCount; ++draw) {
+                for (const Uniform &u : uniforms)
+                    shaders->setUniform(ubufData, u.id, data.constData(), u.size, u.flags);
+            }
+        }
+        break;
+    }
+}
+
 QTEST_APPLESS_MAIN(tst_renderer)
 
 #include "tst_renderer.moc"